@@ -0,0 +1,209 @@
+#include "cooling_supervisor.h"
+#include <math.h>
+#include <string.h>
+
+// 温差不动点迭代次数（制冷量依赖温差，温差又依赖制冷量）
+#define MODEL_ITERATIONS 4
+
+void cooling_model_default(cooling_model_t* model) {
+    model->fan_power_max    = 3.0f;
+    model->fan_power_exp    = 3.0f;
+    model->fan_cooling_max  = 15.0f;
+    model->tec_power_max    = 60.0f;
+    model->tec_power_exp    = 1.0f;
+    model->tec_cooling_max  = 40.0f;
+    model->tec_delta_t_max  = 65.0f;
+    model->heatsink_r_still = 1.5f;
+    model->heatsink_r_full  = 0.3f;
+}
+
+void cooling_supervisor_init(cooling_supervisor_t* sup, const cooling_model_t* model) {
+    memset(sup, 0, sizeof(*sup));
+    sup->model = *model;
+}
+
+float cooling_model_fan_power(const cooling_model_t* model, uint8_t fan) {
+    return fan ? model->fan_power_max * powf(fan / 100.0f, model->fan_power_exp) : 0.0f;
+}
+
+float cooling_model_tec_power(const cooling_model_t* model, uint8_t tec) {
+    return tec ? model->tec_power_max * powf(tec / 100.0f, model->tec_power_exp) : 0.0f;
+}
+
+void cooling_supervisor_set_budget(cooling_supervisor_t* sup, float watts) {
+    sup->power_budget_w = watts > 0.0f ? watts : 0.0f;
+}
+
+/**
+ * @brief 单通道功率不超过 watts 时的最大占空比（反解功率曲线）
+ */
+static uint8_t duty_for_power(float watts, float power_max, float exponent) {
+    if (watts <= 0.0f) return 0;
+    if (watts >= power_max) return 100;
+    float duty = 100.0f * powf(watts / power_max, 1.0f / exponent);
+    return (uint8_t)duty;   // 向下取整，保证不超过预算
+}
+
+/**
+ * @brief 按模型计算冷热端温差和制冷片制冷量
+ */
+static float model_tec(const cooling_model_t* m, float x, float u, float bias, float* delta_t) {
+    float r = m->heatsink_r_full + (m->heatsink_r_still - m->heatsink_r_full) * (1.0f - x) * (1.0f - x);
+    float p_tec = u * m->tec_power_max;
+    float dt = bias > 0.0f ? bias : 0.0f;
+    float q_tec = 0.0f;
+    for (int i = 0; i < MODEL_ITERATIONS; i++) {
+        float eff = 1.0f - dt / m->tec_delta_t_max;
+        q_tec = u * m->tec_cooling_max * (eff > 0.0f ? eff : 0.0f);
+        // 热端需排出制冷量与电功率之和
+        dt = (bias > 0.0f ? bias : 0.0f) + (q_tec + p_tec) * r;
+    }
+    if (delta_t) *delta_t = dt;
+    return q_tec;
+}
+
+float cooling_supervisor_estimate(const cooling_supervisor_t* sup, cooling_output_t out, float* cooling_w) {
+    const cooling_model_t* m = &sup->model;
+    float x = out.fan / 100.0f;
+    float u = out.tec / 100.0f;
+    if (cooling_w) {
+        *cooling_w = m->fan_cooling_max * powf(x, 0.8f) + model_tec(m, x, u, sup->delta_t_bias, NULL);
+    }
+    return cooling_model_fan_power(m, out.fan) + cooling_model_tec_power(m, out.tec);
+}
+
+cooling_output_t cooling_supervisor_optimize(const cooling_supervisor_t* sup, uint8_t demand) {
+    cooling_output_t best = { 0, 0 };
+    if (demand == 0) return best;
+    if (demand > 100) demand = 100;
+
+    float q_max;
+    cooling_supervisor_estimate(sup, (cooling_output_t){ 100, 100 }, &q_max);
+    float q_req = q_max * demand / 100.0f;
+
+    float best_power = INFINITY;
+    float best_cooling = -1.0f;
+    bool best_feasible = false;
+    for (int tec = 0; tec <= 100; tec += SUPERVISOR_SEARCH_STEP) {
+        int fan_min = tec > 0 ? SUPERVISOR_FAN_MIN_WITH_TEC : 0;
+        for (int fan = fan_min; fan <= 100; fan += SUPERVISOR_SEARCH_STEP) {
+            cooling_output_t cand = { (uint8_t)fan, (uint8_t)tec };
+            float cooling;
+            float power = cooling_supervisor_estimate(sup, cand, &cooling);
+            if (sup->power_budget_w > 0.0f && power > sup->power_budget_w) continue;
+            bool feasible = cooling >= q_req;
+            // 优先满足需求且功率最小；都不满足时取制冷量最大的组合
+            if ((feasible && (!best_feasible || power < best_power)) ||
+                (!feasible && !best_feasible && cooling > best_cooling)) {
+                best = cand;
+                best_power = power;
+                best_cooling = cooling;
+                best_feasible = feasible;
+            }
+        }
+    }
+    return best;
+}
+
+static void update_delta_t_bias(cooling_supervisor_t* sup, float cold_c, float hot_c) {
+    if (sup->applied.tec == 0) return;
+    float model_dt;
+    model_tec(&sup->model, sup->applied.fan / 100.0f, sup->applied.tec / 100.0f, 0.0f, &model_dt);
+    float err = (hot_c - cold_c) - model_dt;
+    sup->delta_t_bias = 0.8f * sup->delta_t_bias + 0.2f * err;
+}
+
+cooling_output_t cooling_supervisor_step(cooling_supervisor_t* sup, cooling_output_t request,
+                                         float cold_c, float hot_c, uint32_t now_ms) {
+    cooling_output_t out = request;
+    if (out.fan > 100) out.fan = 100;
+    if (out.tec > 100) out.tec = 100;
+
+    bool hot_known = hot_c != SUPERVISOR_HOT_UNKNOWN;
+    bool hot_fault = hot_known && hot_c == SUPERVISOR_HOT_FAULT;
+
+    // 热端过温：带滞回的锁定
+    if (hot_known && !hot_fault) {
+        if (!sup->overtemp && hot_c >= SUPERVISOR_HOT_CUTOFF_C) {
+            sup->overtemp = true;
+            sup->overtemp_trips++;
+        } else if (sup->overtemp && hot_c <= SUPERVISOR_HOT_RESUME_C) {
+            sup->overtemp = false;
+        }
+        update_delta_t_bias(sup, cold_c, hot_c);
+    }
+    if (sup->overtemp) {
+        out.tec = 0;
+        out.fan = 100;
+    } else if (hot_fault) {
+        // 热端传感器故障时无法保护，关闭制冷片
+        out.tec = 0;
+    }
+
+    // 制冷片关闭后的风扇续转
+    if (sup->tec_was_on && out.tec == 0) {
+        sup->tec_off_since_ms = now_ms;
+    }
+    bool run_on = sup->tec_off_since_ms != 0 && (now_ms - sup->tec_off_since_ms) < SUPERVISOR_FAN_RUNON_MS;
+    if ((out.tec > 0 || run_on) && out.fan < SUPERVISOR_FAN_MIN_WITH_TEC) {
+        out.fan = SUPERVISOR_FAN_MIN_WITH_TEC;
+    }
+
+    // 先风扇后制冷片：风扇需持续运行在最低占空比以上一段时间
+    if (out.fan >= SUPERVISOR_FAN_MIN_WITH_TEC) {
+        if (sup->applied.fan < SUPERVISOR_FAN_MIN_WITH_TEC) {
+            sup->fan_ready_since_ms = now_ms;
+        }
+        sup->fan_ready = (now_ms - sup->fan_ready_since_ms) >= SUPERVISOR_FAN_SPINUP_MS;
+    } else {
+        sup->fan_ready = false;
+    }
+    if (!sup->fan_ready) {
+        out.tec = 0;
+    }
+
+    // 功率预算：先削减制冷片，再削减风扇（不低于联锁要求）
+    sup->budget_limited = false;
+    if (sup->power_budget_w > 0.0f && cooling_supervisor_estimate(sup, out, NULL) > sup->power_budget_w) {
+        const cooling_model_t* m = &sup->model;
+        sup->budget_limited = true;
+        uint8_t tec = duty_for_power(sup->power_budget_w - cooling_model_fan_power(m, out.fan),
+                                     m->tec_power_max, m->tec_power_exp);
+        if (tec < out.tec) out.tec = tec;
+        uint8_t fan_floor = sup->overtemp ? 100 : (out.tec > 0 || run_on) ? SUPERVISOR_FAN_MIN_WITH_TEC : 0;
+        uint8_t fan = duty_for_power(sup->power_budget_w - cooling_model_tec_power(m, out.tec),
+                                     m->fan_power_max, m->fan_power_exp);
+        if (fan < fan_floor) fan = fan_floor;
+        if (fan < out.fan) out.fan = fan;
+    }
+
+    sup->tec_was_on = out.tec > 0;
+    sup->applied = out;
+    return out;
+}
+
+uint8_t cooling_supervisor_limit_fan(const cooling_supervisor_t* sup, uint8_t fan) {
+    if (sup->overtemp) return 100;
+    if (fan > 100) fan = 100;
+    if (sup->power_budget_w > 0.0f) {
+        const cooling_model_t* m = &sup->model;
+        uint8_t cap = duty_for_power(sup->power_budget_w - cooling_model_tec_power(m, sup->applied.tec),
+                                     m->fan_power_max, m->fan_power_exp);
+        if (fan > cap) fan = cap;
+    }
+    if (sup->applied.tec > 0 && fan < SUPERVISOR_FAN_MIN_WITH_TEC) return SUPERVISOR_FAN_MIN_WITH_TEC;
+    return fan;
+}
+
+cooling_output_t cooling_supervisor_force_safe(cooling_supervisor_t* sup, uint32_t now_ms) {
+    cooling_output_t out = { .fan = 100, .tec = 0 };
+    if (sup->tec_was_on) {
+        sup->tec_off_since_ms = now_ms;
+    }
+    if (sup->applied.fan < SUPERVISOR_FAN_MIN_WITH_TEC) {
+        sup->fan_ready_since_ms = now_ms;
+    }
+    sup->tec_was_on = false;
+    sup->applied = out;
+    return out;
+}
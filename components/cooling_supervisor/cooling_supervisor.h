@@ -0,0 +1,121 @@
+#ifndef COOLING_SUPERVISOR_H
+#define COOLING_SUPERVISOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 风扇/制冷片协调监督器
+ *        1. 安全联锁：先风扇后制冷片、制冷片开启时风扇最低占空比、热端过温切断
+ *        2. 效率分配：按简化热模型在满足制冷需求的前提下选取总电功率最小的占空比组合
+ *        3. 功率预算：限制风扇 + 制冷片总电功率，超出时优先削减制冷片，联锁要求的风扇不受限
+ *        纯C实现，不依赖ESP-IDF
+ */
+
+// 安全参数
+#define SUPERVISOR_FAN_MIN_WITH_TEC   40      // 制冷片开启时风扇最低占空比（%）
+#define SUPERVISOR_FAN_SPINUP_MS      2000    // 风扇达到最低占空比后多久才允许开制冷片
+#define SUPERVISOR_FAN_RUNON_MS       30000   // 制冷片关闭后风扇继续运行的时间，排出热端余热
+#define SUPERVISOR_HOT_CUTOFF_C       70.0f   // 热端过温切断温度
+#define SUPERVISOR_HOT_RESUME_C       60.0f   // 过温恢复温度（滞回）
+#define SUPERVISOR_SEARCH_STEP        5       // 占空比搜索步长（%）
+
+// 热端温度不可用（未安装热端传感器时传入）
+#define SUPERVISOR_HOT_UNKNOWN        (-1000.0f)
+// 热端传感器故障（DS18B20 返回 -127）
+#define SUPERVISOR_HOT_FAULT          (-127.0f)
+
+/**
+ * @brief 简化热/电模型，功率单位 W，热阻单位 K/W
+ */
+typedef struct {
+    float fan_power_max;        // 风扇100%时电功率
+    float fan_power_exp;        // 风扇功率曲线 P = P_max × duty^exp，风机相似律为 3
+    float fan_cooling_max;      // 风扇100%时的换气散热能力
+    float tec_power_max;        // 制冷片100%时电功率
+    float tec_power_exp;        // 制冷片功率曲线，PWM 斩波下为 1
+    float tec_cooling_max;      // 制冷片100%、冷热端温差为0时的制冷量
+    float tec_delta_t_max;      // 制冷量降为0时的冷热端温差
+    float heatsink_r_still;     // 风扇停转时热端散热器热阻
+    float heatsink_r_full;      // 风扇100%时热端散热器热阻
+} cooling_model_t;
+
+typedef struct {
+    uint8_t fan;                // 风扇占空比（%）
+    uint8_t tec;                // 制冷片占空比（%）
+} cooling_output_t;
+
+typedef struct {
+    cooling_model_t model;
+    cooling_output_t applied;   // 上一次输出
+    bool fan_ready;             // 风扇已持续运行在最低占空比以上
+    uint32_t fan_ready_since_ms;
+    uint32_t tec_off_since_ms;
+    bool tec_was_on;
+    bool overtemp;              // 热端过温锁定中
+    uint32_t overtemp_trips;    // 过温切断次数
+    float delta_t_bias;         // 实测温差与模型温差的偏差（在线校正）
+    float power_budget_w;       // 风扇 + 制冷片总功率上限，0 表示不限制
+    bool budget_limited;        // 上一次输出被功率预算削减
+} cooling_supervisor_t;
+
+/**
+ * @brief 默认模型参数（12V 40x40 TEC + 4010 风扇）
+ */
+void cooling_model_default(cooling_model_t* model);
+
+void cooling_supervisor_init(cooling_supervisor_t* sup, const cooling_model_t* model);
+
+/**
+ * @brief 单通道电功率（W）
+ */
+float cooling_model_fan_power(const cooling_model_t* model, uint8_t fan);
+float cooling_model_tec_power(const cooling_model_t* model, uint8_t tec);
+
+/**
+ * @brief 设置总功率预算
+ * @param watts 上限（W），0 或负数表示不限制
+ */
+void cooling_supervisor_set_budget(cooling_supervisor_t* sup, float watts);
+
+/**
+ * @brief 估计给定占空比组合的总电功率和制冷量
+ * @param sup 监督器（使用模型和温差校正量）
+ * @param out 占空比组合
+ * @param cooling_w 输出：估计制冷量（W），可为 NULL
+ * @return 估计总电功率（W）
+ */
+float cooling_supervisor_estimate(const cooling_supervisor_t* sup, cooling_output_t out, float* cooling_w);
+
+/**
+ * @brief 选取满足制冷需求、总电功率最小的风扇/制冷片占空比组合
+ *        设有功率预算时只在预算内搜索，无法满足需求时取预算内制冷量最大的组合
+ * @param demand 制冷需求（0-100，相对最大制冷能力）
+ * @return 占空比组合（尚未经过联锁约束）
+ */
+cooling_output_t cooling_supervisor_optimize(const cooling_supervisor_t* sup, uint8_t demand);
+
+/**
+ * @brief 施加安全联锁和功率预算并记录输出，每个控制周期调用一次
+ * @param request 期望的占空比组合
+ * @param cold_c 冷端（被控对象）温度
+ * @param hot_c 热端温度，SUPERVISOR_HOT_UNKNOWN 表示未安装
+ * @param now_ms 单调时间（毫秒）
+ * @return 实际应输出的占空比组合
+ */
+cooling_output_t cooling_supervisor_step(cooling_supervisor_t* sup, cooling_output_t request,
+                                         float cold_c, float hot_c, uint32_t now_ms);
+
+/**
+ * @brief 在两次 step 之间单独调整风扇时（如手动调速），返回满足联锁和功率预算的风扇占空比
+ */
+uint8_t cooling_supervisor_limit_fan(const cooling_supervisor_t* sup, uint8_t fan);
+
+/**
+ * @brief 进入安全状态：制冷片关闭、风扇全速，并开始续转计时
+ *        用于控制任务停止运行等无法正常 step 的场合，下次 step 从此状态接续
+ * @return 应立即输出的占空比组合
+ */
+cooling_output_t cooling_supervisor_force_safe(cooling_supervisor_t* sup, uint32_t now_ms);
+
+#endif // COOLING_SUPERVISOR_H
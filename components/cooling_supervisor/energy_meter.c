@@ -0,0 +1,29 @@
+#include "energy_meter.h"
+#include <string.h>
+
+void energy_meter_init(energy_meter_t* em, uint64_t fan_mj, uint64_t tec_mj, int64_t now_us) {
+    memset(em, 0, sizeof(*em));
+    em->fan_mj = fan_mj;
+    em->tec_mj = tec_mj;
+    em->last_us = now_us;
+}
+
+static void accumulate(uint64_t* total_mj, float* residual_mj, float watts, int64_t dt_us) {
+    // W × us = uJ，除以 1000 得 mJ
+    float mj = *residual_mj + watts * (float)dt_us / 1000.0f;
+    uint64_t whole = (uint64_t)mj;
+    *total_mj += whole;
+    *residual_mj = mj - (float)whole;
+}
+
+void energy_meter_update(energy_meter_t* em, const cooling_model_t* model, cooling_output_t duty, int64_t now_us) {
+    int64_t dt_us = now_us - em->last_us;
+    if (dt_us > 0) {
+        accumulate(&em->fan_mj, &em->fan_residual_mj, em->fan_w, dt_us);
+        accumulate(&em->tec_mj, &em->tec_residual_mj, em->tec_w, dt_us);
+        em->last_us = now_us;
+    }
+    em->duty = duty;
+    em->fan_w = cooling_model_fan_power(model, duty.fan);
+    em->tec_w = cooling_model_tec_power(model, duty.tec);
+}
@@ -0,0 +1,43 @@
+#ifndef ENERGY_METER_H
+#define ENERGY_METER_H
+
+#include <stdint.h>
+#include "cooling_supervisor.h"
+
+/**
+ * @brief 风扇/制冷片电能计量：按指令占空比和功率模型对时间积分
+ *        占空比在两次设置之间保持不变，按零阶保持精确积分；累计值以毫焦为单位，
+ *        64 位整数保存，不足 1mJ 的部分留在余量中，长期累计无舍入漂移
+ *        纯C实现，不依赖ESP-IDF
+ */
+
+typedef struct {
+    cooling_output_t duty;      // 当前指令占空比
+    float fan_w;                // 当前功率
+    float tec_w;
+    int64_t last_us;            // 上次积分时刻
+    uint64_t fan_mj;            // 累计电能（毫焦）
+    uint64_t tec_mj;
+    float fan_residual_mj;      // 不足 1mJ 的余量
+    float tec_residual_mj;
+} energy_meter_t;
+
+/**
+ * @brief 初始化，累计值从 fan_mj/tec_mj 接续（重启后从 NVS 恢复）
+ */
+void energy_meter_init(energy_meter_t* em, uint64_t fan_mj, uint64_t tec_mj, int64_t now_us);
+
+/**
+ * @brief 以原占空比积分到 now_us，然后切换为新占空比
+ *        只需积分不改变占空比时传入当前值
+ */
+void energy_meter_update(energy_meter_t* em, const cooling_model_t* model, cooling_output_t duty, int64_t now_us);
+
+/**
+ * @brief 毫焦换算为千瓦时
+ */
+static inline float energy_meter_kwh(uint64_t mj) {
+    return (float)(mj / 1000) / 3.6e6f;
+}
+
+#endif // ENERGY_METER_H
@@ -0,0 +1,45 @@
+#include "deadline_monitor.h"
+#include <string.h>
+
+void deadline_monitor_init(deadline_monitor_t* dm, uint32_t grace_us, uint32_t safe_after) {
+    memset(dm, 0, sizeof(*dm));
+    dm->grace_us = grace_us;
+    dm->safe_after = safe_after ? safe_after : 1;
+}
+
+/**
+ * @brief 统计自上次 kick 以来越过的截止时间，返回新增部分
+ *        第 n 个截止时间为 last_kick + n × period + grace
+ */
+static uint32_t account(deadline_monitor_t* dm, int64_t now_us) {
+    if (dm->last_kick_us == 0 || dm->period_us == 0) return 0;
+    int64_t overdue = now_us - dm->last_kick_us - dm->period_us - dm->grace_us;
+    if (overdue < 0) return 0;
+
+    uint32_t total = (uint32_t)(overdue / dm->period_us) + 1;
+    if (total <= dm->gap_misses) return 0;
+    uint32_t added = total - dm->gap_misses;
+    dm->gap_misses = total;
+    dm->misses += added;
+    dm->last_miss_us = now_us;
+    return added;
+}
+
+uint32_t deadline_monitor_kick(deadline_monitor_t* dm, int64_t now_us, uint32_t next_period_us) {
+    uint32_t added = account(dm, now_us);
+    dm->last_kick_us = now_us;
+    dm->period_us = next_period_us;
+    dm->gap_misses = 0;
+    dm->safe_state = false;
+    return added;
+}
+
+bool deadline_monitor_check(deadline_monitor_t* dm, int64_t now_us) {
+    account(dm, now_us);
+    if (!dm->safe_state && dm->gap_misses >= dm->safe_after) {
+        dm->safe_state = true;
+        dm->safe_entries++;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,43 @@
+#ifndef DEADLINE_MONITOR_H
+#define DEADLINE_MONITOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 周期任务截止时间监视
+ *        被监视任务每个周期结束时 kick 一次并给出下一个周期长度；
+ *        另一上下文定期 check，任务停滞时也能按周期计数错过次数，
+ *        连续错过达到阈值后进入安全状态，直到任务恢复
+ *        纯C实现，不依赖ESP-IDF；调用方负责加锁
+ */
+
+typedef struct {
+    uint32_t grace_us;          // 允许的延迟余量
+    uint32_t safe_after;        // 连续错过多少个周期进入安全状态
+    uint32_t period_us;         // 当前计划周期
+    int64_t last_kick_us;       // 0 表示尚未开始
+    uint32_t gap_misses;        // 本次间隔内已计入的错过次数
+    uint32_t misses;            // 累计错过周期数
+    int64_t last_miss_us;       // 最近一次错过的时间，0 表示从未错过
+    bool safe_state;            // 处于安全状态
+    uint32_t safe_entries;      // 进入安全状态的次数
+} deadline_monitor_t;
+
+void deadline_monitor_init(deadline_monitor_t* dm, uint32_t grace_us, uint32_t safe_after);
+
+/**
+ * @brief 被监视任务完成一个周期
+ * @param now_us 单调时间（微秒）
+ * @param next_period_us 到下一次 kick 的计划周期
+ * @return 本次新计入的错过周期数（check 已计入的不重复计）
+ */
+uint32_t deadline_monitor_kick(deadline_monitor_t* dm, int64_t now_us, uint32_t next_period_us);
+
+/**
+ * @brief 监视侧定期调用，统计停滞期间错过的周期
+ * @return true 表示本次调用进入安全状态，调用方应立即输出安全值
+ */
+bool deadline_monitor_check(deadline_monitor_t* dm, int64_t now_us);
+
+#endif // DEADLINE_MONITOR_H
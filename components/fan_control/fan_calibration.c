@@ -0,0 +1,74 @@
+#include "fan_calibration.h"
+
+#define FAN_CAL_DUTY_STEP (FAN_CURVE_DUTY_MAX / (FAN_CAL_STEPS - 1))
+
+void fan_cal_start(fan_cal_t* cal, uint32_t purge_ms, uint32_t now_ms) {
+    cal->phase = purge_ms ? FAN_CAL_PURGE : FAN_CAL_SWEEP;
+    cal->step = 0;
+    cal->phase_start_ms = now_ms;
+    cal->purge_ms = purge_ms;
+    cal->pulses = 0;
+    cal->window_ms = 0;
+    cal->last_ms = now_ms;
+}
+
+static void finish(fan_cal_t* cal) {
+    fan_curve_t curve;
+    if (fan_curve_build(cal->duty_pm, cal->rpm, FAN_CAL_STEPS, &curve)) {
+        cal->curve = curve;
+        cal->phase = FAN_CAL_DONE;
+    } else {
+        cal->phase = FAN_CAL_FAILED;
+    }
+}
+
+uint16_t fan_cal_step(fan_cal_t* cal, uint32_t pulses, uint32_t now_ms) {
+    uint32_t dt = now_ms - cal->last_ms;
+    cal->last_ms = now_ms;
+
+    switch (cal->phase) {
+    case FAN_CAL_PURGE:
+        if (now_ms - cal->phase_start_ms < cal->purge_ms) return FAN_CURVE_DUTY_MAX;
+        cal->phase = FAN_CAL_SWEEP;
+        cal->step = 0;
+        cal->phase_start_ms = now_ms;
+        cal->pulses = 0;
+        cal->window_ms = 0;
+        break;
+    case FAN_CAL_SWEEP:
+        // 只累计稳定时间之后的脉冲；跨越稳定边界的周期整个丢弃，窗口按实际计数时长折算
+        if (now_ms - cal->phase_start_ms >= FAN_CAL_SETTLE_MS + dt) {
+            cal->pulses += pulses;
+            cal->window_ms += dt;
+        }
+        if (cal->window_ms >= FAN_CAL_MEASURE_MS) {
+            cal->duty_pm[cal->step] = (uint16_t)(cal->step * FAN_CAL_DUTY_STEP);
+            cal->rpm[cal->step] = cal->pulses * 60000.0f / (FAN_CAL_PULSES_PER_REV * cal->window_ms);
+            if (++cal->step == FAN_CAL_STEPS) {
+                finish(cal);
+                return 0;
+            }
+            cal->phase_start_ms = now_ms;
+            cal->pulses = 0;
+            cal->window_ms = 0;
+        }
+        break;
+    default:
+        return 0;
+    }
+    return (uint16_t)(cal->step * FAN_CAL_DUTY_STEP);
+}
+
+void fan_cal_abort(fan_cal_t* cal) {
+    if (cal->phase == FAN_CAL_PURGE || cal->phase == FAN_CAL_SWEEP) {
+        cal->phase = FAN_CAL_FAILED;
+    }
+}
+
+uint8_t fan_cal_progress(const fan_cal_t* cal) {
+    switch (cal->phase) {
+    case FAN_CAL_SWEEP: return (uint8_t)(cal->step * 100 / FAN_CAL_STEPS);
+    case FAN_CAL_DONE:  return 100;
+    default:            return 0;
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef FAN_CALIBRATION_H
+#define FAN_CALIBRATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fan_curve.h"
+
+/**
+ * @brief 风扇线性化校准：逐级扫描占空比，每级稳定后用测速脉冲计算转速，
+ *        扫描结束由 fan_curve_build() 生成反查表
+ *        纯C实现，不依赖ESP-IDF；每个采样周期调用 fan_cal_step()，传入自上次调用以来的测速脉冲数
+ */
+
+#define FAN_CAL_STEPS        FAN_CURVE_POINTS   // 占空比 0‰、50‰、…、1000‰
+#define FAN_CAL_SETTLE_MS    3000               // 每级切换后等待转速稳定
+#define FAN_CAL_MEASURE_MS   2000               // 每级计数窗口
+#define FAN_CAL_PULSES_PER_REV 2                // 4 线风扇测速线每转 2 个脉冲
+
+typedef enum {
+    FAN_CAL_IDLE = 0,
+    FAN_CAL_PURGE,              // 全速运行，排出制冷片余热后再开始扫描
+    FAN_CAL_SWEEP,
+    FAN_CAL_DONE,               // 结果在 curve 中
+    FAN_CAL_FAILED,             // 转速没有随占空比上升（未接测速线或风扇不转）或被中止
+} fan_cal_phase_t;
+
+typedef struct {
+    fan_cal_phase_t phase;
+    uint8_t step;               // 当前扫描级
+    uint32_t phase_start_ms;    // 当前阶段/级开始时刻
+    uint32_t purge_ms;
+    uint32_t pulses;            // 当前级计数窗口内的脉冲
+    uint32_t window_ms;         // 当前级已计数的时长
+    uint32_t last_ms;
+    uint16_t duty_pm[FAN_CAL_STEPS];
+    float rpm[FAN_CAL_STEPS];
+    fan_curve_t curve;
+} fan_cal_t;
+
+/**
+ * @brief 开始校准
+ * @param purge_ms 扫描前全速运行的时间，制冷片刚关闭时传入余热排出时间，否则为 0
+ */
+void fan_cal_start(fan_cal_t* cal, uint32_t purge_ms, uint32_t now_ms);
+
+/**
+ * @brief 推进一个采样周期
+ * @param pulses 自上次调用以来的测速脉冲数
+ * @param now_ms 单调时间（毫秒）
+ * @return 本周期应输出的原始占空比（‰），校准结束后返回 0
+ */
+uint16_t fan_cal_step(fan_cal_t* cal, uint32_t pulses, uint32_t now_ms);
+
+void fan_cal_abort(fan_cal_t* cal);
+
+/**
+ * @brief 进度百分比（用于显示）
+ */
+uint8_t fan_cal_progress(const fan_cal_t* cal);
+
+#endif // FAN_CALIBRATION_H
@@ -1,10 +1,34 @@
 #include "fan_control.h"
 #include "esp_err.h"
+#include "esp_log.h"
+#include "driver/pulse_cnt.h"
+#include "freertos/FreeRTOS.h"
+#include "power_mgmt.h"
+
+static const char *TAG = "FAN";
+
+// 启用电源管理时 APB 会随 DFS 变化，改用低速模式 + RC_FAST 时钟，
+// 该时钟不受调频影响且可在浅睡眠中保持，保证 PWM 输出无毛刺
+#ifdef CONFIG_PM_ENABLE
+#define PWM_SPEED_MODE LEDC_LOW_SPEED_MODE
+#define PWM_CLK_CFG    LEDC_USE_RC_FAST_CLK
+#else
+#define PWM_SPEED_MODE LEDC_HIGH_SPEED_MODE
+#define PWM_CLK_CFG    LEDC_AUTO_CLK
+#endif
+
+#define PWM_DUTY_MAX ((1 << 8) - 1)
 
 // 静态变量分别保存两个通道
 static ledc_channel_t cooler_channel;
 static ledc_channel_t fan_channel;
 
+// 线性化表：启动时为编译生成的默认表，校准或从 NVS 加载后替换
+static fan_curve_t s_curve;
+static portMUX_TYPE s_curve_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static pcnt_unit_handle_t s_tach_unit = NULL;
+
 /**
  * @brief 初始化制冷片 PWM 控制
  * @param channel LEDC 通道，用于输出 PWM 信号
@@ -14,18 +38,18 @@ void cooler_pwm_init(ledc_channel_t channel, gpio_num_t pin) {
     cooler_channel = channel;
     // 配置 LEDC 定时器参数
     ledc_timer_config_t ledc_timer = {
-        .speed_mode       = LEDC_HIGH_SPEED_MODE,  // 高速模式
+        .speed_mode       = PWM_SPEED_MODE,
         .timer_num        = LEDC_TIMER_0,          // 定时器 0
         .duty_resolution  = LEDC_TIMER_8_BIT,      // 8 位分辨率
         .freq_hz          = 25000,                 // 25 kHz PWM 频率
-        .clk_cfg          = LEDC_AUTO_CLK,         // 自动时钟
+        .clk_cfg          = PWM_CLK_CFG,
     };
     ledc_timer_config(&ledc_timer);
 
     // 配置 LEDC 通道参数
     ledc_channel_config_t ledc_channel_conf = {
         .gpio_num       = pin,                     // PWM 输出管脚
-        .speed_mode     = LEDC_HIGH_SPEED_MODE,
+        .speed_mode     = PWM_SPEED_MODE,
         .channel        = channel,                 // 使用的通道
         .intr_type      = LEDC_INTR_DISABLE,       // 关闭中断
         .timer_sel      = LEDC_TIMER_0,            // 定时器 0
@@ -43,9 +67,11 @@ void cooler_pwm_set_power(uint8_t power) {
     if (power > 100) power = 100;
     // 将百分比映射到 8 位占空比值
     uint32_t duty = (power * ((1 << 8) - 1)) / 100;
-    // 设置占空比并更新
-    ledc_set_duty(LEDC_HIGH_SPEED_MODE, cooler_channel, duty);
-    ledc_update_duty(LEDC_HIGH_SPEED_MODE, cooler_channel);
+    // 设置占空比并更新（新占空比在下一个PWM周期边界生效）
+    power_mgmt_acquire(PM_LOCK_LEDC);
+    ledc_set_duty(PWM_SPEED_MODE, cooler_channel, duty);
+    ledc_update_duty(PWM_SPEED_MODE, cooler_channel);
+    power_mgmt_release(PM_LOCK_LEDC);
 }
 
 /**
@@ -57,36 +83,117 @@ void fan_pwm_init(ledc_channel_t channel, gpio_num_t pin) {
     fan_channel = channel;
     // 配置 LEDC 定时器参数
     ledc_timer_config_t ledc_timer = {
-        .speed_mode       = LEDC_HIGH_SPEED_MODE,  // 高速模式
+        .speed_mode       = PWM_SPEED_MODE,
         .timer_num        = LEDC_TIMER_1,          // 定时器 1
         .duty_resolution  = LEDC_TIMER_8_BIT,      // 8 位分辨率
         .freq_hz          = 25000,                 // 25 kHz PWM 频率
-        .clk_cfg          = LEDC_AUTO_CLK,         // 自动时钟
+        .clk_cfg          = PWM_CLK_CFG,
     };
     ledc_timer_config(&ledc_timer);
 
     // 配置 LEDC 通道参数
     ledc_channel_config_t ledc_channel_conf = {
         .gpio_num       = pin,                     // PWM 输出管脚
-        .speed_mode     = LEDC_HIGH_SPEED_MODE,
+        .speed_mode     = PWM_SPEED_MODE,
         .channel        = channel,                 // 使用的通道
         .intr_type      = LEDC_INTR_DISABLE,       // 关闭中断
         .timer_sel      = LEDC_TIMER_1,            // 定时器 1
         .duty           = 0,                       // 初始占空比 0
     };
     ledc_channel_config(&ledc_channel_conf);
+    fan_curve_default(&s_curve);
 }
 
 /**
- * @brief 设置风扇转速
- * @param speed 转速百分比 (0-100)
+ * @brief 直接设置风扇占空比
+ * @param duty_pm 占空比千分比 (0-1000)
+ */
+void fan_pwm_set_duty_raw(uint16_t duty_pm) {
+    if (duty_pm > FAN_CURVE_DUTY_MAX) duty_pm = FAN_CURVE_DUTY_MAX;
+    // 千分比映射到 8 位占空比值（四舍五入）
+    uint32_t duty = (duty_pm * PWM_DUTY_MAX + FAN_CURVE_DUTY_MAX / 2) / FAN_CURVE_DUTY_MAX;
+    // 设置占空比并更新（新占空比在下一个PWM周期边界生效）
+    power_mgmt_acquire(PM_LOCK_LEDC);
+    ledc_set_duty(PWM_SPEED_MODE, fan_channel, duty);
+    ledc_update_duty(PWM_SPEED_MODE, fan_channel);
+    power_mgmt_release(PM_LOCK_LEDC);
+}
+
+/**
+ * @brief 设置风扇气流
+ * @param speed 气流百分比 (0-100)
  */
 void fan_pwm_set_speed(uint8_t speed) {
     // 限制范围
     if (speed > 100) speed = 100;
-    // 将百分比映射到 8 位占空比值
-    uint32_t duty = (speed * ((1 << 8) - 1)) / 100;
-    // 设置占空比并更新
-    ledc_set_duty(LEDC_HIGH_SPEED_MODE, fan_channel, duty);
-    ledc_update_duty(LEDC_HIGH_SPEED_MODE, fan_channel);
+    portENTER_CRITICAL(&s_curve_mux);
+    uint16_t duty_pm = fan_curve_duty(&s_curve, speed);
+    portEXIT_CRITICAL(&s_curve_mux);
+    fan_pwm_set_duty_raw(duty_pm);
+}
+
+bool fan_pwm_set_curve(const fan_curve_t* curve) {
+    if (!fan_curve_valid(curve)) return false;
+    portENTER_CRITICAL(&s_curve_mux);
+    s_curve = *curve;
+    portEXIT_CRITICAL(&s_curve_mux);
+    return true;
+}
+
+void fan_pwm_get_curve(fan_curve_t* curve) {
+    portENTER_CRITICAL(&s_curve_mux);
+    *curve = s_curve;
+    portEXIT_CRITICAL(&s_curve_mux);
+}
+
+/**
+ * @brief 初始化风扇测速
+ * @param pin 测速线 GPIO
+ */
+void fan_tach_init(gpio_num_t pin) {
+    pcnt_unit_config_t unit_config = {
+        .low_limit  = -1,
+        .high_limit = 32767,
+    };
+    if (pcnt_new_unit(&unit_config, &s_tach_unit) != ESP_OK) {
+        ESP_LOGE(TAG, "测速 PCNT 单元创建失败");
+        s_tach_unit = NULL;
+        return;
+    }
+    // 滤掉 PWM 串扰产生的窄毛刺（25 kHz PWM 周期 40us，测速脉冲为毫秒级）
+    pcnt_glitch_filter_config_t filter_config = {
+        .max_glitch_ns = 1000,
+    };
+    pcnt_unit_set_glitch_filter(s_tach_unit, &filter_config);
+
+    pcnt_chan_config_t chan_config = {
+        .edge_gpio_num  = pin,
+        .level_gpio_num = -1,
+    };
+    pcnt_channel_handle_t chan;
+    ESP_ERROR_CHECK(pcnt_new_channel(s_tach_unit, &chan_config, &chan));
+    // 上升沿计数，下降沿忽略
+    pcnt_channel_set_edge_action(chan, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_HOLD);
+    gpio_set_pull_mode(pin, GPIO_PULLUP_ONLY);
+    ESP_ERROR_CHECK(pcnt_unit_enable(s_tach_unit));
+}
+
+void fan_tach_enable(bool enable) {
+    if (!s_tach_unit) return;
+    if (enable) {
+        power_mgmt_acquire(PM_LOCK_TACH);
+        pcnt_unit_clear_count(s_tach_unit);
+        pcnt_unit_start(s_tach_unit);
+    } else {
+        pcnt_unit_stop(s_tach_unit);
+        power_mgmt_release(PM_LOCK_TACH);
+    }
+}
+
+uint32_t fan_tach_take_pulses(void) {
+    if (!s_tach_unit) return 0;
+    int count = 0;
+    pcnt_unit_get_count(s_tach_unit, &count);
+    pcnt_unit_clear_count(s_tach_unit);
+    return count > 0 ? (uint32_t)count : 0;
 }
@@ -1,8 +1,10 @@
 #ifndef FAN_CONTROL_H
 #define FAN_CONTROL_H
 
+#include <stdbool.h>
 #include "driver/ledc.h"
 #include "driver/gpio.h"
+#include "fan_curve.h"
 
 /**
  * @brief 初始化制冷片 PWM 控制
@@ -25,9 +27,40 @@ void cooler_pwm_set_power(uint8_t power);
 void fan_pwm_init(ledc_channel_t channel, gpio_num_t pin);
 
 /**
- * @brief 设置风扇转速
- * @param speed 转速百分比 (0-100)
+ * @brief 设置风扇气流
+ *        经线性化表换算为占空比，使控制器输出与气流近似成正比
+ * @param speed 气流百分比 (0-100)
  */
 void fan_pwm_set_speed(uint8_t speed);
 
+/**
+ * @brief 直接设置风扇占空比，不经线性化（校准扫描用）
+ * @param duty_pm 占空比千分比 (0-1000)
+ */
+void fan_pwm_set_duty_raw(uint16_t duty_pm);
+
+/**
+ * @brief 替换线性化表，下一次 fan_pwm_set_speed() 生效
+ * @return false 表无效，仍使用原表
+ */
+bool fan_pwm_set_curve(const fan_curve_t* curve);
+
+void fan_pwm_get_curve(fan_curve_t* curve);
+
+/**
+ * @brief 初始化风扇测速（PCNT 对测速线上升沿计数）
+ * @param pin 测速线 GPIO，开漏输出，需要上拉
+ */
+void fan_tach_init(gpio_num_t pin);
+
+/**
+ * @brief 开始/停止测速，计数期间持有电源锁禁止浅睡眠
+ */
+void fan_tach_enable(bool enable);
+
+/**
+ * @brief 读取并清零自上次调用以来的测速脉冲数
+ */
+uint32_t fan_tach_take_pulses(void);
+
 #endif // FAN_CONTROL_H
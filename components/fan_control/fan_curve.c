@@ -0,0 +1,84 @@
+#include "fan_curve.h"
+#include <string.h>
+
+#include "fan_curve_default.h"  // 构建时生成：FAN_CURVE_DEFAULT_PM[]
+
+#define FAN_CURVE_MAX_SAMPLES   64
+// 最大响应低于此值视为未测到转动（与单位无关的下限，转速时约等于停转）
+#define FAN_CURVE_MIN_RESPONSE  1.0f
+
+_Static_assert(sizeof(FAN_CURVE_DEFAULT_PM) / sizeof(FAN_CURVE_DEFAULT_PM[0]) == FAN_CURVE_POINTS,
+               "生成的默认表点数与 FAN_CURVE_POINTS 不一致");
+
+void fan_curve_default(fan_curve_t* curve) {
+    memcpy(curve->duty_pm, FAN_CURVE_DEFAULT_PM, sizeof(curve->duty_pm));
+}
+
+bool fan_curve_valid(const fan_curve_t* curve) {
+    if (curve->duty_pm[0] != 0) return false;
+    for (int i = 1; i < FAN_CURVE_POINTS; i++) {
+        if (curve->duty_pm[i] < curve->duty_pm[i - 1] || curve->duty_pm[i] > FAN_CURVE_DUTY_MAX) return false;
+    }
+    return curve->duty_pm[FAN_CURVE_POINTS - 1] > 0;
+}
+
+uint16_t fan_curve_duty(const fan_curve_t* curve, uint8_t airflow_pct) {
+    if (airflow_pct == 0) return 0;
+    if (airflow_pct >= 100) return curve->duty_pm[FAN_CURVE_POINTS - 1];
+    int i = airflow_pct / FAN_CURVE_STEP;
+    int frac = airflow_pct % FAN_CURVE_STEP;
+    // 1-4% 不向 0 插值，否则会落进死区导致风扇不转
+    if (i == 0) return curve->duty_pm[1];
+    uint16_t lo = curve->duty_pm[i];
+    uint16_t hi = curve->duty_pm[i + 1];
+    return (uint16_t)(lo + (int32_t)(hi - lo) * frac / FAN_CURVE_STEP);
+}
+
+bool fan_curve_build(const uint16_t* duty_pm, const float* response, int n, fan_curve_t* out) {
+    if (n < 3 || n > FAN_CURVE_MAX_SAMPLES) return false;
+
+    // 保序回归（PAVA）：违序的相邻块合并为均值
+    float level[FAN_CURVE_MAX_SAMPLES];
+    int weight[FAN_CURVE_MAX_SAMPLES];
+    int blocks = 0;
+    for (int i = 0; i < n; i++) {
+        level[blocks] = response[i] > 0.0f ? response[i] : 0.0f;
+        weight[blocks] = 1;
+        blocks++;
+        while (blocks > 1 && level[blocks - 2] > level[blocks - 1]) {
+            int w = weight[blocks - 2] + weight[blocks - 1];
+            level[blocks - 2] = (level[blocks - 2] * weight[blocks - 2] + level[blocks - 1] * weight[blocks - 1]) / w;
+            weight[blocks - 2] = w;
+            blocks--;
+        }
+    }
+    float fit[FAN_CURVE_MAX_SAMPLES];
+    for (int b = 0, i = 0; b < blocks; b++) {
+        for (int k = 0; k < weight[b]; k++) fit[i++] = level[b];
+    }
+
+    float top = fit[n - 1];
+    if (top < FAN_CURVE_MIN_RESPONSE || fit[0] >= top) return false;
+
+    fan_curve_t curve;
+    curve.duty_pm[0] = 0;
+    int j = 0;
+    for (int p = 1; p < FAN_CURVE_POINTS; p++) {
+        float target = top * p / (FAN_CURVE_POINTS - 1);
+        while (j < n - 2 && fit[j + 1] < target) j++;
+        float y0 = fit[j], y1 = fit[j + 1];
+        float duty;
+        if (target <= y0) {
+            duty = duty_pm[j];
+        } else if (target >= y1) {
+            duty = duty_pm[j + 1];
+        } else {
+            duty = duty_pm[j] + (duty_pm[j + 1] - duty_pm[j]) * (target - y0) / (y1 - y0);
+        }
+        uint16_t d = (uint16_t)(duty + 0.5f);
+        if (d > FAN_CURVE_DUTY_MAX) d = FAN_CURVE_DUTY_MAX;
+        curve.duty_pm[p] = d < curve.duty_pm[p - 1] ? curve.duty_pm[p - 1] : d;
+    }
+    *out = curve;
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef FAN_CURVE_H
+#define FAN_CURVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 风扇占空比线性化：气流百分比 → PWM 占空比的单调反查表
+ *        风扇在约 20% 占空比以下不转、接近满占空比时饱和，直接按占空比控制时
+ *        控制增益在不同区段差异很大。表按每 5% 气流一个点保存所需占空比（千分比），
+ *        中间线性插值
+ *        纯C实现，不依赖ESP-IDF
+ */
+
+#define FAN_CURVE_POINTS    21      // 气流 0%、5%、…、100%
+#define FAN_CURVE_STEP      5
+#define FAN_CURVE_DUTY_MAX  1000    // 占空比千分比满量程
+
+typedef struct {
+    uint16_t duty_pm[FAN_CURVE_POINTS];    // 达到对应气流所需占空比（‰），单调不减
+} fan_curve_t;
+
+/**
+ * @brief 编译时按默认风扇模型生成的表（见 gen_fan_curve.py）
+ */
+void fan_curve_default(fan_curve_t* curve);
+
+/**
+ * @brief 检查表是否可用：首点为 0、单调不减、不超过满量程
+ */
+bool fan_curve_valid(const fan_curve_t* curve);
+
+/**
+ * @brief 气流百分比对应的占空比
+ * @param airflow_pct 0-100，0 表示停转
+ * @return 占空比（‰）
+ */
+uint16_t fan_curve_duty(const fan_curve_t* curve, uint8_t airflow_pct);
+
+/**
+ * @brief 由扫频测量结果构建反查表
+ *        响应（转速）先做保序回归（相邻违序合并）得到单调曲线，按最大响应归一化为气流，
+ *        再对每个目标气流在相邻测量点之间线性反插值
+ * @param duty_pm 测量点占空比（‰），严格递增
+ * @param response 对应响应（如转速），单位任意
+ * @param n 测量点数（至少 3）
+ * @param out 输出表
+ * @return false 响应没有随占空比上升（风扇未接测速线或未转动），out 不变
+ */
+bool fan_curve_build(const uint16_t* duty_pm, const float* response, int n, fan_curve_t* out);
+
+#endif // FAN_CURVE_H
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""生成默认风扇线性化表 fan_curve_default.h（构建时由 CMake 调用）。
+
+默认风扇模型：占空比低于 DEAD_ZONE 不转，高于 SATURATION 后转速不再上升，
+中间段气流 ≈ 1-(1-t)^2（低占空比时增益大、接近饱和时增益小，典型的 4 线 PWM 风扇）。
+对模型做数值反解，得到每 5% 气流所需的占空比（千分比）。
+
+用法：python gen_fan_curve.py <输出头文件>
+"""
+
+import sys
+
+POINTS = 21
+DEAD_ZONE = 0.20
+SATURATION = 0.90
+
+
+def airflow(duty):
+    """默认模型：占空比 (0-1) → 归一化气流 (0-1)。"""
+    if duty <= DEAD_ZONE:
+        return 0.0
+    t = min((duty - DEAD_ZONE) / (SATURATION - DEAD_ZONE), 1.0)
+    return 1.0 - (1.0 - t) ** 2
+
+
+def duty_for(target):
+    """二分求满足 airflow(duty) >= target 的最小占空比。"""
+    lo, hi = DEAD_ZONE, SATURATION
+    for _ in range(40):
+        mid = (lo + hi) / 2
+        if airflow(mid) < target:
+            lo = mid
+        else:
+            hi = mid
+    return hi
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit("usage: gen_fan_curve.py <output.h>")
+    table = [0]
+    for i in range(1, POINTS):
+        table.append(max(table[-1], round(duty_for(i / (POINTS - 1)) * 1000)))
+
+    rows = ", ".join(str(v) for v in table)
+    text = (
+        "// 由 gen_fan_curve.py 生成，请勿手工修改\n"
+        "#pragma once\n"
+        "#include <stdint.h>\n\n"
+        f"// 默认模型：死区 {DEAD_ZONE:.0%}，饱和 {SATURATION:.0%}，气流 = 1-(1-t)^2\n"
+        f"static const uint16_t FAN_CURVE_DEFAULT_PM[{POINTS}] = {{ {rows} }};\n"
+    )
+    # 内容不变时不重写，避免触发无谓的重新编译
+    try:
+        with open(sys.argv[1], encoding="utf-8") as f:
+            if f.read() == text:
+                return
+    except OSError:
+        pass
+    with open(sys.argv[1], "w", encoding="utf-8") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main()
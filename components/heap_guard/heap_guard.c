@@ -0,0 +1,86 @@
+#include "heap_guard.h"
+#include "esp_heap_caps.h"
+#include "esp_attr.h"
+#include "sdkconfig.h"
+#include <stdatomic.h>
+
+static TaskHandle_t s_tasks[HEAP_GUARD_MAX_TASKS];
+static _Atomic uint32_t s_allocs[HEAP_GUARD_MAX_TASKS];
+static _Atomic uint32_t s_last_size;
+static volatile int s_task_count = 0;
+static volatile bool s_armed = false;
+
+#if CONFIG_HEAP_USE_HOOKS
+/**
+ * @brief 堆分配钩子，在分配器内部调用（可能处于临界区），只做查表和原子计数
+ */
+void IRAM_ATTR esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+    if (!s_armed) return;
+    TaskHandle_t current = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < s_task_count; i++) {
+        if (s_tasks[i] == current) {
+            atomic_fetch_add_explicit(&s_allocs[i], 1, memory_order_relaxed);
+            atomic_store_explicit(&s_last_size, (uint32_t)size, memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+void IRAM_ATTR esp_heap_trace_free_hook(void* ptr) {
+}
+#endif
+
+bool heap_guard_watch(TaskHandle_t task) {
+    if (!task || s_task_count >= HEAP_GUARD_MAX_TASKS) return false;
+    s_tasks[s_task_count] = task;
+    s_task_count++;
+    return true;
+}
+
+void heap_guard_mark_baseline(void) {
+    for (int i = 0; i < HEAP_GUARD_MAX_TASKS; i++) {
+        atomic_store(&s_allocs[i], 0);
+    }
+    atomic_store(&s_last_size, 0);
+    s_armed = true;
+}
+
+uint32_t heap_guard_allocs(TaskHandle_t task) {
+    for (int i = 0; i < s_task_count; i++) {
+        if (s_tasks[i] == task) return atomic_load(&s_allocs[i]);
+    }
+    return 0;
+}
+
+uint32_t heap_guard_total(size_t* last_size) {
+    uint32_t total = 0;
+    for (int i = 0; i < s_task_count; i++) {
+        total += atomic_load(&s_allocs[i]);
+    }
+    if (last_size) *last_size = atomic_load(&s_last_size);
+    return total;
+}
+
+void heap_guard_get_stats(heap_guard_stats_t* stats) {
+    const uint32_t caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    stats->free_bytes = (uint32_t)heap_caps_get_free_size(caps);
+    stats->largest_block = (uint32_t)heap_caps_get_largest_free_block(caps);
+    stats->frag_pct = stats->free_bytes
+        ? (uint8_t)(100 - (uint64_t)stats->largest_block * 100 / stats->free_bytes)
+        : 0;
+}
+
+static uint32_t s_peak_base = 0;
+
+void heap_guard_peak_begin(void) {
+    const uint32_t caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    s_peak_base = (uint32_t)heap_caps_get_free_size(caps);
+    heap_caps_monitor_local_minimum_free_size_start();
+}
+
+uint32_t heap_guard_peak_end(void) {
+    const uint32_t caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    uint32_t low = (uint32_t)heap_caps_get_minimum_free_size(caps);
+    heap_caps_monitor_local_minimum_free_size_stop();
+    return s_peak_base > low ? s_peak_base - low : 0;
+}
@@ -0,0 +1,64 @@
+#ifndef HEAP_GUARD_H
+#define HEAP_GUARD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/**
+ * @brief 稳态堆分配检查和内部 DRAM 碎片统计
+ *        通过 CONFIG_HEAP_USE_HOOKS 的分配钩子统计被监视任务在基线之后的分配次数；
+ *        初始化阶段的分配不计入，基线之后任何一次分配都说明稳态路径仍在使用堆。
+ *        未启用钩子时计数恒为 0
+ */
+
+#define HEAP_GUARD_MAX_TASKS    4
+
+typedef struct {
+    uint32_t free_bytes;        // 内部 DRAM 可用总量
+    uint32_t largest_block;     // 最大连续可用块
+    uint8_t frag_pct;           // 100 × (1 − 最大块 / 可用总量)
+} heap_guard_stats_t;
+
+/**
+ * @brief 加入监视列表（初始化阶段调用）
+ * @return false 列表已满
+ */
+bool heap_guard_watch(TaskHandle_t task);
+
+/**
+ * @brief 清零计数并开始检查，在被监视任务完成预热后调用
+ */
+void heap_guard_mark_baseline(void);
+
+/**
+ * @brief 基线之后指定任务的分配次数
+ */
+uint32_t heap_guard_allocs(TaskHandle_t task);
+
+/**
+ * @brief 基线之后所有被监视任务的分配次数之和
+ * @param last_size 输出：最近一次分配的字节数，可为 NULL
+ */
+uint32_t heap_guard_total(size_t* last_size);
+
+/**
+ * @brief 读取内部 DRAM 可用量和碎片程度
+ */
+void heap_guard_get_stats(heap_guard_stats_t* stats);
+
+/**
+ * @brief 开始记录内部 DRAM 的局部最低可用量，用于测量一次短操作（如 TLS 握手）的峰值占用
+ *        底层监视是全局的，同一时刻只应有一个调用者；期间其他任务的分配也会计入
+ */
+void heap_guard_peak_begin(void);
+
+/**
+ * @brief 结束记录
+ * @return 自 heap_guard_peak_begin 以来可用量的最大降幅（字节）
+ */
+uint32_t heap_guard_peak_end(void);
+
+#endif // HEAP_GUARD_H
@@ -0,0 +1,339 @@
+#include "history.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char* const s_field_names[] = { "temp", "fan", "tec" };
+
+static void acc_reset(history_acc_t* acc, uint32_t index) {
+    memset(acc, 0, sizeof(*acc));
+    acc->index = index;
+    acc->temp_min = INT16_MAX;
+    acc->temp_max = INT16_MIN;
+}
+
+static void level_init(history_level_t* level, history_bucket_t* slots, uint16_t len, uint16_t period_s) {
+    memset(level, 0, sizeof(*level));
+    level->slots = slots;
+    level->len = len;
+    level->period_s = period_s;
+    acc_reset(&level->acc, 0);
+}
+
+void history_init(history_t* h) {
+    memset(h, 0, sizeof(*h));
+    level_init(&h->l1, h->l1_slots, HISTORY_L1_LEN, HISTORY_L1_PERIOD_S);
+    level_init(&h->l2, h->l2_slots, HISTORY_L2_LEN, HISTORY_L2_PERIOD_S);
+}
+
+/**
+ * @brief 追加一个桶，序号间隙以无效桶填充
+ */
+static void level_push(history_level_t* level, uint32_t index, history_bucket_t bucket) {
+    if (level->count > 0) {
+        if (index <= level->last_index) return;
+        uint32_t gap = index - level->last_index - 1;
+        if (gap > level->len) gap = level->len;
+        history_bucket_t empty = { HISTORY_INVALID, HISTORY_INVALID, HISTORY_INVALID, 0, 0 };
+        while (gap--) {
+            level->slots[level->head] = empty;
+            level->head = (level->head + 1) % level->len;
+            if (level->count < level->len) level->count++;
+        }
+    }
+    level->slots[level->head] = bucket;
+    level->head = (level->head + 1) % level->len;
+    if (level->count < level->len) level->count++;
+    level->last_index = index;
+}
+
+static history_bucket_t acc_to_bucket(const history_acc_t* acc) {
+    history_bucket_t b = { HISTORY_INVALID, HISTORY_INVALID, HISTORY_INVALID, 0, 0 };
+    if (acc->temp_count > 0) {
+        b.temp_min = acc->temp_min;
+        b.temp_max = acc->temp_max;
+        b.temp_avg = (int16_t)(acc->temp_sum / (int32_t)acc->temp_count);
+    }
+    if (acc->count > 0) {
+        b.fan = (uint8_t)(acc->fan_sum / acc->count);
+        b.tec = (uint8_t)(acc->tec_sum / acc->count);
+    }
+    return b;
+}
+
+/**
+ * @brief 把一个累加器并入另一个（L1 完成的桶并入 L2，保持总和精确）
+ */
+static void acc_merge(history_acc_t* dst, const history_acc_t* src) {
+    dst->temp_sum += src->temp_sum;
+    dst->temp_count += src->temp_count;
+    if (src->temp_count > 0) {
+        if (src->temp_min < dst->temp_min) dst->temp_min = src->temp_min;
+        if (src->temp_max > dst->temp_max) dst->temp_max = src->temp_max;
+    }
+    dst->fan_sum += src->fan_sum;
+    dst->tec_sum += src->tec_sum;
+    dst->count += src->count;
+}
+
+/**
+ * @brief 向汇总级别加入数据；跨越桶边界时先完成旧桶
+ * @return 完成的旧桶的累加器（未完成时 count 为 0）
+ */
+static history_acc_t level_add(history_level_t* level, uint32_t now_s, const history_acc_t* src) {
+    history_acc_t done = { 0 };
+    uint32_t index = now_s / level->period_s;
+    if (level->acc.count > 0 && index != level->acc.index) {
+        done = level->acc;
+        level_push(level, done.index, acc_to_bucket(&done));
+        acc_reset(&level->acc, index);
+    } else if (level->acc.count == 0) {
+        acc_reset(&level->acc, index);
+    }
+    acc_merge(&level->acc, src);
+    return done;
+}
+
+/**
+ * @brief 追加一秒的原始样本并计入汇总
+ */
+static void raw_push(history_t* h, uint32_t now_s, history_sample_t sample) {
+    h->raw[h->raw_head] = sample;
+    h->raw_head = (h->raw_head + 1) % HISTORY_RAW_LEN;
+    if (h->raw_count < HISTORY_RAW_LEN) h->raw_count++;
+    h->raw_last_s = now_s;
+
+    history_acc_t one;
+    acc_reset(&one, 0);
+    if (sample.temp_centi != HISTORY_INVALID) {
+        one.temp_sum = sample.temp_centi;
+        one.temp_count = 1;
+        one.temp_min = sample.temp_centi;
+        one.temp_max = sample.temp_centi;
+    }
+    one.fan_sum = sample.fan;
+    one.tec_sum = sample.tec;
+    one.count = 1;
+
+    history_acc_t l1_done = level_add(&h->l1, now_s, &one);
+    if (l1_done.count > 0) {
+        level_add(&h->l2, l1_done.index * HISTORY_L1_PERIOD_S, &l1_done);
+    }
+}
+
+void history_insert(history_t* h, uint32_t now_s, history_sample_t sample) {
+    if (h->raw_count > 0) {
+        if (now_s < h->raw_last_s) return;
+        if (now_s == h->raw_last_s) {
+            // 同一秒重复写入：覆盖最新样本（汇总中保留首个，误差可忽略）
+            h->raw[(h->raw_head + HISTORY_RAW_LEN - 1) % HISTORY_RAW_LEN] = sample;
+            return;
+        }
+        uint32_t gap = now_s - h->raw_last_s - 1;
+        if (gap < HISTORY_HOLD_S) {
+            // 采样周期长于 1 秒：跳过的每一秒按上一个样本保持，同样计入汇总以保持时间加权
+            history_sample_t held = h->raw[(h->raw_head + HISTORY_RAW_LEN - 1) % HISTORY_RAW_LEN];
+            for (uint32_t t = h->raw_last_s + 1; t < now_s; t++) raw_push(h, t, held);
+        } else {
+            if (gap > HISTORY_RAW_LEN) gap = HISTORY_RAW_LEN;
+            history_sample_t empty = { HISTORY_INVALID, 0, 0 };
+            while (gap--) {
+                h->raw[h->raw_head] = empty;
+                h->raw_head = (h->raw_head + 1) % HISTORY_RAW_LEN;
+                if (h->raw_count < HISTORY_RAW_LEN) h->raw_count++;
+            }
+        }
+    }
+    raw_push(h, now_s, sample);
+}
+
+// ---------------------------------------------------------------------------
+// 查询
+
+// 查询视图：统一原始样本和汇总桶的按序访问（0 为最旧）
+typedef struct {
+    const history_t* h;
+    const history_level_t* level;   // NULL 表示原始样本
+    history_field_t field;
+    uint32_t count;
+    uint32_t newest_s;              // 最新一项的时间
+    uint32_t period_s;
+} history_view_t;
+
+static bool view_get(const history_view_t* v, uint32_t i, history_point_t* p) {
+    uint32_t newest_i = v->count - 1;
+    p->ago_s = (v->h->raw_last_s - v->newest_s) + (newest_i - i) * v->period_s;
+    if (!v->level) {
+        const history_sample_t* s = &v->h->raw[(v->h->raw_head + HISTORY_RAW_LEN - v->count + i) % HISTORY_RAW_LEN];
+        // 与汇总桶一致：温度无效的样本整体视为缺失
+        if (s->temp_centi == HISTORY_INVALID) return false;
+        int16_t value = v->field == HISTORY_FIELD_TEMP ? s->temp_centi
+                      : v->field == HISTORY_FIELD_FAN ? s->fan : s->tec;
+        p->value = p->min = p->max = value;
+        return true;
+    }
+    const history_level_t* l = v->level;
+    const history_bucket_t* b = &l->slots[(l->head + l->len - v->count + i) % l->len];
+    if (b->temp_avg == HISTORY_INVALID) return false;
+    if (v->field == HISTORY_FIELD_TEMP) {
+        p->value = b->temp_avg;
+        p->min = b->temp_min;
+        p->max = b->temp_max;
+    } else {
+        p->value = p->min = p->max = v->field == HISTORY_FIELD_FAN ? b->fan : b->tec;
+    }
+    return true;
+}
+
+/**
+ * @brief 选择能覆盖起点的最细分辨率
+ */
+static void view_select(const history_t* h, uint32_t from_ago_s, history_field_t field, history_view_t* v) {
+    memset(v, 0, sizeof(*v));
+    v->h = h;
+    v->field = field;
+    v->count = h->raw_count;
+    v->newest_s = h->raw_last_s;
+    v->period_s = 1;
+    if (h->raw_count == 0 || from_ago_s < h->raw_count) return;
+
+    const history_level_t* levels[] = { &h->l1, &h->l2 };
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+        const history_level_t* l = levels[i];
+        if (l->count == 0) break;
+        v->level = l;
+        v->count = l->count;
+        v->newest_s = l->last_index * l->period_s;
+        v->period_s = l->period_s;
+        uint32_t span = (h->raw_last_s - v->newest_s) + (l->count - 1) * l->period_s;
+        if (from_ago_s <= span) break;
+    }
+}
+
+/**
+ * @brief 时间（距最新秒数）转换为视图序号，结果夹在 [0, count-1]
+ */
+static uint32_t view_index(const history_view_t* v, uint32_t ago_s) {
+    uint32_t offset = v->h->raw_last_s - v->newest_s;
+    uint32_t back = ago_s > offset ? (ago_s - offset + v->period_s - 1) / v->period_s : 0;
+    return back >= v->count ? 0 : v->count - 1 - back;
+}
+
+static int64_t triangle_area2(const history_point_t* a, const history_point_t* b, int64_t cx_ago, int64_t cy) {
+    // 时间轴用 ago（向过去增大），面积只比较大小，符号无关
+    int64_t area = ((int64_t)a->ago_s - cx_ago) * ((int64_t)b->value - a->value) -
+                   ((int64_t)a->ago_s - b->ago_s) * (cy - a->value);
+    return area < 0 ? -area : area;
+}
+
+size_t history_query(const history_t* h, uint32_t from_ago_s, uint32_t to_ago_s, history_field_t field,
+                     size_t max_points, history_point_t* out, uint32_t* resolution_s) {
+    if (max_points > HISTORY_MAX_POINTS) max_points = HISTORY_MAX_POINTS;
+    if (max_points < 3) max_points = 3;
+    if (from_ago_s < to_ago_s) {
+        uint32_t t = from_ago_s;
+        from_ago_s = to_ago_s;
+        to_ago_s = t;
+    }
+
+    history_view_t v;
+    view_select(h, from_ago_s, field, &v);
+    if (resolution_s) *resolution_s = v.period_s;
+    if (v.count == 0) return 0;
+
+    uint32_t first = view_index(&v, from_ago_s);
+    uint32_t last = view_index(&v, to_ago_s);
+    uint32_t n = last - first + 1;
+    size_t out_count = 0;
+    history_point_t p;
+
+    if (n <= max_points) {
+        for (uint32_t i = first; i <= last; i++) {
+            if (view_get(&v, i, &p)) out[out_count++] = p;
+        }
+        return out_count;
+    }
+
+    // Largest-Triangle-Three-Buckets：首尾保留，中间每桶选与前一选中点、下一桶均值构成最大三角形的点
+    history_point_t prev;
+    bool have_prev = view_get(&v, first, &prev);
+    if (have_prev) out[out_count++] = prev;
+
+    uint32_t buckets = (uint32_t)max_points - 2;
+    uint32_t inner = n - 2;
+    for (uint32_t b = 0; b < buckets; b++) {
+        uint32_t start = first + 1 + (uint32_t)((uint64_t)b * inner / buckets);
+        uint32_t end = first + 1 + (uint32_t)((uint64_t)(b + 1) * inner / buckets);
+        uint32_t next_end = first + 1 + (uint32_t)((uint64_t)(b + 2) * inner / buckets);
+        if (next_end > last + 1) next_end = last + 1;
+
+        // 下一桶的均值（最后一桶用末点）
+        int64_t sum_ago = 0;
+        int64_t sum_val = 0;
+        uint32_t cnt = 0;
+        for (uint32_t i = end; i < next_end; i++) {
+            if (view_get(&v, i, &p)) {
+                sum_ago += p.ago_s;
+                sum_val += p.value;
+                cnt++;
+            }
+        }
+        if (cnt == 0 && view_get(&v, last, &p)) {
+            sum_ago = p.ago_s;
+            sum_val = p.value;
+            cnt = 1;
+        }
+
+        history_point_t best;
+        int64_t best_area = -1;
+        for (uint32_t i = start; i < end; i++) {
+            if (!view_get(&v, i, &p)) continue;
+            int64_t area = (have_prev && cnt > 0)
+                ? triangle_area2(&prev, &p, sum_ago / cnt, sum_val / cnt) : 0;
+            if (area > best_area) {
+                best_area = area;
+                best = p;
+            }
+        }
+        if (best_area >= 0) {
+            out[out_count++] = best;
+            prev = best;
+            have_prev = true;
+        }
+    }
+
+    if (view_get(&v, last, &p)) out[out_count++] = p;
+    return out_count;
+}
+
+bool history_field_from_name(const char* name, history_field_t* field) {
+    for (size_t i = 0; i < sizeof(s_field_names) / sizeof(s_field_names[0]); i++) {
+        if (strcmp(name, s_field_names[i]) == 0) {
+            *field = (history_field_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+int history_format_json(const char* id, history_field_t field, uint32_t now_s, uint32_t resolution_s,
+                        const history_point_t* points, size_t count, char* buf, size_t size) {
+    size_t pos = 0;
+    int n = snprintf(buf, size, "{\"id\":\"%s\",\"field\":\"%s\",\"res_s\":%u,\"now_s\":%u,\"p\":[",
+                     id ? id : "", s_field_names[field], (unsigned)resolution_s, (unsigned)now_s);
+    if (n < 0 || (size_t)n >= size) return -1;
+    pos = n;
+
+    bool envelope = resolution_s > 1 && field == HISTORY_FIELD_TEMP;
+    for (size_t i = 0; i < count; i++) {
+        const history_point_t* p = &points[i];
+        n = envelope
+            ? snprintf(buf + pos, size - pos, "%s[%u,%d,%d,%d]", i ? "," : "",
+                       (unsigned)p->ago_s, p->value, p->min, p->max)
+            : snprintf(buf + pos, size - pos, "%s[%u,%d]", i ? "," : "", (unsigned)p->ago_s, p->value);
+        if (n < 0 || (size_t)n >= size - pos) return -1;
+        pos += n;
+    }
+    n = snprintf(buf + pos, size - pos, "]}");
+    if (n < 0 || (size_t)n >= size - pos) return -1;
+    return (int)(pos + n);
+}
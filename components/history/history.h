@@ -0,0 +1,122 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 运行历史：1Hz 原始样本环形缓冲 + 两级 min/max/avg 汇总
+ *        所有存储在编译期确定（约 26KB），查询时按 LTTB 降采样
+ *        纯C实现，不依赖ESP-IDF；调用方负责加锁
+ */
+
+#define HISTORY_RAW_LEN         3600    // 1 秒分辨率，1 小时
+#define HISTORY_L1_PERIOD_S     60
+#define HISTORY_L1_LEN          720     // 1 分钟分辨率，12 小时
+#define HISTORY_L2_PERIOD_S     900
+#define HISTORY_L2_LEN          672     // 15 分钟分辨率，7 天
+#define HISTORY_MAX_POINTS      200     // 单次查询返回的最大点数
+
+#define HISTORY_HOLD_S          10      // 短于此的间隙按上一个样本保持（采样周期可长于 1 秒）
+#define HISTORY_INVALID         INT16_MIN   // 缺失样本（传感器无效或时间间隙）
+
+typedef enum {
+    HISTORY_FIELD_TEMP = 0,     // 温度（0.01°C）
+    HISTORY_FIELD_FAN,          // 风扇占空比（%）
+    HISTORY_FIELD_TEC,          // 制冷片占空比（%）
+} history_field_t;
+
+typedef struct {
+    int16_t temp_centi;         // HISTORY_INVALID 表示无效
+    uint8_t fan;
+    uint8_t tec;
+} history_sample_t;
+
+// 汇总桶：温度保留极值，占空比只保留均值
+typedef struct {
+    int16_t temp_min;
+    int16_t temp_max;
+    int16_t temp_avg;           // HISTORY_INVALID 表示桶内没有有效温度
+    uint8_t fan;
+    uint8_t tec;
+} history_bucket_t;
+
+// 汇总累加器（当前未完成的桶）
+typedef struct {
+    uint32_t index;             // 桶序号 = 时间 / 周期
+    int32_t temp_sum;
+    uint32_t temp_count;
+    int16_t temp_min;
+    int16_t temp_max;
+    uint32_t fan_sum;
+    uint32_t tec_sum;
+    uint32_t count;
+} history_acc_t;
+
+typedef struct {
+    history_bucket_t* slots;
+    uint16_t len;
+    uint16_t period_s;
+    uint16_t head;              // 下一个写入位置
+    uint16_t count;
+    uint32_t last_index;        // 最新一个桶的序号
+    history_acc_t acc;
+} history_level_t;
+
+typedef struct {
+    history_sample_t raw[HISTORY_RAW_LEN];
+    uint16_t raw_head;
+    uint16_t raw_count;
+    uint32_t raw_last_s;        // 最新样本的时间（秒）
+    history_bucket_t l1_slots[HISTORY_L1_LEN];
+    history_bucket_t l2_slots[HISTORY_L2_LEN];
+    history_level_t l1;
+    history_level_t l2;
+} history_t;
+
+// 查询结果中的一个点
+typedef struct {
+    uint32_t ago_s;             // 距最新样本的秒数
+    int16_t value;              // 均值（原始分辨率下即样本值）
+    int16_t min;                // 温度的桶内极值，其他字段与 value 相同
+    int16_t max;
+} history_point_t;
+
+void history_init(history_t* h);
+
+/**
+ * @brief 写入一个样本
+ * @param now_s 单调时间（秒），与上次相同则覆盖；跳过不足 HISTORY_HOLD_S 秒时逐秒重复上一个样本
+ *              （两次采样之间估计值和输出不变），更长的间隙以无效样本填充
+ */
+void history_insert(history_t* h, uint32_t now_s, history_sample_t sample);
+
+/**
+ * @brief 查询时间范围并 LTTB 降采样
+ *        自动选择能覆盖起点的最细分辨率
+ * @param from_ago_s 起点：距最新样本的秒数
+ * @param to_ago_s 终点：距最新样本的秒数（0 表示最新）
+ * @param max_points 最多返回的点数（3 ~ HISTORY_MAX_POINTS）
+ * @param out 输出缓冲，至少 max_points 个
+ * @param resolution_s 输出：所用数据的分辨率（秒）
+ * @return 实际输出点数
+ */
+size_t history_query(const history_t* h, uint32_t from_ago_s, uint32_t to_ago_s, history_field_t field,
+                     size_t max_points, history_point_t* out, uint32_t* resolution_s);
+
+/**
+ * @brief 字段名转换（"temp"/"fan"/"tec"）
+ * @return false 未知字段
+ */
+bool history_field_from_name(const char* name, history_field_t* field);
+
+/**
+ * @brief 序列化查询结果为紧凑 JSON
+ *        {"id":..,"field":..,"res_s":..,"now_s":..,"p":[[ago,v],..]}，汇总分辨率下为 [ago,v,min,max]
+ * @return 写入长度，缓冲不足时返回 -1
+ */
+int history_format_json(const char* id, history_field_t field, uint32_t now_s, uint32_t resolution_s,
+                        const history_point_t* points, size_t count, char* buf, size_t size);
+
+#endif // HISTORY_H
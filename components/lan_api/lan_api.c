@@ -0,0 +1,372 @@
+#include "lan_api.h"
+#include "esp_log.h"
+#include "metrics.h"
+#include "lan_auth.h"
+#include "wifi_provision.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <stdatomic.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+static const char* TAG = "LAN_API";
+
+#define LAN_API_MAX_CLIENTS   10    // 受 CONFIG_LWIP_MAX_SOCKETS 限制
+#define LAN_API_BODY_MAX      256
+#define LAN_API_CONFIG_MAX    3072  // 配置可带 broker 列表和 PEM 证书（转义后约 2.1 KB）
+#define LAN_API_FRAME_MAX     128
+#define LAN_API_ACK_MAX       160
+
+// 状态字段掩码，用于生成增量
+#define FIELD_TEMP    (1 << 0)
+#define FIELD_SPEED   (1 << 1)
+#define FIELD_COOLER  (1 << 2)
+#define FIELD_MODE    (1 << 3)
+#define FIELD_ALL     (FIELD_TEMP | FIELD_SPEED | FIELD_COOLER | FIELD_MODE)
+
+static httpd_handle_t s_server = NULL;
+static mqtt_command_callback_t command_callback = NULL;
+static mqtt_config_callback_t config_callback = NULL;
+static char s_token[LAN_AUTH_TOKEN_MAX + 1];    // 写接口令牌，空串表示写接口关闭（启动时读取，之后只读）
+
+// 控制任务写入的最新状态，由自旋锁保护
+static lan_state_t s_latest;
+static mqtt_config_t s_config;
+static portMUX_TYPE s_state_mux = portMUX_INITIALIZER_UNLOCKED;
+static atomic_bool s_broadcast_pending = false;
+
+// 以下变量只在 HTTP 服务任务中访问（通过 httpd_queue_work 串行化）
+static lan_state_t s_sent;                      // 最近一次推送的状态
+static uint32_t s_version = 0;                  // 状态版本号，每次推送增量加一
+static char s_delta_frame[LAN_API_FRAME_MAX];   // 所有客户端共享的增量帧
+static char s_full_frame[LAN_API_FRAME_MAX];    // 新客户端共享的完整状态帧
+static uint32_t s_full_version = UINT32_MAX;    // s_full_frame 对应的版本
+
+/**
+ * @brief 按字段掩码序列化状态
+ * @return 长度，缓冲不足返回 -1（snprintf 截断后再用返回值做偏移会越界）
+ */
+static int format_state(char* buf, size_t size, const lan_state_t* st, uint32_t version, int fields) {
+    int n = snprintf(buf, size, "{\"v\":%lu", (unsigned long)version);
+    if ((fields & FIELD_TEMP) && n > 0 && (size_t)n < size) {
+        n += snprintf(buf + n, size - n, ",\"temp\":%.2f", st->temperature);
+    }
+    if ((fields & FIELD_SPEED) && n > 0 && (size_t)n < size) {
+        n += snprintf(buf + n, size - n, ",\"speed\":%u", st->fan_speed);
+    }
+    if ((fields & FIELD_COOLER) && n > 0 && (size_t)n < size) {
+        n += snprintf(buf + n, size - n, ",\"cooler\":%u", st->cooler_power);
+    }
+    if ((fields & FIELD_MODE) && n > 0 && (size_t)n < size) {
+        n += snprintf(buf + n, size - n, ",\"mode\":\"%s\"", st->auto_mode ? "auto" : "manual");
+    }
+    if (n > 0 && (size_t)n < size) {
+        n += snprintf(buf + n, size - n, "}");
+    }
+    if (n <= 0 || (size_t)n >= size) {
+        buf[0] = '\0';
+        return -1;
+    }
+    return n;
+}
+
+static int diff_fields(const lan_state_t* a, const lan_state_t* b) {
+    int fields = 0;
+    // 温度按0.01°C比较，DS18B20分辨率为0.0625°C
+    if (lroundf(a->temperature * 100) != lroundf(b->temperature * 100)) fields |= FIELD_TEMP;
+    if (a->fan_speed != b->fan_speed)       fields |= FIELD_SPEED;
+    if (a->cooler_power != b->cooler_power) fields |= FIELD_COOLER;
+    if (a->auto_mode != b->auto_mode)       fields |= FIELD_MODE;
+    return fields;
+}
+
+static esp_err_t ws_send_text(int fd, const char* text, size_t len) {
+    httpd_ws_frame_t frame = {
+        .final   = true,
+        .type    = HTTPD_WS_TYPE_TEXT,
+        .payload = (uint8_t*)text,
+        .len     = len,
+    };
+    return httpd_ws_send_frame_async(s_server, fd, &frame);
+}
+
+/**
+ * @brief 发送完整状态；同一版本的完整帧只序列化一次
+ */
+static void send_full_work(void* arg) {
+    int fd = (int)(intptr_t)arg;
+    if (s_full_version != s_version) {
+        format_state(s_full_frame, sizeof(s_full_frame), &s_sent, s_version, FIELD_ALL);
+        s_full_version = s_version;
+    }
+    ws_send_text(fd, s_full_frame, strlen(s_full_frame));
+}
+
+/**
+ * @brief 计算增量并广播：每次变化只序列化一次，所有客户端共享同一帧
+ */
+static void broadcast_work(void* arg) {
+    // 先清标志，保证处理期间到来的新状态会重新排队
+    atomic_store(&s_broadcast_pending, false);
+
+    lan_state_t cur;
+    portENTER_CRITICAL(&s_state_mux);
+    cur = s_latest;
+    portEXIT_CRITICAL(&s_state_mux);
+
+    int fields = diff_fields(&cur, &s_sent);
+    if (fields == 0) return;
+
+    s_sent = cur;
+    s_version++;
+    int len = format_state(s_delta_frame, sizeof(s_delta_frame), &cur, s_version, fields);
+    if (len < 0) return;
+
+    size_t count = LAN_API_MAX_CLIENTS;
+    int fds[LAN_API_MAX_CLIENTS];
+    if (httpd_get_client_list(s_server, &count, fds) != ESP_OK) return;
+    for (size_t i = 0; i < count; i++) {
+        if (httpd_ws_get_fd_info(s_server, fds[i]) == HTTPD_WS_CLIENT_WEBSOCKET) {
+            ws_send_text(fds[i], s_delta_frame, len);
+        }
+    }
+}
+
+/**
+ * @brief 读取完整请求体（有长度上限）
+ * @return 读取的字节数，失败返回-1
+ */
+static int read_body(httpd_req_t *req, char* buf, size_t size) {
+    if (req->content_len == 0 || req->content_len >= size) {
+        ESP_LOGW(TAG, "请求体长度无效: %u（上限 %u）", (unsigned)req->content_len, (unsigned)size - 1);
+        return -1;
+    }
+    int received = 0;
+    while (received < req->content_len) {
+        int ret = httpd_req_recv(req, buf + received, req->content_len - received);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) continue;
+        if (ret <= 0) return -1;
+        received += ret;
+    }
+    buf[received] = '\0';
+    return received;
+}
+
+/**
+ * @brief 写接口鉴权，失败时已发送 401/403
+ */
+static bool authorize_write(httpd_req_t *req) {
+    if (!s_token[0]) {
+        httpd_resp_send_err(req, HTTPD_403_FORBIDDEN, "Write API disabled: set an API token during provisioning");
+        return false;
+    }
+    char hdr[LAN_AUTH_HEADER_MAX];
+    if (httpd_req_get_hdr_value_str(req, "Authorization", hdr, sizeof(hdr)) == ESP_OK &&
+        lan_auth_check_bearer(hdr, s_token)) {
+        return true;
+    }
+    ESP_LOGW(TAG, "未授权的写请求: %s", req->uri);
+    httpd_resp_set_hdr(req, "WWW-Authenticate", "Bearer");
+    httpd_resp_send_err(req, HTTPD_401_UNAUTHORIZED, "Unauthorized");
+    return false;
+}
+
+/**
+ * @brief WebSocket 握手鉴权：Authorization 请求头或 ?token= 查询参数
+ */
+static bool authorize_ws(httpd_req_t *req) {
+    char buf[LAN_AUTH_HEADER_MAX * 3];      // 查询参数可能整体百分号编码
+    if (httpd_req_get_hdr_value_str(req, "Authorization", buf, sizeof(buf)) == ESP_OK &&
+        lan_auth_check_bearer(buf, s_token)) {
+        return true;
+    }
+    return httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK &&
+           lan_auth_check_query(buf, strlen(buf), s_token);
+}
+
+static esp_err_t send_json(httpd_req_t *req, const char* json) {
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_sendstr(req, json);
+}
+
+static esp_err_t state_get_handler(httpd_req_t *req) {
+    lan_state_t cur;
+    portENTER_CRITICAL(&s_state_mux);
+    cur = s_latest;
+    portEXIT_CRITICAL(&s_state_mux);
+
+    char buf[LAN_API_FRAME_MAX];
+    format_state(buf, sizeof(buf), &cur, s_version, FIELD_ALL);
+    return send_json(req, buf);
+}
+
+static esp_err_t config_get_handler(httpd_req_t *req) {
+    mqtt_config_t cfg;
+    portENTER_CRITICAL(&s_state_mux);
+    cfg = s_config;
+    portEXIT_CRITICAL(&s_state_mux);
+
+    char buf[LAN_API_FRAME_MAX];
+    snprintf(buf, sizeof(buf), "{\"temp_threshold\":%.1f,\"max_speed\":%u}",
+             cfg.temp_threshold, cfg.max_speed);
+    return send_json(req, buf);
+}
+
+static esp_err_t config_post_handler(httpd_req_t *req) {
+    if (!authorize_write(req)) return ESP_FAIL;
+    // httpd 单任务顺序处理请求，静态缓冲不会被并发使用，也不占 httpd 任务栈
+    static char body[LAN_API_CONFIG_MAX];
+    int len = read_body(req, body, sizeof(body));
+    mqtt_config_t cfg;
+    if (len < 0 || !mqtt_comm_parse_config(body, len, &cfg)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid config");
+        return ESP_FAIL;
+    }
+    if (config_callback) {
+        config_callback(&cfg);
+    }
+    return config_get_handler(req);
+}
+
+static esp_err_t command_post_handler(httpd_req_t *req) {
+    if (!authorize_write(req)) return ESP_FAIL;
+    char body[LAN_API_BODY_MAX];
+    int len = read_body(req, body, sizeof(body));
+    int64_t rx_us = esp_timer_get_time();
+    mqtt_command_t cmd;
+    if (len < 0 || !mqtt_comm_parse_command(body, len, &cmd)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid command");
+        return ESP_FAIL;
+    }
+    cmd.rx_us = rx_us;
+    mqtt_command_ack_t ack = { .result = MQTT_ACK_OK };
+    if (command_callback) {
+        command_callback(&cmd, &ack);
+    }
+    // 响应即回执，格式与 MQTT <id>/command/ack 相同
+    char json[LAN_API_ACK_MAX];
+    int ack_len = mqtt_comm_format_ack(&cmd, &ack, esp_timer_get_time(), json, sizeof(json));
+    return send_json(req, ack_len > 0 ? json : "{\"ok\":true}");
+}
+
+static int metrics_chunk_writer(void* ctx, const char* data, size_t len) {
+    return httpd_resp_send_chunk((httpd_req_t*)ctx, data, len) == ESP_OK ? 0 : -1;
+}
+
+/**
+ * @brief Prometheus 文本格式导出，逐行分块发送，不在内存中拼接整个响应
+ */
+static esp_err_t metrics_get_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+    if (metrics_write_prometheus(metrics_chunk_writer, req) != 0) {
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * @brief WebSocket 处理：握手后推送完整状态，文本帧按命令处理
+ *        设置了令牌时握手必须带令牌，否则断开；未设置令牌时只推送状态，不接受命令
+ */
+static esp_err_t ws_handler(httpd_req_t *req) {
+    if (req->method == HTTP_GET) {
+        // httpd 在调用处理函数前已完成握手，返回失败即关闭该连接
+        if (s_token[0] && !authorize_ws(req)) {
+            ESP_LOGW(TAG, "WebSocket 鉴权失败: fd=%d", httpd_req_to_sockfd(req));
+            return ESP_FAIL;
+        }
+        ESP_LOGI(TAG, "WebSocket 客户端连接: fd=%d", httpd_req_to_sockfd(req));
+        return httpd_queue_work(s_server, send_full_work, (void*)(intptr_t)httpd_req_to_sockfd(req));
+    }
+
+    uint8_t buf[LAN_API_BODY_MAX];
+    httpd_ws_frame_t frame = { .payload = buf };
+    esp_err_t ret = httpd_ws_recv_frame(req, &frame, 0);
+    if (ret != ESP_OK) return ret;
+    if (frame.len >= sizeof(buf)) {
+        ESP_LOGW(TAG, "WebSocket 帧过长: %d", (int)frame.len);
+        return ESP_FAIL;
+    }
+    ret = httpd_ws_recv_frame(req, &frame, frame.len);
+    if (ret != ESP_OK) return ret;
+
+    mqtt_command_t cmd;
+    // 设置了令牌时所有 WebSocket 连接都已在握手时鉴权
+    if (frame.type == HTTPD_WS_TYPE_TEXT && s_token[0] &&
+        mqtt_comm_parse_command((const char*)buf, frame.len, &cmd) && command_callback) {
+        // 结果随下一次状态推送体现，WebSocket 不单独回执
+        cmd.rx_us = esp_timer_get_time();
+        mqtt_command_ack_t ack = { .result = MQTT_ACK_OK };
+        command_callback(&cmd, &ack);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 启动局域网 HTTP 服务
+ */
+void lan_api_start(void) {
+    if (s_server) return;
+
+    if (!wifi_prov_get_api_token(s_token, sizeof(s_token))) {
+        ESP_LOGW(TAG, "未设置接口令牌，局域网写接口关闭（重新配网时可设置）");
+    }
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = 80;
+    config.max_open_sockets = LAN_API_MAX_CLIENTS;
+    config.max_uri_handlers = 16;
+    config.lru_purge_enable = true;
+    config.core_id = 0;     // 与 WiFi/LwIP 同在 PRO_CPU，APP_CPU 留给控制任务
+
+    if (httpd_start(&s_server, &config) != ESP_OK) {
+        ESP_LOGE(TAG, "HTTP 服务启动失败");
+        s_server = NULL;
+        return;
+    }
+
+    const httpd_uri_t uris[] = {
+        { .uri = "/api/state",   .method = HTTP_GET,  .handler = state_get_handler },
+        { .uri = "/api/config",  .method = HTTP_GET,  .handler = config_get_handler },
+        { .uri = "/api/config",  .method = HTTP_POST, .handler = config_post_handler },
+        { .uri = "/api/command", .method = HTTP_POST, .handler = command_post_handler },
+        { .uri = "/metrics",     .method = HTTP_GET,  .handler = metrics_get_handler },
+        { .uri = "/ws",          .method = HTTP_GET,  .handler = ws_handler, .is_websocket = true },
+    };
+    for (size_t i = 0; i < sizeof(uris) / sizeof(uris[0]); i++) {
+        httpd_register_uri_handler(s_server, &uris[i]);
+    }
+    ESP_LOGI(TAG, "局域网 HTTP 服务启动，端口 80");
+}
+
+void lan_api_update_state(const lan_state_t* state) {
+    portENTER_CRITICAL(&s_state_mux);
+    s_latest = *state;
+    portEXIT_CRITICAL(&s_state_mux);
+
+    // 合并多次更新：已有待处理的广播时不再重复排队
+    if (s_server && !atomic_exchange(&s_broadcast_pending, true)) {
+        if (httpd_queue_work(s_server, broadcast_work, NULL) != ESP_OK) {
+            atomic_store(&s_broadcast_pending, false);
+        }
+    }
+}
+
+void lan_api_update_config(const mqtt_config_t* cfg) {
+    portENTER_CRITICAL(&s_state_mux);
+    s_config = *cfg;
+    portEXIT_CRITICAL(&s_state_mux);
+}
+
+void lan_api_set_command_callback(mqtt_command_callback_t callback) {
+    command_callback = callback;
+}
+
+void lan_api_set_config_callback(mqtt_config_callback_t callback) {
+    config_callback = callback;
+}
+
+httpd_handle_t lan_api_get_server(void) {
+    return s_server;
+}
@@ -0,0 +1,57 @@
+#ifndef LAN_API_H
+#define LAN_API_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_http_server.h"
+#include "mqtt_comm.h"
+
+// 局域网推送的设备状态
+typedef struct {
+    float temperature;      // 当前温度（摄氏度）
+    uint8_t fan_speed;      // 风扇转速百分比
+    uint8_t cooler_power;   // 制冷片功率百分比
+    bool auto_mode;         // true=自动模式
+} lan_state_t;
+
+/**
+ * @brief 在 Station 模式下启动局域网 HTTP 服务（重复调用无副作用）
+ *        GET  /api/state   当前状态
+ *        GET  /api/config  当前配置
+ *        POST /api/config  修改配置（与 MQTT config 主题格式相同）
+ *        POST /api/command 下发命令（与 MQTT command 主题格式相同），响应为命令回执
+ *        GET  /metrics     Prometheus 文本格式指标
+ *        GET  /ws          WebSocket，连接后推送完整状态，之后仅推送变化字段
+ *        写操作（两个 POST 与 WebSocket 命令）需要配网时设置的令牌，见 lan_auth.h；未设置令牌时关闭
+ */
+void lan_api_start(void);
+
+/**
+ * @brief 更新设备状态；有变化时序列化一次并推送给全部 WebSocket 客户端
+ * @param state 最新状态
+ */
+void lan_api_update_state(const lan_state_t* state);
+
+/**
+ * @brief 更新 GET /api/config 返回的配置
+ * @param cfg 当前生效的配置
+ */
+void lan_api_update_config(const mqtt_config_t* cfg);
+
+/**
+ * @brief 设置命令回调（通常与 MQTT 命令回调相同）
+ */
+void lan_api_set_command_callback(mqtt_command_callback_t callback);
+
+/**
+ * @brief 设置配置回调（通常与 MQTT 配置回调相同）
+ */
+void lan_api_set_config_callback(mqtt_config_callback_t callback);
+
+/**
+ * @brief 获取 HTTP 服务句柄，供其他组件注册额外 URI
+ * @return 服务句柄，未启动时为 NULL
+ */
+httpd_handle_t lan_api_get_server(void);
+
+#endif // LAN_API_H
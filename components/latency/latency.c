@@ -0,0 +1,115 @@
+#include "latency.h"
+
+#if LATENCY_PROFILE_ENABLE
+
+#include <stdio.h>
+#include <string.h>
+
+// 已记录过的阶段链表，首次记录时用 CAS 插入
+static _Atomic(latency_stage_t*) s_head = NULL;
+
+static void latency_register(latency_stage_t* stage) {
+    bool expected = false;
+    if (!__atomic_compare_exchange_n(&stage->registered, &expected, true, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    latency_stage_t* head = atomic_load(&s_head);
+    do {
+        stage->next = head;
+    } while (!atomic_compare_exchange_weak(&s_head, &head, stage));
+}
+
+/**
+ * @brief 值到桶序号：小于 4 直接映射，否则为 (量级, 次高 2 位)
+ */
+static uint32_t bucket_index(uint32_t us) {
+    if (us < (1u << LATENCY_SUB_BITS)) return us;
+    uint32_t msb = 31 - __builtin_clz(us);
+    uint32_t shift = msb - LATENCY_SUB_BITS;
+    uint32_t index = (shift + 1) * (1u << LATENCY_SUB_BITS) + ((us >> shift) & ((1u << LATENCY_SUB_BITS) - 1));
+    return index < LATENCY_BUCKETS ? index : LATENCY_BUCKETS - 1;
+}
+
+/**
+ * @brief 桶序号到该桶上界
+ */
+static uint32_t bucket_upper(uint32_t index) {
+    const uint32_t sub = 1u << LATENCY_SUB_BITS;
+    if (index < sub) return index;
+    uint32_t shift = index / sub - 1;
+    uint32_t lower = (sub + index % sub) << shift;
+    return lower + (1u << shift) - 1;
+}
+
+void latency_record(latency_stage_t* stage, uint32_t us) {
+    if (!stage->registered) {
+        latency_register(stage);
+    }
+    atomic_fetch_add_explicit(&stage->buckets[bucket_index(us)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stage->count, 1, memory_order_relaxed);
+    uint32_t prev = atomic_load_explicit(&stage->max_us, memory_order_relaxed);
+    while (us > prev &&
+           !atomic_compare_exchange_weak_explicit(&stage->max_us, &prev, us,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+static uint32_t quantile(const uint32_t* buckets, uint32_t total, uint32_t permille) {
+    // 第 ceil(total·q) 个观测所在的桶
+    uint32_t rank = (uint32_t)(((uint64_t)total * permille + 999) / 1000);
+    uint32_t seen = 0;
+    for (uint32_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank && seen > 0) return bucket_upper(i);
+    }
+    return 0;
+}
+
+void latency_summarize(latency_stage_t* stage, latency_summary_t* out) {
+    // 逐桶快照；与并发记录之间的微小偏差可接受
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < LATENCY_BUCKETS; i++) {
+        buckets[i] = atomic_load_explicit(&stage->buckets[i], memory_order_relaxed);
+        total += buckets[i];
+    }
+    out->count = total;
+    out->p50_us = quantile(buckets, total, 500);
+    out->p99_us = quantile(buckets, total, 990);
+    out->max_us = atomic_load_explicit(&stage->max_us, memory_order_relaxed);
+}
+
+static void latency_reset(latency_stage_t* stage) {
+    for (uint32_t i = 0; i < LATENCY_BUCKETS; i++) {
+        atomic_store_explicit(&stage->buckets[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&stage->count, 0, memory_order_relaxed);
+    atomic_store_explicit(&stage->max_us, 0, memory_order_relaxed);
+}
+
+int latency_write_json(char* buf, size_t size, bool reset) {
+    size_t n = 0;
+    int len = snprintf(buf, size, "{");
+    if (len < 0 || (size_t)len >= size) return -1;
+    n += len;
+
+    for (latency_stage_t* s = atomic_load(&s_head); s; s = s->next) {
+        latency_summary_t sum;
+        latency_summarize(s, &sum);
+        len = snprintf(buf + n, size - n, "%s\"%s\":{\"n\":%lu,\"p50\":%lu,\"p99\":%lu,\"max\":%lu}",
+                       n > 1 ? "," : "", s->name, (unsigned long)sum.count,
+                       (unsigned long)sum.p50_us, (unsigned long)sum.p99_us, (unsigned long)sum.max_us);
+        if (len < 0 || (size_t)len >= size - n) return -1;
+        n += len;
+        if (reset) {
+            latency_reset(s);
+        }
+    }
+
+    len = snprintf(buf + n, size - n, "}");
+    if (len < 0 || (size_t)len >= size - n) return -1;
+    return (int)(n + len);
+}
+
+#endif // LATENCY_PROFILE_ENABLE
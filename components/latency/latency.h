@@ -0,0 +1,86 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 分阶段延迟剖析：对数刻度固定桶直方图，报告 p50/p99/max
+ *        每个二进制量级 4 个子桶，覆盖 1us ~ 16s，分位数相对误差不超过 12.5%
+ *        记录只用 32 位原子操作，可在任意任务中调用
+ *
+ *        LATENCY_PROFILE_ENABLE 为 0 时（在组件 CMakeLists 中以 PUBLIC 编译定义给出），
+ *        LATENCY_STAGE/LATENCY_START/LATENCY_STOP 展开为空，阶段变量和计时调用全部编译掉
+ */
+
+#ifndef LATENCY_PROFILE_ENABLE
+#define LATENCY_PROFILE_ENABLE 1
+#endif
+
+#define LATENCY_SUB_BITS    2
+#define LATENCY_BUCKETS     96      // (24 - LATENCY_SUB_BITS + 2) 个量级 × 4 子桶
+
+typedef struct latency_stage {
+    const char* name;
+    _Atomic uint32_t buckets[LATENCY_BUCKETS];
+    _Atomic uint32_t count;
+    _Atomic uint32_t max_us;
+    struct latency_stage* next;
+    bool registered;
+} latency_stage_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t p50_us;            // 所在桶上界
+    uint32_t p99_us;
+    uint32_t max_us;            // 精确值
+} latency_summary_t;
+
+#if LATENCY_PROFILE_ENABLE
+
+#include "esp_timer.h"
+
+// 定义阶段（文件作用域，首次记录时自动注册）
+#define LATENCY_STAGE(var, stage_name) \
+    static latency_stage_t var = { .name = stage_name }
+// 开始计时：声明局部时间戳
+#define LATENCY_START(ts)           int64_t ts = esp_timer_get_time()
+// 结束计时并记录
+#define LATENCY_STOP(stage, ts)     latency_record(&(stage), (uint32_t)(esp_timer_get_time() - (ts)))
+// 直接记录已测得的时长（如周期抖动）
+#define LATENCY_RECORD(stage, us)   latency_record(&(stage), (us))
+
+void latency_record(latency_stage_t* stage, uint32_t us);
+
+/**
+ * @brief 计算阶段摘要
+ */
+void latency_summarize(latency_stage_t* stage, latency_summary_t* out);
+
+/**
+ * @brief 以紧凑 JSON 导出全部已记录阶段
+ *        {"<stage>":{"n":..,"p50":..,"p99":..,"max":..},...}，单位微秒
+ * @param reset 导出后清零（用于按窗口统计）
+ * @return 写入长度，缓冲不足返回 -1
+ */
+int latency_write_json(char* buf, size_t size, bool reset);
+
+#else
+
+#include <stdio.h>
+
+#define LATENCY_STAGE(var, stage_name)
+#define LATENCY_START(ts)           do { } while (0)
+#define LATENCY_STOP(stage, ts)     do { } while (0)
+#define LATENCY_RECORD(stage, us)   do { } while (0)
+
+static inline int latency_write_json(char* buf, size_t size, bool reset) {
+    (void)reset;
+    return size > 2 ? snprintf(buf, size, "{}") : -1;
+}
+
+#endif // LATENCY_PROFILE_ENABLE
+
+#endif // LATENCY_H
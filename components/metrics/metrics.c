@@ -0,0 +1,120 @@
+#include "metrics.h"
+#include <stdio.h>
+#include <string.h>
+
+#define METRICS_LINE_MAX 160
+
+// 注册表链表头，注册时用 CAS 插入，无需加锁
+static _Atomic(metric_t*) s_head = NULL;
+
+void metrics_register(metric_t* m) {
+    bool expected = false;
+    // registered 标志只在初始化阶段写入，这里用原子交换防止并发重复注册
+    if (!__atomic_compare_exchange_n(&m->registered, &expected, true, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    metric_t* head = atomic_load(&s_head);
+    do {
+        m->next = head;
+    } while (!atomic_compare_exchange_weak(&s_head, &head, m));
+}
+
+void metrics_observe(metric_t* m, uint32_t value) {
+    uint8_t i = 0;
+    while (i < m->bucket_count && value > m->bounds[i]) {
+        i++;
+    }
+    atomic_fetch_add_explicit(&m->buckets[i], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&m->sum, value, memory_order_relaxed);
+}
+
+static int32_t metric_value(metric_t* m) {
+    if (m->read) {
+        atomic_store_explicit(&m->value, m->read(), memory_order_relaxed);
+    }
+    return atomic_load_explicit(&m->value, memory_order_relaxed);
+}
+
+static const char* type_name(metric_type_t type) {
+    switch (type) {
+        case METRIC_COUNTER:   return "counter";
+        case METRIC_GAUGE:     return "gauge";
+        case METRIC_HISTOGRAM: return "histogram";
+    }
+    return "untyped";
+}
+
+static int emit(metrics_write_fn_t write, void* ctx, char* line, int len) {
+    if (len < 0) return -1;
+    if (len >= METRICS_LINE_MAX) len = METRICS_LINE_MAX - 1;
+    return write(ctx, line, (size_t)len);
+}
+
+static int write_histogram(metric_t* m, metrics_write_fn_t write, void* ctx, char* line) {
+    // 各桶计数独立读取，导出期间的并发观测可能使 count 与 sum 略有偏差，可接受
+    uint32_t cumulative = 0;
+    int ret;
+    for (uint8_t i = 0; i <= m->bucket_count; i++) {
+        cumulative += atomic_load_explicit(&m->buckets[i], memory_order_relaxed);
+        int len;
+        if (i < m->bucket_count) {
+            len = snprintf(line, METRICS_LINE_MAX, "%s_bucket{le=\"%lu\"} %lu\n",
+                           m->name, (unsigned long)m->bounds[i], (unsigned long)cumulative);
+        } else {
+            len = snprintf(line, METRICS_LINE_MAX, "%s_bucket{le=\"+Inf\"} %lu\n",
+                           m->name, (unsigned long)cumulative);
+        }
+        if ((ret = emit(write, ctx, line, len)) != 0) return ret;
+    }
+    int len = snprintf(line, METRICS_LINE_MAX, "%s_sum %lu\n%s_count %lu\n",
+                       m->name, (unsigned long)atomic_load(&m->sum),
+                       m->name, (unsigned long)cumulative);
+    return emit(write, ctx, line, len);
+}
+
+int metrics_write_prometheus(metrics_write_fn_t write, void* ctx) {
+    char line[METRICS_LINE_MAX];
+    int ret;
+    for (metric_t* m = atomic_load(&s_head); m; m = m->next) {
+        int len = snprintf(line, METRICS_LINE_MAX, "# HELP %s %s\n# TYPE %s %s\n",
+                           m->name, m->help, m->name, type_name(m->type));
+        if ((ret = emit(write, ctx, line, len)) != 0) return ret;
+
+        if (m->type == METRIC_HISTOGRAM) {
+            ret = write_histogram(m, write, ctx, line);
+        } else {
+            len = snprintf(line, METRICS_LINE_MAX, "%s %ld\n", m->name, (long)metric_value(m));
+            ret = emit(write, ctx, line, len);
+        }
+        if (ret != 0) return ret;
+    }
+    return 0;
+}
+
+int metrics_write_json(char* buf, size_t size) {
+    size_t n = 0;
+    int len = snprintf(buf, size, "{");
+    if (len < 0 || (size_t)len >= size) return -1;
+    n += len;
+
+    for (metric_t* m = atomic_load(&s_head); m; m = m->next) {
+        const char* sep = (n > 1) ? "," : "";
+        if (m->type == METRIC_HISTOGRAM) {
+            uint32_t count = 0;
+            for (uint8_t i = 0; i <= m->bucket_count; i++) {
+                count += atomic_load_explicit(&m->buckets[i], memory_order_relaxed);
+            }
+            len = snprintf(buf + n, size - n, "%s\"%s_count\":%lu,\"%s_sum\":%lu", sep,
+                           m->name, (unsigned long)count, m->name, (unsigned long)atomic_load(&m->sum));
+        } else {
+            len = snprintf(buf + n, size - n, "%s\"%s\":%ld", sep, m->name, (long)metric_value(m));
+        }
+        if (len < 0 || (size_t)len >= size - n) return -1;
+        n += len;
+    }
+
+    len = snprintf(buf + n, size - n, "}");
+    if (len < 0 || (size_t)len >= size - n) return -1;
+    return (int)(n + len);
+}
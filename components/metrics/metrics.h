@@ -0,0 +1,94 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 轻量指标注册表：静态分配的计数器、仪表和直方图
+ *        更新只使用 32 位原子操作（ESP32 上无锁），可在热路径和任意任务中调用
+ *        纯C实现，不依赖ESP-IDF
+ */
+
+typedef enum {
+    METRIC_COUNTER,     // 单调递增计数
+    METRIC_GAUGE,       // 可增可减的瞬时值
+    METRIC_HISTOGRAM,   // 固定桶直方图
+} metric_type_t;
+
+typedef struct metric {
+    const char* name;                   // Prometheus 指标名
+    const char* help;                   // 说明文字
+    metric_type_t type;
+    _Atomic int32_t value;              // 计数器/仪表的值
+    int32_t (*read)(void);              // 仪表读取函数（导出时调用，可为 NULL）
+    const uint32_t* bounds;             // 直方图桶上界（升序）
+    _Atomic uint32_t* buckets;          // 直方图各桶计数，长度 bucket_count + 1（最后为 +Inf）
+    uint8_t bucket_count;
+    _Atomic uint32_t sum;               // 直方图观测值之和
+    struct metric* next;
+    bool registered;
+} metric_t;
+
+#define METRIC_COUNTER_DEFINE(var, metric_name, metric_help) \
+    metric_t var = { .name = metric_name, .help = metric_help, .type = METRIC_COUNTER }
+
+#define METRIC_GAUGE_DEFINE(var, metric_name, metric_help) \
+    metric_t var = { .name = metric_name, .help = metric_help, .type = METRIC_GAUGE }
+
+// 导出时调用 read_fn 取值的仪表（如空闲堆、栈高水位）
+#define METRIC_GAUGE_FN_DEFINE(var, metric_name, metric_help, read_fn) \
+    metric_t var = { .name = metric_name, .help = metric_help, .type = METRIC_GAUGE, .read = read_fn }
+
+// 直方图：可变参数为各桶上界（桶数组为文件作用域复合字面量，静态存储）
+#define METRIC_HISTOGRAM_DEFINE(var, metric_name, metric_help, ...) \
+    metric_t var = { .name = metric_name, .help = metric_help, .type = METRIC_HISTOGRAM, \
+                     .bounds = (const uint32_t[]){ __VA_ARGS__ }, \
+                     .buckets = (_Atomic uint32_t[METRIC_NARGS(__VA_ARGS__) + 1]){ 0 }, \
+                     .bucket_count = METRIC_NARGS(__VA_ARGS__) }
+
+#define METRIC_NARGS(...) (sizeof((uint32_t[]){ __VA_ARGS__ }) / sizeof(uint32_t))
+
+/**
+ * @brief 导出写回调，用于流式输出
+ * @return 0 成功，非0 中止导出
+ */
+typedef int (*metrics_write_fn_t)(void* ctx, const char* data, size_t len);
+
+/**
+ * @brief 注册指标（重复注册无副作用），通常在组件初始化时调用
+ */
+void metrics_register(metric_t* m);
+
+static inline void metrics_inc(metric_t* m) {
+    atomic_fetch_add_explicit(&m->value, 1, memory_order_relaxed);
+}
+
+static inline void metrics_add(metric_t* m, int32_t delta) {
+    atomic_fetch_add_explicit(&m->value, delta, memory_order_relaxed);
+}
+
+static inline void metrics_set(metric_t* m, int32_t value) {
+    atomic_store_explicit(&m->value, value, memory_order_relaxed);
+}
+
+/**
+ * @brief 记录一次直方图观测
+ */
+void metrics_observe(metric_t* m, uint32_t value);
+
+/**
+ * @brief 以 Prometheus 文本格式逐行流式导出全部指标
+ * @return 0 成功，否则为写回调返回的错误
+ */
+int metrics_write_prometheus(metrics_write_fn_t write, void* ctx);
+
+/**
+ * @brief 以紧凑 JSON 对象导出计数器和仪表（直方图仅导出 count/sum）
+ * @return 写入的字节数，缓冲区不足返回 -1
+ */
+int metrics_write_json(char* buf, size_t size);
+
+#endif // METRICS_H
@@ -0,0 +1,195 @@
+#include "broker_select.h"
+#include <string.h>
+
+// EWMA 系数 1/4：几次测量即可跟上变化，单次抖动影响有限
+static uint32_t ewma(uint32_t avg, uint32_t sample) {
+    if (avg == 0) return sample ? sample : 1;
+    int32_t diff = (int32_t)sample - (int32_t)avg;
+    int32_t next = (int32_t)avg + diff / 4;
+    return next > 0 ? (uint32_t)next : 1;
+}
+
+static bool str_terminated(const char* s, size_t size) {
+    return memchr(s, '\0', size) != NULL;
+}
+
+bool broker_list_valid(const broker_list_t* list) {
+    if (list->count == 0 || list->count > BROKER_MAX) return false;
+    for (int i = 0; i < list->count; i++) {
+        const broker_entry_t* e = &list->entry[i];
+        if (!str_terminated(e->uri, sizeof(e->uri)) ||
+            !str_terminated(e->username, sizeof(e->username)) ||
+            !str_terminated(e->password, sizeof(e->password))) {
+            return false;
+        }
+        const char* host = broker_uri_is_tls(e->uri) ? e->uri + 8
+                         : strncmp(e->uri, "mqtt://", 7) == 0 ? e->uri + 7 : NULL;
+        if (!host || host[0] == '\0') return false;
+    }
+    return true;
+}
+
+bool broker_uri_is_tls(const char* uri) {
+    return strncmp(uri, "mqtts://", 8) == 0;
+}
+
+void broker_select_init(broker_select_t* sel, const broker_list_t* list) {
+    memset(sel, 0, sizeof(*sel));
+    sel->list = *list;
+    sel->active = -1;
+}
+
+uint32_t broker_select_score(const broker_select_t* sel, int index) {
+    const broker_health_t* h = &sel->health[index];
+    uint32_t latency = h->rtt_ms ? h->rtt_ms : h->connect_ms;
+    return latency + (uint32_t)index * BROKER_RANK_PENALTY_MS;
+}
+
+/**
+ * @brief 退避已结束的 broker 中得分最好的，没有返回 -1
+ */
+static int best_available(const broker_select_t* sel, uint64_t now_ms) {
+    int best = -1;
+    uint32_t best_score = UINT32_MAX;
+    for (int i = 0; i < sel->list.count; i++) {
+        if (sel->health[i].retry_at_ms > now_ms) continue;
+        uint32_t score = broker_select_score(sel, i);
+        if (score < best_score) {
+            best_score = score;
+            best = i;
+        }
+    }
+    return best;
+}
+
+int broker_select_begin(broker_select_t* sel, uint64_t now_ms) {
+    int pick = -1;
+    if (sel->redial && sel->active >= 0 && sel->active < sel->list.count) {
+        pick = sel->active;
+    } else {
+        pick = best_available(sel, now_ms);
+    }
+    if (pick < 0) {
+        pick = 0;
+        for (int i = 1; i < sel->list.count; i++) {
+            if (sel->health[i].retry_at_ms < sel->health[pick].retry_at_ms) pick = i;
+        }
+    }
+    if (sel->active >= 0 && pick != sel->active) sel->switches++;
+    sel->active = (int8_t)pick;
+    sel->redial = false;
+    sel->connected = false;
+    sel->attempt_ms = now_ms;
+    return pick;
+}
+
+void broker_select_connected(broker_select_t* sel, uint64_t now_ms) {
+    if (sel->active < 0) return;
+    broker_health_t* h = &sel->health[sel->active];
+    h->connect_ms = ewma(h->connect_ms, (uint32_t)(now_ms - sel->attempt_ms));
+    h->fail_streak = 0;
+    h->retry_at_ms = 0;
+    sel->connected = true;
+    sel->connected_ms = now_ms;
+}
+
+static uint32_t backoff_ms(uint16_t streak) {
+    if (streak == 0) return 0;
+    if (streak > 15) return BROKER_RETRY_MAX_MS;
+    uint32_t backoff = BROKER_RETRY_MIN_MS << (streak - 1);
+    return backoff > BROKER_RETRY_MAX_MS ? BROKER_RETRY_MAX_MS : backoff;
+}
+
+/**
+ * @brief 当前 broker 退避到 active_retry_at_ms 时，距下一次可尝试的等待：
+ *        有退避已结束的 broker 时立即切过去，否则等最早结束退避的那个
+ */
+static uint32_t wait_for_next(const broker_select_t* sel, uint64_t now_ms, uint64_t active_retry_at_ms) {
+    uint64_t next = active_retry_at_ms;
+    for (int i = 0; i < sel->list.count; i++) {
+        if (i != sel->active && sel->health[i].retry_at_ms < next) next = sel->health[i].retry_at_ms;
+    }
+    if (next <= now_ms + BROKER_FAILOVER_MS) return BROKER_FAILOVER_MS;
+    return (uint32_t)(next - now_ms);
+}
+
+uint32_t broker_select_failed(broker_select_t* sel, uint64_t now_ms) {
+    if (sel->active < 0) return BROKER_RETRY_MIN_MS;
+    if (sel->connected) {
+        // 已建立的连接中断：多为 WiFi 或网络抖动，先重拨同一个 broker，不计失败
+        sel->connected = false;
+        sel->redial = true;
+        return BROKER_FAILOVER_MS;
+    }
+
+    broker_health_t* h = &sel->health[sel->active];
+    h->failures++;
+    if (h->fail_streak < UINT16_MAX) h->fail_streak++;
+    h->retry_at_ms = now_ms + backoff_ms(h->fail_streak);
+    return wait_for_next(sel, now_ms, h->retry_at_ms);
+}
+
+uint32_t broker_select_retry_wait(const broker_select_t* sel, uint64_t now_ms) {
+    if (sel->active < 0) return BROKER_RETRY_MIN_MS;
+    if (sel->connected) return BROKER_FAILOVER_MS;
+    uint16_t streak = sel->health[sel->active].fail_streak;
+    if (streak < UINT16_MAX) streak++;
+    return wait_for_next(sel, now_ms, now_ms + backoff_ms(streak));
+}
+
+void broker_select_release(broker_select_t* sel) {
+    sel->connected = false;
+    sel->redial = false;
+}
+
+void broker_select_rtt(broker_select_t* sel, uint32_t rtt_ms) {
+    if (sel->active < 0) return;
+    broker_health_t* h = &sel->health[sel->active];
+    h->rtt_ms = ewma(h->rtt_ms, rtt_ms);
+}
+
+/**
+ * @brief 回切候选：稳定运行已满保持时间时，退避已结束且得分明显更好的 broker，没有返回 -1
+ */
+static int failback_candidate(const broker_select_t* sel, uint64_t now_ms) {
+    if (!sel->connected || sel->active < 0) return -1;
+    if (now_ms - sel->connected_ms < BROKER_FAILBACK_HOLD_MS) return -1;
+    int best = best_available(sel, now_ms);
+    if (best < 0 || best == sel->active) return -1;
+    if (broker_select_score(sel, best) + BROKER_SWITCH_MARGIN_MS >= broker_select_score(sel, sel->active)) {
+        return -1;
+    }
+    return best;
+}
+
+int broker_select_failback(const broker_select_t* sel, uint64_t now_ms) {
+    int best = failback_candidate(sel, now_ms);
+    if (best < 0) return -1;
+    const broker_health_t* h = &sel->health[best];
+    // 只凭历史得分回切会切到已经宕机的首选 broker，再付出一轮连接超时和退避
+    if (h->fail_streak > 0 || !h->probe_ok || now_ms - h->probe_at_ms > BROKER_PROBE_FRESH_MS) return -1;
+    return best;
+}
+
+int broker_select_probe_due(const broker_select_t* sel, uint64_t now_ms) {
+    int best = failback_candidate(sel, now_ms);
+    if (best < 0) return -1;
+    const broker_health_t* h = &sel->health[best];
+    if (h->probe_at_ms && now_ms - h->probe_at_ms < BROKER_PROBE_INTERVAL_MS) return -1;
+    return best;
+}
+
+void broker_select_probe_result(broker_select_t* sel, int index, bool ok, uint64_t now_ms) {
+    if (index < 0 || index >= sel->list.count) return;
+    broker_health_t* h = &sel->health[index];
+    h->probe_at_ms = now_ms;
+    h->probe_ok = ok;
+    if (ok) {
+        h->fail_streak = 0;
+        h->retry_at_ms = 0;
+    } else {
+        h->failures++;
+        if (h->fail_streak < UINT16_MAX) h->fail_streak++;
+        h->retry_at_ms = now_ms + backoff_ms(h->fail_streak);
+    }
+}
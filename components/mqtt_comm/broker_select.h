@@ -0,0 +1,137 @@
+#ifndef BROKER_SELECT_H
+#define BROKER_SELECT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief MQTT broker 选择：按优先级排列的 broker 列表 + 健康跟踪
+ *        连接中断先重拨同一个 broker（多为 WiFi 抖动），连接失败才退避并切到下一个；
+ *        在备用 broker 上稳定运行一段时间后，若首选 broker 的综合得分明显更好，
+ *        且最近一次可达性探测成功，再回切
+ *        纯C实现，不依赖ESP-IDF
+ */
+
+#define BROKER_MAX              4
+#define BROKER_URI_MAX          96
+#define BROKER_USER_MAX         32
+#define BROKER_PASS_MAX         64
+
+#define BROKER_RETRY_MIN_MS     1000    // 连接失败后的首次退避
+#define BROKER_RETRY_MAX_MS     30000   // 退避上限，WiFi 恢复后最多等这么久
+#define BROKER_FAILOVER_MS      200     // 有其他可用 broker 时切换前的等待
+#define BROKER_FAILBACK_HOLD_MS 300000  // 在当前 broker 上至少稳定运行 5 分钟才考虑回切
+#define BROKER_RANK_PENALTY_MS  250     // 优先级每低一级折算的延迟
+#define BROKER_SWITCH_MARGIN_MS 100     // 得分至少好这么多才回切，避免延迟相近时来回切换
+#define BROKER_PROBE_INTERVAL_MS 60000  // 同一回切候选两次探测的最小间隔
+#define BROKER_PROBE_FRESH_MS   10000   // 探测成功后在这段时间内可以回切
+
+typedef struct {
+    char uri[BROKER_URI_MAX];           // mqtt://host:port 或 mqtts://host:port
+    char username[BROKER_USER_MAX];
+    char password[BROKER_PASS_MAX];
+} broker_entry_t;
+
+// NVS storage/mqtt_brokers 中的持久化格式，entry[0] 为首选
+typedef struct {
+    uint8_t count;
+    broker_entry_t entry[BROKER_MAX];
+} broker_list_t;
+
+typedef struct {
+    uint32_t connect_ms;                // 连接耗时（DNS+TCP+CONNACK）EWMA，0 表示未测
+    uint32_t rtt_ms;                    // QoS1 发布往返延迟 EWMA，0 表示未测
+    uint16_t fail_streak;               // 连续连接失败次数
+    uint32_t failures;                  // 累计连接失败次数
+    uint64_t retry_at_ms;               // 退避结束时间
+    uint64_t probe_at_ms;               // 最近一次可达性探测时间，0 表示未探测
+    bool probe_ok;                      // 最近一次探测是否成功
+} broker_health_t;
+
+typedef struct {
+    broker_list_t list;
+    broker_health_t health[BROKER_MAX];
+    int8_t active;                      // 当前连接或正在尝试的 broker，-1 表示尚未选择
+    bool connected;
+    bool redial;                        // 连接刚中断，下一次先重拨同一个 broker
+    uint64_t attempt_ms;                // 本次连接尝试开始时间
+    uint64_t connected_ms;              // 本次连接建立时间
+    uint32_t switches;                  // 切换到不同 broker 的次数
+} broker_select_t;
+
+/**
+ * @brief 检查列表：1~BROKER_MAX 项，URI 为 mqtt:// 或 mqtts:// 且带主机名，字符串均以 '\0' 结尾
+ */
+bool broker_list_valid(const broker_list_t* list);
+
+/**
+ * @brief URI 是否为 mqtts://
+ */
+bool broker_uri_is_tls(const char* uri);
+
+/**
+ * @brief 载入列表并清空健康记录
+ */
+void broker_select_init(broker_select_t* sel, const broker_list_t* list);
+
+/**
+ * @brief 开始一次连接尝试：优先重拨刚中断的 broker，否则在退避已结束的 broker 中取得分最好的；
+ *        全部处于退避时取最早结束退避的
+ * @return 本次尝试的 broker 下标
+ */
+int broker_select_begin(broker_select_t* sel, uint64_t now_ms);
+
+/**
+ * @brief 连接建立：记录连接耗时，清零连续失败
+ */
+void broker_select_connected(broker_select_t* sel, uint64_t now_ms);
+
+/**
+ * @brief 连接中断或尝试失败
+ * @return 距下一次连接尝试的等待时间（毫秒）
+ */
+uint32_t broker_select_failed(broker_select_t* sel, uint64_t now_ms);
+
+/**
+ * @brief 预测本次连接尝试若失败需要等待的时间，供连接前设置客户端的重连间隔
+ *        （已连接时即为连接中断后的重拨等待）
+ */
+uint32_t broker_select_retry_wait(const broker_select_t* sel, uint64_t now_ms);
+
+/**
+ * @brief 主动断开（回切或列表更新）：不计失败，也不重拨同一个 broker
+ */
+void broker_select_release(broker_select_t* sel);
+
+/**
+ * @brief 记录当前 broker 的一次往返延迟
+ */
+void broker_select_rtt(broker_select_t* sel, uint32_t rtt_ms);
+
+/**
+ * @brief 回切检查：已在当前 broker 上稳定运行 BROKER_FAILBACK_HOLD_MS，
+ *        且有退避已结束、没有连续失败、得分好出 BROKER_SWITCH_MARGIN_MS，
+ *        并在 BROKER_PROBE_FRESH_MS 内探测成功的 broker
+ * @return 应切换到的 broker 下标，不需要切换返回 -1
+ */
+int broker_select_failback(const broker_select_t* sel, uint64_t now_ms);
+
+/**
+ * @brief 需要探测的回切候选：除探测外满足回切条件（连续失败的 broker 也探测，
+ *        探测成功才清零），且距上次探测已过 BROKER_PROBE_INTERVAL_MS
+ * @return 候选下标，没有返回 -1
+ */
+int broker_select_probe_due(const broker_select_t* sel, uint64_t now_ms);
+
+/**
+ * @brief 记录探测结果：成功清零连续失败和退避；失败按连接失败计入退避
+ */
+void broker_select_probe_result(broker_select_t* sel, int index, bool ok, uint64_t now_ms);
+
+/**
+ * @brief 综合得分（越小越好）：往返延迟（未测时用连接耗时）+ 优先级折算
+ */
+uint32_t broker_select_score(const broker_select_t* sel, int index);
+
+#endif // BROKER_SELECT_H
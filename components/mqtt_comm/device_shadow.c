@@ -0,0 +1,84 @@
+#include "device_shadow.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void shadow_init(device_shadow_t* shadow) {
+    memset(shadow, 0, sizeof(*shadow));
+}
+
+void shadow_restore_version(device_shadow_t* shadow, uint32_t limit) {
+    shadow->version = limit;
+    shadow->version_limit = limit;
+}
+
+uint32_t shadow_reserve_version(device_shadow_t* shadow) {
+    if (shadow->version <= shadow->version_limit) return 0;
+    shadow->version_limit = shadow->version + SHADOW_VERSION_BLOCK - 1;
+    return shadow->version_limit;
+}
+
+static int shadow_diff(const shadow_state_t* a, const shadow_state_t* b) {
+    int fields = 0;
+    if (abs(a->temp_centi - b->temp_centi) >= SHADOW_TEMP_DEADBAND_CENTI) fields |= SHADOW_FIELD_TEMP;
+    if (a->fan_speed != b->fan_speed)           fields |= SHADOW_FIELD_SPEED;
+    if (a->cooler_power != b->cooler_power)     fields |= SHADOW_FIELD_COOLER;
+    if (a->auto_mode != b->auto_mode)           fields |= SHADOW_FIELD_MODE;
+    if (a->threshold_deci != b->threshold_deci) fields |= SHADOW_FIELD_THRESHOLD;
+    if (a->max_speed != b->max_speed)           fields |= SHADOW_FIELD_MAX_SPEED;
+    return fields;
+}
+
+int shadow_update_reported(device_shadow_t* shadow, const shadow_state_t* state) {
+    int fields = shadow->has_reported ? shadow_diff(state, &shadow->reported) : SHADOW_FIELD_ALL;
+    if (fields == 0) return 0;
+
+    // 只合并变化的字段：温度在死区内时保留旧值，避免慢漂移被逐步吞掉
+    if (fields & SHADOW_FIELD_TEMP) shadow->reported.temp_centi = state->temp_centi;
+    shadow->reported.fan_speed      = state->fan_speed;
+    shadow->reported.cooler_power   = state->cooler_power;
+    shadow->reported.auto_mode      = state->auto_mode;
+    shadow->reported.threshold_deci = state->threshold_deci;
+    shadow->reported.max_speed      = state->max_speed;
+    shadow->has_reported = true;
+    shadow->version++;
+    return fields;
+}
+
+shadow_desired_result_t shadow_accept_desired(device_shadow_t* shadow, uint32_t version) {
+    if (version == shadow->desired_version) return SHADOW_DESIRED_DUPLICATE;
+    if (version < shadow->desired_version) return SHADOW_DESIRED_STALE;
+    shadow->desired_version = version;
+    return SHADOW_DESIRED_ACCEPTED;
+}
+
+int shadow_format(const device_shadow_t* shadow, int fields, char* buf, size_t size) {
+    const shadow_state_t* st = &shadow->reported;
+    size_t n = 0;
+    int len;
+
+#define SHADOW_APPEND(...) do { \
+        len = snprintf(buf + n, size - n, __VA_ARGS__); \
+        if (len < 0 || (size_t)len >= size - n) return -1; \
+        n += len; \
+    } while (0)
+
+    SHADOW_APPEND("{\"v\":%lu,\"desired_v\":%lu", (unsigned long)shadow->version,
+                  (unsigned long)shadow->desired_version);
+    if (fields & SHADOW_FIELD_TEMP) {
+        int t = st->temp_centi;
+        SHADOW_APPEND(",\"temp\":%s%d.%02d", t < 0 ? "-" : "", abs(t) / 100, abs(t) % 100);
+    }
+    if (fields & SHADOW_FIELD_SPEED)  SHADOW_APPEND(",\"speed\":%u", st->fan_speed);
+    if (fields & SHADOW_FIELD_COOLER) SHADOW_APPEND(",\"cooler\":%u", st->cooler_power);
+    if (fields & SHADOW_FIELD_MODE)   SHADOW_APPEND(",\"mode\":\"%s\"", st->auto_mode ? "auto" : "manual");
+    if (fields & SHADOW_FIELD_THRESHOLD) {
+        int t = st->threshold_deci;
+        SHADOW_APPEND(",\"temp_threshold\":%s%d.%d", t < 0 ? "-" : "", abs(t) / 10, abs(t) % 10);
+    }
+    if (fields & SHADOW_FIELD_MAX_SPEED) SHADOW_APPEND(",\"max_speed\":%u", st->max_speed);
+    SHADOW_APPEND("}");
+
+#undef SHADOW_APPEND
+    return (int)n;
+}
@@ -0,0 +1,85 @@
+#ifndef DEVICE_SHADOW_H
+#define DEVICE_SHADOW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 设备影子：带版本号的状态文档
+ *        上报状态变化时版本号加一，只输出变化字段；
+ *        期望状态按版本号去重，过期或重复的请求被丢弃
+ *        上报版本号按段预留并持久化，重启后从已预留的上限继续，保持单调递增
+ *        纯C实现，不依赖ESP-IDF
+ */
+
+// 每次持久化预留的上报版本号个数：每段只写一次 NVS
+#define SHADOW_VERSION_BLOCK 256
+
+// 温度死区（0.01°C），避免 DS18B20 最低位抖动产生大量增量
+#define SHADOW_TEMP_DEADBAND_CENTI 10
+
+// 字段掩码
+#define SHADOW_FIELD_TEMP       (1 << 0)
+#define SHADOW_FIELD_SPEED      (1 << 1)
+#define SHADOW_FIELD_COOLER     (1 << 2)
+#define SHADOW_FIELD_MODE       (1 << 3)
+#define SHADOW_FIELD_THRESHOLD  (1 << 4)
+#define SHADOW_FIELD_MAX_SPEED  (1 << 5)
+#define SHADOW_FIELD_ALL        0x3F
+
+// 上报状态（定点数，便于精确比较）
+typedef struct {
+    int16_t temp_centi;         // 温度，0.01°C
+    uint8_t fan_speed;          // 风扇转速百分比
+    uint8_t cooler_power;       // 制冷片功率百分比
+    bool auto_mode;             // true=自动模式
+    int16_t threshold_deci;     // 温度阈值，0.1°C
+    uint8_t max_speed;          // 最大转速百分比
+} shadow_state_t;
+
+typedef struct {
+    shadow_state_t reported;    // 最近一次上报的状态
+    uint32_t version;           // 上报版本号，首次启动从1开始
+    uint32_t version_limit;     // 已持久化的版本号上限，发布的版本号不超过此值
+    uint32_t desired_version;   // 最近一次接受的期望状态版本号
+    bool has_reported;
+} device_shadow_t;
+
+typedef enum {
+    SHADOW_DESIRED_ACCEPTED,    // 版本号更新，应执行
+    SHADOW_DESIRED_DUPLICATE,   // 与已接受版本相同（重发）
+    SHADOW_DESIRED_STALE,       // 比已接受版本旧
+} shadow_desired_result_t;
+
+void shadow_init(device_shadow_t* shadow);
+
+/**
+ * @brief 从持久化的版本号上限恢复：之前发布的版本号都不超过该值，新版本从其后继续
+ */
+void shadow_restore_version(device_shadow_t* shadow, uint32_t limit);
+
+/**
+ * @brief 版本号超出已预留的上限时预留下一段，须在发布该版本前持久化返回值
+ * @return 需要持久化的新上限；0 表示当前预留仍够用
+ */
+uint32_t shadow_reserve_version(device_shadow_t* shadow);
+
+/**
+ * @brief 合并新的上报状态
+ * @return 变化字段掩码；非0时版本号已加一
+ */
+int shadow_update_reported(device_shadow_t* shadow, const shadow_state_t* state);
+
+/**
+ * @brief 检查期望状态的版本号，接受时记录该版本
+ */
+shadow_desired_result_t shadow_accept_desired(device_shadow_t* shadow, uint32_t version);
+
+/**
+ * @brief 序列化指定字段（含版本号）
+ * @return 写入字节数，缓冲区不足返回 -1
+ */
+int shadow_format(const device_shadow_t* shadow, int fields, char* buf, size_t size);
+
+#endif // DEVICE_SHADOW_H
@@ -2,117 +2,934 @@
 #include "esp_log.h"
 #include "mqtt_client.h"
 #include "cJSON.h"
+#include "power_mgmt.h"
+#include "metrics.h"
+#include "trace.h"
+#include "broker_select.h"
+#include "mqtt_tls.h"
+#include "esp_mac.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <math.h>
+#include <float.h>
 
 static const char* TAG = "MQTT";
 
-// MQTT主题定义
-#define MQTT_TOPIC_STATUS    "esp32/fan_control/status"
-#define MQTT_TOPIC_COMMAND   "esp32/fan_control/command"
-#define MQTT_TOPIC_CONFIG    "esp32/fan_control/config"
+// MQTT主题定义：设备主题为 <前缀>/<设备ID>/<后缀>，组主题为 <前缀>/group/<组名>/<后缀>
+#define MQTT_TOPIC_PREFIX    "esp32/fan_control"
+#define MQTT_TOPIC_MAX       96
+#define MQTT_GROUP_MAX       32
+#define MQTT_MAX_ROUTES      8
+#define MQTT_SHADOW_MAX      192
+#define MQTT_STATUS_MAX      64
+#define MQTT_TELEMETRY_MAX   1280
+#define MQTT_AUTOTUNE_MAX    192
+#define MQTT_SENSOR_MAX      160
+#define MQTT_OTA_STATUS_MAX  192
+#define MQTT_ACK_MAX         160
+// cJSON 解析内存池：命令/配置/期望状态均为数百字节以内的小文档
+#define MQTT_JSON_ARENA_SIZE 4096
+// 解析失败时日志只带开头部分：载荷可能很长，也可能含密码或证书
+#define MQTT_LOG_PAYLOAD_MAX 64
+// 温度阈值接受范围（DS18B20 常用量程内）
+#define MQTT_THRESHOLD_MIN   0.0
+#define MQTT_THRESHOLD_MAX   85.0
+// 传感器故障外推时限上限（与 SENSOR_FAULT_HOLDOVER_MAX_MS 一致）
+#define MQTT_HOLDOVER_MAX_S  3600
+// 失效安全风扇占空比下限（与 SENSOR_FAULT_FAILSAFE_FAN_MIN 一致）
+#define MQTT_FAILSAFE_FAN_MIN 40
+
+#define MQTT_KEEPALIVE_S     60
+
+// 未配置 NVS storage/mqtt_brokers 时使用的默认 broker
+#define MQTT_DEFAULT_BROKER_URI  "mqtt://nas.phenosolar.com:1883"
+#define MQTT_DEFAULT_BROKER_USER "admin"
+#define MQTT_DEFAULT_BROKER_PASS "admin"
+// 往返延迟探测：QoS1 发布到 PUBACK 的时间（esp-mqtt 不暴露 PINGRESP 时刻），周期与 keepalive 相同
+#define MQTT_PROBE_TIMEOUT_MS 10000
+// 未确认遥测的暂存条数：QoS1 发布后等 PUBACK 才移除，断线期间暂存，重连后按原顺序补发
+#define MQTT_BACKLOG_SLOTS   6
+// 回切前对首选 broker 的可达性探测：在单独的一次性任务中进行，不阻塞上报任务的 OLED/菜单刷新
+#define MQTT_FAILBACK_PROBE_TIMEOUT_MS 1000
+#define MQTT_PROBE_TASK_STACK   8192    // TLS 握手需要较大的栈（与 OTA 任务相同）
+#define MQTT_PROBE_TASK_PRIO    3       // 低于上报任务
+#define MQTT_PROBE_TASK_CORE    0
+
+// 指标
+static METRIC_COUNTER_DEFINE(m_publish, "fan_mqtt_publish_total", "MQTT messages handed to the client");
+static METRIC_COUNTER_DEFINE(m_publish_fail, "fan_mqtt_publish_failures_total", "MQTT publish calls that failed");
+static METRIC_COUNTER_DEFINE(m_parse_err, "fan_mqtt_parse_errors_total", "Command/config payloads that failed to parse");
+static METRIC_COUNTER_DEFINE(m_connects, "fan_mqtt_connects_total", "MQTT connections established");
+static METRIC_COUNTER_DEFINE(m_disconnects, "fan_mqtt_disconnects_total", "MQTT disconnections");
+static METRIC_COUNTER_DEFINE(m_broker_switches, "fan_mqtt_broker_switches_total", "Connection attempts moved to a different broker");
+static METRIC_COUNTER_DEFINE(m_probe_lost, "fan_mqtt_probe_timeouts_total", "RTT probes without PUBACK that forced a reconnect");
+static METRIC_COUNTER_DEFINE(m_backlog_dropped, "fan_mqtt_backlog_dropped_total", "Telemetry messages dropped from a full offline backlog");
+static METRIC_HISTOGRAM_DEFINE(m_connect_ms, "fan_mqtt_connect_duration_ms", "Broker connect time including DNS/TCP/CONNACK",
+                               50, 100, 200, 500, 1000, 2000, 5000, 10000);
+static METRIC_HISTOGRAM_DEFINE(m_rtt_ms, "fan_mqtt_rtt_ms", "QoS1 publish to PUBACK round trip",
+                               10, 25, 50, 100, 250, 500, 1000, 5000);
+
+static METRIC_HISTOGRAM_DEFINE(m_cmd_actuation_us, "fan_mqtt_command_actuation_us", "Command receive to output write on the device",
+                               100, 250, 500, 1000, 2500, 5000, 10000, 50000);
+static METRIC_COUNTER_DEFINE(m_cmd_rejected, "fan_mqtt_command_rejected_total", "Commands acked as rejected or invalid");
+
+static METRIC_COUNTER_DEFINE(m_unrouted, "fan_mqtt_unrouted_total", "Messages whose topic matched no route");
+static METRIC_COUNTER_DEFINE(m_arena_full, "fan_mqtt_json_arena_full_total", "JSON parses that exceeded the static arena");
+TRACE_NAME(t_rx, "mqtt_rx");
+TRACE_NAME(t_publish, "mqtt_publish");
+TRACE_NAME(t_connected, "mqtt_connected");
+TRACE_NAME(t_disconnected, "mqtt_disconnected");
+TRACE_NAME(t_broker_switch, "mqtt_broker_switch");
+
+// 主题路由表：按主题精确匹配分发
+typedef struct {
+    char topic[MQTT_TOPIC_MAX];
+    void (*handler)(const char* data, int data_len);
+} mqtt_route_t;
+
+static mqtt_route_t s_routes[MQTT_MAX_ROUTES];
+static int s_route_count = 0;
+
+static char s_device_id[MQTT_DEVICE_ID_MAX];
+static char s_group[MQTT_GROUP_MAX];
+static char s_topic_status[MQTT_TOPIC_MAX];
+static char s_topic_telemetry[MQTT_TOPIC_MAX];
+static char s_topic_diag[MQTT_TOPIC_MAX];
+static char s_topic_state[MQTT_TOPIC_MAX];        // 保留消息：完整影子文档
+static char s_topic_state_delta[MQTT_TOPIC_MAX];  // 非保留：只含变化字段
+static char s_topic_availability[MQTT_TOPIC_MAX]; // 保留消息：online/offline（遗嘱）
+static char s_topic_autotune[MQTT_TOPIC_MAX];
+static char s_topic_history[MQTT_TOPIC_MAX];      // 历史查询响应
+static char s_topic_latency[MQTT_TOPIC_MAX];      // 分阶段延迟摘要
+static char s_topic_trace[MQTT_TOPIC_MAX];        // 事件追踪导出
+static char s_topic_ota_status[MQTT_TOPIC_MAX];   // OTA 进度与结果
+static char s_topic_ping[MQTT_TOPIC_MAX];         // 往返延迟探测
+static char s_topic_cmd_ack[MQTT_TOPIC_MAX];      // 命令回执
+static char s_topic_sensor[MQTT_TOPIC_MAX];       // 温度传感器故障状态
+
+static volatile bool s_connected = false;
+
+// broker 选择：事件处理（MQTT 任务）与回切检查、遥测（上报任务）共享
+static broker_select_t s_broker;
+static portMUX_TYPE s_broker_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool s_broker_reload = false;              // 列表已更新，下个服务周期切到新列表的首选
+static volatile bool s_switching = false;         // 主动断开中，随后的断开事件不计失败
+// 客户端完整配置：esp_mqtt_set_config 会把未填字段复位为默认值，每次都传完整配置
+static esp_mqtt_client_config_t s_mqtt_cfg;
+static esp_transport_handle_t s_transport = NULL; // mqtt:// 与 mqtts:// 共用的自定义传输（见 mqtt_tls.c）
+static broker_entry_t s_broker_entry;             // 已应用到客户端的 broker（仅 MQTT 任务访问）
+static broker_list_t s_broker_staged;             // 配置解析出的新列表（持有 JSON 内存池锁时访问）
+
+// 往返延迟探测（仅上报任务发起，MQTT 任务在 PUBACK 时结算）
+static volatile int s_probe_msg_id = 0;
+static volatile int64_t s_probe_sent_us = 0;
+static uint32_t s_probe_period_ms = MQTT_KEEPALIVE_S * 1000;
+// 回切探测任务：同一时刻至多一个，结果在下一次 mqtt_comm_service 中用于回切
+static volatile bool s_failback_probing = false;
+static int s_failback_probe_index;
+static broker_entry_t s_failback_probe_entry;
+static volatile uint32_t s_failback_probe_hwm;    // 探测任务栈的最小剩余（字节），0 表示尚未探测
+
+// 遥测暂存：环形缓冲，收到 PUBACK 后从头部移除，满时丢弃最旧的一条
+// s_backlog_lock 只保护条目状态，持锁期间不调用 esp-mqtt：MQTT 任务持客户端锁执行事件回调时会结算暂存区，
+// 若发布方持暂存锁再等客户端锁就会互锁
+#define MQTT_BACKLOG_UNSENT  0      // 尚未交给客户端
+#define MQTT_BACKLOG_ACKED   (-1)   // 已确认，等前面的条目确认后一并移除
+#define MQTT_BACKLOG_SENDING (-2)   // 正在发布（锁外），条目内容不可改动
+#define MQTT_BACKLOG_EARLY   4      // 发布返回前就到达的结算
+typedef struct {
+    uint16_t len;
+    int msg_id;                     // 已发布的消息 ID，或上面三个状态
+    char data[MQTT_TELEMETRY_MAX];
+} mqtt_backlog_slot_t;
+
+// 发布调用返回、记下消息 ID 之前，MQTT 任务可能已处理了它的 PUBACK 或丢弃事件：先记在这里，记 ID 时再结算
+typedef struct {
+    int msg_id;
+    bool acked;
+} mqtt_backlog_early_t;
+
+static mqtt_backlog_slot_t s_backlog[MQTT_BACKLOG_SLOTS];
+static uint8_t s_backlog_head = 0;
+static uint8_t s_backlog_count = 0;
+static uint8_t s_backlog_sending = 0;
+static mqtt_backlog_early_t s_backlog_early[MQTT_BACKLOG_EARLY];
+static uint8_t s_backlog_early_next = 0;
+static SemaphoreHandle_t s_backlog_lock = NULL;
+static StaticSemaphore_t s_backlog_lock_buf;
+
+// 当前正在分发的消息（仅 MQTT 任务访问），路由处理函数据此发布回执
+static esp_mqtt_client_handle_t s_rx_client = NULL;
+static int64_t s_rx_us = 0;
+
+// 设备影子，上报来自控制任务，期望状态来自 MQTT 任务
+static device_shadow_t s_shadow;
+static SemaphoreHandle_t s_shadow_lock = NULL;
 
 // 回调函数指针
 static mqtt_command_callback_t command_callback = NULL;
 static mqtt_config_callback_t config_callback = NULL;
+static mqtt_history_callback_t history_callback = NULL;
+static mqtt_ota_callback_t ota_callback = NULL;
 
-// 前向声明
-static void mqtt_handle_command(const char* data, int data_len);
-static void mqtt_handle_config(const char* data, int data_len);
+// cJSON 解析使用静态内存池：解析期间顺序分配、cJSON_Delete 不逐个释放，解析结束整体复位。
+// 只有持有内存池的任务走内存池，其他 cJSON 使用者仍走 malloc
+static uint8_t s_json_arena[MQTT_JSON_ARENA_SIZE] __attribute__((aligned(8)));
+static size_t s_json_arena_used = 0;
+static TaskHandle_t s_json_arena_owner = NULL;
+static SemaphoreHandle_t s_json_arena_lock = NULL;
+static StaticSemaphore_t s_json_arena_lock_buf;
+
+static void* json_arena_alloc(size_t size) {
+    if (s_json_arena_owner != xTaskGetCurrentTaskHandle()) {
+        return malloc(size);
+    }
+    size_t need = (size + 7) & ~(size_t)7;
+    if (need > sizeof(s_json_arena) - s_json_arena_used) {
+        metrics_inc(&m_arena_full);
+        return NULL;
+    }
+    void* p = s_json_arena + s_json_arena_used;
+    s_json_arena_used += need;
+    return p;
+}
+
+static void json_arena_free(void* p) {
+    uint8_t* b = p;
+    if (b >= s_json_arena && b < s_json_arena + sizeof(s_json_arena)) return;
+    free(p);
+}
 
 /**
- * @brief 处理MQTT命令消息 - 使用cJSON解析
+ * @brief 在内存池中解析，成功后必须以 json_release 结束
+ * @return 解析结果，失败返回 NULL（内存池已归还）
  */
-static void mqtt_handle_command(const char* data, int data_len) {
-    char* json_string = malloc(data_len + 1);
-    if (!json_string) {
-        ESP_LOGE(TAG, "内存分配失败");
-        return;
+static cJSON* json_parse(const char* data, int data_len) {
+    xSemaphoreTake(s_json_arena_lock, portMAX_DELAY);
+    s_json_arena_owner = xTaskGetCurrentTaskHandle();
+    s_json_arena_used = 0;
+    cJSON* json = cJSON_ParseWithLength(data, data_len);
+    if (json == NULL) {
+        s_json_arena_owner = NULL;
+        xSemaphoreGive(s_json_arena_lock);
     }
-    
-    memcpy(json_string, data, data_len);
-    json_string[data_len] = '\0';
-    
-    // 使用cJSON解析
-    cJSON *json = cJSON_Parse(json_string);
+    return json;
+}
+
+static void json_release(cJSON* json) {
+    cJSON_Delete(json);
+    s_json_arena_owner = NULL;
+    xSemaphoreGive(s_json_arena_lock);
+}
+
+/**
+ * @brief 安装 cJSON 内存钩子（lan_api 也会调用解析函数，须在任何解析之前完成）
+ */
+static void json_arena_init(void) {
+    if (s_json_arena_lock) return;
+    s_json_arena_lock = xSemaphoreCreateMutexStatic(&s_json_arena_lock_buf);
+    cJSON_Hooks hooks = { .malloc_fn = json_arena_alloc, .free_fn = json_arena_free };
+    cJSON_InitHooks(&hooks);
+}
+
+/**
+ * @brief 读取 NVS 中的 broker 列表，缺失或无效时使用默认 broker
+ */
+static void mqtt_load_brokers(broker_list_t* list) {
+    nvs_handle_t nvs;
+    bool ok = false;
+    if (nvs_open("storage", NVS_READONLY, &nvs) == ESP_OK) {
+        size_t size = sizeof(*list);
+        ok = nvs_get_blob(nvs, "mqtt_brokers", list, &size) == ESP_OK &&
+             size == sizeof(*list) && broker_list_valid(list);
+        nvs_close(nvs);
+    }
+    if (!ok) {
+        memset(list, 0, sizeof(*list));
+        list->count = 1;
+        strlcpy(list->entry[0].uri, MQTT_DEFAULT_BROKER_URI, sizeof(list->entry[0].uri));
+        strlcpy(list->entry[0].username, MQTT_DEFAULT_BROKER_USER, sizeof(list->entry[0].username));
+        strlcpy(list->entry[0].password, MQTT_DEFAULT_BROKER_PASS, sizeof(list->entry[0].password));
+    }
+}
+
+static bool copy_json_str(const cJSON* item, char* dst, size_t size) {
+    if (item == NULL) {
+        dst[0] = '\0';
+        return true;
+    }
+    if (!cJSON_IsString(item) || strlen(item->valuestring) >= size) return false;
+    strlcpy(dst, item->valuestring, size);
+    return true;
+}
+
+/**
+ * @brief 解析 "brokers":[{"uri":"mqtt://a:1883","username":"u","password":"p"},...]，首项为首选
+ *        校验通过后写入 NVS，并在下个服务周期切到新列表的首选（调用方持有 JSON 内存池锁）
+ */
+static bool mqtt_stage_brokers(const cJSON* array) {
+    broker_list_t* list = &s_broker_staged;
+    memset(list, 0, sizeof(*list));
+    int n = cJSON_GetArraySize(array);
+    if (n < 1 || n > BROKER_MAX) return false;
+
+    const cJSON* item;
+    cJSON_ArrayForEach(item, array) {
+        broker_entry_t* e = &list->entry[list->count++];
+        if (!cJSON_IsString(cJSON_GetObjectItem(item, "uri")) ||
+            !copy_json_str(cJSON_GetObjectItem(item, "uri"), e->uri, sizeof(e->uri)) ||
+            !copy_json_str(cJSON_GetObjectItem(item, "username"), e->username, sizeof(e->username)) ||
+            !copy_json_str(cJSON_GetObjectItem(item, "password"), e->password, sizeof(e->password))) {
+            return false;
+        }
+    }
+    if (!broker_list_valid(list)) return false;
+
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READWRITE, &nvs) == ESP_OK) {
+        nvs_set_blob(nvs, "mqtt_brokers", list, sizeof(*list));
+        nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+    portENTER_CRITICAL(&s_broker_mux);
+    uint32_t switches = s_broker.switches;
+    broker_select_init(&s_broker, list);
+    s_broker.switches = switches;
+    s_broker_reload = true;
+    portEXIT_CRITICAL(&s_broker_mux);
+    ESP_LOGI(TAG, "broker 列表已更新: %u 个，首选 %s", list->count, list->entry[0].uri);
+    return true;
+}
+
+#define LOG_LEN(len) ((len) < MQTT_LOG_PAYLOAD_MAX ? (len) : MQTT_LOG_PAYLOAD_MAX)
+
+/**
+ * @brief 非负整数字段，超出 uint32_t 的值截到上限（直接转换超范围的 double 是未定义行为）
+ */
+static bool parse_u32(const cJSON* item, uint32_t* out) {
+    if (!cJSON_IsNumber(item) || !(item->valuedouble >= 0)) return false;
+    *out = item->valuedouble >= (double)UINT32_MAX ? UINT32_MAX : (uint32_t)item->valuedouble;
+    return true;
+}
+
+/**
+ * @brief 复制请求方关联ID：原样写回响应 JSON，只接受不需要转义的字符，否则置空
+ */
+static void copy_corr_id(const cJSON* item, char* out, size_t size) {
+    out[0] = '\0';
+    if (!cJSON_IsString(item)) return;
+    strlcpy(out, item->valuestring, size);
+    for (char* c = out; *c; c++) {
+        if (*c == '"' || *c == '\\' || (unsigned char)*c < 0x20) {
+            out[0] = '\0';
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 速度字段：只接受 0~100 的数值，valueint 直接截成 uint8_t 会把 300 变成 44
+ * @return true 字段存在（有效与否由 valid 区分）
+ */
+static bool parse_speed(const cJSON* item, uint8_t* speed, bool* valid) {
+    if (!cJSON_IsNumber(item)) return false;
+    *valid = item->valuedouble >= 0 && item->valuedouble <= 100;
+    if (*valid) *speed = (uint8_t)item->valuedouble;
+    return true;
+}
+
+/**
+ * @brief 浮点字段：拒绝 NaN/inf 以及转成 float 后溢出的值（cJSON 把 1e999 解析成 inf）
+ */
+static bool is_finite_number(const cJSON* item) {
+    return cJSON_IsNumber(item) && isfinite(item->valuedouble) && fabs(item->valuedouble) <= FLT_MAX;
+}
+
+/**
+ * @brief 解析命令JSON - 使用cJSON解析
+ */
+bool mqtt_comm_parse_command(const char* data, int data_len, mqtt_command_t* cmd) {
+    memset(cmd, 0, sizeof(*cmd));
+
+    cJSON *json = json_parse(data, data_len);
     if (json == NULL) {
-        ESP_LOGE(TAG, "JSON解析失败: %s", json_string);
-        free(json_string);
-        return;
+        metrics_inc(&m_parse_err);
+        ESP_LOGE(TAG, "JSON解析失败: %.*s", LOG_LEN(data_len), data);
+        return false;
     }
     
     // 解析命令参数
     cJSON *speed_item = cJSON_GetObjectItem(json, "speed");
     cJSON *mode_item = cJSON_GetObjectItem(json, "mode");
     
-    mqtt_command_t cmd = {0};
-    
-    if (cJSON_IsNumber(speed_item)) {
-        cmd.speed = speed_item->valueint;
-        cmd.has_speed = true;
-        ESP_LOGI(TAG, "解析到速度命令: %d%%", cmd.speed);
+    bool speed_valid = false;
+    if (parse_speed(speed_item, &cmd->speed, &speed_valid)) {
+        cmd->has_speed = speed_valid;
+        cmd->speed_invalid = !speed_valid;
+        ESP_LOGI(TAG, "解析到速度命令: %.1f%%%s", speed_item->valuedouble, speed_valid ? "" : "（超出范围）");
     }
     
     if (cJSON_IsString(mode_item)) {
         if (strcmp(mode_item->valuestring, "auto") == 0) {
-            cmd.mode = MQTT_MODE_AUTO;
-            cmd.has_mode = true;
+            cmd->mode = MQTT_MODE_AUTO;
+            cmd->has_mode = true;
         } else if (strcmp(mode_item->valuestring, "manual") == 0) {
-            cmd.mode = MQTT_MODE_MANUAL;
-            cmd.has_mode = true;
+            cmd->mode = MQTT_MODE_MANUAL;
+            cmd->has_mode = true;
         }
         ESP_LOGI(TAG, "解析到模式命令: %s", mode_item->valuestring);
     }
-    
-    // 调用回调函数处理命令
-    if (command_callback) {
-        command_callback(&cmd);
+
+    cJSON *autotune_item = cJSON_GetObjectItem(json, "autotune");
+    if (cJSON_IsString(autotune_item)) {
+        if (strcmp(autotune_item->valuestring, "start") == 0) {
+            cmd->autotune = MQTT_AUTOTUNE_START;
+            cmd->has_autotune = true;
+        } else if (strcmp(autotune_item->valuestring, "abort") == 0) {
+            cmd->autotune = MQTT_AUTOTUNE_ABORT;
+            cmd->has_autotune = true;
+        } else if (strcmp(autotune_item->valuestring, "clear") == 0) {
+            cmd->autotune = MQTT_AUTOTUNE_CLEAR;
+            cmd->has_autotune = true;
+        }
+        ESP_LOGI(TAG, "解析到自整定命令: %s", autotune_item->valuestring);
+    }
+
+    cJSON *fan_cal_item = cJSON_GetObjectItem(json, "fan_cal");
+    if (cJSON_IsString(fan_cal_item)) {
+        if (strcmp(fan_cal_item->valuestring, "start") == 0) {
+            cmd->fan_cal = MQTT_FAN_CAL_START;
+            cmd->has_fan_cal = true;
+        } else if (strcmp(fan_cal_item->valuestring, "abort") == 0) {
+            cmd->fan_cal = MQTT_FAN_CAL_ABORT;
+            cmd->has_fan_cal = true;
+        } else if (strcmp(fan_cal_item->valuestring, "reset") == 0) {
+            cmd->fan_cal = MQTT_FAN_CAL_RESET;
+            cmd->has_fan_cal = true;
+        }
+        ESP_LOGI(TAG, "解析到风扇校准命令: %s", fan_cal_item->valuestring);
     }
+
+    cJSON *report_item = cJSON_GetObjectItem(json, "report");
+    if (cJSON_IsString(report_item)) {
+        if (strcmp(report_item->valuestring, "latency") == 0) {
+            cmd->report_latency = true;
+        } else if (strcmp(report_item->valuestring, "trace") == 0) {
+            cmd->report_trace = true;
+        } else if (strcmp(report_item->valuestring, "trace_log") == 0) {
+            cmd->report_trace_log = true;
+        }
+    }
+
+    copy_corr_id(cJSON_GetObjectItem(json, "id"), cmd->id, sizeof(cmd->id));
     
-    cJSON_Delete(json);
-    free(json_string);
+    json_release(json);
+    return true;
 }
 
 /**
- * @brief 处理MQTT配置消息 - 使用cJSON解析
+ * @brief 解析配置JSON - 使用cJSON解析
  */
-static void mqtt_handle_config(const char* data, int data_len) {
-    char* json_string = malloc(data_len + 1);
-    if (!json_string) {
-        ESP_LOGE(TAG, "内存分配失败");
-        return;
+bool mqtt_comm_parse_config(const char* data, int data_len, mqtt_config_t* cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+
+    cJSON *json = json_parse(data, data_len);
+    if (json == NULL) {
+        metrics_inc(&m_parse_err);
+        ESP_LOGE(TAG, "JSON解析失败: %.*s", LOG_LEN(data_len), data);
+        return false;
     }
     
-    memcpy(json_string, data, data_len);
-    json_string[data_len] = '\0';
+    cJSON *temp_threshold = cJSON_GetObjectItem(json, "temp_threshold");
+    if (cJSON_IsNumber(temp_threshold)) {
+        cfg->has_temp_threshold = temp_threshold->valuedouble >= MQTT_THRESHOLD_MIN &&
+                                  temp_threshold->valuedouble <= MQTT_THRESHOLD_MAX;
+        if (cfg->has_temp_threshold) cfg->temp_threshold = temp_threshold->valuedouble;
+        else ESP_LOGW(TAG, "temp_threshold 超出范围，忽略");
+    }
     
-    cJSON *json = cJSON_Parse(json_string);
+    bool speed_valid = false;
+    if (parse_speed(cJSON_GetObjectItem(json, "max_speed"), &cfg->max_speed, &speed_valid)) {
+        cfg->has_max_speed = speed_valid;
+        if (!speed_valid) ESP_LOGW(TAG, "max_speed 超出范围，忽略");
+    }
+
+    // 停转温度与阈值的先后关系要和当前设置合并后才能判断，由配置回调检查
+    cJSON *fan_off = cJSON_GetObjectItem(json, "fan_off_temp");
+    if (cJSON_IsNumber(fan_off)) {
+        cfg->has_fan_off_temp = fan_off->valuedouble >= MQTT_THRESHOLD_MIN &&
+                                fan_off->valuedouble <= MQTT_THRESHOLD_MAX;
+        if (cfg->has_fan_off_temp) cfg->fan_off_temp = fan_off->valuedouble;
+        else ESP_LOGW(TAG, "fan_off_temp 超出范围，忽略");
+    }
+    if (parse_speed(cJSON_GetObjectItem(json, "mid_speed"), &cfg->mid_speed, &speed_valid)) {
+        cfg->has_mid_speed = speed_valid;
+        if (!speed_valid) ESP_LOGW(TAG, "mid_speed 超出范围，忽略");
+    }
+
+    cJSON *budget = cJSON_GetObjectItem(json, "power_budget_w");
+    if (is_finite_number(budget) && budget->valuedouble >= 0.0) {
+        cfg->power_budget_w = budget->valuedouble;
+        cfg->has_power_budget = true;
+    }
+
+    // 功率模型：瓦数须为有限正数，曲线指数限制在 0.5-4
+    cJSON *model = cJSON_GetObjectItem(json, "power_model");
+    if (cJSON_IsObject(model)) {
+        cJSON *item = cJSON_GetObjectItem(model, "fan_w");
+        if (is_finite_number(item) && item->valuedouble > 0.0) {
+            cfg->fan_power_w = item->valuedouble;
+            cfg->has_fan_power_w = true;
+        }
+        item = cJSON_GetObjectItem(model, "fan_exp");
+        if (is_finite_number(item) && item->valuedouble >= 0.5 && item->valuedouble <= 4.0) {
+            cfg->fan_power_exp = item->valuedouble;
+            cfg->has_fan_power_exp = true;
+        }
+        item = cJSON_GetObjectItem(model, "tec_w");
+        if (is_finite_number(item) && item->valuedouble > 0.0) {
+            cfg->tec_power_w = item->valuedouble;
+            cfg->has_tec_power_w = true;
+        }
+        item = cJSON_GetObjectItem(model, "tec_exp");
+        if (is_finite_number(item) && item->valuedouble >= 0.5 && item->valuedouble <= 4.0) {
+            cfg->tec_power_exp = item->valuedouble;
+            cfg->has_tec_power_exp = true;
+        }
+    }
+
+    // 传感器故障降级：外推时限 0~3600 秒（0 表示确认故障后直接失效安全），风扇占空比 40~100
+    cJSON *sensor = cJSON_GetObjectItem(json, "sensor");
+    if (cJSON_IsObject(sensor)) {
+        cJSON *item = cJSON_GetObjectItem(sensor, "holdover_s");
+        if (cJSON_IsNumber(item)) {
+            cfg->has_holdover_s = item->valuedouble >= 0.0 && item->valuedouble <= MQTT_HOLDOVER_MAX_S;
+            if (cfg->has_holdover_s) cfg->holdover_s = (uint32_t)item->valuedouble;
+            else ESP_LOGW(TAG, "sensor.holdover_s 超出范围，忽略");
+        }
+        bool fan_valid = false;
+        if (parse_speed(cJSON_GetObjectItem(sensor, "failsafe_fan"), &cfg->failsafe_fan, &fan_valid)) {
+            fan_valid = fan_valid && cfg->failsafe_fan >= MQTT_FAILSAFE_FAN_MIN;
+            cfg->has_failsafe_fan = fan_valid;
+            if (!fan_valid) ESP_LOGW(TAG, "sensor.failsafe_fan 超出范围，忽略");
+        }
+    }
+
+    // 信任锚与指纹：空串恢复内置证书包 / 取消指纹
+    cJSON *tls_ca = cJSON_GetObjectItem(json, "tls_ca");
+    if (cJSON_IsString(tls_ca)) {
+        cfg->has_tls = mqtt_tls_set_ca(tls_ca->valuestring);
+    }
+    cJSON *tls_pin = cJSON_GetObjectItem(json, "tls_pin");
+    if (cJSON_IsString(tls_pin)) {
+        cfg->has_tls = mqtt_tls_set_pin(tls_pin->valuestring);
+    }
+    if ((cJSON_IsString(tls_ca) || cJSON_IsString(tls_pin)) && !cfg->has_tls) {
+        metrics_inc(&m_parse_err);
+        ESP_LOGW(TAG, "TLS 证书或指纹无效，保持原设置");
+    }
+
+    cJSON *brokers = cJSON_GetObjectItem(json, "brokers");
+    if (cJSON_IsArray(brokers)) {
+        cfg->has_brokers = mqtt_stage_brokers(brokers);
+        if (!cfg->has_brokers) {
+            metrics_inc(&m_parse_err);
+            ESP_LOGW(TAG, "broker 列表无效，保持原列表");
+        }
+    }
+    
+    json_release(json);
+    return true;
+}
+
+/**
+ * @brief 解析历史查询 {"id":"q1","field":"temp","from_s":3600,"to_s":0,"points":200}
+ */
+bool mqtt_comm_parse_history_request(const char* data, int data_len, mqtt_history_request_t* req) {
+    memset(req, 0, sizeof(*req));
+    strcpy(req->field, "temp");
+    req->from_s = 3600;
+    req->max_points = 200;
+
+    cJSON *json = json_parse(data, data_len);
+    if (json == NULL) {
+        metrics_inc(&m_parse_err);
+        ESP_LOGE(TAG, "JSON解析失败: %.*s", LOG_LEN(data_len), data);
+        return false;
+    }
+
+    copy_corr_id(cJSON_GetObjectItem(json, "id"), req->id, sizeof(req->id));
+    cJSON *item = cJSON_GetObjectItem(json, "field");
+    if (cJSON_IsString(item)) {
+        strlcpy(req->field, item->valuestring, sizeof(req->field));
+    }
+    parse_u32(cJSON_GetObjectItem(json, "from_s"), &req->from_s);
+    parse_u32(cJSON_GetObjectItem(json, "to_s"), &req->to_s);
+    item = cJSON_GetObjectItem(json, "points");
+    if (cJSON_IsNumber(item) && item->valueint > 0) {
+        req->max_points = item->valueint > UINT16_MAX ? UINT16_MAX : item->valueint;
+    }
+
+    json_release(json);
+    return true;
+}
+
+/**
+ * @brief 解析 OTA 请求 {"url":"...","sha256":"...","compressed":true}
+ */
+bool mqtt_comm_parse_ota_request(const char* data, int data_len, mqtt_ota_request_t* req) {
+    memset(req, 0, sizeof(*req));
+
+    cJSON *json = json_parse(data, data_len);
+    if (json == NULL) {
+        metrics_inc(&m_parse_err);
+        ESP_LOGE(TAG, "JSON解析失败: %.*s", LOG_LEN(data_len), data);
+        return false;
+    }
+
+    bool ok = true;
+    cJSON *item = cJSON_GetObjectItem(json, "url");
+    if (cJSON_IsString(item) && strlen(item->valuestring) < sizeof(req->url)) {
+        strlcpy(req->url, item->valuestring, sizeof(req->url));
+    } else {
+        ok = false;
+    }
+    item = cJSON_GetObjectItem(json, "sha256");
+    if (cJSON_IsString(item) && strlen(item->valuestring) == sizeof(req->sha256) - 1) {
+        strlcpy(req->sha256, item->valuestring, sizeof(req->sha256));
+    } else {
+        ok = false;
+    }
+    req->compressed = cJSON_IsTrue(cJSON_GetObjectItem(json, "compressed"));
+
+    json_release(json);
+    if (!ok) {
+        metrics_inc(&m_parse_err);
+        ESP_LOGE(TAG, "OTA 请求缺少 url/sha256");
+    }
+    return ok;
+}
+
+/**
+ * @brief 发布并统计成功/失败次数
+ */
+static int mqtt_comm_publish_raw(esp_mqtt_client_handle_t client, const char* topic,
+                                 const char* data, int len, int qos, int retain) {
+    TRACE_BEGIN(t_publish);
+    int msg_id = esp_mqtt_client_publish(client, topic, data, len, qos, retain);
+    TRACE_END(t_publish);
+    metrics_inc(msg_id < 0 ? &m_publish_fail : &m_publish);
+    return msg_id;
+}
+
+static const char* ack_result_name(mqtt_ack_result_t result) {
+    switch (result) {
+        case MQTT_ACK_OK:       return "ok";
+        case MQTT_ACK_ACCEPTED: return "accepted";
+        case MQTT_ACK_REJECTED: return "rejected";
+        default:                return "invalid";
+    }
+}
+
+int mqtt_comm_format_ack(const mqtt_command_t* cmd, const mqtt_command_ack_t* ack, int64_t now_us,
+                         char* buf, size_t size) {
+    int len = snprintf(buf, size, "{\"ok\":%s,\"id\":\"%s\",\"result\":\"%s\"",
+                       ack->result <= MQTT_ACK_ACCEPTED ? "true" : "false", cmd->id, ack_result_name(ack->result));
+    if (ack->reason && len > 0 && len < (int)size) {
+        len += snprintf(buf + len, size - len, ",\"reason\":\"%s\"", ack->reason);
+    }
+    if (ack->actuated_us && cmd->rx_us && len > 0 && len < (int)size) {
+        len += snprintf(buf + len, size - len, ",\"fan\":%u,\"actuation_us\":%lld",
+                        ack->fan_duty, (long long)(ack->actuated_us - cmd->rx_us));
+    }
+    if (cmd->rx_us && len > 0 && len < (int)size) {
+        len += snprintf(buf + len, size - len, ",\"handled_us\":%lld", (long long)(now_us - cmd->rx_us));
+    }
+    if (len > 0 && len < (int)size) len += snprintf(buf + len, size - len, "}");
+    return len > 0 && len < (int)size ? len : -1;
+}
+
+/**
+ * @brief 处理MQTT命令消息；带关联ID时在 <id>/command/ack 发布回执（QoS1，非保留）
+ *        MQTT 3.1.1 没有 response topic/correlation data，关联ID走 JSON 字段
+ */
+static void mqtt_handle_command(const char* data, int data_len) {
+    mqtt_command_t cmd;
+    if (!mqtt_comm_parse_command(data, data_len, &cmd) || !command_callback) return;
+    cmd.rx_us = s_rx_us;
+
+    mqtt_command_ack_t ack = { .result = MQTT_ACK_OK };
+    command_callback(&cmd, &ack);
+    int64_t done_us = esp_timer_get_time();
+
+    if (ack.actuated_us) metrics_observe(&m_cmd_actuation_us, (uint32_t)(ack.actuated_us - cmd.rx_us));
+    if (ack.result >= MQTT_ACK_REJECTED) {
+        metrics_inc(&m_cmd_rejected);
+        ESP_LOGW(TAG, "命令未执行: %s", ack.reason ? ack.reason : ack_result_name(ack.result));
+    }
+    if (cmd.id[0] == '\0' || !s_rx_client) return;
+
+    char json[MQTT_ACK_MAX];
+    int len = mqtt_comm_format_ack(&cmd, &ack, done_us, json, sizeof(json));
+    if (len > 0) mqtt_comm_publish_raw(s_rx_client, s_topic_cmd_ack, json, len, 1, 0);
+}
+
+/**
+ * @brief 处理MQTT配置消息
+ */
+static void mqtt_handle_config(const char* data, int data_len) {
+    mqtt_config_t cfg;
+    if (mqtt_comm_parse_config(data, data_len, &cfg) && config_callback) {
+        config_callback(&cfg);
+    }
+}
+
+/**
+ * @brief 处理历史查询消息
+ */
+static void mqtt_handle_history(const char* data, int data_len) {
+    mqtt_history_request_t req;
+    if (mqtt_comm_parse_history_request(data, data_len, &req) && history_callback) {
+        history_callback(&req);
+    }
+}
+
+/**
+ * @brief 处理 OTA 请求
+ */
+static void mqtt_handle_ota(const char* data, int data_len) {
+    mqtt_ota_request_t req;
+    if (mqtt_comm_parse_ota_request(data, data_len, &req) && ota_callback) {
+        ota_callback(&req);
+    }
+}
+
+/**
+ * @brief 处理期望状态：{"version":N,"state":{"mode":..,"speed":..,"temp_threshold":..,"max_speed":..}}
+ *        版本号不大于已接受版本的请求视为重复或过期，直接丢弃
+ */
+static void mqtt_handle_desired(const char* data, int data_len) {
+    cJSON *json = json_parse(data, data_len);
     if (json == NULL) {
-        ESP_LOGE(TAG, "JSON解析失败: %s", json_string);
-        free(json_string);
+        metrics_inc(&m_parse_err);
+        ESP_LOGE(TAG, "期望状态解析失败: %.*s", LOG_LEN(data_len), data);
+        return;
+    }
+
+    cJSON *version = cJSON_GetObjectItem(json, "version");
+    cJSON *state = cJSON_GetObjectItem(json, "state");
+    // 超出 uint32_t 的版本号会让之后的请求全部被当作过期，直接拒绝
+    if (!cJSON_IsNumber(version) || !(version->valuedouble >= 1 && version->valuedouble <= UINT32_MAX) ||
+        !cJSON_IsObject(state)) {
+        metrics_inc(&m_parse_err);
+        ESP_LOGW(TAG, "期望状态缺少 version/state");
+        json_release(json);
+        return;
+    }
+
+    xSemaphoreTake(s_shadow_lock, portMAX_DELAY);
+    uint32_t desired_version = (uint32_t)version->valuedouble;
+    shadow_desired_result_t result = shadow_accept_desired(&s_shadow, desired_version);
+    xSemaphoreGive(s_shadow_lock);
+    if (result == SHADOW_DESIRED_ACCEPTED) {
+        // 持久化已接受的版本号，重启后仍能拒绝过期请求
+        nvs_handle_t nvs;
+        if (nvs_open("storage", NVS_READWRITE, &nvs) == ESP_OK) {
+            nvs_set_u32(nvs, "shadow_dver", desired_version);
+            nvs_commit(nvs);
+            nvs_close(nvs);
+        }
+    } else {
+        ESP_LOGW(TAG, "丢弃%s的期望状态: version=%lu",
+                 result == SHADOW_DESIRED_DUPLICATE ? "重复" : "过期", (unsigned long)desired_version);
+        json_release(json);
         return;
     }
     
+    // 字段与 command/config 主题相同，先应用配置再应用命令；超出范围的字段忽略
     mqtt_config_t cfg = {0};
-    
-    cJSON *temp_threshold = cJSON_GetObjectItem(json, "temp_threshold");
-    if (cJSON_IsNumber(temp_threshold)) {
-        cfg.temp_threshold = temp_threshold->valuedouble;
+    cJSON *item = cJSON_GetObjectItem(state, "temp_threshold");
+    if (cJSON_IsNumber(item) && item->valuedouble >= MQTT_THRESHOLD_MIN && item->valuedouble <= MQTT_THRESHOLD_MAX) {
+        cfg.temp_threshold = item->valuedouble;
         cfg.has_temp_threshold = true;
     }
-    
-    cJSON *max_speed = cJSON_GetObjectItem(json, "max_speed");
-    if (cJSON_IsNumber(max_speed)) {
-        cfg.max_speed = max_speed->valueint;
-        cfg.has_max_speed = true;
+    bool max_valid = false;
+    if (parse_speed(cJSON_GetObjectItem(state, "max_speed"), &cfg.max_speed, &max_valid)) {
+        cfg.has_max_speed = max_valid;
     }
-    
-    if (config_callback) {
+
+    mqtt_command_t cmd = {0};
+    item = cJSON_GetObjectItem(state, "mode");
+    if (cJSON_IsString(item)) {
+        if (strcmp(item->valuestring, "auto") == 0) {
+            cmd.mode = MQTT_MODE_AUTO;
+            cmd.has_mode = true;
+        } else if (strcmp(item->valuestring, "manual") == 0) {
+            cmd.mode = MQTT_MODE_MANUAL;
+            cmd.has_mode = true;
+        }
+    }
+    bool speed_valid = false;
+    if (parse_speed(cJSON_GetObjectItem(state, "speed"), &cmd.speed, &speed_valid)) {
+        cmd.has_speed = speed_valid;
+        if (!speed_valid) ESP_LOGW(TAG, "期望状态 speed 超出范围，忽略");
+    }
+    // 回调前归还内存池，回调中可能再次解析
+    json_release(json);
+
+    if ((cfg.has_temp_threshold || cfg.has_max_speed) && config_callback) {
         config_callback(&cfg);
     }
-    
-    cJSON_Delete(json);
-    free(json_string);
+    if ((cmd.has_mode || cmd.has_speed) && command_callback) {
+        // 期望状态的结果由 state/delta 体现，不单独回执
+        cmd.rx_us = s_rx_us;
+        mqtt_command_ack_t ack = { .result = MQTT_ACK_OK };
+        command_callback(&cmd, &ack);
+    }
+}
+
+/**
+ * @brief 连接建立后发布出生消息和完整影子（均为保留消息）
+ */
+static void mqtt_publish_birth(esp_mqtt_client_handle_t client) {
+    esp_mqtt_client_publish(client, s_topic_availability, "online", 0, 1, 1);
+
+    char doc[MQTT_SHADOW_MAX];
+    int len = -1;
+    xSemaphoreTake(s_shadow_lock, portMAX_DELAY);
+    if (s_shadow.has_reported) {
+        len = shadow_format(&s_shadow, SHADOW_FIELD_ALL, doc, sizeof(doc));
+    }
+    xSemaphoreGive(s_shadow_lock);
+    if (len > 0) {
+        esp_mqtt_client_publish(client, s_topic_state, doc, len, 1, 1);
+    }
+}
+
+/**
+ * @brief 添加路由
+ */
+static void mqtt_route_add(const char* topic, void (*handler)(const char*, int)) {
+    if (s_route_count >= MQTT_MAX_ROUTES) {
+        ESP_LOGE(TAG, "路由表已满，忽略主题: %s", topic);
+        return;
+    }
+    mqtt_route_t* route = &s_routes[s_route_count++];
+    strlcpy(route->topic, topic, sizeof(route->topic));
+    route->handler = handler;
+}
+
+/**
+ * @brief 按主题精确匹配分发消息（主题长度必须一致，不做前缀匹配）
+ */
+static void mqtt_dispatch(const char* topic, int topic_len, const char* data, int data_len) {
+    for (int i = 0; i < s_route_count; i++) {
+        const mqtt_route_t* route = &s_routes[i];
+        if (strlen(route->topic) == (size_t)topic_len &&
+            memcmp(route->topic, topic, topic_len) == 0) {
+            route->handler(data, data_len);
+            return;
+        }
+    }
+    metrics_inc(&m_unrouted);
+    ESP_LOGW(TAG, "未匹配的主题: %.*s", topic_len, topic);
+}
+
+/**
+ * @brief 由 WiFi STA MAC 生成设备ID，并生成设备主题和组主题
+ */
+static void mqtt_build_topics(void) {
+    uint8_t mac[6] = {0};
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    snprintf(s_device_id, sizeof(s_device_id), "fan-%02x%02x%02x%02x%02x%02x",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
+    char topic[MQTT_TOPIC_MAX];
+    snprintf(s_topic_status, sizeof(s_topic_status), MQTT_TOPIC_PREFIX "/%s/status", s_device_id);
+    snprintf(s_topic_telemetry, sizeof(s_topic_telemetry), MQTT_TOPIC_PREFIX "/%s/telemetry", s_device_id);
+    snprintf(s_topic_diag, sizeof(s_topic_diag), MQTT_TOPIC_PREFIX "/%s/diagnostics", s_device_id);
+    snprintf(s_topic_state, sizeof(s_topic_state), MQTT_TOPIC_PREFIX "/%s/state", s_device_id);
+    snprintf(s_topic_state_delta, sizeof(s_topic_state_delta), MQTT_TOPIC_PREFIX "/%s/state/delta", s_device_id);
+    snprintf(s_topic_availability, sizeof(s_topic_availability), MQTT_TOPIC_PREFIX "/%s/availability", s_device_id);
+    snprintf(s_topic_autotune, sizeof(s_topic_autotune), MQTT_TOPIC_PREFIX "/%s/autotune", s_device_id);
+    snprintf(s_topic_history, sizeof(s_topic_history), MQTT_TOPIC_PREFIX "/%s/history", s_device_id);
+    snprintf(s_topic_latency, sizeof(s_topic_latency), MQTT_TOPIC_PREFIX "/%s/diagnostics/latency", s_device_id);
+    snprintf(s_topic_trace, sizeof(s_topic_trace), MQTT_TOPIC_PREFIX "/%s/diagnostics/trace", s_device_id);
+    snprintf(s_topic_ota_status, sizeof(s_topic_ota_status), MQTT_TOPIC_PREFIX "/%s/ota/status", s_device_id);
+    snprintf(s_topic_ping, sizeof(s_topic_ping), MQTT_TOPIC_PREFIX "/%s/diagnostics/ping", s_device_id);
+    snprintf(s_topic_cmd_ack, sizeof(s_topic_cmd_ack), MQTT_TOPIC_PREFIX "/%s/command/ack", s_device_id);
+    snprintf(s_topic_sensor, sizeof(s_topic_sensor), MQTT_TOPIC_PREFIX "/%s/sensor", s_device_id);
+
+    s_route_count = 0;
+    snprintf(topic, sizeof(topic), MQTT_TOPIC_PREFIX "/%s/command", s_device_id);
+    mqtt_route_add(topic, mqtt_handle_command);
+    snprintf(topic, sizeof(topic), MQTT_TOPIC_PREFIX "/%s/config", s_device_id);
+    mqtt_route_add(topic, mqtt_handle_config);
+    snprintf(topic, sizeof(topic), MQTT_TOPIC_PREFIX "/%s/state/desired", s_device_id);
+    mqtt_route_add(topic, mqtt_handle_desired);
+    snprintf(topic, sizeof(topic), MQTT_TOPIC_PREFIX "/%s/history/get", s_device_id);
+    mqtt_route_add(topic, mqtt_handle_history);
+    snprintf(topic, sizeof(topic), MQTT_TOPIC_PREFIX "/%s/ota", s_device_id);
+    mqtt_route_add(topic, mqtt_handle_ota);
+
+    // 可选的组主题：NVS storage/mqtt_group，用于按机柜/区域批量下发
+    nvs_handle_t nvs;
+    s_group[0] = '\0';
+    if (nvs_open("storage", NVS_READONLY, &nvs) == ESP_OK) {
+        size_t len = sizeof(s_group);
+        if (nvs_get_str(nvs, "mqtt_group", s_group, &len) != ESP_OK) {
+            s_group[0] = '\0';
+        }
+        nvs_close(nvs);
+    }
+    if (s_group[0]) {
+        snprintf(topic, sizeof(topic), MQTT_TOPIC_PREFIX "/group/%s/command", s_group);
+        mqtt_route_add(topic, mqtt_handle_command);
+        snprintf(topic, sizeof(topic), MQTT_TOPIC_PREFIX "/group/%s/config", s_group);
+        mqtt_route_add(topic, mqtt_handle_config);
+    }
+    ESP_LOGI(TAG, "设备ID: %s, 组: %s", s_device_id, s_group[0] ? s_group : "(无)");
+}
+
+static int mqtt_backlog_flush(esp_mqtt_client_handle_t client);
+static bool mqtt_backlog_settle(int msg_id, bool acked);
+
+/**
+ * @brief 连接前选择 broker：地址或凭据变化时更新客户端配置，
+ *        并按本次尝试失败后的退避设置重连间隔（esp-mqtt 在断开时读取该值）
+ */
+static void mqtt_broker_prepare(esp_mqtt_client_handle_t client) {
+    uint64_t now_ms = esp_timer_get_time() / 1000;
+    broker_entry_t entry;
+    portENTER_CRITICAL(&s_broker_mux);
+    int index = broker_select_begin(&s_broker, now_ms);
+    entry = s_broker.list.entry[index];
+    uint32_t wait_ms = broker_select_retry_wait(&s_broker, now_ms);
+    s_broker_reload = false;
+    portEXIT_CRITICAL(&s_broker_mux);
+    s_switching = false;
+
+    bool changed = memcmp(&entry, &s_broker_entry, sizeof(entry)) != 0;
+    if (!changed && s_mqtt_cfg.network.reconnect_timeout_ms == (int)wait_ms) return;
+    if (changed) {
+        if (s_broker_entry.uri[0]) metrics_inc(&m_broker_switches);
+        s_broker_entry = entry;
+        s_mqtt_cfg.broker.address.uri = s_broker_entry.uri;
+        s_mqtt_cfg.credentials.username = s_broker_entry.username[0] ? s_broker_entry.username : NULL;
+        s_mqtt_cfg.credentials.authentication.password =
+            s_broker_entry.password[0] ? s_broker_entry.password : NULL;
+        mqtt_tls_use(s_transport, broker_uri_is_tls(s_broker_entry.uri));
+        TRACE_INSTANT(t_broker_switch, index);
+        ESP_LOGI(TAG, "连接 broker %d: %s", index, s_broker_entry.uri);
+    }
+    s_mqtt_cfg.network.reconnect_timeout_ms = wait_ms;
+    esp_mqtt_set_config(client, &s_mqtt_cfg);
 }
 
 // MQTT事件处理器
@@ -121,24 +938,81 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     esp_mqtt_client_handle_t client = event->client;
     
     switch ((esp_mqtt_event_id_t)event_id) {
-        case MQTT_EVENT_CONNECTED:
-            ESP_LOGI(TAG, "MQTT已连接");
-            esp_mqtt_client_subscribe(client, MQTT_TOPIC_COMMAND, 1);
-            esp_mqtt_client_subscribe(client, MQTT_TOPIC_CONFIG, 1);
+        case MQTT_EVENT_BEFORE_CONNECT:
+            mqtt_broker_prepare(client);
+            break;
+
+        case MQTT_EVENT_CONNECTED: {
+            uint64_t now_ms = esp_timer_get_time() / 1000;
+            portENTER_CRITICAL(&s_broker_mux);
+            uint64_t connect_ms = now_ms - s_broker.attempt_ms;
+            broker_select_connected(&s_broker, now_ms);
+            int index = s_broker.active;
+            portEXIT_CRITICAL(&s_broker_mux);
+            ESP_LOGI(TAG, "MQTT已连接 broker %d，耗时 %llums", index, (unsigned long long)connect_ms);
+            metrics_inc(&m_connects);
+            metrics_observe(&m_connect_ms, (uint32_t)connect_ms);
+            TRACE_INSTANT(t_connected, index);
+            s_connected = true;
+            s_probe_msg_id = 0;
+            s_probe_sent_us = esp_timer_get_time();
+            // 连接中断后的重拨间隔恢复为最短
+            if (s_mqtt_cfg.network.reconnect_timeout_ms != BROKER_FAILOVER_MS) {
+                s_mqtt_cfg.network.reconnect_timeout_ms = BROKER_FAILOVER_MS;
+                esp_mqtt_set_config(client, &s_mqtt_cfg);
+            }
+            for (int i = 0; i < s_route_count; i++) {
+                esp_mqtt_client_subscribe(client, s_routes[i].topic, 1);
+            }
+            mqtt_publish_birth(client);
+            int resent = mqtt_backlog_flush(client);
+            if (resent) ESP_LOGI(TAG, "补发断线期间遥测 %d 条", resent);
             break;
+        }
             
-        case MQTT_EVENT_DISCONNECTED:
-            ESP_LOGI(TAG, "MQTT已断开连接");
+        case MQTT_EVENT_DISCONNECTED: {
+            metrics_inc(&m_disconnects);
+            TRACE_INSTANT(t_disconnected, 0);
+            s_connected = false;
+            s_probe_msg_id = 0;
+            // 主动切换时 broker 状态已在发起处更新
+            if (s_switching) {
+                ESP_LOGI(TAG, "MQTT已断开，切换 broker");
+                break;
+            }
+            portENTER_CRITICAL(&s_broker_mux);
+            int index = s_broker.active;
+            uint32_t wait_ms = broker_select_failed(&s_broker, esp_timer_get_time() / 1000);
+            portEXIT_CRITICAL(&s_broker_mux);
+            ESP_LOGI(TAG, "MQTT已断开 broker %d，%lums 后重连", index, (unsigned long)wait_ms);
+            break;
+        }
+
+        case MQTT_EVENT_PUBLISHED:
+            if (s_probe_msg_id != 0 && event->msg_id == s_probe_msg_id) {
+                uint32_t rtt_ms = (uint32_t)((esp_timer_get_time() - s_probe_sent_us) / 1000);
+                s_probe_msg_id = 0;
+                portENTER_CRITICAL(&s_broker_mux);
+                broker_select_rtt(&s_broker, rtt_ms);
+                portEXIT_CRITICAL(&s_broker_mux);
+                metrics_observe(&m_rtt_ms, rtt_ms);
+            } else {
+                mqtt_backlog_settle(event->msg_id, true);
+            }
+            break;
+
+        case MQTT_EVENT_DELETED:
+            // 发件箱中超时未确认被丢弃：遥测留在暂存区，下次补发
+            if (mqtt_backlog_settle(event->msg_id, false) && s_connected) mqtt_backlog_flush(client);
             break;
             
         case MQTT_EVENT_DATA:
             ESP_LOGI(TAG, "收到MQTT消息: %.*s", event->topic_len, event->topic);
-            
-            if (strncmp(event->topic, MQTT_TOPIC_COMMAND, event->topic_len) == 0) {
-                mqtt_handle_command(event->data, event->data_len);
-            } else if (strncmp(event->topic, MQTT_TOPIC_CONFIG, event->topic_len) == 0) {
-                mqtt_handle_config(event->data, event->data_len);
-            }
+            TRACE_BEGIN(t_rx);
+            s_rx_client = event->client;
+            s_rx_us = esp_timer_get_time();
+            mqtt_dispatch(event->topic, event->topic_len, event->data, event->data_len);
+            TRACE_END(t_rx);
             break;
             
         default:
@@ -146,21 +1020,265 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     }
 }
 
+/**
+ * @brief 暂存一条待发送的遥测，满时丢弃最旧的一条（无论是否已发出）；
+ *        最旧的一条正在发布时丢弃新的这条
+ */
+static void mqtt_backlog_push(const char* data, int len) {
+    if (len <= 0 || len > MQTT_TELEMETRY_MAX) return;
+    xSemaphoreTake(s_backlog_lock, portMAX_DELAY);
+    if (s_backlog_count == MQTT_BACKLOG_SLOTS) {
+        metrics_inc(&m_backlog_dropped);
+        if (s_backlog[s_backlog_head].msg_id == MQTT_BACKLOG_SENDING) {
+            xSemaphoreGive(s_backlog_lock);
+            return;
+        }
+        s_backlog_head = (s_backlog_head + 1) % MQTT_BACKLOG_SLOTS;
+        s_backlog_count--;
+    }
+    mqtt_backlog_slot_t* slot = &s_backlog[(s_backlog_head + s_backlog_count) % MQTT_BACKLOG_SLOTS];
+    memcpy(slot->data, data, len);
+    slot->len = len;
+    slot->msg_id = MQTT_BACKLOG_UNSENT;
+    s_backlog_count++;
+    xSemaphoreGive(s_backlog_lock);
+}
+
+/**
+ * @brief 持锁时：标记条目状态，并从头部移除已确认的条目
+ */
+static void mqtt_backlog_mark(mqtt_backlog_slot_t* slot, bool acked) {
+    slot->msg_id = acked ? MQTT_BACKLOG_ACKED : MQTT_BACKLOG_UNSENT;
+    while (s_backlog_count > 0 && s_backlog[s_backlog_head].msg_id == MQTT_BACKLOG_ACKED) {
+        s_backlog_head = (s_backlog_head + 1) % MQTT_BACKLOG_SLOTS;
+        s_backlog_count--;
+    }
+}
+
+/**
+ * @brief 按原顺序以 QoS1 发出尚未交给客户端的遥测；已发出的由 esp-mqtt 发件箱负责重传，
+ *        条目保留到 PUBACK（切换 broker 时发件箱随客户端保留，由新连接重传）。
+ *        逐条在锁内认领、锁外发布，可在上报任务与 MQTT 任务的事件回调中同时调用
+ * @return 本次发出的条数
+ */
+static int mqtt_backlog_flush(esp_mqtt_client_handle_t client) {
+    int sent = 0;
+    for (;;) {
+        xSemaphoreTake(s_backlog_lock, portMAX_DELAY);
+        mqtt_backlog_slot_t* slot = NULL;
+        for (int i = 0; i < s_backlog_count && !slot; i++) {
+            mqtt_backlog_slot_t* s = &s_backlog[(s_backlog_head + i) % MQTT_BACKLOG_SLOTS];
+            if (s->msg_id == MQTT_BACKLOG_UNSENT) slot = s;
+        }
+        if (slot) {
+            slot->msg_id = MQTT_BACKLOG_SENDING;
+            s_backlog_sending++;
+        }
+        xSemaphoreGive(s_backlog_lock);
+        if (!slot) break;
+
+        int msg_id = mqtt_comm_publish_raw(client, s_topic_telemetry, slot->data, slot->len, 1, 0);
+
+        xSemaphoreTake(s_backlog_lock, portMAX_DELAY);
+        s_backlog_sending--;
+        slot->msg_id = msg_id > 0 ? msg_id : MQTT_BACKLOG_UNSENT;
+        for (int i = 0; i < MQTT_BACKLOG_EARLY && msg_id > 0; i++) {
+            if (s_backlog_early[i].msg_id == msg_id) {
+                s_backlog_early[i].msg_id = 0;
+                mqtt_backlog_mark(slot, s_backlog_early[i].acked);
+                break;
+            }
+        }
+        xSemaphoreGive(s_backlog_lock);
+        if (msg_id <= 0) break;
+        sent++;
+    }
+    return sent;
+}
+
+/**
+ * @brief 结算一条已发出的遥测：acked 时标记确认并从头部移除已确认的条目，
+ *        否则（发件箱丢弃）退回待发送。只持暂存锁，不会等待正在进行的发布
+ * @return msg_id 属于暂存区中的遥测
+ */
+static bool mqtt_backlog_settle(int msg_id, bool acked) {
+    if (msg_id <= 0) return false;
+    xSemaphoreTake(s_backlog_lock, portMAX_DELAY);
+    bool found = false;
+    for (int i = 0; i < s_backlog_count && !found; i++) {
+        mqtt_backlog_slot_t* slot = &s_backlog[(s_backlog_head + i) % MQTT_BACKLOG_SLOTS];
+        if (slot->msg_id == msg_id) {
+            mqtt_backlog_mark(slot, acked);
+            found = true;
+        }
+    }
+    if (!found && s_backlog_sending > 0) {
+        // 可能是正在发布、尚未记下 ID 的那条
+        s_backlog_early[s_backlog_early_next] = (mqtt_backlog_early_t){ .msg_id = msg_id, .acked = acked };
+        s_backlog_early_next = (s_backlog_early_next + 1) % MQTT_BACKLOG_EARLY;
+    }
+    xSemaphoreGive(s_backlog_lock);
+    return found;
+}
+
+/**
+ * @brief 主动断开并立即重连；重连前 MQTT_EVENT_BEFORE_CONNECT 按 broker 状态选择目标
+ * @param planned true=回切或列表更新（旧 broker 正常，先把 availability 置为 offline）
+ */
+static void mqtt_broker_reconnect(esp_mqtt_client_handle_t client, bool planned) {
+    uint64_t now_ms = esp_timer_get_time() / 1000;
+    portENTER_CRITICAL(&s_broker_mux);
+    if (planned) {
+        broker_select_release(&s_broker);
+    } else {
+        broker_select_failed(&s_broker, now_ms);
+    }
+    portEXIT_CRITICAL(&s_broker_mux);
+
+    if (planned) {
+        // 正常断开不会触发遗嘱，迁走前自行把旧 broker 上的保留 availability 置为 offline
+        esp_mqtt_client_publish(client, s_topic_availability, "offline", 0, 1, 1);
+    }
+    s_switching = true;
+    s_connected = false;
+    esp_mqtt_client_disconnect(client);
+    esp_mqtt_client_reconnect(client);
+}
+
+/**
+ * @brief 回切探测任务：确认首选 broker 已恢复，只凭切走前的历史得分会切回仍不可达的 broker
+ *        握手可能阻塞到超时，因此不在上报任务中进行；回切由下一次 mqtt_comm_service 完成
+ */
+static void failback_probe_task(void* arg) {
+    (void)arg;
+    bool ok = mqtt_tls_probe(s_failback_probe_entry.uri, MQTT_FAILBACK_PROBE_TIMEOUT_MS);
+    ESP_LOGI(TAG, "探测 broker %d: %s", s_failback_probe_index, ok ? "可达" : "不可达");
+    uint64_t now_ms = esp_timer_get_time() / 1000;
+    portENTER_CRITICAL(&s_broker_mux);
+    // 探测期间列表可能已更新，下标不再指向同一个 broker
+    if (!s_broker_reload &&
+        strcmp(s_broker.list.entry[s_failback_probe_index].uri, s_failback_probe_entry.uri) == 0) {
+        broker_select_probe_result(&s_broker, s_failback_probe_index, ok, now_ms);
+    }
+    portEXIT_CRITICAL(&s_broker_mux);
+
+    uint32_t hwm = (uint32_t)uxTaskGetStackHighWaterMark(NULL);
+    if (s_failback_probe_hwm == 0 || hwm < s_failback_probe_hwm) s_failback_probe_hwm = hwm;
+    s_failback_probing = false;
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 周期服务（上报任务调用）：发起往返延迟探测，探测超时强制重连，
+ *        满足回切条件或列表更新时切换 broker；回切探测交给探测任务，不在此阻塞
+ */
+void mqtt_comm_service(esp_mqtt_client_handle_t client) {
+    if (!client || !s_connected) return;
+    int64_t now_us = esp_timer_get_time();
+
+    if (s_probe_msg_id != 0) {
+        // PUBACK 迟迟不到：TCP 连接可能已半开，keepalive 要 1.5 倍周期才能发现
+        if (now_us - s_probe_sent_us > (int64_t)MQTT_PROBE_TIMEOUT_MS * 1000) {
+            metrics_inc(&m_probe_lost);
+            ESP_LOGW(TAG, "延迟探测超时，重连");
+            mqtt_broker_reconnect(client, false);
+            return;
+        }
+    } else if (now_us - s_probe_sent_us >= (int64_t)s_probe_period_ms * 1000) {
+        char payload[24];
+        int len = snprintf(payload, sizeof(payload), "%lld", (long long)(now_us / 1000));
+        s_probe_sent_us = now_us;
+        int msg_id = mqtt_comm_publish_raw(client, s_topic_ping, payload, len, 1, 0);
+        if (msg_id > 0) s_probe_msg_id = msg_id;
+    }
+
+    portENTER_CRITICAL(&s_broker_mux);
+    bool reload = s_broker_reload;
+    s_broker_reload = false;
+    int target = broker_select_failback(&s_broker, now_us / 1000);
+    int probe = reload || target >= 0 || s_failback_probing ? -1
+                                                             : broker_select_probe_due(&s_broker, now_us / 1000);
+    if (probe >= 0) {
+        s_failback_probe_index = probe;
+        s_failback_probe_entry = s_broker.list.entry[probe];
+        s_failback_probing = true;
+    }
+    portEXIT_CRITICAL(&s_broker_mux);
+
+    if (probe >= 0 && xTaskCreatePinnedToCore(failback_probe_task, "mqtt_probe", MQTT_PROBE_TASK_STACK, NULL,
+                                              MQTT_PROBE_TASK_PRIO, NULL, MQTT_PROBE_TASK_CORE) != pdPASS) {
+        ESP_LOGW(TAG, "无法创建 broker 探测任务");
+        s_failback_probing = false;
+    }
+    if (reload || target >= 0) {
+        if (target >= 0) ESP_LOGI(TAG, "回切到 broker %d", target);
+        mqtt_broker_reconnect(client, true);
+    }
+}
+
 /**
  * @brief 初始化MQTT客户端
  */
 esp_mqtt_client_handle_t mqtt_comm_init(void) {
-    esp_mqtt_client_config_t mqtt_cfg = {
-        .broker.address.uri = "mqtt://nas.phenosolar.com:1883",
-        .credentials.username = "admin",
-        .credentials.authentication.password = "admin",
-        .session.keepalive = 60,
+    json_arena_init();
+    mqtt_build_topics();
+    shadow_init(&s_shadow);
+    s_shadow_lock = xSemaphoreCreateMutex();
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READONLY, &nvs) == ESP_OK) {
+        nvs_get_u32(nvs, "shadow_dver", &s_shadow.desired_version);
+        uint32_t limit = 0;
+        nvs_get_u32(nvs, "shadow_vlim", &limit);
+        shadow_restore_version(&s_shadow, limit);
+        nvs_close(nvs);
+    }
+
+    s_backlog_lock = xSemaphoreCreateMutexStatic(&s_backlog_lock_buf);
+    broker_list_t brokers;
+    mqtt_load_brokers(&brokers);
+    broker_select_init(&s_broker, &brokers);
+    s_broker_entry = brokers.entry[0];
+    s_transport = mqtt_tls_init();
+    mqtt_tls_use(s_transport, broker_uri_is_tls(s_broker_entry.uri));
+    ESP_LOGI(TAG, "broker 列表: %u 个，首选 %s", brokers.count, brokers.entry[0].uri);
+
+    // 地址、凭据和重连间隔在每次连接前按 broker 状态更新（见 mqtt_broker_prepare）
+    s_mqtt_cfg = (esp_mqtt_client_config_t){
+        .broker.address.uri = s_broker_entry.uri,
+        .credentials.client_id = s_device_id,
+        .credentials.username = s_broker_entry.username[0] ? s_broker_entry.username : NULL,
+        .credentials.authentication.password = s_broker_entry.password[0] ? s_broker_entry.password : NULL,
+        // keepalive 对齐到 modem sleep 唤醒周期，减少额外的射频唤醒
+        .session.keepalive = power_mgmt_align_keepalive(MQTT_KEEPALIVE_S, POWER_MGMT_LISTEN_INTERVAL),
         .session.disable_clean_session = false,
-        .network.reconnect_timeout_ms = 5000,
+        // 遗嘱：异常掉线时由 broker 将 availability 置为 offline
+        .session.last_will.topic = s_topic_availability,
+        .session.last_will.msg = "offline",
+        .session.last_will.qos = 1,
+        .session.last_will.retain = 1,
+        .network.reconnect_timeout_ms = BROKER_FAILOVER_MS,
         .network.timeout_ms = 10000,
+        .network.transport = s_transport,
     };
+    // 探测与 keepalive 同周期，搭同一次射频唤醒
+    s_probe_period_ms = (uint32_t)s_mqtt_cfg.session.keepalive * 1000;
 
-    esp_mqtt_client_handle_t client = esp_mqtt_client_init(&mqtt_cfg);
+    metrics_register(&m_publish);
+    metrics_register(&m_publish_fail);
+    metrics_register(&m_parse_err);
+    metrics_register(&m_connects);
+    metrics_register(&m_disconnects);
+    metrics_register(&m_broker_switches);
+    metrics_register(&m_probe_lost);
+    metrics_register(&m_backlog_dropped);
+    metrics_register(&m_connect_ms);
+    metrics_register(&m_rtt_ms);
+    metrics_register(&m_cmd_actuation_us);
+    metrics_register(&m_cmd_rejected);
+    metrics_register(&m_unrouted);
+    metrics_register(&m_arena_full);
+
+    esp_mqtt_client_handle_t client = esp_mqtt_client_init(&s_mqtt_cfg);
     if (client == NULL) {
         ESP_LOGE(TAG, "MQTT客户端初始化失败");
         return NULL;
@@ -173,29 +1291,267 @@ esp_mqtt_client_handle_t mqtt_comm_init(void) {
 }
 
 /**
- * @brief 发布状态信息 - 使用cJSON生成格式化JSON
+ * @brief 发布状态信息（QoS0：每个控制周期都会重发，不进入 esp-mqtt 的重发队列）
  */
 void mqtt_comm_publish(esp_mqtt_client_handle_t client, float temperature, uint8_t speed, bool auto_mode) {
     if (!client) return;
-    
-    // 使用cJSON构建JSON消息
-    cJSON *json = cJSON_CreateObject();
-    cJSON *temp_item = cJSON_CreateNumber(temperature);
-    cJSON *speed_item = cJSON_CreateNumber(speed);
-    cJSON *mode_item = cJSON_CreateString(auto_mode ? "auto" : "manual");
-    
-    cJSON_AddItemToObject(json, "temp", temp_item);
-    cJSON_AddItemToObject(json, "speed", speed_item);
-    cJSON_AddItemToObject(json, "mode", mode_item);
-    
-    char *json_string = cJSON_Print(json);
-    if (json_string) {
-        esp_mqtt_client_publish(client, MQTT_TOPIC_STATUS, json_string, 0, 1, 0);
-        ESP_LOGI(TAG, "发布状态: %s", json_string);
-        free(json_string);
+
+    char json[MQTT_STATUS_MAX];
+    int len = snprintf(json, sizeof(json), "{\"temp\":%.2f,\"speed\":%u,\"mode\":\"%s\"}",
+                       temperature, speed, auto_mode ? "auto" : "manual");
+    if (len <= 0 || len >= (int)sizeof(json)) return;
+    mqtt_comm_publish_raw(client, s_topic_status, json, len, 0, 0);
+    ESP_LOGI(TAG, "发布状态: %s", json);
+}
+
+/**
+ * @brief 发布运行遥测信息（栈上缓冲直接格式化，不经过 cJSON）
+ */
+void mqtt_comm_publish_telemetry(esp_mqtt_client_handle_t client, const mqtt_telemetry_t* tm) {
+    if (!client || !tm) return;
+
+    char json[MQTT_TELEMETRY_MAX];
+    size_t size = sizeof(json);
+    int len = snprintf(json, size,
+                       "{\"uptime_s\":%lu,\"temp_rate_c_min\":%.3f,\"temp_rejected\":%lu,"
+                       "\"cooling\":{\"fan\":%u,\"tec\":%u,\"overtemp_trips\":%lu",
+                       (unsigned long)tm->uptime_s, tm->temp_rate_c_min, (unsigned long)tm->temp_rejected,
+                       tm->fan_duty, tm->tec_duty, (unsigned long)tm->overtemp_trips);
+    if (tm->has_hot_side && len > 0 && (size_t)len < size) {
+        len += snprintf(json + len, size - len, ",\"hot_c\":%.2f", tm->hot_side_c);
     }
-    
-    cJSON_Delete(json);
+    if (len > 0 && (size_t)len < size) {
+        len += snprintf(json + len, size - len,
+                        "},\"deadline\":{\"misses\":%lu,\"last_miss_s\":%lu,\"safe_entries\":%lu}"
+                        ",\"heap\":{\"free\":%lu,\"largest\":%lu,\"frag_pct\":%u,\"steady_allocs\":%lu}"
+                        ",\"period\":{\"control_ms\":%lu,\"sensor_ms\":%lu,\"telemetry_ms\":%lu}"
+                        ",\"energy\":{\"fan_w\":%.2f,\"tec_w\":%.2f,\"fan_kwh\":%.4f,\"tec_kwh\":%.4f,"
+                        "\"budget_w\":%.1f,\"budget_limited\":%s}"
+                        ",\"pm\":{\"i2c_ms\":%llu,\"onewire_ms\":%llu,\"ledc_ms\":%llu",
+                        (unsigned long)tm->deadline_misses, (unsigned long)tm->deadline_last_miss_s,
+                        (unsigned long)tm->safe_state_entries,
+                        (unsigned long)tm->heap_free, (unsigned long)tm->heap_largest_block,
+                        tm->heap_frag_pct, (unsigned long)tm->steady_allocs,
+                        (unsigned long)tm->control_period_ms, (unsigned long)tm->sensor_period_ms,
+                        (unsigned long)tm->telemetry_period_ms,
+                        tm->fan_power_w, tm->tec_power_w, tm->fan_energy_kwh, tm->tec_energy_kwh,
+                        tm->power_budget_w, tm->budget_limited ? "true" : "false",
+                        (unsigned long long)(tm->pm_i2c_us / 1000),
+                        (unsigned long long)(tm->pm_onewire_us / 1000),
+                        (unsigned long long)(tm->pm_ledc_us / 1000));
+    }
+    if (tm->has_pm_modes && len > 0 && (size_t)len < size) {
+        len += snprintf(json + len, size - len,
+                        ",\"sleep_ms\":%llu,\"apb_min_ms\":%llu,\"apb_max_ms\":%llu,\"cpu_max_ms\":%llu,"
+                        "\"light_sleeps\":%lu,\"sleep_rejects\":%lu",
+                        (unsigned long long)(tm->pm_sleep_us / 1000),
+                        (unsigned long long)(tm->pm_apb_min_us / 1000),
+                        (unsigned long long)(tm->pm_apb_max_us / 1000),
+                        (unsigned long long)(tm->pm_cpu_max_us / 1000),
+                        (unsigned long)tm->pm_light_sleeps, (unsigned long)tm->pm_sleep_rejects);
+    }
+    if (len > 0 && (size_t)len < size) {
+        len += snprintf(json + len, size - len, "}");
+    }
+    if (tm->has_stack && len > 0 && (size_t)len < size) {
+        len += snprintf(json + len, size - len, ",\"stack\":{\"control\":%lu,\"sensor\":%lu,\"report\":%lu",
+                        (unsigned long)tm->control_stack_used, (unsigned long)tm->sensor_stack_used,
+                        (unsigned long)tm->report_stack_used);
+        // 探测任务是一次性的，记录的是历次探测中的最小剩余
+        uint32_t probe_hwm = s_failback_probe_hwm;
+        if (probe_hwm && len > 0 && (size_t)len < size) {
+            len += snprintf(json + len, size - len, ",\"probe\":%lu",
+                            (unsigned long)(MQTT_PROBE_TASK_STACK - probe_hwm));
+        }
+        if (len > 0 && (size_t)len < size) {
+            len += snprintf(json + len, size - len, "}");
+        }
+    }
+    if (tm->sensor_state && len > 0 && (size_t)len < size) {
+        len += snprintf(json + len, size - len,
+                        ",\"sensor\":{\"state\":\"%s\",\"fault\":\"%s\",\"fault_s\":%lu,\"faults\":%lu,"
+                        "\"failsafe_entries\":%lu}",
+                        tm->sensor_state, tm->sensor_fault, (unsigned long)tm->sensor_fault_s,
+                        (unsigned long)tm->sensor_faults, (unsigned long)tm->sensor_failsafe_entries);
+    }
+    if (len > 0 && (size_t)len < size) {
+        portENTER_CRITICAL(&s_broker_mux);
+        int index = s_broker.active;
+        broker_health_t health = index >= 0 ? s_broker.health[index] : (broker_health_t){0};
+        uint32_t switches = s_broker.switches;
+        portEXIT_CRITICAL(&s_broker_mux);
+        len += snprintf(json + len, size - len,
+                        ",\"broker\":{\"index\":%d,\"connect_ms\":%lu,\"rtt_ms\":%lu,\"failures\":%lu,"
+                        "\"switches\":%lu,\"backlog\":%u",
+                        index, (unsigned long)health.connect_ms, (unsigned long)health.rtt_ms,
+                        (unsigned long)health.failures, (unsigned long)switches, s_backlog_count);
+    }
+    mqtt_tls_stats_t tls;
+    mqtt_tls_get_stats(&tls);
+    if ((tls.handshakes || tls.pin_failures) && len > 0 && (size_t)len < size) {
+        len += snprintf(json + len, size - len,
+                        ",\"tls\":{\"handshakes\":%lu,\"resume_offers\":%lu,\"last_ms\":%lu,\"ticket_offered\":%s,"
+                        "\"peak_heap\":%lu,\"full_ms\":%lu,\"resume_ms\":%lu,\"pin_failures\":%lu}",
+                        (unsigned long)tls.handshakes, (unsigned long)tls.resume_offers,
+                        (unsigned long)tls.last_ms, tls.ticket_offered ? "true" : "false",
+                        (unsigned long)tls.last_peak_heap, (unsigned long)tls.full_ms,
+                        (unsigned long)tls.resume_ms, (unsigned long)tls.pin_failures);
+    }
+    if (len > 0 && (size_t)len < size) {
+        len += snprintf(json + len, size - len, "}}");
+    }
+    if (len <= 0 || (size_t)len >= size) {
+        ESP_LOGE(TAG, "遥测超出缓冲区");
+        return;
+    }
+    // QoS1：先入暂存区，PUBACK 后才移除；断线或切换 broker 期间留存，重连后补发
+    mqtt_backlog_push(json, len);
+    if (s_connected && mqtt_backlog_flush(client) > 0) {
+        ESP_LOGI(TAG, "发布遥测: %s", json);
+    }
+}
+
+/**
+ * @brief 发布诊断信息（指标快照）
+ */
+void mqtt_comm_publish_diagnostics(esp_mqtt_client_handle_t client, const char* json, int len) {
+    if (!client || !json) return;
+    mqtt_comm_publish_raw(client, s_topic_diag, json, len, 0, 0);
+}
+
+/**
+ * @brief 发布分阶段延迟摘要
+ */
+void mqtt_comm_publish_latency(esp_mqtt_client_handle_t client, const char* json, int len) {
+    if (!client || !json) return;
+    mqtt_comm_publish_raw(client, s_topic_latency, json, len, 0, 0);
+}
+
+/**
+ * @brief 发布事件追踪导出
+ */
+void mqtt_comm_publish_trace(esp_mqtt_client_handle_t client, const uint8_t* data, int len) {
+    if (!client || !data) return;
+    mqtt_comm_publish_raw(client, s_topic_trace, (const char*)data, len, 0, 0);
+}
+
+/**
+ * @brief 发布历史查询结果（非保留，QoS0 避免大消息进入重发队列）
+ */
+void mqtt_comm_publish_history(esp_mqtt_client_handle_t client, const char* json, int len) {
+    if (!client || !json) return;
+    mqtt_comm_publish_raw(client, s_topic_history, json, len, 0, 0);
+}
+
+/**
+ * @brief 发布自整定进度
+ */
+void mqtt_comm_publish_autotune(esp_mqtt_client_handle_t client, const mqtt_autotune_report_t* report) {
+    if (!client || !report) return;
+
+    char json[MQTT_AUTOTUNE_MAX];
+    size_t size = sizeof(json);
+    int len = snprintf(json, size, "{\"phase\":\"%s\",\"cycle\":%u,\"cycles\":%u",
+                       report->phase, report->cycle, report->cycles);
+    if (report->reason && len > 0 && (size_t)len < size) {
+        len += snprintf(json + len, size - len, ",\"reason\":\"%s\"", report->reason);
+    }
+    if (report->tu_s > 0.0f && len > 0 && (size_t)len < size) {
+        len += snprintf(json + len, size - len, ",\"ku\":%.3f,\"tu_s\":%.1f,\"kp\":%.3f,\"ki\":%.5f",
+                        report->ku, report->tu_s, report->kp, report->ki);
+    }
+    if (len > 0 && (size_t)len < size) {
+        len += snprintf(json + len, size - len, "}");
+    }
+    if (len <= 0 || (size_t)len >= size) return;
+    mqtt_comm_publish_raw(client, s_topic_autotune, json, len, 1, 0);
+}
+
+/**
+ * @brief 发布温度传感器故障状态变化（QoS1，故障和恢复都需可靠送达）
+ */
+void mqtt_comm_publish_sensor(esp_mqtt_client_handle_t client, const mqtt_sensor_report_t* report) {
+    if (!client || !report) return;
+
+    char json[MQTT_SENSOR_MAX];
+    size_t size = sizeof(json);
+    int len = snprintf(json, size, "{\"state\":\"%s\",\"fault\":\"%s\",\"fault_s\":%lu",
+                       report->state, report->fault, (unsigned long)report->fault_s);
+    if (report->has_last_good && len > 0 && (size_t)len < size) {
+        len += snprintf(json + len, size - len, ",\"last_good_c\":%.2f", report->last_good_c);
+    }
+    if (len > 0 && (size_t)len < size) {
+        len += snprintf(json + len, size - len, ",\"holdover_s\":%lu,\"failsafe_fan\":%u}",
+                        (unsigned long)report->holdover_s, report->failsafe_fan);
+    }
+    if (len <= 0 || (size_t)len >= size) return;
+    mqtt_comm_publish_raw(client, s_topic_sensor, json, len, 1, 0);
+}
+
+/**
+ * @brief 发布 OTA 状态（QoS1，更新结果需可靠送达）
+ */
+void mqtt_comm_publish_ota_status(esp_mqtt_client_handle_t client, const mqtt_ota_status_t* status) {
+    if (!client || !status) return;
+
+    char json[MQTT_OTA_STATUS_MAX];
+    size_t size = sizeof(json);
+    int len = snprintf(json, size, "{\"state\":\"%s\",\"progress\":%u,\"received\":%lu,\"written\":%lu,"
+                       "\"version\":\"%s\"",
+                       status->state, status->progress, (unsigned long)status->received,
+                       (unsigned long)status->written, status->version ? status->version : "");
+    if (status->error && len > 0 && (size_t)len < size) {
+        len += snprintf(json + len, size - len, ",\"error\":\"%s\"", status->error);
+    }
+    if (len > 0 && (size_t)len < size) {
+        len += snprintf(json + len, size - len, "}");
+    }
+    if (len <= 0 || (size_t)len >= size) return;
+    mqtt_comm_publish_raw(client, s_topic_ota_status, json, len, 1, 0);
+}
+
+bool mqtt_comm_is_connected(void) {
+    return s_connected;
+}
+
+/**
+ * @brief 更新设备影子：有变化时发布增量，并刷新保留的完整文档
+ */
+void mqtt_comm_update_shadow(esp_mqtt_client_handle_t client, const shadow_state_t* state) {
+    if (!s_shadow_lock || !state) return;
+
+    char full[MQTT_SHADOW_MAX];
+    char delta[MQTT_SHADOW_MAX];
+    int full_len = -1, delta_len = -1;
+
+    xSemaphoreTake(s_shadow_lock, portMAX_DELAY);
+    int fields = shadow_update_reported(&s_shadow, state);
+    if (fields) {
+        // 先持久化新的版本号上限再发布，重启后版本号不会回退
+        uint32_t limit = shadow_reserve_version(&s_shadow);
+        nvs_handle_t nvs;
+        if (limit && nvs_open("storage", NVS_READWRITE, &nvs) == ESP_OK) {
+            if (nvs_set_u32(nvs, "shadow_vlim", limit) != ESP_OK || nvs_commit(nvs) != ESP_OK) {
+                ESP_LOGW(TAG, "影子版本号上限保存失败");
+            }
+            nvs_close(nvs);
+        }
+        full_len = shadow_format(&s_shadow, SHADOW_FIELD_ALL, full, sizeof(full));
+        delta_len = shadow_format(&s_shadow, fields, delta, sizeof(delta));
+    }
+    xSemaphoreGive(s_shadow_lock);
+
+    if (!client || !fields) return;
+    // 新订阅者从保留消息立即拿到完整状态，之后按版本号应用增量
+    if (full_len > 0) mqtt_comm_publish_raw(client, s_topic_state, full, full_len, 1, 1);
+    if (delta_len > 0) mqtt_comm_publish_raw(client, s_topic_state_delta, delta, delta_len, 0, 0);
+}
+
+/**
+ * @brief 获取设备ID
+ */
+const char* mqtt_comm_get_device_id(void) {
+    return s_device_id;
 }
 
 /**
@@ -211,3 +1567,17 @@ void mqtt_comm_set_command_callback(mqtt_command_callback_t callback) {
 void mqtt_comm_set_config_callback(mqtt_config_callback_t callback) {
     config_callback = callback;
 }
+
+/**
+ * @brief 设置历史查询回调函数
+ */
+void mqtt_comm_set_history_callback(mqtt_history_callback_t callback) {
+    history_callback = callback;
+}
+
+/**
+ * @brief 设置 OTA 请求回调函数
+ */
+void mqtt_comm_set_ota_callback(mqtt_ota_callback_t callback) {
+    ota_callback = callback;
+}
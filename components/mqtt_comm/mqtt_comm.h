@@ -3,7 +3,12 @@
 
 #include "mqtt_client.h"  // ESP MQTT 客户端类型
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include "device_shadow.h"
+
+// 设备ID最大长度（"fan-" + 12位MAC十六进制 + '\0'）
+#define MQTT_DEVICE_ID_MAX 17
 
 // 命令结构体
 typedef enum {
@@ -11,24 +16,203 @@ typedef enum {
     MQTT_MODE_MANUAL
 } mqtt_mode_t;
 
+typedef enum {
+    MQTT_AUTOTUNE_START,
+    MQTT_AUTOTUNE_ABORT,
+    MQTT_AUTOTUNE_CLEAR         // 清除已保存的增益，恢复分段温控
+} mqtt_autotune_action_t;
+
+typedef enum {
+    MQTT_FAN_CAL_START,
+    MQTT_FAN_CAL_ABORT,
+    MQTT_FAN_CAL_RESET          // 清除校准结果，恢复编译生成的默认线性化表
+} mqtt_fan_cal_action_t;
+
+// 命令关联ID：{"id":"c42",...} 时设备在 <id>/command/ack 发布执行结果
+#define MQTT_CMD_ID_MAX 24
+
 typedef struct {
     uint8_t speed;
     mqtt_mode_t mode;
+    mqtt_autotune_action_t autotune;
+    mqtt_fan_cal_action_t fan_cal;
     bool has_speed;
     bool has_mode;
+    bool has_autotune;
+    bool has_fan_cal;
+    bool report_latency;        // {"report":"latency"}：立即发布延迟摘要
+    bool report_trace;          // {"report":"trace"}：发布事件追踪二进制导出
+    bool report_trace_log;      // {"report":"trace_log"}：事件追踪以 base64 输出到串口
+    bool speed_invalid;         // speed 不是 0~100 的数值，has_speed 不置位
+    char id[MQTT_CMD_ID_MAX];   // 请求方关联ID，空串表示不需要回执
+    int64_t rx_us;              // 收到命令的时刻（esp_timer），0 表示未记录
 } mqtt_command_t;
 
+// 命令执行结果，数值越大越严重；一条命令含多个字段时取最严重的一项
+typedef enum {
+    MQTT_ACK_OK,                // 已执行，输出已写入
+    MQTT_ACK_ACCEPTED,          // 已接受，由控制任务稍后执行（自整定、风扇校准、校准期间的速度）
+    MQTT_ACK_REJECTED,          // 当前状态不允许（如自动模式下的速度命令）
+    MQTT_ACK_INVALID            // 参数超出范围或没有可识别的字段
+} mqtt_ack_result_t;
+
+typedef struct {
+    mqtt_ack_result_t result;
+    const char* reason;         // 静态字符串，结果为 OK 时通常为 NULL
+    int64_t actuated_us;        // 输出写入完成的时刻（esp_timer），0 表示本命令没有立即写输出
+    uint8_t fan_duty;           // actuated_us 非 0 时实际写入的风扇占空比（可能被联锁或预算改写）
+} mqtt_command_ack_t;
+
+/**
+ * @brief 记录一项结果：只在比已有结果更严重时覆盖
+ */
+static inline void mqtt_ack_set(mqtt_command_ack_t* ack, mqtt_ack_result_t result, const char* reason) {
+    if (result > ack->result || (result == ack->result && ack->reason == NULL)) {
+        ack->result = result;
+        ack->reason = reason;
+    }
+}
+
 // 配置结构体
 typedef struct {
     float temp_threshold;
     uint8_t max_speed;
     bool has_temp_threshold;
     bool has_max_speed;
+    // {"fan_off_temp":25,"mid_speed":50}：分段温控的停转温度（须低于阈值）和中间转速
+    float fan_off_temp;
+    uint8_t mid_speed;
+    bool has_fan_off_temp;
+    bool has_mid_speed;
+    float power_budget_w;       // {"power_budget_w":30}，0 取消预算
+    bool has_power_budget;
+    // {"power_model":{"fan_w":3.0,"fan_exp":3.0,"tec_w":60,"tec_exp":1.0}}：实测校准的功率曲线，缺省字段保持原值
+    float fan_power_w;
+    float fan_power_exp;
+    float tec_power_w;
+    float tec_power_exp;
+    bool has_fan_power_w;
+    bool has_fan_power_exp;
+    bool has_tec_power_w;
+    bool has_tec_power_exp;
+    // {"sensor":{"holdover_s":120,"failsafe_fan":100}}：温度传感器故障后按外推值控制的时限，
+    // 以及超时后的失效安全风扇占空比（40~100，温度未知时不允许停转）
+    uint32_t holdover_s;
+    uint8_t failsafe_fan;
+    bool has_holdover_s;
+    bool has_failsafe_fan;
+    // {"brokers":[{"uri":"mqtt://a:1883","username":"u","password":"p"},...]}：按优先级排列的 broker 列表，
+    // 由 mqtt_comm 解析时自行持久化并切换，这里只标记是否已接受
+    bool has_brokers;
+    // {"tls_ca":"-----BEGIN CERTIFICATE-----...","tls_pin":"<sha256 hex>"}：mqtts 信任锚与服务器证书指纹，
+    // 同样由 mqtt_comm 自行持久化，下次握手生效
+    bool has_tls;
 } mqtt_config_t;
 
+// 遥测结构体
+typedef struct {
+    uint32_t uptime_s;          // 运行时间
+    float temp_rate_c_min;      // 估计温度变化率（°C/分钟）
+    uint32_t temp_rejected;     // 被估计器剔除的读数总数
+    bool has_hot_side;          // 是否安装热端传感器
+    float hot_side_c;           // 制冷片热端温度
+    uint8_t fan_duty;           // 监督器实际输出的风扇占空比
+    uint8_t tec_duty;           // 监督器实际输出的制冷片占空比
+    uint32_t overtemp_trips;    // 热端过温切断次数
+    uint32_t deadline_misses;   // 控制周期错过次数
+    uint32_t deadline_last_miss_s; // 最近一次错过的运行时间（秒），0 表示从未错过
+    uint32_t safe_state_entries;   // 因控制任务停滞进入安全状态的次数
+    const char* sensor_state;   // 温度传感器状态：ok/holdover/failsafe
+    const char* sensor_fault;   // 当前或最近一次故障：none/missing/crc/stuck/implausible
+    uint32_t sensor_fault_s;    // 当前故障持续时间（秒），正常时为 0
+    uint32_t sensor_faults;     // 故障确认总次数
+    uint32_t sensor_failsafe_entries;  // 外推超时进入失效安全的次数
+    uint32_t heap_free;         // 内部 DRAM 可用总量
+    uint32_t heap_largest_block;   // 内部 DRAM 最大连续可用块
+    uint8_t heap_frag_pct;      // 碎片程度：100 × (1 − 最大块 / 可用总量)
+    uint32_t steady_allocs;     // 稳态检查基线之后控制/传感器任务的堆分配次数
+    uint32_t control_period_ms; // 当前自适应控制周期
+    uint32_t sensor_period_ms;  // 当前传感器采样周期
+    uint32_t telemetry_period_ms;  // 当前遥测间隔
+    float fan_power_w;          // 按功率模型估计的当前风扇功率
+    float tec_power_w;          // 当前制冷片功率
+    float fan_energy_kwh;       // 累计电能（跨重启）
+    float tec_energy_kwh;
+    float power_budget_w;       // 功率预算，0 表示不限制
+    bool budget_limited;        // 上一个控制周期输出被预算削减
+    bool has_pm_modes;          // 芯片电源模式时间可用（CONFIG_PM_PROFILING）
+    uint64_t pm_sleep_us;       // 浅睡眠累计时间
+    uint64_t pm_apb_min_us;     // 降频（最低频率）累计时间
+    uint64_t pm_apb_max_us;     // APB 全速累计时间
+    uint64_t pm_cpu_max_us;     // CPU 全速累计时间
+    uint32_t pm_light_sleeps;   // 进入浅睡眠次数
+    uint32_t pm_sleep_rejects;  // 浅睡眠被拒绝次数
+    uint64_t pm_i2c_us;         // I2C 电源锁持有时间
+    uint64_t pm_onewire_us;     // 1-Wire 电源锁持有时间
+    uint64_t pm_ledc_us;        // LEDC 电源锁持有时间
+    bool has_stack;             // 任务栈峰值用量可用
+    uint32_t control_stack_used;  // 栈峰值用量（字节，栈大小减高水位）
+    uint32_t sensor_stack_used;
+    uint32_t report_stack_used;
+} mqtt_telemetry_t;
+
 // 回调函数类型定义
-typedef void (*mqtt_command_callback_t)(const mqtt_command_t* cmd);
+// 自整定进度
+typedef struct {
+    const char* phase;          // idle/relay/done/aborted
+    const char* reason;         // 中止原因，未中止时为 NULL
+    uint8_t cycle;              // 已完成的有效周期
+    uint8_t cycles;             // 需要的有效周期
+    float ku;                   // 临界增益（%/°C），完成后有效
+    float tu_s;                 // 临界周期（秒），完成后有效
+    float kp;                   // 整定后的 PI 增益，完成后有效
+    float ki;
+} mqtt_autotune_report_t;
+
+// 温度传感器故障状态变化
+typedef struct {
+    const char* state;          // ok/holdover/failsafe
+    const char* fault;          // missing/crc/stuck/implausible，恢复时为刚结束的故障
+    uint32_t fault_s;           // 故障持续时间（秒），恢复时为本次故障总时长
+    bool has_last_good;         // 是否有过可信读数
+    float last_good_c;          // 最后可信读数
+    uint32_t holdover_s;        // 外推时限
+    uint8_t failsafe_fan;       // 失效安全风扇占空比
+} mqtt_sensor_report_t;
+
+// 历史查询请求：时间以“距最新样本的秒数”表示，设备无需校时
+#define MQTT_HISTORY_ID_MAX 24
+typedef struct {
+    char id[MQTT_HISTORY_ID_MAX];   // 请求方关联ID，原样带回
+    char field[8];                  // temp/fan/tec
+    uint32_t from_s;                // 起点（秒前），默认 3600
+    uint32_t to_s;                  // 终点（秒前），默认 0
+    uint16_t max_points;            // 最多返回点数，默认 200
+} mqtt_history_request_t;
+
+// 命令回调：ack 已初始化为 OK，回调按执行情况填写
+typedef void (*mqtt_command_callback_t)(const mqtt_command_t* cmd, mqtt_command_ack_t* ack);
 typedef void (*mqtt_config_callback_t)(const mqtt_config_t* cfg);
+// OTA 请求：{"url":"https://.../fw.bin.zz","sha256":"<64位十六进制>","compressed":true}
+#define MQTT_OTA_URL_MAX    256
+typedef struct {
+    char url[MQTT_OTA_URL_MAX];
+    char sha256[65];                // 写入分区的镜像（解压后）的 SHA-256
+    bool compressed;                // 镜像为 zlib 压缩流
+} mqtt_ota_request_t;
+
+// OTA 状态上报
+typedef struct {
+    const char* state;              // downloading/rebooting/failed/confirmed
+    uint8_t progress;               // 下载进度（%）
+    uint32_t received;              // 已下载字节
+    uint32_t written;               // 已写入分区字节
+    const char* error;              // 失败原因，可为 NULL
+    const char* version;            // 当前运行的固件版本
+} mqtt_ota_status_t;
+
+typedef void (*mqtt_history_callback_t)(const mqtt_history_request_t* req);
+typedef void (*mqtt_ota_callback_t)(const mqtt_ota_request_t* req);
 
 /**
  * @brief 初始化 MQTT 客户端并返回句柄（不自动启动）
@@ -45,6 +229,84 @@ esp_mqtt_client_handle_t mqtt_comm_init(void);
  */
 void mqtt_comm_publish(esp_mqtt_client_handle_t client, float temperature, uint8_t speed, bool auto_mode);
 
+/**
+ * @brief 周期服务：往返延迟探测、探测超时重连、回切首选 broker
+ *        在上报任务中按控制节拍调用，未连接时直接返回
+ * @param client MQTT 客户端句柄
+ */
+void mqtt_comm_service(esp_mqtt_client_handle_t client);
+
+/**
+ * @brief 发布运行遥测信息到 MQTT 主题；未连接时暂存，重连后补发
+ * @param client MQTT 客户端句柄
+ * @param tm     遥测数据
+ */
+void mqtt_comm_publish_telemetry(esp_mqtt_client_handle_t client, const mqtt_telemetry_t* tm);
+
+/**
+ * @brief 发布诊断信息（JSON 格式的指标快照）到 MQTT 主题
+ * @param client MQTT 客户端句柄
+ * @param json   JSON 数据
+ * @param len    数据长度
+ */
+void mqtt_comm_publish_diagnostics(esp_mqtt_client_handle_t client, const char* json, int len);
+
+/**
+ * @brief 发布分阶段延迟摘要到 <id>/diagnostics/latency 主题
+ * @param client MQTT 客户端句柄
+ * @param json   已序列化的摘要
+ * @param len    数据长度
+ */
+void mqtt_comm_publish_latency(esp_mqtt_client_handle_t client, const char* json, int len);
+
+/**
+ * @brief 发布事件追踪导出（二进制，格式见 trace.h）到 <id>/diagnostics/trace 主题
+ *        非保留、QoS0，用 tools/trace2perfetto.py 转换
+ */
+void mqtt_comm_publish_trace(esp_mqtt_client_handle_t client, const uint8_t* data, int len);
+
+/**
+ * @brief 解析历史查询请求
+ * @return false JSON 无效
+ */
+bool mqtt_comm_parse_history_request(const char* data, int data_len, mqtt_history_request_t* req);
+
+/**
+ * @brief 发布历史查询结果到 <id>/history 主题
+ * @param client MQTT 客户端句柄
+ * @param json   已序列化的结果
+ * @param len    数据长度
+ */
+void mqtt_comm_publish_history(esp_mqtt_client_handle_t client, const char* json, int len);
+
+/**
+ * @brief 解析 OTA 请求
+ * @return false JSON 无效或缺少 url/sha256
+ */
+bool mqtt_comm_parse_ota_request(const char* data, int data_len, mqtt_ota_request_t* req);
+
+/**
+ * @brief 发布 OTA 状态到 <id>/ota/status 主题
+ */
+void mqtt_comm_publish_ota_status(esp_mqtt_client_handle_t client, const mqtt_ota_status_t* status);
+
+/**
+ * @brief 与 broker 的连接是否已建立
+ */
+bool mqtt_comm_is_connected(void);
+
+/**
+ * @brief 发布自整定进度到 <id>/autotune 主题
+ * @param client MQTT 客户端句柄
+ * @param report 进度信息
+ */
+void mqtt_comm_publish_autotune(esp_mqtt_client_handle_t client, const mqtt_autotune_report_t* report);
+
+/**
+ * @brief 发布温度传感器故障状态变化到 <id>/sensor 主题（QoS1）
+ */
+void mqtt_comm_publish_sensor(esp_mqtt_client_handle_t client, const mqtt_sensor_report_t* report);
+
 /**
  * @brief 发布设备信息到 MQTT 主题
  * @param client MQTT 客户端句柄
@@ -53,6 +315,49 @@ void mqtt_comm_publish(esp_mqtt_client_handle_t client, float temperature, uint8
  */
 void mqtt_comm_publish_device_info(esp_mqtt_client_handle_t client, const char* device_id, const char* firmware_version);
 
+/**
+ * @brief 解析命令 JSON（MQTT 与 LAN HTTP 接口共用）
+ * @param data     JSON 数据，无需以 '\0' 结尾
+ * @param data_len 数据长度
+ * @param cmd      输出的命令结构体
+ * @return true 解析成功
+ */
+bool mqtt_comm_parse_command(const char* data, int data_len, mqtt_command_t* cmd);
+
+/**
+ * @brief 格式化命令回执（MQTT 回执主题与 LAN HTTP 响应共用）：
+ *        {"ok":false,"id":"c42","result":"rejected","reason":"auto_mode","handled_us":900}；
+ *        已写输出时另带 "fan":60,"actuation_us":850
+ *        actuation_us 为收到命令到输出写入的时间，handled_us 为收到命令到回调返回的时间
+ * @param now_us 回调返回的时刻
+ * @return 写入长度，缓冲不足返回 -1
+ */
+int mqtt_comm_format_ack(const mqtt_command_t* cmd, const mqtt_command_ack_t* ack, int64_t now_us,
+                         char* buf, size_t size);
+
+/**
+ * @brief 解析配置 JSON（MQTT 与 LAN HTTP 接口共用）
+ * @param data     JSON 数据，无需以 '\0' 结尾
+ * @param data_len 数据长度
+ * @param cfg      输出的配置结构体
+ * @return true 解析成功
+ */
+bool mqtt_comm_parse_config(const char* data, int data_len, mqtt_config_t* cfg);
+
+/**
+ * @brief 更新设备影子：状态变化时发布只含变化字段的增量（state/delta），
+ *        并刷新保留的完整文档（state），版本号单调递增
+ * @param client MQTT 客户端句柄（可为 NULL，此时只更新本地影子）
+ * @param state  当前上报状态
+ */
+void mqtt_comm_update_shadow(esp_mqtt_client_handle_t client, const shadow_state_t* state);
+
+/**
+ * @brief 获取由 MAC 生成的设备ID，所有主题以 esp32/fan_control/<设备ID>/ 为前缀
+ * @return 设备ID字符串，mqtt_comm_init() 之前为空串
+ */
+const char* mqtt_comm_get_device_id(void);
+
 /**
  * @brief 设置命令回调函数
  * @param callback 命令回调函数指针
@@ -65,4 +370,16 @@ void mqtt_comm_set_command_callback(mqtt_command_callback_t callback);
  */
 void mqtt_comm_set_config_callback(mqtt_config_callback_t callback);
 
+/**
+ * @brief 设置历史查询回调函数（订阅 <id>/history/get）
+ * @param callback 查询回调函数指针
+ */
+void mqtt_comm_set_history_callback(mqtt_history_callback_t callback);
+
+/**
+ * @brief 设置 OTA 请求回调函数（订阅 <id>/ota）
+ * @param callback 请求回调函数指针
+ */
+void mqtt_comm_set_ota_callback(mqtt_ota_callback_t callback);
+
 #endif // MQTT_COMM_H
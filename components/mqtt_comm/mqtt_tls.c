@@ -0,0 +1,340 @@
+#include "mqtt_tls.h"
+#include "esp_log.h"
+#include "esp_tls.h"
+#include "esp_crt_bundle.h"
+#include "esp_timer.h"
+#include "heap_guard.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/sha256.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char* TAG = "MQTT_TLS";
+
+#define MQTT_TLS_HOST_MAX   64
+
+// 传输只在 MQTT 任务中使用；信任配置由配置解析任务更新，握手期间持锁
+static esp_tls_t* s_tls = NULL;
+static bool s_use_tls = false;
+static char s_ca_pem[MQTT_TLS_CA_MAX];
+static uint8_t s_pin[32];
+static bool s_has_pin = false;
+static SemaphoreHandle_t s_cfg_lock = NULL;
+static StaticSemaphore_t s_cfg_lock_buf;
+
+// 会话缓存：只对同一 host:port 提供票据（持 s_cfg_lock 访问）
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+static esp_tls_client_session_t* s_session = NULL;
+#endif
+static char s_session_host[MQTT_TLS_HOST_MAX];
+static int s_session_port = 0;
+
+static mqtt_tls_stats_t s_stats;
+static portMUX_TYPE s_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t ewma(uint32_t avg, uint32_t sample) {
+    if (avg == 0) return sample;
+    return (uint32_t)((int32_t)avg + ((int32_t)sample - (int32_t)avg) / 4);
+}
+
+static void forget_session(void) {
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    if (s_session) {
+        esp_tls_free_client_session(s_session);
+        s_session = NULL;
+    }
+#endif
+    s_session_host[0] = '\0';
+    s_session_port = 0;
+}
+
+/**
+ * @brief 解析 64 位十六进制指纹，允许 "AB:CD:..." 形式
+ */
+static bool parse_pin(const char* hex, uint8_t out[32]) {
+    int n = 0;
+    int nibble = -1;
+    for (const char* c = hex; *c; c++) {
+        if (*c == ':') continue;
+        if (!isxdigit((unsigned char)*c) || n >= 32) return false;
+        int v = isdigit((unsigned char)*c) ? *c - '0' : (tolower((unsigned char)*c) - 'a' + 10);
+        if (nibble < 0) {
+            nibble = v;
+        } else {
+            out[n++] = (uint8_t)(nibble << 4 | v);
+            nibble = -1;
+        }
+    }
+    return n == 32 && nibble < 0;
+}
+
+/**
+ * @brief 服务器叶证书指纹检查；会话恢复时证书来自缓存的会话（需 MBEDTLS_SSL_KEEP_PEER_CERTIFICATE）
+ */
+static bool pin_matches(void) {
+    if (!s_use_tls || !s_has_pin) return true;
+    mbedtls_ssl_context* ssl = esp_tls_get_ssl_context(s_tls);
+    const mbedtls_x509_crt* peer = ssl ? mbedtls_ssl_get_peer_cert(ssl) : NULL;
+    if (!peer) return false;
+    uint8_t digest[32];
+    if (mbedtls_sha256(peer->raw.p, peer->raw.len, digest, 0) != 0) return false;
+    return memcmp(digest, s_pin, sizeof(digest)) == 0;
+}
+
+static int tls_close(esp_transport_handle_t t) {
+    if (s_tls) {
+        esp_tls_conn_destroy(s_tls);
+        s_tls = NULL;
+    }
+    return 0;
+}
+
+static int tls_connect(esp_transport_handle_t t, const char* host, int port, int timeout_ms) {
+    tls_close(t);
+    s_tls = esp_tls_init();
+    if (!s_tls) return -1;
+
+    esp_tls_cfg_t cfg = {
+        .timeout_ms = timeout_ms,
+        .is_plain_tcp = !s_use_tls,
+    };
+    bool offered = false;
+    xSemaphoreTake(s_cfg_lock, portMAX_DELAY);
+    if (s_use_tls) {
+        if (s_ca_pem[0]) {
+            cfg.cacert_buf = (const unsigned char*)s_ca_pem;
+            cfg.cacert_bytes = strlen(s_ca_pem) + 1;
+        } else {
+            cfg.crt_bundle_attach = esp_crt_bundle_attach;
+        }
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        if (s_session && port == s_session_port && strcmp(host, s_session_host) == 0) {
+            cfg.client_session = s_session;
+            offered = true;
+        }
+#endif
+    }
+
+    if (s_use_tls) heap_guard_peak_begin();
+    int64_t start_us = esp_timer_get_time();
+    int ret = esp_tls_conn_new_sync(host, strlen(host), port, &cfg, s_tls);
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    uint32_t peak = s_use_tls ? heap_guard_peak_end() : 0;
+
+    bool pinned = ret == 1 && pin_matches();
+    if (ret == 1 && s_use_tls && !pinned) {
+        forget_session();
+    }
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    if (pinned && s_use_tls) {
+        // 服务器可能轮换票据，每次握手后都换成最新的会话
+        esp_tls_client_session_t* fresh = esp_tls_get_client_session(s_tls);
+        if (fresh) {
+            forget_session();
+            s_session = fresh;
+            strlcpy(s_session_host, host, sizeof(s_session_host));
+            s_session_port = port;
+        }
+    }
+#endif
+    xSemaphoreGive(s_cfg_lock);
+
+    if (ret != 1) {
+        tls_close(t);
+        return -1;
+    }
+    if (!s_use_tls) return 0;
+    if (!pinned) {
+        ESP_LOGE(TAG, "服务器证书指纹不符，拒绝连接 %s", host);
+        portENTER_CRITICAL(&s_stats_mux);
+        s_stats.pin_failures++;
+        portEXIT_CRITICAL(&s_stats_mux);
+        tls_close(t);
+        return -1;
+    }
+
+    portENTER_CRITICAL(&s_stats_mux);
+    s_stats.handshakes++;
+    s_stats.last_ms = elapsed_ms;
+    s_stats.last_peak_heap = peak;
+    s_stats.ticket_offered = offered;
+    if (offered) {
+        s_stats.resume_offers++;
+        s_stats.resume_ms = ewma(s_stats.resume_ms, elapsed_ms);
+    } else {
+        s_stats.full_ms = ewma(s_stats.full_ms, elapsed_ms);
+    }
+    portEXIT_CRITICAL(&s_stats_mux);
+    ESP_LOGI(TAG, "TLS 握手 %lums（%s票据），峰值堆 %lu 字节", (unsigned long)elapsed_ms,
+             offered ? "提供" : "未提供", (unsigned long)peak);
+    return 0;
+}
+
+/**
+ * @brief 等待套接字可读/可写；TLS 记录层已缓存的明文视为可读
+ * @return 1 就绪，0 超时，-1 错误
+ */
+static int tls_poll(int timeout_ms, bool read) {
+    if (!s_tls) return -1;
+    if (read && s_use_tls && esp_tls_get_bytes_avail(s_tls) > 0) return 1;
+    int fd = -1;
+    if (esp_tls_get_conn_sockfd(s_tls, &fd) != ESP_OK || fd < 0) return -1;
+
+    fd_set ready, errors;
+    FD_ZERO(&ready);
+    FD_ZERO(&errors);
+    FD_SET(fd, &ready);
+    FD_SET(fd, &errors);
+    struct timeval tv = { .tv_sec = timeout_ms / 1000, .tv_usec = (timeout_ms % 1000) * 1000 };
+    int ret = select(fd + 1, read ? &ready : NULL, read ? NULL : &ready, &errors, timeout_ms >= 0 ? &tv : NULL);
+    if (ret > 0 && FD_ISSET(fd, &errors)) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        ESP_LOGE(TAG, "套接字错误 %d", err);
+        return -1;
+    }
+    return ret > 0 ? 1 : ret;
+}
+
+static int tls_poll_read(esp_transport_handle_t t, int timeout_ms) {
+    return tls_poll(timeout_ms, true);
+}
+
+static int tls_poll_write(esp_transport_handle_t t, int timeout_ms) {
+    return tls_poll(timeout_ms, false);
+}
+
+static int tls_read(esp_transport_handle_t t, char* buffer, int len, int timeout_ms) {
+    int poll = tls_poll(timeout_ms, true);
+    if (poll < 0) return ERR_TCP_TRANSPORT_CONNECTION_FAILED;
+    if (poll == 0) return ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    ssize_t ret = esp_tls_conn_read(s_tls, buffer, len);
+    if (ret > 0) return ret;
+    if (ret == 0) return ERR_TCP_TRANSPORT_CONNECTION_CLOSED_BY_FIN;
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+        return ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+    return ERR_TCP_TRANSPORT_CONNECTION_FAILED;
+}
+
+static int tls_write(esp_transport_handle_t t, const char* buffer, int len, int timeout_ms) {
+    int poll = tls_poll(timeout_ms, false);
+    if (poll <= 0) return poll;
+    ssize_t ret = esp_tls_conn_write(s_tls, buffer, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) return 0;
+    return ret < 0 ? -1 : ret;
+}
+
+static int tls_destroy(esp_transport_handle_t t) {
+    tls_close(t);
+    xSemaphoreTake(s_cfg_lock, portMAX_DELAY);
+    forget_session();
+    xSemaphoreGive(s_cfg_lock);
+    return 0;
+}
+
+esp_transport_handle_t mqtt_tls_init(void) {
+    if (!s_cfg_lock) s_cfg_lock = xSemaphoreCreateMutexStatic(&s_cfg_lock_buf);
+
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READONLY, &nvs) == ESP_OK) {
+        size_t len = sizeof(s_ca_pem);
+        if (nvs_get_str(nvs, "mqtt_tls_ca", s_ca_pem, &len) != ESP_OK) s_ca_pem[0] = '\0';
+        char hex[MQTT_TLS_PIN_HEX + 32];
+        len = sizeof(hex);
+        s_has_pin = nvs_get_str(nvs, "mqtt_tls_pin", hex, &len) == ESP_OK && parse_pin(hex, s_pin);
+        nvs_close(nvs);
+    }
+    ESP_LOGI(TAG, "信任锚: %s%s", s_ca_pem[0] ? "固定证书" : "内置证书包", s_has_pin ? "，已固定指纹" : "");
+#if !CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    ESP_LOGW(TAG, "未启用 CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS，每次重连都是完整握手");
+#endif
+
+    esp_transport_handle_t t = esp_transport_init();
+    if (!t) return NULL;
+    esp_transport_set_func(t, tls_connect, tls_read, tls_write, tls_close, tls_poll_read, tls_poll_write,
+                           tls_destroy);
+    esp_transport_set_default_port(t, 1883);
+    return t;
+}
+
+void mqtt_tls_use(esp_transport_handle_t transport, bool tls) {
+    s_use_tls = tls;
+    if (transport) esp_transport_set_default_port(transport, tls ? 8883 : 1883);
+}
+
+bool mqtt_tls_set_ca(const char* pem) {
+    if (!s_cfg_lock) return false;
+    size_t len = strlen(pem);
+    if (len >= sizeof(s_ca_pem) || (len && !strstr(pem, "-----BEGIN CERTIFICATE-----"))) return false;
+
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READWRITE, &nvs) == ESP_OK) {
+        if (len) {
+            nvs_set_str(nvs, "mqtt_tls_ca", pem);
+        } else {
+            nvs_erase_key(nvs, "mqtt_tls_ca");
+        }
+        nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+    xSemaphoreTake(s_cfg_lock, portMAX_DELAY);
+    strlcpy(s_ca_pem, pem, sizeof(s_ca_pem));
+    forget_session();
+    xSemaphoreGive(s_cfg_lock);
+    ESP_LOGI(TAG, "信任锚已更新: %s", len ? "固定证书" : "内置证书包");
+    return true;
+}
+
+bool mqtt_tls_set_pin(const char* hex) {
+    if (!s_cfg_lock) return false;
+    uint8_t pin[32];
+    bool clear = hex[0] == '\0';
+    if (!clear && (strlen(hex) > MQTT_TLS_PIN_HEX + 31 || !parse_pin(hex, pin))) return false;
+
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READWRITE, &nvs) == ESP_OK) {
+        if (clear) {
+            nvs_erase_key(nvs, "mqtt_tls_pin");
+        } else {
+            nvs_set_str(nvs, "mqtt_tls_pin", hex);
+        }
+        nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+    xSemaphoreTake(s_cfg_lock, portMAX_DELAY);
+    if (!clear) memcpy(s_pin, pin, sizeof(s_pin));
+    s_has_pin = !clear;
+    xSemaphoreGive(s_cfg_lock);
+    return true;
+}
+
+void mqtt_tls_get_stats(mqtt_tls_stats_t* stats) {
+    portENTER_CRITICAL(&s_stats_mux);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_stats_mux);
+}
+
+bool mqtt_tls_probe(const char* uri, int timeout_ms) {
+    bool tls = strncmp(uri, "mqtts://", 8) == 0;
+    const char* host = tls ? uri + 8 : strncmp(uri, "mqtt://", 7) == 0 ? uri + 7 : NULL;
+    if (!host) return false;
+    size_t host_len = strcspn(host, ":/");
+    if (host_len == 0 || host_len >= MQTT_TLS_HOST_MAX) return false;
+    int port = host[host_len] == ':' ? atoi(host + host_len + 1) : (tls ? 8883 : 1883);
+    if (port <= 0 || port > 65535) return false;
+
+    esp_tls_cfg_t cfg = { .timeout_ms = timeout_ms };
+    int fd = -1;
+    esp_err_t err = esp_tls_plain_tcp_connect(host, (int)host_len, port, &cfg, NULL, &fd);
+    if (fd >= 0) close(fd);
+    return err == ESP_OK;
+}
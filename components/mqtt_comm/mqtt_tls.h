@@ -0,0 +1,63 @@
+#ifndef MQTT_TLS_H
+#define MQTT_TLS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_transport.h"
+
+/**
+ * @brief MQTT 传输：esp-tls 之上的自定义 esp_transport，同时承载 mqtt:// 和 mqtts://
+ *        esp-mqtt 自带的 SSL 传输不暴露 esp-tls 的 client_session，无法跨重连复用会话；
+ *        这里缓存最近一次握手得到的会话票据，重连同一 broker 时提供给服务器，
+ *        恢复成功即省去证书链验证和 ECDHE 签名运算。
+ *        信任锚：NVS 中固定的 CA/服务器证书（PEM），未配置时使用内置证书包；
+ *        可选再固定服务器叶证书的 SHA-256 指纹
+ */
+
+// 固定证书上限：ECDSA P-256 证书约 600 字节，RSA-2048 约 1.2 KB
+#define MQTT_TLS_CA_MAX     2048
+#define MQTT_TLS_PIN_HEX    64
+
+typedef struct {
+    uint32_t handshakes;        // TLS 连接成功次数
+    uint32_t resume_offers;     // 其中提供了缓存会话票据的次数
+    uint32_t pin_failures;      // 指纹不符被拒绝的次数
+    uint32_t last_ms;           // 最近一次连接耗时（TCP + TLS 握手）
+    uint32_t last_peak_heap;    // 最近一次握手期间内部 DRAM 峰值占用（字节）
+    uint32_t full_ms;           // 完整握手耗时 EWMA
+    uint32_t resume_ms;         // 提供票据的握手耗时 EWMA
+    bool ticket_offered;        // 最近一次是否提供了票据（服务器是否接受恢复无从得知）
+} mqtt_tls_stats_t;
+
+/**
+ * @brief 从 NVS 载入固定证书和指纹，创建传输句柄（交给 esp-mqtt 后由客户端负责销毁）
+ */
+esp_transport_handle_t mqtt_tls_init(void);
+
+/**
+ * @brief 选择下一次连接是否使用 TLS，并设置未指定端口时的默认端口（1883/8883）
+ *        在 MQTT 任务的 MQTT_EVENT_BEFORE_CONNECT 中调用
+ */
+void mqtt_tls_use(esp_transport_handle_t transport, bool tls);
+
+/**
+ * @brief 固定信任的 CA 或服务器证书（PEM），空串恢复使用内置证书包；写入 NVS，下次握手生效
+ *        更换信任锚后丢弃已缓存的会话
+ */
+bool mqtt_tls_set_ca(const char* pem);
+
+/**
+ * @brief 固定服务器叶证书 SHA-256 指纹（64 位十六进制，可含冒号），空串取消；写入 NVS
+ */
+bool mqtt_tls_set_pin(const char* hex);
+
+void mqtt_tls_get_stats(mqtt_tls_stats_t* stats);
+
+/**
+ * @brief 可达性探测：只建立 TCP 连接随即关闭，不做 TLS 握手和 MQTT 登录（回切前确认首选 broker 已恢复）
+ *        阻塞至多 timeout_ms，在上报任务中调用
+ * @param uri mqtt://host[:port] 或 mqtts://host[:port]，未指定端口时取 1883/8883
+ */
+bool mqtt_tls_probe(const char* uri, int timeout_ms);
+
+#endif // MQTT_TLS_H
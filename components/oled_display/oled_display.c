@@ -3,6 +3,10 @@
 #include "driver/i2c.h"
 #include <stdio.h>
 #include <string.h>
+#include "power_mgmt.h"
+#include "metrics.h"
+#include "trace.h"
+#include "oled_frame.h"
 
 // 抑制旧版I2C驱动警告
 #pragma GCC diagnostic push
@@ -10,40 +14,147 @@
 
 // static const char* TAG = "OLED";  // 暂时未使用，注释掉避免警告
 
-// 声明手动模式下制冷片功率变量（由main.c定义）
-extern uint8_t manual_cooler_power;
-
 #define SSD1306_I2C_ADDR 0x3C
 #define SSD1306_WIDTH    128
 #define SSD1306_HEIGHT   64
 #define SSD1306_PAGE_COUNT (SSD1306_HEIGHT/8)
 
 static i2c_port_t s_i2c_num;
+static char s_status[22];   // 底部状态行（如自整定进度），空串不显示
+static oled_frame_t s_shown;    // 屏幕上当前的内容，用于增量刷新
+
+static METRIC_COUNTER_DEFINE(m_i2c_err, "fan_oled_i2c_errors_total", "Failed I2C writes to the SSD1306");
+TRACE_NAME(t_update, "oled_update");
+TRACE_NAME(t_i2c_err, "oled_i2c_error");
+TRACE_NAME(t_bytes, "oled_bytes");
 
-// 5x7 ASCII 字体表（仅部分，完整可扩展）
+// 5x7 ASCII 字体表（0x20-0x7E，列优先，LSB 在上）
 static const uint8_t font5x7[][5] = {
-    // ... 只示例部分 ...
     {0x00,0x00,0x00,0x00,0x00}, // 空格 0x20
     {0x00,0x00,0x5F,0x00,0x00}, // !
     {0x00,0x07,0x00,0x07,0x00}, // "
-    // ... 可补充完整 ...
+    {0x14,0x7F,0x14,0x7F,0x14}, // #
+    {0x24,0x2A,0x7F,0x2A,0x12}, // $
+    {0x23,0x13,0x08,0x64,0x62}, // %
+    {0x36,0x49,0x55,0x22,0x50}, // &
+    {0x00,0x05,0x03,0x00,0x00}, // '
+    {0x00,0x1C,0x22,0x41,0x00}, // (
+    {0x00,0x41,0x22,0x1C,0x00}, // )
+    {0x08,0x2A,0x1C,0x2A,0x08}, // *
+    {0x08,0x08,0x3E,0x08,0x08}, // +
+    {0x00,0x50,0x30,0x00,0x00}, // ,
+    {0x08,0x08,0x08,0x08,0x08}, // -
+    {0x00,0x60,0x60,0x00,0x00}, // .
+    {0x20,0x10,0x08,0x04,0x02}, // /
+    {0x3E,0x51,0x49,0x45,0x3E}, // 0 0x30
+    {0x00,0x42,0x7F,0x40,0x00}, // 1
+    {0x42,0x61,0x51,0x49,0x46}, // 2
+    {0x21,0x41,0x45,0x4B,0x31}, // 3
+    {0x18,0x14,0x12,0x7F,0x10}, // 4
+    {0x27,0x45,0x45,0x45,0x39}, // 5
+    {0x3C,0x4A,0x49,0x49,0x30}, // 6
+    {0x01,0x71,0x09,0x05,0x03}, // 7
+    {0x36,0x49,0x49,0x49,0x36}, // 8
+    {0x06,0x49,0x49,0x29,0x1E}, // 9
+    {0x00,0x36,0x36,0x00,0x00}, // :
+    {0x00,0x56,0x36,0x00,0x00}, // ;
+    {0x08,0x14,0x22,0x41,0x00}, // <
+    {0x14,0x14,0x14,0x14,0x14}, // =
+    {0x00,0x41,0x22,0x14,0x08}, // >
+    {0x02,0x01,0x51,0x09,0x06}, // ?
+    {0x32,0x49,0x79,0x41,0x3E}, // @ 0x40
+    {0x7E,0x11,0x11,0x11,0x7E}, // A
+    {0x7F,0x49,0x49,0x49,0x36}, // B
+    {0x3E,0x41,0x41,0x41,0x22}, // C
+    {0x7F,0x41,0x41,0x22,0x1C}, // D
+    {0x7F,0x49,0x49,0x49,0x41}, // E
+    {0x7F,0x09,0x09,0x09,0x01}, // F
+    {0x3E,0x41,0x49,0x49,0x7A}, // G
+    {0x7F,0x08,0x08,0x08,0x7F}, // H
+    {0x00,0x41,0x7F,0x41,0x00}, // I
+    {0x20,0x40,0x41,0x3F,0x01}, // J
+    {0x7F,0x08,0x14,0x22,0x41}, // K
+    {0x7F,0x40,0x40,0x40,0x40}, // L
+    {0x7F,0x02,0x0C,0x02,0x7F}, // M
+    {0x7F,0x04,0x08,0x10,0x7F}, // N
+    {0x3E,0x41,0x41,0x41,0x3E}, // O
+    {0x7F,0x09,0x09,0x09,0x06}, // P 0x50
+    {0x3E,0x41,0x51,0x21,0x5E}, // Q
+    {0x7F,0x09,0x19,0x29,0x46}, // R
+    {0x46,0x49,0x49,0x49,0x31}, // S
+    {0x01,0x01,0x7F,0x01,0x01}, // T
+    {0x3F,0x40,0x40,0x40,0x3F}, // U
+    {0x1F,0x20,0x40,0x20,0x1F}, // V
+    {0x3F,0x40,0x38,0x40,0x3F}, // W
+    {0x63,0x14,0x08,0x14,0x63}, // X
+    {0x07,0x08,0x70,0x08,0x07}, // Y
+    {0x61,0x51,0x49,0x45,0x43}, // Z
+    {0x00,0x7F,0x41,0x41,0x00}, // [
+    {0x02,0x04,0x08,0x10,0x20}, // 反斜杠
+    {0x00,0x41,0x41,0x7F,0x00}, // ]
+    {0x04,0x02,0x01,0x02,0x04}, // ^
+    {0x40,0x40,0x40,0x40,0x40}, // _
+    {0x00,0x01,0x02,0x04,0x00}, // ` 0x60
+    {0x20,0x54,0x54,0x54,0x78}, // a
+    {0x7F,0x48,0x44,0x44,0x38}, // b
+    {0x38,0x44,0x44,0x44,0x20}, // c
+    {0x38,0x44,0x44,0x48,0x7F}, // d
+    {0x38,0x54,0x54,0x54,0x18}, // e
+    {0x08,0x7E,0x09,0x01,0x02}, // f
+    {0x0C,0x52,0x52,0x52,0x3E}, // g
+    {0x7F,0x08,0x04,0x04,0x78}, // h
+    {0x00,0x44,0x7D,0x40,0x00}, // i
+    {0x20,0x40,0x44,0x3D,0x00}, // j
+    {0x7F,0x10,0x28,0x44,0x00}, // k
+    {0x00,0x41,0x7F,0x40,0x00}, // l
+    {0x7C,0x04,0x18,0x04,0x78}, // m
+    {0x7C,0x08,0x04,0x04,0x78}, // n
+    {0x38,0x44,0x44,0x44,0x38}, // o
+    {0x7C,0x14,0x14,0x14,0x08}, // p 0x70
+    {0x08,0x14,0x14,0x18,0x7C}, // q
+    {0x7C,0x08,0x04,0x04,0x08}, // r
+    {0x48,0x54,0x54,0x54,0x20}, // s
+    {0x04,0x3F,0x44,0x40,0x20}, // t
+    {0x3C,0x40,0x40,0x20,0x7C}, // u
+    {0x1C,0x20,0x40,0x20,0x1C}, // v
+    {0x3C,0x40,0x30,0x40,0x3C}, // w
+    {0x44,0x28,0x10,0x28,0x44}, // x
+    {0x0C,0x50,0x50,0x50,0x3C}, // y
+    {0x44,0x64,0x54,0x4C,0x44}, // z
+    {0x00,0x08,0x36,0x41,0x00}, // {
+    {0x00,0x00,0x7F,0x00,0x00}, // |
+    {0x00,0x41,0x36,0x08,0x00}, // }
+    {0x08,0x04,0x08,0x10,0x08}, // ~ 0x7E
 };
 
+static void ssd1306_clear(void);
+
 // I2C 写命令
 static esp_err_t ssd1306_write_cmd(uint8_t cmd) {
     uint8_t buf[2] = {0x00, cmd};
-    return i2c_master_write_to_device(s_i2c_num, SSD1306_I2C_ADDR, buf, 2, 100 / portTICK_PERIOD_MS);
+    esp_err_t err = i2c_master_write_to_device(s_i2c_num, SSD1306_I2C_ADDR, buf, 2, 100 / portTICK_PERIOD_MS);
+    if (err != ESP_OK) {
+        metrics_inc(&m_i2c_err);
+        TRACE_INSTANT(t_i2c_err, err);
+    }
+    return err;
 }
 // I2C 写数据
 static esp_err_t ssd1306_write_data(const uint8_t* data, size_t len) {
     uint8_t buf[SSD1306_WIDTH+1];
     buf[0] = 0x40;
     memcpy(&buf[1], data, len);
-    return i2c_master_write_to_device(s_i2c_num, SSD1306_I2C_ADDR, buf, len+1, 100 / portTICK_PERIOD_MS);
+    esp_err_t err = i2c_master_write_to_device(s_i2c_num, SSD1306_I2C_ADDR, buf, len+1, 100 / portTICK_PERIOD_MS);
+    if (err != ESP_OK) {
+        metrics_inc(&m_i2c_err);
+        TRACE_INSTANT(t_i2c_err, err);
+    }
+    return err;
 }
 // 初始化 SSD1306
 void oled_init(i2c_port_t i2c_num, gpio_num_t sda_pin, gpio_num_t scl_pin) {
     s_i2c_num = i2c_num;
+    metrics_register(&m_i2c_err);
     i2c_config_t i2c_conf = {
         .mode = I2C_MODE_MASTER,
         .sda_io_num = sda_pin,
@@ -55,8 +166,9 @@ void oled_init(i2c_port_t i2c_num, gpio_num_t sda_pin, gpio_num_t scl_pin) {
     ESP_ERROR_CHECK(i2c_param_config(i2c_num, &i2c_conf));
     ESP_ERROR_CHECK(i2c_driver_install(i2c_num, I2C_MODE_MASTER, 0, 0, 0));
     // SSD1306 初始化命令序列（简化版）
+    power_mgmt_acquire(PM_LOCK_I2C);
     ssd1306_write_cmd(0xAE); // 关闭显示
-    ssd1306_write_cmd(0x20); ssd1306_write_cmd(0x00); // 水平寻址
+    ssd1306_write_cmd(0x20); ssd1306_write_cmd(0x02); // 页寻址：局部重绘用 0xB0/0x00/0x10 定位，水平寻址下这些命令无效
     ssd1306_write_cmd(0xB0); // page0
     ssd1306_write_cmd(0xC8); // COM扫描方向
     ssd1306_write_cmd(0x00); // 低列地址
@@ -74,6 +186,9 @@ void oled_init(i2c_port_t i2c_num, gpio_num_t sda_pin, gpio_num_t scl_pin) {
     ssd1306_write_cmd(0xDB); ssd1306_write_cmd(0x40); // VCOMH
     ssd1306_write_cmd(0x8D); ssd1306_write_cmd(0x14); // 电荷泵
     ssd1306_write_cmd(0xAF); // 开启显示
+    ssd1306_clear();
+    power_mgmt_release(PM_LOCK_I2C);
+    oled_frame_clear(&s_shown);
 }
 // 清屏
 static void ssd1306_clear(void) {
@@ -85,38 +200,61 @@ static void ssd1306_clear(void) {
         ssd1306_write_data(zero, SSD1306_WIDTH);
     }
 }
-// 显示ASCII字符串（单行，x:0-127, y:0/8/16...63）
-static void ssd1306_draw_str(uint8_t x, uint8_t page, const char* str) {
+// 在一页内从第 col 个字符起连续绘制 n 个字符，一次 I2C 事务写完
+static esp_err_t ssd1306_draw_span(uint8_t page, uint8_t col, const char* str, uint8_t n, bool inverted) {
+    uint8_t buf[OLED_FRAME_COLS * 6];
+    uint8_t x = col * 6;
+    for (uint8_t i = 0; i < n; i++) {
+        char c = str[i];
+        if (c < 32 || c > 126) c = '?';
+        for (int j = 0; j < 5; j++) {
+            buf[i * 6 + j] = inverted ? (uint8_t)~font5x7[c-32][j] : font5x7[c-32][j];
+        }
+        buf[i * 6 + 5] = inverted ? 0xFF : 0x00; // 字符间隔
+    }
     ssd1306_write_cmd(0xB0 | page);
     ssd1306_write_cmd(0x00 | (x & 0x0F));
     ssd1306_write_cmd(0x10 | (x >> 4));
-    while (*str && x < SSD1306_WIDTH-6) {
-        char c = *str++;
-        if (c < 32 || c > 126) c = '?';
-        ssd1306_write_data(font5x7[c-32], 5);
-        uint8_t space = 0x00;
-        ssd1306_write_data(&space, 1); // 字符间隔
-        x += 6;
-    }
+    return ssd1306_write_data(buf, n * 6);
 }
-// 刷新显示内容（本实现为直接写入，无需额外刷新）
 
-void oled_display_update(float temperature, uint8_t fan_speed, bool auto_mode) {
-    char line1[22], line2[22], line3[22], line4[22];
-    snprintf(line1, sizeof(line1), "Temp : %5.1f °C", temperature);
-    snprintf(line2, sizeof(line2), "Fan  : %3d%% %s", fan_speed, auto_mode ? "(Auto) " : "      ");
-    if (auto_mode) {
-        snprintf(line3, sizeof(line3), "Cooler: %3d%% (Auto) ", fan_speed);
-        snprintf(line4, sizeof(line4), "Mode : 自动       ");
-    } else {
-        snprintf(line3, sizeof(line3), "Cooler: %3d%% (Manual)", manual_cooler_power);
-        snprintf(line4, sizeof(line4), "Mode : 手动       ");
+void oled_display_frame(const oled_frame_t* frame) {
+    uint32_t bytes = 0;
+    TRACE_BEGIN(t_update);
+    // 整帧刷新期间保持 I2C 电源锁，避免逐行锁操作开销
+    power_mgmt_acquire(PM_LOCK_I2C);
+    for (uint8_t row = 0; row < OLED_FRAME_ROWS; row++) {
+        uint8_t first, last;
+        if (!oled_frame_diff_row(&s_shown, frame, row, &first, &last)) continue;
+        uint8_t n = last - first + 1;
+        bool inverted = frame->inverted & (1u << row);
+        if (ssd1306_draw_span(row, first, &frame->text[row][first], n, inverted) == ESP_OK) {
+            memcpy(&s_shown.text[row][first], &frame->text[row][first], n);
+            s_shown.inverted = (s_shown.inverted & ~(1u << row)) | (frame->inverted & (1u << row));
+            bytes += n * 6;
+        } else {
+            // 写失败时屏幕内容未知，下次整行重绘
+            memset(s_shown.text[row], 0, OLED_FRAME_COLS);
+        }
     }
-    ssd1306_clear();
-    ssd1306_draw_str(0, 0, line1);
-    ssd1306_draw_str(0, 1, line2);
-    ssd1306_draw_str(0, 2, line3);
-    ssd1306_draw_str(0, 3, line4);
+    power_mgmt_release(PM_LOCK_I2C);
+    TRACE_COUNTER(t_bytes, bytes);
+    TRACE_END(t_update);
+}
+
+void oled_display_set_status(const char* status) {
+    snprintf(s_status, sizeof(s_status), "%s", status ? status : "");
+}
+
+void oled_display_update(float temperature, uint8_t fan_speed, uint8_t cooler_power, bool auto_mode) {
+    oled_frame_t frame;
+    oled_frame_clear(&frame);
+    oled_frame_printf(&frame, 0, "Temp : %5.1f C", temperature);
+    oled_frame_printf(&frame, 1, "Fan  : %3d%% %s", fan_speed, auto_mode ? "(Auto) " : "      ");
+    oled_frame_printf(&frame, 2, "Cooler: %3d%% %s", cooler_power, auto_mode ? "(Auto) " : "(Manual)");
+    oled_frame_printf(&frame, 3, "Mode : %s", auto_mode ? "Auto" : "Manual");
+    oled_frame_printf(&frame, 5, "%s", s_status);
+    oled_display_frame(&frame);
 }
 
 #pragma GCC diagnostic pop  // 恢复警告设置
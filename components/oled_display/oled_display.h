@@ -3,6 +3,7 @@
 
 #include "driver/i2c.h"
 #include <stdbool.h>
+#include "oled_frame.h"
 
 /**
  * @brief Initialize OLED display (SSD1306) via I2C
@@ -10,8 +11,20 @@
 void oled_init(i2c_port_t i2c_num, gpio_num_t sda_pin, gpio_num_t scl_pin);
 
 /**
- * @brief Update OLED display with temperature, speed, and mode
+ * @brief Update OLED display with temperature, applied fan/cooler duty, and mode
+ *        fan_speed/cooler_power are the outputs after the cooling supervisor (interlock, budget),
+ *        not the requested values
  */
-void oled_display_update(float temperature, uint8_t speed, bool auto_mode);
+void oled_display_update(float temperature, uint8_t fan_speed, uint8_t cooler_power, bool auto_mode);
+
+/**
+ * @brief Draw a text frame, rewriting only the character spans that differ from the screen
+ */
+void oled_display_frame(const oled_frame_t* frame);
+
+/**
+ * @brief Set the bottom status line shown on the next update (NULL or "" hides it)
+ */
+void oled_display_set_status(const char* status);
 
 #endif // OLED_DISPLAY_H
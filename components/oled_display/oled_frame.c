@@ -0,0 +1,46 @@
+#include "oled_frame.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+void oled_frame_clear(oled_frame_t* frame) {
+    for (int row = 0; row < OLED_FRAME_ROWS; row++) {
+        memset(frame->text[row], ' ', OLED_FRAME_COLS);
+        frame->text[row][OLED_FRAME_COLS] = '\0';
+    }
+    frame->inverted = 0;
+}
+
+void oled_frame_printf(oled_frame_t* frame, uint8_t row, const char* fmt, ...) {
+    if (row >= OLED_FRAME_ROWS) return;
+    char* line = frame->text[row];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(line, OLED_FRAME_COLS + 1, fmt, args);
+    va_end(args);
+    if (len < 0) len = 0;
+    if (len < OLED_FRAME_COLS) {
+        memset(line + len, ' ', OLED_FRAME_COLS - len);
+    }
+    line[OLED_FRAME_COLS] = '\0';
+}
+
+bool oled_frame_diff_row(const oled_frame_t* prev, const oled_frame_t* next, uint8_t row,
+                         uint8_t* first, uint8_t* last) {
+    uint8_t mask = 1u << row;
+    if ((prev->inverted ^ next->inverted) & mask) {
+        *first = 0;
+        *last = OLED_FRAME_COLS - 1;
+        return true;
+    }
+    const char* a = prev->text[row];
+    const char* b = next->text[row];
+    int lo = 0;
+    while (lo < OLED_FRAME_COLS && a[lo] == b[lo]) lo++;
+    if (lo == OLED_FRAME_COLS) return false;
+    int hi = OLED_FRAME_COLS - 1;
+    while (hi > lo && a[hi] == b[hi]) hi--;
+    *first = (uint8_t)lo;
+    *last = (uint8_t)hi;
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef OLED_FRAME_H
+#define OLED_FRAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 文本帧：8 行 × 21 列（5x7 字体加 1 列间隔，每行对应 SSD1306 的一页）
+ *        刷新时与上一帧逐行比较，只重绘变化的字符区间
+ *        纯C实现，不依赖ESP-IDF
+ */
+
+#define OLED_FRAME_ROWS 8
+#define OLED_FRAME_COLS 21
+
+typedef struct {
+    char text[OLED_FRAME_ROWS][OLED_FRAME_COLS + 1];   // 每行补空格到满宽
+    uint8_t inverted;                                  // 按位：反色显示的行
+} oled_frame_t;
+
+/**
+ * @brief 清空为全空格
+ */
+void oled_frame_clear(oled_frame_t* frame);
+
+/**
+ * @brief 格式化写入一行，超出部分截断，不足补空格
+ */
+void oled_frame_printf(oled_frame_t* frame, uint8_t row, const char* fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * @brief 比较一行，得到需要重绘的字符区间
+ *        反色状态变化时整行重绘
+ * @param first 输出：第一个变化的列
+ * @param last 输出：最后一个变化的列
+ * @return false 该行没有变化
+ */
+bool oled_frame_diff_row(const oled_frame_t* prev, const oled_frame_t* next, uint8_t row,
+                         uint8_t* first, uint8_t* last);
+
+#endif // OLED_FRAME_H
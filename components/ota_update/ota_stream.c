@@ -0,0 +1,72 @@
+#include "ota_stream.h"
+#include <string.h>
+
+void ota_stream_init(ota_stream_t* s, bool compressed, uint8_t* dict, ota_stream_sink_t sink, void* ctx) {
+    memset(s, 0, sizeof(*s));
+    s->compressed = compressed;
+    s->dict = dict;
+    s->sink = sink;
+    s->sink_ctx = ctx;
+    tinfl_init(&s->inflator);
+}
+
+static ota_stream_err_t emit(ota_stream_t* s, const uint8_t* data, size_t len) {
+    if (len == 0) return OTA_STREAM_OK;
+    if (s->sink(s->sink_ctx, data, len) != 0) return OTA_STREAM_ERR_SINK;
+    s->out_total += len;
+    return OTA_STREAM_OK;
+}
+
+/**
+ * @brief 解压输入，窗口满或输入耗尽时把新产生的数据交给写入回调
+ * @param last 没有更多输入
+ */
+static ota_stream_err_t stream_inflate(ota_stream_t* s, const uint8_t* in, size_t len, bool last) {
+    while (!s->done) {
+        size_t in_bytes = len;
+        size_t out_bytes = OTA_STREAM_DICT_SIZE - s->dict_ofs;
+        // 结束时也声明“还有输入”：不带该标志时，ROM 中的旧版 tinfl 以 0 补齐缺失的输入，
+        // 新版返回 FAILED_CANNOT_MAKE_PROGRESS，截断都会被误报为数据损坏
+        mz_uint32 flags = TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT;
+        tinfl_status status = tinfl_decompress(&s->inflator, in, &in_bytes, s->dict, s->dict + s->dict_ofs,
+                                               &out_bytes, flags);
+        in += in_bytes;
+        len -= in_bytes;
+
+        ota_stream_err_t err = emit(s, s->dict + s->dict_ofs, out_bytes);
+        if (err != OTA_STREAM_OK) return err;
+        s->dict_ofs = (s->dict_ofs + out_bytes) & (OTA_STREAM_DICT_SIZE - 1);
+
+        if (status == TINFL_STATUS_DONE) {
+            s->done = true;
+        } else if (status == TINFL_STATUS_NEEDS_MORE_INPUT) {
+            return last ? OTA_STREAM_ERR_TRUNCATED : OTA_STREAM_OK;
+        } else if (status < 0) {
+            return OTA_STREAM_ERR_DATA;
+        }
+        // TINFL_STATUS_HAS_MORE_OUTPUT：窗口已满，继续取输出
+    }
+    // 压缩流结束后的多余数据（如 zlib 尾部之后的填充）忽略
+    return OTA_STREAM_OK;
+}
+
+ota_stream_err_t ota_stream_feed(ota_stream_t* s, const uint8_t* data, size_t len) {
+    s->in_total += len;
+    if (!s->compressed) return emit(s, data, len);
+    return stream_inflate(s, data, len, false);
+}
+
+ota_stream_err_t ota_stream_finish(ota_stream_t* s) {
+    if (!s->compressed) return OTA_STREAM_OK;
+    return stream_inflate(s, NULL, 0, true);
+}
+
+const char* ota_stream_err_name(ota_stream_err_t err) {
+    switch (err) {
+    case OTA_STREAM_OK:            return "ok";
+    case OTA_STREAM_ERR_DATA:      return "corrupt";
+    case OTA_STREAM_ERR_TRUNCATED: return "truncated";
+    case OTA_STREAM_ERR_SINK:      return "write";
+    }
+    return "unknown";
+}
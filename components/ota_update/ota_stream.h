@@ -0,0 +1,65 @@
+#ifndef OTA_STREAM_H
+#define OTA_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include "rom/miniz.h"      // ROM 内置的 tinfl，不占用 flash
+#else
+#include "miniz.h"
+#endif
+
+/**
+ * @brief OTA 流式管线：下载数据按块送入，可选 zlib 解压后交给写入回调
+ *        不缓存整个镜像，解压只需要 32KB 滑动窗口（由调用方提供）
+ *        不依赖 ESP-IDF，可在主机上以文件作为分区进行测试
+ */
+
+#define OTA_STREAM_DICT_SIZE    TINFL_LZ_DICT_SIZE
+
+typedef enum {
+    OTA_STREAM_OK = 0,
+    OTA_STREAM_ERR_DATA,        // 压缩数据损坏
+    OTA_STREAM_ERR_TRUNCATED,   // 数据提前结束
+    OTA_STREAM_ERR_SINK,        // 写入回调失败
+} ota_stream_err_t;
+
+/**
+ * @brief 写入回调
+ * @return 0 成功，非 0 中止
+ */
+typedef int (*ota_stream_sink_t)(void* ctx, const uint8_t* data, size_t len);
+
+typedef struct {
+    bool compressed;
+    bool done;                  // 压缩流已结束
+    tinfl_decompressor inflator;
+    uint8_t* dict;              // OTA_STREAM_DICT_SIZE 字节环形窗口
+    size_t dict_ofs;
+    size_t in_total;            // 已输入字节
+    size_t out_total;           // 已写出字节
+    ota_stream_sink_t sink;
+    void* sink_ctx;
+} ota_stream_t;
+
+/**
+ * @param compressed true 表示输入为 zlib 流（带头），false 原样透传
+ * @param dict 解压窗口，compressed 为 false 时可为 NULL
+ */
+void ota_stream_init(ota_stream_t* s, bool compressed, uint8_t* dict, ota_stream_sink_t sink, void* ctx);
+
+/**
+ * @brief 送入一块下载数据
+ */
+ota_stream_err_t ota_stream_feed(ota_stream_t* s, const uint8_t* data, size_t len);
+
+/**
+ * @brief 下载结束，检查压缩流是否完整
+ */
+ota_stream_err_t ota_stream_finish(ota_stream_t* s);
+
+const char* ota_stream_err_name(ota_stream_err_t err);
+
+#endif // OTA_STREAM_H
@@ -0,0 +1,298 @@
+#include "ota_update.h"
+#include "ota_stream.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_http_client.h"
+#include "esp_crt_bundle.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "mbedtls/sha256.h"
+#include "power_mgmt.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "OTA";
+
+#define OTA_TASK_STACK          8192    // TLS 握手需要较大的栈
+#define OTA_TASK_PRIO           3
+#define OTA_TASK_CORE           0
+#define OTA_RECV_BUF            2048
+#define OTA_HTTP_TIMEOUT_MS     15000
+#define OTA_REBOOT_DELAY_MS     1000
+
+typedef struct {
+    char url[OTA_URL_MAX];
+    uint8_t sha256[32];
+    bool compressed;
+} ota_request_t;
+
+// 写入回调上下文
+typedef struct {
+    esp_ota_handle_t handle;
+    mbedtls_sha256_context sha;
+} ota_sink_ctx_t;
+
+static ota_status_callback_t s_callback = NULL;
+static ota_request_t s_request;
+static volatile bool s_busy = false;
+static bool s_pending_verify = false;
+static esp_timer_handle_t s_health_timer = NULL;
+
+static void notify(ota_state_t state, uint8_t progress, uint32_t received, uint32_t written, const char* error) {
+    ota_status_t status = {
+        .state = state,
+        .progress = progress,
+        .received = received,
+        .written = written,
+        .error = error,
+    };
+    if (s_callback) s_callback(&status);
+}
+
+static bool parse_hex(const char* hex, uint8_t* out, size_t len) {
+    if (!hex || strlen(hex) != len * 2) return false;
+    for (size_t i = 0; i < len * 2; i++) {
+        char c = hex[i];
+        int v = (c >= '0' && c <= '9') ? c - '0'
+              : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+              : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+        if (v < 0) return false;
+        if (i & 1) {
+            out[i / 2] |= (uint8_t)v;
+        } else {
+            out[i / 2] = (uint8_t)(v << 4);
+        }
+    }
+    return true;
+}
+
+static int sink_write(void* arg, const uint8_t* data, size_t len) {
+    ota_sink_ctx_t* ctx = arg;
+    mbedtls_sha256_update(&ctx->sha, data, len);
+    return esp_ota_write(ctx->handle, data, len) == ESP_OK ? 0 : -1;
+}
+
+/**
+ * @brief 下载并写入，成功时不返回（重启）
+ * @return 失败原因
+ */
+static const char* ota_run(const ota_request_t* req) {
+    const esp_partition_t* partition = esp_ota_get_next_update_partition(NULL);
+    if (!partition) return "no_partition";
+
+    esp_http_client_config_t http_cfg = {
+        .url = req->url,
+        .timeout_ms = OTA_HTTP_TIMEOUT_MS,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .keep_alive_enable = true,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&http_cfg);
+    if (!client) return "http_init";
+
+    const char* error = NULL;
+    uint8_t* buf = NULL;
+    uint8_t* dict = NULL;
+    ota_stream_t* stream = NULL;
+    ota_sink_ctx_t sink = { 0 };
+    bool ota_begun = false;
+    mbedtls_sha256_init(&sink.sha);
+
+    if (esp_http_client_open(client, 0) != ESP_OK) {
+        error = "connect";
+        goto cleanup;
+    }
+    int64_t content_len = esp_http_client_fetch_headers(client);
+    if (esp_http_client_get_status_code(client) != 200) {
+        error = "http_status";
+        goto cleanup;
+    }
+
+    // 只在更新期间占用：接收缓冲、32KB 解压窗口和解压器状态
+    buf = malloc(OTA_RECV_BUF);
+    stream = malloc(sizeof(*stream));
+    if (req->compressed) {
+        dict = heap_caps_malloc(OTA_STREAM_DICT_SIZE, MALLOC_CAP_8BIT);
+    }
+    if (!buf || !stream || (req->compressed && !dict)) {
+        error = "no_memory";
+        goto cleanup;
+    }
+
+    if (esp_ota_begin(partition, OTA_WITH_SEQUENTIAL_WRITES, &sink.handle) != ESP_OK) {
+        error = "ota_begin";
+        goto cleanup;
+    }
+    ota_begun = true;
+    mbedtls_sha256_starts(&sink.sha, 0);
+    ota_stream_init(stream, req->compressed, dict, sink_write, &sink);
+
+    ESP_LOGI(TAG, "写入分区 %s, 长度 %lld%s", partition->label, content_len, req->compressed ? "（压缩）" : "");
+    uint8_t last_progress = 0;
+    notify(OTA_STATE_DOWNLOADING, 0, 0, 0, NULL);
+    while (true) {
+        int n = esp_http_client_read(client, (char*)buf, OTA_RECV_BUF);
+        if (n < 0) {
+            error = "read";
+            goto cleanup;
+        }
+        if (n == 0) {
+            if (!esp_http_client_is_complete_data_received(client)) {
+                error = "connection_closed";
+                goto cleanup;
+            }
+            break;
+        }
+        ota_stream_err_t err = ota_stream_feed(stream, buf, n);
+        if (err != OTA_STREAM_OK) {
+            error = ota_stream_err_name(err);
+            goto cleanup;
+        }
+        if (content_len > 0) {
+            uint8_t progress = (uint8_t)(stream->in_total * 100 / content_len);
+            if (progress / 10 != last_progress / 10) {
+                last_progress = progress;
+                notify(OTA_STATE_DOWNLOADING, progress, stream->in_total, stream->out_total, NULL);
+            }
+        }
+    }
+    ota_stream_err_t err = ota_stream_finish(stream);
+    if (err != OTA_STREAM_OK) {
+        error = ota_stream_err_name(err);
+        goto cleanup;
+    }
+
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&sink.sha, digest);
+    if (memcmp(digest, req->sha256, sizeof(digest)) != 0) {
+        error = "sha256_mismatch";
+        goto cleanup;
+    }
+    // esp_ota_end 还会校验镜像头和追加的校验和
+    ota_begun = false;
+    if (esp_ota_end(sink.handle) != ESP_OK) {
+        error = "image_invalid";
+        goto cleanup;
+    }
+    if (esp_ota_set_boot_partition(partition) != ESP_OK) {
+        error = "set_boot";
+        goto cleanup;
+    }
+
+    ESP_LOGI(TAG, "更新完成: 下载 %u 字节, 写入 %u 字节，重启", (unsigned)stream->in_total, (unsigned)stream->out_total);
+    notify(OTA_STATE_REBOOTING, 100, stream->in_total, stream->out_total, NULL);
+    vTaskDelay(pdMS_TO_TICKS(OTA_REBOOT_DELAY_MS));
+    esp_restart();
+
+cleanup:
+    if (ota_begun) esp_ota_abort(sink.handle);
+    mbedtls_sha256_free(&sink.sha);
+    esp_http_client_close(client);
+    esp_http_client_cleanup(client);
+    if (stream) {
+        notify(OTA_STATE_FAILED, 0, stream->in_total, stream->out_total, error);
+    } else {
+        notify(OTA_STATE_FAILED, 0, 0, 0, error);
+    }
+    free(stream);
+    free(dict);
+    free(buf);
+    return error;
+}
+
+static void ota_task(void* arg) {
+    power_mgmt_acquire(PM_LOCK_OTA);
+    const char* error = ota_run(&s_request);
+    power_mgmt_release(PM_LOCK_OTA);
+    ESP_LOGE(TAG, "更新失败: %s", error);
+    s_busy = false;
+    vTaskDelete(NULL);
+}
+
+bool ota_update_start(const char* url, const char* sha256_hex, bool compressed) {
+    if (s_busy) {
+        ESP_LOGW(TAG, "已有更新在进行");
+        return false;
+    }
+    if (!url || (strncmp(url, "http://", 7) != 0 && strncmp(url, "https://", 8) != 0) ||
+        strlen(url) >= sizeof(s_request.url)) {
+        ESP_LOGE(TAG, "无效的 URL");
+        return false;
+    }
+    if (!parse_hex(sha256_hex, s_request.sha256, sizeof(s_request.sha256))) {
+        ESP_LOGE(TAG, "无效的 SHA-256");
+        return false;
+    }
+    strlcpy(s_request.url, url, sizeof(s_request.url));
+    s_request.compressed = compressed;
+
+    s_busy = true;
+    if (xTaskCreatePinnedToCore(ota_task, "ota_task", OTA_TASK_STACK, NULL, OTA_TASK_PRIO, NULL,
+                                OTA_TASK_CORE) != pdPASS) {
+        s_busy = false;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 健康确认超时：回滚到上一个镜像并重启
+ */
+static void health_timeout_cb(void* arg) {
+    ESP_LOGE(TAG, "新镜像未在 %d 秒内确认健康，回滚", OTA_HEALTH_TIMEOUT_MS / 1000);
+    esp_ota_mark_app_invalid_rollback_and_reboot();
+}
+
+void ota_update_init(ota_status_callback_t callback) {
+    s_callback = callback;
+
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(running, &state) == ESP_OK && state == ESP_OTA_IMG_PENDING_VERIFY) {
+        s_pending_verify = true;
+        const esp_timer_create_args_t args = {
+            .callback = health_timeout_cb,
+            .name = "ota_health",
+        };
+        if (esp_timer_create(&args, &s_health_timer) == ESP_OK) {
+            esp_timer_start_once(s_health_timer, (uint64_t)OTA_HEALTH_TIMEOUT_MS * 1000);
+        }
+        ESP_LOGW(TAG, "运行新镜像 %s，等待健康确认", running->label);
+    }
+
+    const esp_partition_t* invalid = esp_ota_get_last_invalid_partition();
+    if (invalid) {
+        ESP_LOGW(TAG, "分区 %s 的镜像未通过确认，已回滚", invalid->label);
+    }
+}
+
+bool ota_update_pending_verify(void) {
+    return s_pending_verify;
+}
+
+void ota_update_confirm(void) {
+    if (!s_pending_verify) return;
+    if (s_health_timer) {
+        esp_timer_stop(s_health_timer);
+    }
+    if (esp_ota_mark_app_valid_cancel_rollback() != ESP_OK) {
+        ESP_LOGE(TAG, "确认新镜像失败");
+        return;
+    }
+    s_pending_verify = false;
+    ESP_LOGI(TAG, "新镜像已确认");
+    notify(OTA_STATE_CONFIRMED, 100, 0, 0, NULL);
+}
+
+const char* ota_update_state_name(ota_state_t state) {
+    switch (state) {
+    case OTA_STATE_IDLE:        return "idle";
+    case OTA_STATE_DOWNLOADING: return "downloading";
+    case OTA_STATE_REBOOTING:   return "rebooting";
+    case OTA_STATE_FAILED:      return "failed";
+    case OTA_STATE_CONFIRMED:   return "confirmed";
+    }
+    return "unknown";
+}
@@ -0,0 +1,63 @@
+#ifndef OTA_UPDATE_H
+#define OTA_UPDATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief HTTP(S) 拉取式 OTA：流式写入非活动分区，可选 zlib 压缩镜像边下边解压，
+ *        校验解压后镜像的 SHA-256 后切换启动分区并重启。
+ *        新镜像启动后处于待验证状态，需在 OTA_HEALTH_TIMEOUT_MS 内调用 ota_update_confirm()，
+ *        否则回滚到上一个分区；确认前崩溃重启由 bootloader 回滚
+ */
+
+#define OTA_URL_MAX             256
+#define OTA_SHA256_HEX_LEN      64
+#define OTA_HEALTH_TIMEOUT_MS   (5 * 60 * 1000)
+
+typedef enum {
+    OTA_STATE_IDLE = 0,
+    OTA_STATE_DOWNLOADING,
+    OTA_STATE_REBOOTING,        // 校验通过，即将以新镜像重启
+    OTA_STATE_FAILED,
+    OTA_STATE_CONFIRMED,        // 新镜像已通过健康确认
+} ota_state_t;
+
+typedef struct {
+    ota_state_t state;
+    uint8_t progress;           // 下载进度（%），服务器未给出长度时为 0
+    uint32_t received;          // 已下载字节
+    uint32_t written;           // 已写入分区字节（解压后）
+    const char* error;          // 失败原因，其他状态为 NULL
+} ota_status_t;
+
+typedef void (*ota_status_callback_t)(const ota_status_t* status);
+
+/**
+ * @brief 启动时调用：检查当前镜像是否待验证，是则开始健康确认计时
+ * @param callback 状态回调，在 OTA 任务或定时器上下文中调用
+ */
+void ota_update_init(ota_status_callback_t callback);
+
+/**
+ * @brief 开始一次更新（在独立任务中执行）
+ * @param url http:// 或 https://（使用证书包校验服务器）
+ * @param sha256_hex 写入分区的镜像（解压后）的 SHA-256，64 位十六进制
+ * @param compressed 镜像为 zlib 压缩流
+ * @return false 参数无效或已有更新在进行
+ */
+bool ota_update_start(const char* url, const char* sha256_hex, bool compressed);
+
+/**
+ * @brief 当前镜像是否仍在等待健康确认
+ */
+bool ota_update_pending_verify(void);
+
+/**
+ * @brief 确认新镜像运行正常，取消回滚
+ */
+void ota_update_confirm(void);
+
+const char* ota_update_state_name(ota_state_t state);
+
+#endif // OTA_UPDATE_H
@@ -0,0 +1,97 @@
+#include "pm_accounting.h"
+#include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
+
+static void pm_acct_switch_state(pm_accounting_t* acct, pm_state_t state, uint64_t now_us) {
+    if (acct->state == state) return;
+    acct->state_us[acct->state] += now_us - acct->state_since_us;
+    acct->state = state;
+    acct->state_since_us = now_us;
+}
+
+void pm_acct_init(pm_accounting_t* acct, uint64_t now_us) {
+    memset(acct, 0, sizeof(*acct));
+    acct->state = PM_STATE_LOW_POWER;
+    acct->state_since_us = now_us;
+}
+
+bool pm_acct_acquire(pm_accounting_t* acct, int lock, uint64_t now_us) {
+    if (lock < 0 || lock >= PM_ACCT_MAX_LOCKS) return false;
+    if (acct->depth[lock]++ > 0) return false;  // 嵌套获取，硬件锁已持有
+
+    acct->acquire_count[lock]++;
+    acct->held_since_us[lock] = now_us;
+    if (acct->active_locks++ == 0) {
+        pm_acct_switch_state(acct, PM_STATE_ACTIVE, now_us);
+    }
+    return true;
+}
+
+bool pm_acct_release(pm_accounting_t* acct, int lock, uint64_t now_us) {
+    if (lock < 0 || lock >= PM_ACCT_MAX_LOCKS) return false;
+    if (acct->depth[lock] == 0) {
+        acct->unbalanced_release++;
+        return false;
+    }
+    if (--acct->depth[lock] > 0) return false;
+
+    acct->held_us[lock] += now_us - acct->held_since_us[lock];
+    if (--acct->active_locks == 0) {
+        pm_acct_switch_state(acct, PM_STATE_LOW_POWER, now_us);
+    }
+    return true;
+}
+
+void pm_acct_snapshot(const pm_accounting_t* acct, uint64_t now_us, pm_accounting_t* out) {
+    *out = *acct;
+    out->state_us[out->state] += now_us - out->state_since_us;
+    out->state_since_us = now_us;
+    for (int i = 0; i < PM_ACCT_MAX_LOCKS; i++) {
+        if (out->depth[i] > 0) {
+            out->held_us[i] += now_us - out->held_since_us[i];
+            out->held_since_us[i] = now_us;
+        }
+    }
+}
+
+bool pm_mode_stats_parse(const char* text, pm_mode_stats_t* out) {
+    static const char* const names[PM_CHIP_MODE_MAX] = {
+        [PM_CHIP_SLEEP]   = "SLEEP",
+        [PM_CHIP_APB_MIN] = "APB_MIN",
+        [PM_CHIP_APB_MAX] = "APB_MAX",
+        [PM_CHIP_CPU_MAX] = "CPU_MAX",
+    };
+    memset(out, 0, sizeof(*out));
+    const char* line = text ? strstr(text, "Mode stats:") : NULL;
+    if (!line) return false;
+
+    // 每行形如 "CPU_MAX   240M        123456      12%"，表头和空行不匹配
+    bool found = false;
+    while ((line = strchr(line, '\n')) != NULL) {
+        line++;
+        char name[16];
+        uint32_t mhz;
+        int64_t us;
+        if (sscanf(line, "%15s %" SCNu32 "M %" SCNd64, name, &mhz, &us) != 3 || us < 0) {
+            if (strncmp(line, "Sleep stats:", 12) == 0) break;
+            continue;
+        }
+        for (int i = 0; i < PM_CHIP_MODE_MAX; i++) {
+            if (strcmp(name, names[i]) == 0) {
+                out->mode_us[i] = (uint64_t)us;
+                found = true;
+            }
+        }
+    }
+
+    const char* sleep = strstr(text, "light_sleep_counts:");
+    if (sleep) {
+        long counts = 0, rejects = 0;
+        if (sscanf(sleep, "light_sleep_counts:%ld light_sleep_reject_counts:%ld", &counts, &rejects) == 2) {
+            out->light_sleeps = (uint32_t)counts;
+            out->sleep_rejects = (uint32_t)rejects;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,78 @@
+#ifndef PM_ACCOUNTING_H
+#define PM_ACCOUNTING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief 电源锁记账（纯C实现，不依赖ESP-IDF，可在主机上编译测试）
+ *        时间戳由调用者传入，单位微秒
+ */
+
+#define PM_ACCT_MAX_LOCKS 6
+
+// 锁状态：持有任意锁时本固件要求全速，否则允许降频/浅睡眠
+// 只是本固件的请求，其他组件（如 WiFi 驱动）的锁不计入，不代表芯片实际的频率或睡眠时间
+typedef enum {
+    PM_STATE_ACTIVE = 0,   // 至少一个锁被持有，CPU/APB全速
+    PM_STATE_LOW_POWER,    // 本固件无锁，允许DFS降频和tickless浅睡眠
+    PM_STATE_MAX
+} pm_state_t;
+
+typedef struct {
+    uint8_t  depth[PM_ACCT_MAX_LOCKS];          // 每个锁的嵌套深度
+    uint32_t acquire_count[PM_ACCT_MAX_LOCKS];  // 获取次数（仅计最外层）
+    uint64_t held_us[PM_ACCT_MAX_LOCKS];        // 累计持有时间
+    uint64_t held_since_us[PM_ACCT_MAX_LOCKS];  // 最外层获取时刻
+    uint32_t unbalanced_release;                // 未配对的释放次数
+    uint8_t  active_locks;                      // 当前被持有的锁数量
+    pm_state_t state;                           // 当前电源状态
+    uint64_t state_since_us;                    // 进入当前状态的时刻
+    uint64_t state_us[PM_STATE_MAX];            // 每个状态的累计时间
+} pm_accounting_t;
+
+/**
+ * @brief 初始化记账结构，从低功耗状态开始计时
+ */
+void pm_acct_init(pm_accounting_t* acct, uint64_t now_us);
+
+/**
+ * @brief 记录一次锁获取
+ * @return true 表示这是最外层获取（需要真正获取硬件锁）
+ */
+bool pm_acct_acquire(pm_accounting_t* acct, int lock, uint64_t now_us);
+
+/**
+ * @brief 记录一次锁释放
+ * @return true 表示这是最外层释放（需要真正释放硬件锁）
+ */
+bool pm_acct_release(pm_accounting_t* acct, int lock, uint64_t now_us);
+
+/**
+ * @brief 把仍在进行中的状态和锁持有时间结算到 now_us，生成快照
+ */
+void pm_acct_snapshot(const pm_accounting_t* acct, uint64_t now_us, pm_accounting_t* out);
+
+// 芯片实际电源模式（esp_pm 的模式划分），时间来自 CONFIG_PM_PROFILING 下的 esp_pm_dump_locks
+typedef enum {
+    PM_CHIP_SLEEP = 0,     // 浅睡眠（未启用浅睡眠时不出现）
+    PM_CHIP_APB_MIN,       // 无锁，降到最低频率
+    PM_CHIP_APB_MAX,       // APB 全速
+    PM_CHIP_CPU_MAX,       // CPU 全速
+    PM_CHIP_MODE_MAX
+} pm_chip_mode_t;
+
+typedef struct {
+    uint64_t mode_us[PM_CHIP_MODE_MAX];  // 自启动以来各模式的累计时间
+    uint32_t light_sleeps;               // 进入浅睡眠次数
+    uint32_t sleep_rejects;              // 浅睡眠被拒绝次数（唤醒源已触发等）
+} pm_mode_stats_t;
+
+/**
+ * @brief 解析 esp_pm_dump_locks 输出中的 "Mode stats" 和 "Sleep stats" 段
+ * @param text 以 '\0' 结尾的完整输出
+ * @return 至少解析到一个模式时返回 true
+ */
+bool pm_mode_stats_parse(const char* text, pm_mode_stats_t* out);
+
+#endif // PM_ACCOUNTING_H
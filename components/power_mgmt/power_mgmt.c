@@ -0,0 +1,161 @@
+#include "power_mgmt.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char* TAG = "POWER_MGMT";
+
+// DFS 下限频率（XTAL），上限为 menuconfig 中的默认 CPU 频率
+#define PM_MIN_FREQ_MHZ 40
+// beacon 间隔 100 TU = 102.4 ms，以 0.1ms 为单位避免浮点
+#define PM_BEACON_INTERVAL_100US 1024
+// esp_pm_dump_locks 输出缓冲：模式统计在锁表之后，截断就会丢失
+#define PM_DUMP_MAX 3072
+
+_Static_assert(PM_LOCK_MAX <= PM_ACCT_MAX_LOCKS, "记账结构容纳不下所有电源锁");
+
+static pm_accounting_t s_acct;
+static portMUX_TYPE s_acct_mux = portMUX_INITIALIZER_UNLOCKED;
+
+#ifdef CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t s_locks[PM_LOCK_MAX];
+
+// 各事务需要的锁类型：1-Wire 位时序依赖 CPU 忙等延时，需锁定 CPU 频率
+static const esp_pm_lock_type_t s_lock_types[PM_LOCK_MAX] = {
+    [PM_LOCK_I2C]     = ESP_PM_APB_FREQ_MAX,
+    [PM_LOCK_ONEWIRE] = ESP_PM_CPU_FREQ_MAX,
+    [PM_LOCK_LEDC]    = ESP_PM_APB_FREQ_MAX,
+    [PM_LOCK_OTA]     = ESP_PM_CPU_FREQ_MAX,
+    [PM_LOCK_TACH]    = ESP_PM_NO_LIGHT_SLEEP,
+    [PM_LOCK_INPUT]   = ESP_PM_NO_LIGHT_SLEEP,
+};
+static const char* s_lock_names[PM_LOCK_MAX] = {
+    [PM_LOCK_I2C]     = "i2c",
+    [PM_LOCK_ONEWIRE] = "onewire",
+    [PM_LOCK_LEDC]    = "ledc",
+    [PM_LOCK_OTA]     = "ota",
+    [PM_LOCK_TACH]    = "tach",
+    [PM_LOCK_INPUT]   = "input",
+};
+#endif
+
+/**
+ * @brief 初始化电源管理
+ */
+void power_mgmt_init(void) {
+    pm_acct_init(&s_acct, esp_timer_get_time());
+
+#ifdef CONFIG_PM_ENABLE
+    for (int i = 0; i < PM_LOCK_MAX; i++) {
+        ESP_ERROR_CHECK(esp_pm_lock_create(s_lock_types[i], 0, s_lock_names[i], &s_locks[i]));
+    }
+
+    // LEDC 使用 RC_FAST 时钟，浅睡眠期间需保持该时钟域供电，PWM 才不会中断
+    esp_sleep_pd_config(ESP_PD_DOMAIN_RC_FAST, ESP_PD_OPTION_ON);
+
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = PM_MIN_FREQ_MHZ,
+#ifdef CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        .light_sleep_enable = true,
+#endif
+    };
+    ESP_ERROR_CHECK(esp_pm_configure(&pm_config));
+    ESP_LOGI(TAG, "电源管理已启用: %d-%d MHz, 浅睡眠=%d",
+             PM_MIN_FREQ_MHZ, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, pm_config.light_sleep_enable);
+#else
+    ESP_LOGI(TAG, "CONFIG_PM_ENABLE 未开启，仅记录锁统计");
+#endif
+}
+
+void power_mgmt_acquire(pm_lock_id_t id) {
+    if (id >= PM_LOCK_MAX) return;
+    portENTER_CRITICAL(&s_acct_mux);
+    bool outermost = pm_acct_acquire(&s_acct, id, esp_timer_get_time());
+    portEXIT_CRITICAL(&s_acct_mux);
+#ifdef CONFIG_PM_ENABLE
+    if (outermost) esp_pm_lock_acquire(s_locks[id]);
+#else
+    (void)outermost;
+#endif
+}
+
+void power_mgmt_release(pm_lock_id_t id) {
+    if (id >= PM_LOCK_MAX) return;
+    portENTER_CRITICAL(&s_acct_mux);
+    bool outermost = pm_acct_release(&s_acct, id, esp_timer_get_time());
+    portEXIT_CRITICAL(&s_acct_mux);
+#ifdef CONFIG_PM_ENABLE
+    if (outermost) esp_pm_lock_release(s_locks[id]);
+#else
+    (void)outermost;
+#endif
+}
+
+/**
+ * @brief 开启 WiFi modem sleep
+ */
+void power_mgmt_enable_modem_sleep(void) {
+#ifdef CONFIG_PM_ENABLE
+    // MAX_MODEM 按 listen_interval 唤醒，间隔由 wifi_provision 在连接前配置
+    esp_err_t err = esp_wifi_set_ps(WIFI_PS_MAX_MODEM);
+#else
+    esp_err_t err = esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
+#endif
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "设置 modem sleep 失败: %s", esp_err_to_name(err));
+    }
+}
+
+/**
+ * @brief keepalive 对齐：选取使 PINGREQ 间隔距唤醒周期整数倍最近的秒数
+ */
+int power_mgmt_align_keepalive(int keepalive_s, int listen_interval) {
+    if (keepalive_s <= 2 || listen_interval <= 0) return keepalive_s;
+
+    const int64_t period = (int64_t)PM_BEACON_INTERVAL_100US * listen_interval;
+    int best_s = keepalive_s;
+    int64_t best_err = period;
+    // 只在 [keepalive/2, keepalive] 中搜索，避免 keepalive 缩短太多
+    for (int s = keepalive_s; s >= keepalive_s / 2; s--) {
+        int64_t half_100us = (int64_t)s * 5000;  // keepalive/2，单位0.1ms
+        int64_t err = half_100us % period;
+        if (period - err < err) err = period - err;
+        if (err < best_err) {
+            best_err = err;
+            best_s = s;
+            if (err == 0) break;
+        }
+    }
+    return best_s;
+}
+
+void power_mgmt_get_stats(pm_accounting_t* stats) {
+    portENTER_CRITICAL(&s_acct_mux);
+    pm_acct_snapshot(&s_acct, esp_timer_get_time(), stats);
+    portEXIT_CRITICAL(&s_acct_mux);
+}
+
+bool power_mgmt_get_mode_stats(pm_mode_stats_t* stats) {
+#if defined(CONFIG_PM_ENABLE) && defined(CONFIG_PM_PROFILING)
+    static char dump[PM_DUMP_MAX];
+    memset(dump, 0, sizeof(dump));
+    // 末字节留作结尾 '\0'
+    FILE* f = fmemopen(dump, sizeof(dump) - 1, "w");
+    if (!f) {
+        memset(stats, 0, sizeof(*stats));
+        return false;
+    }
+    esp_pm_dump_locks(f);
+    fclose(f);
+    return pm_mode_stats_parse(dump, stats);
+#else
+    memset(stats, 0, sizeof(*stats));
+    return false;
+#endif
+}
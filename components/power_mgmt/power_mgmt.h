@@ -0,0 +1,65 @@
+#ifndef POWER_MGMT_H
+#define POWER_MGMT_H
+
+#include <stdint.h>
+#include "pm_accounting.h"
+
+// WiFi modem sleep 监听间隔（单位：beacon，约102.4ms）
+#define POWER_MGMT_LISTEN_INTERVAL 3
+
+// 需要全速运行的外设事务类型
+typedef enum {
+    PM_LOCK_I2C = 0,    // OLED I2C 传输
+    PM_LOCK_ONEWIRE,    // DS18B20 1-Wire 时序（位时序对频率敏感）
+    PM_LOCK_LEDC,       // LEDC 占空比更新
+    PM_LOCK_OTA,        // OTA 下载、解压和写入期间保持全速
+    PM_LOCK_TACH,       // 风扇测速期间禁止浅睡眠（PCNT 在浅睡眠中停止计数）
+    PM_LOCK_INPUT,      // 编码器/按键操作后一段时间内禁止浅睡眠，连续转动的边沿不因唤醒延迟丢失
+    PM_LOCK_MAX
+} pm_lock_id_t;
+
+/**
+ * @brief 初始化电源管理：DFS动态调频 + tickless idle 浅睡眠
+ *        未启用 CONFIG_PM_ENABLE 时仅做锁记账
+ */
+void power_mgmt_init(void);
+
+/**
+ * @brief 在外设事务开始前获取电源锁（可嵌套）
+ * @param id 锁类型
+ */
+void power_mgmt_acquire(pm_lock_id_t id);
+
+/**
+ * @brief 在外设事务结束后释放电源锁
+ * @param id 锁类型
+ */
+void power_mgmt_release(pm_lock_id_t id);
+
+/**
+ * @brief 开启 WiFi modem sleep，需在 Station 连接成功后调用
+ */
+void power_mgmt_enable_modem_sleep(void);
+
+/**
+ * @brief 将 MQTT keepalive 对齐到 modem sleep 唤醒周期（listen_interval × beacon 间隔）
+ *        esp-mqtt 在 keepalive/2 时发送 PINGREQ，使其间隔尽量是唤醒周期的整数倍
+ * @param keepalive_s 期望的 keepalive 秒数
+ * @param listen_interval 监听间隔（beacon 个数）
+ * @return 对齐后的 keepalive 秒数（不大于期望值）
+ */
+int power_mgmt_align_keepalive(int keepalive_s, int listen_interval);
+
+/**
+ * @brief 获取本固件电源锁的持有时间统计快照
+ *        只反映本组件管理的锁，WiFi 驱动等持有的锁和实际睡眠时间不在其中
+ */
+void power_mgmt_get_stats(pm_accounting_t* stats);
+
+/**
+ * @brief 获取芯片实际处于各电源模式（浅睡眠/降频/全速）的累计时间
+ *        需要 CONFIG_PM_PROFILING；未启用时返回 false。只应在单个任务中调用（共用静态缓冲）
+ */
+bool power_mgmt_get_mode_stats(pm_mode_stats_t* stats);
+
+#endif // POWER_MGMT_H
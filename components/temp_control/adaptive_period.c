@@ -0,0 +1,57 @@
+#include "adaptive_period.h"
+#include <math.h>
+#include <string.h>
+
+#define STRETCH_NUM 3
+#define STRETCH_DEN 2
+
+void adaptive_period_init(adaptive_period_t* ap, uint32_t min_ms, uint32_t max_ms,
+                          float step_c, float error_band_c, float error_full_c) {
+    memset(ap, 0, sizeof(*ap));
+    ap->min_ms = min_ms;
+    ap->max_ms = max_ms;
+    ap->step_c = step_c;
+    ap->error_band_c = error_band_c;
+    ap->error_full_c = error_full_c;
+    ap->period_ms = min_ms;
+}
+
+uint32_t adaptive_period_update(adaptive_period_t* ap, float rate_c_s, float error_c) {
+    float span = (float)(ap->max_ms - ap->min_ms);
+    float target = (float)ap->max_ms;
+
+    // 变化率：一个周期内温度变化不超过 step_c
+    float rate = fabsf(rate_c_s);
+    if (rate > 0.0f) {
+        float by_rate = ap->step_c / rate * 1000.0f;
+        if (by_rate < target) target = by_rate;
+    }
+    // 误差：超出死区后按比例缩短
+    float excess = error_c - ap->error_band_c;
+    if (excess > 0.0f) {
+        float width = ap->error_full_c - ap->error_band_c;
+        float frac = width > 0.0f ? excess / width : 1.0f;
+        if (frac > 1.0f) frac = 1.0f;
+        float by_error = (float)ap->max_ms - frac * span;
+        if (by_error < target) target = by_error;
+    }
+    if (target < (float)ap->min_ms) target = (float)ap->min_ms;
+
+    uint32_t next = (uint32_t)target;
+    if (next > ap->period_ms) {
+        // 拉长时限速，缩短时立即生效
+        uint32_t limit = ap->period_ms * STRETCH_NUM / STRETCH_DEN;
+        if (next > limit) next = limit;
+    }
+    if (next > ap->max_ms) next = ap->max_ms;
+    ap->period_ms = next;
+    return next;
+}
+
+uint32_t adaptive_period_scale(uint32_t period_ms, uint32_t num, uint32_t den,
+                               uint32_t lo_ms, uint32_t hi_ms) {
+    uint64_t ms = (uint64_t)period_ms * num / den;
+    if (ms < lo_ms) ms = lo_ms;
+    if (ms > hi_ms) ms = hi_ms;
+    return (uint32_t)ms;
+}
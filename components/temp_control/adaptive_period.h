@@ -0,0 +1,42 @@
+#ifndef ADAPTIVE_PERIOD_H
+#define ADAPTIVE_PERIOD_H
+
+#include <stdint.h>
+
+/**
+ * @brief 按热动态调整控制周期
+ *        温度变化快或高于设定值较多时立即缩短到下限，稳定后每次最多拉长 1.5 倍，
+ *        避免在两个周期之间来回振荡
+ *        纯C实现，不依赖ESP-IDF
+ */
+
+typedef struct {
+    uint32_t min_ms;            // 周期下限（不低于一次温度转换的时间）
+    uint32_t max_ms;            // 周期上限
+    float step_c;               // 每个周期允许的温度变化（°C），周期 ≈ step_c / |dT/dt|
+    float error_band_c;         // 高于设定值不超过此值时不因误差缩短周期
+    float error_full_c;         // 高于设定值达到此值时周期取下限
+    uint32_t period_ms;         // 当前周期
+} adaptive_period_t;
+
+/**
+ * @brief 初始化，初始周期为下限（启动时先快速收敛）
+ */
+void adaptive_period_init(adaptive_period_t* ap, uint32_t min_ms, uint32_t max_ms,
+                          float step_c, float error_band_c, float error_full_c);
+
+/**
+ * @brief 根据当前变化率和误差计算下一个周期
+ * @param rate_c_s 估计变化率（°C/s）
+ * @param error_c 测量值减设定值（°C）；低于设定值时输出只会维持在低位，只看变化率
+ * @return 下一个周期（毫秒）
+ */
+uint32_t adaptive_period_update(adaptive_period_t* ap, float rate_c_s, float error_c);
+
+/**
+ * @brief 按比例派生其他节拍（传感器、遥测、显示）并限制在各自范围内
+ */
+uint32_t adaptive_period_scale(uint32_t period_ms, uint32_t num, uint32_t den,
+                               uint32_t lo_ms, uint32_t hi_ms);
+
+#endif // ADAPTIVE_PERIOD_H
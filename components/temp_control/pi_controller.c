@@ -0,0 +1,40 @@
+#include "pi_controller.h"
+#include <string.h>
+
+void pi_controller_init(pi_controller_t* pi, float kp, float ki) {
+    memset(pi, 0, sizeof(*pi));
+    pi->kp = kp;
+    pi->ki = ki;
+}
+
+void pi_controller_reset(pi_controller_t* pi) {
+    pi->integral = 0.0f;
+    pi->initialized = false;
+}
+
+float pi_controller_update(pi_controller_t* pi, float setpoint, float measurement,
+                           float dt_s, float bumpless, float out_max) {
+    float error = measurement - setpoint;
+    float p = pi->kp * error;
+
+    if (!pi->initialized) {
+        // 无扰切换：让 P + I 等于切换前的输出
+        pi->integral = bumpless - p;
+        pi->initialized = true;
+    } else if (dt_s > 0.0f) {
+        float candidate = pi->integral + pi->ki * error * dt_s;
+        float out = p + candidate;
+        // 条件积分：输出已饱和且误差继续推向饱和方向时停止积分
+        bool saturating = (out > out_max && error > 0.0f) || (out < 0.0f && error < 0.0f);
+        if (!saturating) {
+            pi->integral = candidate;
+        }
+    }
+    if (pi->integral > out_max) pi->integral = out_max;
+    if (pi->integral < 0.0f) pi->integral = 0.0f;
+
+    float out = p + pi->integral;
+    if (out > out_max) out = out_max;
+    if (out < 0.0f) out = 0.0f;
+    return out;
+}
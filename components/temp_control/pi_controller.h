@@ -0,0 +1,38 @@
+#ifndef PI_CONTROLLER_H
+#define PI_CONTROLLER_H
+
+#include <stdbool.h>
+
+/**
+ * @brief 温度 PI 控制器（反作用：温度高于设定值时输出增大）
+ *        积分项带条件积分抗饱和，输出限幅由调用方每周期给定
+ *        纯C实现，不依赖ESP-IDF
+ */
+
+typedef struct {
+    float kp;                   // 比例增益（%/°C）
+    float ki;                   // 积分增益（%/(°C·s)）
+    float integral;             // 积分项（%）
+    bool initialized;           // 首次更新时按当前输出做无扰切换
+} pi_controller_t;
+
+void pi_controller_init(pi_controller_t* pi, float kp, float ki);
+
+/**
+ * @brief 清空积分项，下一次更新时重新做无扰切换
+ */
+void pi_controller_reset(pi_controller_t* pi);
+
+/**
+ * @brief 计算一次控制输出
+ * @param setpoint 设定温度（°C）
+ * @param measurement 当前温度（°C）
+ * @param dt_s 距上次更新的时间（秒）
+ * @param bumpless 首次更新时希望接续的输出（%），用于从其他控制律切换过来
+ * @param out_max 输出上限（%），下限固定为 0
+ * @return 控制输出（%）
+ */
+float pi_controller_update(pi_controller_t* pi, float setpoint, float measurement,
+                           float dt_s, float bumpless, float out_max);
+
+#endif // PI_CONTROLLER_H
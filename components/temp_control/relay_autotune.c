@@ -0,0 +1,135 @@
+#include "relay_autotune.h"
+#include <math.h>
+#include <string.h>
+
+#define AUTOTUNE_INVALID_TEMP   (-127.0f)
+// 有效周期之间周期、振幅允许的相对差异
+#define AUTOTUNE_MAX_SPREAD     0.3f
+
+void relay_autotune_default_config(autotune_config_t* cfg, float setpoint) {
+    cfg->setpoint = setpoint;
+    cfg->hysteresis = 0.2f;
+    cfg->output_high = 100;
+    cfg->output_low = 0;
+    cfg->cycles = 3;
+    cfg->max_excursion = 8.0f;
+    cfg->timeout_ms = 2 * 60 * 60 * 1000;
+}
+
+void relay_autotune_start(relay_autotune_t* tune, const autotune_config_t* cfg, uint32_t now_ms) {
+    memset(tune, 0, sizeof(*tune));
+    tune->cfg = *cfg;
+    tune->phase = AUTOTUNE_RELAY;
+    tune->start_ms = now_ms;
+    tune->period_min_s = INFINITY;
+}
+
+void relay_autotune_abort(relay_autotune_t* tune, autotune_abort_t reason) {
+    if (tune->phase != AUTOTUNE_RELAY) return;
+    tune->phase = AUTOTUNE_ABORTED;
+    tune->abort_reason = reason;
+}
+
+/**
+ * @brief 一个完整周期结束：记录周期和振幅，够数后计算 Ku/Tu
+ */
+static void finish_cycle(relay_autotune_t* tune, uint32_t now_ms) {
+    tune->cycles_seen++;
+    // 第一个周期从任意初始状态开始，不是极限环，丢弃
+    if (tune->cycles_seen == 1) return;
+
+    float period_s = (now_ms - tune->cycle_start_ms) / 1000.0f;
+    float amp = (tune->cycle_max - tune->cycle_min) / 2.0f;
+    tune->period_sum_s += period_s;
+    tune->amp_sum += amp;
+    if (period_s < tune->period_min_s) tune->period_min_s = period_s;
+    if (period_s > tune->period_max_s) tune->period_max_s = period_s;
+
+    uint8_t n = tune->cycles_seen - 1;
+    if (n < tune->cfg.cycles) return;
+
+    float tu = tune->period_sum_s / n;
+    float a = tune->amp_sum / n;
+    float h = tune->cfg.hysteresis;
+    if ((tune->period_max_s - tune->period_min_s) > AUTOTUNE_MAX_SPREAD * tu || a <= h) {
+        relay_autotune_abort(tune, AUTOTUNE_ABORT_INCONSISTENT);
+        return;
+    }
+    // 带滞环继电器的描述函数：Ku = 4d / (π·sqrt(a² - h²))
+    float d = (tune->cfg.output_high - tune->cfg.output_low) / 2.0f;
+    tune->ku = 4.0f * d / ((float)M_PI * sqrtf(a * a - h * h));
+    tune->tu_s = tu;
+    tune->phase = AUTOTUNE_DONE;
+}
+
+uint8_t relay_autotune_step(relay_autotune_t* tune, float temp, uint32_t now_ms) {
+    if (tune->phase != AUTOTUNE_RELAY) return 0;
+    const autotune_config_t* cfg = &tune->cfg;
+
+    if (temp == AUTOTUNE_INVALID_TEMP) {
+        relay_autotune_abort(tune, AUTOTUNE_ABORT_SENSOR);
+        return 0;
+    }
+    if (fabsf(temp - cfg->setpoint) > cfg->max_excursion) {
+        relay_autotune_abort(tune, AUTOTUNE_ABORT_OVERTEMP);
+        return 0;
+    }
+    if (now_ms - tune->start_ms > cfg->timeout_ms) {
+        relay_autotune_abort(tune, AUTOTUNE_ABORT_TIMEOUT);
+        return 0;
+    }
+
+    if (tune->cycle_start_ms != 0) {
+        if (temp > tune->cycle_max) tune->cycle_max = temp;
+        if (temp < tune->cycle_min) tune->cycle_min = temp;
+    }
+
+    // 反作用：温度高于上沿开大制冷，低于下沿关小；以切到高输出为周期边界
+    if (!tune->output_high && temp > cfg->setpoint + cfg->hysteresis) {
+        tune->output_high = true;
+        if (tune->cycle_start_ms != 0) {
+            finish_cycle(tune, now_ms);
+            if (tune->phase != AUTOTUNE_RELAY) return 0;
+        }
+        tune->cycle_start_ms = now_ms ? now_ms : 1;
+        tune->cycle_max = temp;
+        tune->cycle_min = temp;
+    } else if (tune->output_high && temp < cfg->setpoint - cfg->hysteresis) {
+        tune->output_high = false;
+    }
+    return tune->output_high ? cfg->output_high : cfg->output_low;
+}
+
+uint8_t relay_autotune_progress(const relay_autotune_t* tune) {
+    uint8_t n = tune->cycles_seen > 0 ? tune->cycles_seen - 1 : 0;
+    return n > tune->cfg.cycles ? tune->cfg.cycles : n;
+}
+
+bool relay_autotune_pi_gains(const relay_autotune_t* tune, float* kp, float* ki) {
+    if (tune->phase != AUTOTUNE_DONE || tune->tu_s <= 0.0f) return false;
+    *kp = tune->ku / 3.2f;
+    *ki = *kp / (2.2f * tune->tu_s);
+    return true;
+}
+
+const char* relay_autotune_phase_name(autotune_phase_t phase) {
+    switch (phase) {
+    case AUTOTUNE_IDLE:    return "idle";
+    case AUTOTUNE_RELAY:   return "relay";
+    case AUTOTUNE_DONE:    return "done";
+    case AUTOTUNE_ABORTED: return "aborted";
+    }
+    return "unknown";
+}
+
+const char* relay_autotune_abort_name(autotune_abort_t reason) {
+    switch (reason) {
+    case AUTOTUNE_ABORT_NONE:         return "none";
+    case AUTOTUNE_ABORT_USER:         return "user";
+    case AUTOTUNE_ABORT_OVERTEMP:     return "overtemp";
+    case AUTOTUNE_ABORT_SENSOR:       return "sensor";
+    case AUTOTUNE_ABORT_TIMEOUT:      return "timeout";
+    case AUTOTUNE_ABORT_INCONSISTENT: return "inconsistent";
+    }
+    return "unknown";
+}
@@ -0,0 +1,93 @@
+#ifndef RELAY_AUTOTUNE_H
+#define RELAY_AUTOTUNE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 继电反馈自整定（Åström–Hägglund）
+ *        以带滞环的继电器代替控制器，使温度在设定值附近形成极限环，
+ *        由振幅和周期得到临界增益 Ku、临界周期 Tu，再按 Tyreus–Luyben 规则计算 PI 增益
+ *        纯C实现，不依赖ESP-IDF；每个采样周期调用 relay_autotune_step()
+ */
+
+typedef enum {
+    AUTOTUNE_IDLE = 0,
+    AUTOTUNE_RELAY,             // 继电实验进行中
+    AUTOTUNE_DONE,              // 辨识完成，结果有效
+    AUTOTUNE_ABORTED,           // 已中止，见 abort_reason
+} autotune_phase_t;
+
+typedef enum {
+    AUTOTUNE_ABORT_NONE = 0,
+    AUTOTUNE_ABORT_USER,        // 用户取消
+    AUTOTUNE_ABORT_OVERTEMP,    // 热端过温或温度偏离设定值过远
+    AUTOTUNE_ABORT_SENSOR,      // 温度读数无效
+    AUTOTUNE_ABORT_TIMEOUT,     // 超时仍未完成足够周期
+    AUTOTUNE_ABORT_INCONSISTENT,// 各周期周期/振幅差异过大，不是稳定极限环
+} autotune_abort_t;
+
+typedef struct {
+    float setpoint;             // 继电切换中心（°C）
+    float hysteresis;           // 滞环半宽（°C），需大于测量噪声
+    uint8_t output_high;        // 温度高于上沿时的输出（%）
+    uint8_t output_low;         // 温度低于下沿时的输出（%）
+    uint8_t cycles;             // 参与计算的完整周期数（不含首个过渡周期）
+    float max_excursion;        // 温度偏离设定值超过此值则中止（°C）
+    uint32_t timeout_ms;        // 实验总时长上限
+} autotune_config_t;
+
+typedef struct {
+    autotune_config_t cfg;
+    autotune_phase_t phase;
+    autotune_abort_t abort_reason;
+    bool output_high;           // 当前继电器状态
+    uint32_t start_ms;
+    uint32_t cycle_start_ms;    // 最近一次切到高输出的时刻，0 表示尚未开始计周期
+    float cycle_max;            // 当前周期内温度极值
+    float cycle_min;
+    uint8_t cycles_seen;        // 已完成的周期数（含过渡周期）
+    float period_sum_s;
+    float period_min_s;
+    float period_max_s;
+    float amp_sum;
+    float ku;                   // 临界增益（%/°C）
+    float tu_s;                 // 临界周期（秒）
+} relay_autotune_t;
+
+/**
+ * @brief 默认实验参数
+ * @param setpoint 继电切换中心（°C）
+ */
+void relay_autotune_default_config(autotune_config_t* cfg, float setpoint);
+
+void relay_autotune_start(relay_autotune_t* tune, const autotune_config_t* cfg, uint32_t now_ms);
+
+/**
+ * @brief 推进一个采样周期
+ * @param temp 当前温度（°C），-127 表示无效
+ * @param now_ms 单调时间（毫秒）
+ * @return 本周期应输出的制冷需求（%），非 AUTOTUNE_RELAY 阶段返回 0
+ */
+uint8_t relay_autotune_step(relay_autotune_t* tune, float temp, uint32_t now_ms);
+
+/**
+ * @brief 外部中止（用户取消、过温联锁）
+ */
+void relay_autotune_abort(relay_autotune_t* tune, autotune_abort_t reason);
+
+/**
+ * @brief 已完成的有效周期数（用于进度显示）
+ */
+uint8_t relay_autotune_progress(const relay_autotune_t* tune);
+
+/**
+ * @brief 按 Tyreus–Luyben 规则由 Ku/Tu 计算 PI 增益（Kp = Ku/3.2, Ti = 2.2·Tu）
+ * @return false 结果无效（实验未完成）
+ */
+bool relay_autotune_pi_gains(const relay_autotune_t* tune, float* kp, float* ki);
+
+const char* relay_autotune_phase_name(autotune_phase_t phase);
+const char* relay_autotune_abort_name(autotune_abort_t reason);
+
+#endif // RELAY_AUTOTUNE_H
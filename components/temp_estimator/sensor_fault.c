@@ -0,0 +1,154 @@
+#include "sensor_fault.h"
+#include <math.h>
+#include <string.h>
+
+// 上电值与最后可信值相差不超过此值时当作真实读数（与估计器一致）
+#define SENSOR_FAULT_POWER_ON_BAND_C 5.0f
+
+void sensor_fault_init(sensor_fault_t* sf, uint32_t holdover_ms, uint8_t failsafe_fan) {
+    memset(sf, 0, sizeof(*sf));
+    sf->stuck_c = NAN;
+    sensor_fault_configure(sf, holdover_ms, failsafe_fan);
+}
+
+void sensor_fault_configure(sensor_fault_t* sf, uint32_t holdover_ms, uint8_t failsafe_fan) {
+    sf->holdover_ms = holdover_ms > SENSOR_FAULT_HOLDOVER_MAX_MS ? SENSOR_FAULT_HOLDOVER_MAX_MS : holdover_ms;
+    sf->failsafe_fan = failsafe_fan > 100 ? 100
+                     : failsafe_fan < SENSOR_FAULT_FAILSAFE_FAN_MIN ? SENSOR_FAULT_FAILSAFE_FAN_MIN : failsafe_fan;
+}
+
+/**
+ * @brief 从 (from_c, from_ms) 到 (to_c, to_ms) 的变化是否在物理变化率之内
+ */
+static bool plausible_step(float from_c, uint32_t from_ms, float to_c, uint32_t to_ms) {
+    float dt_s = (to_ms - from_ms) / 1000.0f;
+    return fabsf(to_c - from_c) <= SENSOR_FAULT_SLEW_C_PER_S * dt_s + SENSOR_FAULT_SLEW_MARGIN_C;
+}
+
+/**
+ * @brief 卡滞检测：读数逐位不变的时长，以及期间输出激励的摆幅
+ *        DS18B20 12 位分辨率 0.0625°C，风扇大幅变化几分钟内读数必然变动；
+ *        只凭时长不足以判断，恒温环境中激励不变时读数本来就可以长时间不变；
+ *        时长从激励变化时算起，长时间空闲后的第一次激励变化要给读数留出响应时间
+ */
+static bool stuck_check(sensor_fault_t* sf, float temp_c, uint8_t drive, uint32_t now_ms) {
+    if (temp_c != sf->stuck_c) {
+        sf->stuck_c = temp_c;
+        sf->stuck_ms = now_ms;
+        sf->drive_min = sf->drive_max = drive;
+        return false;
+    }
+    int before = sf->drive_max - sf->drive_min;
+    if (drive < sf->drive_min) sf->drive_min = drive;
+    if (drive > sf->drive_max) sf->drive_max = drive;
+    int swing = sf->drive_max - sf->drive_min;
+    if (before < SENSOR_FAULT_STUCK_IDLE_SWING && swing >= SENSOR_FAULT_STUCK_IDLE_SWING) sf->drive_moved_ms = now_ms;
+    if (before < SENSOR_FAULT_STUCK_SWING && swing >= SENSOR_FAULT_STUCK_SWING) sf->drive_swing_ms = now_ms;
+    return (swing >= SENSOR_FAULT_STUCK_IDLE_SWING && now_ms - sf->drive_moved_ms >= SENSOR_FAULT_STUCK_IDLE_MS) ||
+           (swing >= SENSOR_FAULT_STUCK_SWING && now_ms - sf->drive_swing_ms >= SENSOR_FAULT_STUCK_MS);
+}
+
+static sensor_fault_kind_t classify(sensor_fault_t* sf, sensor_read_t read, float temp_c, uint8_t drive,
+                                    uint32_t now_ms) {
+    if (read == SENSOR_READ_NO_DEVICE) return SENSOR_FAULT_MISSING;
+    if (read == SENSOR_READ_CRC_ERROR) return SENSOR_FAULT_CRC;
+    if (isnan(temp_c) || temp_c < SENSOR_FAULT_MIN_C || temp_c > SENSOR_FAULT_MAX_C) {
+        return SENSOR_FAULT_IMPLAUSIBLE;
+    }
+    if (temp_c == SENSOR_FAULT_POWER_ON_C &&
+        (!sf->have_good || fabsf(sf->last_good_c - SENSOR_FAULT_POWER_ON_C) > SENSOR_FAULT_POWER_ON_BAND_C)) {
+        return SENSOR_FAULT_IMPLAUSIBLE;
+    }
+    if (stuck_check(sf, temp_c, drive, now_ms)) return SENSOR_FAULT_STUCK;
+
+    if (sf->have_good && !plausible_step(sf->last_good_c, sf->last_good_ms, temp_c, now_ms)) {
+        // 跳变：连续几次读数彼此一致时视为真实变化（如打开机箱），以新值重新锚定
+        if (sf->jump_count > 0 && plausible_step(sf->jump_c, sf->jump_ms, temp_c, now_ms)) {
+            sf->jump_count++;
+        } else {
+            sf->jump_count = 1;
+        }
+        sf->jump_c = temp_c;
+        sf->jump_ms = now_ms;
+        if (sf->jump_count < SENSOR_FAULT_CONFIRM) return SENSOR_FAULT_IMPLAUSIBLE;
+    }
+    sf->jump_count = 0;
+    return SENSOR_FAULT_NONE;
+}
+
+static void enter_fault(sensor_fault_t* sf, sensor_fault_kind_t kind, uint32_t now_ms) {
+    sf->state = SENSOR_STATE_HOLDOVER;
+    sf->fault = kind;
+    sf->faults[kind]++;
+    sf->fault_ms = now_ms;
+    if (kind == SENSOR_FAULT_STUCK) {
+        // 激励变化之前读数不变与恒温一致，之后的读数才不可信；最多回溯一个外推时限，
+        // 回溯过久恢复时的变化率检查会按几十分钟放宽，跳变读数也能通过
+        uint32_t since_ms = now_ms - sf->drive_moved_ms;
+        if (since_ms > sf->holdover_ms) since_ms = sf->holdover_ms;
+        sf->last_good_ms = now_ms - since_ms;
+    }
+}
+
+bool sensor_fault_update(sensor_fault_t* sf, sensor_read_t read, float temp_c, uint8_t drive, uint32_t now_ms) {
+    sensor_fault_kind_t kind = classify(sf, read, temp_c, drive, now_ms);
+    sf->last = kind;
+
+    if (kind == SENSOR_FAULT_NONE) {
+        sf->have_good = true;
+        sf->last_good_c = temp_c;
+        sf->last_good_ms = now_ms;
+        sf->bad_streak = 0;
+        if (sf->state != SENSOR_STATE_OK && ++sf->good_streak >= SENSOR_FAULT_CLEAR) {
+            sf->state = SENSOR_STATE_OK;
+            sf->good_streak = 0;
+        }
+    } else {
+        sf->good_streak = 0;
+        if (sf->bad_streak < UINT8_MAX) sf->bad_streak++;
+        if (sf->state != SENSOR_STATE_OK) {
+            sf->fault = kind;
+        } else if (sf->bad_streak >= SENSOR_FAULT_CONFIRM || kind == SENSOR_FAULT_STUCK) {
+            enter_fault(sf, kind, now_ms);
+        }
+    }
+
+    if (sf->state == SENSOR_STATE_HOLDOVER &&
+        (!sf->have_good || now_ms - sf->last_good_ms >= sf->holdover_ms)) {
+        sf->state = SENSOR_STATE_FAILSAFE;
+        sf->failsafe_entries++;
+    }
+    return kind == SENSOR_FAULT_NONE;
+}
+
+float sensor_fault_bound(const sensor_fault_t* sf, float predicted_c) {
+    if (sf->state == SENSOR_STATE_OK || !sf->have_good) return predicted_c;
+    if (isnan(predicted_c) || predicted_c < sf->last_good_c) return sf->last_good_c;
+    if (predicted_c > sf->last_good_c + SENSOR_FAULT_EXTRAP_MAX_C) return sf->last_good_c + SENSOR_FAULT_EXTRAP_MAX_C;
+    return predicted_c;
+}
+
+uint32_t sensor_fault_age_ms(const sensor_fault_t* sf, uint32_t now_ms) {
+    return sf->state == SENSOR_STATE_OK ? 0 : now_ms - sf->fault_ms;
+}
+
+const char* sensor_fault_kind_name(sensor_fault_kind_t kind) {
+    switch (kind) {
+    case SENSOR_FAULT_NONE:        return "none";
+    case SENSOR_FAULT_MISSING:     return "missing";
+    case SENSOR_FAULT_CRC:         return "crc";
+    case SENSOR_FAULT_STUCK:       return "stuck";
+    case SENSOR_FAULT_IMPLAUSIBLE: return "implausible";
+    case SENSOR_FAULT_KIND_COUNT:  break;
+    }
+    return "unknown";
+}
+
+const char* sensor_fault_state_name(sensor_state_t state) {
+    switch (state) {
+    case SENSOR_STATE_OK:       return "ok";
+    case SENSOR_STATE_HOLDOVER: return "holdover";
+    case SENSOR_STATE_FAILSAFE: return "failsafe";
+    }
+    return "unknown";
+}
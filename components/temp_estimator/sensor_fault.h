@@ -0,0 +1,115 @@
+#ifndef SENSOR_FAULT_H
+#define SENSOR_FAULT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 温度传感器故障分类与降级：在读数进入卡尔曼估计器之前判断是否可信
+ *        故障类型：掉线（无存在脉冲）、CRC 错误、读数卡滞、读数不可信（超量程/上电值/变化率超出物理可能）
+ *        确认故障后先按最后可信值外推维持控制（holdover），超过时限进入失效安全：风扇固定占空比、制冷片关闭
+ *        纯C实现，不依赖ESP-IDF；传感器任务每次读数调用 sensor_fault_update()
+ */
+
+#define SENSOR_FAULT_MIN_C          (-55.0f)    // DS18B20 量程
+#define SENSOR_FAULT_MAX_C          125.0f
+#define SENSOR_FAULT_POWER_ON_C     85.0f       // 上电复位值（未完成转换）
+#define SENSOR_FAULT_SLEW_C_PER_S   0.5f        // 机箱温度的物理变化率上限
+#define SENSOR_FAULT_SLEW_MARGIN_C  0.5f        // 量化与噪声余量
+#define SENSOR_FAULT_CONFIRM        3           // 连续异常读数达到此值确认故障；连续一致的跳变读数达到此值视为真实变化
+#define SENSOR_FAULT_CLEAR          3           // 故障后连续可信读数达到此值才恢复正常控制
+#define SENSOR_FAULT_STUCK_MS       300000      // 输出激励大幅变化后读数仍逐位不变 5 分钟判为卡滞
+#define SENSOR_FAULT_STUCK_IDLE_MS  1800000     // 激励小幅变化后读数仍逐位不变 30 分钟判为卡滞
+#define SENSOR_FAULT_STUCK_SWING    30          // “输出激励变化”的最小摆幅（占空比 %）
+#define SENSOR_FAULT_STUCK_IDLE_SWING 5         // 长时间不变判据的最小摆幅：激励完全不变时环境可能就是恒温
+#define SENSOR_FAULT_EXTRAP_MAX_C   5.0f        // 外推温度最多高出最后可信值
+#define SENSOR_FAULT_HOLDOVER_MS    120000      // 默认外推时限
+#define SENSOR_FAULT_HOLDOVER_MAX_MS 3600000
+#define SENSOR_FAULT_FAILSAFE_FAN   100         // 默认失效安全风扇占空比
+#define SENSOR_FAULT_FAILSAFE_FAN_MIN 40        // 失效安全风扇占空比下限（同 SUPERVISOR_FAN_MIN_WITH_TEC），
+                                                // 温度未知时不允许把风扇配置到停转或失速区
+
+typedef enum {
+    SENSOR_FAULT_NONE = 0,
+    SENSOR_FAULT_MISSING,       // 总线复位无存在脉冲
+    SENSOR_FAULT_CRC,           // 暂存器 CRC 校验失败
+    SENSOR_FAULT_STUCK,         // 输出激励变化而读数长时间逐位不变
+    SENSOR_FAULT_IMPLAUSIBLE,   // 超量程、上电值或变化率超出物理可能
+    SENSOR_FAULT_KIND_COUNT,
+} sensor_fault_kind_t;
+
+typedef enum {
+    SENSOR_STATE_OK = 0,        // 读数可信，正常控制
+    SENSOR_STATE_HOLDOVER,      // 故障已确认，按最后可信值外推控制
+    SENSOR_STATE_FAILSAFE,      // 外推超时或开机即无可信读数：固定风扇占空比，制冷片关闭
+} sensor_state_t;
+
+// 一次总线读取的结果（由 temp_sensor 状态映射而来）
+typedef enum {
+    SENSOR_READ_OK = 0,
+    SENSOR_READ_NO_DEVICE,
+    SENSOR_READ_CRC_ERROR,
+} sensor_read_t;
+
+typedef struct {
+    uint32_t holdover_ms;       // 外推时限，0 表示确认故障后直接失效安全
+    uint8_t failsafe_fan;       // 失效安全风扇占空比（%）
+    sensor_state_t state;
+    sensor_fault_kind_t fault;  // 当前故障（最近一次异常读数的类型）；恢复后保留，供上报
+    sensor_fault_kind_t last;   // 最近一次读数的分类
+    uint8_t bad_streak;         // 连续异常读数
+    uint8_t good_streak;        // 故障后连续可信读数
+    bool have_good;             // 是否有过可信读数
+    float last_good_c;          // 最后可信读数
+    uint32_t last_good_ms;
+    uint32_t fault_ms;          // 故障确认时刻
+    float jump_c;               // 跳变候选：与最后可信值不连续、彼此一致的读数
+    uint32_t jump_ms;
+    uint8_t jump_count;
+    float stuck_c;              // 卡滞检测：逐位不变的读数及起始时刻
+    uint32_t stuck_ms;
+    uint8_t drive_min;          // 读数不变期间的输出激励范围
+    uint8_t drive_max;
+    uint32_t drive_moved_ms;    // 读数不变期间激励摆幅达到 SENSOR_FAULT_STUCK_IDLE_SWING 的时刻
+    uint32_t drive_swing_ms;    // 读数不变期间激励摆幅达到 SENSOR_FAULT_STUCK_SWING 的时刻
+    uint32_t faults[SENSOR_FAULT_KIND_COUNT];   // 各类故障确认次数
+    uint32_t failsafe_entries;
+} sensor_fault_t;
+
+/**
+ * @brief 初始化：状态正常，尚无可信读数
+ * @param holdover_ms 外推时限，超过 SENSOR_FAULT_HOLDOVER_MAX_MS 时取上限
+ * @param failsafe_fan 失效安全风扇占空比（%），限制在 [SENSOR_FAULT_FAILSAFE_FAN_MIN, 100]
+ */
+void sensor_fault_init(sensor_fault_t* sf, uint32_t holdover_ms, uint8_t failsafe_fan);
+
+/**
+ * @brief 修改外推时限和失效安全占空比（取值限制同 sensor_fault_init），不影响当前故障状态
+ */
+void sensor_fault_configure(sensor_fault_t* sf, uint32_t holdover_ms, uint8_t failsafe_fan);
+
+/**
+ * @brief 分类一次读数并推进状态
+ * @param read 总线读取结果
+ * @param temp_c 读数（read 非 OK 时忽略）
+ * @param drive 当前输出激励（风扇与制冷片占空比之和，上限 255），用于卡滞判断
+ * @return 读数可信，可以送入估计器
+ */
+bool sensor_fault_update(sensor_fault_t* sf, sensor_read_t read, float temp_c, uint8_t drive, uint32_t now_ms);
+
+/**
+ * @brief 故障期间控制律使用的温度：估计器外推值限制在 [最后可信值, 最后可信值 + SENSOR_FAULT_EXTRAP_MAX_C]
+ *        只跟随上升趋势，下降趋势保持最后可信值，宁可多冷却也不因外推关断风扇
+ *        状态正常或从无可信读数时原样返回
+ */
+float sensor_fault_bound(const sensor_fault_t* sf, float predicted_c);
+
+/**
+ * @brief 故障持续时间（毫秒），状态正常时为 0
+ */
+uint32_t sensor_fault_age_ms(const sensor_fault_t* sf, uint32_t now_ms);
+
+const char* sensor_fault_kind_name(sensor_fault_kind_t kind);
+const char* sensor_fault_state_name(sensor_state_t state);
+
+#endif // SENSOR_FAULT_H
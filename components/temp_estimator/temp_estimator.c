@@ -0,0 +1,92 @@
+#include "temp_estimator.h"
+#include <math.h>
+#include <string.h>
+
+// DS18B20 量程
+#define TEMP_EST_MIN_VALID (-55.0f)
+#define TEMP_EST_MAX_VALID 125.0f
+// 初始变化率方差：允许初始时 ±0.1°C/s 的不确定度
+#define TEMP_EST_INIT_RATE_VAR 0.01f
+
+void temp_estimator_init(temp_estimator_t* est, float meas_sigma, float accel_sigma) {
+    memset(est, 0, sizeof(*est));
+    est->meas_var = meas_sigma * meas_sigma;
+    est->accel_var = accel_sigma * accel_sigma;
+    est->gate_sigma = 4.0f;
+    est->max_rejects = 3;
+}
+
+static void temp_estimator_reset(temp_estimator_t* est, float measurement) {
+    est->temp = measurement;
+    est->rate = 0.0f;
+    est->p[0][0] = est->meas_var;
+    est->p[0][1] = est->p[1][0] = 0.0f;
+    est->p[1][1] = TEMP_EST_INIT_RATE_VAR;
+    est->consecutive_rejects = 0;
+    est->initialized = true;
+}
+
+static bool temp_estimator_is_invalid(const temp_estimator_t* est, float measurement) {
+    if (isnan(measurement) || measurement == TEMP_EST_ERROR_VALUE) return true;
+    if (measurement < TEMP_EST_MIN_VALID || measurement > TEMP_EST_MAX_VALID) return true;
+    // 85°C 是上电复位值；只有估计值接近 85°C 时才当作真实读数
+    if (measurement == TEMP_EST_POWER_ON_VALUE &&
+        (!est->initialized || fabsf(est->temp - TEMP_EST_POWER_ON_VALUE) > 5.0f)) {
+        return true;
+    }
+    return false;
+}
+
+temp_est_result_t temp_estimator_update(temp_estimator_t* est, float measurement, float dt_s) {
+    if (temp_estimator_is_invalid(est, measurement)) {
+        est->rejected_total++;
+        return TEMP_EST_REJECTED_INVALID;
+    }
+    if (!est->initialized) {
+        temp_estimator_reset(est, measurement);
+        return TEMP_EST_ACCEPTED;
+    }
+    if (dt_s < 0.0f) dt_s = 0.0f;
+
+    // 预测：x = F x，P = F P F' + Q
+    float dt2 = dt_s * dt_s;
+    float temp_pred = est->temp + est->rate * dt_s;
+    float p00 = est->p[0][0] + dt_s * (est->p[0][1] + est->p[1][0]) + dt2 * est->p[1][1]
+              + est->accel_var * dt2 * dt2 / 4.0f;
+    float p01 = est->p[0][1] + dt_s * est->p[1][1] + est->accel_var * dt2 * dt_s / 2.0f;
+    float p11 = est->p[1][1] + est->accel_var * dt2;
+
+    // 新息门限检查
+    float innovation = measurement - temp_pred;
+    float s = p00 + est->meas_var;
+    if (innovation * innovation > est->gate_sigma * est->gate_sigma * s) {
+        est->rejected_total++;
+        if (++est->consecutive_rejects >= est->max_rejects) {
+            // 连续离群更可能是真实阶跃（如传感器移位），重新初始化
+            temp_estimator_reset(est, measurement);
+            return TEMP_EST_RESET;
+        }
+        // 只保留预测，不融合测量
+        est->temp = temp_pred;
+        est->p[0][0] = p00;
+        est->p[0][1] = est->p[1][0] = p01;
+        est->p[1][1] = p11;
+        return TEMP_EST_REJECTED_OUTLIER;
+    }
+    est->consecutive_rejects = 0;
+
+    // 更新：K = P H' / S，H = [1 0]
+    float k0 = p00 / s;
+    float k1 = p01 / s;
+    est->temp = temp_pred + k0 * innovation;
+    est->rate = est->rate + k1 * innovation;
+    est->p[0][0] = (1.0f - k0) * p00;
+    est->p[0][1] = est->p[1][0] = (1.0f - k0) * p01;
+    est->p[1][1] = p11 - k1 * p01;
+    return TEMP_EST_ACCEPTED;
+}
+
+float temp_estimator_predict(const temp_estimator_t* est, float horizon_s) {
+    if (!est->initialized) return TEMP_EST_ERROR_VALUE;
+    return est->temp + est->rate * horizon_s;
+}
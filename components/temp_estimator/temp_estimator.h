@@ -0,0 +1,56 @@
+#ifndef TEMP_ESTIMATOR_H
+#define TEMP_ESTIMATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 温度估计器：二状态卡尔曼滤波（温度、温度变化率）
+ *        匀速模型 + 白噪声加速度；剔除 DS18B20 错误值和新息超门限的离群点
+ *        纯C实现，不依赖ESP-IDF
+ */
+
+// DS18B20 特殊值：-127 为读取失败，85 为上电复位值（未完成转换）
+#define TEMP_EST_ERROR_VALUE    (-127.0f)
+#define TEMP_EST_POWER_ON_VALUE 85.0f
+
+typedef enum {
+    TEMP_EST_ACCEPTED = 0,      // 测量值已融合
+    TEMP_EST_REJECTED_INVALID,  // 错误值/上电值/超出量程
+    TEMP_EST_REJECTED_OUTLIER,  // 新息超过门限
+    TEMP_EST_RESET,             // 连续离群，按新测量值重新初始化
+} temp_est_result_t;
+
+typedef struct {
+    float temp;                 // 估计温度（°C）
+    float rate;                 // 估计变化率（°C/s）
+    float p[2][2];              // 协方差矩阵
+    float meas_var;             // 测量噪声方差（°C²）
+    float accel_var;            // 过程噪声：加速度方差（(°C/s²)²）
+    float gate_sigma;           // 离群门限（新息标准差倍数）
+    uint8_t max_rejects;        // 连续离群多少次后重新初始化
+    uint8_t consecutive_rejects;
+    uint32_t rejected_total;
+    bool initialized;
+} temp_estimator_t;
+
+/**
+ * @brief 初始化估计器
+ * @param meas_sigma 测量噪声标准差（°C），含 0.0625°C 量化噪声
+ * @param accel_sigma 加速度噪声标准差（°C/s²），越大跟踪越快、越不平滑
+ */
+void temp_estimator_init(temp_estimator_t* est, float meas_sigma, float accel_sigma);
+
+/**
+ * @brief 融合一次测量
+ * @param measurement 传感器原始读数（°C）
+ * @param dt_s 距上次更新的时间（秒）
+ */
+temp_est_result_t temp_estimator_update(temp_estimator_t* est, float measurement, float dt_s);
+
+/**
+ * @brief 预测 horizon_s 秒后的温度（控制律使用，补偿转换延迟）
+ */
+float temp_estimator_predict(const temp_estimator_t* est, float horizon_s);
+
+#endif // TEMP_ESTIMATOR_H
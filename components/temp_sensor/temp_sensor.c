@@ -1,21 +1,300 @@
 #include "temp_sensor.h"
 #include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "power_mgmt.h"
+#include "metrics.h"
+#include "trace.h"
 
-// static const char* TAG = "TEMP_SENSOR";  // 暂时未使用，注释掉避免警告
+static const char* TAG = "TEMP_SENSOR";
+
+// DS18B20 命令
+#define DS18B20_CMD_SKIP_ROM        0xCC
+#define DS18B20_CMD_CONVERT_T       0x44
+#define DS18B20_CMD_READ_SCRATCHPAD 0xBE
+#define TEMP_SENSOR_ERROR_VALUE     (-127.0f)
+// 热端传感器初始化时的存在检测次数，任一次有存在脉冲即视为已安装
+#define HOT_SIDE_PROBE_ATTEMPTS     3
+
+static METRIC_COUNTER_DEFINE(m_crc_err, "fan_onewire_crc_errors_total", "DS18B20 scratchpad CRC mismatches");
+static METRIC_COUNTER_DEFINE(m_no_device, "fan_onewire_no_presence_total", "1-Wire resets without a presence pulse");
+static METRIC_COUNTER_DEFINE(m_hot_crc_err, "fan_onewire_hot_crc_errors_total",
+                             "Hot-side DS18B20 scratchpad CRC mismatches");
+static METRIC_COUNTER_DEFINE(m_hot_no_device, "fan_onewire_hot_no_presence_total",
+                             "Hot-side 1-Wire resets without a presence pulse");
+
+/**
+ * @brief 一条 1-Wire 总线（各挂一个 DS18B20），冷端和热端分别计数
+ */
+typedef struct {
+    gpio_num_t pin;
+    metric_t* crc_err;
+    metric_t* no_device;
+} onewire_bus_t;
+
+static onewire_bus_t s_cold = { GPIO_NUM_NC, &m_crc_err, &m_no_device };
+static onewire_bus_t s_hot = { GPIO_NUM_NC, &m_hot_crc_err, &m_hot_no_device };
+static float s_last_temp = TEMP_SENSOR_ERROR_VALUE;
+static temp_sensor_status_t s_status = TEMP_SENSOR_NO_DEVICE;
+static float s_last_hot_temp = TEMP_SENSOR_ERROR_VALUE;
+// 单个时隙内禁止被中断打断，保证位时序
+static portMUX_TYPE s_ow_mux = portMUX_INITIALIZER_UNLOCKED;
+
+TRACE_NAME(t_convert, "onewire_convert");
+TRACE_NAME(t_read, "onewire_read");
+TRACE_NAME(t_crc_err, "onewire_crc_error");
+TRACE_NAME(t_no_device, "onewire_no_presence");
+
+/**
+ * @brief 1-Wire 复位并检测存在脉冲
+ * @return true 检测到设备
+ */
+static bool onewire_reset(gpio_num_t pin) {
+    gpio_set_level(pin, 0);
+    esp_rom_delay_us(480);
+    portENTER_CRITICAL(&s_ow_mux);
+    gpio_set_level(pin, 1);
+    esp_rom_delay_us(70);
+    bool presence = (gpio_get_level(pin) == 0);
+    portEXIT_CRITICAL(&s_ow_mux);
+    esp_rom_delay_us(410);
+    return presence;
+}
+
+static void onewire_write_bit(gpio_num_t pin, int bit) {
+    portENTER_CRITICAL(&s_ow_mux);
+    gpio_set_level(pin, 0);
+    if (bit) {
+        esp_rom_delay_us(6);
+        gpio_set_level(pin, 1);
+        esp_rom_delay_us(64);
+    } else {
+        esp_rom_delay_us(60);
+        gpio_set_level(pin, 1);
+        esp_rom_delay_us(10);
+    }
+    portEXIT_CRITICAL(&s_ow_mux);
+}
+
+static int onewire_read_bit(gpio_num_t pin) {
+    portENTER_CRITICAL(&s_ow_mux);
+    gpio_set_level(pin, 0);
+    esp_rom_delay_us(3);
+    gpio_set_level(pin, 1);
+    esp_rom_delay_us(10);
+    int bit = gpio_get_level(pin);
+    portEXIT_CRITICAL(&s_ow_mux);
+    esp_rom_delay_us(53);
+    return bit;
+}
+
+static void onewire_write_byte(gpio_num_t pin, uint8_t data) {
+    for (int i = 0; i < 8; i++) {
+        onewire_write_bit(pin, data & 0x01);
+        data >>= 1;
+    }
+}
+
+static uint8_t onewire_read_byte(gpio_num_t pin) {
+    uint8_t data = 0;
+    for (int i = 0; i < 8; i++) {
+        data |= (uint8_t)(onewire_read_bit(pin) << i);
+    }
+    return data;
+}
+
+/**
+ * @brief Dallas/Maxim CRC8（多项式 x^8+x^5+x^4+1）
+ */
+static uint8_t onewire_crc8(const uint8_t* data, int len) {
+    uint8_t crc = 0;
+    while (len--) {
+        uint8_t byte = *data++;
+        for (int i = 0; i < 8; i++) {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief 发起一次温度转换（总线上仅一个 DS18B20，使用 SKIP ROM）
+ */
+static bool ds18b20_start_conversion(gpio_num_t pin) {
+    TRACE_BEGIN(t_convert);
+    power_mgmt_acquire(PM_LOCK_ONEWIRE);
+    bool ok = onewire_reset(pin);
+    if (ok) {
+        onewire_write_byte(pin, DS18B20_CMD_SKIP_ROM);
+        onewire_write_byte(pin, DS18B20_CMD_CONVERT_T);
+    }
+    power_mgmt_release(PM_LOCK_ONEWIRE);
+    TRACE_END(t_convert);
+    return ok;
+}
+
+/**
+ * @brief 读取暂存器并校验 CRC
+ *        总线被拉低时复位也会看到“存在脉冲”，读回全 0 且 CRC 恰好为 0，按 CRC 错误处理
+ */
+static temp_sensor_status_t ds18b20_read_scratchpad(const onewire_bus_t* bus, uint8_t scratchpad[9]) {
+    gpio_num_t pin = bus->pin;
+    TRACE_BEGIN(t_read);
+    power_mgmt_acquire(PM_LOCK_ONEWIRE);
+    bool ok = onewire_reset(pin);
+    uint8_t any = 0;
+    if (ok) {
+        onewire_write_byte(pin, DS18B20_CMD_SKIP_ROM);
+        onewire_write_byte(pin, DS18B20_CMD_READ_SCRATCHPAD);
+        for (int i = 0; i < 9; i++) {
+            scratchpad[i] = onewire_read_byte(pin);
+            any |= scratchpad[i];
+        }
+    }
+    power_mgmt_release(PM_LOCK_ONEWIRE);
+    TRACE_END(t_read);
+    if (!ok) {
+        metrics_inc(bus->no_device);
+        TRACE_INSTANT(t_no_device, pin);
+        return TEMP_SENSOR_NO_DEVICE;
+    }
+    if (any == 0 || onewire_crc8(scratchpad, 8) != scratchpad[8]) {
+        metrics_inc(bus->crc_err);
+        TRACE_INSTANT(t_crc_err, pin);
+        return TEMP_SENSOR_CRC_ERROR;
+    }
+    return TEMP_SENSOR_OK;
+}
+
+/**
+ * @brief 配置 1-Wire 引脚为开漏输出
+ */
+static void onewire_bus_init(gpio_num_t pin) {
+    gpio_reset_pin(pin);
+    gpio_set_direction(pin, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_level(pin, 1);
+}
 
 /**
- * @brief 初始化DS18B20温度传感器 - 使用官方DS18B20库
- * @param gpio_pin 数据引脚GPIO
+ * @brief 在一条总线上发起转换（总线上仅一个 DS18B20）
+ */
+static bool ds18b20_begin(const onewire_bus_t* bus) {
+    gpio_num_t pin = bus->pin;
+    if (pin == GPIO_NUM_NC) return false;
+    if (!ds18b20_start_conversion(pin)) {
+        metrics_inc(bus->no_device);
+        TRACE_INSTANT(t_no_device, pin);
+        ESP_LOGW(TAG, "GPIO%d 未检测到 DS18B20", pin);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 读取转换结果
+ */
+static float ds18b20_finish(const onewire_bus_t* bus, temp_sensor_status_t* status) {
+    uint8_t scratchpad[9];
+    *status = ds18b20_read_scratchpad(bus, scratchpad);
+    if (*status != TEMP_SENSOR_OK) {
+        ESP_LOGW(TAG, "GPIO%d %s", bus->pin, *status == TEMP_SENSOR_NO_DEVICE ? "读取暂存器时未检测到 DS18B20"
+                                                                         : "暂存器 CRC 错误");
+        return TEMP_SENSOR_ERROR_VALUE;
+    }
+    int16_t raw = (int16_t)((scratchpad[1] << 8) | scratchpad[0]);
+    return raw / 16.0f;
+}
+
+static void temp_sensor_register_metrics(void) {
+    metrics_register(&m_crc_err);
+    metrics_register(&m_no_device);
+    metrics_register(&m_hot_crc_err);
+    metrics_register(&m_hot_no_device);
+}
+
+/**
+ * @brief 初始化DS18B20温度传感器
+ * @param gpio_pin 数据引脚GPIO（需外接4.7kΩ上拉）
  */
 void temp_sensor_init(gpio_num_t gpio_pin) {
-    // TODO: 需用官方 driver/gpio.h 自己实现1-Wire协议和DS18B20温度读取逻辑，移除所有 onewire_bus/ds18b20 相关API和变量。
+    s_cold.pin = gpio_pin;
+    temp_sensor_register_metrics();
+    onewire_bus_init(gpio_pin);
+    ESP_LOGI(TAG, "DS18B20 初始化完成: GPIO=%d", gpio_pin);
+}
+
+/**
+ * @brief 初始化制冷片热端 DS18B20（独立总线）
+ *        热端传感器是选装件：初始化时检测存在脉冲，没有则按未安装处理，之后不再访问该总线；
+ *        安装后掉线仍按读取失败（-127）上报，由监督器关闭制冷片
+ * @param gpio_pin 数据引脚GPIO（需外接4.7kΩ上拉）
+ * @return true 检测到热端传感器
+ */
+bool temp_sensor_init_hot_side(gpio_num_t gpio_pin) {
+    temp_sensor_register_metrics();
+    onewire_bus_init(gpio_pin);
+    bool present = false;
+    power_mgmt_acquire(PM_LOCK_ONEWIRE);
+    for (int i = 0; i < HOT_SIDE_PROBE_ATTEMPTS && !present; i++) {
+        present = onewire_reset(gpio_pin);
+    }
+    power_mgmt_release(PM_LOCK_ONEWIRE);
+    if (!present) {
+        s_hot.pin = GPIO_NUM_NC;
+        ESP_LOGI(TAG, "GPIO%d 未检测到热端 DS18B20，按未安装处理", gpio_pin);
+        return false;
+    }
+    s_hot.pin = gpio_pin;
+    ESP_LOGI(TAG, "热端 DS18B20 初始化完成: GPIO=%d", gpio_pin);
+    return true;
 }
 
 /**
- * @brief 获取温度值 - 使用官方DS18B20库
+ * @brief 在所有总线上同时发起转换，统一等待一次后读取（阻塞约750ms）
+ *        转换等待期间不持有电源锁，允许系统降频/浅睡眠
+ * @return 温度值（摄氏度），错误时返回-127.0
+ */
+float temp_sensor_update(void) {
+    bool cold_started = ds18b20_begin(&s_cold);
+    bool hot_started = ds18b20_begin(&s_hot);
+
+    if (cold_started || hot_started) {
+        vTaskDelay(pdMS_TO_TICKS(TEMP_SENSOR_CONVERSION_MS));
+    }
+    temp_sensor_status_t hot_status = TEMP_SENSOR_NO_DEVICE;
+    s_status = TEMP_SENSOR_NO_DEVICE;
+    s_last_temp = cold_started ? ds18b20_finish(&s_cold, &s_status) : TEMP_SENSOR_ERROR_VALUE;
+    s_last_hot_temp = hot_started ? ds18b20_finish(&s_hot, &hot_status) : TEMP_SENSOR_ERROR_VALUE;
+    return s_last_temp;
+}
+
+/**
+ * @brief 获取最近一次读取的温度值（不访问总线）
  * @return 温度值（摄氏度），错误时返回-127.0
  */
 float temp_sensor_get_temperature(void) {
-    // TODO: 需用官方 driver/gpio.h 自己实现1-Wire协议和DS18B20温度读取逻辑，移除所有 onewire_bus/ds18b20 相关API和变量。
-    return 0.0;
+    return s_last_temp;
+}
+
+/**
+ * @brief 最近一次 temp_sensor_update() 冷端读取的结果，区分掉线和 CRC 错误
+ */
+temp_sensor_status_t temp_sensor_get_status(void) {
+    return s_status;
+}
+
+/**
+ * @brief 获取最近一次 temp_sensor_update() 读取的热端温度值（不访问总线）
+ * @return 温度值（摄氏度），错误时返回-127.0
+ */
+float temp_sensor_get_hot_side_temperature(void) {
+    return s_last_hot_temp;
+}
+
+bool temp_sensor_has_hot_side(void) {
+    return s_hot.pin != GPIO_NUM_NC;
 }
@@ -2,6 +2,16 @@
 #define TEMP_SENSOR_H
 
 #include "driver/gpio.h"
+#include <stdbool.h>
+
+// 12-bit conversion time; also the latency the control law compensates for
+#define TEMP_SENSOR_CONVERSION_MS 750
+
+typedef enum {
+    TEMP_SENSOR_OK = 0,
+    TEMP_SENSOR_NO_DEVICE,      // no presence pulse on reset
+    TEMP_SENSOR_CRC_ERROR,      // scratchpad CRC mismatch
+} temp_sensor_status_t;
 
 /**
  * @brief Initialize DS18B20 sensor on the specified GPIO pin
@@ -9,9 +19,38 @@
 void temp_sensor_init(gpio_num_t pin);
 
 /**
- * @brief Read temperature from DS18B20
- * @return Temperature in Celsius
+ * @brief Run one conversion on every fitted sensor and read the results (blocks ~750 ms)
+ * @return Temperature in Celsius, -127.0 on error
+ */
+float temp_sensor_update(void);
+
+/**
+ * @brief Get the last temperature read by temp_sensor_update()
+ * @return Temperature in Celsius, -127.0 on error
  */
 float temp_sensor_get_temperature(void);
 
+/**
+ * @brief Outcome of the last cold-side read by temp_sensor_update()
+ */
+temp_sensor_status_t temp_sensor_get_status(void);
+
+/**
+ * @brief Initialize the optional TEC hot-side DS18B20 on its own GPIO
+ *        Probes for a presence pulse; without one the sensor is treated as not fitted
+ * @return true if a hot-side sensor was detected
+ */
+bool temp_sensor_init_hot_side(gpio_num_t pin);
+
+/**
+ * @brief Get the last hot-side temperature read by temp_sensor_update()
+ * @return Temperature in Celsius, -127.0 on error or when not fitted
+ */
+float temp_sensor_get_hot_side_temperature(void);
+
+/**
+ * @brief Whether a hot-side sensor was detected at init
+ */
+bool temp_sensor_has_hot_side(void);
+
 #endif // TEMP_SENSOR_H
@@ -0,0 +1,171 @@
+#include "trace.h"
+
+#if TRACE_ENABLE
+
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mbedtls/base64.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_EVENT_WIRE_SIZE   12
+#define TRACE_HEADER_SIZE       24
+#define TRACE_LOG_CHUNK         57      // base64 后每行 76 字符
+
+_Static_assert((TRACE_CAPACITY & (TRACE_CAPACITY - 1)) == 0, "TRACE_CAPACITY 须为 2 的幂");
+
+static trace_event_t s_ring[TRACE_CAPACITY];
+static _Atomic uint32_t s_head = 0;         // 下一个占位序号
+static _Atomic uint32_t s_dropped = 0;      // 暂停期间丢弃的事件
+static _Atomic bool s_paused = false;
+
+// 已注册事件名链表，首次记录时用 CAS 插入
+static _Atomic(trace_name_t*) s_names = NULL;
+static _Atomic uint16_t s_next_id = 1;
+
+// 任务槽：首次在该任务中记录时用 CAS 占用，名字随后复制
+static _Atomic(TaskHandle_t) s_tasks[TRACE_MAX_TASKS];
+static char s_task_names[TRACE_MAX_TASKS][configMAX_TASK_NAME_LEN];
+
+static void trace_register(trace_name_t* name) {
+    bool expected = false;
+    if (!__atomic_compare_exchange_n(&name->registered, &expected, true, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    atomic_store(&name->id, atomic_fetch_add(&s_next_id, 1));
+    trace_name_t* head = atomic_load(&s_names);
+    do {
+        name->next = head;
+    } while (!atomic_compare_exchange_weak(&s_names, &head, name));
+}
+
+static uint8_t IRAM_ATTR task_slot(void) {
+    if (xPortInIsrContext()) return TRACE_TASK_ISR;
+    TaskHandle_t current = xTaskGetCurrentTaskHandle();
+    for (uint8_t i = 0; i < TRACE_MAX_TASKS; i++) {
+        TaskHandle_t slot = atomic_load_explicit(&s_tasks[i], memory_order_acquire);
+        if (slot == current) return i;
+        if (slot == NULL) {
+            if (atomic_compare_exchange_strong(&s_tasks[i], &slot, current)) {
+                strlcpy(s_task_names[i], pcTaskGetName(NULL), sizeof(s_task_names[i]));
+                return i;
+            }
+            if (slot == current) return i;
+        }
+    }
+    return TRACE_TASK_OTHER;
+}
+
+void IRAM_ATTR trace_record(trace_name_t* name, trace_event_type_t type, uint32_t arg) {
+    if (atomic_load_explicit(&s_paused, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&s_dropped, 1, memory_order_relaxed);
+        return;
+    }
+    if (!name->registered) {
+        trace_register(name);
+    }
+    uint8_t task = task_slot() | (uint8_t)(xPortGetCoreID() << 7);
+    uint32_t index = atomic_fetch_add_explicit(&s_head, 1, memory_order_relaxed);
+    trace_event_t* e = &s_ring[index & (TRACE_CAPACITY - 1)];
+
+    atomic_store_explicit(&e->seq, 0, memory_order_relaxed);
+    e->ts_us = (uint32_t)esp_timer_get_time();
+    e->arg = arg;
+    e->name_id = atomic_load_explicit(&name->id, memory_order_relaxed);
+    e->type = (uint8_t)type;
+    e->task = task;
+    atomic_store_explicit(&e->seq, index + 1, memory_order_release);
+}
+
+size_t trace_dump_size(void) {
+    size_t size = TRACE_HEADER_SIZE + (size_t)TRACE_CAPACITY * TRACE_EVENT_WIRE_SIZE;
+    for (trace_name_t* n = atomic_load(&s_names); n; n = n->next) {
+        size += 3 + strnlen(n->name, UINT8_MAX);
+    }
+    size += (size_t)TRACE_MAX_TASKS * (2 + configMAX_TASK_NAME_LEN);
+    return size;
+}
+
+static uint8_t* put_u8(uint8_t* p, uint8_t v) { *p++ = v; return p; }
+static uint8_t* put_u16(uint8_t* p, uint16_t v) { *p++ = v; *p++ = v >> 8; return p; }
+static uint8_t* put_u32(uint8_t* p, uint32_t v) { p = put_u16(p, v); return put_u16(p, v >> 16); }
+static uint8_t* put_u64(uint8_t* p, uint64_t v) { p = put_u32(p, (uint32_t)v); return put_u32(p, v >> 32); }
+static uint8_t* put_str(uint8_t* p, const char* s, size_t len) { memcpy(p, s, len); return p + len; }
+
+int trace_dump(uint8_t* buf, size_t size) {
+    if (size < trace_dump_size()) return -1;
+
+    atomic_store(&s_paused, true);
+    uint64_t now_us = (uint64_t)esp_timer_get_time();
+    uint32_t head = atomic_load(&s_head);
+    uint32_t first = head > TRACE_CAPACITY ? head - TRACE_CAPACITY : 0;
+
+    uint8_t* p = buf + TRACE_HEADER_SIZE;
+    uint16_t name_count = 0;
+    for (trace_name_t* n = atomic_load(&s_names); n; n = n->next) {
+        size_t len = strnlen(n->name, UINT8_MAX);
+        p = put_u16(p, atomic_load(&n->id));
+        p = put_u8(p, (uint8_t)len);
+        p = put_str(p, n->name, len);
+        name_count++;
+    }
+    uint8_t task_count = 0;
+    for (uint8_t i = 0; i < TRACE_MAX_TASKS; i++) {
+        if (atomic_load(&s_tasks[i]) == NULL) continue;
+        size_t len = strnlen(s_task_names[i], sizeof(s_task_names[i]));
+        p = put_u8(p, i);
+        p = put_u8(p, (uint8_t)len);
+        p = put_str(p, s_task_names[i], len);
+        task_count++;
+    }
+    uint32_t event_count = 0;
+    for (uint32_t index = first; index != head; index++) {
+        const trace_event_t* e = &s_ring[index & (TRACE_CAPACITY - 1)];
+        // 被覆盖或暂停前仍在写的槽位序号对不上，跳过
+        if (atomic_load_explicit(&e->seq, memory_order_acquire) != index + 1) continue;
+        p = put_u32(p, e->ts_us);
+        p = put_u32(p, e->arg);
+        p = put_u16(p, e->name_id);
+        p = put_u8(p, e->type);
+        p = put_u8(p, e->task);
+        event_count++;
+    }
+    uint32_t dropped = atomic_exchange(&s_dropped, 0);
+    atomic_store(&s_paused, false);
+
+    uint8_t* h = buf;
+    h = put_str(h, "FTRC", 4);
+    h = put_u8(h, TRACE_DUMP_VERSION);
+    h = put_u8(h, task_count);
+    h = put_u16(h, name_count);
+    h = put_u32(h, event_count);
+    h = put_u32(h, dropped);
+    put_u64(h, now_us);
+    return (int)(p - buf);
+}
+
+void trace_dump_to_log(void) {
+    size_t size = trace_dump_size();
+    uint8_t* buf = malloc(size);
+    if (!buf) return;
+    int len = trace_dump(buf, size);
+    if (len > 0) {
+        printf("-----BEGIN FAN TRACE-----\n");
+        for (int i = 0; i < len; i += TRACE_LOG_CHUNK) {
+            unsigned char line[80];
+            size_t out = 0;
+            size_t n = (size_t)(len - i) < TRACE_LOG_CHUNK ? (size_t)(len - i) : TRACE_LOG_CHUNK;
+            if (mbedtls_base64_encode(line, sizeof(line), &out, buf + i, n) == 0) {
+                printf("%.*s\n", (int)out, line);
+            }
+        }
+        printf("-----END FAN TRACE-----\n");
+    }
+    free(buf);
+}
+
+#endif // TRACE_ENABLE
@@ -0,0 +1,99 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 二进制事件追踪：固定大小环形缓冲，记录 begin/end/instant/counter 事件、
+ *        任务和核心号及微秒时间戳，用于还原现场时序（I2C 卡死、MQTT 重连风暴、错过控制周期）
+ *        记录无锁（一次原子 fetch_add 占位 + 序号提交），可在中断中调用；缓冲写满后覆盖最旧事件。
+ *        导出为紧凑二进制，由 tools/trace2perfetto.py 转换为 Perfetto/Chrome trace JSON
+ *
+ *        TRACE_ENABLE 为 0 时（在组件 CMakeLists 中以 PUBLIC 编译定义给出）所有记录点编译掉
+ */
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE 1
+#endif
+
+#define TRACE_CAPACITY      512     // 事件数，须为 2 的幂
+#define TRACE_MAX_TASKS     24      // 可区分的任务数，超出的任务记为 TRACE_TASK_OTHER
+#define TRACE_TASK_ISR      0x7F    // 中断上下文
+#define TRACE_TASK_OTHER    0x7E
+#define TRACE_DUMP_VERSION  1
+
+typedef enum {
+    TRACE_EV_BEGIN   = 'B',
+    TRACE_EV_END     = 'E',
+    TRACE_EV_INSTANT = 'i',
+    TRACE_EV_COUNTER = 'C',
+} trace_event_type_t;
+
+// 事件名，首次记录时注册并分配编号
+typedef struct trace_name {
+    const char* name;
+    _Atomic uint16_t id;        // 0 表示尚未分配
+    bool registered;
+    struct trace_name* next;
+} trace_name_t;
+
+typedef struct {
+    uint32_t ts_us;             // esp_timer 时间低 32 位（导出时按导出时刻展开）
+    _Atomic uint32_t seq;       // 占位序号 + 1，写完后提交；0 表示正在写
+    uint32_t arg;
+    uint16_t name_id;
+    uint8_t type;               // trace_event_type_t
+    uint8_t task;               // bit7 核心号，低 7 位任务槽
+} trace_event_t;
+
+#if TRACE_ENABLE
+
+// 定义事件名（文件作用域）
+#define TRACE_NAME(var, event_name) \
+    static trace_name_t var = { .name = event_name }
+#define TRACE_BEGIN(var)            trace_record(&(var), TRACE_EV_BEGIN, 0)
+#define TRACE_END(var)              trace_record(&(var), TRACE_EV_END, 0)
+#define TRACE_INSTANT(var, arg)     trace_record(&(var), TRACE_EV_INSTANT, (uint32_t)(arg))
+#define TRACE_COUNTER(var, value)   trace_record(&(var), TRACE_EV_COUNTER, (uint32_t)(value))
+
+void trace_record(trace_name_t* name, trace_event_type_t type, uint32_t arg);
+
+/**
+ * @brief 导出所需缓冲大小上界
+ */
+size_t trace_dump_size(void);
+
+/**
+ * @brief 导出为二进制（导出期间暂停记录，期间的事件计入丢弃数）
+ *        格式（小端）：
+ *          头   "FTRC" u8 版本 u8 任务数 u16 事件名数 u32 事件数 u32 丢弃数 u64 导出时刻(us)
+ *          事件名 { u16 编号 u8 长度 char[长度] } × 事件名数
+ *          任务  { u8 任务槽 u8 长度 char[长度] } × 任务数
+ *          事件  { u32 时间 u32 参数 u16 事件名编号 u8 类型 u8 任务 } × 事件数，按时间先后
+ * @return 写入长度，缓冲不足返回 -1
+ */
+int trace_dump(uint8_t* buf, size_t size);
+
+/**
+ * @brief 以 base64 输出到串口日志，位于 TRACE BEGIN/END 标记行之间
+ */
+void trace_dump_to_log(void);
+
+#else
+
+#define TRACE_NAME(var, event_name)
+#define TRACE_BEGIN(var)            do { } while (0)
+#define TRACE_END(var)              do { } while (0)
+#define TRACE_INSTANT(var, arg)     do { } while (0)
+#define TRACE_COUNTER(var, value)   do { } while (0)
+
+static inline size_t trace_dump_size(void) { return 0; }
+static inline int trace_dump(uint8_t* buf, size_t size) { (void)buf; (void)size; return -1; }
+static inline void trace_dump_to_log(void) { }
+
+#endif // TRACE_ENABLE
+
+#endif // TRACE_H
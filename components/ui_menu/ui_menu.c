@@ -0,0 +1,155 @@
+#include "ui_menu.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char* const s_confirm_choices[] = { "No", "Yes" };
+
+void ui_menu_init(ui_menu_t* menu, const char* title, ui_item_t* items, uint8_t count) {
+    menu->title = title;
+    menu->items = items;
+    menu->count = count;
+    menu->open = false;
+    menu->editing = false;
+    menu->focus = 0;
+    menu->top = 0;
+    menu->edit = 0.0f;
+}
+
+void ui_menu_open(ui_menu_t* menu) {
+    menu->open = true;
+    menu->editing = false;
+    menu->focus = 0;
+    menu->top = 0;
+}
+
+void ui_menu_close(ui_menu_t* menu) {
+    menu->open = false;
+    menu->editing = false;
+}
+
+/**
+ * @brief 编辑值按步数调整
+ */
+static float adjust(const ui_item_t* item, float value, int steps) {
+    switch (item->type) {
+    case UI_ITEM_VALUE: {
+        // 按步长取整，避免浮点累加误差在显示上出现 29.999
+        float v = roundf(value / item->step + steps) * item->step;
+        return v < item->min ? item->min : v > item->max ? item->max : v;
+    }
+    case UI_ITEM_CHOICE: {
+        int n = item->choice_count;
+        int i = ((int)value + steps) % n;
+        return (float)(i < 0 ? i + n : i);
+    }
+    case UI_ITEM_CONFIRM:
+        return steps % 2 ? 1.0f - value : value;
+    default:
+        return value;
+    }
+}
+
+ui_menu_result_t ui_menu_input(ui_menu_t* menu, ui_key_t key, int steps) {
+    if (!menu->open || menu->count == 0) return UI_MENU_IGNORED;
+    ui_item_t* item = &menu->items[menu->focus];
+
+    switch (key) {
+    case UI_KEY_ROTATE: {
+        if (steps == 0) return UI_MENU_IGNORED;
+        if (menu->editing) {
+            float v = adjust(item, menu->edit, steps);
+            if (v == menu->edit) return UI_MENU_IGNORED;
+            menu->edit = v;
+            return UI_MENU_REDRAW;
+        }
+        int focus = menu->focus + steps;
+        focus = focus < 0 ? 0 : focus >= menu->count ? menu->count - 1 : focus;
+        if (focus == menu->focus) return UI_MENU_IGNORED;
+        menu->focus = (uint8_t)focus;
+        if (menu->focus < menu->top) {
+            menu->top = menu->focus;
+        } else if (menu->focus >= menu->top + UI_MENU_VISIBLE_ROWS) {
+            menu->top = menu->focus - UI_MENU_VISIBLE_ROWS + 1;
+        }
+        return UI_MENU_REDRAW;
+    }
+    case UI_KEY_CLICK:
+        if (item->type == UI_ITEM_BACK) {
+            ui_menu_close(menu);
+            return UI_MENU_CLOSED;
+        }
+        if (!menu->editing) {
+            menu->editing = true;
+            menu->edit = item->type == UI_ITEM_CONFIRM ? 0.0f : item->value;
+            return UI_MENU_REDRAW;
+        }
+        menu->editing = false;
+        if (item->type == UI_ITEM_CONFIRM) {
+            return menu->edit != 0.0f ? UI_MENU_COMMIT : UI_MENU_REDRAW;
+        }
+        if (menu->edit == item->value) return UI_MENU_REDRAW;
+        item->value = menu->edit;
+        return UI_MENU_COMMIT;
+    case UI_KEY_LONG:
+        if (menu->editing) {
+            menu->editing = false;
+            return UI_MENU_REDRAW;
+        }
+        ui_menu_close(menu);
+        return UI_MENU_CLOSED;
+    }
+    return UI_MENU_IGNORED;
+}
+
+/**
+ * @brief 设置项的值文本
+ */
+static void format_value(const ui_item_t* item, float value, char* buf, size_t len) {
+    switch (item->type) {
+    case UI_ITEM_VALUE:
+        snprintf(buf, len, "%.*f%s", item->decimals, value, item->unit ? item->unit : "");
+        break;
+    case UI_ITEM_CHOICE:
+        snprintf(buf, len, "%s", item->choices[(int)value % item->choice_count]);
+        break;
+    case UI_ITEM_CONFIRM:
+        snprintf(buf, len, "%s", s_confirm_choices[value != 0.0f]);
+        break;
+    default:
+        buf[0] = '\0';
+        break;
+    }
+}
+
+void ui_menu_render(const ui_menu_t* menu, oled_frame_t* frame) {
+    oled_frame_clear(frame);
+    int pad = (OLED_FRAME_COLS - (int)strlen(menu->title)) / 2;
+    oled_frame_printf(frame, 0, "%*s%s", pad > 0 ? pad : 0, "", menu->title);
+
+    for (int row = 0; row < UI_MENU_VISIBLE_ROWS; row++) {
+        int index = menu->top + row;
+        if (index >= menu->count) break;
+        const ui_item_t* item = &menu->items[index];
+        bool focused = index == menu->focus;
+        char value[12];
+        if (focused && menu->editing) {
+            char inner[10];
+            format_value(item, menu->edit, inner, sizeof(inner));
+            snprintf(value, sizeof(value), "[%s]", inner);
+        } else if (item->type == UI_ITEM_CONFIRM) {
+            value[0] = '\0';    // 动作项平时不显示值
+        } else {
+            format_value(item, item->value, value, sizeof(value));
+        }
+        // 1 列焦点标记 + 标签左对齐 + 值右对齐，共 21 列
+        oled_frame_printf(frame, row + 1, "%c%-*.*s%*s", focused ? '>' : ' ',
+                          UI_MENU_LABEL_LEN, UI_MENU_LABEL_LEN, item->label,
+                          OLED_FRAME_COLS - 1 - UI_MENU_LABEL_LEN, value);
+        if (focused) {
+            frame->inverted |= 1u << (row + 1);
+        }
+    }
+    oled_frame_printf(frame, OLED_FRAME_ROWS - 1, "%s",
+                      menu->editing ? "Click:OK  Hold:cancel" : "Click:edit Hold:exit");
+}
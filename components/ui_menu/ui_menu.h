@@ -0,0 +1,82 @@
+#ifndef UI_MENU_H
+#define UI_MENU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "oled_frame.h"
+
+/**
+ * @brief 编码器驱动的设置菜单
+ *        旋转移动焦点，短按进入编辑、旋转调整、再短按确认；长按取消编辑或退出菜单
+ *        菜单只维护状态并渲染为文本帧，设置项的生效由调用方在 UI_MENU_COMMIT 时完成
+ *        纯C实现，不依赖ESP-IDF
+ */
+
+#define UI_MENU_VISIBLE_ROWS 6      // 第 0 行标题、第 7 行提示，中间 6 行为设置项
+#define UI_MENU_LABEL_LEN    10
+
+typedef enum {
+    UI_ITEM_VALUE,              // 数值，按 step 调整并限制在 [min, max]
+    UI_ITEM_CHOICE,             // 枚举，value 为 choices 下标，循环切换
+    UI_ITEM_CONFIRM,            // 动作，编辑时选择 No/Yes，选 Yes 确认才提交
+    UI_ITEM_BACK,               // 退出菜单
+} ui_item_type_t;
+
+typedef struct {
+    const char* label;          // 不超过 UI_MENU_LABEL_LEN 个字符
+    ui_item_type_t type;
+    float value;
+    float min;
+    float max;
+    float step;
+    uint8_t decimals;
+    const char* unit;
+    const char* const* choices;
+    uint8_t choice_count;
+} ui_item_t;
+
+typedef enum {
+    UI_KEY_ROTATE,              // steps 为顺时针步数
+    UI_KEY_CLICK,
+    UI_KEY_LONG,
+} ui_key_t;
+
+typedef enum {
+    UI_MENU_IGNORED = 0,        // 菜单未打开或输入无效果
+    UI_MENU_REDRAW,             // 焦点或编辑值变化
+    UI_MENU_COMMIT,             // 焦点项的新值已写入 items[focus].value
+    UI_MENU_CLOSED,
+} ui_menu_result_t;
+
+typedef struct {
+    const char* title;
+    ui_item_t* items;
+    uint8_t count;
+    bool open;
+    bool editing;
+    uint8_t focus;
+    uint8_t top;                // 第一行可见项
+    float edit;                 // 编辑中的值，确认后才写回
+} ui_menu_t;
+
+void ui_menu_init(ui_menu_t* menu, const char* title, ui_item_t* items, uint8_t count);
+
+/**
+ * @brief 打开菜单，焦点回到第一项（调用前由调用方把各项 value 更新为当前设置）
+ */
+void ui_menu_open(ui_menu_t* menu);
+
+void ui_menu_close(ui_menu_t* menu);
+
+/**
+ * @brief 处理一次输入
+ * @param steps UI_KEY_ROTATE 的步数，其他按键忽略
+ */
+ui_menu_result_t ui_menu_input(ui_menu_t* menu, ui_key_t key, int steps);
+
+/**
+ * @brief 渲染为文本帧：焦点行反色，编辑中的值加方括号
+ */
+void ui_menu_render(const ui_menu_t* menu, oled_frame_t* frame);
+
+#endif // UI_MENU_H
@@ -0,0 +1,70 @@
+#include "button_gesture.h"
+
+enum {
+    GESTURE_IDLE = 0,
+    GESTURE_DOWN,               // 第一次按下
+    GESTURE_UP,                 // 第一次松开，等待双击
+    GESTURE_DOWN2,              // 第二次按下，消抖中
+    GESTURE_WAIT_RELEASE,       // 已触发长按或双击，等待松开
+};
+
+void button_gesture_init(button_gesture_t* g, uint16_t debounce_ms, uint16_t long_ms, uint16_t double_ms) {
+    g->debounce_ms = debounce_ms;
+    g->long_ms = long_ms;
+    g->double_ms = double_ms;
+    g->state = GESTURE_IDLE;
+    g->down_ms = 0;
+    g->up_ms = 0;
+}
+
+button_gesture_event_t button_gesture_update(button_gesture_t* g, bool pressed, uint32_t now_ms) {
+    switch (g->state) {
+    case GESTURE_IDLE:
+        if (pressed) {
+            g->state = GESTURE_DOWN;
+            g->down_ms = now_ms;
+        }
+        break;
+    case GESTURE_DOWN:
+        if (pressed) {
+            if (now_ms - g->down_ms >= g->long_ms) {
+                g->state = GESTURE_WAIT_RELEASE;
+                return BUTTON_GESTURE_LONG;
+            }
+        } else if (now_ms - g->down_ms < g->debounce_ms) {
+            g->state = GESTURE_IDLE;
+        } else {
+            g->state = GESTURE_UP;
+            g->up_ms = now_ms;
+        }
+        break;
+    case GESTURE_UP:
+        if (pressed) {
+            g->state = GESTURE_DOWN2;
+            g->down_ms = now_ms;
+        } else if (now_ms - g->up_ms >= g->double_ms) {
+            g->state = GESTURE_IDLE;
+            return BUTTON_GESTURE_CLICK;
+        }
+        break;
+    case GESTURE_DOWN2:
+        if (!pressed) {
+            // 第一次松开时的抖动，回到等待窗口
+            g->state = GESTURE_UP;
+        } else if (now_ms - g->down_ms >= g->debounce_ms) {
+            g->state = GESTURE_WAIT_RELEASE;
+            return BUTTON_GESTURE_DOUBLE;
+        }
+        break;
+    case GESTURE_WAIT_RELEASE:
+        if (!pressed) {
+            g->state = GESTURE_IDLE;
+        }
+        break;
+    }
+    return BUTTON_GESTURE_NONE;
+}
+
+bool button_gesture_busy(const button_gesture_t* g) {
+    return g->state != GESTURE_IDLE;
+}
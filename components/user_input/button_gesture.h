@@ -0,0 +1,45 @@
+#ifndef BUTTON_GESTURE_H
+#define BUTTON_GESTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 按键手势识别：短按、长按、双击
+ *        按键期间由任务周期性传入电平和时间，不在中断中计时
+ *        短按要等双击窗口结束才确认；长按在按住达到时长时立即触发
+ *        纯C实现，不依赖ESP-IDF
+ */
+
+typedef enum {
+    BUTTON_GESTURE_NONE = 0,
+    BUTTON_GESTURE_CLICK,
+    BUTTON_GESTURE_LONG,
+    BUTTON_GESTURE_DOUBLE,
+} button_gesture_event_t;
+
+typedef struct {
+    uint16_t debounce_ms;       // 短于此时长的按下视为抖动
+    uint16_t long_ms;           // 长按时长
+    uint16_t double_ms;         // 松开后等待第二次按下的窗口
+    uint8_t state;
+    uint32_t down_ms;           // 最近一次按下时刻
+    uint32_t up_ms;             // 第一次松开时刻
+} button_gesture_t;
+
+void button_gesture_init(button_gesture_t* g, uint16_t debounce_ms, uint16_t long_ms, uint16_t double_ms);
+
+/**
+ * @brief 传入当前电平推进识别
+ * @param pressed 按键是否按下
+ * @param now_ms 单调时间（毫秒）
+ * @return 本次识别出的手势
+ */
+button_gesture_event_t button_gesture_update(button_gesture_t* g, bool pressed, uint32_t now_ms);
+
+/**
+ * @brief 手势未结束，需要继续周期性调用 button_gesture_update()
+ */
+bool button_gesture_busy(const button_gesture_t* g);
+
+#endif // BUTTON_GESTURE_H
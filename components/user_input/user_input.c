@@ -1,48 +1,176 @@
 #include "user_input.h"
+#include "button_gesture.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "esp_sleep.h"
+#include "hal/gpio_ll.h"
+#include "trace.h"
+#include "power_mgmt.h"
 
 static const char* TAG = "USER_INPUT"; // 日志标签
 static mode_change_cb_t mode_cb;         // 模式切换回调函数指针
 static speed_change_cb_t speed_cb;       // 速度调整回调函数指针
+static long_press_cb_t long_press_cb;    // 长按回调函数指针
+static user_input_event_cb_t event_cb;   // 输入事件回调函数指针
+static TaskHandle_t s_input_task;        // 输入处理任务
+static QueueHandle_t s_input_queue;      // 中断 → 输入任务的原始事件
+static button_gesture_t s_gesture;
 static bool last_a_level;                // 上次 A 相信号电平
 static uint8_t speed = 0;                // 当前风扇速度百分比
-static bool auto_mode = true;            // 当前模式：true=自动，false=手动
+static volatile bool auto_mode = true;   // 当前模式：true=自动，false=手动
 
 // 保存引脚配置
 static gpio_num_t gpio_pin_a;
 static gpio_num_t gpio_pin_b;
 static gpio_num_t gpio_pin_btn;
 
+#define BTN_POLL_MS      20     // 手势进行中的电平轮询间隔
+#define BTN_DEBOUNCE_MS  40     // 短于此时长的按下视为抖动
+#define INPUT_QUEUE_LEN  16
+#define INPUT_AWAKE_MS   2000   // 最后一次输入后保持不进入浅睡眠的时长
+
+// 队列中的原始事件：+1/-1 为编码器一步，0 为按键按下
+#define INPUT_RAW_BUTTON 0
+
+TRACE_NAME(t_btn_isr, "btn_isr");
+TRACE_NAME(t_encoder_isr, "encoder_isr");
+TRACE_NAME(t_gesture, "btn_gesture");
+
 /**
  * @brief GPIO 中断处理函数
- *        处理 EC11 编码器 A/B 相和按钮按下事件
+ *        只读取 EC11 编码器方向和按键边沿并放入队列，计时和回调都在输入任务中完成
  * @param arg 触发中断的 GPIO 引脚编号
  */
 static void IRAM_ATTR gpio_isr_handler(void* arg) {
     uint32_t gpio_num = (uint32_t) arg;
+    BaseType_t woken = pdFALSE;
     if (gpio_num == gpio_pin_btn) {
-        // 按键按下，切换自动/手动模式
-        auto_mode = !auto_mode;
-        mode_cb(auto_mode); // 调用模式切换回调
+        // 按键按下：关闭按键中断（低电平唤醒模式下按住会持续触发），手势结束后由输入任务重新打开
+        gpio_ll_intr_disable(&GPIO, gpio_pin_btn);
+        TRACE_INSTANT(t_btn_isr, gpio_num);
+        int8_t raw = INPUT_RAW_BUTTON;
+        xQueueSendFromISR(s_input_queue, &raw, &woken);
     } else if (gpio_num == gpio_pin_a) {
         // 编码器 A 相触发
         bool level = gpio_get_level(gpio_pin_a);
-        // 上升沿触发有效
+#ifdef CONFIG_PM_ENABLE
+        // A 相是电平唤醒源（GPIO 唤醒只支持电平）：改为等待相反电平，效果等同任意边沿，
+        // 读电平与改触发之间若再次翻转，电平中断会立即重入，不丢边沿
+        gpio_ll_set_intr_type(&GPIO, gpio_pin_a, level ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+#endif
+        // 上升沿触发有效，B 相电平决定方向
         if (last_a_level == 0 && level == 1) {
-            if (gpio_get_level(gpio_pin_b)) {
-                // 顺时针旋转，速度增加
-                if (speed < 100) speed++;
-            } else {
-                // 逆时针旋转，速度减少
-                if (speed > 0) speed--;
-            }
-            speed_cb(speed); // 调用速度调整回调
+            int8_t raw = gpio_get_level(gpio_pin_b) ? 1 : -1;
+            TRACE_INSTANT(t_encoder_isr, raw);
+            xQueueSendFromISR(s_input_queue, &raw, &woken);
         }
         last_a_level = level;
     }
+    portYIELD_FROM_ISR(woken);
+}
+
+/**
+ * @brief 先交给事件回调，未处理时执行默认动作
+ */
+static void dispatch(const user_input_event_t* event) {
+    if (event_cb && event_cb(event)) return;
+    switch (event->type) {
+    case USER_INPUT_ROTATE: {
+        int value = speed + event->steps;
+        speed = value < 0 ? 0 : value > 100 ? 100 : (uint8_t)value;
+        speed_cb(speed); // 调用速度调整回调
+        break;
+    }
+    case USER_INPUT_CLICK:
+        auto_mode = !auto_mode;
+        mode_cb(auto_mode); // 调用模式切换回调
+        break;
+    case USER_INPUT_LONG_PRESS:
+        if (long_press_cb) long_press_cb();
+        break;
+    case USER_INPUT_DOUBLE_CLICK:
+        break;
+    }
+}
+
+/**
+ * @brief 输入任务：合并编码器步数，按键手势进行中每 BTN_POLL_MS 轮询一次电平
+ *        有输入后持有 PM_LOCK_INPUT 至最后一次输入 INPUT_AWAKE_MS 之后：第一格由 A 相唤醒，
+ *        连续转动的后续边沿在 CPU 保持运行时采样，不受浅睡眠唤醒延迟影响
+ */
+static void input_task(void* arg) {
+    bool btn_intr_off = false;
+    bool awake = false;
+    uint32_t last_input_ms = 0;
+    while (1) {
+        bool busy = button_gesture_busy(&s_gesture);
+        TickType_t wait = (busy || btn_intr_off) ? pdMS_TO_TICKS(BTN_POLL_MS)
+                        : awake ? pdMS_TO_TICKS(INPUT_AWAKE_MS) : portMAX_DELAY;
+        int steps = 0;
+        int8_t raw;
+        bool received = xQueueReceive(s_input_queue, &raw, wait) == pdTRUE;
+        uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+        if (received) {
+            if (!awake) {
+                power_mgmt_acquire(PM_LOCK_INPUT);
+                awake = true;
+            }
+            last_input_ms = now_ms;
+            // 一次取完队列：快速旋转合并为一个事件，界面只刷新一次
+            do {
+                if (raw == INPUT_RAW_BUTTON) {
+                    btn_intr_off = true;
+                } else {
+                    steps += raw;
+                }
+            } while (xQueueReceive(s_input_queue, &raw, 0) == pdTRUE);
+        }
+        if (steps) {
+            user_input_event_t event = { .type = USER_INPUT_ROTATE, .steps = (int16_t)steps };
+            dispatch(&event);
+        }
+        if (btn_intr_off || busy) {
+            bool pressed = gpio_get_level(gpio_pin_btn) == 0;
+            button_gesture_event_t gesture = button_gesture_update(&s_gesture, pressed, now_ms);
+            if (gesture != BUTTON_GESTURE_NONE) {
+                TRACE_INSTANT(t_gesture, gesture);
+                static const user_input_event_type_t types[] = {
+                    [BUTTON_GESTURE_CLICK]  = USER_INPUT_CLICK,
+                    [BUTTON_GESTURE_LONG]   = USER_INPUT_LONG_PRESS,
+                    [BUTTON_GESTURE_DOUBLE] = USER_INPUT_DOUBLE_CLICK,
+                };
+                user_input_event_t event = { .type = types[gesture] };
+                dispatch(&event);
+            }
+            // 手势结束且按键已松开后重新打开中断，等待下一次按下
+            if (btn_intr_off && !pressed && !button_gesture_busy(&s_gesture)) {
+                btn_intr_off = false;
+                gpio_intr_enable(gpio_pin_btn);
+            }
+            if (pressed) last_input_ms = now_ms;
+        }
+        if (awake && !btn_intr_off && !button_gesture_busy(&s_gesture) &&
+            now_ms - last_input_ms >= INPUT_AWAKE_MS) {
+            power_mgmt_release(PM_LOCK_INPUT);
+            awake = false;
+        }
+    }
+}
+
+void user_input_set_long_press_callback(long_press_cb_t cb) {
+    long_press_cb = cb;
+}
+
+void user_input_set_event_callback(user_input_event_cb_t cb) {
+    event_cb = cb;
+}
+
+void user_input_set_mode(bool mode) {
+    auto_mode = mode;
 }
 
 /**
@@ -81,6 +209,10 @@ void user_input_init(gpio_num_t pin_a, gpio_num_t pin_b, gpio_num_t pin_btn,
     };
     gpio_config(&btn_conf);
 
+    button_gesture_init(&s_gesture, BTN_DEBOUNCE_MS, USER_INPUT_LONG_PRESS_MS, USER_INPUT_DOUBLE_CLICK_MS);
+    s_input_queue = xQueueCreate(INPUT_QUEUE_LEN, sizeof(int8_t));
+    xTaskCreate(input_task, "input_task", 3072, NULL, 4, &s_input_task);
+
     // 安装并启动 GPIO 中断服务
     gpio_install_isr_service(0);
     gpio_isr_handler_add(pin_a, gpio_isr_handler, (void*) pin_a);
@@ -89,5 +221,13 @@ void user_input_init(gpio_num_t pin_a, gpio_num_t pin_b, gpio_num_t pin_btn,
 
     // 读取初始 A 相电平
     last_a_level = gpio_get_level(pin_a);
+
+#ifdef CONFIG_PM_ENABLE
+    // tickless idle 浅睡眠期间按键低电平或 A 相电平变化可唤醒 CPU；
+    // 唤醒使能会把中断改为电平触发，A 相此后由中断处理函数交替设置等待的电平
+    gpio_wakeup_enable(pin_btn, GPIO_INTR_LOW_LEVEL);
+    gpio_wakeup_enable(pin_a, last_a_level ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+#endif
     ESP_LOGI(TAG, "User input initialized: A=%d B=%d BTN=%d", pin_a, pin_b, pin_btn);
 }
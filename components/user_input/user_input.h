@@ -9,6 +9,26 @@
 typedef void (*mode_change_cb_t)(bool auto_mode);
 // 速度改变回调类型：当手动模式下旋转编码器调速时调用
 typedef void (*speed_change_cb_t)(uint8_t new_speed);
+// 长按回调类型：按键按住超过 USER_INPUT_LONG_PRESS_MS 时调用一次
+typedef void (*long_press_cb_t)(void);
+
+#define USER_INPUT_LONG_PRESS_MS   2000
+#define USER_INPUT_DOUBLE_CLICK_MS 300     // 短按在此窗口结束后才确认
+
+typedef enum {
+    USER_INPUT_ROTATE,          // 旋转，steps 为顺时针步数（逆时针为负）
+    USER_INPUT_CLICK,
+    USER_INPUT_LONG_PRESS,
+    USER_INPUT_DOUBLE_CLICK,
+} user_input_event_type_t;
+
+typedef struct {
+    user_input_event_type_t type;
+    int16_t steps;
+} user_input_event_t;
+
+// 输入事件回调：返回 true 表示已处理，不再执行默认动作（调速/切换模式/长按回调）
+typedef bool (*user_input_event_cb_t)(const user_input_event_t* event);
 
 /**
  * @brief 初始化 EC11 旋转编码器输入
@@ -17,8 +37,26 @@ typedef void (*speed_change_cb_t)(uint8_t new_speed);
  * @param pin_btn GPIO 引脚，连接编码器按键
  * @param mode_cb 模式切换回调函数
  * @param speed_cb 速度调整回调函数
+ *        所有回调都在输入任务中调用；中断只把编码器和按键边沿放入队列
  */
 void user_input_init(gpio_num_t pin_a, gpio_num_t pin_b, gpio_num_t pin_btn,
                      mode_change_cb_t mode_cb, speed_change_cb_t speed_cb);
 
+/**
+ * @brief 设置按键长按回调（在输入任务中调用，不在中断上下文）
+ * @param cb 长按回调函数
+ */
+void user_input_set_long_press_callback(long_press_cb_t cb);
+
+/**
+ * @brief 设置输入事件回调（在输入任务中调用），先于默认动作执行，用于菜单等界面接管输入
+ * @param cb 事件回调函数
+ */
+void user_input_set_event_callback(user_input_event_cb_t cb);
+
+/**
+ * @brief 同步当前模式，模式被其他途径（MQTT、菜单）修改后调用，使下一次短按从正确的状态切换
+ */
+void user_input_set_mode(bool auto_mode);
+
 #endif // USER_INPUT_H
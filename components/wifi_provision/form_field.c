@@ -0,0 +1,71 @@
+#include "form_field.h"
+#include <string.h>
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief 解码到 out，*out_len 返回解码后长度；失败时 out 置为空串
+ */
+static form_field_result_t decode(const char* src, size_t len, char* out, size_t out_size, size_t* out_len) {
+    if (out_size == 0) return FORM_FIELD_TOO_LONG;
+    size_t n = 0;
+    form_field_result_t result = FORM_FIELD_OK;
+    for (size_t i = 0; i < len; i++) {
+        char c = src[i];
+        if (c == '%') {
+            // 逐字节检查剩余长度，不越过 len 读取
+            int hi = i + 1 < len ? hex_value(src[i + 1]) : -1;
+            int lo = i + 2 < len ? hex_value(src[i + 2]) : -1;
+            if (hi < 0 || lo < 0) {
+                result = FORM_FIELD_BAD_ENCODING;
+                break;
+            }
+            c = (char)(hi << 4 | lo);
+            i += 2;
+        } else if (c == '+') {
+            c = ' ';
+        }
+        // %00 会截断字符串，SSID/密码里不可能出现
+        if (c == '\0') {
+            result = FORM_FIELD_BAD_ENCODING;
+            break;
+        }
+        if (n + 1 >= out_size) {
+            result = FORM_FIELD_TOO_LONG;
+            break;
+        }
+        out[n++] = c;
+    }
+    out[result == FORM_FIELD_OK ? n : 0] = '\0';
+    *out_len = n;
+    return result;
+}
+
+int form_url_decode(const char* src, size_t len, char* out, size_t out_size) {
+    size_t n;
+    return decode(src, len, out, out_size, &n) == FORM_FIELD_OK ? (int)n : -1;
+}
+
+form_field_result_t form_field_get(const char* body, size_t len, const char* key, char* out, size_t out_size) {
+    if (out_size) out[0] = '\0';
+    size_t key_len = strlen(key);
+    size_t pos = 0;
+    while (pos < len) {
+        const char* amp = memchr(body + pos, '&', len - pos);
+        size_t end = amp ? (size_t)(amp - body) : len;
+        const char* eq = memchr(body + pos, '=', end - pos);
+        size_t name_len = eq ? (size_t)(eq - (body + pos)) : end - pos;
+        if (name_len == key_len && memcmp(body + pos, key, key_len) == 0) {
+            const char* value = eq ? eq + 1 : body + end;
+            size_t n;
+            return decode(value, (size_t)(body + end - value), out, out_size, &n);
+        }
+        pos = end + 1;
+    }
+    return FORM_FIELD_MISSING;
+}
@@ -0,0 +1,37 @@
+#ifndef FORM_FIELD_H
+#define FORM_FIELD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief application/x-www-form-urlencoded 表单字段提取
+ *        按 '&' 分隔逐项比较完整键名（"ssid" 不会匹配 "xssid" 或密码值里的 "ssid="），
+ *        值按 %XX 与 '+' 解码后写入定长缓冲；所有读写都受长度约束，输入无需以 '\0' 结尾
+ *        纯C实现，不依赖ESP-IDF
+ */
+
+typedef enum {
+    FORM_FIELD_OK,
+    FORM_FIELD_MISSING,         // 没有该字段
+    FORM_FIELD_TOO_LONG,        // 解码后超出输出缓冲
+    FORM_FIELD_BAD_ENCODING     // 不完整的 %XX 或解码出 '\0'
+} form_field_result_t;
+
+/**
+ * @brief 取第一个名为 key 的字段
+ * @param body     表单数据
+ * @param len      数据长度
+ * @param key      字段名（不编码）
+ * @param out      输出缓冲，成功时以 '\0' 结尾；失败时置为空串
+ * @param out_size 输出缓冲大小（含 '\0'）
+ */
+form_field_result_t form_field_get(const char* body, size_t len, const char* key, char* out, size_t out_size);
+
+/**
+ * @brief 解码一段 URL 编码文本
+ * @return 解码后长度，超出 out_size-1 或编码错误返回 -1（out 置为空串）
+ */
+int form_url_decode(const char* src, size_t len, char* out, size_t out_size);
+
+#endif // FORM_FIELD_H
@@ -0,0 +1,44 @@
+#include "lan_auth.h"
+#include "form_field.h"
+#include <string.h>
+#include <strings.h>
+
+bool lan_auth_token_valid(const char* token) {
+    size_t len = strlen(token);
+    if (len < LAN_AUTH_TOKEN_MIN || len > LAN_AUTH_TOKEN_MAX) return false;
+    for (size_t i = 0; i < len; i++) {
+        if (token[i] <= ' ' || token[i] > '~') return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 比较候选值与令牌：循环次数只取决于令牌长度，不因首个不同字节提前返回
+ */
+static bool token_equal(const char* cand, size_t cand_len, const char* token) {
+    size_t token_len = strlen(token);
+    unsigned diff = cand_len != token_len;
+    for (size_t i = 0; i < token_len; i++) {
+        unsigned char c = i < cand_len ? (unsigned char)cand[i] : 0;
+        diff |= c ^ (unsigned char)token[i];
+    }
+    return diff == 0;
+}
+
+bool lan_auth_check_bearer(const char* header, const char* token) {
+    if (!header || !token[0]) return false;
+    while (*header == ' ') header++;
+    if (strncasecmp(header, "Bearer ", 7) != 0) return false;
+    const char* cand = header + 7;
+    while (*cand == ' ') cand++;
+    size_t len = strlen(cand);
+    while (len > 0 && cand[len - 1] == ' ') len--;
+    return token_equal(cand, len, token);
+}
+
+bool lan_auth_check_query(const char* query, size_t len, const char* token) {
+    if (!query || !token[0]) return false;
+    char cand[LAN_AUTH_TOKEN_MAX + 1];
+    if (form_field_get(query, len, "token", cand, sizeof(cand)) != FORM_FIELD_OK) return false;
+    return token_equal(cand, strlen(cand), token);
+}
@@ -0,0 +1,36 @@
+#ifndef LAN_AUTH_H
+#define LAN_AUTH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief 局域网写接口鉴权：HTTP 请求带 "Authorization: Bearer <令牌>"，
+ *        浏览器 WebSocket 无法设置请求头，也可在 URL 中带 ?token=<令牌>
+ *        令牌在配网页面与 WiFi 凭据一同设置；未设置令牌时写接口关闭
+ *        纯C实现，不依赖ESP-IDF
+ */
+
+#define LAN_AUTH_TOKEN_MIN  8
+#define LAN_AUTH_TOKEN_MAX  64      // 不含结尾 '\0'
+#define LAN_AUTH_HEADER_MAX (LAN_AUTH_TOKEN_MAX + 16)
+
+/**
+ * @brief 令牌格式：LAN_AUTH_TOKEN_MIN~LAN_AUTH_TOKEN_MAX 个可见 ASCII 字符（不含空格）
+ */
+bool lan_auth_token_valid(const char* token);
+
+/**
+ * @brief 校验 Authorization 请求头的值，方案名不区分大小写，比较耗时与输入内容无关
+ * @param header 请求头的值，NULL 视为缺失
+ * @param token  设备令牌，空串时一律拒绝
+ */
+bool lan_auth_check_bearer(const char* header, const char* token);
+
+/**
+ * @brief 校验 URL 查询串中的 token 参数（按 URL 编码解码后比较）
+ * @param query 查询串（不含 '?'），无需以 '\0' 结尾
+ */
+bool lan_auth_check_query(const char* query, size_t len, const char* token);
+
+#endif // LAN_AUTH_H
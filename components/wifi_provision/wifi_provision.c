@@ -1,6 +1,5 @@
 #include "wifi_provision.h"
 #include <string.h>
-#include <ctype.h>
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "esp_log.h"
@@ -8,8 +7,14 @@
 #include "esp_event.h"
 #include "esp_wifi.h"
 #include "esp_http_server.h"
+#include "power_mgmt.h"
+#include "form_field.h"
+#include "lan_auth.h"
 
 static const char *TAG = "WIFI_PROV";
+
+#define PROV_FORM_MAX 512     // 表单上限：SSID 31 字节、密码 63 字节全部百分号编码后约 300 字节
+
 static bool prov_done = false;
 
 /**
@@ -46,6 +51,8 @@ static esp_err_t root_get_handler(httpd_req_t *req) {
         "<input type='text' id='ssid' name='ssid' required maxlength='31' placeholder='请输入WiFi名称'>"
         "<label for='password'>WiFi密码:</label>"
         "<input type='password' id='password' name='password' maxlength='63' placeholder='请输入WiFi密码'>"
+        "<label for='api_token'>局域网接口令牌 (可选):</label>"
+        "<input type='password' id='api_token' name='api_token' minlength='8' maxlength='64' placeholder='留空则局域网只读'>"
         "<input type='submit' value='保存配置'>"
         "</form>"
         "</div>"
@@ -57,73 +64,55 @@ static esp_err_t root_get_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
-/**
- * @brief URL解码函数
- */
-static void url_decode(char *dst, const char *src) {
-    char a, b;
-    while (*src) {
-        if ((*src == '%') && ((a = src[1]) && (b = src[2])) && (isxdigit(a) && isxdigit(b))) {
-            if (a >= 'a') a -= 'a'-'A';
-            if (a >= 'A') a -= ('A' - 10);
-            else a -= '0';
-            if (b >= 'a') b -= 'a'-'A';
-            if (b >= 'A') b -= ('A' - 10);
-            else b -= '0';
-            *dst++ = 16*a+b;
-            src+=3;
-        } else if (*src == '+') {
-            *dst++ = ' ';
-            src++;
-        } else {
-            *dst++ = *src++;
-        }
-    }
-    *dst = '\0';
-}
-
 /**
  * @brief 处理配置页面表单提交，接收 SSID 和密码
  */
 static esp_err_t config_post_handler(httpd_req_t *req) {
-    char buf[256];
-    int len = httpd_req_recv(req, buf, req->content_len);
-    if (len <= 0) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Invalid Request");
+    char buf[PROV_FORM_MAX];
+    if (req->content_len == 0 || req->content_len >= sizeof(buf)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid Request");
         return ESP_FAIL;
     }
-    buf[len] = '\0';
-    
-    char ssid[32] = {0}, password[64] = {0};
-    char ssid_encoded[64] = {0}, password_encoded[128] = {0};
-    
-    // 解析表单数据
-    char *ssid_start = strstr(buf, "ssid=");
-    char *password_start = strstr(buf, "password=");
-    
-    if (ssid_start) {
-        ssid_start += 5; // 跳过"ssid="
-        char *ssid_end = strchr(ssid_start, '&');
-        if (ssid_end) {
-            strncpy(ssid_encoded, ssid_start, ssid_end - ssid_start);
-        } else {
-            strncpy(ssid_encoded, ssid_start, sizeof(ssid_encoded)-1);
+    int len = 0;
+    while (len < (int)req->content_len) {
+        int ret = httpd_req_recv(req, buf + len, req->content_len - len);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) continue;
+        if (ret <= 0) {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Invalid Request");
+            return ESP_FAIL;
         }
-        url_decode(ssid, ssid_encoded);
+        len += ret;
     }
     
-    if (password_start) {
-        password_start += 9; // 跳过"password="
-        strncpy(password_encoded, password_start, sizeof(password_encoded)-1);
-        url_decode(password, password_encoded);
+    // 解析表单数据，长度按 wifi_config_t 限制（SSID 32 字节可不以 '\0' 结尾，这里统一留出结尾）
+    char ssid[32] = {0}, password[64] = {0}, token[LAN_AUTH_TOKEN_MAX + 1] = {0};
+    form_field_result_t ssid_ret = form_field_get(buf, len, "ssid", ssid, sizeof(ssid));
+    form_field_result_t pass_ret = form_field_get(buf, len, "password", password, sizeof(password));
+    form_field_result_t token_ret = form_field_get(buf, len, "api_token", token, sizeof(token));
+    if (pass_ret == FORM_FIELD_MISSING) pass_ret = FORM_FIELD_OK;   // 开放网络
+    if (token_ret == FORM_FIELD_MISSING) token_ret = FORM_FIELD_OK; // 不设令牌：局域网写接口关闭
+    if (ssid_ret != FORM_FIELD_OK || ssid[0] == '\0' || pass_ret != FORM_FIELD_OK) {
+        ESP_LOGW(TAG, "表单无效: ssid=%d password=%d", ssid_ret, pass_ret);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid SSID or password");
+        return ESP_FAIL;
+    }
+    if (token_ret != FORM_FIELD_OK || (token[0] && !lan_auth_token_valid(token))) {
+        ESP_LOGW(TAG, "接口令牌无效: %d", token_ret);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "API token must be 8-64 visible ASCII characters");
+        return ESP_FAIL;
     }
     
-    ESP_LOGI(TAG, "收到配置：SSID=%s, PASS=%s", ssid, password);    // 保存WiFi配置到NVS
+    ESP_LOGI(TAG, "收到配置：SSID=%s, 密码 %u 字符", ssid, (unsigned)strlen(password));    // 保存WiFi配置到NVS
     nvs_handle_t nvs_handle;
     esp_err_t err = nvs_open("storage", NVS_READWRITE, &nvs_handle);
     if (err == ESP_OK) {
         nvs_set_str(nvs_handle, "wifi_ssid", ssid);
         nvs_set_str(nvs_handle, "wifi_password", password);
+        if (token[0]) {
+            nvs_set_str(nvs_handle, "api_token", token);
+        } else {
+            nvs_erase_key(nvs_handle, "api_token");
+        }
         nvs_commit(nvs_handle);
         nvs_close(nvs_handle);
         ESP_LOGI(TAG, "WiFi配置已保存到NVS");
@@ -257,6 +246,7 @@ void wifi_prov_connect_from_nvs(void) {
     wifi_config_t wifi_config = {
         .sta = {
             .threshold.authmode = WIFI_AUTH_WPA2_PSK,
+            .listen_interval = POWER_MGMT_LISTEN_INTERVAL,  // modem sleep 唤醒间隔
         },
     };
     strncpy((char*)wifi_config.sta.ssid, ssid, sizeof(wifi_config.sta.ssid)-1);
@@ -268,3 +258,36 @@ void wifi_prov_connect_from_nvs(void) {
     
     ESP_LOGI(TAG, "WiFi Station 模式已启动，正在连接到: %s", ssid);
 }
+
+/**
+ * @brief 清除 WiFi 配置并重启
+ */
+void wifi_prov_reset(void) {
+    nvs_handle_t nvs_handle;
+    if (nvs_open("storage", NVS_READWRITE, &nvs_handle) == ESP_OK) {
+        nvs_erase_key(nvs_handle, "wifi_ssid");
+        nvs_erase_key(nvs_handle, "wifi_password");
+        nvs_erase_key(nvs_handle, "api_token");
+        nvs_commit(nvs_handle);
+        nvs_close(nvs_handle);
+    }
+    ESP_LOGW(TAG, "WiFi配置已清除，重启进入配置模式");
+    esp_restart();
+}
+
+/**
+ * @brief 读取局域网接口令牌
+ */
+bool wifi_prov_get_api_token(char* out, size_t size) {
+    out[0] = '\0';
+    nvs_handle_t nvs_handle;
+    if (nvs_open("storage", NVS_READONLY, &nvs_handle) != ESP_OK) return false;
+    size_t len = size;
+    esp_err_t err = nvs_get_str(nvs_handle, "api_token", out, &len);
+    nvs_close(nvs_handle);
+    if (err != ESP_OK || !lan_auth_token_valid(out)) {
+        out[0] = '\0';
+        return false;
+    }
+    return true;
+}
@@ -1,6 +1,9 @@
 #ifndef WIFI_PROVISION_H
 #define WIFI_PROVISION_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 /**
  * @brief 启动 Wi-Fi 配置模式（SoftAP + Web 表单）
  *        设备将创建开放热点并启动 HTTP 服务器，
@@ -15,4 +18,17 @@ void wifi_prov_start(void);
  */
 void wifi_prov_connect_from_nvs(void);
 
+/**
+ * @brief 读取配网时设置的局域网接口令牌（与 WiFi 凭据同存于 NVS）
+ * @param out  输出缓冲，未设置或格式无效时置为空串
+ * @param size 缓冲大小，至少 LAN_AUTH_TOKEN_MAX + 1
+ * @return 已设置有效令牌
+ */
+bool wifi_prov_get_api_token(char* out, size_t size);
+
+/**
+ * @brief 清除 NVS 中的 WiFi 配置和接口令牌并重启，重启后进入配置模式
+ */
+void wifi_prov_reset(void);
+
 #endif // WIFI_PROVISION_H
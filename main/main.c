@@ -8,15 +8,41 @@
 // 使用优化版的组件
 #include "temp_sensor.h"     // 使用DS18B20库版本
 #include "fan_control.h"
+#include "fan_calibration.h" // 风扇占空比线性化校准
 #include "user_input.h"      // 使用编码器和按钮库版本
 #include "oled_display.h"    // 使用SSD1306库版本
+#include "ui_menu.h"         // 编码器设置菜单
 #include "mqtt_comm.h"       // 使用cJSON版本
 #include "wifi_provision.h"  // 自定义WiFi配网模块
+#include "power_mgmt.h"      // DFS/浅睡眠/电源锁
+#include "lan_api.h"         // 局域网 HTTP/WebSocket 接口
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "metrics.h"         // Prometheus 指标注册表
+#include "temp_estimator.h"  // 卡尔曼温度估计
+#include "sensor_fault.h"    // 传感器故障分类与降级
+#include "cooling_supervisor.h" // 风扇/制冷片联锁与效率分配
+#include "energy_meter.h"    // 风扇/制冷片电能计量
+#include "pi_controller.h"   // PI 温控
+#include "relay_autotune.h"  // 继电反馈自整定
+#include "adaptive_period.h" // 按热动态调整控制周期
+#include "history.h"         // 运行历史与降采样查询
+#include "freertos/semphr.h"
+#include "latency.h"         // 分阶段延迟剖析（可编译关闭）
+#include "trace.h"           // 事件追踪环形缓冲（可编译关闭）
+#include "deadline_monitor.h" // 控制周期截止时间监视
+#include "heap_guard.h"      // 稳态堆分配检查与碎片统计
+#include "ota_update.h"      // 流式 OTA 与回滚
+#include "esp_app_desc.h"
 
 static const char *TAG = "MAIN";
 
 // GPIO定义
 #define DS18B20_GPIO       GPIO_NUM_4
+#define HOT_SIDE_GPIO      GPIO_NUM_5    // 制冷片热端 DS18B20（独立总线）
 #define ENCODER_A_GPIO     GPIO_NUM_15
 #define ENCODER_B_GPIO     GPIO_NUM_2
 #define ENCODER_BTN_GPIO   GPIO_NUM_0
@@ -24,16 +50,87 @@ static const char *TAG = "MAIN";
 #define COOLER_PWM_CHANNEL LEDC_CHANNEL_0
 #define FAN_PWM_GPIO       GPIO_NUM_19   // 新增风扇PWM
 #define FAN_PWM_CHANNEL    LEDC_CHANNEL_1
+#define FAN_TACH_GPIO      GPIO_NUM_23   // 风扇测速线（开漏，需上拉）
 #define I2C_SDA_GPIO       GPIO_NUM_21
 #define I2C_SCL_GPIO       GPIO_NUM_22
 #define LEDC_CHANNEL       LEDC_CHANNEL_0
 
+// 自适应控制周期：温度变化快或明显高于设定值时缩短到下限，稳定后逐步拉长到上限
+#define CONTROL_PERIOD_MIN_MS   1000
+#define CONTROL_PERIOD_MAX_MS   20000
+#define ADAPT_STEP_C            0.1f    // 每个周期允许的温度变化
+#define ADAPT_ERROR_BAND_C      0.5f    // 高于设定值的误差死区
+#define ADAPT_ERROR_FULL_C      3.0f    // 高于设定值达到此值时取下限
+// 派生节拍：遥测为控制周期的 12 倍（5 秒周期对应 60 秒），状态/显示刷新不快于 2 秒
+#define TELEMETRY_PERIOD_MIN_MS 15000
+#define TELEMETRY_PERIOD_MAX_MS 120000
+#define DISPLAY_PERIOD_MIN_MS   2000
+// 累计电能写入 NVS 的间隔
+#define ENERGY_SAVE_PERIOD_S    900
+// 自整定期间缩短控制周期，减小继电切换的附加滞后
+#define AUTOTUNE_PERIOD_MS      1000
+#define FAN_CAL_PERIOD_MS       1000    // 风扇校准按固定周期读取测速计数
+// 随遥测一起发布指标快照到诊断主题（0 关闭）
+#define DIAG_MQTT_ENABLE        1
+// 传感器采样周期：取控制周期的一半，下限受每次约750ms的转换时间限制
+#define SENSOR_PERIOD_MIN_MS    1000
+#define SENSOR_PERIOD_MAX_MS    5000
+// 历史查询响应缓冲（200 点 × 最长约 27 字节）
+#define HISTORY_JSON_MAX        6144
+// 估计器参数：测量噪声（含0.0625°C量化）和加速度噪声
+#define EST_MEAS_SIGMA          0.1f
+#define EST_ACCEL_SIGMA         0.002f
+
+// 任务布局：控制和传感器任务固定在 APP_CPU 高优先级运行，不与 WiFi/LwIP/MQTT/HTTP 竞争；
+// OLED 刷新和各类上报由 PRO_CPU 上的上报任务完成，控制周期内不做 I2C 和网络操作。
+// 栈静态分配（字节）：按遥测 stack 段中的峰值用量（栈大小减 uxTaskGetStackHighWaterMark）加
+// STACK_MARGIN_BYTES 余量确定，余量不足时发布遥测时告警。上报任务的最深路径是遥测格式化和 MQTT 发布，
+// broker 回切探测的 TLS 握手在 mqtt_comm 的一次性探测任务中进行，不占用上报任务的栈
+#define CONTROL_TASK_CORE       1
+#define CONTROL_TASK_PRIO       20
+#define CONTROL_TASK_STACK      4096
+#define SENSOR_TASK_CORE        1
+#define SENSOR_TASK_PRIO        19
+#define SENSOR_TASK_STACK       3072
+#define REPORT_TASK_CORE        0
+#define REPORT_TASK_PRIO        5
+#define REPORT_TASK_STACK       4096
+#define STACK_MARGIN_BYTES      1024
+
+// 上报任务通知位
+#define REPORT_STATE            (1u << 0)   // OLED、状态/影子、局域网推送
+#define REPORT_TELEMETRY        (1u << 1)   // 遥测、延迟摘要和指标快照
+#define REPORT_LATENCY          (1u << 2)   // 按需延迟摘要
+#define REPORT_AUTOTUNE         (1u << 3)   // 自整定进度
+#define REPORT_TRACE            (1u << 4)   // 事件追踪导出到 MQTT
+#define REPORT_TRACE_LOG        (1u << 5)   // 事件追踪导出到串口
+#define REPORT_FAN_CAL          (1u << 6)   // 风扇校准进度
+#define REPORT_MENU             (1u << 7)   // 设置菜单重绘
+#define REPORT_SENSOR           (1u << 8)   // 温度传感器故障状态变化
+
+// 设置菜单：双击打开，无操作超过此时长自动退出
+#define MENU_TIMEOUT_MS         30000
+
+// 截止时间监视：控制任务每周期结束时登记，esp_timer（PRO_CPU）每秒检查
+#define DEADLINE_GRACE_MS       500
+#define DEADLINE_SAFE_AFTER     2       // 连续错过 2 个周期进入安全状态
+#define DEADLINE_CHECK_MS       1000
+
+// 稳态分配检查：控制任务完成若干周期（日志、newlib 等首次使用的缓冲已分配）后建立基线，
+// 此后控制和传感器任务的任何堆分配都计为失败
+#define HEAP_GUARD_WARMUP_CYCLES 3
+
+// OTA 健康确认：新镜像完成这么多个控制周期、未进入安全状态且 MQTT 已连接
+#define OTA_HEALTH_CYCLES       12
+
 // 系统状态
 typedef struct {
     bool auto_mode;
     uint8_t manual_speed;
     float temp_threshold;
     uint8_t max_speed;
+    float fan_off_temp;         // 分段温控：不高于此温度时风扇停转
+    uint8_t mid_speed;          // 分段温控：停转温度到阈值之间的转速
     esp_mqtt_client_handle_t mqtt_client;
 } system_state_t;
 
@@ -41,113 +138,1793 @@ static system_state_t g_system = {
     .auto_mode = true,
     .manual_speed = 0,
     .temp_threshold = 30.0f,
-    .max_speed = 100,    .mqtt_client = NULL
+    .max_speed = 100,
+    .fan_off_temp = 25.0f,
+    .mid_speed = 50,
+    .mqtt_client = NULL
 };
 
+// 设置菜单：输入任务处理按键并修改状态，上报任务渲染，两者通过 s_menu_mux 同步
+enum {
+    MENU_THRESHOLD,
+    MENU_MAX_SPEED,
+    MENU_FAN_OFF,
+    MENU_MID_SPEED,
+    MENU_MODE,
+    MENU_WIFI_RESET,
+    MENU_BACK,
+    MENU_ITEM_COUNT
+};
+static const char* const s_mode_choices[] = { "Auto", "Manual" };
+static ui_item_t s_menu_items[MENU_ITEM_COUNT] = {
+    [MENU_THRESHOLD]  = { .label = "Threshold", .type = UI_ITEM_VALUE, .min = 20, .max = 45, .step = 0.5f,
+                          .decimals = 1, .unit = "C" },
+    [MENU_MAX_SPEED]  = { .label = "Max speed", .type = UI_ITEM_VALUE, .min = 10, .max = 100, .step = 5, .unit = "%" },
+    [MENU_FAN_OFF]    = { .label = "Fan off <", .type = UI_ITEM_VALUE, .min = 10, .max = 40, .step = 0.5f,
+                          .decimals = 1, .unit = "C" },
+    [MENU_MID_SPEED]  = { .label = "Mid speed", .type = UI_ITEM_VALUE, .min = 0, .max = 100, .step = 5, .unit = "%" },
+    [MENU_MODE]       = { .label = "Mode", .type = UI_ITEM_CHOICE, .choices = s_mode_choices, .choice_count = 2 },
+    [MENU_WIFI_RESET] = { .label = "WiFi reset", .type = UI_ITEM_CONFIRM },
+    [MENU_BACK]       = { .label = "Back", .type = UI_ITEM_BACK },
+};
+static ui_menu_t s_menu;
+static int64_t s_menu_input_us = 0;
+static portMUX_TYPE s_menu_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t s_control_task = NULL;
+static TaskHandle_t s_sensor_task = NULL;
+static TaskHandle_t s_report_task = NULL;
+
+static StaticTask_t s_control_tcb;
+static StackType_t s_control_stack[CONTROL_TASK_STACK];
+static StaticTask_t s_sensor_tcb;
+static StackType_t s_sensor_stack[SENSOR_TASK_STACK];
+static StaticTask_t s_report_tcb;
+static StackType_t s_report_stack[REPORT_TASK_STACK];
+
+// 温度估计器，由传感器任务更新，控制任务和回调读取
+static temp_estimator_t s_estimator;
+static int64_t s_estimate_time_us = 0;
+// 传感器故障分类与估计器同一把锁保护
+static sensor_fault_t s_sensor_fault;
+static portMUX_TYPE s_estimator_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// 风扇/制冷片监督器，由控制任务推进，回调只读取联锁结果
+static cooling_supervisor_t s_supervisor;
+// 电能计量使用监督器的功率模型，同一把锁保护
+static energy_meter_t s_energy;
+static portMUX_TYPE s_supervisor_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// 功率模型校准和预算，保存在 NVS storage/power_cfg
+typedef struct {
+    float fan_w;
+    float fan_exp;
+    float tec_w;
+    float tec_exp;
+    float budget_w;
+} power_cfg_t;
+
+// 温控设置（本地菜单与 MQTT/局域网配置共用），保存在 NVS storage/control_cfg；
+// 设备影子的期望状态在连接后照常覆盖阈值和最大速度
+typedef struct {
+    float temp_threshold;
+    float fan_off_temp;
+    uint8_t max_speed;
+    uint8_t mid_speed;
+} control_cfg_t;
+
+// 传感器故障降级设置，保存在 NVS storage/sensor_cfg
+typedef struct {
+    uint32_t holdover_ms;
+    uint8_t failsafe_fan;
+} sensor_cfg_t;
+
+// 累计电能，保存在 NVS storage/energy；定期和重启前写入，断电最多丢失一个保存间隔
+typedef struct {
+    uint64_t fan_mj;
+    uint64_t tec_mj;
+} energy_record_t;
+
+// 自整定和 PI 控制器只在控制任务中访问；其他上下文通过请求标志交给控制任务处理
+typedef enum {
+    TUNE_REQ_NONE,
+    TUNE_REQ_START,
+    TUNE_REQ_ABORT,
+    TUNE_REQ_CLEAR,
+} tune_request_t;
+
+// NVS 中保存的整定结果
+typedef struct {
+    float kp;
+    float ki;
+    float ku;
+    float tu_s;
+} pi_gains_t;
+
+// 运行历史：传感器任务每秒写入，MQTT 任务查询
+static history_t s_history;
+static SemaphoreHandle_t s_history_lock = NULL;
+
+static volatile tune_request_t s_tune_request = TUNE_REQ_NONE;
+static volatile bool s_tune_active = false;
+static relay_autotune_t s_tune;
+static pi_controller_t s_pi;
+static bool s_pi_valid = false;   // 未整定时沿用分段温控
+
+// 风扇校准只在控制任务中推进；其他上下文通过请求标志交给控制任务处理
+static volatile mqtt_fan_cal_action_t s_fan_cal_request;
+static volatile bool s_fan_cal_requested = false;
+static volatile bool s_fan_cal_active = false;
+static fan_cal_t s_fan_cal;
+static char s_fan_cal_status[22];
+static portMUX_TYPE s_fan_cal_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// 自整定进度快照：控制任务写入，上报任务发布
+static mqtt_autotune_report_t s_tune_report;
+static char s_tune_status[22];
+static portMUX_TYPE s_tune_report_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// 传感器故障上报（传感器任务生成，上报任务发布）
+static mqtt_sensor_report_t s_sensor_report;
+static char s_sensor_status[22];
+static portMUX_TYPE s_sensor_report_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static volatile uint32_t s_control_cycles = 0;
+// 自适应节拍，由控制任务更新；传感器任务和遥测只读
+static adaptive_period_t s_period;
+static volatile uint32_t s_sensor_period_ms = SENSOR_PERIOD_MIN_MS;
+static volatile uint32_t s_telemetry_period_ms = TELEMETRY_PERIOD_MIN_MS;
+
+static deadline_monitor_t s_deadline;
+static portMUX_TYPE s_deadline_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static int32_t read_heap_free(void) {
+    return (int32_t)esp_get_free_heap_size();
+}
+
+static int32_t read_heap_min(void) {
+    return (int32_t)esp_get_minimum_free_heap_size();
+}
+
+static int32_t read_heap_largest(void) {
+    heap_guard_stats_t stats;
+    heap_guard_get_stats(&stats);
+    return (int32_t)stats.largest_block;
+}
+
+static int32_t read_steady_allocs(void) {
+    return (int32_t)heap_guard_total(NULL);
+}
+
+static int32_t read_control_stack_hwm(void) {
+    return s_control_task ? (int32_t)uxTaskGetStackHighWaterMark(s_control_task) : 0;
+}
+
+static int32_t read_sensor_stack_hwm(void) {
+    return s_sensor_task ? (int32_t)uxTaskGetStackHighWaterMark(s_sensor_task) : 0;
+}
+
+static int32_t read_report_stack_hwm(void) {
+    return s_report_task ? (int32_t)uxTaskGetStackHighWaterMark(s_report_task) : 0;
+}
+
+static METRIC_GAUGE_FN_DEFINE(m_heap_free, "fan_heap_free_bytes", "Current free heap", read_heap_free);
+static METRIC_GAUGE_FN_DEFINE(m_heap_min, "fan_heap_min_free_bytes", "Minimum free heap since boot", read_heap_min);
+static METRIC_GAUGE_FN_DEFINE(m_heap_largest, "fan_heap_largest_free_block_bytes",
+                              "Largest contiguous free block in internal DRAM", read_heap_largest);
+static METRIC_GAUGE_FN_DEFINE(m_steady_allocs, "fan_steady_state_allocs",
+                              "Heap allocations by control/sensor tasks after the steady-state baseline",
+                              read_steady_allocs);
+static METRIC_GAUGE_FN_DEFINE(m_control_hwm, "fan_control_task_stack_hwm_bytes",
+                              "Unused stack of auto_control_task at its high-water mark", read_control_stack_hwm);
+static METRIC_GAUGE_FN_DEFINE(m_sensor_hwm, "fan_sensor_task_stack_hwm_bytes",
+                              "Unused stack of sensor_task at its high-water mark", read_sensor_stack_hwm);
+static METRIC_GAUGE_FN_DEFINE(m_report_hwm, "fan_report_task_stack_hwm_bytes",
+                              "Unused stack of report_task at its high-water mark", read_report_stack_hwm);
+static METRIC_COUNTER_DEFINE(m_deadline_misses, "fan_control_deadline_misses_total",
+                             "Control periods not completed within period plus grace");
+static METRIC_COUNTER_DEFINE(m_sensor_faults, "fan_sensor_faults_total",
+                             "Confirmed temperature sensor faults");
+static METRIC_COUNTER_DEFINE(m_sensor_failsafe, "fan_sensor_failsafe_total",
+                             "Sensor holdover expiries that forced the fail-safe fan duty");
+static METRIC_HISTOGRAM_DEFINE(m_loop_us, "fan_control_loop_duration_us", "Control loop work time per cycle",
+                               1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000);
+
+// 分阶段延迟：控制周期各阶段、上报任务、传感器任务和各回调
+LATENCY_STAGE(s_lat_wake, "control_wake_late");
+LATENCY_STAGE(s_lat_law, "control_law");
+LATENCY_STAGE(s_lat_pwm, "control_pwm");
+LATENCY_STAGE(s_lat_oled, "report_oled");
+LATENCY_STAGE(s_lat_menu, "menu_input_to_frame");
+LATENCY_STAGE(s_lat_report, "report_state");
+LATENCY_STAGE(s_lat_telemetry, "report_telemetry");
+LATENCY_STAGE(s_lat_sensor, "sensor_convert");
+LATENCY_STAGE(s_lat_estimator, "sensor_estimator");
+LATENCY_STAGE(s_lat_history, "sensor_history");
+LATENCY_STAGE(s_lat_cb_mode, "cb_mode_change");
+LATENCY_STAGE(s_lat_cb_speed, "cb_speed_change");
+LATENCY_STAGE(s_lat_cb_encoder, "cb_encoder_change");
+LATENCY_STAGE(s_lat_cb_command, "cb_mqtt_command");
+LATENCY_STAGE(s_lat_cb_config, "cb_mqtt_config");
+LATENCY_STAGE(s_lat_cb_history, "cb_history_request");
+
+TRACE_NAME(t_control, "control_cycle");
+TRACE_NAME(t_fan_duty, "fan_duty");
+TRACE_NAME(t_tec_duty, "tec_duty");
+TRACE_NAME(t_deadline_miss, "deadline_miss");
+TRACE_NAME(t_safe_state, "safe_state");
+TRACE_NAME(t_report, "report");
+
 uint8_t manual_cooler_power = 0; // 手动模式下制冷片功率（全局变量，供其他模块访问）
 
 /**
  * @brief 温度映射到风扇转速 - 可配置版本
  */
 static uint8_t map_temp_to_speed(float temp) {
-    if (temp <= 25.0) return 0;
-    if (temp <= g_system.temp_threshold) return 50;
+    if (temp <= g_system.fan_off_temp) return 0;
+    if (temp <= g_system.temp_threshold) return g_system.mid_speed;
     return g_system.max_speed;
 }
 
+/**
+ * @brief 从 NVS 加载整定结果，存在时启用 PI 控制
+ */
+static void load_pi_gains(void) {
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READONLY, &nvs) != ESP_OK) return;
+    pi_gains_t gains;
+    size_t len = sizeof(gains);
+    if (nvs_get_blob(nvs, "pi_gains", &gains, &len) == ESP_OK && len == sizeof(gains) &&
+        gains.kp > 0.0f && gains.ki > 0.0f) {
+        pi_controller_init(&s_pi, gains.kp, gains.ki);
+        s_pi_valid = true;
+        ESP_LOGI(TAG, "PI 增益: Kp=%.2f Ki=%.4f (Ku=%.2f Tu=%.0fs)", gains.kp, gains.ki, gains.ku, gains.tu_s);
+    }
+    nvs_close(nvs);
+}
+
+static void save_pi_gains(const pi_gains_t* gains) {
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READWRITE, &nvs) != ESP_OK) return;
+    esp_err_t err = gains ? nvs_set_blob(nvs, "pi_gains", gains, sizeof(*gains))
+                          : nvs_erase_key(nvs, "pi_gains");
+    if (err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND) {
+        nvs_commit(nvs);
+    } else {
+        ESP_LOGE(TAG, "保存 PI 增益失败: %s", esp_err_to_name(err));
+    }
+    nvs_close(nvs);
+}
+
+/**
+ * @brief NVS 中的功率模型与 MQTT 配置接受同样的范围，损坏的记录整条忽略
+ */
+static bool power_cfg_valid(const power_cfg_t* cfg) {
+    return isfinite(cfg->fan_w) && cfg->fan_w > 0.0f &&
+           isfinite(cfg->tec_w) && cfg->tec_w > 0.0f &&
+           isfinite(cfg->fan_exp) && cfg->fan_exp >= 0.5f && cfg->fan_exp <= 4.0f &&
+           isfinite(cfg->tec_exp) && cfg->tec_exp >= 0.5f && cfg->tec_exp <= 4.0f &&
+           isfinite(cfg->budget_w) && cfg->budget_w >= 0.0f;
+}
+
+/**
+ * @brief 从 NVS 加载功率模型校准和预算（在监督器初始化之后调用）
+ */
+static void load_power_cfg(void) {
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READONLY, &nvs) != ESP_OK) return;
+    power_cfg_t cfg;
+    size_t len = sizeof(cfg);
+    if (nvs_get_blob(nvs, "power_cfg", &cfg, &len) == ESP_OK && len == sizeof(cfg) &&
+        power_cfg_valid(&cfg)) {
+        s_supervisor.model.fan_power_max = cfg.fan_w;
+        s_supervisor.model.fan_power_exp = cfg.fan_exp;
+        s_supervisor.model.tec_power_max = cfg.tec_w;
+        s_supervisor.model.tec_power_exp = cfg.tec_exp;
+        cooling_supervisor_set_budget(&s_supervisor, cfg.budget_w);
+        ESP_LOGI(TAG, "功率模型: 风扇 %.1fW^%.1f 制冷片 %.1fW^%.1f 预算 %.1fW",
+                 cfg.fan_w, cfg.fan_exp, cfg.tec_w, cfg.tec_exp, cfg.budget_w);
+    }
+    nvs_close(nvs);
+}
+
+static void save_power_cfg(void) {
+    portENTER_CRITICAL(&s_supervisor_mux);
+    power_cfg_t cfg = {
+        .fan_w    = s_supervisor.model.fan_power_max,
+        .fan_exp  = s_supervisor.model.fan_power_exp,
+        .tec_w    = s_supervisor.model.tec_power_max,
+        .tec_exp  = s_supervisor.model.tec_power_exp,
+        .budget_w = s_supervisor.power_budget_w,
+    };
+    portEXIT_CRITICAL(&s_supervisor_mux);
+
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READWRITE, &nvs) != ESP_OK) return;
+    esp_err_t err = nvs_set_blob(nvs, "power_cfg", &cfg, sizeof(cfg));
+    if (err == ESP_OK) {
+        nvs_commit(nvs);
+    } else {
+        ESP_LOGE(TAG, "保存功率模型失败: %s", esp_err_to_name(err));
+    }
+    nvs_close(nvs);
+}
+
+/**
+ * @brief 停转温度须低于阈值，否则阈值以下的分段永远不会生效
+ */
+static bool control_cfg_valid(const control_cfg_t* cfg) {
+    return isfinite(cfg->temp_threshold) && isfinite(cfg->fan_off_temp) &&
+           cfg->fan_off_temp < cfg->temp_threshold && cfg->max_speed <= 100 && cfg->mid_speed <= 100;
+}
+
+/**
+ * @brief 从 NVS 加载温控设置，不存在或无效时沿用默认值
+ */
+static void load_control_cfg(void) {
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READONLY, &nvs) != ESP_OK) return;
+    control_cfg_t cfg;
+    size_t len = sizeof(cfg);
+    if (nvs_get_blob(nvs, "control_cfg", &cfg, &len) == ESP_OK && len == sizeof(cfg) &&
+        control_cfg_valid(&cfg)) {
+        g_system.temp_threshold = cfg.temp_threshold;
+        g_system.fan_off_temp = cfg.fan_off_temp;
+        g_system.max_speed = cfg.max_speed;
+        g_system.mid_speed = cfg.mid_speed;
+        ESP_LOGI(TAG, "温控设置: 阈值 %.1f°C 停转 %.1f°C 中间转速 %u%% 最大速度 %u%%",
+                 cfg.temp_threshold, cfg.fan_off_temp, cfg.mid_speed, cfg.max_speed);
+    }
+    nvs_close(nvs);
+}
+
+static void save_control_cfg(void) {
+    control_cfg_t cfg = {
+        .temp_threshold = g_system.temp_threshold,
+        .fan_off_temp   = g_system.fan_off_temp,
+        .max_speed      = g_system.max_speed,
+        .mid_speed      = g_system.mid_speed,
+    };
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READWRITE, &nvs) != ESP_OK) return;
+    esp_err_t err = nvs_set_blob(nvs, "control_cfg", &cfg, sizeof(cfg));
+    if (err == ESP_OK) {
+        nvs_commit(nvs);
+    } else {
+        ESP_LOGE(TAG, "保存温控设置失败: %s", esp_err_to_name(err));
+    }
+    nvs_close(nvs);
+}
+
+/**
+ * @brief 从 NVS 加载传感器故障降级设置（在 sensor_fault_init 之后调用），不存在时沿用默认值
+ */
+static void load_sensor_cfg(void) {
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READONLY, &nvs) != ESP_OK) return;
+    sensor_cfg_t cfg;
+    size_t len = sizeof(cfg);
+    if (nvs_get_blob(nvs, "sensor_cfg", &cfg, &len) == ESP_OK && len == sizeof(cfg)) {
+        sensor_fault_configure(&s_sensor_fault, cfg.holdover_ms, cfg.failsafe_fan);
+        ESP_LOGI(TAG, "传感器故障降级: 外推 %lus，失效安全风扇 %u%%",
+                 (unsigned long)(s_sensor_fault.holdover_ms / 1000), s_sensor_fault.failsafe_fan);
+    }
+    nvs_close(nvs);
+}
+
+static void save_sensor_cfg(void) {
+    portENTER_CRITICAL(&s_estimator_mux);
+    sensor_cfg_t cfg = {
+        .holdover_ms  = s_sensor_fault.holdover_ms,
+        .failsafe_fan = s_sensor_fault.failsafe_fan,
+    };
+    portEXIT_CRITICAL(&s_estimator_mux);
+
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READWRITE, &nvs) != ESP_OK) return;
+    esp_err_t err = nvs_set_blob(nvs, "sensor_cfg", &cfg, sizeof(cfg));
+    if (err == ESP_OK) {
+        nvs_commit(nvs);
+    } else {
+        ESP_LOGE(TAG, "保存传感器故障降级设置失败: %s", esp_err_to_name(err));
+    }
+    nvs_close(nvs);
+}
+
+/**
+ * @brief 从 NVS 加载风扇线性化表（在 fan_pwm_init 之后调用），不存在时沿用默认表
+ */
+static void load_fan_curve(void) {
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READONLY, &nvs) != ESP_OK) return;
+    fan_curve_t curve;
+    size_t len = sizeof(curve);
+    if (nvs_get_blob(nvs, "fan_curve", &curve, &len) == ESP_OK && len == sizeof(curve) &&
+        fan_pwm_set_curve(&curve)) {
+        ESP_LOGI(TAG, "风扇线性化表: 5%%→%u‰ 50%%→%u‰ 100%%→%u‰", curve.duty_pm[1],
+                 curve.duty_pm[FAN_CURVE_POINTS / 2], curve.duty_pm[FAN_CURVE_POINTS - 1]);
+    }
+    nvs_close(nvs);
+}
+
+static void save_fan_curve(const fan_curve_t* curve) {
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READWRITE, &nvs) != ESP_OK) return;
+    esp_err_t err = curve ? nvs_set_blob(nvs, "fan_curve", curve, sizeof(*curve))
+                          : nvs_erase_key(nvs, "fan_curve");
+    if (err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND) {
+        nvs_commit(nvs);
+    } else {
+        ESP_LOGE(TAG, "保存风扇线性化表失败: %s", esp_err_to_name(err));
+    }
+    nvs_close(nvs);
+}
+
+/**
+ * @brief 从 NVS 恢复累计电能并开始计量
+ */
+static void load_energy(void) {
+    energy_record_t rec = { 0, 0 };
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READONLY, &nvs) == ESP_OK) {
+        size_t len = sizeof(rec);
+        if (nvs_get_blob(nvs, "energy", &rec, &len) != ESP_OK || len != sizeof(rec)) {
+            rec = (energy_record_t){ 0, 0 };
+        }
+        nvs_close(nvs);
+    }
+    energy_meter_init(&s_energy, rec.fan_mj, rec.tec_mj, esp_timer_get_time());
+}
+
+/**
+ * @brief 积分到当前时刻并保存累计电能（上报任务、重启前的关机回调）
+ */
+static void save_energy(void) {
+    portENTER_CRITICAL(&s_supervisor_mux);
+    energy_meter_update(&s_energy, &s_supervisor.model, s_energy.duty, esp_timer_get_time());
+    energy_record_t rec = { s_energy.fan_mj, s_energy.tec_mj };
+    portEXIT_CRITICAL(&s_supervisor_mux);
+
+    nvs_handle_t nvs;
+    if (nvs_open("storage", NVS_READWRITE, &nvs) != ESP_OK) return;
+    if (nvs_set_blob(nvs, "energy", &rec, sizeof(rec)) == ESP_OK) {
+        nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+}
+
+/**
+ * @brief 输出 PWM 并计入电能（控制任务、回调和截止时间检查共用）
+ *        先提高风扇再开制冷片，关断时先关制冷片
+ */
+static void apply_outputs(cooling_output_t out) {
+    portENTER_CRITICAL(&s_supervisor_mux);
+    bool tec_first = out.tec < s_energy.duty.tec;
+    energy_meter_update(&s_energy, &s_supervisor.model, out, esp_timer_get_time());
+    portEXIT_CRITICAL(&s_supervisor_mux);
+
+    if (tec_first) {
+        cooler_pwm_set_power(out.tec);
+        fan_pwm_set_speed(out.fan);
+    } else {
+        fan_pwm_set_speed(out.fan);
+        cooler_pwm_set_power(out.tec);
+    }
+}
+
+/**
+ * @brief 校准扫描期间输出原始风扇占空比，制冷片保持关闭
+ *        电能按占空比近似气流计入，只影响约两分钟的计量精度
+ */
+static void apply_fan_cal_duty(uint16_t duty_pm) {
+    cooling_output_t out = { (uint8_t)((duty_pm + 5) / 10), 0 };
+    portENTER_CRITICAL(&s_supervisor_mux);
+    energy_meter_update(&s_energy, &s_supervisor.model, out, esp_timer_get_time());
+    portEXIT_CRITICAL(&s_supervisor_mux);
+
+    cooler_pwm_set_power(0);
+    fan_pwm_set_duty_raw(duty_pm);
+}
+
+/**
+ * @brief 控制律使用的温度：估计值外推到“当前时刻 + 一次转换时间”之后，
+ *        抵消估计的时效和 DS18B20 的转换延迟；传感器故障期间外推值限制在最后可信读数附近
+ * @return 预测温度，估计器未初始化时返回-127.0
+ */
+static float control_temperature(void) {
+    portENTER_CRITICAL(&s_estimator_mux);
+    float age_s = (esp_timer_get_time() - s_estimate_time_us) / 1e6f;
+    float temp = temp_estimator_predict(&s_estimator, age_s + TEMP_SENSOR_CONVERSION_MS / 1000.0f);
+    temp = sensor_fault_bound(&s_sensor_fault, temp);
+    portEXIT_CRITICAL(&s_estimator_mux);
+    return temp;
+}
+
+/**
+ * @brief 最近一次实际输出的风扇气流（含校准扫描）
+ */
+static uint8_t applied_fan_speed(void) {
+    portENTER_CRITICAL(&s_supervisor_mux);
+    uint8_t fan = s_energy.duty.fan;
+    portEXIT_CRITICAL(&s_supervisor_mux);
+    return fan;
+}
+
+/**
+ * @brief 请求上报任务执行 OLED 刷新或网络上报，调用方不阻塞
+ */
+static void request_report(uint32_t bits) {
+    if (s_report_task) {
+        xTaskNotify(s_report_task, bits, eSetBits);
+    }
+}
+
+/**
+ * @brief 上报状态：MQTT 发布、更新设备影子并推送给局域网 WebSocket 客户端
+ */
+static void report_state(float temp, uint8_t fan_speed, bool auto_mode) {
+    portENTER_CRITICAL(&s_supervisor_mux);
+    uint8_t cooler_power = s_energy.duty.tec;
+    portEXIT_CRITICAL(&s_supervisor_mux);
+    mqtt_comm_publish(g_system.mqtt_client, temp, fan_speed, auto_mode);
+
+    shadow_state_t shadow = {
+        .temp_centi     = (int16_t)lroundf(temp * 100),
+        .fan_speed      = fan_speed,
+        .cooler_power   = cooler_power,
+        .auto_mode      = auto_mode,
+        .threshold_deci = (int16_t)lroundf(g_system.temp_threshold * 10),
+        .max_speed      = g_system.max_speed,
+    };
+    mqtt_comm_update_shadow(g_system.mqtt_client, &shadow);
+
+    lan_state_t state = {
+        .temperature  = temp,
+        .fan_speed    = fan_speed,
+        .cooler_power = cooler_power,
+        .auto_mode    = auto_mode,
+    };
+    lan_api_update_state(&state);
+}
+
+/**
+ * @brief 同步当前配置到局域网接口
+ */
+static void sync_lan_config(void) {
+    mqtt_config_t cfg = {
+        .temp_threshold = g_system.temp_threshold,
+        .max_speed      = g_system.max_speed,
+        .has_temp_threshold = true,
+        .has_max_speed      = true,
+    };
+    lan_api_update_config(&cfg);
+}
+
 /**
  * @brief 模式切换回调
  */
 static void on_mode_change(bool auto_mode) {
+    LATENCY_START(t0);
     g_system.auto_mode = auto_mode;
+    user_input_set_mode(auto_mode);
     ESP_LOGI(TAG, "模式切换为: %s", auto_mode ? "自动" : "手动");
     // 切换模式时，OLED和MQTT立即刷新
-    float temp = temp_sensor_get_temperature();
-    uint8_t fan_speed = map_temp_to_speed(temp);
-    oled_display_update(temp, fan_speed, auto_mode);
-    mqtt_comm_publish(g_system.mqtt_client, temp, fan_speed, auto_mode);
+    request_report(REPORT_STATE);
+    LATENCY_STOP(s_lat_cb_mode, t0);
+}
+
+/**
+ * @brief 长按回调：开始自整定，进行中则取消
+ */
+static void on_long_press(void) {
+    s_tune_request = s_tune_active ? TUNE_REQ_ABORT : TUNE_REQ_START;
 }
 
 /**
  * @brief 速度调节回调
  */
 static void on_speed_change(uint8_t speed) {
+    LATENCY_START(t0);
     g_system.manual_speed = speed;
     ESP_LOGI(TAG, "手动速度设置为: %d%%", speed);
     
-    if (!g_system.auto_mode) {
-        fan_pwm_set_speed(speed);
+    if (!g_system.auto_mode && !s_fan_cal_active) {
+        // 制冷片运行或过温时不允许低于联锁下限
+        portENTER_CRITICAL(&s_supervisor_mux);
+        speed = cooling_supervisor_limit_fan(&s_supervisor, speed);
+        uint8_t tec = s_energy.duty.tec;
+        portEXIT_CRITICAL(&s_supervisor_mux);
+        apply_outputs((cooling_output_t){ speed, tec });
         // 更新显示
-        float temp = temp_sensor_get_temperature();
-        oled_display_update(temp, speed, false);
-        mqtt_comm_publish(g_system.mqtt_client, temp, speed, false);
+        request_report(REPORT_STATE);
     }
+    LATENCY_STOP(s_lat_cb_speed, t0);
 }
 
 static void on_encoder_change(uint8_t value) {
+    LATENCY_START(t0);
     if (!g_system.auto_mode) {
         manual_cooler_power = value;
         ESP_LOGI(TAG, "手动模式下制冷片功率设置为: %d%%", value);
-        float temp = temp_sensor_get_temperature();
-        uint8_t fan_speed = map_temp_to_speed(temp);
-        oled_display_update(temp, fan_speed, false);
-        mqtt_comm_publish(g_system.mqtt_client, temp, fan_speed, false);
+        request_report(REPORT_STATE);
     }
+    LATENCY_STOP(s_lat_cb_encoder, t0);
 }
 
 /**
- * @brief MQTT命令处理回调
+ * @brief MQTT命令处理回调（MQTT 与局域网接口共用），在 ack 中报告每个字段的执行结果
+ *        速度命令在回调内直接写输出，actuated_us 即写完的时刻；
+ *        自整定和风扇校准交给控制任务，只能报告“已接受”，明显不满足条件的当场拒绝
  */
-static void on_mqtt_command(const mqtt_command_t* cmd) {
+static void on_mqtt_command(const mqtt_command_t* cmd, mqtt_command_ack_t* ack) {
+    LATENCY_START(t0);
     ESP_LOGI(TAG, "收到MQTT命令");
+    bool recognized = false;
     
     if (cmd->has_mode) {
+        recognized = true;
         bool new_auto_mode = (cmd->mode == MQTT_MODE_AUTO);
         if (new_auto_mode != g_system.auto_mode) {
             on_mode_change(new_auto_mode);
         }
     }
     
-    if (cmd->has_speed && !g_system.auto_mode) {
-        if (cmd->speed <= 100) {
+    if (cmd->has_autotune) {
+        recognized = true;
+        switch (cmd->autotune) {
+        case MQTT_AUTOTUNE_START: {
+            portENTER_CRITICAL(&s_estimator_mux);
+            sensor_state_t sensor = s_sensor_fault.state;
+            portEXIT_CRITICAL(&s_estimator_mux);
+            if (s_fan_cal_active) {
+                mqtt_ack_set(ack, MQTT_ACK_REJECTED, "fan_cal_active");
+            } else if (sensor != SENSOR_STATE_OK) {
+                mqtt_ack_set(ack, MQTT_ACK_REJECTED, "sensor_fault");
+            } else if (!g_system.auto_mode) {
+                mqtt_ack_set(ack, MQTT_ACK_REJECTED, "manual_mode");
+            } else {
+                s_tune_request = TUNE_REQ_START;
+                mqtt_ack_set(ack, MQTT_ACK_ACCEPTED, NULL);
+            }
+            break;
+        }
+        case MQTT_AUTOTUNE_ABORT:
+            s_tune_request = TUNE_REQ_ABORT;
+            mqtt_ack_set(ack, MQTT_ACK_ACCEPTED, NULL);
+            break;
+        case MQTT_AUTOTUNE_CLEAR:
+            s_tune_request = TUNE_REQ_CLEAR;
+            mqtt_ack_set(ack, MQTT_ACK_ACCEPTED, NULL);
+            break;
+        }
+    }
+
+    if (cmd->has_fan_cal) {
+        recognized = true;
+        if (cmd->fan_cal == MQTT_FAN_CAL_START && s_tune_active) {
+            mqtt_ack_set(ack, MQTT_ACK_REJECTED, "autotune_active");
+        } else {
+            s_fan_cal_request = cmd->fan_cal;
+            s_fan_cal_requested = true;
+            mqtt_ack_set(ack, MQTT_ACK_ACCEPTED, NULL);
+        }
+    }
+
+    if (cmd->speed_invalid) {
+        recognized = true;
+        mqtt_ack_set(ack, MQTT_ACK_INVALID, "speed_range");
+    } else if (cmd->has_speed) {
+        recognized = true;
+        if (g_system.auto_mode) {
+            mqtt_ack_set(ack, MQTT_ACK_REJECTED, "auto_mode");
+        } else if (s_fan_cal_active) {
+            // 记为手动速度，校准结束后生效
             on_speed_change(cmd->speed);
+            mqtt_ack_set(ack, MQTT_ACK_ACCEPTED, "fan_cal_active");
+        } else {
+            on_speed_change(cmd->speed);
+            ack->actuated_us = esp_timer_get_time();
+            ack->fan_duty = applied_fan_speed();
+            // 联锁下限或功率预算改写了请求值
+            if (ack->fan_duty != cmd->speed) mqtt_ack_set(ack, MQTT_ACK_OK, "limited");
         }
     }
+
+    if (cmd->report_latency) {
+        recognized = true;
+        request_report(REPORT_LATENCY);
+    }
+    if (cmd->report_trace) {
+        recognized = true;
+        request_report(REPORT_TRACE);
+    }
+    if (cmd->report_trace_log) {
+        recognized = true;
+        request_report(REPORT_TRACE_LOG);
+    }
+    if (!recognized) {
+        mqtt_ack_set(ack, MQTT_ACK_INVALID, "empty");
+    }
+    LATENCY_STOP(s_lat_cb_command, t0);
 }
 
 /**
  * @brief MQTT配置处理回调
  */
 static void on_mqtt_config(const mqtt_config_t* cfg) {
+    LATENCY_START(t0);
     ESP_LOGI(TAG, "收到MQTT配置");
     
-    if (cfg->has_temp_threshold) {
-        g_system.temp_threshold = cfg->temp_threshold;
-        ESP_LOGI(TAG, "温度阈值设置为: %.1f°C", g_system.temp_threshold);
+    // 阈值与停转温度合并后检查先后关系，违反时这两项整体忽略
+    control_cfg_t next = {
+        .temp_threshold = cfg->has_temp_threshold ? cfg->temp_threshold : g_system.temp_threshold,
+        .fan_off_temp   = cfg->has_fan_off_temp ? cfg->fan_off_temp : g_system.fan_off_temp,
+        .max_speed      = cfg->has_max_speed ? cfg->max_speed : g_system.max_speed,
+        .mid_speed      = cfg->has_mid_speed ? cfg->mid_speed : g_system.mid_speed,
+    };
+    if (!control_cfg_valid(&next)) {
+        ESP_LOGW(TAG, "停转温度 %.1f°C 不低于阈值 %.1f°C，忽略", next.fan_off_temp, next.temp_threshold);
+        next.temp_threshold = g_system.temp_threshold;
+        next.fan_off_temp = g_system.fan_off_temp;
     }
-    
-    if (cfg->has_max_speed) {
-        g_system.max_speed = cfg->max_speed;
-        ESP_LOGI(TAG, "最大速度设置为: %d%%", g_system.max_speed);
+    bool control_changed = next.temp_threshold != g_system.temp_threshold ||
+                           next.fan_off_temp != g_system.fan_off_temp ||
+                           next.max_speed != g_system.max_speed || next.mid_speed != g_system.mid_speed;
+    if (control_changed) {
+        g_system.temp_threshold = next.temp_threshold;
+        g_system.fan_off_temp = next.fan_off_temp;
+        g_system.max_speed = next.max_speed;
+        g_system.mid_speed = next.mid_speed;
+        save_control_cfg();
+        ESP_LOGI(TAG, "温控设置: 阈值 %.1f°C 停转 %.1f°C 中间转速 %u%% 最大速度 %u%%",
+                 next.temp_threshold, next.fan_off_temp, next.mid_speed, next.max_speed);
+    }
+
+    bool power_changed = cfg->has_power_budget || cfg->has_fan_power_w || cfg->has_fan_power_exp ||
+                         cfg->has_tec_power_w || cfg->has_tec_power_exp;
+    if (power_changed) {
+        portENTER_CRITICAL(&s_supervisor_mux);
+        // 先按旧模型积分到当前时刻，新模型只影响之后的功率
+        energy_meter_update(&s_energy, &s_supervisor.model, s_energy.duty, esp_timer_get_time());
+        cooling_model_t* m = &s_supervisor.model;
+        if (cfg->has_fan_power_w) m->fan_power_max = cfg->fan_power_w;
+        if (cfg->has_fan_power_exp) m->fan_power_exp = cfg->fan_power_exp;
+        if (cfg->has_tec_power_w) m->tec_power_max = cfg->tec_power_w;
+        if (cfg->has_tec_power_exp) m->tec_power_exp = cfg->tec_power_exp;
+        if (cfg->has_power_budget) cooling_supervisor_set_budget(&s_supervisor, cfg->power_budget_w);
+        energy_meter_update(&s_energy, m, s_energy.duty, esp_timer_get_time());
+        portEXIT_CRITICAL(&s_supervisor_mux);
+        save_power_cfg();
+        ESP_LOGI(TAG, "功率预算 %.1fW，风扇 %.1fW^%.1f，制冷片 %.1fW^%.1f", s_supervisor.power_budget_w,
+                 s_supervisor.model.fan_power_max, s_supervisor.model.fan_power_exp,
+                 s_supervisor.model.tec_power_max, s_supervisor.model.tec_power_exp);
+    }
+    if (cfg->has_holdover_s || cfg->has_failsafe_fan) {
+        portENTER_CRITICAL(&s_estimator_mux);
+        uint32_t holdover_ms = cfg->has_holdover_s ? cfg->holdover_s * 1000 : s_sensor_fault.holdover_ms;
+        uint8_t failsafe_fan = cfg->has_failsafe_fan ? cfg->failsafe_fan : s_sensor_fault.failsafe_fan;
+        sensor_fault_configure(&s_sensor_fault, holdover_ms, failsafe_fan);
+        portEXIT_CRITICAL(&s_estimator_mux);
+        save_sensor_cfg();
+        ESP_LOGI(TAG, "传感器故障降级: 外推 %lus，失效安全风扇 %u%%",
+                 (unsigned long)(holdover_ms / 1000), failsafe_fan);
+    }
+    sync_lan_config();
+    // 立即反映到设备影子，配置变更无需等待下一个控制周期
+    request_report(REPORT_STATE);
+    LATENCY_STOP(s_lat_cb_config, t0);
+}
+
+/**
+ * @brief 菜单各项取当前设置（调用者持有 s_menu_mux）
+ */
+static void load_menu_values(void) {
+    s_menu_items[MENU_THRESHOLD].value = g_system.temp_threshold;
+    s_menu_items[MENU_MAX_SPEED].value = g_system.max_speed;
+    s_menu_items[MENU_FAN_OFF].value = g_system.fan_off_temp;
+    s_menu_items[MENU_MID_SPEED].value = g_system.mid_speed;
+    s_menu_items[MENU_MODE].value = g_system.auto_mode ? 0 : 1;
+}
+
+/**
+ * @brief 打开设置菜单，各项取当前设置
+ */
+static void open_menu(void) {
+    portENTER_CRITICAL(&s_menu_mux);
+    load_menu_values();
+    ui_menu_open(&s_menu);
+    s_menu_input_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&s_menu_mux);
+    request_report(REPORT_MENU);
+}
+
+/**
+ * @brief 菜单中确认的设置生效；温控设置走与 MQTT 配置相同的校验和保存路径
+ */
+static void apply_menu_item(int index, float value) {
+    switch (index) {
+    case MENU_THRESHOLD: {
+        mqtt_config_t cfg = { .temp_threshold = value, .has_temp_threshold = true };
+        on_mqtt_config(&cfg);
+        break;
+    }
+    case MENU_MAX_SPEED: {
+        mqtt_config_t cfg = { .max_speed = (uint8_t)value, .has_max_speed = true };
+        on_mqtt_config(&cfg);
+        break;
+    }
+    case MENU_FAN_OFF: {
+        mqtt_config_t cfg = { .fan_off_temp = value, .has_fan_off_temp = true };
+        on_mqtt_config(&cfg);
+        break;
+    }
+    case MENU_MID_SPEED: {
+        mqtt_config_t cfg = { .mid_speed = (uint8_t)value, .has_mid_speed = true };
+        on_mqtt_config(&cfg);
+        break;
+    }
+    case MENU_MODE: {
+        bool auto_mode = value == 0;
+        if (auto_mode != g_system.auto_mode) {
+            on_mode_change(auto_mode);
+        }
+        break;
+    }
+    case MENU_WIFI_RESET:
+        wifi_prov_reset();
+        break;
     }
 }
 
+/**
+ * @brief 输入事件回调（输入任务上下文）：双击打开菜单，菜单打开期间接管所有输入
+ * @return true 已由菜单处理
+ */
+static bool on_input_event(const user_input_event_t* event) {
+    portENTER_CRITICAL(&s_menu_mux);
+    bool open = s_menu.open;
+    portEXIT_CRITICAL(&s_menu_mux);
+    if (!open) {
+        if (event->type != USER_INPUT_DOUBLE_CLICK) return false;
+        open_menu();
+        return true;
+    }
+
+    ui_key_t key;
+    switch (event->type) {
+    case USER_INPUT_ROTATE:     key = UI_KEY_ROTATE; break;
+    case USER_INPUT_CLICK:      key = UI_KEY_CLICK; break;
+    case USER_INPUT_LONG_PRESS: key = UI_KEY_LONG; break;
+    default:                    return true;
+    }
+    portENTER_CRITICAL(&s_menu_mux);
+    ui_menu_result_t result = ui_menu_input(&s_menu, key, event->steps);
+    int focus = s_menu.focus;
+    float value = s_menu_items[focus].value;
+    s_menu_input_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&s_menu_mux);
+
+    if (result == UI_MENU_COMMIT) {
+        apply_menu_item(focus, value);
+        // 被校验拒绝的值（如停转温度不低于阈值）在菜单中恢复为实际设置
+        portENTER_CRITICAL(&s_menu_mux);
+        load_menu_values();
+        portEXIT_CRITICAL(&s_menu_mux);
+    }
+    if (result != UI_MENU_IGNORED) {
+        request_report(result == UI_MENU_CLOSED ? REPORT_STATE : REPORT_MENU);
+    }
+    return true;
+}
+
+/**
+ * @brief 菜单是否占用屏幕；无操作超时则关闭（上报任务上下文）
+ */
+static bool menu_showing(void) {
+    portENTER_CRITICAL(&s_menu_mux);
+    if (s_menu.open && esp_timer_get_time() - s_menu_input_us > (int64_t)MENU_TIMEOUT_MS * 1000) {
+        ui_menu_close(&s_menu);
+    }
+    bool open = s_menu.open;
+    portEXIT_CRITICAL(&s_menu_mux);
+    return open;
+}
+
+/**
+ * @brief 渲染菜单，只重绘与屏幕不同的字符（上报任务上下文）
+ */
+static void draw_menu(void) {
+    ui_item_t items[MENU_ITEM_COUNT];
+    portENTER_CRITICAL(&s_menu_mux);
+    ui_menu_t menu = s_menu;
+    memcpy(items, s_menu_items, sizeof(items));
+#if LATENCY_PROFILE_ENABLE
+    int64_t input_us = s_menu_input_us;
+#endif
+    portEXIT_CRITICAL(&s_menu_mux);
+    if (!menu.open) return;
+
+    menu.items = items;
+    oled_frame_t frame;
+    ui_menu_render(&menu, &frame);
+    oled_display_frame(&frame);
+#if LATENCY_PROFILE_ENABLE
+    // 从输入任务处理完按键到帧写完的时间
+    LATENCY_RECORD(s_lat_menu, (uint32_t)(esp_timer_get_time() - input_us));
+#endif
+}
+
+/**
+ * @brief 发布各阶段延迟摘要（上报任务上下文）
+ * @param reset 发布后清零，周期报告按窗口统计；按需报告不影响窗口
+ */
+static void publish_latency(bool reset) {
+    static char json[1536];
+    int len = latency_write_json(json, sizeof(json), reset);
+    if (len > 0) {
+        mqtt_comm_publish_latency(g_system.mqtt_client, json, len);
+    }
+}
+
+/**
+ * @brief 导出事件追踪：MQTT 未连接或按要求时输出到串口
+ *        导出缓冲按需分配，只在诊断请求时发生，不在稳态路径上
+ */
+static void publish_trace(bool to_mqtt) {
+    if (!to_mqtt || !mqtt_comm_is_connected()) {
+        trace_dump_to_log();
+        return;
+    }
+    size_t size = trace_dump_size();
+    uint8_t* buf = size ? malloc(size) : NULL;
+    if (!buf) return;
+    int len = trace_dump(buf, size);
+    if (len > 0) {
+        mqtt_comm_publish_trace(g_system.mqtt_client, buf, len);
+    }
+    free(buf);
+}
+
+/**
+ * @brief 发布遥测：芯片各电源模式时间和各电源锁持有时间
+ */
+static void publish_telemetry(void) {
+    pm_accounting_t pm;
+    power_mgmt_get_stats(&pm);
+    pm_mode_stats_t modes;
+    bool has_modes = power_mgmt_get_mode_stats(&modes);
+
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    portENTER_CRITICAL(&s_estimator_mux);
+    float rate = s_estimator.rate;
+    uint32_t rejected = s_estimator.rejected_total;
+    sensor_state_t sensor = s_sensor_fault.state;
+    sensor_fault_kind_t fault = s_sensor_fault.fault;
+    uint32_t fault_age_ms = sensor_fault_age_ms(&s_sensor_fault, now_ms);
+    uint32_t faults = 0;
+    for (int i = 0; i < SENSOR_FAULT_KIND_COUNT; i++) faults += s_sensor_fault.faults[i];
+    uint32_t failsafe_entries = s_sensor_fault.failsafe_entries;
+    portEXIT_CRITICAL(&s_estimator_mux);
+
+    portENTER_CRITICAL(&s_supervisor_mux);
+    cooling_output_t applied = s_energy.duty;
+    uint32_t trips = s_supervisor.overtemp_trips;
+    energy_meter_update(&s_energy, &s_supervisor.model, s_energy.duty, esp_timer_get_time());
+    energy_meter_t energy = s_energy;
+    float budget_w = s_supervisor.power_budget_w;
+    bool budget_limited = s_supervisor.budget_limited;
+    portEXIT_CRITICAL(&s_supervisor_mux);
+
+    heap_guard_stats_t heap;
+    heap_guard_get_stats(&heap);
+    size_t last_alloc = 0;
+    uint32_t steady_allocs = heap_guard_total(&last_alloc);
+    if (steady_allocs) {
+        ESP_LOGE(TAG, "稳态分配检查失败: 控制 %lu 次, 传感器 %lu 次, 最近一次 %u 字节",
+                 (unsigned long)heap_guard_allocs(s_control_task), (unsigned long)heap_guard_allocs(s_sensor_task),
+                 (unsigned)last_alloc);
+    }
+
+    // 栈峰值用量：高水位为历史最小剩余，余量不足说明栈大小需要按峰值用量重新确定
+    static const uint32_t stack_size[] = { CONTROL_TASK_STACK, SENSOR_TASK_STACK, REPORT_TASK_STACK };
+    static const char* const stack_task[] = { "控制", "传感器", "上报" };
+    const int32_t stack_free[] = { read_control_stack_hwm(), read_sensor_stack_hwm(), read_report_stack_hwm() };
+    uint32_t stack_used[3];
+    for (int i = 0; i < 3; i++) {
+        stack_used[i] = stack_size[i] - (uint32_t)stack_free[i];
+        if (stack_free[i] < STACK_MARGIN_BYTES) {
+            ESP_LOGW(TAG, "%s任务栈余量不足: 峰值 %lu / %lu 字节", stack_task[i],
+                     (unsigned long)stack_used[i], (unsigned long)stack_size[i]);
+        }
+    }
+
+    portENTER_CRITICAL(&s_deadline_mux);
+    uint32_t misses = s_deadline.misses;
+    int64_t last_miss_us = s_deadline.last_miss_us;
+    uint32_t safe_entries = s_deadline.safe_entries;
+    portEXIT_CRITICAL(&s_deadline_mux);
+
+    mqtt_telemetry_t tm = {
+        .uptime_s        = (uint32_t)(esp_timer_get_time() / 1000000),
+        .temp_rate_c_min = rate * 60.0f,
+        .temp_rejected   = rejected,
+        .has_hot_side    = temp_sensor_has_hot_side(),
+        .hot_side_c      = temp_sensor_get_hot_side_temperature(),
+        .fan_duty        = applied.fan,
+        .tec_duty        = applied.tec,
+        .overtemp_trips  = trips,
+        .deadline_misses = misses,
+        .deadline_last_miss_s = (uint32_t)(last_miss_us / 1000000),
+        .safe_state_entries   = safe_entries,
+        .sensor_state    = sensor_fault_state_name(sensor),
+        .sensor_fault    = sensor_fault_kind_name(fault),
+        .sensor_fault_s  = fault_age_ms / 1000,
+        .sensor_faults   = faults,
+        .sensor_failsafe_entries = failsafe_entries,
+        .heap_free       = heap.free_bytes,
+        .heap_largest_block = heap.largest_block,
+        .heap_frag_pct   = heap.frag_pct,
+        .steady_allocs   = steady_allocs,
+        .control_period_ms   = s_period.period_ms,
+        .sensor_period_ms    = s_sensor_period_ms,
+        .telemetry_period_ms = s_telemetry_period_ms,
+        .fan_power_w     = energy.fan_w,
+        .tec_power_w     = energy.tec_w,
+        .fan_energy_kwh  = energy_meter_kwh(energy.fan_mj),
+        .tec_energy_kwh  = energy_meter_kwh(energy.tec_mj),
+        .power_budget_w  = budget_w,
+        .budget_limited  = budget_limited,
+        .has_pm_modes    = has_modes,
+        .pm_sleep_us     = modes.mode_us[PM_CHIP_SLEEP],
+        .pm_apb_min_us   = modes.mode_us[PM_CHIP_APB_MIN],
+        .pm_apb_max_us   = modes.mode_us[PM_CHIP_APB_MAX],
+        .pm_cpu_max_us   = modes.mode_us[PM_CHIP_CPU_MAX],
+        .pm_light_sleeps = modes.light_sleeps,
+        .pm_sleep_rejects = modes.sleep_rejects,
+        .has_stack       = true,
+        .control_stack_used = stack_used[0],
+        .sensor_stack_used  = stack_used[1],
+        .report_stack_used  = stack_used[2],
+        .pm_i2c_us       = pm.held_us[PM_LOCK_I2C],
+        .pm_onewire_us   = pm.held_us[PM_LOCK_ONEWIRE],
+        .pm_ledc_us      = pm.held_us[PM_LOCK_LEDC],
+    };
+    mqtt_comm_publish_telemetry(g_system.mqtt_client, &tm);
+
+    publish_latency(true);
+
+#if DIAG_MQTT_ENABLE
+    static char diag[768];
+    int len = metrics_write_json(diag, sizeof(diag));
+    if (len > 0) {
+        mqtt_comm_publish_diagnostics(g_system.mqtt_client, diag, len);
+    }
+#endif
+}
+
+/**
+ * @brief 历史查询回调（MQTT 任务上下文）
+ */
+static void on_history_request(const mqtt_history_request_t* req) {
+    static history_point_t points[HISTORY_MAX_POINTS];
+    static char json[HISTORY_JSON_MAX];
+
+    history_field_t field;
+    if (!history_field_from_name(req->field, &field)) {
+        ESP_LOGW(TAG, "未知的历史字段: %s", req->field);
+        return;
+    }
+    LATENCY_START(t0);
+    // 静态缓冲只由 MQTT 任务使用；发布放在锁外，避免网络阻塞传感器任务
+    xSemaphoreTake(s_history_lock, portMAX_DELAY);
+    uint32_t resolution_s;
+    size_t count = history_query(&s_history, req->from_s, req->to_s, field, req->max_points,
+                                 points, &resolution_s);
+    uint32_t now_s = s_history.raw_last_s;
+    xSemaphoreGive(s_history_lock);
+
+    int len = history_format_json(req->id, field, now_s, resolution_s, points, count, json, sizeof(json));
+    if (len > 0) {
+        mqtt_comm_publish_history(g_system.mqtt_client, json, len);
+    }
+    LATENCY_STOP(s_lat_cb_history, t0);
+}
+
+/**
+ * @brief 写入一条历史样本：估计温度和监督器实际输出
+ *        随传感器周期（1～5 秒）调用，history_insert 把中间跳过的秒按本样本之前的值保持
+ */
+static void record_history(int64_t now_us) {
+    portENTER_CRITICAL(&s_estimator_mux);
+    bool valid = s_estimator.initialized && s_sensor_fault.state == SENSOR_STATE_OK;
+    float temp = s_estimator.temp;
+    portEXIT_CRITICAL(&s_estimator_mux);
+
+    portENTER_CRITICAL(&s_supervisor_mux);
+    cooling_output_t applied = s_energy.duty;
+    portEXIT_CRITICAL(&s_supervisor_mux);
+
+    history_sample_t sample = {
+        .temp_centi = valid ? (int16_t)lroundf(temp * 100) : HISTORY_INVALID,
+        .fan = applied.fan,
+        .tec = applied.tec,
+    };
+    xSemaphoreTake(s_history_lock, portMAX_DELAY);
+    history_insert(&s_history, (uint32_t)(now_us / 1000000), sample);
+    xSemaphoreGive(s_history_lock);
+}
+
+/**
+ * @brief 传感器故障状态变化：记录日志和指标，生成上报快照交给上报任务发布到 MQTT 和 OLED 状态行
+ */
+static void report_sensor_fault(const sensor_fault_t* sf, sensor_state_t before, uint32_t now_ms) {
+    const char* fault = sensor_fault_kind_name(sf->fault);
+    mqtt_sensor_report_t report = {
+        .state         = sensor_fault_state_name(sf->state),
+        .fault         = fault,
+        .fault_s       = (now_ms - sf->fault_ms) / 1000,
+        .has_last_good = sf->have_good,
+        .last_good_c   = sf->last_good_c,
+        .holdover_s    = sf->holdover_ms / 1000,
+        .failsafe_fan  = sf->failsafe_fan,
+    };
+    // OLED 状态行 21 个字符
+    static const char* const short_names[SENSOR_FAULT_KIND_COUNT] = { "ok", "lost", "CRC", "stuck", "bad" };
+    char status[sizeof(s_sensor_status)];
+    switch (sf->state) {
+    case SENSOR_STATE_HOLDOVER:
+        if (before == SENSOR_STATE_OK) {
+            metrics_inc(&m_sensor_faults);
+            ESP_LOGE(TAG, "温度传感器故障: %s，按最后可信值 %.2f°C 外推 %lus", fault, sf->last_good_c,
+                     (unsigned long)report.holdover_s);
+        }
+        snprintf(status, sizeof(status), "Sensor %s hold", short_names[sf->fault]);
+        break;
+    case SENSOR_STATE_FAILSAFE:
+        if (before == SENSOR_STATE_OK) metrics_inc(&m_sensor_faults);
+        if (before != SENSOR_STATE_FAILSAFE) {
+            metrics_inc(&m_sensor_failsafe);
+            ESP_LOGE(TAG, "温度传感器故障: %s，进入失效安全：风扇 %u%%，制冷片关闭", fault, sf->failsafe_fan);
+        }
+        snprintf(status, sizeof(status), "Sensor %s fan %u%%", short_names[sf->fault], sf->failsafe_fan);
+        break;
+    default:
+        ESP_LOGI(TAG, "温度传感器恢复（%s 持续 %lus）", fault, (unsigned long)report.fault_s);
+        status[0] = '\0';
+        break;
+    }
+    portENTER_CRITICAL(&s_sensor_report_mux);
+    s_sensor_report = report;
+    memcpy(s_sensor_status, status, sizeof(s_sensor_status));
+    portEXIT_CRITICAL(&s_sensor_report_mux);
+    request_report(REPORT_SENSOR);
+}
+
+static sensor_read_t sensor_read_status(temp_sensor_status_t status) {
+    switch (status) {
+    case TEMP_SENSOR_NO_DEVICE: return SENSOR_READ_NO_DEVICE;
+    case TEMP_SENSOR_CRC_ERROR: return SENSOR_READ_CRC_ERROR;
+    default:                    return SENSOR_READ_OK;
+    }
+}
+
+/**
+ * @brief 传感器任务：连续转换，经故障分类后送入卡尔曼估计器
+ *        不可信读数（掉线/CRC/卡滞/跳变）不进入估计器；可信读数中的离群点由估计器剔除，均不推进估计时间
+ */
+static void sensor_task(void *arg) {
+    TickType_t last_wake_time = xTaskGetTickCount();
+    while (1) {
+        // 冷端和热端同时转换，热端读数由控制任务交给监督器
+        LATENCY_START(t_sensor);
+        float raw = temp_sensor_update();
+        sensor_read_t read = sensor_read_status(temp_sensor_get_status());
+        LATENCY_STOP(s_lat_sensor, t_sensor);
+        int64_t now = esp_timer_get_time();
+        uint32_t now_ms = (uint32_t)(now / 1000);
+
+        // 卡滞判断的输出激励：风扇与制冷片占空比之和
+        portENTER_CRITICAL(&s_supervisor_mux);
+        unsigned drive = s_energy.duty.fan + s_energy.duty.tec;
+        portEXIT_CRITICAL(&s_supervisor_mux);
+        if (drive > UINT8_MAX) drive = UINT8_MAX;
+
+        portENTER_CRITICAL(&s_estimator_mux);
+        sensor_state_t before = s_sensor_fault.state;
+        bool trusted = sensor_fault_update(&s_sensor_fault, read, raw, (uint8_t)drive, now_ms);
+        temp_est_result_t result = TEMP_EST_REJECTED_INVALID;
+        if (trusted) {
+            float dt_s = s_estimate_time_us ? (now - s_estimate_time_us) / 1e6f : 0.0f;
+            result = temp_estimator_update(&s_estimator, raw, dt_s);
+            if (result != TEMP_EST_REJECTED_INVALID) {
+                s_estimate_time_us = now;
+            }
+        }
+        sensor_fault_t sf = s_sensor_fault;
+        float rate = s_estimator.rate;
+        portEXIT_CRITICAL(&s_estimator_mux);
+        LATENCY_RECORD(s_lat_estimator, (uint32_t)(esp_timer_get_time() - now));
+
+        if (!trusted) {
+            ESP_LOGW(TAG, "温度读数 %.2f°C 不可信: %s", raw, sensor_fault_kind_name(sf.last));
+        } else if (result != TEMP_EST_ACCEPTED) {
+            ESP_LOGW(TAG, "温度读数 %.2f°C 未被采用 (%d)", raw, result);
+        }
+        if (sf.state != before) {
+            report_sensor_fault(&sf, before, now_ms);
+        }
+        LATENCY_START(t_history);
+        record_history(now);
+        LATENCY_STOP(s_lat_history, t_history);
+
+        // 当前控制周期内温度变化将超过两个调整步长，或传感器状态变化：提前唤醒控制任务
+        uint32_t control_ms = s_period.period_ms;
+        if (s_control_task && control_ms > CONTROL_PERIOD_MIN_MS &&
+            ((result == TEMP_EST_ACCEPTED && fabsf(rate) * control_ms / 1000.0f > 2.0f * ADAPT_STEP_C) ||
+             sf.state != before)) {
+            xTaskNotifyGive(s_control_task);
+        }
+        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(s_sensor_period_ms));
+    }
+}
+
+/**
+ * @brief 生成自整定进度快照，交给上报任务发布到 MQTT 和 OLED 状态行
+ */
+static void report_autotune(void) {
+    mqtt_autotune_report_t report = {
+        .phase  = relay_autotune_phase_name(s_tune.phase),
+        .reason = s_tune.phase == AUTOTUNE_ABORTED ? relay_autotune_abort_name(s_tune.abort_reason) : NULL,
+        .cycle  = relay_autotune_progress(&s_tune),
+        .cycles = s_tune.cfg.cycles,
+    };
+    char status[sizeof(s_tune_status)];
+    switch (s_tune.phase) {
+    case AUTOTUNE_RELAY:
+        snprintf(status, sizeof(status), "Tune %d/%d", report.cycle, report.cycles);
+        break;
+    case AUTOTUNE_DONE:
+        report.ku = s_tune.ku;
+        report.tu_s = s_tune.tu_s;
+        relay_autotune_pi_gains(&s_tune, &report.kp, &report.ki);
+        snprintf(status, sizeof(status), "Tune OK Kp %.1f", report.kp);
+        break;
+    case AUTOTUNE_ABORTED:
+        snprintf(status, sizeof(status), "Tune abort: %s", report.reason);
+        break;
+    default:
+        status[0] = '\0';
+        break;
+    }
+    portENTER_CRITICAL(&s_tune_report_mux);
+    s_tune_report = report;
+    memcpy(s_tune_status, status, sizeof(s_tune_status));
+    portEXIT_CRITICAL(&s_tune_report_mux);
+    request_report(REPORT_AUTOTUNE);
+}
+
+/**
+ * @brief 自整定结束：计算并保存增益
+ */
+static void finish_autotune(void) {
+    pi_gains_t gains = { .ku = s_tune.ku, .tu_s = s_tune.tu_s };
+    if (relay_autotune_pi_gains(&s_tune, &gains.kp, &gains.ki)) {
+        pi_controller_init(&s_pi, gains.kp, gains.ki);
+        s_pi_valid = true;
+        save_pi_gains(&gains);
+        ESP_LOGI(TAG, "自整定完成: Ku=%.2f Tu=%.0fs → Kp=%.2f Ki=%.4f",
+                 gains.ku, gains.tu_s, gains.kp, gains.ki);
+    } else {
+        ESP_LOGW(TAG, "自整定中止: %s", relay_autotune_abort_name(s_tune.abort_reason));
+    }
+    report_autotune();
+}
+
+/**
+ * @brief 中止进行中的自整定并上报
+ */
+static void abort_autotune(autotune_abort_t reason) {
+    if (s_tune.phase != AUTOTUNE_RELAY) return;
+    relay_autotune_abort(&s_tune, reason);
+    finish_autotune();
+}
+
+/**
+ * @brief 处理自整定请求（控制任务上下文）
+ */
+static void handle_tune_request(uint32_t now_ms) {
+    tune_request_t req = s_tune_request;
+    s_tune_request = TUNE_REQ_NONE;
+
+    switch (req) {
+    case TUNE_REQ_START: {
+        if (s_tune.phase == AUTOTUNE_RELAY) break;
+        if (s_fan_cal_active) {
+            ESP_LOGW(TAG, "风扇校准中不能自整定");
+            break;
+        }
+        if (!g_system.auto_mode) {
+            ESP_LOGW(TAG, "手动模式下不能自整定");
+            break;
+        }
+        autotune_config_t cfg;
+        relay_autotune_default_config(&cfg, g_system.temp_threshold);
+        cfg.output_high = g_system.max_speed;
+        relay_autotune_start(&s_tune, &cfg, now_ms);
+        ESP_LOGI(TAG, "开始自整定: 设定值 %.1f°C", cfg.setpoint);
+        report_autotune();
+        break;
+    }
+    case TUNE_REQ_ABORT:
+        abort_autotune(AUTOTUNE_ABORT_USER);
+        break;
+    case TUNE_REQ_CLEAR:
+        abort_autotune(AUTOTUNE_ABORT_USER);
+        s_pi_valid = false;
+        save_pi_gains(NULL);
+        ESP_LOGI(TAG, "已清除 PI 增益，恢复分段温控");
+        break;
+    case TUNE_REQ_NONE:
+        break;
+    }
+}
+
+/**
+ * @brief 生成风扇校准进度，交给上报任务显示到 OLED 状态行
+ */
+static void report_fan_cal(void) {
+    char status[sizeof(s_fan_cal_status)];
+    switch (s_fan_cal.phase) {
+    case FAN_CAL_PURGE:
+        snprintf(status, sizeof(status), "Fan cal: purge");
+        break;
+    case FAN_CAL_SWEEP:
+        snprintf(status, sizeof(status), "Fan cal %u%%", fan_cal_progress(&s_fan_cal));
+        break;
+    case FAN_CAL_DONE:
+        snprintf(status, sizeof(status), "Fan cal OK");
+        break;
+    case FAN_CAL_FAILED:
+        snprintf(status, sizeof(status), "Fan cal failed");
+        break;
+    default:
+        status[0] = '\0';
+        break;
+    }
+    portENTER_CRITICAL(&s_fan_cal_mux);
+    memcpy(s_fan_cal_status, status, sizeof(s_fan_cal_status));
+    portEXIT_CRITICAL(&s_fan_cal_mux);
+    request_report(REPORT_FAN_CAL);
+}
+
+/**
+ * @brief 风扇校准结束：保存新表，把输出交还监督器
+ *        扫描绕过了监督器，按风扇刚从停转启动处理：本周期风扇全速、制冷片关闭，重新计 spin-up
+ */
+static cooling_output_t finish_fan_cal(uint32_t now_ms) {
+    fan_tach_enable(false);
+    s_fan_cal_active = false;
+    if (s_fan_cal.phase == FAN_CAL_DONE && fan_pwm_set_curve(&s_fan_cal.curve)) {
+        save_fan_curve(&s_fan_cal.curve);
+        const uint16_t* d = s_fan_cal.curve.duty_pm;
+        ESP_LOGI(TAG, "风扇校准完成: 5%%→%u‰ 25%%→%u‰ 50%%→%u‰ 75%%→%u‰ 100%%→%u‰ (满速 %.0f rpm)",
+                 d[1], d[5], d[10], d[15], d[20], s_fan_cal.rpm[FAN_CAL_STEPS - 1]);
+    } else {
+        s_fan_cal.phase = FAN_CAL_FAILED;
+        ESP_LOGW(TAG, "风扇校准失败或被取消，沿用原线性化表");
+    }
+    report_fan_cal();
+
+    portENTER_CRITICAL(&s_supervisor_mux);
+    s_supervisor.applied.fan = 0;
+    cooling_output_t out = cooling_supervisor_force_safe(&s_supervisor, now_ms);
+    portEXIT_CRITICAL(&s_supervisor_mux);
+    return out;
+}
+
+/**
+ * @brief 推进风扇校准一个周期并输出（控制任务上下文）
+ * @return 本周期实际输出
+ */
+static cooling_output_t step_fan_cal(uint32_t now_ms) {
+    fan_cal_phase_t phase = s_fan_cal.phase;
+    uint8_t progress = fan_cal_progress(&s_fan_cal);
+    uint16_t duty = fan_cal_step(&s_fan_cal, fan_tach_take_pulses(), now_ms);
+    if (s_fan_cal.phase != FAN_CAL_PURGE && s_fan_cal.phase != FAN_CAL_SWEEP) {
+        cooling_output_t out = finish_fan_cal(now_ms);
+        apply_outputs(out);
+        return out;
+    }
+    if (s_fan_cal.phase != phase || fan_cal_progress(&s_fan_cal) != progress) {
+        report_fan_cal();
+    }
+    apply_fan_cal_duty(duty);
+    return (cooling_output_t){ (uint8_t)((duty + 5) / 10), 0 };
+}
+
+/**
+ * @brief 处理风扇校准请求（控制任务上下文）
+ *        开始时经监督器关闭制冷片；制冷片刚在运行时先全速运行一个余热排出时间再扫描
+ */
+static void handle_fan_cal_request(uint32_t now_ms) {
+    if (!s_fan_cal_requested) return;
+    s_fan_cal_requested = false;
+
+    switch (s_fan_cal_request) {
+    case MQTT_FAN_CAL_START: {
+        if (s_fan_cal_active) break;
+        if (s_tune.phase == AUTOTUNE_RELAY) {
+            ESP_LOGW(TAG, "自整定中不能校准风扇");
+            break;
+        }
+        portENTER_CRITICAL(&s_supervisor_mux);
+        bool tec_was_on = s_supervisor.tec_was_on ||
+                          now_ms - s_supervisor.tec_off_since_ms < SUPERVISOR_FAN_RUNON_MS;
+        cooling_supervisor_force_safe(&s_supervisor, now_ms);
+        portEXIT_CRITICAL(&s_supervisor_mux);
+
+        fan_cal_start(&s_fan_cal, tec_was_on ? SUPERVISOR_FAN_RUNON_MS : 0, now_ms);
+        fan_tach_enable(true);
+        fan_tach_take_pulses();
+        s_fan_cal_active = true;
+        ESP_LOGI(TAG, "开始风扇校准%s", tec_was_on ? "，先排出制冷片余热" : "");
+        report_fan_cal();
+        break;
+    }
+    case MQTT_FAN_CAL_ABORT:
+        fan_cal_abort(&s_fan_cal);
+        break;
+    case MQTT_FAN_CAL_RESET: {
+        fan_cal_abort(&s_fan_cal);
+        fan_curve_t curve;
+        fan_curve_default(&curve);
+        fan_pwm_set_curve(&curve);
+        save_fan_curve(NULL);
+        ESP_LOGI(TAG, "已清除风扇校准，恢复默认线性化表");
+        break;
+    }
+    }
+}
+
+/**
+ * @brief 登记一个控制周期完成，统计本周期是否越过截止时间
+ */
+static void kick_deadline(uint32_t next_period_ms) {
+    portENTER_CRITICAL(&s_deadline_mux);
+    bool was_safe = s_deadline.safe_state;
+    uint32_t added = deadline_monitor_kick(&s_deadline, esp_timer_get_time(), next_period_ms * 1000);
+    portEXIT_CRITICAL(&s_deadline_mux);
+
+    if (added) {
+        metrics_add(&m_deadline_misses, (int32_t)added);
+        TRACE_INSTANT(t_deadline_miss, added);
+        ESP_LOGW(TAG, "控制周期超时，错过 %lu 个截止时间", (unsigned long)added);
+    }
+    if (was_safe) {
+        ESP_LOGW(TAG, "控制任务恢复，退出安全状态");
+    }
+}
+
+/**
+ * @brief 截止时间检查（esp_timer 任务，PRO_CPU）
+ *        控制任务停滞时计数错过的周期，连续错过后直接输出安全值：制冷片关闭、风扇全速
+ */
+static void deadline_check_cb(void* arg) {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_deadline_mux);
+    uint32_t before = s_deadline.misses;
+    bool enter_safe = deadline_monitor_check(&s_deadline, now);
+    uint32_t added = s_deadline.misses - before;
+    portEXIT_CRITICAL(&s_deadline_mux);
+
+    if (added) {
+        metrics_add(&m_deadline_misses, (int32_t)added);
+        TRACE_INSTANT(t_deadline_miss, added);
+    }
+    if (!enter_safe) return;
+
+    TRACE_INSTANT(t_safe_state, 0);
+
+    portENTER_CRITICAL(&s_supervisor_mux);
+    cooling_output_t out = cooling_supervisor_force_safe(&s_supervisor, (uint32_t)(now / 1000));
+    portEXIT_CRITICAL(&s_supervisor_mux);
+    apply_outputs(out);
+    ESP_LOGE(TAG, "控制任务连续错过 %d 个周期，进入安全状态", DEADLINE_SAFE_AFTER);
+    request_report(REPORT_STATE);
+}
+
+/**
+ * @brief 新镜像是否满足健康条件
+ */
+static bool ota_healthy(void) {
+    portENTER_CRITICAL(&s_deadline_mux);
+    uint32_t safe_entries = s_deadline.safe_entries;
+    portEXIT_CRITICAL(&s_deadline_mux);
+    return s_control_cycles >= OTA_HEALTH_CYCLES && safe_entries == 0 && mqtt_comm_is_connected();
+}
+
+/**
+ * @brief OTA 状态回调（OTA 任务上下文）
+ */
+static void on_ota_status(const ota_status_t* status) {
+    mqtt_ota_status_t report = {
+        .state    = ota_update_state_name(status->state),
+        .progress = status->progress,
+        .received = status->received,
+        .written  = status->written,
+        .error    = status->error,
+        .version  = esp_app_get_description()->version,
+    };
+    mqtt_comm_publish_ota_status(g_system.mqtt_client, &report);
+}
+
+/**
+ * @brief OTA 请求回调（MQTT 任务上下文）
+ */
+static void on_ota_request(const mqtt_ota_request_t* req) {
+    ESP_LOGI(TAG, "收到 OTA 请求: %s", req->url);
+    if (!ota_update_start(req->url, req->sha256, req->compressed)) {
+        ota_status_t status = { .state = OTA_STATE_FAILED, .error = "rejected" };
+        on_ota_status(&status);
+    }
+}
+
+/**
+ * @brief 上报任务（PRO_CPU）：按通知位刷新 OLED 并完成各类网络上报
+ */
+static void report_task(void *arg) {
+    int64_t last_energy_save_us = esp_timer_get_time();
+    while (1) {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+        TRACE_BEGIN(t_report);
+
+        if (bits & REPORT_AUTOTUNE) {
+            mqtt_autotune_report_t tune;
+            char status[sizeof(s_tune_status)];
+            portENTER_CRITICAL(&s_tune_report_mux);
+            tune = s_tune_report;
+            memcpy(status, s_tune_status, sizeof(status));
+            portEXIT_CRITICAL(&s_tune_report_mux);
+            oled_display_set_status(status);
+            mqtt_comm_publish_autotune(g_system.mqtt_client, &tune);
+        }
+
+        if (bits & REPORT_FAN_CAL) {
+            char status[sizeof(s_fan_cal_status)];
+            portENTER_CRITICAL(&s_fan_cal_mux);
+            memcpy(status, s_fan_cal_status, sizeof(status));
+            portEXIT_CRITICAL(&s_fan_cal_mux);
+            oled_display_set_status(status);
+        }
+
+        if (bits & REPORT_SENSOR) {
+            mqtt_sensor_report_t sensor;
+            char status[sizeof(s_sensor_status)];
+            portENTER_CRITICAL(&s_sensor_report_mux);
+            sensor = s_sensor_report;
+            memcpy(status, s_sensor_status, sizeof(status));
+            portEXIT_CRITICAL(&s_sensor_report_mux);
+            oled_display_set_status(status);
+            mqtt_comm_publish_sensor(g_system.mqtt_client, &sensor);
+        }
+
+        if (bits & REPORT_MENU) {
+            draw_menu();
+        }
+
+        if (bits & REPORT_STATE) {
+            float temp = control_temperature();
+            portENTER_CRITICAL(&s_supervisor_mux);
+            cooling_output_t applied = s_energy.duty;
+            portEXIT_CRITICAL(&s_supervisor_mux);
+            uint8_t fan_speed = applied.fan;
+            bool auto_mode = g_system.auto_mode;
+
+            // 菜单打开期间状态照常上报，只是不覆盖屏幕
+            if (!menu_showing()) {
+                LATENCY_START(t_oled);
+                // 显示监督器实际输出（联锁、过温切断和功率预算之后），而不是请求值
+                oled_display_update(temp, fan_speed, applied.tec, auto_mode);
+                LATENCY_STOP(s_lat_oled, t_oled);
+            }
+
+            LATENCY_START(t_report);
+            report_state(temp, fan_speed, auto_mode);
+            LATENCY_STOP(s_lat_report, t_report);
+            mqtt_comm_service(g_system.mqtt_client);
+
+            // 写 otadata 需要访问 flash，放在上报任务而不是控制任务中
+            if (ota_update_pending_verify() && ota_healthy()) {
+                ota_update_confirm();
+            }
+        }
+
+        if (bits & REPORT_TELEMETRY) {
+            LATENCY_START(t_telemetry);
+            publish_telemetry();
+            LATENCY_STOP(s_lat_telemetry, t_telemetry);
+            if (esp_timer_get_time() - last_energy_save_us >= (int64_t)ENERGY_SAVE_PERIOD_S * 1000000) {
+                last_energy_save_us = esp_timer_get_time();
+                save_energy();
+            }
+        } else if (bits & REPORT_LATENCY) {
+            publish_latency(false);
+        }
+        TRACE_END(t_report);
+
+        if (bits & (REPORT_TRACE | REPORT_TRACE_LOG)) {
+            publish_trace((bits & REPORT_TRACE) != 0);
+        }
+    }
+}
+
+/**
+ * @brief 按估计变化率和误差计算下一个控制周期，并派生传感器和遥测节拍
+ *        估计器未初始化（刚启动）或传感器故障时保持最短周期，尽快发现恢复
+ */
+static uint32_t next_control_period(float temp) {
+    portENTER_CRITICAL(&s_estimator_mux);
+    bool valid = s_estimator.initialized && s_sensor_fault.state == SENSOR_STATE_OK;
+    float rate = s_estimator.rate;
+    portEXIT_CRITICAL(&s_estimator_mux);
+
+    uint32_t period_ms = valid
+        ? adaptive_period_update(&s_period, rate, temp - g_system.temp_threshold)
+        : adaptive_period_update(&s_period, 0.0f, ADAPT_ERROR_FULL_C);
+    s_sensor_period_ms = adaptive_period_scale(period_ms, 1, 2, SENSOR_PERIOD_MIN_MS, SENSOR_PERIOD_MAX_MS);
+    s_telemetry_period_ms = adaptive_period_scale(period_ms, 12, 1, TELEMETRY_PERIOD_MIN_MS,
+                                                  TELEMETRY_PERIOD_MAX_MS);
+    return period_ms;
+}
+
+/**
+ * @brief 等到下一个控制周期；传感器任务发现温度快速变化时可提前唤醒
+ *        已经越过唤醒时刻时不等待（与 vTaskDelayUntil 一致）
+ */
+static void wait_next_period(TickType_t* last_wake_time, uint32_t period_ms) {
+    TickType_t period = pdMS_TO_TICKS(period_ms);
+    TickType_t wake = *last_wake_time + period;
+    TickType_t remaining = wake - xTaskGetTickCount();
+    if (remaining > 0 && remaining <= period && ulTaskNotifyTake(pdTRUE, remaining)) {
+        wake = xTaskGetTickCount();
+    }
+    *last_wake_time = wake;
+}
+
 /**
  * @brief 自动模式控制任务
  */
 static void auto_control_task(void *arg) {
     TickType_t last_wake_time = xTaskGetTickCount();
+    uint32_t last_telemetry_ms = 0;
+    uint32_t last_state_ms = 0;
+    uint32_t last_control_ms = 0;
+    uint32_t period_ms = s_period.period_ms;
+    cooling_output_t last_out = { 0, 0 };
+    uint8_t demand = 0;
+#if LATENCY_PROFILE_ENABLE
+    int64_t prev_start_us = 0;
+#endif
     while (1) {
-        float temp = temp_sensor_get_temperature();
-        // 风扇始终自动运行
-        uint8_t fan_speed = map_temp_to_speed(temp);
-        fan_pwm_set_speed(fan_speed);
-        // 制冷片根据模式自动或手动
-        uint8_t cooler_power = g_system.auto_mode ? map_temp_to_speed(temp) : manual_cooler_power;
-        cooler_pwm_set_power(cooler_power);
-        oled_display_update(temp, fan_speed, g_system.auto_mode);
-        mqtt_comm_publish(g_system.mqtt_client, temp, fan_speed, g_system.auto_mode);
-        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(5000));
+        float temp = control_temperature();
+        int64_t work_start = esp_timer_get_time();
+        uint32_t now_ms = (uint32_t)(work_start / 1000);
+        float dt_s = last_control_ms ? (now_ms - last_control_ms) / 1000.0f : 0.0f;
+        last_control_ms = now_ms;
+#if LATENCY_PROFILE_ENABLE
+        // 唤醒滞后：实际间隔超出计划周期的部分（含一个 tick 以内的量化误差）
+        if (prev_start_us) {
+            int64_t late = (work_start - prev_start_us) - (int64_t)period_ms * 1000;
+            LATENCY_RECORD(s_lat_wake, late > 0 ? (uint32_t)late : 0);
+        }
+        prev_start_us = work_start;
+#endif
+
+        TRACE_BEGIN(t_control);
+        LATENCY_START(t_law);
+        handle_tune_request(now_ms);
+        handle_fan_cal_request(now_ms);
+        if (!g_system.auto_mode) {
+            abort_autotune(AUTOTUNE_ABORT_USER);
+        }
+        portENTER_CRITICAL(&s_estimator_mux);
+        sensor_state_t sensor = s_sensor_fault.state;
+        uint8_t failsafe_fan = s_sensor_fault.failsafe_fan;
+        portEXIT_CRITICAL(&s_estimator_mux);
+        if (sensor != SENSOR_STATE_OK) {
+            // 外推温度只够维持控制，不能用于辨识
+            abort_autotune(AUTOTUNE_ABORT_SENSOR);
+        }
+
+        cooling_output_t out;
+        if (s_fan_cal_active) {
+            // 校准期间由扫描序列直接决定输出，控制律暂停
+            out = step_fan_cal(now_ms);
+            LATENCY_STOP(s_lat_law, t_law);
+        } else {
+            if (sensor == SENSOR_STATE_FAILSAFE) {
+                // 没有可信温度：风扇固定占空比，PI 恢复后从该输出无扰接续
+                pi_controller_reset(&s_pi);
+                demand = failsafe_fan;
+            } else if (s_tune.phase == AUTOTUNE_RELAY) {
+                uint8_t progress = relay_autotune_progress(&s_tune);
+                demand = relay_autotune_step(&s_tune, temp, now_ms);
+                if (s_tune.phase != AUTOTUNE_RELAY) {
+                    finish_autotune();
+                } else if (relay_autotune_progress(&s_tune) != progress) {
+                    report_autotune();
+                }
+            } else if (g_system.auto_mode && s_pi_valid) {
+                demand = (uint8_t)lroundf(pi_controller_update(&s_pi, g_system.temp_threshold, temp,
+                                                               dt_s, demand, g_system.max_speed));
+            } else {
+                // 分段温控期间让 PI 下次启用时从当前输出无扰接续
+                pi_controller_reset(&s_pi);
+                demand = map_temp_to_speed(temp);
+            }
+            // 自动模式按模型选取总功耗最小的组合；手动模式风扇仍自动、制冷片按设定；
+            // 失效安全时冷端温度无从验证，两种模式都关闭制冷片
+            cooling_output_t request = sensor == SENSOR_STATE_FAILSAFE ? (cooling_output_t){ demand, 0 }
+                : g_system.auto_mode ? cooling_supervisor_optimize(&s_supervisor, demand)
+                : (cooling_output_t){ demand, manual_cooler_power };
+            float hot = temp_sensor_has_hot_side() ? temp_sensor_get_hot_side_temperature() : SUPERVISOR_HOT_UNKNOWN;
+
+            portENTER_CRITICAL(&s_supervisor_mux);
+            uint32_t trips_before = s_supervisor.overtemp_trips;
+            out = cooling_supervisor_step(&s_supervisor, request, temp, hot, now_ms);
+            bool tripped = s_supervisor.overtemp_trips != trips_before;
+            bool overtemp = s_supervisor.overtemp;
+            portEXIT_CRITICAL(&s_supervisor_mux);
+
+            if (tripped) {
+                ESP_LOGE(TAG, "热端过温 %.1f°C，切断制冷片", hot);
+            }
+            if (overtemp) {
+                abort_autotune(AUTOTUNE_ABORT_OVERTEMP);
+            }
+            s_tune_active = s_tune.phase == AUTOTUNE_RELAY;
+            LATENCY_STOP(s_lat_law, t_law);
+
+            LATENCY_START(t_pwm);
+            apply_outputs(out);
+            LATENCY_STOP(s_lat_pwm, t_pwm);
+        }
+        TRACE_COUNTER(t_fan_duty, out.fan);
+        TRACE_COUNTER(t_tec_duty, out.tec);
+
+        // 输出变化时立即刷新显示和状态，否则按显示节拍限速
+        uint32_t report = 0;
+        if (out.fan != last_out.fan || out.tec != last_out.tec ||
+            now_ms - last_state_ms >= DISPLAY_PERIOD_MIN_MS) {
+            last_state_ms = now_ms;
+            last_out = out;
+            report |= REPORT_STATE;
+        }
+        if (now_ms - last_telemetry_ms >= s_telemetry_period_ms) {
+            last_telemetry_ms = now_ms;
+            report |= REPORT_TELEMETRY;
+        }
+        if (report) {
+            request_report(report);
+        }
+        metrics_observe(&m_loop_us, (uint32_t)(esp_timer_get_time() - work_start));
+        TRACE_END(t_control);
+
+        if (++s_control_cycles == HEAP_GUARD_WARMUP_CYCLES) {
+            heap_guard_mark_baseline();
+        }
+        if (s_tune_active) {
+            // 继电自整定需要连续采样，固定短周期
+            period_ms = AUTOTUNE_PERIOD_MS;
+            s_sensor_period_ms = SENSOR_PERIOD_MIN_MS;
+        } else if (s_fan_cal_active) {
+            period_ms = FAN_CAL_PERIOD_MS;
+        } else {
+            period_ms = next_control_period(temp);
+        }
+        kick_deadline(period_ms);
+        wait_next_period(&last_wake_time, period_ms);
     }
 }
 
@@ -157,6 +1934,10 @@ static void auto_control_task(void *arg) {
 static void on_got_ip(void* arg, esp_event_base_t event_base,
                       int32_t event_id, void* event_data) {
     ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;    ESP_LOGI(TAG, "获取到 IP: " IPSTR, IP2STR(&event->ip_info.ip));
+    // 连接成功后开启 modem sleep
+    power_mgmt_enable_modem_sleep();
+    // 启动局域网 HTTP/WebSocket 接口（重连时不会重复启动）
+    lan_api_start();
     ESP_LOGI(TAG, "启动 MQTT 客户端");
     if (g_system.mqtt_client) {
         esp_mqtt_client_start(g_system.mqtt_client);
@@ -178,6 +1959,21 @@ void app_main(void) {
         ESP_ERROR_CHECK(nvs_flash_init());
     }
     
+    // 启用 DFS 和 tickless idle，须在各外设驱动使用电源锁之前完成
+    power_mgmt_init();
+    
+    metrics_register(&m_heap_free);
+    metrics_register(&m_heap_min);
+    metrics_register(&m_heap_largest);
+    metrics_register(&m_steady_allocs);
+    metrics_register(&m_control_hwm);
+    metrics_register(&m_sensor_hwm);
+    metrics_register(&m_report_hwm);
+    metrics_register(&m_deadline_misses);
+    metrics_register(&m_sensor_faults);
+    metrics_register(&m_sensor_failsafe);
+    metrics_register(&m_loop_us);
+    
     // 2. 初始化 TCP/IP 和事件循环
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
@@ -206,6 +2002,9 @@ void app_main(void) {
     // 4. WiFi已配置，启动正常模式
     ESP_LOGI(TAG, "WiFi已配置，启动正常模式");
     
+    // 新镜像首次启动时开始健康确认计时
+    ota_update_init(on_ota_status);
+
     // 注册 IP 事件（在启动WiFi之前注册）
     ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP,
                                                on_got_ip, NULL));
@@ -215,20 +2014,68 @@ void app_main(void) {
 
     // 5. 初始化各组件
     temp_sensor_init(DS18B20_GPIO);
+    temp_sensor_init_hot_side(HOT_SIDE_GPIO);
+    temp_estimator_init(&s_estimator, EST_MEAS_SIGMA, EST_ACCEL_SIGMA);
+    sensor_fault_init(&s_sensor_fault, SENSOR_FAULT_HOLDOVER_MS, SENSOR_FAULT_FAILSAFE_FAN);
+    load_sensor_cfg();
+    load_control_cfg();
+    cooling_model_t model;
+    cooling_model_default(&model);
+    cooling_supervisor_init(&s_supervisor, &model);
+    load_power_cfg();
+    load_energy();
+    esp_register_shutdown_handler(save_energy);
+    load_pi_gains();
+    history_init(&s_history);
+    s_history_lock = xSemaphoreCreateMutex();
     cooler_pwm_init(COOLER_PWM_CHANNEL, COOLER_PWM_GPIO);
     fan_pwm_init(FAN_PWM_CHANNEL, FAN_PWM_GPIO);
+    fan_tach_init(FAN_TACH_GPIO);
+    load_fan_curve();
     oled_init(I2C_NUM_0, I2C_SDA_GPIO, I2C_SCL_GPIO);
     
     // 初始化 MQTT 客户端并设置回调，将句柄存储到全局结构体
     g_system.mqtt_client = mqtt_comm_init();
     mqtt_comm_set_command_callback(on_mqtt_command);
     mqtt_comm_set_config_callback(on_mqtt_config);
+    mqtt_comm_set_history_callback(on_history_request);
+    mqtt_comm_set_ota_callback(on_ota_request);
+    
+    // 局域网接口复用 MQTT 的命令/配置处理
+    lan_api_set_command_callback(on_mqtt_command);
+    lan_api_set_config_callback(on_mqtt_config);
+    sync_lan_config();
     
     user_input_init(ENCODER_A_GPIO, ENCODER_B_GPIO, ENCODER_BTN_GPIO,
                     on_mode_change, on_encoder_change);
+    user_input_set_long_press_callback(on_long_press);
+    ui_menu_init(&s_menu, "Settings", s_menu_items, MENU_ITEM_COUNT);
+    user_input_set_event_callback(on_input_event);
     
-    // 6. 启动自动模式任务
-    xTaskCreate(auto_control_task, "auto_control_task", 4096, NULL, 5, NULL);
+    deadline_monitor_init(&s_deadline, DEADLINE_GRACE_MS * 1000, DEADLINE_SAFE_AFTER);
+    adaptive_period_init(&s_period, CONTROL_PERIOD_MIN_MS, CONTROL_PERIOD_MAX_MS,
+                         ADAPT_STEP_C, ADAPT_ERROR_BAND_C, ADAPT_ERROR_FULL_C);
+
+    // 6. 启动任务：上报任务先于控制任务创建，保证第一次通知不丢失
+    s_report_task = xTaskCreateStaticPinnedToCore(report_task, "report_task", REPORT_TASK_STACK, NULL,
+                                                  REPORT_TASK_PRIO, s_report_stack, &s_report_tcb,
+                                                  REPORT_TASK_CORE);
+    s_sensor_task = xTaskCreateStaticPinnedToCore(sensor_task, "sensor_task", SENSOR_TASK_STACK, NULL,
+                                                  SENSOR_TASK_PRIO, s_sensor_stack, &s_sensor_tcb,
+                                                  SENSOR_TASK_CORE);
+    s_control_task = xTaskCreateStaticPinnedToCore(auto_control_task, "auto_control_task", CONTROL_TASK_STACK,
+                                                   NULL, CONTROL_TASK_PRIO, s_control_stack, &s_control_tcb,
+                                                   CONTROL_TASK_CORE);
+    heap_guard_watch(s_control_task);
+    heap_guard_watch(s_sensor_task);
+
+    const esp_timer_create_args_t deadline_timer_args = {
+        .callback = deadline_check_cb,
+        .name = "deadline",
+    };
+    esp_timer_handle_t deadline_timer;
+    ESP_ERROR_CHECK(esp_timer_create(&deadline_timer_args, &deadline_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(deadline_timer, DEADLINE_CHECK_MS * 1000));
     
     // 7. 主循环
     while (true) {
@@ -0,0 +1,99 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief 主机吞吐基准：每个用例重复测量取最快一轮，输出与 bench_baseline.txt 相同的格式
+ *        bench_xxx [--baseline <文件>] [--tolerance <倍数>]
+ *        给出基准文件时逐项比较，比基准慢超过 tolerance 倍（默认 3）返回非 0
+ *        主机与 ESP32 的绝对速度无关，只用于发现解析路径的数量级退化
+ */
+
+#define BENCH_ROUNDS    5
+#define BENCH_ROUND_NS  50000000.0      // 每轮至少 50ms
+
+typedef struct {
+    const char* baseline;
+    double tolerance;
+    int regressions;
+} bench_ctx_t;
+
+static double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench_init(bench_ctx_t* ctx, int argc, char** argv) {
+    ctx->baseline = NULL;
+    ctx->tolerance = 3.0;
+    ctx->regressions = 0;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--baseline") == 0) ctx->baseline = argv[++i];
+        else if (strcmp(argv[i], "--tolerance") == 0) ctx->tolerance = atof(argv[++i]);
+    }
+}
+
+/**
+ * @return 基准文件中 name 的 ns/op，没有记录时返回 0
+ */
+static double bench_baseline(const char* path, const char* name) {
+    FILE* f = fopen(path, "r");
+    if (!f) return 0;
+    char line[256], key[128];
+    double ns = 0, v;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%127s %lf", key, &v) == 2 && strcmp(key, name) == 0) ns = v;
+    }
+    fclose(f);
+    return ns;
+}
+
+/**
+ * @brief 报告一项结果：name ns/op [MB/s]，bytes 为每次操作处理的字节数（0 表示不计吞吐）
+ */
+static void bench_report(bench_ctx_t* ctx, const char* name, double ns_per_op, size_t bytes) {
+    printf("%-40s %10.1f", name, ns_per_op);
+    if (bytes) printf("  # %.1f MB/s", bytes / ns_per_op * 1e3);
+    if (ctx->baseline) {
+        double base = bench_baseline(ctx->baseline, name);
+        if (base > 0) {
+            printf("  # baseline %.1f (%+.0f%%)", base, (ns_per_op / base - 1) * 100);
+            if (ns_per_op > base * ctx->tolerance) {
+                printf("  REGRESSION");
+                ctx->regressions++;
+            }
+        } else {
+            printf("  # no baseline");
+        }
+    }
+    printf("\n");
+}
+
+/**
+ * @brief 测量 body 的单次耗时（ns），body 为语句块，循环变量为 bench_i
+ */
+#define BENCH_RUN(ctx, name, bytes, body) do {                                  \
+        double best_ = 0;                                                       \
+        for (int round_ = 0; round_ < BENCH_ROUNDS; round_++) {                 \
+            long iters_ = 0;                                                    \
+            double start_ = bench_now_ns(), elapsed_;                           \
+            do {                                                                \
+                for (long bench_i = 0; bench_i < 1000; bench_i++) { body; }     \
+                iters_ += 1000;                                                 \
+                elapsed_ = bench_now_ns() - start_;                             \
+            } while (elapsed_ < BENCH_ROUND_NS);                                \
+            double per_ = elapsed_ / iters_;                                    \
+            if (round_ == 0 || per_ < best_) best_ = per_;                      \
+        }                                                                       \
+        bench_report(ctx, name, best_, bytes);                                  \
+    } while (0)
+
+#define BENCH_RESULT(ctx) ((ctx)->regressions ? 1 : 0)
+
+#endif // BENCH_H
@@ -0,0 +1,36 @@
+#include "bench.h"
+#include "form_field.h"
+
+/**
+ * @brief 配网表单解析吞吐：典型表单、字段在末尾、全部百分号编码
+ */
+
+static volatile int s_sink;
+
+int main(int argc, char** argv) {
+    bench_ctx_t ctx;
+    bench_init(&ctx, argc, argv);
+
+    static const char form[] = "ssid=Office+WiFi+5G&password=correct%20horse%20battery%20staple";
+    char ssid[32], password[64];
+    BENCH_RUN(&ctx, "form_field_get/typical", sizeof(form) - 1, {
+        s_sink = form_field_get(form, sizeof(form) - 1, "ssid", ssid, sizeof(ssid));
+        s_sink += form_field_get(form, sizeof(form) - 1, "password", password, sizeof(password));
+    });
+
+    char padded[512];
+    int n = 0;
+    for (int i = 0; n < 400; i++) n += snprintf(padded + n, sizeof(padded) - n, "f%d=v%d&", i, i);
+    n += snprintf(padded + n, sizeof(padded) - n, "ssid=last");
+    BENCH_RUN(&ctx, "form_field_get/last_of_many", (size_t)n, {
+        s_sink = form_field_get(padded, n, "ssid", ssid, sizeof(ssid));
+    });
+
+    char encoded[64 * 3 + 1];
+    for (int i = 0; i < 63; i++) snprintf(encoded + i * 3, 4, "%%%02X", 'A' + i % 26);
+    BENCH_RUN(&ctx, "form_url_decode/percent_63", 63 * 3, {
+        s_sink = form_url_decode(encoded, 63 * 3, password, sizeof(password));
+    });
+
+    return BENCH_RESULT(&ctx);
+}
@@ -0,0 +1,37 @@
+#include "bench.h"
+#include "mqtt_comm.h"
+
+/**
+ * @brief cJSON 解析路径吞吐（静态内存池）：命令、完整配置、历史查询
+ */
+
+static volatile int s_sink;
+
+int main(int argc, char** argv) {
+    bench_ctx_t ctx;
+    bench_init(&ctx, argc, argv);
+    mqtt_comm_init();
+
+    static const char cmd_json[] = "{\"id\":\"c42\",\"speed\":65,\"mode\":\"manual\"}";
+    mqtt_command_t cmd;
+    BENCH_RUN(&ctx, "mqtt_parse_command/speed_mode", sizeof(cmd_json) - 1, {
+        s_sink = mqtt_comm_parse_command(cmd_json, sizeof(cmd_json) - 1, &cmd);
+    });
+
+    static const char cfg_json[] =
+        "{\"temp_threshold\":31.5,\"max_speed\":90,\"power_budget_w\":40,"
+        "\"power_model\":{\"fan_w\":3.2,\"fan_exp\":2.8,\"tec_w\":58,\"tec_exp\":1.0},"
+        "\"sensor\":{\"holdover_s\":300,\"failsafe_fan\":80}}";
+    mqtt_config_t cfg;
+    BENCH_RUN(&ctx, "mqtt_parse_config/full", sizeof(cfg_json) - 1, {
+        s_sink = mqtt_comm_parse_config(cfg_json, sizeof(cfg_json) - 1, &cfg);
+    });
+
+    static const char hist_json[] = "{\"id\":\"q1\",\"field\":\"temp\",\"from_s\":86400,\"to_s\":0,\"points\":200}";
+    mqtt_history_request_t req;
+    BENCH_RUN(&ctx, "mqtt_parse_history/typical", sizeof(hist_json) - 1, {
+        s_sink = mqtt_comm_parse_history_request(hist_json, sizeof(hist_json) - 1, &req);
+    });
+
+    return BENCH_RESULT(&ctx);
+}
@@ -0,0 +1,165 @@
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/**
+ * @brief 没有 libFuzzer 时（GCC 构建）的独立驱动：先回放语料，再做确定性的随机变异
+ *        命令行与 libFuzzer 兼容：fuzz_xxx [-runs=N] [-seed=S] [-max_len=L] <语料目录或文件>...
+ *        每个输入都按实际长度单独分配，配合 ASan 可以发现越界读
+ */
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+int LLVMFuzzerInitialize(int* argc, char*** argv) __attribute__((weak));
+
+#define CORPUS_MAX 1024
+
+typedef struct {
+    uint8_t* data;
+    size_t size;
+} input_t;
+
+static input_t s_corpus[CORPUS_MAX];
+static size_t s_corpus_count = 0;
+static uint64_t s_rng = 0x9e3779b97f4a7c15ull;
+
+static uint32_t rnd(uint32_t n) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return n ? (uint32_t)(s_rng % n) : 0;
+}
+
+static void run_one(const uint8_t* data, size_t size) {
+    uint8_t* copy = malloc(size ? size : 1);
+    if (size) memcpy(copy, data, size);
+    LLVMFuzzerTestOneInput(copy, size);
+    free(copy);
+}
+
+static void load_file(const char* path, size_t max_len) {
+    FILE* f = fopen(path, "rb");
+    if (!f || s_corpus_count == CORPUS_MAX) {
+        if (f) fclose(f);
+        return;
+    }
+    uint8_t* buf = malloc(max_len);
+    size_t n = fread(buf, 1, max_len, f);
+    fclose(f);
+    s_corpus[s_corpus_count].data = buf;
+    s_corpus[s_corpus_count].size = n;
+    s_corpus_count++;
+}
+
+static void load_path(const char* path, size_t max_len) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "fuzz: cannot open %s\n", path);
+        exit(2);
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        load_file(path, max_len);
+        return;
+    }
+    DIR* dir = opendir(path);
+    struct dirent* e;
+    char full[4096];
+    while (dir && (e = readdir(dir)) != NULL) {
+        if (e->d_name[0] == '.') continue;
+        snprintf(full, sizeof(full), "%s/%s", path, e->d_name);
+        load_file(full, max_len);
+    }
+    if (dir) closedir(dir);
+}
+
+/**
+ * @brief 一次变异：位翻转、替换为边界字节、插入、删除、重复片段、与另一输入拼接
+ */
+static size_t mutate(uint8_t* buf, size_t size, size_t max_len) {
+    static const uint8_t interesting[] = { 0, 0xff, 0x7f, 0x80, '%', '+', '&', '=', '"', '\\', '{', '}',
+                                           '[', ']', ',', ':', '-', '.', 'e', '0', '9' };
+    switch (rnd(6)) {
+    case 0:
+        if (size) buf[rnd(size)] ^= (uint8_t)(1u << rnd(8));
+        break;
+    case 1:
+        if (size) buf[rnd(size)] = interesting[rnd(sizeof(interesting))];
+        break;
+    case 2:
+        if (size < max_len) {
+            size_t at = rnd(size + 1);
+            memmove(buf + at + 1, buf + at, size - at);
+            buf[at] = rnd(2) ? interesting[rnd(sizeof(interesting))] : (uint8_t)rnd(256);
+            size++;
+        }
+        break;
+    case 3:
+        if (size) {
+            size_t at = rnd(size), n = 1 + rnd(size - at);
+            memmove(buf + at, buf + at + n, size - at - n);
+            size -= n;
+        }
+        break;
+    case 4:
+        if (size) {
+            size_t at = rnd(size), n = 1 + rnd(size - at);
+            if (n > max_len - size) n = max_len - size;
+            size_t to = rnd(size + 1);
+            uint8_t tmp[256];
+            if (n > sizeof(tmp)) n = sizeof(tmp);
+            memcpy(tmp, buf + at, n);
+            memmove(buf + to + n, buf + to, size - to);
+            memcpy(buf + to, tmp, n);
+            size += n;
+        }
+        break;
+    default: {
+        const input_t* other = &s_corpus[rnd(s_corpus_count)];
+        size_t keep = rnd(size + 1);
+        size_t from = rnd(other->size + 1);
+        size_t n = other->size - from;
+        if (n > max_len - keep) n = max_len - keep;
+        memcpy(buf + keep, other->data + from, n);
+        size = keep + n;
+        break;
+    }
+    }
+    return size;
+}
+
+int main(int argc, char** argv) {
+    unsigned long runs = 10000;
+    size_t max_len = 4096;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-runs=", 6) == 0) runs = strtoul(argv[i] + 6, NULL, 10);
+        else if (strncmp(argv[i], "-seed=", 6) == 0) s_rng = strtoull(argv[i] + 6, NULL, 10) | 1;
+        else if (strncmp(argv[i], "-max_len=", 9) == 0) max_len = strtoul(argv[i] + 9, NULL, 10);
+    }
+    if (LLVMFuzzerInitialize) LLVMFuzzerInitialize(&argc, &argv);
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') load_path(argv[i], max_len);
+    }
+    if (s_corpus_count == 0) {
+        s_corpus[0].data = malloc(1);
+        s_corpus[0].size = 0;
+        s_corpus_count = 1;
+    }
+
+    for (size_t i = 0; i < s_corpus_count; i++) {
+        run_one(s_corpus[i].data, s_corpus[i].size);
+    }
+
+    uint8_t* buf = malloc(max_len);
+    for (unsigned long r = 0; r < runs; r++) {
+        const input_t* seed = &s_corpus[rnd(s_corpus_count)];
+        size_t size = seed->size < max_len ? seed->size : max_len;
+        memcpy(buf, seed->data, size);
+        for (uint32_t m = 1 + rnd(4); m > 0; m--) size = mutate(buf, size, max_len);
+        run_one(buf, size);
+    }
+    free(buf);
+    printf("fuzz: %zu corpus inputs, %lu mutated runs, no crash\n", s_corpus_count, runs);
+    return 0;
+}
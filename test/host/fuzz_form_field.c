@@ -0,0 +1,24 @@
+#include "form_field.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief 表单字段提取：首字节选择字段名和输出缓冲大小，其余为表单数据
+ *        不变式：输出总以 '\0' 结尾且不超出缓冲；失败时为空串
+ */
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static const char* const keys[] = { "ssid", "password", "s", "" };
+    if (size < 1) return 0;
+    const char* key = keys[data[0] & 3];
+    size_t out_size = (data[0] >> 2) + 1;   // 1~64，覆盖 SSID（32）和密码（64）缓冲
+    char* out = malloc(out_size);
+    memset(out, 'x', out_size);
+
+    form_field_result_t ret = form_field_get((const char*)data + 1, size - 1, key, out, out_size);
+    size_t len = strnlen(out, out_size);
+    if (len >= out_size) abort();
+    if (ret != FORM_FIELD_OK && len != 0) abort();
+    free(out);
+    return 0;
+}
@@ -0,0 +1,33 @@
+#include "mqtt_comm.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief MQTT/局域网命令解析与回执格式化
+ *        不变式：速度只在 0~100 时有效；关联ID可原样写入 JSON；回执不超出缓冲
+ */
+int LLVMFuzzerInitialize(int* argc, char*** argv) {
+    (void)argc;
+    (void)argv;
+    mqtt_comm_init();
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size > 4096) return 0;
+    mqtt_command_t cmd;
+    if (!mqtt_comm_parse_command((const char*)data, (int)size, &cmd)) return 0;
+    if (cmd.has_speed && (cmd.speed > 100 || cmd.speed_invalid)) abort();
+    if (strnlen(cmd.id, sizeof(cmd.id)) >= sizeof(cmd.id)) abort();
+    for (const char* c = cmd.id; *c; c++) {
+        if (*c == '"' || *c == '\\' || (unsigned char)*c < 0x20) abort();
+    }
+
+    cmd.rx_us = 1;
+    mqtt_command_ack_t ack = { .result = MQTT_ACK_ACCEPTED, .reason = "fuzz", .actuated_us = 2, .fan_duty = cmd.speed };
+    char buf[160];
+    int len = mqtt_comm_format_ack(&cmd, &ack, 3, buf, sizeof(buf));
+    if (len >= (int)sizeof(buf) || (len > 0 && (size_t)len != strlen(buf))) abort();
+    return 0;
+}
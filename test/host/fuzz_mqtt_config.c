@@ -0,0 +1,38 @@
+#include "mqtt_comm.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @brief MQTT/局域网配置解析
+ *        不变式：置位的字段都在接受范围内（与 mqtt_comm.c 和 README 中的范围一致）
+ */
+int LLVMFuzzerInitialize(int* argc, char*** argv) {
+    (void)argc;
+    (void)argv;
+    mqtt_comm_init();
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size > 4096) return 0;
+    mqtt_config_t cfg;
+    if (!mqtt_comm_parse_config((const char*)data, (int)size, &cfg)) return 0;
+    if (cfg.has_temp_threshold && !(cfg.temp_threshold >= 0.0f && cfg.temp_threshold <= 85.0f)) abort();
+    if (cfg.has_max_speed && cfg.max_speed > 100) abort();
+    if (cfg.has_fan_off_temp && !(cfg.fan_off_temp >= 0.0f && cfg.fan_off_temp <= 85.0f)) abort();
+    if (cfg.has_mid_speed && cfg.mid_speed > 100) abort();
+    if (cfg.has_power_budget && !(isfinite(cfg.power_budget_w) && cfg.power_budget_w >= 0.0f)) abort();
+    if (cfg.has_fan_power_w && !(isfinite(cfg.fan_power_w) && cfg.fan_power_w > 0.0f)) abort();
+    if (cfg.has_tec_power_w && !(isfinite(cfg.tec_power_w) && cfg.tec_power_w > 0.0f)) abort();
+    if (cfg.has_fan_power_exp && !(cfg.fan_power_exp >= 0.5f && cfg.fan_power_exp <= 4.0f)) abort();
+    if (cfg.has_tec_power_exp && !(cfg.tec_power_exp >= 0.5f && cfg.tec_power_exp <= 4.0f)) abort();
+    if (cfg.has_holdover_s && cfg.holdover_s > 3600) abort();
+    if (cfg.has_failsafe_fan && (cfg.failsafe_fan < 40 || cfg.failsafe_fan > 100)) abort();
+
+    mqtt_history_request_t req;
+    mqtt_comm_parse_history_request((const char*)data, (int)size, &req);
+    mqtt_ota_request_t ota;
+    mqtt_comm_parse_ota_request((const char*)data, (int)size, &ota);
+    return 0;
+}
@@ -0,0 +1,26 @@
+#include "form_field.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief URL 解码：首字节选择输出缓冲大小，其余为编码文本
+ *        不变式：返回值为 -1 或解码长度，且与输出字符串长度一致；解码结果不含 '\0'、不会比输入长
+ */
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size < 1) return 0;
+    size_t out_size = data[0] + 1;
+    char* out = malloc(out_size);
+
+    int n = form_url_decode((const char*)data + 1, size - 1, out, out_size);
+    size_t len = strnlen(out, out_size);
+    if (len >= out_size) abort();
+    if (n < 0 ? len != 0 : (size_t)n != len || (size_t)n > size - 1) abort();
+    // 不含 %、+ 的输入应原样输出
+    if (n >= 0 && !memchr(data + 1, '%', size - 1) && !memchr(data + 1, '+', size - 1) &&
+        memcmp(out, data + 1, size - 1) != 0) {
+        abort();
+    }
+    free(out);
+    return 0;
+}
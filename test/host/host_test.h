@@ -0,0 +1,59 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief 主机单元测试的最小断言集：失败时打印位置并计数，RUN 结束后由 HOST_TEST_RESULT 返回进程状态
+ */
+
+static int host_test_failures = 0;
+static int host_test_checks = 0;
+
+#define CHECK(cond) do {                                                        \
+        host_test_checks++;                                                     \
+        if (!(cond)) {                                                          \
+            host_test_failures++;                                               \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_INT(actual, expected) do {                                        \
+        long long a_ = (long long)(actual), e_ = (long long)(expected);         \
+        host_test_checks++;                                                     \
+        if (a_ != e_) {                                                         \
+            host_test_failures++;                                               \
+            fprintf(stderr, "%s:%d: %s == %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tol) do {                                  \
+        double a_ = (double)(actual), e_ = (double)(expected);                  \
+        host_test_checks++;                                                     \
+        if (!(fabs(a_ - e_) <= (tol))) {                                        \
+            host_test_failures++;                                               \
+            fprintf(stderr, "%s:%d: %s == %g, expected %g ± %g\n", __FILE__, __LINE__, #actual, a_, e_, (double)(tol)); \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_STR(actual, expected) do {                                        \
+        const char *a_ = (actual), *e_ = (expected);                            \
+        host_test_checks++;                                                     \
+        if (a_ == NULL || strcmp(a_, e_) != 0) {                                \
+            host_test_failures++;                                               \
+            fprintf(stderr, "%s:%d: %s == \"%s\", expected \"%s\"\n", __FILE__, __LINE__, #actual, a_ ? a_ : "(null)", e_); \
+        }                                                                       \
+    } while (0)
+
+#define RUN(test) do {                                                          \
+        int before_ = host_test_failures;                                       \
+        test();                                                                 \
+        printf("%-48s %s\n", #test, host_test_failures == before_ ? "ok" : "FAILED"); \
+    } while (0)
+
+#define HOST_TEST_RESULT() \
+    (printf("%d checks, %d failures\n", host_test_checks, host_test_failures), host_test_failures ? 1 : 0)
+
+#endif // HOST_TEST_H
@@ -0,0 +1,116 @@
+#include "host_test.h"
+#include "pi_controller.h"
+#include "relay_autotune.h"
+#include <stdint.h>
+
+/**
+ * @brief 自整定仿真：一阶惯性加纯滞后（FOPDT）对象，DS18B20 0.0625°C 量化，
+ *        继电实验辨识的 Ku/Tu 与解析临界点比较，再用得到的 PI 增益做闭环阶跃，检查超调和稳态误差
+ */
+
+#define STEP_S          1u
+#define PLANT_TAU_S     300.0f      // 时间常数
+#define PLANT_DELAY_S   30u         // 纯滞后（转换延迟 + 热传导）
+#define PLANT_GAIN      0.15f       // °C / %，100% 制冷需求降温 15°C
+#define PLANT_OPEN_C    38.0f       // 0% 输出时的平衡温度
+#define SETPOINT_C      30.0f
+#define QUANT_C         0.0625f
+
+typedef struct {
+    float temp;
+    uint8_t delay_line[PLANT_DELAY_S];
+    uint32_t head;
+} plant_t;
+
+static void plant_init(plant_t* p, float temp, uint8_t u0) {
+    p->temp = temp;
+    p->head = 0;
+    memset(p->delay_line, u0, sizeof(p->delay_line));
+}
+
+static float plant_step(plant_t* p, uint8_t u) {
+    uint8_t delayed = p->delay_line[p->head];
+    p->delay_line[p->head] = u;
+    p->head = (p->head + 1) % PLANT_DELAY_S;
+    float target = PLANT_OPEN_C - PLANT_GAIN * delayed;
+    p->temp += (target - p->temp) * STEP_S / PLANT_TAU_S;
+    return roundf(p->temp / QUANT_C) * QUANT_C;
+}
+
+/**
+ * @brief FOPDT 的解析临界点：ωL + atan(ωτ) = π，Ku = sqrt(1 + (ωτ)²) / K
+ */
+static void analytic_ultimate(float* ku, float* tu_s) {
+    double lo = 1e-4, hi = 3.14159265 / PLANT_DELAY_S;
+    for (int i = 0; i < 100; i++) {
+        double w = (lo + hi) / 2;
+        if (w * PLANT_DELAY_S + atan(w * PLANT_TAU_S) < 3.14159265) lo = w; else hi = w;
+    }
+    *ku = (float)(sqrt(1.0 + lo * PLANT_TAU_S * lo * PLANT_TAU_S) / PLANT_GAIN);
+    *tu_s = (float)(2 * 3.14159265 / lo);
+}
+
+static relay_autotune_t s_tune;
+
+static void sim_relay_identifies_plant(void) {
+    autotune_config_t cfg;
+    relay_autotune_default_config(&cfg, SETPOINT_C);
+    plant_t plant;
+    plant_init(&plant, SETPOINT_C, 53);
+    relay_autotune_start(&s_tune, &cfg, 1000);
+
+    float temp = plant.temp;
+    uint32_t now = 1000;
+    while (s_tune.phase == AUTOTUNE_RELAY) {
+        uint8_t u = relay_autotune_step(&s_tune, temp, now);
+        temp = plant_step(&plant, u);
+        now += STEP_S * 1000;
+    }
+    CHECK_INT(s_tune.phase, AUTOTUNE_DONE);
+
+    float ku, tu_s;
+    analytic_ultimate(&ku, &tu_s);
+    // 描述函数法是一次谐波近似：滞后占优的对象上 Ku 偏低、滞环使 Tu 偏长，
+    // 两者都让整定结果偏保守；偏差超过下列范围说明辨识逻辑有误
+    CHECK(s_tune.ku / ku > 0.5f && s_tune.ku / ku < 1.1f);
+    CHECK(s_tune.tu_s / tu_s > 0.9f && s_tune.tu_s / tu_s < 1.5f);
+    printf("  relay: Ku %.1f (analytic %.1f), Tu %.0f s (analytic %.0f s), %u s\n",
+           s_tune.ku, ku, s_tune.tu_s, tu_s, (unsigned)(now - 1000) / 1000);
+}
+
+static void sim_closed_loop_step(void) {
+    float kp, ki;
+    CHECK(relay_autotune_pi_gains(&s_tune, &kp, &ki));
+    pi_controller_t pi;
+    pi_controller_init(&pi, kp, ki);
+
+    // 从 0% 输出的平衡态开始（已被冷端热负载加热），设定值阶跃到 30°C
+    plant_t plant;
+    plant_init(&plant, PLANT_OPEN_C, 0);
+    float temp = plant.temp;
+    float out = 0.0f;
+    float undershoot = 0.0f;
+    float settled_err = 0.0f;
+    const uint32_t duration_s = 4 * 3600;
+    for (uint32_t t = 0; t < duration_s; t += STEP_S) {
+        out = pi_controller_update(&pi, SETPOINT_C, temp, STEP_S, out, 100.0f);
+        temp = plant_step(&plant, (uint8_t)lroundf(out));
+        float below = SETPOINT_C - plant.temp;
+        if (below > undershoot) undershoot = below;
+        if (t >= duration_s - 1800) {
+            float err = fabsf(plant.temp - SETPOINT_C);
+            if (err > settled_err) settled_err = err;
+        }
+    }
+    // Tyreus–Luyben 偏保守：过冲小、最后半小时稳定在量化精度附近
+    CHECK(undershoot < 1.0f);
+    CHECK(settled_err < 0.15f);
+    CHECK_NEAR(out, (PLANT_OPEN_C - SETPOINT_C) / PLANT_GAIN, 3.0);
+    printf("  PI Kp %.2f Ki %.4f: undershoot %.2f°C, settled ±%.3f°C\n", kp, ki, undershoot, settled_err);
+}
+
+int main(void) {
+    RUN(sim_relay_identifies_plant);
+    RUN(sim_closed_loop_step);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,137 @@
+#include "host_test.h"
+#include "sensor_fault.h"
+#include <math.h>
+#include <stdint.h>
+
+/**
+ * @brief 传感器故障仿真：冷端对象在比例控制下闭环运行六小时，读数按 DS18B20 量化，
+ *        依次经过恒温空闲、制冷片周期启停、读数冻结、短/长掉线和偶发 CRC 错误，
+ *        每个 1 s 步长检查：恒温空闲不判卡滞、注入的卡滞在时限内确认、确认时不回溯超过外推时限、
+ *        失效安全时风扇不低于下限且制冷片关闭、故障结束后恢复正常
+ */
+
+#define STEP_MS         1000u
+#define SIM_MS          (6u * 3600u * 1000u)
+#define AMBIENT_C       25.0f
+#define LOAD_W          4.0f
+#define TAU_S           300.0f      // 冷端对象时间常数
+#define TEC_PERIOD_MS   600000u     // 制冷片启停周期（独立于温度的激励变化来源）
+#define HOLDOVER_MS     120000u
+
+// 注入的故障窗口
+#define IDLE_END_MS     (2u * 3600u * 1000u)            // 之前制冷片关闭，对象稳定后读数长时间不变
+#define STUCK_FROM_MS   (2u * 3600u * 1000u + 1800000u)
+#define STUCK_TO_MS     (STUCK_FROM_MS + 1200000u)
+#define SHORT_FROM_MS   (4u * 3600u * 1000u)
+#define SHORT_TO_MS     (SHORT_FROM_MS + 60000u)        // 短于外推时限
+#define LONG_FROM_MS    (4u * 3600u * 1000u + 1800000u)
+#define LONG_TO_MS      (LONG_FROM_MS + 600000u)
+#define TEC_END_MS      (5u * 3600u * 1000u)            // 之后再次空闲
+
+static float plant_target(uint8_t fan, uint8_t tec) {
+    float r = 0.5f + 1.5f * (1.0f - fan / 100.0f);
+    return AMBIENT_C + LOAD_W * r - 8.0f * tec / 100.0f;
+}
+
+static uint8_t fan_for(float temp_c) {
+    float fan = (temp_c - 34.0f) * 25.0f;               // 空闲时对象稳定在 33°C，风扇停转
+    return (uint8_t)(fan < 0.0f ? 0.0f : fan > 100.0f ? 100.0f : fan);
+}
+
+static void sim_sensor_faults(void) {
+    sensor_fault_t sf;
+    sensor_fault_init(&sf, HOLDOVER_MS, 10);    // 配置的失效安全占空比低于下限
+    float plant_c = AMBIENT_C + 6.0f;
+    float control_c = plant_c;
+    float frozen_c = NAN;
+    uint8_t fan = 0, tec = 0;
+    int violations = 0;
+    uint32_t stuck_confirmed_ms = 0;
+    uint32_t failsafe_steps = 0, holdover_steps = 0, idle_same_ms = 0, same_since_ms = 0;
+    float last_reading = NAN;
+    sensor_state_t prev = SENSOR_STATE_OK;
+
+    for (uint32_t now = 1000; now < SIM_MS; now += STEP_MS) {
+        float reading = roundf(plant_c * 16.0f) / 16.0f;
+        sensor_read_t read = SENSOR_READ_OK;
+        if (now >= STUCK_FROM_MS && now < STUCK_TO_MS) {
+            if (isnan(frozen_c)) frozen_c = reading;
+            reading = frozen_c;
+        }
+        if ((now >= SHORT_FROM_MS && now < SHORT_TO_MS) || (now >= LONG_FROM_MS && now < LONG_TO_MS)) {
+            read = SENSOR_READ_NO_DEVICE;
+        } else if (now % 97000u < STEP_MS) {
+            read = SENSOR_READ_CRC_ERROR;       // 偶发单次错误
+        }
+
+        unsigned drive = fan + tec;
+        bool trusted = sensor_fault_update(&sf, read, reading, (uint8_t)(drive > UINT8_MAX ? UINT8_MAX : drive), now);
+        if (trusted) control_c = reading;
+
+        // 恒温空闲期间读数逐位不变的最长时长（检验仿真确实覆盖了长判据）
+        if (read == SENSOR_READ_OK) {
+            if (reading != last_reading) same_since_ms = now;
+            if (now < IDLE_END_MS && now - same_since_ms > idle_same_ms) idle_same_ms = now - same_since_ms;
+            last_reading = reading;
+        }
+
+        // 1. 卡滞只在注入的冻结窗口内确认，且在激励摆动后的判据时限内
+        if (sf.fault == SENSOR_FAULT_STUCK && sf.state != SENSOR_STATE_OK && prev == SENSOR_STATE_OK) {
+            if (now < STUCK_FROM_MS || now >= STUCK_TO_MS) violations++;
+            stuck_confirmed_ms = now;
+        }
+        // 2. 确认故障时最后可信时刻不早于一个外推时限之前
+        if (prev == SENSOR_STATE_OK && sf.state != SENSOR_STATE_OK && now - sf.last_good_ms > HOLDOVER_MS) {
+            violations++;
+        }
+        // 3. 短掉线只外推，长掉线在外推时限后进入失效安全
+        if (now >= SHORT_FROM_MS && now < SHORT_TO_MS && sf.state == SENSOR_STATE_FAILSAFE) violations++;
+        if (now >= LONG_FROM_MS + HOLDOVER_MS + 3 * STEP_MS && now < LONG_TO_MS &&
+            sf.state != SENSOR_STATE_FAILSAFE) {
+            violations++;
+        }
+        // 4. 故障结束后 CLEAR 次读数内恢复
+        if (((now >= STUCK_TO_MS + 4 * STEP_MS && now < SHORT_FROM_MS) ||
+             (now >= LONG_TO_MS + 4 * STEP_MS && now < LONG_TO_MS + 90000u)) &&
+            sf.state != SENSOR_STATE_OK && now % 97000u >= 4 * STEP_MS) {
+            violations++;
+        }
+
+        // 控制：失效安全固定风扇、制冷片关闭；外推期间用限幅后的最后可信值
+        if (sf.state == SENSOR_STATE_FAILSAFE) {
+            fan = sf.failsafe_fan;
+            tec = 0;
+            failsafe_steps++;
+        } else {
+            float temp_c = sensor_fault_bound(&sf, control_c);
+            fan = fan_for(temp_c);
+            tec = now >= IDLE_END_MS && now < TEC_END_MS && now % TEC_PERIOD_MS < TEC_PERIOD_MS / 2 ? 60 : 0;
+            if (tec > 0 && fan < 40) fan = 40;
+            holdover_steps += sf.state == SENSOR_STATE_HOLDOVER;
+        }
+        // 5. 失效安全输出
+        if (sf.state == SENSOR_STATE_FAILSAFE && (fan < SENSOR_FAULT_FAILSAFE_FAN_MIN || tec != 0)) violations++;
+
+        prev = sf.state;
+        plant_c += (plant_target(fan, tec) - plant_c) * (STEP_MS / 1000.0f) / TAU_S;
+    }
+
+    CHECK_INT(violations, 0);
+    CHECK_INT(sf.failsafe_fan, SENSOR_FAULT_FAILSAFE_FAN_MIN);
+    CHECK_INT(sf.faults[SENSOR_FAULT_STUCK], 1);
+    CHECK(stuck_confirmed_ms >= STUCK_FROM_MS && stuck_confirmed_ms <= STUCK_FROM_MS + SENSOR_FAULT_STUCK_MS + TEC_PERIOD_MS);
+    CHECK_INT(sf.faults[SENSOR_FAULT_MISSING], 2);
+    CHECK_INT(sf.faults[SENSOR_FAULT_CRC], 0);
+    CHECK(idle_same_ms > SENSOR_FAULT_STUCK_IDLE_MS);           // 空闲段确实超过了长判据时长
+    CHECK(sf.failsafe_entries >= 2);                            // 卡滞与长掉线
+    CHECK(holdover_steps > 0);
+    CHECK_INT(sf.state, SENSOR_STATE_OK);
+    printf("  stuck at +%us, idle constant %us, failsafe %us, holdover %us\n",
+           (unsigned)((stuck_confirmed_ms - STUCK_FROM_MS) / 1000), (unsigned)(idle_same_ms / 1000),
+           (unsigned)(failsafe_steps * STEP_MS / 1000), (unsigned)(holdover_steps * STEP_MS / 1000));
+}
+
+int main(void) {
+    RUN(sim_sensor_faults);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,136 @@
+#include "host_test.h"
+#include "cooling_supervisor.h"
+#include <stdint.h>
+
+/**
+ * @brief 联锁仿真：简化热端散热器/冷端对象模型在闭环中运行两小时，
+ *        随机请求（含明显违反联锁的组合）、热端传感器故障窗口、散热器积灰时段和功率预算变化，
+ *        每个 100 ms 步长检查监督器输出满足全部联锁约束
+ */
+
+#define STEP_MS         100u
+#define SIM_MS          (2u * 3600u * 1000u)
+#define AMBIENT_C       25.0f
+#define HOT_CAP_J_PER_K 150.0f      // 热端散热器热容
+#define COLD_CAP_J_PER_K 400.0f     // 冷端对象热容
+#define COLD_LOAD_W     12.0f       // 冷端热负载
+#define COLD_R_K_PER_W  2.0f        // 冷端对环境热阻
+#define CLOGGED_R_SCALE 3.0f        // 积灰时段散热器热阻放大倍数，使热端能达到切断温度
+
+static uint32_t s_rng = 12345;
+
+static uint32_t rnd(uint32_t n) {
+    s_rng = s_rng * 1103515245u + 12345u;
+    return (s_rng >> 16) % n;
+}
+
+typedef struct {
+    float hot_c;
+    float cold_c;
+} plant_t;
+
+static void plant_step(plant_t* p, const cooling_model_t* m, cooling_output_t out, bool clogged, float dt_s) {
+    float x = out.fan / 100.0f;
+    float u = out.tec / 100.0f;
+    float r = m->heatsink_r_full + (m->heatsink_r_still - m->heatsink_r_full) * (1.0f - x) * (1.0f - x);
+    if (clogged) r *= CLOGGED_R_SCALE;
+    float eff = 1.0f - (p->hot_c - p->cold_c) / m->tec_delta_t_max;
+    float q_tec = u * m->tec_cooling_max * (eff > 0.0f ? eff : 0.0f);
+    float p_tec = cooling_model_tec_power(m, out.tec);
+    p->hot_c += dt_s * (q_tec + p_tec - (p->hot_c - AMBIENT_C) / r) / HOT_CAP_J_PER_K;
+    float q_fan = m->fan_cooling_max * powf(x, 0.8f) * (p->cold_c - AMBIENT_C) / 10.0f;
+    p->cold_c += dt_s * (COLD_LOAD_W - q_tec - q_fan - (p->cold_c - AMBIENT_C) / COLD_R_K_PER_W) / COLD_CAP_J_PER_K;
+}
+
+static void sim_interlocks(void) {
+    cooling_supervisor_t sup;
+    cooling_model_t model;
+    cooling_model_default(&model);
+    cooling_supervisor_init(&sup, &model);
+    plant_t plant = { AMBIENT_C, AMBIENT_C };
+
+    cooling_output_t request = { 0, 0 };
+    uint32_t next_request_ms = 0;
+    uint32_t fault_until_ms = 0;
+    uint32_t fan_min_since_ms = 0;
+    bool fan_at_min = false;
+    bool was_tec = false;
+    uint32_t tec_off_ms = 0;
+    bool locked = false;
+    int violations = 0;
+    uint32_t tec_on_steps = 0, fault_steps = 0, budget_steps = 0;
+    float hot_max = AMBIENT_C;
+
+    for (uint32_t now = 1000; now < SIM_MS; now += STEP_MS) {
+        if (now >= next_request_ms) {
+            switch (rnd(4)) {
+            case 0:  request = (cooling_output_t){ (uint8_t)rnd(101), (uint8_t)rnd(101) }; break;
+            case 1:  request = (cooling_output_t){ (uint8_t)rnd(20), (uint8_t)(50 + rnd(51)) }; break;
+            case 2:  request = (cooling_output_t){ 0, 0 }; break;
+            default: request = cooling_supervisor_optimize(&sup, (uint8_t)rnd(101)); break;
+            }
+            if (rnd(10) == 0) cooling_supervisor_set_budget(&sup, rnd(3) ? 0.0f : (float)(10 + rnd(50)));
+            if (rnd(25) == 0) fault_until_ms = now + 1000 + rnd(20000);
+            next_request_ms = now + 500 + rnd(20000);
+        }
+        bool fault = now < fault_until_ms;
+        float hot = fault ? SUPERVISOR_HOT_FAULT : roundf(plant.hot_c * 16.0f) / 16.0f;
+        if (!fault && hot >= SUPERVISOR_HOT_CUTOFF_C) locked = true;
+        if (!fault && hot <= SUPERVISOR_HOT_RESUME_C) locked = false;
+
+        cooling_output_t out = cooling_supervisor_step(&sup, request, plant.cold_c, hot, now);
+
+        // 1. 制冷片开启时风扇已在最低占空比以上持续 SPINUP
+        if (out.tec > 0 && (out.fan < SUPERVISOR_FAN_MIN_WITH_TEC || !fan_at_min ||
+                            now - fan_min_since_ms < SUPERVISOR_FAN_SPINUP_MS)) {
+            violations++;
+        }
+        // 2. 制冷片关闭后续转
+        if (was_tec && out.tec == 0) tec_off_ms = now;
+        if (out.tec == 0 && tec_off_ms && now - tec_off_ms < SUPERVISOR_FAN_RUNON_MS &&
+            out.fan < SUPERVISOR_FAN_MIN_WITH_TEC) {
+            violations++;
+        }
+        // 3. 过温锁定：制冷片关闭、风扇满速
+        if (locked != sup.overtemp || (locked && (out.tec != 0 || out.fan != 100))) violations++;
+        // 4. 热端读数错误时制冷片关闭
+        if (fault && out.tec != 0) violations++;
+        // 5. 功率预算：超出时只能是联锁要求的风扇
+        if (sup.power_budget_w > 0.0f) {
+            budget_steps++;
+            float power = cooling_supervisor_estimate(&sup, out, NULL);
+            if (power > sup.power_budget_w + 1e-3f &&
+                !(out.tec == 0 && (out.fan == SUPERVISOR_FAN_MIN_WITH_TEC || (locked && out.fan == 100)))) {
+                violations++;
+            }
+        }
+
+        if (out.fan >= SUPERVISOR_FAN_MIN_WITH_TEC) {
+            if (!fan_at_min) fan_min_since_ms = now;
+            fan_at_min = true;
+        } else {
+            fan_at_min = false;
+        }
+        was_tec = out.tec > 0;
+        tec_on_steps += out.tec > 0;
+        fault_steps += fault;
+        bool clogged = now % (40u * 60u * 1000u) >= 25u * 60u * 1000u;
+        plant_step(&plant, &model, out, clogged, STEP_MS / 1000.0f);
+        if (plant.hot_c > hot_max) hot_max = plant.hot_c;
+    }
+
+    CHECK_INT(violations, 0);
+    CHECK(hot_max < SUPERVISOR_HOT_CUTOFF_C + 5.0f);   // 切断后热端只有热惯性带来的小过冲
+    // 仿真确实覆盖了各条路径
+    CHECK(sup.overtemp_trips > 0);
+    CHECK(tec_on_steps > SIM_MS / STEP_MS / 10);
+    CHECK(fault_steps > 0);
+    CHECK(budget_steps > 0);
+    printf("  %u trips, tec on %.0f%%, hot max %.1f°C\n", (unsigned)sup.overtemp_trips,
+           100.0 * tec_on_steps / (SIM_MS / STEP_MS), hot_max);
+}
+
+int main(void) {
+    RUN(sim_interlocks);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,67 @@
+#include "power_mgmt.h"
+#include "mqtt_tls.h"
+#include "host_stubs.h"
+#include <string.h>
+
+/**
+ * @brief 依赖 ESP-IDF 驱动的组件接口桩：power_mgmt（esp_pm/esp_wifi）和 mqtt_tls（esp-tls/mbedTLS）
+ *        只实现 mqtt_comm 与 oled_display 在主机上链接所需的部分
+ */
+
+void power_mgmt_acquire(pm_lock_id_t id) {
+    (void)id;
+}
+
+void power_mgmt_release(pm_lock_id_t id) {
+    (void)id;
+}
+
+int power_mgmt_align_keepalive(int keepalive_s, int listen_interval) {
+    (void)listen_interval;
+    return keepalive_s;
+}
+
+void power_mgmt_get_stats(pm_accounting_t* stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+static struct esp_transport_item_t* s_transport;
+
+esp_transport_handle_t mqtt_tls_init(void) {
+    return s_transport;
+}
+
+void mqtt_tls_use(esp_transport_handle_t transport, bool tls) {
+    (void)transport;
+    (void)tls;
+}
+
+bool mqtt_tls_set_ca(const char* pem) {
+    return pem[0] == '\0' || strncmp(pem, "-----BEGIN CERTIFICATE-----", 27) == 0;
+}
+
+bool mqtt_tls_set_pin(const char* hex) {
+    return hex[0] == '\0' || strlen(hex) == MQTT_TLS_PIN_HEX;
+}
+
+void mqtt_tls_get_stats(mqtt_tls_stats_t* stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+static bool s_probe_ok = true;
+static int s_probes;
+
+void host_tls_probe_result(bool ok) {
+    s_probe_ok = ok;
+}
+
+int host_tls_probes(void) {
+    return s_probes;
+}
+
+bool mqtt_tls_probe(const char* uri, int timeout_ms) {
+    (void)uri;
+    (void)timeout_ms;
+    s_probes++;
+    return s_probe_ok;
+}
@@ -0,0 +1,35 @@
+#ifndef DRIVER_I2C_H
+#define DRIVER_I2C_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+// 主机测试桩：旧版 I2C 主机驱动的子集，写入交给 idf_stubs.c 中的 SSD1306 模型
+
+typedef int i2c_port_t;
+typedef int gpio_num_t;
+
+typedef enum { I2C_MODE_SLAVE = 0, I2C_MODE_MASTER } i2c_mode_t;
+#define GPIO_PULLUP_DISABLE 0
+#define GPIO_PULLUP_ENABLE  1
+
+typedef struct {
+    i2c_mode_t mode;
+    int sda_io_num;
+    int scl_io_num;
+    int sda_pullup_en;
+    int scl_pullup_en;
+    struct {
+        uint32_t clk_speed;
+    } master;
+} i2c_config_t;
+
+esp_err_t i2c_param_config(i2c_port_t i2c_num, const i2c_config_t* conf);
+esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode, size_t slv_rx_buf_len, size_t slv_tx_buf_len,
+                             int intr_alloc_flags);
+esp_err_t i2c_master_write_to_device(i2c_port_t i2c_num, uint8_t device_address, const uint8_t* write_buffer,
+                                     size_t write_size, TickType_t ticks_to_wait);
+
+#endif // DRIVER_I2C_H
@@ -0,0 +1,15 @@
+#ifndef ESP_MAC_H
+#define ESP_MAC_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+    ESP_MAC_WIFI_STA,
+    ESP_MAC_WIFI_SOFTAP,
+} esp_mac_type_t;
+
+// 主机测试桩：固定返回 24:0a:c4:00:00:01
+esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t type);
+
+#endif // ESP_MAC_H
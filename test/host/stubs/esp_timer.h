@@ -0,0 +1,10 @@
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdint.h>
+
+// 主机测试桩：时间由测试通过 host_time_set_us()/host_time_advance_us() 推进
+
+int64_t esp_timer_get_time(void);
+
+#endif // ESP_TIMER_H
@@ -0,0 +1,7 @@
+#ifndef ESP_TRANSPORT_H
+#define ESP_TRANSPORT_H
+
+// 主机测试桩：传输句柄只作为不透明指针传递
+typedef struct esp_transport_item_t* esp_transport_handle_t;
+
+#endif // ESP_TRANSPORT_H
@@ -0,0 +1,32 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+
+// 主机测试桩：单线程执行，临界区与互斥量均为空操作（只校验配对）
+
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE          1
+#define pdFALSE         0
+#define pdPASS          pdTRUE
+#define pdFAIL          pdFALSE
+#define portMAX_DELAY   ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS 10
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms) / portTICK_PERIOD_MS)
+
+typedef struct {
+    int depth;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+
+void host_critical_enter(portMUX_TYPE* mux);
+void host_critical_exit(portMUX_TYPE* mux);
+
+#define portENTER_CRITICAL(mux) host_critical_enter(mux)
+#define portEXIT_CRITICAL(mux)  host_critical_exit(mux)
+
+#endif // FREERTOS_H
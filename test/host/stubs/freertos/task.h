@@ -0,0 +1,20 @@
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_task* TaskHandle_t;
+
+// 主机测试桩：固定返回同一个任务句柄
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+typedef void (*TaskFunction_t)(void*);
+
+// 主机测试桩：新任务在创建时同步运行到 vTaskDelete(NULL) 返回
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack_bytes, void* arg,
+                                   UBaseType_t prio, TaskHandle_t* handle, BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+// 主机测试桩：没有栈可测，返回 0
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+#endif // FREERTOS_TASK_H
@@ -0,0 +1,15 @@
+#ifndef HOST_COMPAT_H
+#define HOST_COMPAT_H
+
+/**
+ * @brief 主机编译兼容层（由 CMake 以 -include 强制包含）
+ *        newlib 提供的 BSD 扩展在旧版 glibc 上缺失时由 idf_stubs.c 补齐
+ */
+
+#include <stddef.h>
+
+#ifndef HOST_HAVE_STRLCPY
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+#endif // HOST_COMPAT_H
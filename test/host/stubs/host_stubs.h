@@ -0,0 +1,116 @@
+#ifndef HOST_STUBS_H
+#define HOST_STUBS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_http_server.h"
+#include "mqtt_client.h"
+
+/**
+ * @brief 主机测试桩的控制接口：推进时间、清空 NVS、检查发布记录、注入 MQTT 事件、读取显示屏显存、模拟 HTTP/WebSocket 客户端
+ */
+
+// 时间（esp_timer_get_time 的返回值）
+void host_time_set_us(int64_t now_us);
+void host_time_advance_ms(uint32_t ms);
+
+// esp_read_mac 返回的 STA 地址（SoftAP 为其末字节加一），决定 mqtt_comm 的设备ID
+void host_mac_set(const uint8_t mac[6]);
+
+// NVS：清空全部命名空间
+void host_nvs_reset(void);
+
+// MQTT 发布记录
+#define HOST_MQTT_TOPIC_MAX 128
+#define HOST_MQTT_DATA_MAX  2048
+#define HOST_MQTT_LOG       64      // 保留最近的发布条数
+
+typedef struct {
+    char topic[HOST_MQTT_TOPIC_MAX];
+    char data[HOST_MQTT_DATA_MAX];  // 以 '\0' 结尾
+    int len;
+    int qos;
+    int retain;
+    int msg_id;                     // QoS0 时为 0
+} host_mqtt_msg_t;
+
+typedef struct {
+    uint32_t published;             // 成功的发布调用
+    uint32_t subscribed;
+    uint32_t disconnects;
+    uint32_t reconnects;
+    uint32_t set_configs;
+} host_mqtt_counts_t;
+
+void host_mqtt_reset(void);
+// 之后的发布调用全部失败（返回 -1），模拟出队列满或客户端未连接
+void host_mqtt_fail_publish(bool fail);
+int host_mqtt_count(void);
+const host_mqtt_msg_t* host_mqtt_msg(int index);
+// 主题以 suffix 结尾的最近一条发布，没有时返回 NULL
+const host_mqtt_msg_t* host_mqtt_last(const char* suffix);
+// 主题以 suffix 结尾的发布条数
+int host_mqtt_count_topic(const char* suffix);
+host_mqtt_counts_t host_mqtt_counts(void);
+const esp_mqtt_client_config_t* host_mqtt_config(void);
+
+// 以客户端身份调用注册的事件处理函数
+void host_mqtt_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t id, int msg_id);
+// 下一次从事件回调之外的发布：记录消息后、返回调用方前，以客户端身份执行一次事件回调，
+// 模拟 MQTT 任务持客户端锁处理事件时发布方正在等锁；msg_id 为 0 时取这次发布的消息 ID
+void host_mqtt_contend(esp_mqtt_event_id_t id, int msg_id);
+void host_mqtt_deliver(esp_mqtt_client_handle_t client, const char* topic, const char* data, int len);
+
+// I2C 上的 SSD1306 模型：显存按页存放，每页 HOST_SSD1306_WIDTH 字节
+#define HOST_SSD1306_WIDTH 128
+#define HOST_SSD1306_PAGES 8
+const uint8_t* host_ssd1306_ram(void);
+
+// mqtt_tls_probe（component_stubs.c）：设置之后探测的结果，返回已探测次数
+void host_tls_probe_result(bool ok);
+int host_tls_probes(void);
+
+// HTTP 服务：请求同步调用注册的处理函数；httpd_queue_work 入队，由 host_httpd_run_work 在“服务任务”中执行
+#define HOST_HTTPD_MAX_FDS  16
+#define HOST_HTTPD_BODY_MAX 1024
+
+typedef struct {
+    int status;                         // 200 或 httpd_resp_send_err 对应的状态码
+    char body[HOST_HTTPD_BODY_MAX];     // 以 '\0' 结尾
+    char www_authenticate[32];
+} host_http_resp_t;
+
+typedef struct {
+    bool open;
+    bool websocket;
+    uint32_t frames;                    // 收到的推送帧数
+    uint64_t bytes;
+    const uint8_t* last_payload;        // 最近一帧的发送缓冲地址（检查是否共享同一帧）
+    char last[256];                     // 最近一帧内容，以 '\0' 结尾
+} host_ws_client_t;
+
+typedef struct {
+    uint32_t ws_sends;          // httpd_ws_send_frame_async 调用次数
+    uint32_t queued_work;
+    uint32_t queue_full;
+} host_httpd_counts_t;
+
+void host_httpd_reset(void);
+// 以 fd 发起一次 HTTP 请求；uri 可带查询串，auth 为 Authorization 请求头（NULL 表示不带）
+esp_err_t host_httpd_request(int fd, httpd_method_t method, const char* uri, const char* auth,
+                             const char* body, host_http_resp_t* resp);
+// 连接数受 httpd_config_t.max_open_sockets 限制，超出时拒绝连接（请求返回 ESP_ERR_NO_MEM）
+// 保持打开的普通 HTTP 连接（出现在客户端列表中，但不是 WebSocket）
+bool host_httpd_open_http(int fd);
+// WebSocket 握手；被拒绝或处理函数返回失败时连接被关闭，返回 false
+bool host_httpd_ws_open(int fd, const char* uri, const char* auth);
+esp_err_t host_httpd_ws_text(int fd, const char* text);
+void host_httpd_close(int fd);
+// 执行全部已排队的工作，返回执行个数
+int host_httpd_run_work(void);
+// 限制工作队列长度，模拟 httpd 控制队列满；0 表示不限
+void host_httpd_work_limit(int limit);
+const host_ws_client_t* host_httpd_client(int fd);
+host_httpd_counts_t host_httpd_counts(void);
+
+#endif // HOST_STUBS_H
@@ -0,0 +1,310 @@
+#include "host_stubs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define HOST_HTTPD_MAX_URIS 16
+#define HOST_HTTPD_MAX_WORK 64
+
+typedef struct {
+    int fd;
+    const char* query;                  // 不含 '?'，NULL 表示没有
+    const char* auth;
+    const char* body;
+    size_t body_off;
+    const char* ws_text;                // WebSocket 数据帧内容
+    host_http_resp_t* resp;
+} host_req_ctx_t;
+
+typedef struct {
+    httpd_work_fn_t fn;
+    void* arg;
+} host_work_t;
+
+static int s_server_token;              // httpd_handle_t 指向它
+static bool s_started = false;
+static int s_max_open = 0;
+static httpd_uri_t s_uris[HOST_HTTPD_MAX_URIS];
+static char s_uri_paths[HOST_HTTPD_MAX_URIS][64];
+static int s_uri_count = 0;
+static host_ws_client_t s_clients[HOST_HTTPD_MAX_FDS];
+static host_work_t s_work[HOST_HTTPD_MAX_WORK];
+static int s_work_count = 0;
+static int s_work_limit = 0;
+static host_httpd_counts_t s_httpd_counts;
+
+void host_httpd_reset(void) {
+    memset(s_clients, 0, sizeof(s_clients));
+    s_work_count = 0;
+    s_work_limit = 0;
+    memset(&s_httpd_counts, 0, sizeof(s_httpd_counts));
+}
+
+static int open_count(void) {
+    int n = 0;
+    for (int fd = 0; fd < HOST_HTTPD_MAX_FDS; fd++) n += s_clients[fd].open;
+    return n;
+}
+
+static host_ws_client_t* client(int fd) {
+    if (fd < 0 || fd >= HOST_HTTPD_MAX_FDS) {
+        fprintf(stderr, "host httpd: fd %d out of range\n", fd);
+        abort();
+    }
+    return &s_clients[fd];
+}
+
+/**
+ * @brief 建立连接，超过 max_open_sockets 时拒绝（不模拟 LRU 淘汰）
+ */
+static bool accept_fd(int fd) {
+    host_ws_client_t* c = client(fd);
+    if (c->open) return true;
+    if (open_count() >= s_max_open) return false;
+    c->open = true;
+    return true;
+}
+
+esp_err_t httpd_start(httpd_handle_t* handle, const httpd_config_t* config) {
+    if (config->max_open_sockets > HOST_HTTPD_MAX_FDS) return ESP_ERR_INVALID_ARG;
+    s_started = true;
+    s_max_open = config->max_open_sockets;
+    s_uri_count = 0;
+    *handle = &s_server_token;
+    return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t* uri_handler) {
+    if (handle != &s_server_token || s_uri_count >= HOST_HTTPD_MAX_URIS) return ESP_FAIL;
+    // 调用者的 httpd_uri_t 可能在栈上，按 IDF 的做法复制 URI 字符串
+    strlcpy(s_uri_paths[s_uri_count], uri_handler->uri, sizeof(s_uri_paths[0]));
+    s_uris[s_uri_count] = *uri_handler;
+    s_uris[s_uri_count].uri = s_uri_paths[s_uri_count];
+    s_uri_count++;
+    return ESP_OK;
+}
+
+static const httpd_uri_t* find_uri(const char* path, size_t len, httpd_method_t method) {
+    for (int i = 0; i < s_uri_count; i++) {
+        if (s_uris[i].method == method && strlen(s_uris[i].uri) == len && memcmp(s_uris[i].uri, path, len) == 0) {
+            return &s_uris[i];
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t dispatch(int fd, httpd_method_t method, const char* uri, const char* auth, const char* body,
+                          const char* ws_text, host_http_resp_t* resp, bool* is_ws) {
+    if (!s_started) return ESP_ERR_INVALID_STATE;
+    const char* q = strchr(uri, '?');
+    size_t path_len = q ? (size_t)(q - uri) : strlen(uri);
+    // WebSocket 数据帧按握手时的 GET 处理函数分派
+    const httpd_uri_t* h = find_uri(uri, path_len, ws_text ? HTTP_GET : method);
+    if (!h) return ESP_ERR_NOT_FOUND;
+    if (is_ws) *is_ws = h->is_websocket;
+
+    host_req_ctx_t ctx = {
+        .fd = fd, .query = q ? q + 1 : NULL, .auth = auth, .body = body, .ws_text = ws_text, .resp = resp,
+    };
+    httpd_req_t req = {
+        .handle = &s_server_token,
+        .method = ws_text ? 0 : method,
+        .content_len = body ? strlen(body) : 0,
+        .aux = &ctx,
+        .user_ctx = h->user_ctx,
+    };
+    strlcpy(req.uri, uri, sizeof(req.uri));
+    if (resp) {
+        memset(resp, 0, sizeof(*resp));
+        resp->status = 200;
+    }
+    if (!accept_fd(fd)) return ESP_ERR_NO_MEM;
+    return h->handler(&req);
+}
+
+esp_err_t host_httpd_request(int fd, httpd_method_t method, const char* uri, const char* auth,
+                             const char* body, host_http_resp_t* resp) {
+    return dispatch(fd, method, uri, auth, body, NULL, resp, NULL);
+}
+
+bool host_httpd_open_http(int fd) {
+    return accept_fd(fd);
+}
+
+bool host_httpd_ws_open(int fd, const char* uri, const char* auth) {
+    bool is_ws = false;
+    host_http_resp_t resp;
+    bool was_open = client(fd)->open;
+    esp_err_t err = dispatch(fd, HTTP_GET, uri, auth, NULL, NULL, &resp, &is_ws);
+    if (err != ESP_OK || !is_ws) {
+        if (err != ESP_ERR_NO_MEM || !was_open) host_httpd_close(fd);
+        return false;
+    }
+    client(fd)->websocket = true;
+    return true;
+}
+
+esp_err_t host_httpd_ws_text(int fd, const char* text) {
+    if (!client(fd)->websocket) return ESP_ERR_INVALID_STATE;
+    return dispatch(fd, HTTP_GET, "/ws", NULL, NULL, text, NULL, NULL);
+}
+
+void host_httpd_close(int fd) {
+    memset(client(fd), 0, sizeof(host_ws_client_t));
+}
+
+int host_httpd_run_work(void) {
+    int ran = 0;
+    // 工作函数可能再次排队，逐个取出执行
+    while (s_work_count > 0) {
+        host_work_t w = s_work[0];
+        memmove(s_work, s_work + 1, (size_t)(--s_work_count) * sizeof(s_work[0]));
+        w.fn(w.arg);
+        ran++;
+    }
+    return ran;
+}
+
+void host_httpd_work_limit(int limit) {
+    s_work_limit = limit;
+}
+
+const host_ws_client_t* host_httpd_client(int fd) {
+    return client(fd);
+}
+
+host_httpd_counts_t host_httpd_counts(void) {
+    return s_httpd_counts;
+}
+
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void* arg) {
+    int limit = s_work_limit > 0 ? s_work_limit : HOST_HTTPD_MAX_WORK;
+    if (handle != &s_server_token || s_work_count >= limit) {
+        s_httpd_counts.queue_full++;
+        return ESP_FAIL;
+    }
+    s_work[s_work_count++] = (host_work_t){ work, arg };
+    s_httpd_counts.queued_work++;
+    return ESP_OK;
+}
+
+esp_err_t httpd_get_client_list(httpd_handle_t handle, size_t* fds, int* client_fds) {
+    size_t n = 0;
+    for (int fd = 0; fd < HOST_HTTPD_MAX_FDS; fd++) {
+        if (!s_clients[fd].open) continue;
+        if (n >= *fds) return ESP_ERR_INVALID_ARG;
+        client_fds[n++] = fd;
+    }
+    *fds = n;
+    return ESP_OK;
+}
+
+httpd_ws_client_info_t httpd_ws_get_fd_info(httpd_handle_t hd, int fd) {
+    if (fd < 0 || fd >= HOST_HTTPD_MAX_FDS || !s_clients[fd].open) return HTTPD_WS_CLIENT_INVALID;
+    return s_clients[fd].websocket ? HTTPD_WS_CLIENT_WEBSOCKET : HTTPD_WS_CLIENT_HTTP;
+}
+
+esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t* frame) {
+    host_ws_client_t* c = client(fd);
+    if (!c->open || !c->websocket) return ESP_FAIL;
+    c->frames++;
+    c->bytes += frame->len;
+    c->last_payload = frame->payload;
+    size_t n = frame->len < sizeof(c->last) - 1 ? frame->len : sizeof(c->last) - 1;
+    memcpy(c->last, frame->payload, n);
+    c->last[n] = '\0';
+    s_httpd_counts.ws_sends++;
+    return ESP_OK;
+}
+
+esp_err_t httpd_ws_recv_frame(httpd_req_t* req, httpd_ws_frame_t* pkt, size_t max_len) {
+    host_req_ctx_t* ctx = req->aux;
+    if (!ctx->ws_text) return ESP_FAIL;
+    size_t len = strlen(ctx->ws_text);
+    pkt->final = true;
+    pkt->type = HTTPD_WS_TYPE_TEXT;
+    pkt->len = len;
+    if (max_len == 0) return ESP_OK;
+    if (max_len < len) return ESP_ERR_INVALID_SIZE;
+    memcpy(pkt->payload, ctx->ws_text, len);
+    return ESP_OK;
+}
+
+int httpd_req_to_sockfd(httpd_req_t* r) {
+    return ((host_req_ctx_t*)r->aux)->fd;
+}
+
+int httpd_req_recv(httpd_req_t* r, char* buf, size_t buf_len) {
+    host_req_ctx_t* ctx = r->aux;
+    size_t left = r->content_len - ctx->body_off;
+    if (left == 0) return 0;
+    // 每次最多返回 7 字节，覆盖调用者的分段读取循环
+    size_t n = left < buf_len ? left : buf_len;
+    if (n > 7) n = 7;
+    memcpy(buf, ctx->body + ctx->body_off, n);
+    ctx->body_off += n;
+    return (int)n;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t* r, const char* field, char* val, size_t val_size) {
+    host_req_ctx_t* ctx = r->aux;
+    if (strcasecmp(field, "Authorization") != 0 || !ctx->auth) return ESP_ERR_NOT_FOUND;
+    if (strlcpy(val, ctx->auth, val_size) >= val_size) return ESP_ERR_HTTPD_RESULT_TRUNC;
+    return ESP_OK;
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t* r, char* buf, size_t buf_len) {
+    host_req_ctx_t* ctx = r->aux;
+    if (!ctx->query) return ESP_ERR_NOT_FOUND;
+    if (strlcpy(buf, ctx->query, buf_len) >= buf_len) return ESP_ERR_HTTPD_RESULT_TRUNC;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t* r, const char* type) {
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t* r, const char* field, const char* value) {
+    host_req_ctx_t* ctx = r->aux;
+    if (ctx->resp && strcasecmp(field, "WWW-Authenticate") == 0) {
+        strlcpy(ctx->resp->www_authenticate, value, sizeof(ctx->resp->www_authenticate));
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t* r, const char* buf, ssize_t buf_len) {
+    host_req_ctx_t* ctx = r->aux;
+    if (!ctx->resp || !buf) return ESP_OK;
+    if (buf_len < 0) buf_len = (ssize_t)strlen(buf);
+    size_t used = strlen(ctx->resp->body);
+    size_t room = sizeof(ctx->resp->body) - 1 - used;
+    size_t n = (size_t)buf_len < room ? (size_t)buf_len : room;
+    memcpy(ctx->resp->body + used, buf, n);
+    ctx->resp->body[used + n] = '\0';
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t* r, const char* buf, ssize_t buf_len) {
+    return httpd_resp_send_chunk(r, buf, buf_len);
+}
+
+esp_err_t httpd_resp_sendstr(httpd_req_t* r, const char* str) {
+    return httpd_resp_send_chunk(r, str, -1);
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t* req, httpd_err_code_t error, const char* msg) {
+    static const int status[] = {
+        [HTTPD_500_INTERNAL_SERVER_ERROR] = 500,
+        [HTTPD_400_BAD_REQUEST] = 400,
+        [HTTPD_401_UNAUTHORIZED] = 401,
+        [HTTPD_403_FORBIDDEN] = 403,
+        [HTTPD_404_NOT_FOUND] = 404,
+    };
+    host_req_ctx_t* ctx = req->aux;
+    if (ctx->resp) {
+        ctx->resp->status = status[error];
+        strlcpy(ctx->resp->body, msg, sizeof(ctx->resp->body));
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,382 @@
+#include "host_stubs.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_timer.h"
+#include "driver/i2c.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ---- 兼容层 ----
+
+#ifndef HOST_HAVE_STRLCPY
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+// ---- esp_err / esp_log ----
+
+const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+    case ESP_OK:                return "ESP_OK";
+    case ESP_FAIL:              return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:  return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+    default:                    return "UNKNOWN";
+    }
+}
+
+void host_error_check_failed(esp_err_t rc, const char* file, int line, const char* expr) {
+    fprintf(stderr, "ESP_ERROR_CHECK failed: %s (%d) at %s:%d: %s\n", esp_err_to_name(rc), rc, file, line, expr);
+    abort();
+}
+
+void host_log(char level, const char* tag, const char* fmt, ...) {
+    static int enabled = -1;
+    if (enabled < 0) enabled = getenv("HOST_LOG") != NULL;
+
+    char line[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    if (enabled) fprintf(stderr, "%c (%s) %s\n", level, tag, line);
+}
+
+// ---- esp_timer / esp_mac ----
+
+static int64_t s_now_us = 0;
+
+int64_t esp_timer_get_time(void) {
+    return s_now_us;
+}
+
+void host_time_set_us(int64_t now_us) {
+    s_now_us = now_us;
+}
+
+void host_time_advance_ms(uint32_t ms) {
+    s_now_us += (int64_t)ms * 1000;
+}
+
+static uint8_t s_mac[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x01 };
+
+void host_mac_set(const uint8_t mac[6]) {
+    memcpy(s_mac, mac, sizeof(s_mac));
+}
+
+esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t type) {
+    memcpy(mac, s_mac, sizeof(s_mac));
+    if (type == ESP_MAC_WIFI_SOFTAP) mac[5]++;
+    return ESP_OK;
+}
+
+// ---- FreeRTOS ----
+
+void host_critical_enter(portMUX_TYPE* mux) {
+    if (mux->depth++ != 0) {
+        fprintf(stderr, "portENTER_CRITICAL: nested on the same spinlock\n");
+        abort();
+    }
+}
+
+void host_critical_exit(portMUX_TYPE* mux) {
+    if (--mux->depth != 0) {
+        fprintf(stderr, "portEXIT_CRITICAL: not held\n");
+        abort();
+    }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    static int task;
+    return (TaskHandle_t)&task;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack_bytes, void* arg,
+                                   UBaseType_t prio, TaskHandle_t* handle, BaseType_t core) {
+    (void)name;
+    (void)stack_bytes;
+    (void)prio;
+    (void)core;
+    if (handle) *handle = xTaskGetCurrentTaskHandle();
+    fn(arg);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    (void)task;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    (void)task;
+    return 0;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t* buffer) {
+    buffer->held = 0;
+    return buffer;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return xSemaphoreCreateMutexStatic(calloc(1, sizeof(StaticSemaphore_t)));
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    (void)ticks;
+    if (sem->held) {
+        // 单线程下重复获取必然死锁
+        fprintf(stderr, "xSemaphoreTake: mutex already held\n");
+        abort();
+    }
+    sem->held = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    if (!sem->held) {
+        fprintf(stderr, "xSemaphoreGive: mutex not held\n");
+        abort();
+    }
+    sem->held = 0;
+    return pdTRUE;
+}
+
+// ---- NVS ----
+
+#define HOST_NVS_ENTRIES 64
+#define HOST_NVS_VALUE_MAX 4096
+
+typedef struct {
+    char ns[16];
+    char key[16];
+    uint8_t value[HOST_NVS_VALUE_MAX];
+    size_t len;
+    bool used;
+} host_nvs_entry_t;
+
+static host_nvs_entry_t s_nvs[HOST_NVS_ENTRIES];
+static char s_nvs_ns[8][16];
+static int s_nvs_ns_count = 0;
+
+void host_nvs_reset(void) {
+    memset(s_nvs, 0, sizeof(s_nvs));
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle) {
+    (void)open_mode;
+    for (int i = 0; i < s_nvs_ns_count; i++) {
+        if (strcmp(s_nvs_ns[i], name) == 0) {
+            *out_handle = i + 1;
+            return ESP_OK;
+        }
+    }
+    if (s_nvs_ns_count == 8 || strlen(name) >= sizeof(s_nvs_ns[0])) return ESP_ERR_NO_MEM;
+    strcpy(s_nvs_ns[s_nvs_ns_count], name);
+    *out_handle = ++s_nvs_ns_count;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    (void)handle;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    (void)handle;
+    return ESP_OK;
+}
+
+static host_nvs_entry_t* nvs_find(nvs_handle_t handle, const char* key) {
+    for (int i = 0; i < HOST_NVS_ENTRIES; i++) {
+        if (s_nvs[i].used && strcmp(s_nvs[i].ns, s_nvs_ns[handle - 1]) == 0 && strcmp(s_nvs[i].key, key) == 0) {
+            return &s_nvs[i];
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t nvs_put(nvs_handle_t handle, const char* key, const void* value, size_t len) {
+    if (strlen(key) > 15 || len > HOST_NVS_VALUE_MAX) return ESP_ERR_INVALID_ARG;
+    host_nvs_entry_t* e = nvs_find(handle, key);
+    for (int i = 0; e == NULL && i < HOST_NVS_ENTRIES; i++) {
+        if (!s_nvs[i].used) e = &s_nvs[i];
+    }
+    if (e == NULL) return ESP_ERR_NO_MEM;
+    strcpy(e->ns, s_nvs_ns[handle - 1]);
+    strcpy(e->key, key);
+    memcpy(e->value, value, len);
+    e->len = len;
+    e->used = true;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+    host_nvs_entry_t* e = nvs_find(handle, key);
+    if (e == NULL) return ESP_ERR_NVS_NOT_FOUND;
+    e->used = false;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+    return nvs_put(handle, key, value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length) {
+    host_nvs_entry_t* e = nvs_find(handle, key);
+    if (e == NULL) return ESP_ERR_NVS_NOT_FOUND;
+    if (out_value == NULL) {
+        *length = e->len;
+        return ESP_OK;
+    }
+    if (*length < e->len) return ESP_ERR_INVALID_SIZE;
+    memcpy(out_value, e->value, e->len);
+    *length = e->len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value) {
+    return nvs_put(handle, key, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out_value, size_t* length) {
+    return nvs_get_blob(handle, key, out_value, length);
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char* key, uint8_t value) {
+    return nvs_put(handle, key, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char* key, uint8_t* out_value) {
+    size_t len = sizeof(*out_value);
+    return nvs_get_blob(handle, key, out_value, &len);
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value) {
+    return nvs_put(handle, key, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* out_value) {
+    size_t len = sizeof(*out_value);
+    return nvs_get_blob(handle, key, out_value, &len);
+}
+
+// ---- I2C（SSD1306 模型）----
+
+// 按数据手册解释命令流：0x20 选寻址模式（复位为页寻址），0xB0/0x00/0x10 只在页寻址下定位，
+// 0x21/0x22 只在水平/垂直寻址下设窗口；单字节参数的命令可跨事务接收参数
+static struct {
+    uint8_t ram[HOST_SSD1306_PAGES][HOST_SSD1306_WIDTH];
+    uint8_t mode;                       // 0 水平，1 垂直，2 页
+    uint8_t page, col;
+    uint8_t col_start, col_end, page_start, page_end;
+    uint8_t cmd;                        // 等待参数的命令
+    uint8_t args[2];
+    uint8_t nargs, need;
+} s_oled = { .mode = 2, .col_end = HOST_SSD1306_WIDTH - 1, .page_end = HOST_SSD1306_PAGES - 1 };
+
+static uint8_t ssd1306_arg_count(uint8_t cmd) {
+    switch (cmd) {
+    case 0x21: case 0x22:
+        return 2;
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3: case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static void ssd1306_command(uint8_t byte) {
+    if (s_oled.need) {
+        s_oled.args[s_oled.nargs++] = byte;
+        if (s_oled.nargs < s_oled.need) return;
+        s_oled.need = 0;
+        switch (s_oled.cmd) {
+        case 0x20:
+            s_oled.mode = s_oled.args[0] & 0x03;
+            break;
+        case 0x21:
+            s_oled.col_start = s_oled.col = s_oled.args[0] & 0x7F;
+            s_oled.col_end = s_oled.args[1] & 0x7F;
+            break;
+        case 0x22:
+            s_oled.page_start = s_oled.page = s_oled.args[0] & 0x07;
+            s_oled.page_end = s_oled.args[1] & 0x07;
+            break;
+        }
+        return;
+    }
+    uint8_t need = ssd1306_arg_count(byte);
+    if (need) {
+        s_oled.cmd = byte;
+        s_oled.nargs = 0;
+        s_oled.need = need;
+    } else if (s_oled.mode == 2 && byte >= 0xB0 && byte <= 0xB7) {
+        s_oled.page = byte & 0x07;
+    } else if (s_oled.mode == 2 && byte <= 0x0F) {
+        s_oled.col = (s_oled.col & 0xF0) | byte;
+    } else if (s_oled.mode == 2 && byte >= 0x10 && byte <= 0x17) {
+        s_oled.col = (uint8_t)((s_oled.col & 0x0F) | ((byte & 0x07) << 4));
+    }
+}
+
+static void ssd1306_data(uint8_t byte) {
+    s_oled.ram[s_oled.page][s_oled.col] = byte;
+    if (s_oled.mode == 2) {
+        s_oled.col = (s_oled.col + 1) % HOST_SSD1306_WIDTH;
+    } else if (s_oled.col++ == s_oled.col_end) {
+        s_oled.col = s_oled.col_start;
+        s_oled.page = s_oled.page == s_oled.page_end ? s_oled.page_start : s_oled.page + 1;
+    }
+}
+
+const uint8_t* host_ssd1306_ram(void) {
+    return &s_oled.ram[0][0];
+}
+
+esp_err_t i2c_param_config(i2c_port_t i2c_num, const i2c_config_t* conf) {
+    (void)i2c_num;
+    (void)conf;
+    return ESP_OK;
+}
+
+esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode, size_t slv_rx_buf_len, size_t slv_tx_buf_len,
+                             int intr_alloc_flags) {
+    (void)i2c_num;
+    (void)mode;
+    (void)slv_rx_buf_len;
+    (void)slv_tx_buf_len;
+    (void)intr_alloc_flags;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_write_to_device(i2c_port_t i2c_num, uint8_t device_address, const uint8_t* write_buffer,
+                                     size_t write_size, TickType_t ticks_to_wait) {
+    (void)i2c_num;
+    (void)ticks_to_wait;
+    if (device_address != 0x3C || write_size < 1) return ESP_FAIL;
+    // 控制字节：0x00 后跟命令，0x40 后跟显存数据
+    for (size_t i = 1; i < write_size; i++) {
+        if (write_buffer[0] == 0x40) {
+            ssd1306_data(write_buffer[i]);
+        } else {
+            ssd1306_command(write_buffer[i]);
+        }
+    }
+    return ESP_OK;
+}
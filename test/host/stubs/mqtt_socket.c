@@ -0,0 +1,507 @@
+#include "mqtt_socket.h"
+#include "host_stubs.h"
+#include "esp_log.h"
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char* TAG = "MQTT_SOCKET";
+
+#define MQTT_SOCKET_RX_MAX      8192
+#define MQTT_SOCKET_INFLIGHT    32      // 跟踪的未确认 QoS1 消息数，超出的不再报告 DELETED
+
+// MQTT 3.1.1 报文类型（固定头高 4 位）
+#define PKT_CONNECT     0x10
+#define PKT_CONNACK     0x20
+#define PKT_PUBLISH     0x30
+#define PKT_PUBACK      0x40
+#define PKT_SUBSCRIBE   0x82
+#define PKT_SUBACK      0x90
+#define PKT_PINGREQ     0xC0
+#define PKT_PINGRESP    0xD0
+#define PKT_DISCONNECT  0xE0
+
+typedef enum {
+    STATE_IDLE,
+    STATE_CONNECTING,           // 已发 CONNECT，等待 CONNACK
+    STATE_CONNECTED,
+} socket_state_t;
+
+struct esp_mqtt_client {
+    esp_mqtt_client_config_t config;
+    esp_event_handler_t handler;
+    void* handler_arg;
+    int fd;
+    socket_state_t state;
+    bool started;               // start 之后、disconnect 之前：断线后自动重连
+    bool lost;                  // 连接已关闭，断线事件待派发
+    bool broken;                // 发送失败，下次轮询时关闭
+    int64_t reconnect_at_us;
+    int64_t connack_deadline_us;
+    int64_t last_tx_us;
+    uint16_t next_id;
+    int inflight[MQTT_SOCKET_INFLIGHT];
+    uint8_t rx[MQTT_SOCKET_RX_MAX];
+    size_t rx_len;
+    host_mqtt_socket_stats_t stats;
+};
+
+static int64_t mono_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void dispatch(esp_mqtt_client_handle_t client, esp_mqtt_event_t* event) {
+    host_time_set_us(mono_us());
+    event->client = client;
+    if (client->handler) client->handler(client->handler_arg, "MQTT_EVENTS", event->event_id, event);
+}
+
+static void dispatch_id(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t id, int msg_id) {
+    esp_mqtt_event_t event = { .event_id = id, .msg_id = msg_id };
+    dispatch(client, &event);
+}
+
+static uint16_t next_packet_id(esp_mqtt_client_handle_t client) {
+    client->next_id = client->next_id % 65535 + 1;
+    return client->next_id;
+}
+
+static size_t put_u16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+    return 2;
+}
+
+static size_t put_str(uint8_t* p, const char* s, size_t len) {
+    put_u16(p, (uint16_t)len);
+    memcpy(p + 2, s, len);
+    return len + 2;
+}
+
+/**
+ * @brief 写出一个报文：固定头 + 可变头 + 载荷，写不完整时标记连接损坏
+ */
+static bool send_packet(esp_mqtt_client_handle_t client, uint8_t type, const uint8_t* head, size_t head_len,
+                        const void* payload, size_t payload_len) {
+    if (client->fd < 0 || client->broken) return false;
+    uint8_t fixed[5];
+    size_t n = 0;
+    size_t remaining = head_len + payload_len;
+    fixed[n++] = type;
+    do {
+        uint8_t byte = remaining % 128;
+        remaining /= 128;
+        fixed[n++] = byte | (remaining ? 0x80 : 0);
+    } while (remaining && n < sizeof(fixed));
+
+    struct iovec iov[3] = {
+        { fixed, n }, { (void*)head, head_len }, { (void*)payload, payload_len },
+    };
+    int iovcnt = 3;
+    struct iovec* v = iov;
+    while (iovcnt > 0) {
+        struct msghdr msg = { .msg_iov = v, .msg_iovlen = iovcnt };
+        ssize_t sent = sendmsg(client->fd, &msg, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) {
+            client->broken = true;
+            return false;
+        }
+        while (iovcnt > 0 && (size_t)sent >= v->iov_len) {
+            sent -= v->iov_len;
+            v++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            v->iov_base = (uint8_t*)v->iov_base + sent;
+            v->iov_len -= sent;
+        }
+    }
+    client->last_tx_us = mono_us();
+    return true;
+}
+
+/**
+ * @brief 关闭连接；断线事件在下次轮询时派发（与 esp-mqtt 一样不在调用方的上下文里回调）
+ */
+static void close_connection(esp_mqtt_client_handle_t client, uint32_t reconnect_ms, bool reset) {
+    if (client->fd >= 0) {
+        if (reset) {
+            struct linger lg = { .l_onoff = 1, .l_linger = 0 };
+            setsockopt(client->fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+        }
+        close(client->fd);
+        client->fd = -1;
+        client->lost = true;
+    }
+    client->state = STATE_IDLE;
+    client->broken = false;
+    client->rx_len = 0;
+    client->reconnect_at_us = mono_us() + (int64_t)reconnect_ms * 1000;
+}
+
+/**
+ * @brief 派发断线事件，再把未确认的 QoS1 消息按发件箱过期报告
+ */
+static void dispatch_lost(esp_mqtt_client_handle_t client) {
+    if (!client->lost) return;
+    client->lost = false;
+    int inflight[MQTT_SOCKET_INFLIGHT];
+    memcpy(inflight, client->inflight, sizeof(inflight));
+    memset(client->inflight, 0, sizeof(client->inflight));
+    dispatch_id(client, MQTT_EVENT_DISCONNECTED, 0);
+    for (int i = 0; i < MQTT_SOCKET_INFLIGHT; i++) {
+        if (inflight[i]) dispatch_id(client, MQTT_EVENT_DELETED, inflight[i]);
+    }
+}
+
+/**
+ * @brief mqtt://host[:port] 拆成主机名和端口
+ */
+static bool parse_uri(const char* uri, char* host, size_t host_size, char* port, size_t port_size) {
+    static const char scheme[] = "mqtt://";
+    if (!uri || strncmp(uri, scheme, sizeof(scheme) - 1) != 0) return false;
+    const char* h = uri + sizeof(scheme) - 1;
+    size_t len = strcspn(h, ":/");
+    if (len == 0 || len >= host_size) return false;
+    memcpy(host, h, len);
+    host[len] = '\0';
+    if (h[len] == ':') {
+        size_t plen = strcspn(h + len + 1, "/");
+        if (plen == 0 || plen >= port_size) return false;
+        memcpy(port, h + len + 1, plen);
+        port[plen] = '\0';
+    } else {
+        snprintf(port, port_size, "1883");
+    }
+    return true;
+}
+
+static int tcp_connect(const char* host, const char* port) {
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo* res = NULL;
+    if (getaddrinfo(host, port, &hints, &res) != 0) return -1;
+    int fd = -1;
+    for (struct addrinfo* ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd >= 0) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+static void connection_failed(esp_mqtt_client_handle_t client) {
+    client->stats.connect_failures++;
+    if (client->fd < 0) client->lost = true;   // TCP 未建立也按断线报告，mqtt_comm 据此计失败
+    close_connection(client, client->config.network.reconnect_timeout_ms, false);
+}
+
+static void start_connect(esp_mqtt_client_handle_t client) {
+    dispatch_id(client, MQTT_EVENT_BEFORE_CONNECT, 0);
+    const esp_mqtt_client_config_t* cfg = &client->config;
+    char host[128], port[8];
+    if (!parse_uri(cfg->broker.address.uri, host, sizeof(host), port, sizeof(port))) {
+        ESP_LOGE(TAG, "不支持的 broker 地址: %s", cfg->broker.address.uri ? cfg->broker.address.uri : "(null)");
+        connection_failed(client);
+        return;
+    }
+    client->fd = tcp_connect(host, port);
+    if (client->fd < 0) {
+        connection_failed(client);
+        return;
+    }
+
+    const char* id = cfg->credentials.client_id ? cfg->credentials.client_id : "";
+    const char* user = cfg->credentials.username;
+    const char* pass = cfg->credentials.authentication.password;
+    const char* will_topic = cfg->session.last_will.topic;
+    const char* will_msg = cfg->session.last_will.msg ? cfg->session.last_will.msg : "";
+    size_t will_len = cfg->session.last_will.msg_len ? (size_t)cfg->session.last_will.msg_len : strlen(will_msg);
+
+    uint8_t flags = cfg->session.disable_clean_session ? 0 : 0x02;
+    if (will_topic) {
+        flags |= 0x04 | (uint8_t)((cfg->session.last_will.qos & 3) << 3) | (cfg->session.last_will.retain ? 0x20 : 0);
+    }
+    if (user) flags |= 0x80;
+    if (pass) flags |= 0x40;
+
+    uint8_t head[10];
+    size_t n = put_str(head, "MQTT", 4);
+    head[n++] = 4;                              // 协议级别 3.1.1
+    head[n++] = flags;
+    n += put_u16(head + n, (uint16_t)cfg->session.keepalive);
+
+    size_t size = 2 + strlen(id) + (will_topic ? 4 + strlen(will_topic) + will_len : 0) +
+                  (user ? 2 + strlen(user) : 0) + (pass ? 2 + strlen(pass) : 0);
+    uint8_t* payload = malloc(size);
+    size_t p = put_str(payload, id, strlen(id));
+    if (will_topic) {
+        p += put_str(payload + p, will_topic, strlen(will_topic));
+        p += put_str(payload + p, will_msg, will_len);
+    }
+    if (user) p += put_str(payload + p, user, strlen(user));
+    if (pass) p += put_str(payload + p, pass, strlen(pass));
+    bool ok = send_packet(client, PKT_CONNECT, head, n, payload, p);
+    free(payload);
+    if (!ok) {
+        connection_failed(client);
+        return;
+    }
+    client->state = STATE_CONNECTING;
+    int timeout_ms = cfg->network.timeout_ms > 0 ? cfg->network.timeout_ms : 10000;
+    client->connack_deadline_us = mono_us() + (int64_t)timeout_ms * 1000;
+}
+
+static void track_inflight(esp_mqtt_client_handle_t client, int msg_id, bool add) {
+    for (int i = 0; i < MQTT_SOCKET_INFLIGHT; i++) {
+        if (client->inflight[i] == (add ? 0 : msg_id)) {
+            client->inflight[i] = add ? msg_id : 0;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 处理一个完整报文
+ */
+static void handle_packet(esp_mqtt_client_handle_t client, uint8_t type, uint8_t* body, size_t len) {
+    switch (type & 0xF0) {
+    case PKT_CONNACK:
+        if (len < 2 || body[1] != 0) {
+            ESP_LOGW(TAG, "CONNACK 拒绝: %d", len >= 2 ? body[1] : -1);
+            connection_failed(client);
+            dispatch_lost(client);
+            return;
+        }
+        client->state = STATE_CONNECTED;
+        client->stats.connects++;
+        esp_mqtt_event_t event = { .event_id = MQTT_EVENT_CONNECTED, .session_present = body[0] & 1 };
+        dispatch(client, &event);
+        break;
+
+    case PKT_PUBLISH: {
+        int qos = (type >> 1) & 3;
+        if (len < 2) break;
+        size_t topic_len = ((size_t)body[0] << 8) | body[1];
+        size_t off = 2 + topic_len + (qos ? 2 : 0);
+        if (off > len) break;
+        if (qos) {
+            uint8_t id[2] = { body[2 + topic_len], body[3 + topic_len] };
+            send_packet(client, PKT_PUBACK, id, sizeof(id), NULL, 0);
+        }
+        client->stats.received++;
+        esp_mqtt_event_t event = {
+            .event_id = MQTT_EVENT_DATA,
+            .topic = (char*)body + 2, .topic_len = (int)topic_len,
+            .data = (char*)body + off, .data_len = (int)(len - off), .total_data_len = (int)(len - off),
+            .qos = qos, .retain = type & 1, .dup = (type >> 3) & 1,
+        };
+        dispatch(client, &event);
+        break;
+    }
+
+    case PKT_PUBACK:
+        if (len >= 2) {
+            int msg_id = (body[0] << 8) | body[1];
+            track_inflight(client, msg_id, false);
+            dispatch_id(client, MQTT_EVENT_PUBLISHED, msg_id);
+        }
+        break;
+
+    case PKT_SUBACK:
+        if (len >= 2) dispatch_id(client, MQTT_EVENT_SUBSCRIBED, (body[0] << 8) | body[1]);
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief 从接收缓冲中逐个取出完整报文；回调中关闭连接时停止
+ */
+static void parse_rx(esp_mqtt_client_handle_t client) {
+    size_t pos = 0;
+    while (client->fd >= 0 && client->rx_len - pos >= 2) {
+        size_t remaining = 0, mult = 1, n = 1;
+        bool complete = false;
+        while (n < 5 && pos + n < client->rx_len) {
+            uint8_t byte = client->rx[pos + n++];
+            remaining += (byte & 0x7F) * mult;
+            mult *= 128;
+            if (!(byte & 0x80)) {
+                complete = true;
+                break;
+            }
+        }
+        if (!complete) {
+            if (n >= 5) {
+                ESP_LOGE(TAG, "报文长度无效");
+                close_connection(client, client->config.network.reconnect_timeout_ms, true);
+                return;
+            }
+            break;
+        }
+        if (n + remaining > sizeof(client->rx)) {
+            ESP_LOGE(TAG, "报文过大: %zu", remaining);
+            close_connection(client, client->config.network.reconnect_timeout_ms, true);
+            return;
+        }
+        if (client->rx_len - pos < n + remaining) break;
+        uint8_t type = client->rx[pos];
+        handle_packet(client, type, client->rx + pos + n, remaining);
+        pos += n + remaining;
+    }
+    if (client->fd < 0) return;
+    memmove(client->rx, client->rx + pos, client->rx_len - pos);
+    client->rx_len -= pos;
+}
+
+void host_mqtt_socket_poll(esp_mqtt_client_handle_t client, int timeout_ms) {
+    if (client->broken) close_connection(client, client->config.network.reconnect_timeout_ms, true);
+    dispatch_lost(client);
+
+    int64_t now = mono_us();
+    if (client->fd < 0) {
+        if (!client->started || now < client->reconnect_at_us) {
+            int64_t wait_us = client->started ? client->reconnect_at_us - now : (int64_t)timeout_ms * 1000;
+            if (wait_us > (int64_t)timeout_ms * 1000) wait_us = (int64_t)timeout_ms * 1000;
+            if (wait_us > 0) usleep((useconds_t)wait_us);
+            return;
+        }
+        start_connect(client);
+        dispatch_lost(client);
+        if (client->fd < 0) return;
+    }
+
+    if (client->state == STATE_CONNECTING && now > client->connack_deadline_us) {
+        ESP_LOGW(TAG, "CONNACK 超时");
+        connection_failed(client);
+        dispatch_lost(client);
+        return;
+    }
+    int keepalive_s = client->config.session.keepalive;
+    if (client->state == STATE_CONNECTED && keepalive_s > 0 &&
+        now - client->last_tx_us >= (int64_t)keepalive_s * 1000000 / 2) {
+        send_packet(client, PKT_PINGREQ, NULL, 0, NULL, 0);
+    }
+
+    struct pollfd pfd = { .fd = client->fd, .events = POLLIN };
+    if (poll(&pfd, 1, timeout_ms) <= 0) return;
+    ssize_t n = recv(client->fd, client->rx + client->rx_len, sizeof(client->rx) - client->rx_len, MSG_DONTWAIT);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return;
+    if (n <= 0) {
+        ESP_LOGW(TAG, "连接断开");
+        close_connection(client, client->config.network.reconnect_timeout_ms, false);
+        dispatch_lost(client);
+        return;
+    }
+    client->rx_len += (size_t)n;
+    parse_rx(client);
+    dispatch_lost(client);
+}
+
+void host_mqtt_socket_drop(esp_mqtt_client_handle_t client, uint32_t reconnect_ms) {
+    close_connection(client, reconnect_ms, true);
+}
+
+host_mqtt_socket_stats_t host_mqtt_socket_stats(esp_mqtt_client_handle_t client) {
+    return client->stats;
+}
+
+// ---- esp-mqtt 接口 ----
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t* config) {
+    esp_mqtt_client_handle_t client = calloc(1, sizeof(*client));
+    if (!client) return NULL;
+    client->config = *config;
+    client->fd = -1;
+    return client;
+}
+
+esp_err_t esp_mqtt_set_config(esp_mqtt_client_handle_t client, const esp_mqtt_client_config_t* config) {
+    client->config = *config;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client) {
+    client->started = true;
+    client->reconnect_at_us = mono_us();
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t event_handler, void* event_handler_arg) {
+    (void)event;
+    client->handler = event_handler;
+    client->handler_arg = event_handler_arg;
+    return ESP_OK;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char* topic, const char* data,
+                            int len, int qos, int retain) {
+    if (client->state != STATE_CONNECTED) return -1;
+    if (len == 0 && data) len = (int)strlen(data);
+    size_t topic_len = strlen(topic);
+    uint8_t* head = malloc(topic_len + 4);
+    size_t n = put_str(head, topic, topic_len);
+    int msg_id = 0;
+    if (qos > 0) {
+        qos = 1;                                // 只实现到 QoS1
+        msg_id = next_packet_id(client);
+        n += put_u16(head + n, (uint16_t)msg_id);
+    }
+    uint8_t type = PKT_PUBLISH | (uint8_t)(qos << 1) | (retain ? 1 : 0);
+    bool ok = send_packet(client, type, head, n, data, (size_t)len);
+    free(head);
+    if (!ok) return -1;
+    if (msg_id) track_inflight(client, msg_id, true);
+    client->stats.published++;
+    return msg_id;
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char* topic, int qos) {
+    if (client->state != STATE_CONNECTED) return -1;
+    size_t topic_len = strlen(topic);
+    uint8_t id[2];
+    int msg_id = next_packet_id(client);
+    put_u16(id, (uint16_t)msg_id);
+    uint8_t* payload = malloc(topic_len + 3);
+    size_t n = put_str(payload, topic, topic_len);
+    payload[n++] = (uint8_t)(qos > 1 ? 1 : qos);
+    bool ok = send_packet(client, PKT_SUBSCRIBE, id, sizeof(id), payload, n);
+    free(payload);
+    return ok ? msg_id : -1;
+}
+
+esp_err_t esp_mqtt_client_disconnect(esp_mqtt_client_handle_t client) {
+    if (client->state == STATE_CONNECTED) send_packet(client, PKT_DISCONNECT, NULL, 0, NULL, 0);
+    client->started = false;
+    close_connection(client, 0, false);
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_reconnect(esp_mqtt_client_handle_t client) {
+    client->started = true;
+    client->reconnect_at_us = mono_us();
+    return ESP_OK;
+}
@@ -0,0 +1,33 @@
+#ifndef MQTT_SOCKET_H
+#define MQTT_SOCKET_H
+
+#include <stdint.h>
+#include "mqtt_client.h"
+
+/**
+ * @brief esp-mqtt 客户端接口的主机实现：MQTT 3.1.1 over TCP（QoS0/1、遗嘱、keepalive、断线重连），
+ *        让 mqtt_comm.c 在 PC 上原样连接真实 broker（见 virtual_fleet.c）。
+ *        与 esp-mqtt 一样事件只在“MQTT 任务”中派发，这里即 host_mqtt_socket_poll；只支持 mqtt://
+ */
+
+typedef struct {
+    uint32_t published;         // 成功写入套接字的 PUBLISH
+    uint32_t received;          // 收到的 PUBLISH（MQTT_EVENT_DATA）
+    uint32_t connects;          // 收到 CONNACK 接受
+    uint32_t connect_failures;  // TCP 连接失败、CONNACK 拒绝或超时
+} host_mqtt_socket_stats_t;
+
+/**
+ * @brief 收发并派发事件，最多等待 timeout_ms；未连接且重连时间已到时先连接
+ *        主机时钟（esp_timer_get_time）在派发前更新为单调时钟
+ */
+void host_mqtt_socket_poll(esp_mqtt_client_handle_t client, int timeout_ms);
+
+/**
+ * @brief 不发 DISCONNECT 直接复位 TCP 连接（broker 发布遗嘱），reconnect_ms 后重连
+ */
+void host_mqtt_socket_drop(esp_mqtt_client_handle_t client, uint32_t reconnect_ms);
+
+host_mqtt_socket_stats_t host_mqtt_socket_stats(esp_mqtt_client_handle_t client);
+
+#endif // MQTT_SOCKET_H
@@ -0,0 +1,176 @@
+#include "host_stubs.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief esp-mqtt 客户端桩：发布只记录不发送，事件由 host_mqtt_event/host_mqtt_deliver 注入
+ *        （连接真实 broker 的实现见 mqtt_socket.c）
+ */
+
+struct esp_mqtt_client {
+    esp_mqtt_client_config_t config;
+    esp_event_handler_t handler;
+    void* handler_arg;
+    int dispatching;                            // 事件回调执行中（MQTT 任务持有客户端锁）
+};
+
+static struct esp_mqtt_client s_client;
+static host_mqtt_msg_t s_log[HOST_MQTT_LOG];
+static int s_log_count = 0;                     // 累计条数，按 HOST_MQTT_LOG 取模存放
+static int s_next_msg_id = 1;
+static bool s_fail_publish = false;
+static host_mqtt_counts_t s_counts;
+static struct {
+    bool armed;
+    esp_mqtt_event_id_t id;
+    int msg_id;
+} s_contend;
+
+void host_mqtt_reset(void) {
+    s_log_count = 0;
+    s_fail_publish = false;
+    s_contend.armed = false;
+    memset(&s_counts, 0, sizeof(s_counts));
+}
+
+void host_mqtt_fail_publish(bool fail) {
+    s_fail_publish = fail;
+}
+
+void host_mqtt_contend(esp_mqtt_event_id_t id, int msg_id) {
+    s_contend.armed = true;
+    s_contend.id = id;
+    s_contend.msg_id = msg_id;
+}
+
+int host_mqtt_count(void) {
+    return s_log_count;
+}
+
+const host_mqtt_msg_t* host_mqtt_msg(int index) {
+    if (index < 0 || index >= s_log_count || index < s_log_count - HOST_MQTT_LOG) return NULL;
+    return &s_log[index % HOST_MQTT_LOG];
+}
+
+static bool ends_with(const char* s, const char* suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+const host_mqtt_msg_t* host_mqtt_last(const char* suffix) {
+    for (int i = s_log_count - 1; i >= 0 && i >= s_log_count - HOST_MQTT_LOG; i--) {
+        if (ends_with(s_log[i % HOST_MQTT_LOG].topic, suffix)) return &s_log[i % HOST_MQTT_LOG];
+    }
+    return NULL;
+}
+
+int host_mqtt_count_topic(const char* suffix) {
+    int n = 0;
+    for (int i = s_log_count - 1; i >= 0 && i >= s_log_count - HOST_MQTT_LOG; i--) {
+        if (ends_with(s_log[i % HOST_MQTT_LOG].topic, suffix)) n++;
+    }
+    return n;
+}
+
+host_mqtt_counts_t host_mqtt_counts(void) {
+    return s_counts;
+}
+
+const esp_mqtt_client_config_t* host_mqtt_config(void) {
+    return &s_client.config;
+}
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t* config) {
+    memset(&s_client, 0, sizeof(s_client));
+    s_client.config = *config;
+    return &s_client;
+}
+
+esp_err_t esp_mqtt_set_config(esp_mqtt_client_handle_t client, const esp_mqtt_client_config_t* config) {
+    client->config = *config;
+    s_counts.set_configs++;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client) {
+    (void)client;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t event_handler, void* event_handler_arg) {
+    (void)event;
+    client->handler = event_handler;
+    client->handler_arg = event_handler_arg;
+    return ESP_OK;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char* topic, const char* data,
+                            int len, int qos, int retain) {
+    if (s_fail_publish) return -1;
+    if (len == 0 && data) len = (int)strlen(data);
+    host_mqtt_msg_t* m = &s_log[s_log_count++ % HOST_MQTT_LOG];
+    strlcpy(m->topic, topic, sizeof(m->topic));
+    m->len = len;
+    int n = len < HOST_MQTT_DATA_MAX - 1 ? len : HOST_MQTT_DATA_MAX - 1;
+    memcpy(m->data, data, n);
+    m->data[n] = '\0';
+    m->qos = qos;
+    m->retain = retain;
+    m->msg_id = qos > 0 ? s_next_msg_id++ : 0;
+    s_counts.published++;
+    int msg_id = m->msg_id;
+    if (s_contend.armed && client->dispatching == 0) {
+        // 调用方返回前 MQTT 任务抢到客户端锁并执行事件回调
+        s_contend.armed = false;
+        host_mqtt_event(client, s_contend.id, s_contend.msg_id ? s_contend.msg_id : msg_id);
+    }
+    return msg_id;
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char* topic, int qos) {
+    (void)client;
+    (void)topic;
+    (void)qos;
+    s_counts.subscribed++;
+    return s_next_msg_id++;
+}
+
+esp_err_t esp_mqtt_client_disconnect(esp_mqtt_client_handle_t client) {
+    (void)client;
+    s_counts.disconnects++;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_reconnect(esp_mqtt_client_handle_t client) {
+    (void)client;
+    s_counts.reconnects++;
+    return ESP_OK;
+}
+
+void host_mqtt_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t id, int msg_id) {
+    esp_mqtt_event_t event = { .event_id = id, .client = client, .msg_id = msg_id };
+    client->dispatching++;
+    client->handler(client->handler_arg, "MQTT_EVENTS", id, &event);
+    client->dispatching--;
+}
+
+void host_mqtt_deliver(esp_mqtt_client_handle_t client, const char* topic, const char* data, int len) {
+    // 与 esp-mqtt 一致：主题与数据都不以 '\0' 结尾，按长度拷贝到独立缓冲便于 ASan 检查越界
+    int topic_len = (int)strlen(topic);
+    char* t = malloc(topic_len ? topic_len : 1);
+    char* d = malloc(len ? len : 1);
+    memcpy(t, topic, topic_len);
+    memcpy(d, data, len);
+    esp_mqtt_event_t event = {
+        .event_id = MQTT_EVENT_DATA, .client = client,
+        .topic = t, .topic_len = topic_len, .data = d, .data_len = len, .total_data_len = len,
+    };
+    client->dispatching++;
+    client->handler(client->handler_arg, "MQTT_EVENTS", MQTT_EVENT_DATA, &event);
+    client->dispatching--;
+    free(t);
+    free(d);
+}
@@ -0,0 +1,21 @@
+#include "wifi_provision.h"
+#include "lan_auth.h"
+#include "nvs.h"
+
+/**
+ * @brief wifi_provision 接口桩：只实现 lan_api 读取接口令牌所需的部分（与固件相同的 NVS 键）
+ */
+
+bool wifi_prov_get_api_token(char* out, size_t size) {
+    out[0] = '\0';
+    nvs_handle_t nvs_handle;
+    if (nvs_open("storage", NVS_READONLY, &nvs_handle) != ESP_OK) return false;
+    size_t len = size;
+    esp_err_t err = nvs_get_str(nvs_handle, "api_token", out, &len);
+    nvs_close(nvs_handle);
+    if (err != ESP_OK || !lan_auth_token_valid(out)) {
+        out[0] = '\0';
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,90 @@
+#include "host_test.h"
+#include "adaptive_period.h"
+
+/**
+ * @brief 自适应周期：按变化率和误差缩短、稳定后限速拉长、不在两个周期间振荡、派生节拍限幅
+ *        参数与 main.c 一致：1~20 s，每周期 0.1°C，误差死区 0.5°C、3°C 取下限
+ */
+
+#define MIN_MS 1000u
+#define MAX_MS 20000u
+
+static adaptive_period_t make(void) {
+    adaptive_period_t ap;
+    adaptive_period_init(&ap, MIN_MS, MAX_MS, 0.1f, 0.5f, 3.0f);
+    return ap;
+}
+
+static void test_starts_fast_and_stretches(void) {
+    adaptive_period_t ap = make();
+    CHECK_INT(ap.period_ms, MIN_MS);
+    uint32_t prev = MIN_MS;
+    int steps = 0;
+    while (prev < MAX_MS && steps < 100) {
+        uint32_t next = adaptive_period_update(&ap, 0.0f, 0.0f);
+        CHECK(next <= prev * 3 / 2);        // 每次最多拉长 1.5 倍
+        CHECK(next > prev);
+        prev = next;
+        steps++;
+    }
+    CHECK_INT(prev, MAX_MS);
+    CHECK(steps >= 7 && steps <= 9);        // 1.5^7.4 ≈ 20
+    CHECK_INT(adaptive_period_update(&ap, 0.0f, 0.0f), MAX_MS);
+}
+
+static void test_fast_change_shortens_immediately(void) {
+    adaptive_period_t ap = make();
+    for (int i = 0; i < 20; i++) adaptive_period_update(&ap, 0.0f, 0.0f);
+    // 0.05°C/s：每周期 0.1°C 对应 2 s
+    CHECK_INT(adaptive_period_update(&ap, 0.05f, 0.0f), 2000);
+    CHECK_INT(adaptive_period_update(&ap, -0.05f, 0.0f), 2000);   // 降温同样按绝对值
+    CHECK_INT(adaptive_period_update(&ap, 1.0f, 0.0f), MIN_MS);
+}
+
+static void test_error_shortens(void) {
+    adaptive_period_t ap = make();
+    for (int i = 0; i < 20; i++) adaptive_period_update(&ap, 0.0f, 0.0f);
+    CHECK_INT(adaptive_period_update(&ap, 0.0f, 0.5f), MAX_MS);   // 死区内
+    CHECK_INT(adaptive_period_update(&ap, 0.0f, -5.0f), MAX_MS);  // 低于设定值只看变化率
+    // 死区到取下限之间线性：1.75°C 处为中点
+    CHECK_INT(adaptive_period_update(&ap, 0.0f, 1.75f), (MIN_MS + MAX_MS) / 2);
+    CHECK_INT(adaptive_period_update(&ap, 0.0f, 3.0f), MIN_MS);
+    CHECK_INT(adaptive_period_update(&ap, 0.0f, 10.0f), MIN_MS);
+}
+
+static void test_recovery_is_gradual(void) {
+    // 扰动后立即缩短，恢复时逐级拉长：一次平稳读数不会直接跳回上限
+    adaptive_period_t ap = make();
+    for (int i = 0; i < 20; i++) adaptive_period_update(&ap, 0.0f, 0.0f);
+    CHECK_INT(adaptive_period_update(&ap, 0.5f, 0.0f), MIN_MS);
+    CHECK_INT(adaptive_period_update(&ap, 0.0f, 0.0f), MIN_MS * 3 / 2);
+    CHECK_INT(adaptive_period_update(&ap, 0.0f, 0.0f), MIN_MS * 9 / 4);
+    // 变化率对应的周期低于当前值时不受拉长限速影响
+    CHECK_INT(adaptive_period_update(&ap, 0.1f, 0.0f), MIN_MS);
+}
+
+static void test_nan_rate_ignored(void) {
+    adaptive_period_t ap = make();
+    for (int i = 0; i < 20; i++) adaptive_period_update(&ap, 0.0f, 0.0f);
+    uint32_t p = adaptive_period_update(&ap, NAN, 0.0f);
+    CHECK(p >= MIN_MS && p <= MAX_MS);
+}
+
+static void test_scale(void) {
+    CHECK_INT(adaptive_period_scale(20000, 1, 2, 2000, 8000), 8000);
+    CHECK_INT(adaptive_period_scale(1000, 1, 2, 2000, 8000), 2000);
+    CHECK_INT(adaptive_period_scale(6000, 1, 2, 2000, 8000), 3000);
+    // 乘以分子超出 32 位时按上限处理，而不是截断
+    CHECK_INT(adaptive_period_scale(400000000u, 12, 1, 0, UINT32_MAX), UINT32_MAX);
+    CHECK_INT(adaptive_period_scale(400000000u, 12, 1, 0, 60000), 60000);
+}
+
+int main(void) {
+    RUN(test_starts_fast_and_stretches);
+    RUN(test_fast_change_shortens_immediately);
+    RUN(test_error_shortens);
+    RUN(test_recovery_is_gradual);
+    RUN(test_nan_rate_ignored);
+    RUN(test_scale);
+    return HOST_TEST_RESULT();
+}
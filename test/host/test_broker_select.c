@@ -0,0 +1,175 @@
+#include "host_test.h"
+#include "broker_select.h"
+
+/**
+ * @brief broker 选择：列表检查、中断重拨与失败退避、切换到备用、回切的保持时间/得分余量，
+ *        以及回切前的可达性探测（连续失败或探测过期时不回切）
+ */
+
+#define T0 1000000ull
+
+static broker_list_t list_of(int count) {
+    static const char* const uris[] = { "mqtt://a.local", "mqtts://b.local:8883", "mqtt://c.local", "mqtt://d" };
+    broker_list_t list = { .count = (uint8_t)count };
+    for (int i = 0; i < count; i++) strcpy(list.entry[i].uri, uris[i]);
+    return list;
+}
+
+/**
+ * @brief 首选失败后连上备用 broker 1，返回连接建立时间
+ */
+static uint64_t fail_over(broker_select_t* sel) {
+    broker_list_t list = list_of(2);
+    broker_select_init(sel, &list);
+    CHECK_INT(broker_select_begin(sel, T0), 0);
+    CHECK_INT(broker_select_failed(sel, T0), BROKER_FAILOVER_MS);   // 备用可用，马上切
+    CHECK_INT(broker_select_begin(sel, T0 + BROKER_FAILOVER_MS), 1);
+    broker_select_connected(sel, T0 + BROKER_FAILOVER_MS + 100);
+    return T0 + BROKER_FAILOVER_MS + 100;
+}
+
+static void test_list_valid(void) {
+    broker_list_t list = list_of(BROKER_MAX);
+    CHECK(broker_list_valid(&list));
+    list.count = 0;
+    CHECK(!broker_list_valid(&list));
+    list.count = BROKER_MAX + 1;
+    CHECK(!broker_list_valid(&list));
+
+    list = list_of(1);
+    strcpy(list.entry[0].uri, "mqtt://");
+    CHECK(!broker_list_valid(&list));
+    strcpy(list.entry[0].uri, "http://a.local");
+    CHECK(!broker_list_valid(&list));
+    list = list_of(1);
+    memset(list.entry[0].password, 'x', sizeof(list.entry[0].password));   // 不以 '\0' 结尾
+    CHECK(!broker_list_valid(&list));
+
+    CHECK(broker_uri_is_tls("mqtts://b.local"));
+    CHECK(!broker_uri_is_tls("mqtt://a.local"));
+}
+
+static void test_redial_after_drop(void) {
+    broker_select_t sel;
+    uint64_t now = fail_over(&sel);
+    CHECK_INT(broker_select_retry_wait(&sel, now), BROKER_FAILOVER_MS);
+    // 已建立的连接中断：重拨同一个 broker，不计失败
+    CHECK_INT(broker_select_failed(&sel, now + 1000), BROKER_FAILOVER_MS);
+    CHECK_INT(sel.health[1].failures, 0);
+    CHECK_INT(broker_select_begin(&sel, now + 1200), 1);
+    CHECK_INT(sel.switches, 1);
+
+    // 主动断开不重拨：回到得分最好的首选
+    broker_select_connected(&sel, now + 1300);
+    broker_select_release(&sel);
+    CHECK_INT(broker_select_begin(&sel, now + 10000), 0);
+    CHECK_INT(sel.switches, 2);
+}
+
+static void test_backoff_doubles(void) {
+    broker_select_t sel;
+    broker_list_t list = list_of(1);
+    broker_select_init(&sel, &list);
+    uint64_t now = T0;
+    uint32_t expect = BROKER_RETRY_MIN_MS;
+    for (int i = 0; i < 8; i++) {
+        CHECK_INT(broker_select_begin(&sel, now), 0);
+        CHECK_INT(broker_select_retry_wait(&sel, now), expect);
+        CHECK_INT(broker_select_failed(&sel, now), expect);
+        now += expect;
+        expect = expect * 2 > BROKER_RETRY_MAX_MS ? BROKER_RETRY_MAX_MS : expect * 2;
+    }
+    CHECK_INT(sel.health[0].failures, 8);
+    broker_select_begin(&sel, now);
+    broker_select_connected(&sel, now + 50);
+    CHECK_INT(sel.health[0].fail_streak, 0);
+    CHECK_INT(sel.health[0].connect_ms, 50);
+}
+
+static void test_all_backing_off(void) {
+    broker_select_t sel;
+    broker_list_t list = list_of(2);
+    broker_select_init(&sel, &list);
+    broker_select_begin(&sel, T0);
+    broker_select_failed(&sel, T0);                             // 0 退避到 T0+1000
+    broker_select_begin(&sel, T0 + 200);
+    // 1 也失败：等 0 的退避结束，而不是 1 自己的
+    CHECK_INT(broker_select_failed(&sel, T0 + 200), 800);
+    CHECK_INT(broker_select_begin(&sel, T0 + 500), 0);          // 都在退避时取最早结束的
+}
+
+static void test_failback_hold_and_margin(void) {
+    broker_select_t sel;
+    uint64_t up = fail_over(&sel);
+    broker_select_probe_result(&sel, 0, true, up + BROKER_FAILBACK_HOLD_MS - 1);
+    CHECK_INT(broker_select_failback(&sel, up + BROKER_FAILBACK_HOLD_MS - 1), -1);   // 未满保持时间
+    CHECK_INT(broker_select_failback(&sel, up + BROKER_FAILBACK_HOLD_MS), 0);
+
+    // 得分相差不到余量时不回切：1 = 100 + 250，0 = 260
+    sel.health[1].rtt_ms = 100;
+    sel.health[0].rtt_ms = 260;
+    CHECK_INT(broker_select_failback(&sel, up + BROKER_FAILBACK_HOLD_MS), -1);
+    sel.health[0].rtt_ms = 240;
+    CHECK_INT(broker_select_failback(&sel, up + BROKER_FAILBACK_HOLD_MS), 0);
+
+    // 未连接时不回切
+    broker_select_release(&sel);
+    CHECK_INT(broker_select_failback(&sel, up + BROKER_FAILBACK_HOLD_MS), -1);
+}
+
+static void test_failback_requires_probe(void) {
+    broker_select_t sel;
+    uint64_t now = fail_over(&sel) + BROKER_FAILBACK_HOLD_MS;
+    // 首选的退避早已结束，但切走时的连续失败还在：先探测
+    CHECK_INT(sel.health[0].fail_streak, 1);
+    CHECK_INT(broker_select_failback(&sel, now), -1);
+    CHECK_INT(broker_select_probe_due(&sel, now), 0);
+
+    // 探测失败：计入退避，间隔内不再探测
+    broker_select_probe_result(&sel, 0, false, now);
+    CHECK_INT(sel.health[0].fail_streak, 2);
+    CHECK_INT(sel.health[0].failures, 2);
+    CHECK_INT(broker_select_failback(&sel, now), -1);
+    CHECK_INT(broker_select_probe_due(&sel, now + 2000), -1);
+    CHECK_INT(broker_select_probe_due(&sel, now + BROKER_PROBE_INTERVAL_MS - 1), -1);
+    now += BROKER_PROBE_INTERVAL_MS;
+    CHECK_INT(broker_select_probe_due(&sel, now), 0);
+
+    // 探测成功：清零连续失败，新鲜期内回切
+    broker_select_probe_result(&sel, 0, true, now);
+    CHECK_INT(sel.health[0].fail_streak, 0);
+    CHECK_INT(sel.health[0].retry_at_ms, 0);
+    CHECK_INT(broker_select_failback(&sel, now + BROKER_PROBE_FRESH_MS), 0);
+    CHECK_INT(broker_select_failback(&sel, now + BROKER_PROBE_FRESH_MS + 1), -1);
+    CHECK_INT(broker_select_probe_due(&sel, now + BROKER_PROBE_FRESH_MS + 1), -1);
+    CHECK_INT(broker_select_probe_due(&sel, now + BROKER_PROBE_INTERVAL_MS), 0);
+
+    // 探测成功后又连接失败（探测只看 TCP）：有连续失败时即使探测新鲜也不回切
+    broker_select_probe_result(&sel, 0, true, now);
+    sel.health[0].fail_streak = 1;
+    CHECK_INT(broker_select_failback(&sel, now), -1);
+}
+
+static void test_probe_due_only_for_candidate(void) {
+    broker_select_t sel;
+    uint64_t up = fail_over(&sel);
+    CHECK_INT(broker_select_probe_due(&sel, up + BROKER_FAILBACK_HOLD_MS - 1), -1);
+    // 已在首选上时没有回切候选
+    broker_select_probe_result(&sel, 0, true, up);
+    broker_select_release(&sel);
+    broker_select_begin(&sel, up);
+    broker_select_connected(&sel, up);
+    CHECK_INT(broker_select_probe_due(&sel, up + BROKER_FAILBACK_HOLD_MS), -1);
+    broker_select_probe_result(&sel, 7, true, up);              // 越界下标被忽略
+}
+
+int main(void) {
+    RUN(test_list_valid);
+    RUN(test_redial_after_drop);
+    RUN(test_backoff_doubles);
+    RUN(test_all_backing_off);
+    RUN(test_failback_hold_and_margin);
+    RUN(test_failback_requires_probe);
+    RUN(test_probe_due_only_for_candidate);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,162 @@
+#include "host_test.h"
+#include "cooling_supervisor.h"
+
+/**
+ * @brief 风扇/制冷片监督器：联锁时序、续转、过温滞回、热端故障/未安装、功率最优与功率预算
+ */
+
+#define T0 1000u
+
+static cooling_supervisor_t make(void) {
+    cooling_supervisor_t sup;
+    cooling_model_t model;
+    cooling_model_default(&model);
+    cooling_supervisor_init(&sup, &model);
+    return sup;
+}
+
+static cooling_output_t step(cooling_supervisor_t* sup, uint8_t fan, uint8_t tec, float hot, uint32_t now) {
+    return cooling_supervisor_step(sup, (cooling_output_t){ fan, tec }, 25.0f, hot, now);
+}
+
+static void test_fan_before_tec(void) {
+    cooling_supervisor_t sup = make();
+    cooling_output_t out = step(&sup, 100, 80, 30.0f, T0);
+    CHECK_INT(out.fan, 100);
+    CHECK_INT(out.tec, 0);                          // 风扇刚启动
+    out = step(&sup, 100, 80, 30.0f, T0 + SUPERVISOR_FAN_SPINUP_MS - 1);
+    CHECK_INT(out.tec, 0);
+    out = step(&sup, 100, 80, 30.0f, T0 + SUPERVISOR_FAN_SPINUP_MS);
+    CHECK_INT(out.tec, 80);
+    CHECK(sup.fan_ready);
+}
+
+static void test_min_fan_with_tec(void) {
+    cooling_supervisor_t sup = make();
+    step(&sup, 50, 0, 30.0f, T0);
+    cooling_output_t out = step(&sup, 10, 60, 30.0f, T0 + SUPERVISOR_FAN_SPINUP_MS);
+    CHECK_INT(out.fan, SUPERVISOR_FAN_MIN_WITH_TEC);
+    CHECK_INT(out.tec, 60);
+    CHECK_INT(cooling_supervisor_limit_fan(&sup, 0), SUPERVISOR_FAN_MIN_WITH_TEC);
+    CHECK_INT(cooling_supervisor_limit_fan(&sup, 70), 70);
+}
+
+static void test_fan_run_on(void) {
+    cooling_supervisor_t sup = make();
+    step(&sup, 60, 0, 30.0f, T0);
+    step(&sup, 60, 50, 30.0f, T0 + 2000);
+    uint32_t off = T0 + 10000;
+    cooling_output_t out = step(&sup, 0, 0, 30.0f, off);
+    CHECK_INT(out.tec, 0);
+    CHECK_INT(out.fan, SUPERVISOR_FAN_MIN_WITH_TEC);
+    out = step(&sup, 0, 0, 30.0f, off + SUPERVISOR_FAN_RUNON_MS - 1);
+    CHECK_INT(out.fan, SUPERVISOR_FAN_MIN_WITH_TEC);
+    out = step(&sup, 0, 0, 30.0f, off + SUPERVISOR_FAN_RUNON_MS);
+    CHECK_INT(out.fan, 0);
+}
+
+static void test_overtemp_hysteresis(void) {
+    cooling_supervisor_t sup = make();
+    step(&sup, 60, 0, 30.0f, T0);
+    step(&sup, 60, 50, 30.0f, T0 + 2000);
+    cooling_output_t out = step(&sup, 60, 50, SUPERVISOR_HOT_CUTOFF_C, T0 + 3000);
+    CHECK(sup.overtemp);
+    CHECK_INT(sup.overtemp_trips, 1);
+    CHECK_INT(out.fan, 100);
+    CHECK_INT(out.tec, 0);
+    CHECK_INT(cooling_supervisor_limit_fan(&sup, 20), 100);
+    out = step(&sup, 60, 50, SUPERVISOR_HOT_RESUME_C + 0.5f, T0 + 4000);
+    CHECK(sup.overtemp);
+    CHECK_INT(out.tec, 0);
+    out = step(&sup, 60, 50, SUPERVISOR_HOT_RESUME_C, T0 + 5000);
+    CHECK(!sup.overtemp);
+    CHECK_INT(out.fan, 60);
+    CHECK_INT(out.tec, 50);                         // 风扇一直在最低占空比以上，无需重新等待
+    CHECK_INT(sup.overtemp_trips, 1);
+}
+
+static void test_hot_fault_and_unknown(void) {
+    cooling_supervisor_t sup = make();
+    step(&sup, 60, 0, SUPERVISOR_HOT_FAULT, T0);
+    cooling_output_t out = step(&sup, 60, 50, SUPERVISOR_HOT_FAULT, T0 + 2000);
+    CHECK_INT(out.tec, 0);                          // 已安装的热端传感器读数错误：无法保护
+    CHECK(!sup.overtemp);
+
+    // 未安装热端传感器：只有时序联锁，制冷片照常开启
+    cooling_supervisor_t bare = make();
+    step(&bare, 60, 0, SUPERVISOR_HOT_UNKNOWN, T0);
+    out = step(&bare, 60, 50, SUPERVISOR_HOT_UNKNOWN, T0 + 2000);
+    CHECK_INT(out.tec, 50);
+    CHECK_NEAR(bare.delta_t_bias, 0.0f, 0.0);
+}
+
+static void test_optimize_minimises_power(void) {
+    cooling_supervisor_t sup = make();
+    cooling_output_t none = cooling_supervisor_optimize(&sup, 0);
+    CHECK_INT(none.fan, 0);
+    CHECK_INT(none.tec, 0);
+
+    cooling_output_t low = cooling_supervisor_optimize(&sup, 10);
+    CHECK_INT(low.tec, 0);                          // 低需求只开风扇
+    CHECK(low.fan > 0);
+
+    float prev_power = 0.0f;
+    for (int demand = 10; demand <= 100; demand += 10) {
+        cooling_output_t out = cooling_supervisor_optimize(&sup, (uint8_t)demand);
+        CHECK(out.tec == 0 || out.fan >= SUPERVISOR_FAN_MIN_WITH_TEC);
+        float power = cooling_supervisor_estimate(&sup, out, NULL);
+        CHECK(power >= prev_power);
+        prev_power = power;
+    }
+    cooling_output_t full = cooling_supervisor_optimize(&sup, 100);
+    CHECK(full.tec > 0);
+}
+
+static void test_budget(void) {
+    cooling_supervisor_t sup = make();
+    cooling_supervisor_set_budget(&sup, 20.0f);
+    for (int demand = 0; demand <= 100; demand += 5) {
+        cooling_output_t out = cooling_supervisor_optimize(&sup, (uint8_t)demand);
+        CHECK(cooling_supervisor_estimate(&sup, out, NULL) <= 20.0f);
+    }
+
+    // 先削减制冷片，联锁要求的风扇不受限
+    step(&sup, 100, 0, 30.0f, T0);
+    cooling_output_t out = step(&sup, 100, 100, 30.0f, T0 + 2000);
+    CHECK(sup.budget_limited);
+    CHECK(out.fan >= SUPERVISOR_FAN_MIN_WITH_TEC);
+    CHECK(cooling_supervisor_estimate(&sup, out, NULL) <= 20.0f);
+    CHECK(out.tec > 0 && out.tec < 100);
+
+    cooling_supervisor_set_budget(&sup, -5.0f);
+    CHECK_NEAR(sup.power_budget_w, 0.0f, 0.0);
+    out = step(&sup, 100, 100, 30.0f, T0 + 3000);
+    CHECK(!sup.budget_limited);
+    CHECK_INT(out.tec, 100);
+}
+
+static void test_force_safe(void) {
+    cooling_supervisor_t sup = make();
+    step(&sup, 60, 0, 30.0f, T0);
+    step(&sup, 60, 50, 30.0f, T0 + 2000);
+    cooling_output_t out = cooling_supervisor_force_safe(&sup, T0 + 5000);
+    CHECK_INT(out.fan, 100);
+    CHECK_INT(out.tec, 0);
+    // 恢复后从续转状态接续
+    out = step(&sup, 0, 0, 30.0f, T0 + 6000);
+    CHECK_INT(out.fan, SUPERVISOR_FAN_MIN_WITH_TEC);
+    out = step(&sup, 0, 0, 30.0f, T0 + 5000 + SUPERVISOR_FAN_RUNON_MS);
+    CHECK_INT(out.fan, 0);
+}
+
+int main(void) {
+    RUN(test_fan_before_tec);
+    RUN(test_min_fan_with_tec);
+    RUN(test_fan_run_on);
+    RUN(test_overtemp_hysteresis);
+    RUN(test_hot_fault_and_unknown);
+    RUN(test_optimize_minimises_power);
+    RUN(test_budget);
+    RUN(test_force_safe);
+    return HOST_TEST_RESULT();
+}
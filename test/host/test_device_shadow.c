@@ -0,0 +1,116 @@
+#include "host_test.h"
+#include "device_shadow.h"
+
+static shadow_state_t base_state(void) {
+    return (shadow_state_t){
+        .temp_centi = 2650, .fan_speed = 50, .cooler_power = 50,
+        .auto_mode = true, .threshold_deci = 300, .max_speed = 100,
+    };
+}
+
+static void test_first_update_reports_all(void) {
+    device_shadow_t sh;
+    shadow_init(&sh);
+    shadow_state_t st = base_state();
+    CHECK_INT(shadow_update_reported(&sh, &st), SHADOW_FIELD_ALL);
+    CHECK_INT(sh.version, 1);
+    CHECK_INT(shadow_update_reported(&sh, &st), 0);
+    CHECK_INT(sh.version, 1);
+}
+
+static void test_temperature_deadband(void) {
+    device_shadow_t sh;
+    shadow_init(&sh);
+    shadow_state_t st = base_state();
+    shadow_update_reported(&sh, &st);
+    // 死区内的慢漂移不产生增量，但也不被逐步吞掉：与最后上报值比较
+    for (int i = 0; i < 9; i++) {
+        st.temp_centi++;
+        CHECK_INT(shadow_update_reported(&sh, &st), 0);
+    }
+    CHECK_INT(sh.reported.temp_centi, 2650);
+    st.temp_centi++;
+    CHECK_INT(shadow_update_reported(&sh, &st), SHADOW_FIELD_TEMP);
+    CHECK_INT(sh.reported.temp_centi, 2660);
+    CHECK_INT(sh.version, 2);
+
+    st.fan_speed = 80;
+    st.auto_mode = false;
+    CHECK_INT(shadow_update_reported(&sh, &st), SHADOW_FIELD_SPEED | SHADOW_FIELD_MODE);
+}
+
+static void test_desired_dedupe(void) {
+    device_shadow_t sh;
+    shadow_init(&sh);
+    CHECK_INT(shadow_accept_desired(&sh, 5), SHADOW_DESIRED_ACCEPTED);
+    CHECK_INT(shadow_accept_desired(&sh, 5), SHADOW_DESIRED_DUPLICATE);
+    CHECK_INT(shadow_accept_desired(&sh, 4), SHADOW_DESIRED_STALE);
+    CHECK_INT(shadow_accept_desired(&sh, 6), SHADOW_DESIRED_ACCEPTED);
+    CHECK_INT(sh.desired_version, 6);
+}
+
+static void test_format(void) {
+    device_shadow_t sh;
+    shadow_init(&sh);
+    shadow_state_t st = base_state();
+    st.temp_centi = -305;
+    st.threshold_deci = 285;
+    shadow_update_reported(&sh, &st);
+    shadow_accept_desired(&sh, 7);
+    char buf[160];
+    CHECK(shadow_format(&sh, SHADOW_FIELD_ALL, buf, sizeof(buf)) > 0);
+    CHECK_STR(buf, "{\"v\":1,\"desired_v\":7,\"temp\":-3.05,\"speed\":50,\"cooler\":50,"
+                   "\"mode\":\"auto\",\"temp_threshold\":28.5,\"max_speed\":100}");
+    CHECK(shadow_format(&sh, SHADOW_FIELD_SPEED, buf, sizeof(buf)) > 0);
+    CHECK_STR(buf, "{\"v\":1,\"desired_v\":7,\"speed\":50}");
+    // 缓冲不足返回 -1，不输出截断的 JSON
+    CHECK_INT(shadow_format(&sh, SHADOW_FIELD_ALL, buf, 40), -1);
+}
+
+/**
+ * @brief 模拟持久化：每次 shadow_reserve_version 返回非0时写入“NVS”
+ */
+static uint32_t run_updates(device_shadow_t* sh, int updates, uint32_t* nvs_limit, int* writes) {
+    shadow_state_t st = base_state();
+    uint32_t max_published = 0;
+    for (int i = 0; i < updates; i++) {
+        st.fan_speed = (uint8_t)(i % 2 ? 40 : 60);
+        if (!shadow_update_reported(sh, &st)) continue;
+        uint32_t limit = shadow_reserve_version(sh);
+        if (limit) {
+            *nvs_limit = limit;
+            (*writes)++;
+        }
+        CHECK(sh->version <= *nvs_limit);       // 发布的版本号始终已被持久化覆盖
+        max_published = sh->version;
+    }
+    return max_published;
+}
+
+static void test_version_monotonic_across_reboots(void) {
+    uint32_t nvs_limit = 0;     // 首次启动：NVS 中没有上限
+    int writes = 0;
+    uint32_t last = 0;
+    for (int boot = 0; boot < 5; boot++) {
+        device_shadow_t sh;
+        shadow_init(&sh);
+        shadow_restore_version(&sh, nvs_limit);
+        shadow_state_t st = base_state();
+        shadow_update_reported(&sh, &st);
+        if (shadow_reserve_version(&sh)) writes++, nvs_limit = sh.version_limit;
+        CHECK(sh.version > last);
+        if (boot == 0) CHECK_INT(sh.version, 1);
+        last = run_updates(&sh, 300 + boot * 7, &nvs_limit, &writes);
+    }
+    // 每段 SHADOW_VERSION_BLOCK 个版本号只写一次，另加每次启动一次
+    CHECK(writes <= 5 + (int)(last / SHADOW_VERSION_BLOCK) + 1);
+}
+
+int main(void) {
+    RUN(test_first_update_reports_all);
+    RUN(test_temperature_deadband);
+    RUN(test_desired_dedupe);
+    RUN(test_format);
+    RUN(test_version_monotonic_across_reboots);
+    return HOST_TEST_RESULT();
+}
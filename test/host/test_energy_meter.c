@@ -0,0 +1,92 @@
+#include "host_test.h"
+#include "energy_meter.h"
+
+/**
+ * @brief 电能计量：零阶保持积分、占空比切换边界、亚毫焦余量、时间回退与接续累计
+ */
+
+#define T0 1000000
+
+static cooling_model_t model(void) {
+    cooling_model_t m;
+    cooling_model_default(&m);
+    m.fan_power_max = 2.0f;
+    m.fan_power_exp = 1.0f;
+    m.tec_power_max = 40.0f;
+    m.tec_power_exp = 1.0f;
+    return m;
+}
+
+static void test_zero_order_hold(void) {
+    cooling_model_t m = model();
+    energy_meter_t em;
+    energy_meter_init(&em, 0, 0, T0);
+    energy_meter_update(&em, &m, (cooling_output_t){ 100, 50 }, T0);
+    CHECK_INT(em.fan_mj, 0);                        // 切换时刻之前占空比为 0
+    energy_meter_update(&em, &m, (cooling_output_t){ 100, 50 }, T0 + 1000000);
+    CHECK_INT(em.fan_mj, 2000);                     // 2W × 1s
+    CHECK_INT(em.tec_mj, 20000);                    // 20W × 1s
+}
+
+static void test_switch_uses_previous_duty(void) {
+    cooling_model_t m = model();
+    energy_meter_t em;
+    energy_meter_init(&em, 0, 0, T0);
+    energy_meter_update(&em, &m, (cooling_output_t){ 50, 0 }, T0);
+    energy_meter_update(&em, &m, (cooling_output_t){ 0, 0 }, T0 + 2000000);
+    CHECK_INT(em.fan_mj, 2000);                     // 1W × 2s，新占空比不回溯
+    energy_meter_update(&em, &m, (cooling_output_t){ 0, 0 }, T0 + 10000000);
+    CHECK_INT(em.fan_mj, 2000);
+    CHECK_NEAR(em.fan_w, 0.0, 1e-9);
+}
+
+static void test_residual_has_no_drift(void) {
+    cooling_model_t m = model();
+    energy_meter_t em;
+    energy_meter_init(&em, 0, 0, T0);
+    energy_meter_update(&em, &m, (cooling_output_t){ 25, 0 }, T0);
+    // 0.5W 每 1ms 积分一次：每步 0.5mJ，逐步截断会丢掉一半
+    int64_t now = T0;
+    for (int i = 0; i < 100000; i++) {
+        now += 1000;
+        energy_meter_update(&em, &m, (cooling_output_t){ 25, 0 }, now);
+    }
+    CHECK_INT(em.fan_mj, 50000);
+    CHECK(em.fan_residual_mj >= 0.0f && em.fan_residual_mj < 1.0f);
+}
+
+static void test_time_going_backwards_is_ignored(void) {
+    cooling_model_t m = model();
+    energy_meter_t em;
+    energy_meter_init(&em, 0, 0, T0);
+    energy_meter_update(&em, &m, (cooling_output_t){ 100, 100 }, T0);
+    energy_meter_update(&em, &m, (cooling_output_t){ 100, 100 }, T0 - 500000);
+    CHECK_INT(em.fan_mj, 0);
+    CHECK_INT(em.tec_mj, 0);
+    CHECK_INT(em.last_us, T0);
+    energy_meter_update(&em, &m, (cooling_output_t){ 100, 100 }, T0 + 1000);
+    CHECK_INT(em.fan_mj, 2);
+    CHECK_INT(em.tec_mj, 40);
+}
+
+static void test_resume_and_kwh(void) {
+    cooling_model_t m = model();
+    energy_meter_t em;
+    energy_meter_init(&em, 3600000000ull, 7200000000ull, T0);   // 1kWh / 2kWh
+    energy_meter_update(&em, &m, (cooling_output_t){ 100, 0 }, T0);
+    energy_meter_update(&em, &m, (cooling_output_t){ 100, 0 }, T0 + 1000000);
+    CHECK_INT(em.fan_mj, 3600002000ull);
+    CHECK_INT(em.tec_mj, 7200000000ull);
+    CHECK_NEAR(energy_meter_kwh(em.fan_mj), 1.0, 1e-6);
+    CHECK_NEAR(energy_meter_kwh(em.tec_mj), 2.0, 1e-6);
+    CHECK_NEAR(energy_meter_kwh(999), 0.0, 1e-12);               // 不足 1J 不计入
+}
+
+int main(void) {
+    RUN(test_zero_order_hold);
+    RUN(test_switch_uses_previous_duty);
+    RUN(test_residual_has_no_drift);
+    RUN(test_time_going_backwards_is_ignored);
+    RUN(test_resume_and_kwh);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,144 @@
+#include "host_test.h"
+#include "fan_calibration.h"
+#include <math.h>
+
+/**
+ * @brief 风扇校准扫描：余热排出、逐级稳定与计数窗口、带惯性的风扇模型下的结果、失败与中止
+ */
+
+#define TICK_MS 100
+#define T0      5000u
+
+// 与 gen_fan_curve.py 相同的默认风扇模型，转速按一阶惯性跟随占空比
+typedef struct {
+    float rpm;
+    float pulse_frac;
+    bool tach;                  // 未接测速线时不出脉冲
+} fan_sim_t;
+
+static float steady_rpm(uint16_t duty_pm) {
+    float duty = duty_pm / 1000.0f;
+    if (duty <= 0.20f) return 0.0f;
+    float t = fminf((duty - 0.20f) / 0.70f, 1.0f);
+    return 3000.0f * (1.0f - (1.0f - t) * (1.0f - t));
+}
+
+static uint32_t fan_tick(fan_sim_t* fan, uint16_t duty_pm) {
+    fan->rpm += (steady_rpm(duty_pm) - fan->rpm) * (TICK_MS / 500.0f);   // 时间常数 500ms
+    if (!fan->tach) return 0;
+    fan->pulse_frac += fan->rpm * FAN_CAL_PULSES_PER_REV / 60.0f * TICK_MS / 1000.0f;
+    uint32_t pulses = (uint32_t)fan->pulse_frac;
+    fan->pulse_frac -= pulses;
+    return pulses;
+}
+
+/**
+ * @brief 跑完整个校准，返回耗时（毫秒）
+ */
+static uint32_t run(fan_cal_t* cal, fan_sim_t* fan, uint32_t purge_ms, uint16_t first_duty) {
+    uint32_t now = T0;
+    fan_cal_start(cal, purge_ms, now);
+    uint16_t duty = first_duty;
+    while (cal->phase == FAN_CAL_PURGE || cal->phase == FAN_CAL_SWEEP) {
+        uint32_t pulses = fan_tick(fan, duty);
+        now += TICK_MS;
+        duty = fan_cal_step(cal, pulses, now);
+        if (now - T0 > 10u * 60 * 1000) break;
+    }
+    return now - T0;
+}
+
+static void test_sweep_builds_curve(void) {
+    fan_cal_t cal;
+    fan_sim_t fan = { .rpm = 3000.0f, .tach = true };   // 从全速开始，检验稳定等待
+    uint32_t elapsed = run(&cal, &fan, 0, 0);
+
+    CHECK_INT(cal.phase, FAN_CAL_DONE);
+    CHECK_INT(fan_cal_progress(&cal), 100);
+    // 采样周期与稳定边界对齐时不丢周期：每级恰好是稳定等待 + 计数窗口
+    CHECK_INT(elapsed, FAN_CAL_STEPS * (FAN_CAL_SETTLE_MS + FAN_CAL_MEASURE_MS));
+    for (int i = 0; i < FAN_CAL_STEPS; i++) {
+        CHECK_INT(cal.duty_pm[i], i * 50);
+        CHECK_NEAR(cal.rpm[i], steady_rpm(cal.duty_pm[i]), 20.0);   // 稳定等待丢弃了惯性
+    }
+    CHECK(fan_curve_valid(&cal.curve));
+    fan_curve_t expected;
+    fan_curve_default(&expected);
+    for (int i = 0; i < FAN_CURVE_POINTS; i++) {
+        CHECK_NEAR(cal.curve.duty_pm[i], expected.duty_pm[i], 15);
+    }
+    CHECK_INT(fan_cal_step(&cal, 100, T0 + elapsed + TICK_MS), 0);  // 结束后不再输出
+}
+
+static void test_purge_runs_full_speed(void) {
+    fan_cal_t cal;
+    fan_cal_start(&cal, 30000, T0);
+    CHECK_INT(cal.phase, FAN_CAL_PURGE);
+    CHECK_INT(fan_cal_progress(&cal), 0);
+    uint32_t now = T0;
+    int full = 0;
+    while (now - T0 < 30000) {
+        now += TICK_MS;
+        full += fan_cal_step(&cal, 50, now) == FAN_CURVE_DUTY_MAX;
+    }
+    CHECK_INT(full, 30000 / TICK_MS - 1);
+    CHECK_INT(cal.phase, FAN_CAL_SWEEP);
+    CHECK_INT(cal.step, 0);
+    CHECK_INT(cal.pulses, 0);                            // 排热期间的脉冲不计入第 0 级
+
+    fan_sim_t fan = { .tach = true };
+    CHECK(run(&cal, &fan, 30000, FAN_CURVE_DUTY_MAX) > 30000);
+    CHECK_INT(cal.phase, FAN_CAL_DONE);
+}
+
+static void test_progress_is_monotonic(void) {
+    fan_cal_t cal;
+    fan_sim_t fan = { .tach = true };
+    uint32_t now = T0;
+    fan_cal_start(&cal, 0, now);
+    uint16_t duty = 0;
+    uint8_t prev = 0;
+    int monotonic = 1;
+    while (cal.phase == FAN_CAL_SWEEP) {
+        now += TICK_MS;
+        duty = fan_cal_step(&cal, fan_tick(&fan, duty), now);
+        uint8_t p = fan_cal_progress(&cal);
+        monotonic &= p >= prev;
+        prev = p;
+    }
+    CHECK(monotonic);
+    CHECK_INT(prev, 100);
+}
+
+static void test_no_tach_fails(void) {
+    fan_cal_t cal;
+    fan_sim_t fan = { .tach = false };
+    run(&cal, &fan, 0, 0);
+    CHECK_INT(cal.phase, FAN_CAL_FAILED);
+    CHECK_INT(fan_cal_progress(&cal), 0);
+}
+
+static void test_abort(void) {
+    fan_cal_t cal;
+    fan_cal_start(&cal, 0, T0);
+    for (uint32_t t = T0 + TICK_MS; t < T0 + 20000; t += TICK_MS) fan_cal_step(&cal, 10, t);
+    CHECK(cal.step > 0);
+    fan_cal_abort(&cal);
+    CHECK_INT(cal.phase, FAN_CAL_FAILED);
+    CHECK_INT(fan_cal_step(&cal, 10, T0 + 20000), 0);
+
+    // 已完成的结果不被中止覆盖
+    fan_sim_t fan = { .tach = true };
+    run(&cal, &fan, 0, 0);
+    fan_cal_abort(&cal);
+    CHECK_INT(cal.phase, FAN_CAL_DONE);
+}
+
+int main(void) {
+    RUN(test_sweep_builds_curve);
+    RUN(test_purge_runs_full_speed);
+    RUN(test_progress_is_monotonic);
+    RUN(test_no_tach_fails);
+    RUN(test_abort);
+    return HOST_TEST_RESULT();
+}
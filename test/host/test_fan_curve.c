@@ -0,0 +1,141 @@
+#include "host_test.h"
+#include "fan_curve.h"
+#include <math.h>
+
+/**
+ * @brief 风扇线性化表：生成的默认表、查表插值、有效性检查，以及扫频结果的保序回归与反插值
+ */
+
+// 与 gen_fan_curve.py 相同的默认风扇模型
+static float model_airflow(float duty) {
+    if (duty <= 0.20f) return 0.0f;
+    float t = fminf((duty - 0.20f) / 0.70f, 1.0f);
+    return 1.0f - (1.0f - t) * (1.0f - t);
+}
+
+static void test_default_table(void) {
+    fan_curve_t c;
+    fan_curve_default(&c);
+    CHECK(fan_curve_valid(&c));
+    CHECK_INT(c.duty_pm[0], 0);
+    CHECK_INT(c.duty_pm[FAN_CURVE_POINTS - 1], 900);    // 饱和点
+    CHECK_NEAR(c.duty_pm[1], 218, 1);                   // 5% 气流刚过死区
+    CHECK_NEAR(c.duty_pm[10], 405, 1);                  // 50% 气流
+    // 每个点都是模型的反解
+    for (int i = 1; i < FAN_CURVE_POINTS; i++) {
+        CHECK_NEAR(model_airflow(c.duty_pm[i] / 1000.0f), i / 20.0, 0.01);
+    }
+}
+
+static void test_lookup(void) {
+    fan_curve_t c;
+    fan_curve_default(&c);
+    CHECK_INT(fan_curve_duty(&c, 0), 0);
+    for (uint8_t pct = 1; pct < FAN_CURVE_STEP; pct++) {
+        CHECK_INT(fan_curve_duty(&c, pct), c.duty_pm[1]);  // 不插值到死区里
+    }
+    CHECK_INT(fan_curve_duty(&c, 5), c.duty_pm[1]);
+    CHECK_INT(fan_curve_duty(&c, 50), c.duty_pm[10]);
+    CHECK_INT(fan_curve_duty(&c, 7), c.duty_pm[1] + (c.duty_pm[2] - c.duty_pm[1]) * 2 / 5);
+    CHECK_INT(fan_curve_duty(&c, 100), 900);
+    CHECK_INT(fan_curve_duty(&c, 255), 900);
+
+    uint16_t prev = 0;
+    int monotonic = 1;
+    for (int pct = 0; pct <= 100; pct++) {
+        uint16_t d = fan_curve_duty(&c, (uint8_t)pct);
+        monotonic &= d >= prev;
+        prev = d;
+    }
+    CHECK(monotonic);
+}
+
+static void test_validity(void) {
+    fan_curve_t c;
+    fan_curve_default(&c);
+    c.duty_pm[0] = 10;
+    CHECK(!fan_curve_valid(&c));
+
+    fan_curve_default(&c);
+    c.duty_pm[7] = c.duty_pm[6] - 1;
+    CHECK(!fan_curve_valid(&c));
+
+    fan_curve_default(&c);
+    c.duty_pm[FAN_CURVE_POINTS - 1] = FAN_CURVE_DUTY_MAX + 1;
+    CHECK(!fan_curve_valid(&c));
+
+    memset(&c, 0, sizeof(c));
+    CHECK(!fan_curve_valid(&c));                        // 全零表：风扇永远不转
+}
+
+static void sweep(float (*rpm_at)(float), uint16_t* duty, float* rpm) {
+    for (int i = 0; i < FAN_CURVE_POINTS; i++) {
+        duty[i] = (uint16_t)(i * 50);
+        rpm[i] = rpm_at(duty[i] / 1000.0f);
+    }
+}
+
+static float model_rpm(float duty) {
+    return 3000.0f * model_airflow(duty);
+}
+
+static void test_build_matches_model(void) {
+    uint16_t duty[FAN_CURVE_POINTS];
+    float rpm[FAN_CURVE_POINTS];
+    sweep(model_rpm, duty, rpm);
+
+    fan_curve_t built, expected;
+    CHECK(fan_curve_build(duty, rpm, FAN_CURVE_POINTS, &built));
+    CHECK(fan_curve_valid(&built));
+    fan_curve_default(&expected);
+    // 50‰ 采样间隔上线性反插值，误差来自曲线弯曲
+    for (int i = 0; i < FAN_CURVE_POINTS; i++) {
+        CHECK_NEAR(built.duty_pm[i], expected.duty_pm[i], 15);
+    }
+}
+
+static void test_build_isotonic(void) {
+    uint16_t duty[FAN_CURVE_POINTS];
+    float rpm[FAN_CURVE_POINTS];
+    sweep(model_rpm, duty, rpm);
+    // 测量噪声造成的违序、负值读数
+    rpm[12] = rpm[10];
+    rpm[13] = rpm[9];
+    rpm[3] = -50.0f;
+
+    fan_curve_t c;
+    CHECK(fan_curve_build(duty, rpm, FAN_CURVE_POINTS, &c));
+    CHECK(fan_curve_valid(&c));
+    CHECK_INT(c.duty_pm[0], 0);
+}
+
+static void test_build_rejects(void) {
+    uint16_t duty[FAN_CURVE_POINTS];
+    float rpm[FAN_CURVE_POINTS];
+    fan_curve_t c, before;
+    fan_curve_default(&c);
+    before = c;
+
+    sweep(model_rpm, duty, rpm);
+    for (int i = 0; i < FAN_CURVE_POINTS; i++) rpm[i] = 0.0f;   // 未接测速线
+    CHECK(!fan_curve_build(duty, rpm, FAN_CURVE_POINTS, &c));
+    for (int i = 0; i < FAN_CURVE_POINTS; i++) rpm[i] = 1500.0f; // 转速不随占空比变化
+    CHECK(!fan_curve_build(duty, rpm, FAN_CURVE_POINTS, &c));
+    for (int i = 0; i < FAN_CURVE_POINTS; i++) rpm[i] = 3000.0f - i * 100.0f; // 反向
+    CHECK(!fan_curve_build(duty, rpm, FAN_CURVE_POINTS, &c));
+
+    sweep(model_rpm, duty, rpm);
+    CHECK(!fan_curve_build(duty, rpm, 2, &c));
+    CHECK(!fan_curve_build(duty, rpm, 65, &c));
+    CHECK(memcmp(&c, &before, sizeof(c)) == 0);          // 失败时输出不变
+}
+
+int main(void) {
+    RUN(test_default_table);
+    RUN(test_lookup);
+    RUN(test_validity);
+    RUN(test_build_matches_model);
+    RUN(test_build_isotonic);
+    RUN(test_build_rejects);
+    return HOST_TEST_RESULT();
+}
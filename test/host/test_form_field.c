@@ -0,0 +1,75 @@
+#include "host_test.h"
+#include "form_field.h"
+
+static void test_exact_key_match(void) {
+    const char body[] = "xssid=evil&password=ssid%3Dfake&ssid=home";
+    char out[32];
+    CHECK_INT(form_field_get(body, sizeof(body) - 1, "ssid", out, sizeof(out)), FORM_FIELD_OK);
+    CHECK_STR(out, "home");
+    CHECK_INT(form_field_get(body, sizeof(body) - 1, "password", out, sizeof(out)), FORM_FIELD_OK);
+    CHECK_STR(out, "ssid=fake");
+}
+
+static void test_decoding(void) {
+    const char body[] = "ssid=My+Net%21&password=%e4%b8%ad";
+    char out[32];
+    CHECK_INT(form_field_get(body, sizeof(body) - 1, "ssid", out, sizeof(out)), FORM_FIELD_OK);
+    CHECK_STR(out, "My Net!");
+    CHECK_INT(form_field_get(body, sizeof(body) - 1, "password", out, sizeof(out)), FORM_FIELD_OK);
+    CHECK_STR(out, "\xe4\xb8\xad");
+}
+
+static void test_missing_and_empty(void) {
+    char out[8] = "junk";
+    CHECK_INT(form_field_get("a=1&b", 5, "c", out, sizeof(out)), FORM_FIELD_MISSING);
+    CHECK_STR(out, "");
+    CHECK_INT(form_field_get("a=1&b", 5, "b", out, sizeof(out)), FORM_FIELD_OK);
+    CHECK_STR(out, "");
+    CHECK_INT(form_field_get("", 0, "a", out, sizeof(out)), FORM_FIELD_MISSING);
+    CHECK_INT(form_field_get("&&&", 3, "a", out, sizeof(out)), FORM_FIELD_MISSING);
+}
+
+static void test_length_limits(void) {
+    char out[4];
+    CHECK_INT(form_field_get("k=abc", 5, "k", out, sizeof(out)), FORM_FIELD_OK);
+    CHECK_STR(out, "abc");
+    CHECK_INT(form_field_get("k=abcd", 6, "k", out, sizeof(out)), FORM_FIELD_TOO_LONG);
+    CHECK_STR(out, "");
+    // 长度之外的字节不参与解析
+    CHECK_INT(form_field_get("k=ab&k2=zz", 4, "k", out, sizeof(out)), FORM_FIELD_OK);
+    CHECK_STR(out, "ab");
+    CHECK_INT(form_field_get("k=a", 3, "k", out, 0), FORM_FIELD_TOO_LONG);
+}
+
+static void test_bad_encoding(void) {
+    char out[16];
+    CHECK_INT(form_field_get("k=%", 3, "k", out, sizeof(out)), FORM_FIELD_BAD_ENCODING);
+    CHECK_INT(form_field_get("k=%4", 4, "k", out, sizeof(out)), FORM_FIELD_BAD_ENCODING);
+    CHECK_INT(form_field_get("k=%zz", 5, "k", out, sizeof(out)), FORM_FIELD_BAD_ENCODING);
+    CHECK_INT(form_field_get("k=a%00b", 7, "k", out, sizeof(out)), FORM_FIELD_BAD_ENCODING);
+    CHECK_STR(out, "");
+    // "%4" 在长度边界处截断，后面的字节不可读
+    CHECK_INT(form_field_get("k=%41", 4, "k", out, sizeof(out)), FORM_FIELD_BAD_ENCODING);
+}
+
+static void test_url_decode(void) {
+    char out[8];
+    CHECK_INT(form_url_decode("a%20b+c", 7, out, sizeof(out)), 5);
+    CHECK_STR(out, "a b c");
+    CHECK_INT(form_url_decode("1234567", 7, out, sizeof(out)), 7);
+    CHECK_INT(form_url_decode("12345678", 8, out, sizeof(out)), -1);
+    CHECK_STR(out, "");
+    CHECK_INT(form_url_decode("%G0", 3, out, sizeof(out)), -1);
+    CHECK_INT(form_url_decode("", 0, out, sizeof(out)), 0);
+    CHECK_STR(out, "");
+}
+
+int main(void) {
+    RUN(test_exact_key_match);
+    RUN(test_decoding);
+    RUN(test_missing_and_empty);
+    RUN(test_length_limits);
+    RUN(test_bad_encoding);
+    RUN(test_url_decode);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,189 @@
+#include "host_test.h"
+#include "history.h"
+
+/**
+ * @brief 运行历史：原始环形缓冲、间隙填充、慢采样逐秒保持、两级汇总的精确性、分辨率选择、LTTB 降采样、JSON 序列化
+ */
+
+static history_t s_hist;        // 约 26KB，不放在栈上
+static history_point_t s_points[HISTORY_MAX_POINTS];
+
+static history_sample_t sample(int16_t temp, uint8_t fan) {
+    return (history_sample_t){ .temp_centi = temp, .fan = fan, .tec = (uint8_t)(fan / 2) };
+}
+
+static void test_raw_insert_and_query(void) {
+    history_init(&s_hist);
+    uint32_t res = 0;
+    CHECK_INT(history_query(&s_hist, 10, 0, HISTORY_FIELD_TEMP, 50, s_points, &res), 0);
+    for (uint32_t t = 100; t < 110; t++) history_insert(&s_hist, t, sample((int16_t)(2500 + t), 40));
+    size_t n = history_query(&s_hist, 9, 0, HISTORY_FIELD_TEMP, 50, s_points, &res);
+    CHECK_INT(res, 1);
+    CHECK_INT(n, 10);
+    CHECK_INT(s_points[0].ago_s, 9);
+    CHECK_INT(s_points[0].value, 2600);
+    CHECK_INT(s_points[9].ago_s, 0);
+    CHECK_INT(s_points[9].value, 2609);
+    CHECK_INT(history_query(&s_hist, 0, 3, HISTORY_FIELD_FAN, 50, s_points, &res), 4);   // 起止颠倒
+    CHECK_INT(s_points[0].value, 40);
+
+    // 同一秒覆盖，时间倒退忽略
+    history_insert(&s_hist, 109, sample(1234, 40));
+    history_insert(&s_hist, 50, sample(999, 40));
+    n = history_query(&s_hist, 0, 0, HISTORY_FIELD_TEMP, 50, s_points, &res);
+    CHECK_INT(n, 1);
+    CHECK_INT(s_points[0].value, 1234);
+    CHECK_INT(s_hist.raw_count, 10);
+}
+
+static void test_gaps_and_invalid(void) {
+    history_init(&s_hist);
+    history_insert(&s_hist, 10, sample(2000, 10));
+    history_insert(&s_hist, 11, sample(HISTORY_INVALID, 10));
+    history_insert(&s_hist, 15, sample(2100, 10));       // 12~14 保持上一个（无效）样本
+    CHECK_INT(s_hist.raw_count, 6);
+    uint32_t res;
+    size_t n = history_query(&s_hist, 5, 0, HISTORY_FIELD_TEMP, 50, s_points, &res);
+    CHECK_INT(n, 2);
+    CHECK_INT(s_points[0].ago_s, 5);
+    CHECK_INT(s_points[1].ago_s, 0);
+    // 温度无效的样本整体视为缺失（风扇字段同样跳过）
+    CHECK_INT(history_query(&s_hist, 5, 0, HISTORY_FIELD_FAN, 50, s_points, &res), 2);
+
+    // 超过整个缓冲的间隙不会无限循环
+    history_insert(&s_hist, 15 + 10 * HISTORY_RAW_LEN, sample(2200, 10));
+    CHECK_INT(s_hist.raw_count, HISTORY_RAW_LEN);
+    CHECK_INT(history_query(&s_hist, HISTORY_RAW_LEN - 1, 0, HISTORY_FIELD_TEMP, 50, s_points, &res), 1);
+}
+
+static void test_slow_cadence_held(void) {
+    history_init(&s_hist);
+    // 负载低时采样周期拉长到 5 秒：1 秒分辨率的最近 1 小时不出现缺失
+    const uint32_t t0 = 6000;
+    uint32_t t;
+    for (t = t0; t <= t0 + 3600 + 60; t += 5) {
+        uint32_t step = (t / 5) % 12;
+        history_insert(&s_hist, t, sample((int16_t)(2000 + step * 10), (uint8_t)(step < 6 ? 20 : 80)));
+    }
+    t -= 5;
+    CHECK_INT(s_hist.raw_count, HISTORY_RAW_LEN);
+    int invalid = 0;
+    for (int i = 0; i < HISTORY_RAW_LEN; i++) invalid += s_hist.raw[i].temp_centi == HISTORY_INVALID;
+    CHECK_INT(invalid, 0);
+
+    // 两次采样之间的秒等于前一次采样
+    uint32_t res;
+    size_t n = history_query(&s_hist, 9, 0, HISTORY_FIELD_TEMP, 50, s_points, &res);
+    CHECK_INT(res, 1);
+    CHECK_INT(n, 10);
+    for (size_t i = 0; i < n; i++) {
+        uint32_t at = t - s_points[i].ago_s;
+        CHECK_INT(s_points[i].value, 2000 + (int)((at - at % 5) / 5 % 12) * 10);
+    }
+
+    // 汇总按时间加权：每个样本计 5 秒
+    n = history_query(&s_hist, 3600 + 30, 0, HISTORY_FIELD_TEMP, HISTORY_MAX_POINTS, s_points, &res);
+    CHECK_INT(res, HISTORY_L1_PERIOD_S);
+    CHECK_INT(s_points[0].min, 2000);
+    CHECK_INT(s_points[0].max, 2110);
+    CHECK_INT(s_points[0].value, 2055);
+    history_query(&s_hist, 3600 + 30, 0, HISTORY_FIELD_FAN, HISTORY_MAX_POINTS, s_points, &res);
+    CHECK_INT(s_points[0].value, 50);
+
+    // 达到保持时限的间隙仍按缺失处理
+    history_insert(&s_hist, t + HISTORY_HOLD_S + 1, sample(2500, 10));
+    CHECK_INT(s_hist.raw[(s_hist.raw_head + HISTORY_RAW_LEN - 2) % HISTORY_RAW_LEN].temp_centi, HISTORY_INVALID);
+    CHECK_INT(s_hist.raw[(s_hist.raw_head + HISTORY_RAW_LEN - 1) % HISTORY_RAW_LEN].temp_centi, 2500);
+}
+
+static void test_rollups_exact(void) {
+    history_init(&s_hist);
+    // 2 小时 1Hz：温度按分钟内序号变化，汇总桶 min/max/avg 可精确预期
+    const uint32_t t0 = 6000;           // 桶边界对齐（6000 = 100 × 60）
+    for (uint32_t t = t0; t < t0 + 2 * 3600; t++) {
+        uint32_t sec = t % 60;
+        history_insert(&s_hist, t, sample((int16_t)(2000 + sec * 10), (uint8_t)(sec < 30 ? 20 : 80)));
+    }
+    uint32_t res;
+    size_t n = history_query(&s_hist, 2 * 3600 - 60, 0, HISTORY_FIELD_TEMP, HISTORY_MAX_POINTS, s_points, &res);
+    CHECK_INT(res, HISTORY_L1_PERIOD_S);
+    CHECK_INT(n, 119);                  // 当前分钟的桶尚未完成
+    CHECK_INT(s_points[0].min, 2000);
+    CHECK_INT(s_points[0].max, 2590);
+    CHECK_INT(s_points[0].value, 2295);
+    CHECK_INT(s_points[n - 1].ago_s, 119);
+    n = history_query(&s_hist, 2 * 3600 - 60, 0, HISTORY_FIELD_FAN, HISTORY_MAX_POINTS, s_points, &res);
+    CHECK_INT(s_points[0].value, 50);
+
+    // L2：由完成的 L1 桶合并，总和精确（而不是均值的均值）
+    for (uint32_t t = t0 + 2 * 3600; t < t0 + 26 * 3600; t++) {
+        uint32_t sec = t % 60;
+        history_insert(&s_hist, t, sample((int16_t)(2000 + sec * 10), (uint8_t)(sec < 30 ? 20 : 80)));
+    }
+    n = history_query(&s_hist, 20 * 3600, 0, HISTORY_FIELD_TEMP, HISTORY_MAX_POINTS, s_points, &res);
+    CHECK_INT(res, HISTORY_L2_PERIOD_S);
+    CHECK(n >= 80);
+    CHECK_INT(s_points[0].min, 2000);
+    CHECK_INT(s_points[0].max, 2590);
+    CHECK_INT(s_points[0].value, 2295);
+
+    // 超出所有级别的起点：返回最粗级别的全部数据
+    history_query(&s_hist, 30 * 24 * 3600, 0, HISTORY_FIELD_TEMP, HISTORY_MAX_POINTS, s_points, &res);
+    CHECK_INT(res, HISTORY_L2_PERIOD_S);
+}
+
+static void test_lttb_keeps_extremes(void) {
+    history_init(&s_hist);
+    for (uint32_t t = 1; t <= HISTORY_RAW_LEN; t++) {
+        int16_t temp = 2500 + (int16_t)(t % 20);
+        if (t == 1234) temp = 4000;     // 单个尖峰
+        if (t == 2500) temp = 1000;
+        history_insert(&s_hist, t, sample(temp, 50));
+    }
+    uint32_t res;
+    size_t n = history_query(&s_hist, HISTORY_RAW_LEN - 1, 0, HISTORY_FIELD_TEMP, 50, s_points, &res);
+    CHECK_INT(res, 1);
+    CHECK_INT(n, 50);
+    CHECK_INT(s_points[0].ago_s, HISTORY_RAW_LEN - 1);
+    CHECK_INT(s_points[n - 1].ago_s, 0);
+    bool spike = false, dip = false, ordered = true;
+    for (size_t i = 0; i < n; i++) {
+        spike |= s_points[i].value == 4000;
+        dip |= s_points[i].value == 1000;
+        if (i > 0) ordered &= s_points[i].ago_s < s_points[i - 1].ago_s;
+    }
+    CHECK(spike);
+    CHECK(dip);
+    CHECK(ordered);
+
+    // 点数限制在 [3, HISTORY_MAX_POINTS]
+    CHECK_INT(history_query(&s_hist, HISTORY_RAW_LEN - 1, 0, HISTORY_FIELD_TEMP, 1, s_points, &res), 3);
+    CHECK_INT(history_query(&s_hist, HISTORY_RAW_LEN - 1, 0, HISTORY_FIELD_TEMP, 100000, s_points, &res),
+              HISTORY_MAX_POINTS);
+}
+
+static void test_format_json(void) {
+    history_point_t pts[] = { { 120, 2500, 2400, 2600 }, { 60, 2550, 2500, 2610 } };
+    char buf[160];
+    CHECK(history_format_json("q1", HISTORY_FIELD_TEMP, 900, 60, pts, 2, buf, sizeof(buf)) > 0);
+    CHECK_STR(buf, "{\"id\":\"q1\",\"field\":\"temp\",\"res_s\":60,\"now_s\":900,"
+                   "\"p\":[[120,2500,2400,2600],[60,2550,2500,2610]]}");
+    CHECK(history_format_json(NULL, HISTORY_FIELD_FAN, 900, 1, pts, 1, buf, sizeof(buf)) > 0);
+    CHECK_STR(buf, "{\"id\":\"\",\"field\":\"fan\",\"res_s\":1,\"now_s\":900,\"p\":[[120,2500]]}");
+    CHECK_INT(history_format_json("q1", HISTORY_FIELD_TEMP, 900, 60, pts, 2, buf, 60), -1);
+    CHECK_INT(history_format_json("q1", HISTORY_FIELD_TEMP, 900, 60, pts, 0, buf, 5), -1);
+
+    history_field_t f;
+    CHECK(history_field_from_name("tec", &f) && f == HISTORY_FIELD_TEC);
+    CHECK(!history_field_from_name("temperature", &f));
+}
+
+int main(void) {
+    RUN(test_raw_insert_and_query);
+    RUN(test_gaps_and_invalid);
+    RUN(test_slow_cadence_held);
+    RUN(test_rollups_exact);
+    RUN(test_lttb_keeps_extremes);
+    RUN(test_format_json);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,247 @@
+#include "host_test.h"
+#include "host_stubs.h"
+#include "lan_api.h"
+#include "nvs.h"
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * @brief 局域网接口：写接口鉴权与 WebSocket 扇出负载
+ *        lan_api_start 每个进程只能调用一次，--no-token 在未设置令牌的设备上运行
+ */
+
+#define TOKEN       "fan-lan-token-01"
+#define AUTH        "Bearer " TOKEN
+#define MAX_SOCKETS 10      // LAN_API_MAX_CLIENTS
+#define WS_CLIENTS  (MAX_SOCKETS - 1)
+#define HTTP_FD     WS_CLIENTS
+#define LATE_FD     (MAX_SOCKETS + 1)
+#define UPDATES     20000
+
+static int s_commands;
+static int s_configs;
+
+static void on_command(const mqtt_command_t* cmd, mqtt_command_ack_t* ack) {
+    s_commands++;
+}
+
+static void on_config(const mqtt_config_t* cfg) {
+    s_configs++;
+}
+
+static void start(bool with_token) {
+    host_nvs_reset();
+    host_httpd_reset();
+    if (with_token) {
+        nvs_handle_t h;
+        nvs_open("storage", NVS_READWRITE, &h);
+        nvs_set_str(h, "api_token", TOKEN);
+        nvs_commit(h);
+        nvs_close(h);
+    }
+    mqtt_comm_init();
+    lan_api_set_command_callback(on_command);
+    lan_api_set_config_callback(on_config);
+    lan_api_start();
+}
+
+static unsigned long frame_version(const char* frame) {
+    const char* v = strstr(frame, "\"v\":");
+    return v ? strtoul(v + 4, NULL, 10) : 0;
+}
+
+static lan_state_t state_at(int i) {
+    return (lan_state_t){
+        .temperature = 20.0f + (i % 400) * 0.0625f,
+        .fan_speed = (uint8_t)(i % 101),
+        .cooler_power = (uint8_t)((i / 7) % 101),
+        .auto_mode = (i / 1000) % 2 == 0,
+    };
+}
+
+static void test_write_requires_token(void) {
+    host_http_resp_t resp;
+    s_commands = s_configs = 0;
+    host_httpd_request(1, HTTP_POST, "/api/command", NULL, "{\"speed\":40}", &resp);
+    CHECK_INT(resp.status, 401);
+    CHECK_STR(resp.www_authenticate, "Bearer");
+    host_httpd_request(1, HTTP_POST, "/api/command", "Bearer wrong-token-000", "{\"speed\":40}", &resp);
+    CHECK_INT(resp.status, 401);
+    host_httpd_request(1, HTTP_POST, "/api/config", "Basic " TOKEN, "{\"max_speed\":80}", &resp);
+    CHECK_INT(resp.status, 401);
+    CHECK_INT(s_commands + s_configs, 0);
+
+    host_httpd_request(1, HTTP_POST, "/api/command", AUTH, "{\"speed\":40,\"id\":\"a1\"}", &resp);
+    CHECK_INT(resp.status, 200);
+    CHECK(strstr(resp.body, "\"a1\"") != NULL);
+    host_httpd_request(1, HTTP_POST, "/api/config", AUTH, "{\"max_speed\":80}", &resp);
+    CHECK_INT(resp.status, 200);
+    CHECK_INT(s_commands, 1);
+    CHECK_INT(s_configs, 1);
+
+    // 读接口无需鉴权
+    host_httpd_request(1, HTTP_GET, "/api/state", NULL, NULL, &resp);
+    CHECK_INT(resp.status, 200);
+    CHECK(strstr(resp.body, "\"v\":") != NULL);
+    host_httpd_close(1);
+}
+
+static void test_ws_handshake_requires_token(void) {
+    s_commands = 0;
+    CHECK(!host_httpd_ws_open(2, "/ws", NULL));
+    CHECK(!host_httpd_ws_open(2, "/ws?token=nope-nope-nope", NULL));
+    CHECK(!host_httpd_client(2)->open);
+
+    CHECK(host_httpd_ws_open(2, "/ws?lang=zh&token=" TOKEN, NULL));
+    CHECK(host_httpd_ws_open(3, "/ws", AUTH));
+    host_httpd_run_work();
+    CHECK_INT(host_httpd_client(2)->frames, 1);     // 握手后的完整状态
+    CHECK_INT(host_httpd_client(3)->frames, 1);
+    CHECK_INT(host_httpd_ws_text(2, "{\"speed\":30}"), ESP_OK);
+    CHECK_INT(s_commands, 1);
+    host_httpd_close(2);
+    host_httpd_close(3);
+}
+
+static void test_fanout_load(void) {
+    for (int fd = 0; fd < WS_CLIENTS; fd++) {
+        CHECK(host_httpd_ws_open(fd, "/ws", AUTH));
+    }
+    CHECK(host_httpd_open_http(HTTP_FD));   // 普通 HTTP 长连接不应收到推送
+    CHECK(!host_httpd_ws_open(LATE_FD, "/ws", AUTH));   // 连接数已满
+    host_httpd_run_work();
+
+    host_httpd_counts_t before = host_httpd_counts();
+    uint32_t frames_before[WS_CLIENTS];
+    for (int fd = 0; fd < WS_CLIENTS; fd++) frames_before[fd] = host_httpd_client(fd)->frames;
+    unsigned long prev_version = frame_version(host_httpd_client(0)->last);
+
+    clock_t t0 = clock();
+    int shared = 0, monotonic = 0;
+    for (int i = 1; i <= UPDATES; i++) {
+        lan_state_t st = state_at(i);
+        lan_api_update_state(&st);
+        host_httpd_run_work();
+        // 同一次变化的帧只序列化一次：所有客户端收到同一缓冲
+        const uint8_t* payload = host_httpd_client(0)->last_payload;
+        int same = 1;
+        for (int fd = 1; fd < WS_CLIENTS; fd++) same &= host_httpd_client(fd)->last_payload == payload;
+        shared += same;
+        unsigned long v = frame_version(host_httpd_client(0)->last);
+        monotonic += v == prev_version + 1;
+        prev_version = v;
+    }
+    double elapsed_s = (double)(clock() - t0) / CLOCKS_PER_SEC;
+
+    host_httpd_counts_t after = host_httpd_counts();
+    CHECK_INT(shared, UPDATES);
+    CHECK_INT(monotonic, UPDATES);
+    CHECK_INT(after.ws_sends - before.ws_sends, (uint32_t)UPDATES * WS_CLIENTS);
+    CHECK_INT(after.queued_work - before.queued_work, UPDATES);
+    CHECK_INT(after.queue_full, before.queue_full);
+    for (int fd = 0; fd < WS_CLIENTS; fd++) {
+        CHECK_INT(host_httpd_client(fd)->frames - frames_before[fd], UPDATES);
+    }
+    CHECK_INT(host_httpd_client(HTTP_FD)->frames, 0);
+    printf("  fan-out: %d updates x %d clients, %.0f ns/update\n",
+           UPDATES, WS_CLIENTS, elapsed_s * 1e9 / UPDATES);
+}
+
+static void test_updates_coalesce(void) {
+    host_httpd_counts_t before = host_httpd_counts();
+    uint32_t frames = host_httpd_client(0)->frames;
+    lan_state_t st;
+    for (int i = 0; i < 100; i++) {
+        st = state_at(UPDATES + 1 + i);
+        lan_api_update_state(&st);
+    }
+    CHECK_INT(host_httpd_counts().queued_work - before.queued_work, 1);
+    host_httpd_run_work();
+    CHECK_INT(host_httpd_client(0)->frames - frames, 1);
+
+    // 推送的是最后一次状态
+    host_http_resp_t resp;
+    host_httpd_request(HTTP_FD, HTTP_GET, "/api/state", NULL, NULL, &resp);
+    char speed[24];
+    snprintf(speed, sizeof(speed), "\"speed\":%u", st.fan_speed);
+    CHECK(strstr(resp.body, speed) != NULL);
+
+    // 状态没有变化时不推送
+    frames = host_httpd_client(0)->frames;
+    lan_api_update_state(&st);
+    host_httpd_run_work();
+    CHECK_INT(host_httpd_client(0)->frames, frames);
+}
+
+static void noop_work(void* arg) {
+}
+
+static void test_queue_full_recovers(void) {
+    uint32_t frames = host_httpd_client(0)->frames;
+    host_httpd_work_limit(1);
+    CHECK_INT(httpd_queue_work(lan_api_get_server(), noop_work, NULL), ESP_OK);
+    lan_state_t st = state_at(UPDATES + 500);
+    lan_api_update_state(&st);          // 队列满，排队失败
+    CHECK_INT(host_httpd_counts().queue_full, 1);
+    host_httpd_run_work();
+    CHECK_INT(host_httpd_client(0)->frames, frames);
+
+    // 排队失败后待处理标志已清除，下一次更新能重新排队
+    host_httpd_work_limit(0);
+    st = state_at(UPDATES + 501);
+    lan_api_update_state(&st);
+    host_httpd_run_work();
+    CHECK_INT(host_httpd_client(0)->frames, frames + 1);
+}
+
+static void test_late_joiner_and_churn(void) {
+    host_httpd_close(0);
+    CHECK(host_httpd_ws_open(LATE_FD, "/ws", AUTH));
+    host_httpd_run_work();
+    const host_ws_client_t* late = host_httpd_client(LATE_FD);
+    CHECK_INT(late->frames, 1);
+    CHECK_INT(frame_version(late->last), frame_version(host_httpd_client(1)->last));
+    CHECK(strstr(late->last, "\"temp\":") && strstr(late->last, "\"speed\":") &&
+          strstr(late->last, "\"cooler\":") && strstr(late->last, "\"mode\":"));
+
+    // 已关闭的客户端不再收到推送
+    uint32_t frames = host_httpd_client(1)->frames;
+    lan_state_t st = state_at(UPDATES + 900);
+    lan_api_update_state(&st);
+    host_httpd_run_work();
+    CHECK_INT(host_httpd_client(0)->frames, 0);
+    CHECK_INT(host_httpd_client(1)->frames, frames + 1);
+    CHECK_INT(late->frames, 2);
+}
+
+static void test_no_token_is_read_only(void) {
+    host_http_resp_t resp;
+    s_commands = s_configs = 0;
+    host_httpd_request(1, HTTP_POST, "/api/command", AUTH, "{\"speed\":40}", &resp);
+    CHECK_INT(resp.status, 403);
+    host_httpd_request(1, HTTP_POST, "/api/config", NULL, "{\"max_speed\":80}", &resp);
+    CHECK_INT(resp.status, 403);
+
+    // WebSocket 可以连接接收状态，但命令被忽略
+    CHECK(host_httpd_ws_open(2, "/ws", NULL));
+    host_httpd_run_work();
+    CHECK_INT(host_httpd_client(2)->frames, 1);
+    host_httpd_ws_text(2, "{\"speed\":30}");
+    CHECK_INT(s_commands + s_configs, 0);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--no-token") == 0) {
+        start(false);
+        RUN(test_no_token_is_read_only);
+        return HOST_TEST_RESULT();
+    }
+    start(true);
+    RUN(test_write_requires_token);
+    RUN(test_ws_handshake_requires_token);
+    RUN(test_fanout_load);
+    RUN(test_updates_coalesce);
+    RUN(test_queue_full_recovers);
+    RUN(test_late_joiner_and_churn);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,63 @@
+#include "host_test.h"
+#include "lan_auth.h"
+
+static const char TOKEN[] = "s3cret-T0ken";
+
+static void test_token_format(void) {
+    CHECK(lan_auth_token_valid(TOKEN));
+    CHECK(!lan_auth_token_valid(""));
+    CHECK(!lan_auth_token_valid("short"));
+    CHECK(!lan_auth_token_valid("has space inside"));
+    CHECK(!lan_auth_token_valid("tab\there12"));
+    CHECK(!lan_auth_token_valid("\xe4\xb8\xad\xe6\x96\x87\xe4\xbb\xa4\xe7\x89\x8c"));
+    char max[LAN_AUTH_TOKEN_MAX + 2];
+    memset(max, 'a', sizeof(max));
+    max[LAN_AUTH_TOKEN_MAX] = '\0';
+    CHECK(lan_auth_token_valid(max));
+    max[LAN_AUTH_TOKEN_MAX] = 'a';
+    max[LAN_AUTH_TOKEN_MAX + 1] = '\0';
+    CHECK(!lan_auth_token_valid(max));
+}
+
+static void test_bearer_header(void) {
+    CHECK(lan_auth_check_bearer("Bearer s3cret-T0ken", TOKEN));
+    CHECK(lan_auth_check_bearer("bearer   s3cret-T0ken  ", TOKEN));
+    CHECK(!lan_auth_check_bearer("Bearer s3cret-T0ke", TOKEN));     // 前缀
+    CHECK(!lan_auth_check_bearer("Bearer s3cret-T0kenX", TOKEN));   // 多一个字节
+    CHECK(!lan_auth_check_bearer("Bearer S3cret-T0ken", TOKEN));
+    CHECK(!lan_auth_check_bearer("Basic s3cret-T0ken", TOKEN));
+    CHECK(!lan_auth_check_bearer("s3cret-T0ken", TOKEN));
+    CHECK(!lan_auth_check_bearer("Bearer ", TOKEN));
+    CHECK(!lan_auth_check_bearer(NULL, TOKEN));
+}
+
+static void test_disabled_without_token(void) {
+    // 未设置令牌：任何凭据都不放行，包括空令牌
+    CHECK(!lan_auth_check_bearer("Bearer ", ""));
+    CHECK(!lan_auth_check_bearer("Bearer x", ""));
+    CHECK(!lan_auth_check_query("token=", 6, ""));
+}
+
+static void test_query_token(void) {
+    const char q[] = "lang=zh&token=s3cret-T0ken";
+    CHECK(lan_auth_check_query(q, sizeof(q) - 1, TOKEN));
+    const char enc[] = "token=s3cret%2DT0ken";
+    CHECK(lan_auth_check_query(enc, sizeof(enc) - 1, TOKEN));
+    const char wrong[] = "token=s3cret-T0ken2";
+    CHECK(!lan_auth_check_query(wrong, sizeof(wrong) - 1, TOKEN));
+    const char other[] = "xtoken=s3cret-T0ken";
+    CHECK(!lan_auth_check_query(other, sizeof(other) - 1, TOKEN));
+    // 长度之外的字节不参与比较
+    CHECK(!lan_auth_check_query(q, sizeof(q) - 2, TOKEN));
+    char longq[200] = "token=";
+    memset(longq + 6, 'a', 150);
+    CHECK(!lan_auth_check_query(longq, strlen(longq), TOKEN));
+}
+
+int main(void) {
+    RUN(test_token_format);
+    RUN(test_bearer_header);
+    RUN(test_disabled_without_token);
+    RUN(test_query_token);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,200 @@
+#include "host_test.h"
+#include "host_stubs.h"
+#include "mqtt_comm.h"
+#include "broker_select.h"
+#include "nvs.h"
+
+/**
+ * @brief broker 连接管理：遥测以 QoS1 发出并保留到 PUBACK，发件箱丢弃或断线期间的遥测重连后补发；
+ *        暂存锁不跨发布持有，MQTT 任务持客户端锁结算时不互锁；
+ *        首选 broker 失败后切到备用，回切前先在探测任务中探测（桩中同步运行），探测失败不回切
+ *        broker 列表在 mqtt_comm_init 前写入 NVS storage/mqtt_brokers
+ */
+
+static esp_mqtt_client_handle_t s_client;
+static uint32_t s_uptime;
+static int s_acked_ping;
+
+static void publish_telemetry(void) {
+    mqtt_telemetry_t tm = {
+        .uptime_s = ++s_uptime, .sensor_state = "ok", .sensor_fault = "none", .fan_duty = 50,
+    };
+    mqtt_comm_publish_telemetry(s_client, &tm);
+}
+
+static int telemetry_count(void) {
+    return host_mqtt_count_topic("/telemetry");
+}
+
+static const host_mqtt_msg_t* last_telemetry(void) {
+    return host_mqtt_last("/telemetry");
+}
+
+static void connect(void) {
+    host_mqtt_event(s_client, MQTT_EVENT_BEFORE_CONNECT, 0);
+    host_time_advance_ms(50);
+    host_mqtt_event(s_client, MQTT_EVENT_CONNECTED, 0);
+}
+
+/**
+ * @brief 周期服务，并立即确认新发出的延迟探测，避免探测超时触发重连
+ */
+static void service(void) {
+    mqtt_comm_service(s_client);
+    const host_mqtt_msg_t* ping = host_mqtt_last("/diagnostics/ping");
+    if (ping && ping->msg_id != s_acked_ping) {
+        s_acked_ping = ping->msg_id;
+        host_mqtt_event(s_client, MQTT_EVENT_PUBLISHED, ping->msg_id);
+    }
+}
+
+static void test_telemetry_held_until_puback(void) {
+    connect();
+    int before = telemetry_count();
+    publish_telemetry();
+    const host_mqtt_msg_t* first = last_telemetry();
+    CHECK(first != NULL);
+    CHECK_INT(first->qos, 1);
+    CHECK(first->msg_id > 0);
+    int first_id = first->msg_id;
+
+    // 未确认的不重复发布
+    publish_telemetry();
+    CHECK_INT(telemetry_count() - before, 2);
+    int second_id = last_telemetry()->msg_id;
+    CHECK(strstr(last_telemetry()->data, "\"backlog\":1") != NULL);
+
+    // 确认第一条后只剩第二条
+    host_mqtt_event(s_client, MQTT_EVENT_PUBLISHED, first_id);
+    publish_telemetry();
+    CHECK(strstr(last_telemetry()->data, "\"backlog\":1") != NULL);
+    int third_id = last_telemetry()->msg_id;
+
+    // 发件箱丢弃第二条：退回暂存区并重新发出，内容不变
+    host_mqtt_event(s_client, MQTT_EVENT_DELETED, second_id);
+    CHECK_INT(telemetry_count() - before, 4);
+    CHECK(strstr(last_telemetry()->data, "\"uptime_s\":2,") != NULL);
+    CHECK(last_telemetry()->msg_id != second_id);
+
+    // 与暂存区无关的消息 ID 不影响暂存区
+    host_mqtt_event(s_client, MQTT_EVENT_DELETED, 9999);
+    CHECK_INT(telemetry_count() - before, 4);
+
+    host_mqtt_event(s_client, MQTT_EVENT_PUBLISHED, last_telemetry()->msg_id);
+    host_mqtt_event(s_client, MQTT_EVENT_PUBLISHED, third_id);
+    publish_telemetry();
+    CHECK(strstr(last_telemetry()->data, "\"backlog\":0") != NULL);
+    host_mqtt_event(s_client, MQTT_EVENT_PUBLISHED, last_telemetry()->msg_id);
+}
+
+static void test_telemetry_resent_after_reconnect(void) {
+    host_mqtt_event(s_client, MQTT_EVENT_DISCONNECTED, 0);
+    int before = telemetry_count();
+    publish_telemetry();
+    publish_telemetry();
+    CHECK_INT(telemetry_count(), before);                   // 断线期间只暂存
+
+    connect();                                              // 中断后重拨同一个 broker
+    CHECK_INT(telemetry_count() - before, 2);
+    CHECK_INT(last_telemetry()->qos, 1);
+    CHECK(strstr(last_telemetry()->data, "\"index\":0") != NULL);
+    const host_mqtt_msg_t* m = host_mqtt_msg(host_mqtt_count() - 2);
+    CHECK(strstr(m->data, "\"uptime_s\":5,") != NULL);   // 按原顺序
+    host_mqtt_event(s_client, MQTT_EVENT_PUBLISHED, m->msg_id);
+    host_mqtt_event(s_client, MQTT_EVENT_PUBLISHED, last_telemetry()->msg_id);
+}
+
+static void test_settle_while_publishing(void) {
+    // 发布方等客户端锁时 MQTT 任务结算上一条：桩中重复获取已持有的互斥量即中止
+    int before = telemetry_count();
+    publish_telemetry();
+    int first_id = last_telemetry()->msg_id;
+    host_mqtt_contend(MQTT_EVENT_PUBLISHED, first_id);
+    publish_telemetry();
+    CHECK_INT(telemetry_count() - before, 2);
+    int second_id = last_telemetry()->msg_id;
+
+    // 发布返回、记下 ID 之前 PUBACK 已到：记 ID 时结算，但要等前面的第二条确认后才移除
+    host_mqtt_contend(MQTT_EVENT_PUBLISHED, 0);
+    publish_telemetry();
+    CHECK(strstr(last_telemetry()->data, "\"backlog\":1") != NULL);
+
+    // 发布期间第二条被发件箱丢弃：事件回调中补发
+    host_mqtt_contend(MQTT_EVENT_DELETED, second_id);
+    publish_telemetry();
+    CHECK(strstr(last_telemetry()->data, "\"uptime_s\":8,") != NULL);      // 最后一条是补发的第二条
+    CHECK(last_telemetry()->msg_id != second_id);
+    CHECK_INT(telemetry_count() - before, 5);
+    int fourth_id = host_mqtt_msg(host_mqtt_count() - 2)->msg_id;
+
+    host_mqtt_event(s_client, MQTT_EVENT_PUBLISHED, last_telemetry()->msg_id);
+    host_mqtt_event(s_client, MQTT_EVENT_PUBLISHED, fourth_id);
+    publish_telemetry();
+    CHECK(strstr(last_telemetry()->data, "\"backlog\":0") != NULL);
+    host_mqtt_event(s_client, MQTT_EVENT_PUBLISHED, last_telemetry()->msg_id);
+}
+
+static void test_failback_after_probe(void) {
+    // 首选 broker 宕机：中断后重拨失败，切到备用
+    host_mqtt_event(s_client, MQTT_EVENT_DISCONNECTED, 0);
+    host_mqtt_event(s_client, MQTT_EVENT_BEFORE_CONNECT, 0);
+    CHECK_STR(host_mqtt_config()->broker.address.uri, "mqtt://a.local");
+    host_mqtt_event(s_client, MQTT_EVENT_DISCONNECTED, 0);
+    connect();
+    CHECK_STR(host_mqtt_config()->broker.address.uri, "mqtt://b.local");
+
+    // 满保持时间后首选仍有连续失败：先探测，探测失败不回切
+    host_mqtt_counts_t before = host_mqtt_counts();
+    host_tls_probe_result(false);
+    int probes = host_tls_probes();
+    host_time_advance_ms(BROKER_FAILBACK_HOLD_MS);
+    service();
+    CHECK_INT(host_tls_probes() - probes, 1);
+    CHECK_INT(host_mqtt_counts().reconnects, before.reconnects);
+
+    // 探测间隔内不再探测
+    host_tls_probe_result(true);
+    host_time_advance_ms(BROKER_PROBE_INTERVAL_MS / 2);
+    service();
+    CHECK_INT(host_tls_probes() - probes, 1);
+    CHECK_INT(host_mqtt_counts().reconnects, before.reconnects);
+
+    // 探测在单独的任务中进行，服务调用本身不回切
+    host_time_advance_ms(BROKER_PROBE_INTERVAL_MS / 2);
+    service();
+    CHECK_INT(host_tls_probes() - probes, 2);
+    CHECK_INT(host_mqtt_counts().reconnects, before.reconnects);
+
+    // 探测成功后的下一次服务：迁走前把旧 broker 上的 availability 置为 offline，再回切
+    service();
+    CHECK_INT(host_tls_probes() - probes, 2);
+    CHECK_INT(host_mqtt_counts().reconnects - before.reconnects, 1);
+    CHECK_STR(host_mqtt_last("/availability")->data, "offline");
+    host_mqtt_event(s_client, MQTT_EVENT_DISCONNECTED, 0);
+    connect();
+    CHECK_STR(host_mqtt_config()->broker.address.uri, "mqtt://a.local");
+
+    // 回到首选后没有回切候选，不再探测
+    host_time_advance_ms(BROKER_FAILBACK_HOLD_MS + BROKER_PROBE_INTERVAL_MS);
+    service();
+    CHECK_INT(host_tls_probes() - probes, 2);
+}
+
+int main(void) {
+    broker_list_t list = { .count = 2 };
+    strcpy(list.entry[0].uri, "mqtt://a.local");
+    strcpy(list.entry[1].uri, "mqtt://b.local");
+    nvs_handle_t nvs;
+    nvs_open("storage", NVS_READWRITE, &nvs);
+    nvs_set_blob(nvs, "mqtt_brokers", &list, sizeof(list));
+    nvs_commit(nvs);
+    nvs_close(nvs);
+
+    host_time_set_us(1000000000);
+    s_client = mqtt_comm_init();
+    RUN(test_telemetry_held_until_puback);
+    RUN(test_telemetry_resent_after_reconnect);
+    RUN(test_settle_while_publishing);
+    RUN(test_failback_after_probe);
+    return HOST_TEST_RESULT();
+}
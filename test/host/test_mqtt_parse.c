@@ -0,0 +1,182 @@
+#include "host_test.h"
+#include "host_stubs.h"
+#include "mqtt_comm.h"
+#include <stdint.h>
+
+static int parse_cmd(const char* json, mqtt_command_t* cmd) {
+    return mqtt_comm_parse_command(json, (int)strlen(json), cmd);
+}
+
+static int parse_cfg(const char* json, mqtt_config_t* cfg) {
+    return mqtt_comm_parse_config(json, (int)strlen(json), cfg);
+}
+
+static void test_command_fields(void) {
+    mqtt_command_t cmd;
+    CHECK(parse_cmd("{\"speed\":55,\"mode\":\"manual\",\"id\":\"c42\"}", &cmd));
+    CHECK(cmd.has_speed);
+    CHECK_INT(cmd.speed, 55);
+    CHECK(cmd.has_mode);
+    CHECK_INT(cmd.mode, MQTT_MODE_MANUAL);
+    CHECK_STR(cmd.id, "c42");
+
+    CHECK(parse_cmd("{\"autotune\":\"start\",\"fan_cal\":\"reset\",\"report\":\"trace\"}", &cmd));
+    CHECK(cmd.has_autotune && cmd.autotune == MQTT_AUTOTUNE_START);
+    CHECK(cmd.has_fan_cal && cmd.fan_cal == MQTT_FAN_CAL_RESET);
+    CHECK(cmd.report_trace && !cmd.report_latency);
+    CHECK(!cmd.has_speed && !cmd.has_mode);
+}
+
+static void test_command_speed_range(void) {
+    mqtt_command_t cmd;
+    // 300 截成 uint8_t 会变成 44，必须判为无效
+    CHECK(parse_cmd("{\"speed\":300}", &cmd));
+    CHECK(!cmd.has_speed && cmd.speed_invalid);
+    CHECK(parse_cmd("{\"speed\":-1}", &cmd));
+    CHECK(!cmd.has_speed && cmd.speed_invalid);
+    CHECK(parse_cmd("{\"speed\":1e300}", &cmd));
+    CHECK(!cmd.has_speed && cmd.speed_invalid);
+    CHECK(parse_cmd("{\"speed\":\"50\"}", &cmd));
+    CHECK(!cmd.has_speed && !cmd.speed_invalid);
+    CHECK(parse_cmd("{\"speed\":100}", &cmd));
+    CHECK(cmd.has_speed && cmd.speed == 100);
+}
+
+static void test_command_correlation_id(void) {
+    mqtt_command_t cmd;
+    CHECK(parse_cmd("{\"id\":\"a\\\"b\"}", &cmd));
+    CHECK_STR(cmd.id, "");
+    CHECK(parse_cmd("{\"id\":\"line\\nbreak\"}", &cmd));
+    CHECK_STR(cmd.id, "");
+    CHECK(parse_cmd("{\"id\":\"0123456789012345678901234567890\"}", &cmd));
+    CHECK_INT(strlen(cmd.id), MQTT_CMD_ID_MAX - 1);
+    CHECK(parse_cmd("{\"id\":42}", &cmd));
+    CHECK_STR(cmd.id, "");
+}
+
+static void test_malformed(void) {
+    mqtt_command_t cmd;
+    mqtt_config_t cfg;
+    CHECK(!parse_cmd("", &cmd));
+    CHECK(!parse_cmd("{\"speed\":", &cmd));
+    CHECK(!parse_cfg("not json", &cfg));
+    // 数据不以 '\0' 结尾：只解析给定长度
+    const char buf[] = "{\"speed\":42}garbage";
+    CHECK(mqtt_comm_parse_command(buf, 12, &cmd));
+    CHECK(cmd.has_speed && cmd.speed == 42);
+}
+
+static void test_arena_overflow(void) {
+    // 超出 4 KB 内存池的文档解析失败而不是退回 malloc
+    char big[8192];
+    int n = snprintf(big, sizeof(big), "{\"a\":[");
+    while (n < (int)sizeof(big) - 16) n += snprintf(big + n, sizeof(big) - n, "1,");
+    n += snprintf(big + n, sizeof(big) - n, "1]}");
+    mqtt_command_t cmd;
+    CHECK(!mqtt_comm_parse_command(big, n, &cmd));
+    // 内存池已归还，随后的解析正常
+    CHECK(parse_cmd("{\"speed\":1}", &cmd));
+    CHECK(cmd.has_speed);
+}
+
+static void test_config_ranges(void) {
+    mqtt_config_t cfg;
+    CHECK(parse_cfg("{\"temp_threshold\":31.5,\"max_speed\":80,\"power_budget_w\":25}", &cfg));
+    CHECK(cfg.has_temp_threshold);
+    CHECK_NEAR(cfg.temp_threshold, 31.5, 1e-6);
+    CHECK(cfg.has_max_speed && cfg.max_speed == 80);
+    CHECK(cfg.has_power_budget);
+    CHECK_NEAR(cfg.power_budget_w, 25, 1e-6);
+
+    CHECK(parse_cfg("{\"temp_threshold\":90,\"max_speed\":101,\"power_budget_w\":-1}", &cfg));
+    CHECK(!cfg.has_temp_threshold && !cfg.has_max_speed && !cfg.has_power_budget);
+
+    CHECK(parse_cfg("{\"fan_off_temp\":24.5,\"mid_speed\":40}", &cfg));
+    CHECK(cfg.has_fan_off_temp && cfg.has_mid_speed && cfg.mid_speed == 40);
+    CHECK_NEAR(cfg.fan_off_temp, 24.5, 1e-6);
+    CHECK(parse_cfg("{\"fan_off_temp\":-1,\"mid_speed\":300}", &cfg));
+    CHECK(!cfg.has_fan_off_temp && !cfg.has_mid_speed);
+
+    CHECK(parse_cfg("{\"power_model\":{\"fan_w\":3,\"fan_exp\":3,\"tec_w\":0,\"tec_exp\":5}}", &cfg));
+    CHECK(cfg.has_fan_power_w && cfg.has_fan_power_exp);
+    CHECK(!cfg.has_tec_power_w && !cfg.has_tec_power_exp);
+
+    // 1e999 被 cJSON 解析成 inf，1e300 转成 float 溢出
+    CHECK(parse_cfg("{\"power_budget_w\":1e999,\"power_model\":{\"fan_w\":1e300,\"tec_w\":1e999}}", &cfg));
+    CHECK(!cfg.has_power_budget && !cfg.has_fan_power_w && !cfg.has_tec_power_w);
+
+    CHECK(parse_cfg("{\"sensor\":{\"holdover_s\":600,\"failsafe_fan\":70}}", &cfg));
+    CHECK(cfg.has_holdover_s && cfg.holdover_s == 600);
+    CHECK(cfg.has_failsafe_fan && cfg.failsafe_fan == 70);
+    CHECK(parse_cfg("{\"sensor\":{\"holdover_s\":3601,\"failsafe_fan\":101}}", &cfg));
+    CHECK(!cfg.has_holdover_s && !cfg.has_failsafe_fan);
+    // 失效安全占空比低于制冷片开启时的风扇下限：温度未知时风扇可能停转
+    CHECK(parse_cfg("{\"sensor\":{\"failsafe_fan\":39}}", &cfg));
+    CHECK(!cfg.has_failsafe_fan);
+    CHECK(parse_cfg("{\"sensor\":{\"failsafe_fan\":40}}", &cfg));
+    CHECK(cfg.has_failsafe_fan && cfg.failsafe_fan == 40);
+}
+
+static void test_config_brokers(void) {
+    mqtt_config_t cfg;
+    CHECK(parse_cfg("{\"brokers\":[{\"uri\":\"mqtt://a.local:1883\"},"
+                    "{\"uri\":\"mqtts://b.local\",\"username\":\"u\",\"password\":\"p\"}]}", &cfg));
+    CHECK(cfg.has_brokers);
+    CHECK(parse_cfg("{\"brokers\":[{\"username\":\"u\"}]}", &cfg));
+    CHECK(!cfg.has_brokers);
+    CHECK(parse_cfg("{\"brokers\":[]}", &cfg));
+    CHECK(!cfg.has_brokers);
+}
+
+static void test_history_request(void) {
+    mqtt_history_request_t req;
+    const char* json = "{\"id\":\"q1\",\"field\":\"fan\",\"from_s\":1e20,\"to_s\":-5,\"points\":1000000}";
+    CHECK(mqtt_comm_parse_history_request(json, (int)strlen(json), &req));
+    CHECK_STR(req.id, "q1");
+    CHECK_STR(req.field, "fan");
+    CHECK_INT(req.from_s, UINT32_MAX);
+    CHECK_INT(req.to_s, 0);
+    CHECK_INT(req.max_points, UINT16_MAX);
+
+    json = "{}";
+    CHECK(mqtt_comm_parse_history_request(json, 2, &req));
+    CHECK_STR(req.field, "temp");
+    CHECK_INT(req.from_s, 3600);
+    CHECK_INT(req.max_points, 200);
+}
+
+static void test_ota_request(void) {
+    mqtt_ota_request_t req;
+    const char* json = "{\"url\":\"https://x/fw.bin\",\"sha256\":\"abc\"}";
+    CHECK(!mqtt_comm_parse_ota_request(json, (int)strlen(json), &req));
+    char ok[200];
+    snprintf(ok, sizeof(ok), "{\"url\":\"https://x/fw.bin\",\"sha256\":\"%064d\",\"compressed\":true}", 0);
+    CHECK(mqtt_comm_parse_ota_request(ok, (int)strlen(ok), &req));
+    CHECK(req.compressed);
+}
+
+static void test_format_ack(void) {
+    mqtt_command_t cmd = { .rx_us = 1000 };
+    strcpy(cmd.id, "c1");
+    mqtt_command_ack_t ack = { .result = MQTT_ACK_REJECTED, .reason = "auto_mode" };
+    char buf[160];
+    int len = mqtt_comm_format_ack(&cmd, &ack, 3000, buf, sizeof(buf));
+    CHECK(len > 0);
+    CHECK_STR(buf, "{\"ok\":false,\"id\":\"c1\",\"result\":\"rejected\",\"reason\":\"auto_mode\",\"handled_us\":2000}");
+    CHECK_INT(mqtt_comm_format_ack(&cmd, &ack, 3000, buf, 20), -1);
+}
+
+int main(void) {
+    mqtt_comm_init();
+    RUN(test_command_fields);
+    RUN(test_command_speed_range);
+    RUN(test_command_correlation_id);
+    RUN(test_malformed);
+    RUN(test_arena_overflow);
+    RUN(test_config_ranges);
+    RUN(test_config_brokers);
+    RUN(test_history_request);
+    RUN(test_ota_request);
+    RUN(test_format_ack);
+    return HOST_TEST_RESULT();
+}
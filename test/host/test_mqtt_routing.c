@@ -0,0 +1,129 @@
+#include "host_test.h"
+#include "host_stubs.h"
+#include "metrics.h"
+#include "mqtt_comm.h"
+#include "nvs.h"
+#include <stdlib.h>
+
+/**
+ * @brief MQTT 主题路由：设备/组主题精确匹配，前缀、后缀和其他设备的主题不分发
+ *        主题在 mqtt_comm_init 时按 MAC 和 NVS storage/mqtt_group 生成
+ */
+
+#define DEV   "esp32/fan_control/fan-240ac4000001"
+#define GROUP "esp32/fan_control/group/rack-a"
+
+static esp_mqtt_client_handle_t s_client;
+static int s_commands;
+static int s_configs;
+static mqtt_command_t s_last_cmd;
+
+static void on_command(const mqtt_command_t* cmd, mqtt_command_ack_t* ack) {
+    s_commands++;
+    s_last_cmd = *cmd;
+}
+
+static void on_config(const mqtt_config_t* cfg) {
+    s_configs++;
+}
+
+static char s_metrics[8192];
+static size_t s_metrics_len;
+
+static int metrics_to_buf(void* ctx, const char* data, size_t len) {
+    if (s_metrics_len + len >= sizeof(s_metrics)) return -1;
+    memcpy(s_metrics + s_metrics_len, data, len);
+    s_metrics_len += len;
+    s_metrics[s_metrics_len] = '\0';
+    return 0;
+}
+
+static long metric_value(const char* name) {
+    s_metrics_len = 0;
+    if (metrics_write_prometheus(metrics_to_buf, NULL) != 0) return -1;
+    char key[96];
+    snprintf(key, sizeof(key), "\n%s ", name);
+    const char* p = strstr(s_metrics, key);
+    return p ? strtol(p + strlen(key), NULL, 10) : -1;
+}
+
+static void deliver(const char* topic, const char* data) {
+    host_mqtt_deliver(s_client, topic, data, (int)strlen(data));
+}
+
+static void test_subscribes_every_route(void) {
+    host_mqtt_counts_t before = host_mqtt_counts();
+    host_mqtt_event(s_client, MQTT_EVENT_CONNECTED, 0);
+    // 设备 command/config/state/desired/history/get/ota + 组 command/config
+    CHECK_INT(host_mqtt_counts().subscribed - before.subscribed, 7);
+    CHECK_STR(mqtt_comm_get_device_id(), "fan-240ac4000001");
+}
+
+static void test_device_topics_route(void) {
+    s_commands = s_configs = 0;
+    deliver(DEV "/command", "{\"speed\":42,\"id\":\"r1\"}");
+    CHECK_INT(s_commands, 1);
+    CHECK_INT(s_last_cmd.speed, 42);
+    const host_mqtt_msg_t* ack = host_mqtt_last("/command/ack");
+    CHECK(ack != NULL && strstr(ack->topic, DEV) == ack->topic && strstr(ack->data, "\"r1\""));
+
+    deliver(DEV "/config", "{\"max_speed\":70}");
+    CHECK_INT(s_configs, 1);
+}
+
+static void test_group_topics_route(void) {
+    s_commands = s_configs = 0;
+    deliver(GROUP "/command", "{\"mode\":\"manual\"}");
+    deliver(GROUP "/config", "{\"max_speed\":60}");
+    CHECK_INT(s_commands, 1);
+    CHECK_INT(s_configs, 1);
+}
+
+static void test_near_misses_are_unrouted(void) {
+    static const char* const topics[] = {
+        DEV "/commandX",                                    // 后缀
+        DEV "/comman",                                      // 前缀
+        DEV "/command/ack",                                 // 自己发布的回执
+        "esp32/fan_control/fan-240ac4000002/command",       // 其他设备
+        "esp32/fan_control/group/rack-b/command",           // 其他组
+        "esp32/fan_control/group/rack-a/command/",
+        "esp32/fan_control/command",                        // 旧的无设备ID主题
+        "",
+    };
+    s_commands = s_configs = 0;
+    long before = metric_value("fan_mqtt_unrouted_total");
+    CHECK(before >= 0);
+    for (size_t i = 0; i < sizeof(topics) / sizeof(topics[0]); i++) {
+        deliver(topics[i], "{\"speed\":10}");
+    }
+    CHECK_INT(s_commands + s_configs, 0);
+    CHECK_INT(metric_value("fan_mqtt_unrouted_total") - before, sizeof(topics) / sizeof(topics[0]));
+}
+
+static void test_topic_not_nul_terminated(void) {
+    // esp-mqtt 的主题不以 '\0' 结尾（桩按长度拷贝到独立缓冲）：只比较 topic_len 字节
+    s_commands = 0;
+    deliver(DEV "/command", "{\"speed\":5}");
+    CHECK_INT(s_commands, 1);
+}
+
+int main(void) {
+    host_nvs_reset();
+    nvs_handle_t h;
+    nvs_open("storage", NVS_READWRITE, &h);
+    nvs_set_str(h, "mqtt_group", "rack-a");
+    nvs_commit(h);
+    nvs_close(h);
+
+    s_client = mqtt_comm_init();
+    mqtt_comm_set_command_callback(on_command);
+    mqtt_comm_set_config_callback(on_config);
+    CHECK(s_client != NULL);
+
+    RUN(test_subscribes_every_route);
+    RUN(test_device_topics_route);
+    RUN(test_group_topics_route);
+    RUN(test_near_misses_are_unrouted);
+    RUN(test_topic_not_nul_terminated);
+    return HOST_TEST_RESULT();
+}
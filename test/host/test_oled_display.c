@@ -0,0 +1,82 @@
+#include "host_test.h"
+#include "host_stubs.h"
+#include "oled_display.h"
+
+/**
+ * @brief SSD1306 驱动：按数据手册模型解释命令流，增量重绘后的显存与同一帧整屏重绘一致，
+ *        只改动的字符区间落在对应的页与列上；状态页显示传入的实际输出
+ */
+
+static uint8_t ram_at(int page, int x) {
+    return host_ssd1306_ram()[page * HOST_SSD1306_WIDTH + x];
+}
+
+static void test_partial_redraw_matches_full(void) {
+    oled_init(0, 21, 22);
+    for (int i = 0; i < HOST_SSD1306_PAGES * HOST_SSD1306_WIDTH; i++) CHECK_INT(host_ssd1306_ram()[i], 0);
+
+    oled_frame_t a;
+    oled_frame_clear(&a);
+    oled_frame_printf(&a, 0, "Temp : %5.1f C", 31.5);
+    oled_frame_printf(&a, 1, "Fan  : %3d%%", 42);
+    oled_frame_printf(&a, 3, "Mode : Auto");
+    oled_display_frame(&a);
+    CHECK(ram_at(0, 0) != 0);                               // 'T' 在第 0 页第 0 列
+    CHECK(ram_at(1, 0) != 0);
+    CHECK_INT(ram_at(2, 0), 0);
+
+    // 只改第 1 行第 9、10 个字符和第 4 行的反色
+    oled_frame_t b = a;
+    oled_frame_printf(&b, 1, "Fan  : %3d%%", 57);
+    b.inverted = 1u << 4;
+    uint8_t before[HOST_SSD1306_PAGES * HOST_SSD1306_WIDTH];
+    memcpy(before, host_ssd1306_ram(), sizeof(before));
+    oled_display_frame(&b);
+    for (int x = 0; x < HOST_SSD1306_WIDTH; x++) {
+        bool changed = ram_at(1, x) != before[HOST_SSD1306_WIDTH + x];
+        if (changed) CHECK(x >= 8 * 6 && x < 10 * 6);
+        CHECK_INT(ram_at(0, x), before[x]);
+        CHECK_INT(ram_at(4, x), x < OLED_FRAME_COLS * 6 ? 0xFF : 0x00);     // 空行反色：字符区全亮
+    }
+    uint8_t partial[sizeof(before)];
+    memcpy(partial, host_ssd1306_ram(), sizeof(partial));
+
+    // 重新初始化后整屏绘制同一帧
+    oled_init(0, 21, 22);
+    oled_display_frame(&b);
+    CHECK(memcmp(partial, host_ssd1306_ram(), sizeof(partial)) == 0);
+}
+
+static void test_status_shows_applied_outputs(void) {
+    // 手动设定与监督器输出不同（如过温切断后制冷片为 0）：屏幕显示实际输出
+    oled_init(0, 21, 22);
+    oled_display_update(28.0f, 60, 0, false);
+    uint8_t shown[HOST_SSD1306_PAGES * HOST_SSD1306_WIDTH];
+    memcpy(shown, host_ssd1306_ram(), sizeof(shown));
+
+    oled_frame_t expected;
+    oled_frame_clear(&expected);
+    oled_frame_printf(&expected, 0, "Temp : %5.1f C", 28.0);
+    oled_frame_printf(&expected, 1, "Fan  :  60%%       ");
+    oled_frame_printf(&expected, 2, "Cooler:   0%% (Manual)");
+    oled_frame_printf(&expected, 3, "Mode : Manual");
+    oled_init(0, 21, 22);
+    oled_display_frame(&expected);
+    CHECK(memcmp(shown, host_ssd1306_ram(), sizeof(shown)) == 0);
+
+    // 自动模式：制冷片显示监督器分配的占空比，而不是风扇转速
+    oled_display_update(28.0f, 60, 35, true);
+    memcpy(shown, host_ssd1306_ram(), sizeof(shown));
+    oled_frame_printf(&expected, 1, "Fan  :  60%% (Auto) ");
+    oled_frame_printf(&expected, 2, "Cooler:  35%% (Auto) ");
+    oled_frame_printf(&expected, 3, "Mode : Auto");
+    oled_init(0, 21, 22);
+    oled_display_frame(&expected);
+    CHECK(memcmp(shown, host_ssd1306_ram(), sizeof(shown)) == 0);
+}
+
+int main(void) {
+    RUN(test_partial_redraw_matches_full);
+    RUN(test_status_shows_applied_outputs);
+    return HOST_TEST_RESULT();
+}
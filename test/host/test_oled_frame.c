@@ -0,0 +1,73 @@
+#include "host_test.h"
+#include "oled_frame.h"
+
+/**
+ * @brief 文本帧：补空格与截断、逐行差异区间、反色变化整行重绘
+ */
+
+static void test_printf_pads_and_truncates(void) {
+    oled_frame_t f;
+    oled_frame_clear(&f);
+    CHECK_STR(f.text[3], "                     ");
+    CHECK_INT(f.inverted, 0);
+
+    oled_frame_printf(&f, 0, "T:%.1fC", 25.5);
+    CHECK_STR(f.text[0], "T:25.5C              ");
+    oled_frame_printf(&f, 1, "%s", "0123456789abcdefghijKLMNOP");
+    CHECK_STR(f.text[1], "0123456789abcdefghijK");
+    CHECK_INT(strlen(f.text[1]), OLED_FRAME_COLS);
+
+    // 覆盖较短内容时清掉旧字符
+    oled_frame_printf(&f, 1, "ab");
+    CHECK_STR(f.text[1], "ab                   ");
+
+    oled_frame_t before = f;
+    oled_frame_printf(&f, OLED_FRAME_ROWS, "out of range");
+    CHECK(memcmp(&f, &before, sizeof(f)) == 0);
+}
+
+static void test_diff_row(void) {
+    oled_frame_t a, b;
+    oled_frame_clear(&a);
+    oled_frame_printf(&a, 2, "Temp 25.50C  Fan 40%%");
+    b = a;
+    uint8_t first = 0xff, last = 0xff;
+    CHECK(!oled_frame_diff_row(&a, &b, 2, &first, &last));
+    CHECK_INT(first, 0xff);
+
+    oled_frame_printf(&b, 2, "Temp 25.75C  Fan 45%%");
+    CHECK(oled_frame_diff_row(&a, &b, 2, &first, &last));
+    CHECK_INT(first, 8);                // 首末变化列之间整段重绘
+    CHECK_INT(last, 18);
+
+    oled_frame_printf(&b, 2, "Temp 25.75C  Fan 40%%");
+    CHECK(oled_frame_diff_row(&a, &b, 2, &first, &last));
+    CHECK_INT(first, 8);
+    CHECK_INT(last, 9);
+
+    b = a;
+    b.text[2][OLED_FRAME_COLS - 1] = '!';
+    CHECK(oled_frame_diff_row(&a, &b, 2, &first, &last));
+    CHECK_INT(first, OLED_FRAME_COLS - 1);
+    CHECK_INT(last, OLED_FRAME_COLS - 1);
+}
+
+static void test_inversion_redraws_row(void) {
+    oled_frame_t a, b;
+    oled_frame_clear(&a);
+    b = a;
+    b.inverted = 1u << 5;
+    uint8_t first, last;
+    CHECK(oled_frame_diff_row(&a, &b, 5, &first, &last));
+    CHECK_INT(first, 0);
+    CHECK_INT(last, OLED_FRAME_COLS - 1);
+    CHECK(!oled_frame_diff_row(&a, &b, 4, &first, &last));   // 其他行不受影响
+    CHECK(!oled_frame_diff_row(&a, &b, 7, &first, &last));
+}
+
+int main(void) {
+    RUN(test_printf_pads_and_truncates);
+    RUN(test_diff_row);
+    RUN(test_inversion_redraws_row);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,146 @@
+#include "host_test.h"
+#include "ota_stream.h"
+#include <stdlib.h>
+
+/**
+ * @brief OTA 流式管线：透传、分块解压（跨越 32KB 窗口回绕）、截断/损坏/写入失败、流结束后的填充
+ *        压缩数据由 miniz 的 mz_compress2 在测试中生成
+ */
+
+#define IMAGE_LEN   (200 * 1024)
+
+static uint8_t s_image[IMAGE_LEN];
+static uint8_t s_zlib[IMAGE_LEN + 1024];
+static size_t s_zlib_len;
+static uint8_t s_dict[OTA_STREAM_DICT_SIZE];
+
+// 写入回调：写到内存“分区”，可在指定偏移后失败
+typedef struct {
+    uint8_t data[IMAGE_LEN + 64];
+    size_t len;
+    size_t fail_at;             // 0 表示不失败
+    uint32_t calls;
+} partition_t;
+
+static partition_t s_part;
+
+static int partition_write(void* ctx, const uint8_t* data, size_t len) {
+    partition_t* p = ctx;
+    p->calls++;
+    if (p->fail_at && p->len + len > p->fail_at) return -1;
+    if (p->len + len > sizeof(p->data)) return -1;
+    memcpy(p->data + p->len, data, len);
+    p->len += len;
+    return 0;
+}
+
+static void make_image(void) {
+    // 类似固件：重复的指令序列夹杂随机常量，可压缩但不平凡
+    uint32_t rng = 7;
+    for (size_t i = 0; i < IMAGE_LEN; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        s_image[i] = (i % 64 < 48) ? (uint8_t)(i % 48 * 5) : (uint8_t)(rng >> 24);
+    }
+    mz_ulong len = sizeof(s_zlib);
+    CHECK_INT(mz_compress2(s_zlib, &len, s_image, IMAGE_LEN, 6), MZ_OK);
+    s_zlib_len = len;
+    CHECK(s_zlib_len < IMAGE_LEN / 2);
+}
+
+static ota_stream_err_t run(bool compressed, const uint8_t* data, size_t len, size_t chunk, ota_stream_t* s) {
+    memset(&s_part, 0, offsetof(partition_t, fail_at));
+    ota_stream_init(s, compressed, compressed ? s_dict : NULL, partition_write, &s_part);
+    for (size_t off = 0; off < len; off += chunk) {
+        size_t n = len - off < chunk ? len - off : chunk;
+        ota_stream_err_t err = ota_stream_feed(s, data + off, n);
+        if (err != OTA_STREAM_OK) return err;
+    }
+    return ota_stream_finish(s);
+}
+
+static void test_passthrough(void) {
+    ota_stream_t s;
+    s_part.fail_at = 0;
+    CHECK_INT(run(false, s_image, IMAGE_LEN, 1460, &s), OTA_STREAM_OK);
+    CHECK_INT(s_part.len, IMAGE_LEN);
+    CHECK(memcmp(s_part.data, s_image, IMAGE_LEN) == 0);
+    CHECK_INT(s.in_total, IMAGE_LEN);
+    CHECK_INT(s.out_total, IMAGE_LEN);
+}
+
+static void test_inflate_any_chunking(void) {
+    static const size_t chunks[] = { 1, 7, 1460, 4096, 65536 };
+    s_part.fail_at = 0;
+    for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        ota_stream_t s;
+        CHECK_INT(run(true, s_zlib, s_zlib_len, chunks[i], &s), OTA_STREAM_OK);
+        CHECK(s.done);
+        CHECK_INT(s_part.len, IMAGE_LEN);
+        CHECK(memcmp(s_part.data, s_image, IMAGE_LEN) == 0);
+        CHECK_INT(s.in_total, s_zlib_len);
+        CHECK_INT(s.out_total, IMAGE_LEN);
+    }
+}
+
+static void test_trailing_padding_ignored(void) {
+    static uint8_t padded[sizeof(s_zlib) + 512];
+    memcpy(padded, s_zlib, s_zlib_len);
+    memset(padded + s_zlib_len, 0xFF, 512);
+    ota_stream_t s;
+    s_part.fail_at = 0;
+    CHECK_INT(run(true, padded, s_zlib_len + 512, 1000, &s), OTA_STREAM_OK);
+    CHECK_INT(s_part.len, IMAGE_LEN);
+}
+
+static void test_truncated(void) {
+    static const size_t cut[] = { 1, 4, 100, 5000 };
+    s_part.fail_at = 0;
+    for (size_t i = 0; i < sizeof(cut) / sizeof(cut[0]); i++) {
+        ota_stream_t s;
+        CHECK_INT(run(true, s_zlib, s_zlib_len - cut[i], 1460, &s), OTA_STREAM_ERR_TRUNCATED);
+        CHECK(!s.done);
+    }
+    ota_stream_t s;
+    CHECK_INT(run(true, s_zlib, 0, 1460, &s), OTA_STREAM_ERR_TRUNCATED);
+}
+
+static void test_corrupt(void) {
+    static uint8_t bad[sizeof(s_zlib)];
+    ota_stream_t s;
+    s_part.fail_at = 0;
+
+    memcpy(bad, s_zlib, s_zlib_len);
+    bad[0] ^= 0x0F;                     // zlib 头
+    CHECK_INT(run(true, bad, s_zlib_len, 1460, &s), OTA_STREAM_ERR_DATA);
+
+    memcpy(bad, s_zlib, s_zlib_len);
+    bad[s_zlib_len - 2] ^= 0x55;        // Adler-32
+    CHECK_INT(run(true, bad, s_zlib_len, 1460, &s), OTA_STREAM_ERR_DATA);
+
+    // 未压缩镜像被当作压缩流
+    CHECK_INT(run(true, s_image, IMAGE_LEN, 1460, &s), OTA_STREAM_ERR_DATA);
+}
+
+static void test_sink_failure(void) {
+    ota_stream_t s;
+    s_part.fail_at = 70000;
+    CHECK_INT(run(true, s_zlib, s_zlib_len, 1460, &s), OTA_STREAM_ERR_SINK);
+    CHECK(s_part.len <= 70000);
+    CHECK_INT(s.out_total, s_part.len);
+    CHECK_INT(run(false, s_image, IMAGE_LEN, 1460, &s), OTA_STREAM_ERR_SINK);
+    s_part.fail_at = 0;
+
+    CHECK_STR(ota_stream_err_name(OTA_STREAM_ERR_TRUNCATED), "truncated");
+    CHECK_STR(ota_stream_err_name(OTA_STREAM_ERR_SINK), "write");
+}
+
+int main(void) {
+    make_image();
+    RUN(test_passthrough);
+    RUN(test_inflate_any_chunking);
+    RUN(test_trailing_padding_ignored);
+    RUN(test_truncated);
+    RUN(test_corrupt);
+    RUN(test_sink_failure);
+    return HOST_TEST_RESULT();
+}
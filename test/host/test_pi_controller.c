@@ -0,0 +1,87 @@
+#include "host_test.h"
+#include "pi_controller.h"
+
+/**
+ * @brief PI 控制器：反作用方向、无扰切换、条件积分抗饱和、输出限幅、复位
+ */
+
+static void test_bumpless_first_update(void) {
+    pi_controller_t pi;
+    pi_controller_init(&pi, 10.0f, 0.1f);
+    // 首次更新输出等于切换前的输出，不论误差多大
+    CHECK_NEAR(pi_controller_update(&pi, 30.0f, 32.0f, 5.0f, 55.0f, 100.0f), 55.0f, 1e-4);
+    CHECK(pi.initialized);
+    CHECK_NEAR(pi.integral, 35.0f, 1e-4);
+}
+
+static void test_reverse_acting(void) {
+    pi_controller_t pi;
+    pi_controller_init(&pi, 10.0f, 0.1f);
+    pi_controller_update(&pi, 30.0f, 30.0f, 1.0f, 50.0f, 100.0f);
+    // 温度高于设定值：输出增大，并随时间继续积分
+    float a = pi_controller_update(&pi, 30.0f, 31.0f, 1.0f, 0.0f, 100.0f);
+    CHECK_NEAR(a, 50.0f + 10.0f + 0.1f, 1e-4);
+    float b = pi_controller_update(&pi, 30.0f, 31.0f, 1.0f, 0.0f, 100.0f);
+    CHECK(b > a);
+    // 低于设定值：输出减小
+    CHECK(pi_controller_update(&pi, 30.0f, 29.0f, 1.0f, 0.0f, 100.0f) < b);
+}
+
+static void test_anti_windup(void) {
+    pi_controller_t pi;
+    pi_controller_init(&pi, 5.0f, 0.5f);
+    pi_controller_update(&pi, 30.0f, 30.0f, 1.0f, 90.0f, 100.0f);
+    // 长时间高于设定值：输出饱和，积分不再增长
+    for (int i = 0; i < 1000; i++) {
+        CHECK_NEAR(pi_controller_update(&pi, 30.0f, 40.0f, 1.0f, 0.0f, 100.0f), 100.0f, 1e-4);
+    }
+    CHECK(pi.integral <= 100.0f);
+    // 误差反向后立即离开饱和，而不是先把积累的积分放完
+    float out = pi_controller_update(&pi, 30.0f, 29.0f, 1.0f, 0.0f, 100.0f);
+    CHECK(out < 100.0f);
+
+    // 下限同理
+    pi_controller_reset(&pi);
+    pi_controller_update(&pi, 30.0f, 30.0f, 1.0f, 5.0f, 100.0f);
+    for (int i = 0; i < 1000; i++) pi_controller_update(&pi, 30.0f, 20.0f, 1.0f, 0.0f, 100.0f);
+    CHECK(pi.integral >= 0.0f && pi.integral <= 5.0f);
+    CHECK(pi_controller_update(&pi, 30.0f, 31.0f, 1.0f, 0.0f, 100.0f) > 0.0f);
+}
+
+static void test_output_limit_follows_caller(void) {
+    pi_controller_t pi;
+    pi_controller_init(&pi, 10.0f, 0.1f);
+    pi_controller_update(&pi, 30.0f, 30.0f, 1.0f, 80.0f, 100.0f);
+    // 上限降低（如 max_speed 下调）时输出和积分都被限住
+    CHECK_NEAR(pi_controller_update(&pi, 30.0f, 30.0f, 1.0f, 0.0f, 60.0f), 60.0f, 1e-4);
+    CHECK(pi.integral <= 60.0f);
+}
+
+static void test_zero_dt_does_not_integrate(void) {
+    pi_controller_t pi;
+    pi_controller_init(&pi, 10.0f, 0.1f);
+    pi_controller_update(&pi, 30.0f, 30.0f, 1.0f, 40.0f, 100.0f);
+    float before = pi.integral;
+    pi_controller_update(&pi, 30.0f, 35.0f, 0.0f, 0.0f, 100.0f);
+    pi_controller_update(&pi, 30.0f, 35.0f, -3.0f, 0.0f, 100.0f);
+    CHECK_NEAR(pi.integral, before, 0.0);
+}
+
+static void test_reset_rebumps(void) {
+    pi_controller_t pi;
+    pi_controller_init(&pi, 10.0f, 0.1f);
+    pi_controller_update(&pi, 30.0f, 30.0f, 1.0f, 40.0f, 100.0f);
+    pi_controller_reset(&pi);
+    CHECK(!pi.initialized);
+    CHECK_NEAR(pi_controller_update(&pi, 30.0f, 31.0f, 1.0f, 70.0f, 100.0f), 70.0f, 1e-4);
+}
+
+int main(void) {
+    RUN(test_bumpless_first_update);
+    RUN(test_reverse_acting);
+    RUN(test_anti_windup);
+    RUN(test_output_limit_follows_caller);
+    RUN(test_zero_dt_does_not_integrate);
+    RUN(test_reset_rebumps);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,106 @@
+#include "host_test.h"
+#include "pm_accounting.h"
+
+static void test_nested_locks(void) {
+    pm_accounting_t a;
+    pm_acct_init(&a, 1000);
+    CHECK(pm_acct_acquire(&a, 0, 2000));
+    CHECK(!pm_acct_acquire(&a, 0, 2500));      // 嵌套：硬件锁已持有
+    CHECK_INT(a.state, PM_STATE_ACTIVE);
+    CHECK(!pm_acct_release(&a, 0, 3000));
+    CHECK_INT(a.state, PM_STATE_ACTIVE);
+    CHECK(pm_acct_release(&a, 0, 4000));
+    CHECK_INT(a.state, PM_STATE_LOW_POWER);
+    CHECK_INT(a.held_us[0], 2000);
+    CHECK_INT(a.acquire_count[0], 1);
+    CHECK_INT(a.state_us[PM_STATE_ACTIVE], 2000);
+    CHECK_INT(a.state_us[PM_STATE_LOW_POWER], 1000);
+}
+
+static void test_overlapping_locks(void) {
+    pm_accounting_t a;
+    pm_acct_init(&a, 0);
+    pm_acct_acquire(&a, 0, 100);
+    pm_acct_acquire(&a, 1, 200);
+    pm_acct_release(&a, 0, 300);
+    CHECK_INT(a.state, PM_STATE_ACTIVE);       // 锁 1 仍持有
+    pm_acct_release(&a, 1, 500);
+    CHECK_INT(a.held_us[0], 200);
+    CHECK_INT(a.held_us[1], 300);
+    CHECK_INT(a.state_us[PM_STATE_ACTIVE], 400);
+    CHECK_INT(a.active_locks, 0);
+}
+
+static void test_unbalanced_and_invalid(void) {
+    pm_accounting_t a;
+    pm_acct_init(&a, 0);
+    CHECK(!pm_acct_release(&a, 2, 10));
+    CHECK_INT(a.unbalanced_release, 1);
+    CHECK(!pm_acct_acquire(&a, -1, 10));
+    CHECK(!pm_acct_acquire(&a, PM_ACCT_MAX_LOCKS, 10));
+    CHECK_INT(a.state, PM_STATE_LOW_POWER);
+}
+
+static void test_snapshot_settles_open_intervals(void) {
+    pm_accounting_t a, snap;
+    pm_acct_init(&a, 0);
+    pm_acct_acquire(&a, 3, 1000);
+    pm_acct_snapshot(&a, 5000, &snap);
+    CHECK_INT(snap.held_us[3], 4000);
+    CHECK_INT(snap.state_us[PM_STATE_ACTIVE], 4000);
+    CHECK_INT(snap.state_us[PM_STATE_LOW_POWER], 1000);
+    // 快照不改动原记录，之后的结算不重复计入
+    CHECK_INT(a.held_us[3], 0);
+    pm_acct_release(&a, 3, 6000);
+    CHECK_INT(a.held_us[3], 5000);
+    pm_acct_snapshot(&a, 6000, &snap);
+    CHECK_INT(snap.state_us[PM_STATE_ACTIVE] + snap.state_us[PM_STATE_LOW_POWER], 6000);
+}
+
+// esp_pm_dump_locks 在 CONFIG_PM_PROFILING 下的输出（ESP32，启用浅睡眠）
+static const char* DUMP =
+    "Time: 600004211\n"
+    "Lock stats:\n"
+    "      Name            Type  Arg  Active Total_count   Time(us)  Time(%)\n"
+    "       input  NO_LIGHT_SLEEP    0       0          12    24011032       4%\n"
+    "         i2c    APB_FREQ_MAX    0       0         120      640211       0%\n"
+    "\n"
+    "Mode stats:\n"
+    "Mode      CPU_freq  Time(us)    Time(%)\n"
+    "SLEEP     40M       512003120   85%\n"
+    "APB_MIN   40M       61200455    10%\n"
+    "APB_MAX   80M       20100001    3%\n"
+    "CPU_MAX   240M      6700635     1%\n"
+    "\n"
+    "Sleep stats:\n"
+    "light_sleep_counts:4821  light_sleep_reject_counts:37\n";
+
+static void test_mode_stats_parse(void) {
+    pm_mode_stats_t m;
+    CHECK(pm_mode_stats_parse(DUMP, &m));
+    CHECK(m.mode_us[PM_CHIP_SLEEP] == 512003120ULL);
+    CHECK(m.mode_us[PM_CHIP_APB_MIN] == 61200455ULL);
+    CHECK(m.mode_us[PM_CHIP_APB_MAX] == 20100001ULL);
+    CHECK(m.mode_us[PM_CHIP_CPU_MAX] == 6700635ULL);
+    CHECK_INT(m.light_sleeps, 4821);
+    CHECK_INT(m.sleep_rejects, 37);
+
+    // 锁表中的行不会被当作模式；未启用浅睡眠时没有 SLEEP 行
+    CHECK(pm_mode_stats_parse("Lock stats:\nCPU_MAX 240M 5\n\nMode stats:\nCPU_MAX   240M      900     1%\n", &m));
+    CHECK(m.mode_us[PM_CHIP_CPU_MAX] == 900);
+    CHECK(m.mode_us[PM_CHIP_SLEEP] == 0);
+    CHECK_INT(m.light_sleeps, 0);
+
+    // 输出被截断在模式表之前
+    CHECK(!pm_mode_stats_parse("Time: 1\nLock stats:\n", &m));
+    CHECK(!pm_mode_stats_parse(NULL, &m));
+}
+
+int main(void) {
+    RUN(test_nested_locks);
+    RUN(test_overlapping_locks);
+    RUN(test_unbalanced_and_invalid);
+    RUN(test_snapshot_settles_open_intervals);
+    RUN(test_mode_stats_parse);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,102 @@
+#include "host_test.h"
+#include "relay_autotune.h"
+
+/**
+ * @brief 继电自整定：切换逻辑、周期计数与 Ku/Tu 计算、各中止路径、PI 增益规则
+ */
+
+#define T0 1000u
+
+static autotune_config_t config(void) {
+    autotune_config_t cfg;
+    relay_autotune_default_config(&cfg, 30.0f);
+    return cfg;
+}
+
+/**
+ * @brief 以理想三角波驱动：周期 period_s，振幅 amp，采样 1 s
+ */
+static uint32_t drive_triangle(relay_autotune_t* tune, float amp, uint32_t period_s, uint32_t cycles, uint32_t now) {
+    for (uint32_t t = 0; t < period_s * cycles && tune->phase == AUTOTUNE_RELAY; t++, now += 1000) {
+        float phase = (float)(t % period_s) / period_s;
+        float x = phase < 0.5f ? -1.0f + 4.0f * phase : 3.0f - 4.0f * phase;
+        relay_autotune_step(tune, 30.0f + amp * x, now);
+    }
+    return now;
+}
+
+static void test_relay_switching(void) {
+    autotune_config_t cfg = config();
+    relay_autotune_t tune;
+    relay_autotune_start(&tune, &cfg, T0);
+    CHECK_INT(relay_autotune_step(&tune, 30.1f, T0), 0);       // 滞环内保持低输出
+    CHECK_INT(relay_autotune_step(&tune, 30.3f, T0 + 1000), 100);
+    CHECK_INT(relay_autotune_step(&tune, 29.9f, T0 + 2000), 100);
+    CHECK_INT(relay_autotune_step(&tune, 29.7f, T0 + 3000), 0);
+    CHECK_INT(relay_autotune_progress(&tune), 0);
+}
+
+static void test_identifies_limit_cycle(void) {
+    autotune_config_t cfg = config();
+    relay_autotune_t tune;
+    relay_autotune_start(&tune, &cfg, T0);
+    drive_triangle(&tune, 1.0f, 120, 10, T0);
+    CHECK_INT(tune.phase, AUTOTUNE_DONE);
+    CHECK_INT(relay_autotune_progress(&tune), cfg.cycles);
+    CHECK_NEAR(tune.tu_s, 120.0f, 2.0);
+    // Ku = 4d / (π·sqrt(a² - h²))，d = 50，a ≈ 1
+    float a = 1.0f, h = cfg.hysteresis;
+    CHECK_NEAR(tune.ku, 200.0f / (3.14159265f * sqrtf(a * a - h * h)), 3.0);
+
+    float kp, ki;
+    CHECK(relay_autotune_pi_gains(&tune, &kp, &ki));
+    CHECK_NEAR(kp, tune.ku / 3.2f, 1e-4);
+    CHECK_NEAR(ki, kp / (2.2f * tune.tu_s), 1e-6);
+    CHECK_INT(relay_autotune_step(&tune, 35.0f, T0), 0);      // 完成后不再输出
+}
+
+static void test_abort_paths(void) {
+    autotune_config_t cfg = config();
+    relay_autotune_t tune;
+    float kp, ki;
+
+    relay_autotune_start(&tune, &cfg, T0);
+    relay_autotune_step(&tune, -127.0f, T0);
+    CHECK_INT(tune.abort_reason, AUTOTUNE_ABORT_SENSOR);
+    CHECK(!relay_autotune_pi_gains(&tune, &kp, &ki));
+
+    relay_autotune_start(&tune, &cfg, T0);
+    relay_autotune_step(&tune, 30.0f + cfg.max_excursion + 0.1f, T0);
+    CHECK_INT(tune.abort_reason, AUTOTUNE_ABORT_OVERTEMP);
+
+    relay_autotune_start(&tune, &cfg, T0);
+    relay_autotune_step(&tune, 30.0f, T0 + cfg.timeout_ms + 1);
+    CHECK_INT(tune.abort_reason, AUTOTUNE_ABORT_TIMEOUT);
+
+    relay_autotune_start(&tune, &cfg, T0);
+    relay_autotune_abort(&tune, AUTOTUNE_ABORT_USER);
+    CHECK_INT(tune.phase, AUTOTUNE_ABORTED);
+    relay_autotune_abort(&tune, AUTOTUNE_ABORT_SENSOR);        // 已中止：保留首个原因
+    CHECK_INT(tune.abort_reason, AUTOTUNE_ABORT_USER);
+    CHECK_STR(relay_autotune_abort_name(tune.abort_reason), "user");
+    CHECK_STR(relay_autotune_phase_name(tune.phase), "aborted");
+}
+
+static void test_inconsistent_cycles(void) {
+    autotune_config_t cfg = config();
+    relay_autotune_t tune;
+    relay_autotune_start(&tune, &cfg, T0);
+    // 过渡周期 + 周期 60/60/200 秒：差异超过 30%
+    uint32_t now = drive_triangle(&tune, 1.0f, 60, 3, T0);
+    drive_triangle(&tune, 1.0f, 200, 2, now);
+    CHECK_INT(tune.phase, AUTOTUNE_ABORTED);
+    CHECK_INT(tune.abort_reason, AUTOTUNE_ABORT_INCONSISTENT);
+}
+
+int main(void) {
+    RUN(test_relay_switching);
+    RUN(test_identifies_limit_cycle);
+    RUN(test_abort_paths);
+    RUN(test_inconsistent_cycles);
+    return HOST_TEST_RESULT();
+}
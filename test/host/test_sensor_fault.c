@@ -0,0 +1,252 @@
+#include "host_test.h"
+#include "sensor_fault.h"
+#include <math.h>
+
+/**
+ * @brief 传感器故障分类：掉线/CRC 确认与恢复、外推超时进入失效安全、上电值与跳变、
+ *        卡滞判据（激励摆动 + 时长，激励不变时不判卡滞）与最后可信时刻的回溯上限、失效安全占空比下限
+ */
+
+#define T0      1000u
+#define STEP_MS 5000u
+
+static bool feed(sensor_fault_t* sf, sensor_read_t read, float temp_c, uint8_t drive, uint32_t now_ms) {
+    return sensor_fault_update(sf, read, temp_c, drive, now_ms);
+}
+
+static void test_configure_limits(void) {
+    sensor_fault_t sf;
+    sensor_fault_init(&sf, SENSOR_FAULT_HOLDOVER_MAX_MS + 1, 150);
+    CHECK_INT(sf.holdover_ms, SENSOR_FAULT_HOLDOVER_MAX_MS);
+    CHECK_INT(sf.failsafe_fan, 100);
+    CHECK_INT(sf.state, SENSOR_STATE_OK);
+
+    // 失效安全时温度未知，风扇不允许配置到停转
+    sensor_fault_configure(&sf, 0, 0);
+    CHECK_INT(sf.holdover_ms, 0);
+    CHECK_INT(sf.failsafe_fan, SENSOR_FAULT_FAILSAFE_FAN_MIN);
+    sensor_fault_configure(&sf, 60000, SENSOR_FAULT_FAILSAFE_FAN_MIN - 1);
+    CHECK_INT(sf.failsafe_fan, SENSOR_FAULT_FAILSAFE_FAN_MIN);
+    sensor_fault_configure(&sf, 60000, 70);
+    CHECK_INT(sf.failsafe_fan, 70);
+}
+
+static void test_missing_holdover_failsafe_recover(void) {
+    sensor_fault_t sf;
+    sensor_fault_init(&sf, 120000, 80);
+    uint32_t now = T0;
+    CHECK(feed(&sf, SENSOR_READ_OK, 30.0f, 50, now));
+
+    // 单次 CRC 错误只丢弃读数
+    now += STEP_MS;
+    CHECK(!feed(&sf, SENSOR_READ_CRC_ERROR, 0.0f, 50, now));
+    CHECK_INT(sf.last, SENSOR_FAULT_CRC);
+    CHECK_INT(sf.state, SENSOR_STATE_OK);
+    now += STEP_MS;
+    CHECK(feed(&sf, SENSOR_READ_OK, 30.5f, 50, now));
+    uint32_t last_good = now;
+
+    for (int i = 0; i < SENSOR_FAULT_CONFIRM; i++) {
+        now += STEP_MS;
+        CHECK_INT(sf.state, SENSOR_STATE_OK);
+        CHECK(!feed(&sf, SENSOR_READ_NO_DEVICE, 0.0f, 50, now));
+    }
+    CHECK_INT(sf.state, SENSOR_STATE_HOLDOVER);
+    CHECK_INT(sf.fault, SENSOR_FAULT_MISSING);
+    CHECK_INT(sf.faults[SENSOR_FAULT_MISSING], 1);
+    CHECK_INT(sf.faults[SENSOR_FAULT_CRC], 0);
+    CHECK_INT(sensor_fault_age_ms(&sf, now + 1000), 1000);
+
+    // 外推只跟随上升趋势，最多高出最后可信值 5°C
+    CHECK_NEAR(sensor_fault_bound(&sf, 33.0f), 33.0, 1e-6);
+    CHECK_NEAR(sensor_fault_bound(&sf, 40.0f), 30.5 + SENSOR_FAULT_EXTRAP_MAX_C, 1e-6);
+    CHECK_NEAR(sensor_fault_bound(&sf, 20.0f), 30.5, 1e-6);
+    CHECK_NEAR(sensor_fault_bound(&sf, NAN), 30.5, 1e-6);
+
+    // 距最后可信读数满外推时限进入失效安全
+    while (now + STEP_MS - last_good < 120000) {
+        now += STEP_MS;
+        feed(&sf, SENSOR_READ_NO_DEVICE, 0.0f, 50, now);
+        CHECK_INT(sf.state, SENSOR_STATE_HOLDOVER);
+    }
+    now += STEP_MS;
+    feed(&sf, SENSOR_READ_CRC_ERROR, 0.0f, 50, now);
+    CHECK_INT(sf.state, SENSOR_STATE_FAILSAFE);
+    CHECK_INT(sf.fault, SENSOR_FAULT_CRC);                   // 故障期间跟随最近一次异常
+    CHECK_INT(sf.failsafe_entries, 1);
+
+    // 连续 3 次可信读数才恢复，故障类型保留供上报
+    for (int i = 0; i < SENSOR_FAULT_CLEAR; i++) {
+        CHECK_INT(sf.state, SENSOR_STATE_FAILSAFE);
+        now += STEP_MS;
+        CHECK(feed(&sf, SENSOR_READ_OK, 31.0f + i * 0.0625f, 100, now));
+    }
+    CHECK_INT(sf.state, SENSOR_STATE_OK);
+    CHECK_INT(sf.fault, SENSOR_FAULT_CRC);
+    CHECK_INT(sensor_fault_age_ms(&sf, now), 0);
+    CHECK_NEAR(sensor_fault_bound(&sf, 20.0f), 20.0, 1e-6);
+}
+
+static void test_no_sensor_at_boot(void) {
+    sensor_fault_t sf;
+    sensor_fault_init(&sf, SENSOR_FAULT_HOLDOVER_MAX_MS, 80);
+    uint32_t now = T0;
+    for (int i = 0; i < SENSOR_FAULT_CONFIRM; i++) {
+        now += STEP_MS;
+        feed(&sf, SENSOR_READ_NO_DEVICE, 0.0f, 0, now);
+    }
+    // 从无可信读数，没有可外推的值
+    CHECK_INT(sf.state, SENSOR_STATE_FAILSAFE);
+    CHECK_NEAR(sensor_fault_bound(&sf, 27.0f), 27.0, 1e-6);
+}
+
+static void test_implausible_and_jump(void) {
+    sensor_fault_t sf;
+    sensor_fault_init(&sf, 120000, 100);
+    uint32_t now = T0;
+    CHECK(!feed(&sf, SENSOR_READ_OK, SENSOR_FAULT_POWER_ON_C, 0, now));   // 开机的上电值
+    CHECK_INT(sf.last, SENSOR_FAULT_IMPLAUSIBLE);
+    now += STEP_MS;
+    CHECK(feed(&sf, SENSOR_READ_OK, 30.0f, 0, now));
+    now += STEP_MS;
+    CHECK(!feed(&sf, SENSOR_READ_OK, 130.0f, 0, now));
+    now += STEP_MS;
+    CHECK(!feed(&sf, SENSOR_READ_OK, NAN, 0, now));
+    CHECK_INT(sf.state, SENSOR_STATE_OK);                   // 连续 2 次，未达确认次数
+    now += STEP_MS;
+    CHECK(feed(&sf, SENSOR_READ_OK, 30.0625f, 0, now));
+
+    // 超出物理变化率的跳变：连续 3 次彼此一致时视为真实变化
+    for (int i = 0; i < SENSOR_FAULT_CONFIRM - 1; i++) {
+        now += STEP_MS;
+        CHECK(!feed(&sf, SENSOR_READ_OK, 45.0f, 0, now));
+    }
+    now += STEP_MS;
+    CHECK(feed(&sf, SENSOR_READ_OK, 45.0f, 0, now));
+    CHECK_INT(sf.state, SENSOR_STATE_OK);
+    CHECK_NEAR(sf.last_good_c, 45.0, 1e-6);
+
+    // 彼此不一致的跳变一直被拒绝并确认故障
+    for (int i = 0; i < SENSOR_FAULT_CONFIRM; i++) {
+        now += STEP_MS;
+        CHECK(!feed(&sf, SENSOR_READ_OK, i % 2 ? 10.0f : 80.0f, 0, now));
+    }
+    CHECK_INT(sf.state, SENSOR_STATE_HOLDOVER);
+    CHECK_INT(sf.fault, SENSOR_FAULT_IMPLAUSIBLE);
+}
+
+/**
+ * @brief 每 STEP_MS 一次恒定读数，drive_at 给出各时刻的激励，直到确认故障或到达 until_ms
+ * @return 确认故障的时刻，未确认返回 0
+ */
+static uint32_t hold_reading(sensor_fault_t* sf, uint32_t from_ms, uint32_t until_ms,
+                             uint8_t (*drive_at)(uint32_t elapsed_ms)) {
+    for (uint32_t now = from_ms; now <= until_ms; now += STEP_MS) {
+        feed(sf, SENSOR_READ_OK, 30.0f, drive_at(now - from_ms), now);
+        if (sf->state != SENSOR_STATE_OK) return now;
+    }
+    return 0;
+}
+
+static uint8_t drive_constant(uint32_t elapsed_ms) {
+    return 60;
+}
+
+static uint8_t drive_dither(uint32_t elapsed_ms) {
+    return (elapsed_ms / STEP_MS) % 2 ? 64 : 60;           // 小于 SENSOR_FAULT_STUCK_IDLE_SWING
+}
+
+static uint8_t drive_step_at_1min(uint32_t elapsed_ms) {
+    return elapsed_ms < 60000 ? 20 : 90;
+}
+
+static uint8_t drive_small_step_at_20min(uint32_t elapsed_ms) {
+    return elapsed_ms < 1200000 ? 50 : 60;
+}
+
+static void test_idle_constant_is_not_stuck(void) {
+    // 恒温环境、激励不变或只有小幅抖动：读数可以几个小时逐位不变
+    sensor_fault_t sf;
+    sensor_fault_init(&sf, 120000, 100);
+    CHECK_INT(hold_reading(&sf, T0, T0 + 4 * 3600000u, drive_constant), 0);
+    CHECK_INT(sf.faults[SENSOR_FAULT_STUCK], 0);
+    sensor_fault_init(&sf, 120000, 100);
+    CHECK_INT(hold_reading(&sf, T0, T0 + 4 * 3600000u, drive_dither), 0);
+    CHECK_INT(sf.faults[SENSOR_FAULT_STUCK], 0);
+
+    // 长时间不变后激励突然大幅变化：读数还来不及响应，不立即判卡滞
+    sensor_fault_init(&sf, 120000, 100);
+    CHECK_INT(hold_reading(&sf, T0, T0 + 3600000u, drive_constant), 0);
+    CHECK(feed(&sf, SENSOR_READ_OK, 30.0f, 100, T0 + 3600000u + STEP_MS));
+    CHECK(feed(&sf, SENSOR_READ_OK, 30.0625f, 100, T0 + 3600000u + 2 * STEP_MS));
+    CHECK_INT(sf.faults[SENSOR_FAULT_STUCK], 0);
+}
+
+static void test_stuck_after_drive_swing(void) {
+    sensor_fault_t sf;
+    sensor_fault_init(&sf, 600000, 100);
+    uint32_t at = hold_reading(&sf, T0, T0 + 3600000u, drive_step_at_1min);
+    CHECK_INT(at, T0 + 60000 + SENSOR_FAULT_STUCK_MS);      // 从激励变化时计时
+    CHECK_INT(sf.fault, SENSOR_FAULT_STUCK);
+    CHECK_INT(sf.state, SENSOR_STATE_HOLDOVER);
+    // 激励变化之前的不变读数仍算可信
+    CHECK_INT(sf.last_good_ms, T0 + 60000);
+    CHECK_INT(sf.faults[SENSOR_FAULT_STUCK], 1);
+
+    // 外推时限从激励变化时算起
+    uint32_t now = at;
+    while (sf.state == SENSOR_STATE_HOLDOVER) {
+        now += STEP_MS;
+        CHECK(!feed(&sf, SENSOR_READ_OK, 30.0f, 90, now));
+    }
+    CHECK_INT(now, T0 + 60000 + 600000);
+    CHECK_INT(sf.state, SENSOR_STATE_FAILSAFE);
+
+    // 读数重新变化后恢复
+    for (int i = 1; i <= SENSOR_FAULT_CLEAR; i++) {
+        now += STEP_MS;
+        CHECK(feed(&sf, SENSOR_READ_OK, 30.0f + i * 0.0625f, 90, now));
+    }
+    CHECK_INT(sf.state, SENSOR_STATE_OK);
+}
+
+static void test_idle_stuck_needs_drive_change(void) {
+    // 小幅激励变化后读数长时间不变：按长判据确认，最后可信时刻为激励变化时
+    sensor_fault_t sf;
+    sensor_fault_init(&sf, SENSOR_FAULT_HOLDOVER_MAX_MS, 100);
+    uint32_t at = hold_reading(&sf, T0, T0 + 3600000u, drive_small_step_at_20min);
+    CHECK_INT(at, T0 + 1200000 + SENSOR_FAULT_STUCK_IDLE_MS);
+    CHECK_INT(sf.fault, SENSOR_FAULT_STUCK);
+    CHECK_INT(sf.state, SENSOR_STATE_HOLDOVER);
+    CHECK_INT(sf.last_good_ms, T0 + 1200000);
+
+    // 回溯不超过外推时限：默认 120 秒时直接失效安全，而不是回溯 10 分钟
+    sensor_fault_init(&sf, 120000, 100);
+    at = hold_reading(&sf, T0, T0 + 3600000u, drive_small_step_at_20min);
+    CHECK_INT(at, T0 + 1200000 + SENSOR_FAULT_STUCK_IDLE_MS);
+    CHECK_INT(sf.state, SENSOR_STATE_FAILSAFE);
+    CHECK_INT(sf.last_good_ms, at - 120000);
+
+    // 恢复时的变化率检查按回溯后的时刻计算，不因几十分钟的卡滞放宽到允许任意跳变
+    at += STEP_MS;
+    CHECK(!feed(&sf, SENSOR_READ_OK, 110.0f, 60, at));
+    CHECK_INT(sf.last, SENSOR_FAULT_IMPLAUSIBLE);
+}
+
+static void test_names(void) {
+    CHECK_STR(sensor_fault_kind_name(SENSOR_FAULT_STUCK), "stuck");
+    CHECK_STR(sensor_fault_kind_name(SENSOR_FAULT_KIND_COUNT), "unknown");
+    CHECK_STR(sensor_fault_state_name(SENSOR_STATE_FAILSAFE), "failsafe");
+}
+
+int main(void) {
+    RUN(test_configure_limits);
+    RUN(test_missing_holdover_failsafe_recover);
+    RUN(test_no_sensor_at_boot);
+    RUN(test_implausible_and_jump);
+    RUN(test_idle_constant_is_not_stuck);
+    RUN(test_stuck_after_drive_swing);
+    RUN(test_idle_stuck_needs_drive_change);
+    RUN(test_names);
+    return HOST_TEST_RESULT();
+}
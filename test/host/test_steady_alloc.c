@@ -0,0 +1,118 @@
+#include "host_test.h"
+#include "host_stubs.h"
+#include "mqtt_comm.h"
+#include <stdlib.h>
+
+/**
+ * @brief 稳态路径不使用堆：链接时以 --wrap 截获被测代码（mqtt_comm、cJSON、桩）中的 malloc/calloc/realloc，
+ *        预热一轮后重复上报和解析，分配次数应为 0。设备上由 heap_guard 做同样的检查
+ *        桩的 host_mqtt_deliver 为每条消息分配主题和数据缓冲，以未路由主题的投递作为基准扣除
+ */
+
+#define DEV "esp32/fan_control/fan-240ac4000001"
+#define ROUNDS 200
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* p, size_t size);
+
+static uint32_t s_allocs;
+
+void* __wrap_malloc(size_t size) {
+    s_allocs++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+    s_allocs++;
+    return __real_calloc(n, size);
+}
+
+void* __wrap_realloc(void* p, size_t size) {
+    s_allocs++;
+    return __real_realloc(p, size);
+}
+
+static esp_mqtt_client_handle_t s_client;
+static int s_commands, s_configs;
+
+static void on_command(const mqtt_command_t* cmd, mqtt_command_ack_t* ack) {
+    s_commands++;
+}
+
+static void on_config(const mqtt_config_t* cfg) {
+    s_configs++;
+}
+
+static void deliver(const char* topic, const char* data) {
+    host_mqtt_deliver(s_client, topic, data, (int)strlen(data));
+}
+
+/**
+ * @brief 一个控制/上报周期内的全部发布路径
+ */
+static void publish_round(int i) {
+    mqtt_comm_publish(s_client, 25.0f + (i % 10) * 0.1f, (uint8_t)(i % 100), i % 2);
+    mqtt_telemetry_t tm = {
+        .uptime_s = (uint32_t)i, .has_hot_side = true, .hot_side_c = 40.0f,
+        .sensor_state = "ok", .sensor_fault = "none", .fan_duty = 50, .tec_duty = 20,
+    };
+    mqtt_comm_publish_telemetry(s_client, &tm);
+    shadow_state_t st = { .temp_centi = (int16_t)(2500 + i * 20), .fan_speed = (uint8_t)(i % 100),
+                          .cooler_power = 20, .auto_mode = true, .threshold_deci = 300, .max_speed = 100 };
+    mqtt_comm_update_shadow(s_client, &st);
+    mqtt_autotune_report_t at = { .phase = "relay", .cycle = 1, .cycles = 3 };
+    mqtt_comm_publish_autotune(s_client, &at);
+    mqtt_sensor_report_t sr = { .state = "holdover", .fault = "crc", .fault_s = 3, .holdover_s = 120,
+                                .failsafe_fan = 100 };
+    mqtt_comm_publish_sensor(s_client, &sr);
+    mqtt_comm_service(s_client);
+}
+
+/**
+ * @brief 一轮入站消息：命令（含回执）、配置、期望状态、历史查询
+ */
+static void parse_round(int i) {
+    char buf[96];
+    snprintf(buf, sizeof(buf), "{\"speed\":%d,\"mode\":\"manual\",\"id\":\"c%d\"}", i % 100, i);
+    deliver(DEV "/command", buf);
+    deliver(DEV "/config", "{\"temp_threshold\":29.5,\"max_speed\":90,\"sensor\":{\"holdover_s\":60}}");
+    snprintf(buf, sizeof(buf), "{\"desired_v\":%d,\"speed\":40}", i + 1);
+    deliver(DEV "/state/desired", buf);
+    deliver(DEV "/history/get", "{\"id\":\"h1\",\"field\":\"temp\",\"from_s\":600}");
+}
+
+static void test_publish_path_is_heap_free(void) {
+    publish_round(0);                   // 预热
+    s_allocs = 0;
+    for (int i = 1; i <= ROUNDS; i++) publish_round(i);
+    CHECK_INT(s_allocs, 0);
+}
+
+static void test_parse_path_uses_arena(void) {
+    // 基准：桩投递本身的分配
+    s_allocs = 0;
+    deliver(DEV "/unrouted", "{}");
+    uint32_t per_delivery = s_allocs;
+    CHECK(per_delivery > 0);
+
+    parse_round(0);
+    s_commands = s_configs = 0;
+    s_allocs = 0;
+    for (int i = 1; i <= ROUNDS; i++) parse_round(i);
+    CHECK_INT(s_allocs, per_delivery * 4 * ROUNDS);
+    CHECK_INT(s_commands, ROUNDS);
+    CHECK_INT(s_configs, ROUNDS);
+}
+
+int main(void) {
+    host_nvs_reset();
+    s_client = mqtt_comm_init();
+    mqtt_comm_set_command_callback(on_command);
+    mqtt_comm_set_config_callback(on_config);
+    host_mqtt_event(s_client, MQTT_EVENT_CONNECTED, 0);
+
+    RUN(test_publish_path_is_heap_free);
+    RUN(test_parse_path_uses_arena);
+    return HOST_TEST_RESULT();
+}
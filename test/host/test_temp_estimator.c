@@ -0,0 +1,112 @@
+#include "host_test.h"
+#include "temp_estimator.h"
+
+/**
+ * @brief 温度估计器：DS18B20 特殊值剔除、离群门限、连续离群重置、变化率跟踪
+ */
+
+static temp_estimator_t make(void) {
+    temp_estimator_t est;
+    temp_estimator_init(&est, 0.1f, 0.001f);
+    return est;
+}
+
+static void test_first_valid_reading_initializes(void) {
+    temp_estimator_t est = make();
+    CHECK_NEAR(temp_estimator_predict(&est, 0.0f), TEMP_EST_ERROR_VALUE, 0.0);
+    CHECK_INT(temp_estimator_update(&est, TEMP_EST_POWER_ON_VALUE, 1.0f), TEMP_EST_REJECTED_INVALID);
+    CHECK(!est.initialized);
+    CHECK_INT(temp_estimator_update(&est, 25.0f, 1.0f), TEMP_EST_ACCEPTED);
+    CHECK(est.initialized);
+    CHECK_NEAR(est.temp, 25.0f, 1e-6);
+    CHECK_NEAR(est.rate, 0.0f, 1e-6);
+}
+
+static void test_invalid_values_rejected(void) {
+    temp_estimator_t est = make();
+    temp_estimator_update(&est, 25.0f, 1.0f);
+    CHECK_INT(temp_estimator_update(&est, TEMP_EST_ERROR_VALUE, 1.0f), TEMP_EST_REJECTED_INVALID);
+    CHECK_INT(temp_estimator_update(&est, NAN, 1.0f), TEMP_EST_REJECTED_INVALID);
+    CHECK_INT(temp_estimator_update(&est, -60.0f, 1.0f), TEMP_EST_REJECTED_INVALID);
+    CHECK_INT(temp_estimator_update(&est, 130.0f, 1.0f), TEMP_EST_REJECTED_INVALID);
+    CHECK_INT(temp_estimator_update(&est, TEMP_EST_POWER_ON_VALUE, 1.0f), TEMP_EST_REJECTED_INVALID);
+    CHECK_INT(est.rejected_total, 5);
+    CHECK_INT(est.consecutive_rejects, 0);     // 错误值不计入连续离群
+    CHECK_NEAR(est.temp, 25.0f, 1e-6);
+
+    // 估计值接近 85°C 时 85 是真实读数
+    temp_estimator_t hot = make();
+    temp_estimator_update(&hot, 84.0f, 1.0f);
+    CHECK(temp_estimator_update(&hot, TEMP_EST_POWER_ON_VALUE, 1.0f) != TEMP_EST_REJECTED_INVALID);
+}
+
+static void test_single_outlier_gated(void) {
+    temp_estimator_t est = make();
+    for (int i = 0; i < 30; i++) temp_estimator_update(&est, 25.0f, 1.0f);
+    CHECK_INT(temp_estimator_update(&est, 40.0f, 1.0f), TEMP_EST_REJECTED_OUTLIER);
+    CHECK_NEAR(est.temp, 25.0f, 0.01);
+    CHECK_INT(temp_estimator_update(&est, 25.0f, 1.0f), TEMP_EST_ACCEPTED);
+    CHECK_INT(est.consecutive_rejects, 0);
+}
+
+static void test_persistent_step_resets(void) {
+    temp_estimator_t est = make();
+    for (int i = 0; i < 30; i++) temp_estimator_update(&est, 25.0f, 1.0f);
+    CHECK_INT(temp_estimator_update(&est, 35.0f, 1.0f), TEMP_EST_REJECTED_OUTLIER);
+    CHECK_INT(temp_estimator_update(&est, 35.0f, 1.0f), TEMP_EST_REJECTED_OUTLIER);
+    CHECK_INT(temp_estimator_update(&est, 35.0f, 1.0f), TEMP_EST_RESET);
+    CHECK_NEAR(est.temp, 35.0f, 1e-6);
+    CHECK_NEAR(est.rate, 0.0f, 1e-6);
+    CHECK_INT(est.rejected_total, 3);
+}
+
+static void test_tracks_ramp_and_predicts(void) {
+    // 0.02°C/s 线性升温，按 DS18B20 的 0.0625°C 分辨率量化
+    temp_estimator_t est = make();
+    int rejected = 0;
+    float truth = 0.0f;
+    for (int i = 0; i < 600; i++) {
+        truth = 20.0f + 0.02f * i;
+        float meas = roundf(truth / 0.0625f) * 0.0625f;
+        rejected += temp_estimator_update(&est, meas, 1.0f) != TEMP_EST_ACCEPTED;
+    }
+    CHECK_INT(rejected, 0);
+    CHECK_NEAR(est.rate, 0.02f, 0.003);
+    CHECK_NEAR(est.temp, truth, 0.1);
+    CHECK_NEAR(temp_estimator_predict(&est, 10.0f), truth + 0.2f, 0.15);
+}
+
+static void test_noise_is_smoothed(void) {
+    // 恒温下 ±1 LSB 交替抖动：估计值波动远小于原始读数
+    temp_estimator_t est = make();
+    float lo = 100.0f, hi = -100.0f;
+    for (int i = 0; i < 300; i++) {
+        float meas = 25.0f + (i % 2 ? 0.0625f : -0.0625f);
+        temp_estimator_update(&est, meas, 1.0f);
+        if (i >= 100) {
+            if (est.temp < lo) lo = est.temp;
+            if (est.temp > hi) hi = est.temp;
+        }
+    }
+    CHECK(hi - lo < 0.05f);
+    CHECK_NEAR(est.rate, 0.0f, 0.005);
+}
+
+static void test_negative_dt_clamped(void) {
+    temp_estimator_t est = make();
+    temp_estimator_update(&est, 25.0f, 1.0f);
+    CHECK_INT(temp_estimator_update(&est, 25.0f, -5.0f), TEMP_EST_ACCEPTED);
+    CHECK(est.p[0][0] > 0.0f && est.p[1][1] > 0.0f);
+    CHECK_NEAR(est.temp, 25.0f, 1e-4);
+}
+
+int main(void) {
+    RUN(test_first_valid_reading_initializes);
+    RUN(test_invalid_values_rejected);
+    RUN(test_single_outlier_gated);
+    RUN(test_persistent_step_resets);
+    RUN(test_tracks_ramp_and_predicts);
+    RUN(test_noise_is_smoothed);
+    RUN(test_negative_dt_clamped);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,200 @@
+#include "host_test.h"
+#include "ui_menu.h"
+
+/**
+ * @brief 设置菜单：焦点移动与滚动、数值/枚举/确认项的编辑与提交、取消、渲染
+ */
+
+enum { ITEM_THRESHOLD, ITEM_SPEED, ITEM_MODE, ITEM_RESET, ITEM_A, ITEM_B, ITEM_C, ITEM_BACK, ITEM_COUNT };
+
+static const char* const s_modes[] = { "Auto", "Manual", "Off" };
+
+static ui_item_t s_items[ITEM_COUNT];
+static ui_menu_t s_menu;
+
+static void setup(void) {
+    static const ui_item_t items[ITEM_COUNT] = {
+        [ITEM_THRESHOLD] = { .label = "Threshold", .type = UI_ITEM_VALUE, .value = 30, .min = 20, .max = 45,
+                             .step = 0.5f, .decimals = 1, .unit = "C" },
+        [ITEM_SPEED]     = { .label = "Max speed", .type = UI_ITEM_VALUE, .value = 100, .min = 10, .max = 100,
+                             .step = 5, .unit = "%" },
+        [ITEM_MODE]      = { .label = "Mode", .type = UI_ITEM_CHOICE, .choices = s_modes, .choice_count = 3 },
+        [ITEM_RESET]     = { .label = "WiFi reset", .type = UI_ITEM_CONFIRM },
+        [ITEM_A]         = { .label = "A", .type = UI_ITEM_VALUE, .min = 0, .max = 10, .step = 1 },
+        [ITEM_B]         = { .label = "B", .type = UI_ITEM_VALUE, .min = 0, .max = 10, .step = 1 },
+        [ITEM_C]         = { .label = "C", .type = UI_ITEM_VALUE, .min = 0, .max = 10, .step = 1 },
+        [ITEM_BACK]      = { .label = "Back", .type = UI_ITEM_BACK },
+    };
+    memcpy(s_items, items, sizeof(items));
+    ui_menu_init(&s_menu, "Settings", s_items, ITEM_COUNT);
+    ui_menu_open(&s_menu);
+}
+
+static ui_menu_result_t rotate(int steps) {
+    return ui_menu_input(&s_menu, UI_KEY_ROTATE, steps);
+}
+
+static ui_menu_result_t click(void) {
+    return ui_menu_input(&s_menu, UI_KEY_CLICK, 0);
+}
+
+static ui_menu_result_t hold(void) {
+    return ui_menu_input(&s_menu, UI_KEY_LONG, 0);
+}
+
+static void test_closed_ignores_input(void) {
+    setup();
+    ui_menu_close(&s_menu);
+    CHECK_INT(rotate(1), UI_MENU_IGNORED);
+    CHECK_INT(click(), UI_MENU_IGNORED);
+    CHECK_INT(s_menu.focus, 0);
+}
+
+static void test_focus_and_scroll(void) {
+    setup();
+    CHECK_INT(rotate(-1), UI_MENU_IGNORED);             // 已在第一项
+    CHECK_INT(rotate(0), UI_MENU_IGNORED);
+    CHECK_INT(rotate(5), UI_MENU_REDRAW);
+    CHECK_INT(s_menu.focus, 5);
+    CHECK_INT(s_menu.top, 0);
+    CHECK_INT(rotate(1), UI_MENU_REDRAW);               // 超出可见 6 行，向下滚动
+    CHECK_INT(s_menu.top, 1);
+    CHECK_INT(rotate(100), UI_MENU_REDRAW);
+    CHECK_INT(s_menu.focus, ITEM_BACK);
+    CHECK_INT(s_menu.top, ITEM_COUNT - UI_MENU_VISIBLE_ROWS);
+    CHECK_INT(rotate(-7), UI_MENU_REDRAW);
+    CHECK_INT(s_menu.focus, 0);
+    CHECK_INT(s_menu.top, 0);
+
+    // 重新打开时焦点回到第一项
+    rotate(3);
+    ui_menu_open(&s_menu);
+    CHECK_INT(s_menu.focus, 0);
+    CHECK_INT(s_menu.top, 0);
+}
+
+static void test_value_edit(void) {
+    setup();
+    CHECK_INT(click(), UI_MENU_REDRAW);
+    CHECK(s_menu.editing);
+    CHECK_INT(rotate(3), UI_MENU_REDRAW);
+    CHECK_NEAR(s_menu.edit, 31.5, 1e-6);
+    CHECK_NEAR(s_items[ITEM_THRESHOLD].value, 30, 1e-6);   // 确认前不写回
+    CHECK_INT(click(), UI_MENU_COMMIT);
+    CHECK(!s_menu.editing);
+    CHECK_NEAR(s_items[ITEM_THRESHOLD].value, 31.5, 1e-6);
+
+    // 限幅，到达边界后继续旋转无效果
+    click();
+    CHECK_INT(rotate(100), UI_MENU_REDRAW);
+    CHECK_NEAR(s_menu.edit, 45, 1e-6);
+    CHECK_INT(rotate(1), UI_MENU_IGNORED);
+    CHECK_INT(rotate(-1000), UI_MENU_REDRAW);
+    CHECK_NEAR(s_menu.edit, 20, 1e-6);
+
+    // 长按取消编辑，值不变
+    CHECK_INT(hold(), UI_MENU_REDRAW);
+    CHECK(!s_menu.editing && s_menu.open);
+    CHECK_NEAR(s_items[ITEM_THRESHOLD].value, 31.5, 1e-6);
+
+    // 值没变时确认不提交
+    click();
+    CHECK_INT(click(), UI_MENU_REDRAW);
+}
+
+static void test_step_rounding(void) {
+    setup();
+    // 0.5 步长来回调整多次，不累积浮点误差
+    click();
+    for (int i = 0; i < 200; i++) rotate(i % 2 ? -3 : 3);
+    CHECK(s_menu.edit == 30.0f);
+    for (int i = 0; i < 7; i++) rotate(1);
+    CHECK(s_menu.edit == 33.5f);
+}
+
+static void test_choice_wraps(void) {
+    setup();
+    rotate(ITEM_MODE);
+    click();
+    CHECK_INT(rotate(-1), UI_MENU_REDRAW);
+    CHECK_NEAR(s_menu.edit, 2, 1e-6);                   // Auto 向前绕到 Off
+    CHECK_INT(rotate(4), UI_MENU_REDRAW);
+    CHECK_NEAR(s_menu.edit, 0, 1e-6);
+    CHECK_INT(rotate(3), UI_MENU_IGNORED);              // 绕一整圈回到原值
+    rotate(1);
+    CHECK_INT(click(), UI_MENU_COMMIT);
+    CHECK_NEAR(s_items[ITEM_MODE].value, 1, 1e-6);
+}
+
+static void test_confirm_requires_yes(void) {
+    setup();
+    rotate(ITEM_RESET);
+    click();
+    CHECK_NEAR(s_menu.edit, 0, 1e-6);                   // 默认 No
+    CHECK_INT(click(), UI_MENU_REDRAW);                 // 选 No 确认不提交
+    click();
+    rotate(1);
+    CHECK_NEAR(s_menu.edit, 1, 1e-6);
+    rotate(2);                                          // 偶数步回到 Yes
+    CHECK_NEAR(s_menu.edit, 1, 1e-6);
+    CHECK_INT(click(), UI_MENU_COMMIT);
+    click();
+    CHECK_NEAR(s_menu.edit, 0, 1e-6);                   // 每次编辑都从 No 开始
+}
+
+static void test_back_and_exit(void) {
+    setup();
+    rotate(ITEM_BACK);
+    CHECK_INT(click(), UI_MENU_CLOSED);
+    CHECK(!s_menu.open);
+
+    setup();
+    CHECK_INT(hold(), UI_MENU_CLOSED);
+    CHECK(!s_menu.open);
+}
+
+static void test_render(void) {
+    setup();
+    oled_frame_t f;
+    ui_menu_render(&s_menu, &f);
+    CHECK_STR(f.text[0], "      Settings       ");
+    CHECK_STR(f.text[1], ">Threshold      30.0C");
+    CHECK_STR(f.text[2], " Max speed       100%");
+    CHECK_STR(f.text[3], " Mode            Auto");
+    CHECK_STR(f.text[4], " WiFi reset          ");   // 动作项平时不显示值
+    CHECK_STR(f.text[7], "Click:edit Hold:exit ");
+    CHECK_INT(f.inverted, 1u << 1);
+
+    click();
+    rotate(1);
+    ui_menu_render(&s_menu, &f);
+    CHECK_STR(f.text[1], ">Threshold    [30.5C]");
+    CHECK_STR(f.text[7], "Click:OK  Hold:cancel");
+
+    hold();
+    rotate(ITEM_RESET);
+    click();
+    ui_menu_render(&s_menu, &f);
+    CHECK_STR(f.text[4], ">WiFi reset      [No]");
+    CHECK_INT(f.inverted, 1u << 4);
+
+    // 滚动后从 top 项开始渲染
+    hold();
+    rotate(100);
+    ui_menu_render(&s_menu, &f);
+    CHECK_STR(f.text[1], " Mode            Auto");
+    CHECK_STR(f.text[6], ">Back                ");
+    CHECK_INT(f.inverted, 1u << 6);
+}
+
+int main(void) {
+    RUN(test_closed_ignores_input);
+    RUN(test_focus_and_scroll);
+    RUN(test_value_edit);
+    RUN(test_step_rounding);
+    RUN(test_choice_wraps);
+    RUN(test_confirm_requires_yes);
+    RUN(test_back_and_exit);
+    RUN(test_render);
+    return HOST_TEST_RESULT();
+}
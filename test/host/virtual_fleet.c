@@ -0,0 +1,623 @@
+#include "mqtt_comm.h"
+#include "broker_select.h"
+#include "cooling_supervisor.h"
+#include "energy_meter.h"
+#include "esp_timer.h"
+#include "host_stubs.h"
+#include "mqtt_socket.h"
+#include "nvs.h"
+#include "cJSON.h"
+#include <getopt.h>
+#include <malloc.h>
+#include <math.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief 虚拟设备群：每台虚拟设备是一个子进程，运行固件的 mqtt_comm.c（经 mqtt_socket.c 连接真实 broker），
+ *        线上格式、遗嘱、遥测暂存补发、broker 切换和重连退避与设备一致，不会与固件漂移；
+ *        控制律、冷却监督器和电能计量同样链接固件组件，对象为一阶机箱模型
+ *        父进程作为看板：订阅 status/telemetry/command/ack，按速率下发带关联ID的命令并统计回执往返时间，
+ *        周期性让一部分设备断线（重连风暴）
+ *
+ *        mosquitto -p 1883 &
+ *        build-host/virtual_fleet --devices 1000 --duration 120 --storm-every 30 --storm-fraction 0.5
+ */
+
+#define TOPIC_PREFIX        "esp32/fan_control"
+#define POLL_MS             50
+#define SERVICE_MS          1000        // mqtt_comm_service 节拍（固件在上报任务中按控制节拍调用）
+#define RTT_PENDING         4096        // 未回执命令的环形表
+
+typedef struct {
+    const char* host;
+    int port;
+    const char* username;
+    const char* password;
+    int devices;
+    double duration_s;
+    double ramp_s;
+    int control_ms;
+    int telemetry_ms;
+    double command_rate;
+    double storm_every_s;
+    double storm_fraction;
+    int jitter_ms;
+    double report_s;
+    unsigned seed;
+} fleet_args_t;
+
+// 子进程写、父进程读的统计（共享内存，每台设备一格）
+typedef struct {
+    _Atomic uint64_t published;
+    _Atomic uint64_t connects;
+    _Atomic uint64_t connect_failures;
+    _Atomic uint64_t storm_drops;
+    _Atomic uint64_t cpu_ns;
+} fleet_slot_t;
+
+static fleet_args_t s_args = {
+    .host = "127.0.0.1", .port = 1883, .devices = 100, .duration_s = 60.0, .ramp_s = 10.0,
+    .control_ms = 5000, .telemetry_ms = 60000, .command_rate = 5.0, .storm_fraction = 0.5,
+    .jitter_ms = 2000, .report_s = 5.0, .seed = 1,
+};
+static fleet_slot_t* s_slots;
+
+static int64_t mono_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t rng_next(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static double rng_uniform(uint32_t* state, double lo, double hi) {
+    return lo + (hi - lo) * (rng_next(state) / 4294967296.0);
+}
+
+static void device_mac(int index, uint8_t mac[6]) {
+    mac[0] = 0x02;                      // 本地管理地址
+    mac[1] = 0x76;
+    mac[2] = 0x66;
+    mac[3] = (uint8_t)(index >> 16);
+    mac[4] = (uint8_t)(index >> 8);
+    mac[5] = (uint8_t)index;
+}
+
+static void device_id(int index, char* out, size_t size) {
+    uint8_t mac[6];
+    device_mac(index, mac);
+    snprintf(out, size, "fan-%02x%02x%02x%02x%02x%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+// ---- 虚拟设备（子进程） ----
+
+static volatile sig_atomic_t s_drop_requested;
+static volatile sig_atomic_t s_stop_requested;
+
+static void on_sigusr1(int sig) {
+    (void)sig;
+    s_drop_requested = 1;
+}
+
+static void on_sigterm(int sig) {
+    (void)sig;
+    s_stop_requested = 1;
+}
+
+static struct {
+    bool auto_mode;
+    uint8_t manual_speed;
+    float temp_threshold;
+    float fan_off_temp;
+    uint8_t mid_speed;
+    uint8_t max_speed;
+    float ambient_c;
+    float load_w;
+    float temp_c;
+    cooling_supervisor_t supervisor;
+    energy_meter_t energy;
+} s_dev = {
+    .auto_mode = true, .temp_threshold = 30.0f, .fan_off_temp = 25.0f, .mid_speed = 50, .max_speed = 100,
+};
+
+// 与 main.c 的 map_temp_to_speed 一致
+static uint8_t map_temp_to_speed(float temp) {
+    if (temp <= s_dev.fan_off_temp) return 0;
+    if (temp <= s_dev.temp_threshold) return s_dev.mid_speed;
+    return s_dev.max_speed;
+}
+
+/**
+ * @brief 主机时钟在事件派发前更新一次；回调内需要真实耗时（执行时刻、回执的 handled_us）时先刷新
+ */
+static int64_t clock_now_us(void) {
+    host_time_set_us(mono_us());
+    return esp_timer_get_time();
+}
+
+static void apply_outputs(cooling_output_t out) {
+    energy_meter_update(&s_dev.energy, &s_dev.supervisor.model, out, clock_now_us());
+}
+
+/**
+ * @brief 一阶机箱：热负载对环境散热，风扇降低热阻，制冷片按模型抽热
+ */
+static void plant_step(float dt_s) {
+    cooling_output_t out = s_dev.energy.duty;
+    float cooling_w = 0.0f;
+    cooling_supervisor_estimate(&s_dev.supervisor, out, &cooling_w);
+    float r = 0.5f + 1.5f * (1.0f - out.fan / 100.0f);
+    float target = s_dev.ambient_c + (s_dev.load_w - cooling_w) * r;
+    s_dev.temp_c += (target - s_dev.temp_c) * dt_s / 300.0f;
+}
+
+/**
+ * @brief 控制周期：与 main.c 相同的分段温控 → 监督器优化与联锁 → 输出；手动模式按设定转速
+ */
+static void control_step(void) {
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    cooling_output_t request = s_dev.auto_mode
+        ? cooling_supervisor_optimize(&s_dev.supervisor, map_temp_to_speed(s_dev.temp_c))
+        : (cooling_output_t){ s_dev.manual_speed, 0 };
+    apply_outputs(cooling_supervisor_step(&s_dev.supervisor, request, s_dev.temp_c, SUPERVISOR_HOT_UNKNOWN, now_ms));
+}
+
+// 与 main.c 的 on_mqtt_command 一致（不模拟自整定和风扇校准，只按固件语义回执）
+static void on_command(const mqtt_command_t* cmd, mqtt_command_ack_t* ack) {
+    bool recognized = false;
+    if (cmd->has_mode) {
+        recognized = true;
+        s_dev.auto_mode = cmd->mode == MQTT_MODE_AUTO;
+    }
+    if (cmd->has_autotune) {
+        recognized = true;
+        if (cmd->autotune == MQTT_AUTOTUNE_START && !s_dev.auto_mode) {
+            mqtt_ack_set(ack, MQTT_ACK_REJECTED, "manual_mode");
+        } else {
+            mqtt_ack_set(ack, MQTT_ACK_ACCEPTED, NULL);
+        }
+    }
+    if (cmd->has_fan_cal) {
+        recognized = true;
+        mqtt_ack_set(ack, MQTT_ACK_ACCEPTED, NULL);
+    }
+    if (cmd->speed_invalid) {
+        recognized = true;
+        mqtt_ack_set(ack, MQTT_ACK_INVALID, "speed_range");
+    } else if (cmd->has_speed) {
+        recognized = true;
+        if (s_dev.auto_mode) {
+            mqtt_ack_set(ack, MQTT_ACK_REJECTED, "auto_mode");
+        } else {
+            s_dev.manual_speed = cmd->speed;
+            uint8_t speed = cooling_supervisor_limit_fan(&s_dev.supervisor, cmd->speed);
+            apply_outputs((cooling_output_t){ speed, s_dev.energy.duty.tec });
+            ack->actuated_us = clock_now_us();
+            ack->fan_duty = s_dev.energy.duty.fan;
+            if (ack->fan_duty != cmd->speed) mqtt_ack_set(ack, MQTT_ACK_OK, "limited");
+        }
+    }
+    if (cmd->report_latency || cmd->report_trace || cmd->report_trace_log) recognized = true;
+    if (!recognized) mqtt_ack_set(ack, MQTT_ACK_INVALID, "empty");
+    clock_now_us();
+}
+
+static void on_config(const mqtt_config_t* cfg) {
+    float threshold = cfg->has_temp_threshold ? cfg->temp_threshold : s_dev.temp_threshold;
+    float fan_off = cfg->has_fan_off_temp ? cfg->fan_off_temp : s_dev.fan_off_temp;
+    if (isfinite(threshold) && isfinite(fan_off) && fan_off < threshold) {
+        s_dev.temp_threshold = threshold;
+        s_dev.fan_off_temp = fan_off;
+    }
+    if (cfg->has_max_speed) s_dev.max_speed = cfg->max_speed;
+    if (cfg->has_mid_speed) s_dev.mid_speed = cfg->mid_speed;
+    if (cfg->has_power_budget) cooling_supervisor_set_budget(&s_dev.supervisor, cfg->power_budget_w);
+}
+
+static void publish_telemetry(esp_mqtt_client_handle_t client, int64_t start_us) {
+    // 主机 malloc 堆代替内部 DRAM：顶部块即最大连续可用块
+    struct mallinfo2 mi = mallinfo2();
+    uint32_t heap_free = (uint32_t)mi.fordblks;
+    uint32_t largest = (uint32_t)mi.keepcost;
+    int64_t now_us = esp_timer_get_time();
+    energy_meter_update(&s_dev.energy, &s_dev.supervisor.model, s_dev.energy.duty, now_us);
+    // 进程 CPU 时间记为 CPU 全速，其余为等待（设备上对应浅睡眠），只为遥测格式与设备一致
+    uint64_t active_us = cpu_ns() / 1000;
+    uint64_t wall_us = (uint64_t)(now_us - start_us);
+    mqtt_telemetry_t tm = {
+        .uptime_s        = (uint32_t)((now_us - start_us) / 1000000),
+        .fan_duty        = s_dev.energy.duty.fan,
+        .tec_duty        = s_dev.energy.duty.tec,
+        .overtemp_trips  = s_dev.supervisor.overtemp_trips,
+        .sensor_state    = "ok",
+        .sensor_fault    = "none",
+        .heap_free       = heap_free,
+        .heap_largest_block = largest,
+        .heap_frag_pct   = heap_free ? (uint8_t)(100 - (uint64_t)largest * 100 / heap_free) : 0,
+        .control_period_ms   = (uint32_t)s_args.control_ms,
+        .sensor_period_ms    = (uint32_t)s_args.control_ms / 2,
+        .telemetry_period_ms = (uint32_t)s_args.telemetry_ms,
+        .fan_power_w     = s_dev.energy.fan_w,
+        .tec_power_w     = s_dev.energy.tec_w,
+        .fan_energy_kwh  = energy_meter_kwh(s_dev.energy.fan_mj),
+        .tec_energy_kwh  = energy_meter_kwh(s_dev.energy.tec_mj),
+        .power_budget_w  = s_dev.supervisor.power_budget_w,
+        .budget_limited  = s_dev.supervisor.budget_limited,
+        .has_pm_modes    = true,
+        .pm_cpu_max_us   = active_us,
+        .pm_sleep_us     = wall_us > active_us ? wall_us - active_us : 0,
+    };
+    mqtt_comm_publish_telemetry(client, &tm);
+}
+
+static void write_broker_list(void) {
+    broker_list_t list = { .count = 1 };
+    snprintf(list.entry[0].uri, sizeof(list.entry[0].uri), "mqtt://%s:%d", s_args.host, s_args.port);
+    if (s_args.username) snprintf(list.entry[0].username, sizeof(list.entry[0].username), "%s", s_args.username);
+    if (s_args.password) snprintf(list.entry[0].password, sizeof(list.entry[0].password), "%s", s_args.password);
+    nvs_handle_t nvs;
+    nvs_open("storage", NVS_READWRITE, &nvs);
+    nvs_set_blob(nvs, "mqtt_brokers", &list, sizeof(list));
+    nvs_commit(nvs);
+    nvs_close(nvs);
+}
+
+static void update_slot(fleet_slot_t* slot, esp_mqtt_client_handle_t client) {
+    host_mqtt_socket_stats_t st = host_mqtt_socket_stats(client);
+    atomic_store(&slot->published, st.published);
+    atomic_store(&slot->connects, st.connects);
+    atomic_store(&slot->connect_failures, st.connect_failures);
+    atomic_store(&slot->cpu_ns, cpu_ns());
+}
+
+static void run_device(int index) {
+    fleet_slot_t* slot = &s_slots[index];
+    uint32_t rng = (s_args.seed * 2654435761u) ^ (uint32_t)(index + 1) * 40503u;
+    if (!rng) rng = 1;
+    s_dev.ambient_c = (float)rng_uniform(&rng, 22.0, 32.0);
+    s_dev.load_w = (float)rng_uniform(&rng, 2.0, 8.0);
+    s_dev.temp_c = s_dev.ambient_c + (float)rng_uniform(&rng, 0.0, 5.0);
+
+    usleep((useconds_t)(rng_uniform(&rng, 0.0, s_args.ramp_s) * 1e6));
+    int64_t start_us = mono_us();
+    host_time_set_us(start_us);
+
+    uint8_t mac[6];
+    device_mac(index, mac);
+    host_mac_set(mac);
+    write_broker_list();
+    cooling_model_t model;
+    cooling_model_default(&model);
+    cooling_supervisor_init(&s_dev.supervisor, &model);
+    energy_meter_init(&s_dev.energy, 0, 0, start_us);
+
+    esp_mqtt_client_handle_t client = mqtt_comm_init();
+    if (!client) _exit(1);
+    mqtt_comm_set_command_callback(on_command);
+    mqtt_comm_set_config_callback(on_config);
+    esp_mqtt_client_start(client);
+
+    int64_t next_control = start_us, next_telemetry = start_us + (int64_t)s_args.telemetry_ms * 1000;
+    int64_t next_service = start_us + SERVICE_MS * 1000;
+    while (!s_stop_requested) {
+        host_mqtt_socket_poll(client, POLL_MS);
+        int64_t now = mono_us();
+        host_time_set_us(now);
+        if (s_drop_requested) {
+            s_drop_requested = 0;
+            // 断线后在抖动窗口内随机重连，之后的退避由 mqtt_comm/broker_select 决定
+            host_mqtt_socket_drop(client, (uint32_t)rng_uniform(&rng, 0.0, s_args.jitter_ms));
+            atomic_fetch_add(&slot->storm_drops, 1);
+        }
+        if (now >= next_control) {
+            plant_step(s_args.control_ms / 1000.0f);
+            control_step();
+            mqtt_comm_publish(client, s_dev.temp_c, s_dev.energy.duty.fan, s_dev.auto_mode);
+            next_control += (int64_t)s_args.control_ms * 1000;
+        }
+        if (now >= next_telemetry) {
+            publish_telemetry(client, start_us);
+            next_telemetry += (int64_t)s_args.telemetry_ms * 1000;
+        }
+        if (now >= next_service) {
+            mqtt_comm_service(client);
+            next_service += SERVICE_MS * 1000;
+        }
+        update_slot(slot, client);
+    }
+    esp_mqtt_client_disconnect(client);
+    update_slot(slot, client);
+    _exit(0);
+}
+
+// ---- 看板（父进程） ----
+
+static struct {
+    esp_mqtt_client_handle_t client;
+    bool connected;
+    uint64_t received;
+    uint32_t seq;
+    int64_t sent_us[RTT_PENDING];
+    double* rtt_ms;
+    size_t rtt_count;
+    size_t rtt_cap;
+    uint64_t not_ok;
+} s_obs;
+
+static bool topic_ends_with(const esp_mqtt_event_t* event, const char* suffix) {
+    size_t n = strlen(suffix);
+    return (size_t)event->topic_len >= n && memcmp(event->topic + event->topic_len - n, suffix, n) == 0;
+}
+
+static void on_ack(const esp_mqtt_event_t* event) {
+    cJSON* root = cJSON_ParseWithLength(event->data, event->data_len);
+    const cJSON* id = cJSON_GetObjectItem(root, "id");
+    unsigned seq;
+    if (cJSON_IsString(id) && sscanf(id->valuestring, "vf%u", &seq) == 1) {
+        int64_t* sent = &s_obs.sent_us[seq % RTT_PENDING];
+        if (*sent) {
+            if (s_obs.rtt_count == s_obs.rtt_cap) {
+                s_obs.rtt_cap = s_obs.rtt_cap ? s_obs.rtt_cap * 2 : 1024;
+                s_obs.rtt_ms = realloc(s_obs.rtt_ms, s_obs.rtt_cap * sizeof(*s_obs.rtt_ms));
+            }
+            s_obs.rtt_ms[s_obs.rtt_count++] = (mono_us() - *sent) / 1000.0;
+            *sent = 0;
+        }
+        if (!cJSON_IsTrue(cJSON_GetObjectItem(root, "ok"))) s_obs.not_ok++;
+    }
+    cJSON_Delete(root);
+}
+
+static void observer_event(void* arg, esp_event_base_t base, int32_t event_id, void* event_data) {
+    esp_mqtt_event_t* event = event_data;
+    switch ((esp_mqtt_event_id_t)event_id) {
+    case MQTT_EVENT_CONNECTED:
+        s_obs.connected = true;
+        esp_mqtt_client_subscribe(event->client, TOPIC_PREFIX "/+/status", 0);
+        esp_mqtt_client_subscribe(event->client, TOPIC_PREFIX "/+/telemetry", 0);
+        esp_mqtt_client_subscribe(event->client, TOPIC_PREFIX "/+/command/ack", 1);
+        break;
+    case MQTT_EVENT_DISCONNECTED:
+        s_obs.connected = false;
+        break;
+    case MQTT_EVENT_DATA:
+        s_obs.received++;
+        if (topic_ends_with(event, "/command/ack")) on_ack(event);
+        break;
+    default:
+        break;
+    }
+}
+
+static void send_command(int index, uint32_t* rng) {
+    char id[MQTT_DEVICE_ID_MAX], topic[96], payload[80];
+    device_id(index, id, sizeof(id));
+    snprintf(topic, sizeof(topic), TOPIC_PREFIX "/%s/command", id);
+    uint32_t seq = ++s_obs.seq;
+    int len = snprintf(payload, sizeof(payload), "{\"id\":\"vf%u\",\"mode\":\"manual\",\"speed\":%u}",
+                       (unsigned)seq, (unsigned)(1 + rng_next(rng) % 100));
+    if (esp_mqtt_client_publish(s_obs.client, topic, payload, len, 1, 0) >= 0) {
+        s_obs.sent_us[seq % RTT_PENDING] = mono_us();
+    }
+}
+
+static void sum_slots(fleet_slot_t* total) {
+    memset(total, 0, sizeof(*total));
+    for (int i = 0; i < s_args.devices; i++) {
+        atomic_fetch_add(&total->published, atomic_load(&s_slots[i].published));
+        atomic_fetch_add(&total->connects, atomic_load(&s_slots[i].connects));
+        atomic_fetch_add(&total->connect_failures, atomic_load(&s_slots[i].connect_failures));
+        atomic_fetch_add(&total->storm_drops, atomic_load(&s_slots[i].storm_drops));
+        atomic_fetch_add(&total->cpu_ns, atomic_load(&s_slots[i].cpu_ns));
+    }
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(double p) {
+    if (!s_obs.rtt_count) return NAN;
+    size_t i = (size_t)lround(p / 100.0 * (s_obs.rtt_count - 1));
+    return s_obs.rtt_ms[i < s_obs.rtt_count ? i : s_obs.rtt_count - 1];
+}
+
+static void run_observer(const pid_t* pids) {
+    char uri[160];
+    snprintf(uri, sizeof(uri), "mqtt://%s:%d", s_args.host, s_args.port);
+    esp_mqtt_client_config_t cfg = {
+        .broker.address.uri = uri,
+        .credentials.client_id = "fan-vf-observer",
+        .credentials.username = s_args.username,
+        .credentials.authentication.password = s_args.password,
+        .session.keepalive = 60,
+        .network.reconnect_timeout_ms = 1000,
+        .network.timeout_ms = 10000,
+    };
+    s_obs.client = esp_mqtt_client_init(&cfg);
+    esp_mqtt_client_register_event(s_obs.client, MQTT_EVENT_ANY, observer_event, NULL);
+    esp_mqtt_client_start(s_obs.client);
+
+    uint32_t rng = s_args.seed ? s_args.seed : 1;
+    int64_t start = mono_us(), stop = start + (int64_t)(s_args.duration_s * 1e6);
+    int64_t command_period = s_args.command_rate > 0 ? (int64_t)(1e6 / s_args.command_rate) : 0;
+    int64_t next_command = start + (int64_t)(s_args.ramp_s * 1e6);
+    int64_t storm_period = (int64_t)(s_args.storm_every_s * 1e6);
+    int64_t next_storm = start + storm_period;
+    int64_t next_report = start + (int64_t)(s_args.report_s * 1e6), last_report = start;
+    fleet_slot_t last = { 0 };
+    uint64_t last_rx = 0;
+
+    for (int64_t now = start; now < stop; now = mono_us()) {
+        host_mqtt_socket_poll(s_obs.client, 5);
+        if (command_period && s_obs.connected && now >= next_command) {
+            send_command((int)(rng_next(&rng) % (uint32_t)s_args.devices), &rng);
+            next_command += command_period;
+        }
+        if (storm_period > 0 && now >= next_storm) {
+            int victims = (int)(s_args.devices * s_args.storm_fraction);
+            printf("storm: dropping %d connections\n", victims);
+            // 部分洗牌选出不重复的设备
+            int* order = malloc(sizeof(int) * s_args.devices);
+            for (int i = 0; i < s_args.devices; i++) order[i] = i;
+            for (int i = 0; i < victims; i++) {
+                int j = i + (int)(rng_next(&rng) % (uint32_t)(s_args.devices - i));
+                int t = order[i];
+                order[i] = order[j];
+                order[j] = t;
+                kill(pids[order[i]], SIGUSR1);
+            }
+            free(order);
+            next_storm += storm_period;
+        }
+        if (now >= next_report) {
+            fleet_slot_t total;
+            sum_slots(&total);
+            double span = (now - last_report) / 1e6;
+            printf("publish %7.0f msg/s  ingest(observed) %7.0f msg/s  connects %llu  drops %llu\n",
+                   (atomic_load(&total.published) - atomic_load(&last.published)) / span,
+                   (s_obs.received - last_rx) / span, (unsigned long long)atomic_load(&total.connects),
+                   (unsigned long long)atomic_load(&total.storm_drops));
+            fflush(stdout);
+            atomic_store(&last.published, atomic_load(&total.published));
+            last_rx = s_obs.received;
+            last_report = now;
+            next_report += (int64_t)(s_args.report_s * 1e6);
+        }
+    }
+    esp_mqtt_client_disconnect(s_obs.client);
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [--host H] [--port P] [--username U] [--password P] [--devices N] [--duration S]\n"
+            "          [--ramp-s S] [--control-ms MS] [--telemetry-ms MS] [--command-rate R]\n"
+            "          [--storm-every S] [--storm-fraction F] [--jitter-ms MS] [--report-s S] [--seed N]\n",
+            prog);
+}
+
+static bool parse_args(int argc, char** argv) {
+    static const struct option options[] = {
+        { "host", required_argument, NULL, 'h' },
+        { "port", required_argument, NULL, 'p' },
+        { "username", required_argument, NULL, 'u' },
+        { "password", required_argument, NULL, 'w' },
+        { "devices", required_argument, NULL, 'n' },
+        { "duration", required_argument, NULL, 'd' },
+        { "ramp-s", required_argument, NULL, 'r' },
+        { "control-ms", required_argument, NULL, 'c' },
+        { "telemetry-ms", required_argument, NULL, 't' },
+        { "command-rate", required_argument, NULL, 'C' },
+        { "storm-every", required_argument, NULL, 'S' },
+        { "storm-fraction", required_argument, NULL, 'F' },
+        { "jitter-ms", required_argument, NULL, 'j' },
+        { "report-s", required_argument, NULL, 'R' },
+        { "seed", required_argument, NULL, 's' },
+        { NULL, 0, NULL, 0 },
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", options, NULL)) != -1) {
+        switch (opt) {
+        case 'h': s_args.host = optarg; break;
+        case 'p': s_args.port = atoi(optarg); break;
+        case 'u': s_args.username = optarg; break;
+        case 'w': s_args.password = optarg; break;
+        case 'n': s_args.devices = atoi(optarg); break;
+        case 'd': s_args.duration_s = atof(optarg); break;
+        case 'r': s_args.ramp_s = atof(optarg); break;
+        case 'c': s_args.control_ms = atoi(optarg); break;
+        case 't': s_args.telemetry_ms = atoi(optarg); break;
+        case 'C': s_args.command_rate = atof(optarg); break;
+        case 'S': s_args.storm_every_s = atof(optarg); break;
+        case 'F': s_args.storm_fraction = atof(optarg); break;
+        case 'j': s_args.jitter_ms = atoi(optarg); break;
+        case 'R': s_args.report_s = atof(optarg); break;
+        case 's': s_args.seed = (unsigned)strtoul(optarg, NULL, 0); break;
+        default: return false;
+        }
+    }
+    return optind == argc && s_args.devices > 0 && s_args.devices <= 0xFFFFFF && s_args.control_ms > 0 &&
+           s_args.telemetry_ms > 0 && s_args.report_s > 0 && s_args.storm_fraction >= 0 &&
+           s_args.storm_fraction <= 1 && s_args.jitter_ms >= 0;
+}
+
+int main(int argc, char** argv) {
+    if (!parse_args(argc, argv)) {
+        usage(argv[0]);
+        return 2;
+    }
+    s_slots = mmap(NULL, sizeof(fleet_slot_t) * s_args.devices, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (s_slots == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    pid_t* pids = calloc(s_args.devices, sizeof(pid_t));
+    signal(SIGUSR1, on_sigusr1);
+    signal(SIGTERM, on_sigterm);
+    fflush(stdout);
+    for (int i = 0; i < s_args.devices; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+            run_device(i);
+        }
+        if (pid < 0) {
+            perror("fork");
+            s_args.devices = i;
+            break;
+        }
+        pids[i] = pid;
+    }
+    signal(SIGUSR1, SIG_IGN);
+    signal(SIGTERM, SIG_DFL);
+
+    int64_t start = mono_us();
+    run_observer(pids);
+    for (int i = 0; i < s_args.devices; i++) kill(pids[i], SIGTERM);
+    for (int i = 0; i < s_args.devices; i++) waitpid(pids[i], NULL, 0);
+    double elapsed = (mono_us() - start) / 1e6;
+
+    fleet_slot_t total;
+    sum_slots(&total);
+    uint64_t published = atomic_load(&total.published);
+    printf("\n%d devices, %.0f s\n", s_args.devices, elapsed);
+    printf("published %llu (%.0f msg/s), observed %llu (%.0f msg/s)\n", (unsigned long long)published,
+           published / elapsed, (unsigned long long)s_obs.received, s_obs.received / elapsed);
+    printf("connects %llu, connect failures %llu, storm drops %llu\n",
+           (unsigned long long)atomic_load(&total.connects),
+           (unsigned long long)atomic_load(&total.connect_failures),
+           (unsigned long long)atomic_load(&total.storm_drops));
+    if (s_obs.rtt_count) qsort(s_obs.rtt_ms, s_obs.rtt_count, sizeof(*s_obs.rtt_ms), compare_double);
+    printf("command RTT ms: n=%zu p50=%.1f p90=%.1f p99=%.1f max=%.1f, not ok %llu\n", s_obs.rtt_count,
+           percentile(50), percentile(90), percentile(99), percentile(100), (unsigned long long)s_obs.not_ok);
+    if (published) {
+        printf("device-side CPU per message: %.1f us (mqtt_comm + socket I/O, whole device process)\n",
+               atomic_load(&total.cpu_ns) / 1000.0 / published);
+    }
+    free(s_obs.rtt_ms);
+    free(pids);
+    return 0;
+}
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""Command round-trip latency: command with a correlation id -> ack on <id>/command/ack.
+
+Sends speed commands to one device (real firmware or a test/host virtual_fleet
+device) and matches each ack by its "id". Reports broker round-trip percentiles
+seen by this host next to the device-side receive-to-actuation time carried in
+the ack, so network/broker latency and on-device handling can be told apart.
+
+    python3 tools/cmd_latency.py --host 192.168.1.10 --device fan-a0b1c2d3e4f5 \\
+        --count 500 --rate 20
+
+The device is switched to manual mode first (otherwise speed commands are acked
+as rejected/auto_mode); --restore-auto switches it back when done. Standard
+library only; uses the MQTT client in mqtt311.py.
+"""
+import argparse
+import asyncio
+import json
+import random
+import time
+
+from mqtt311 import TOPIC_PREFIX, MqttClient, percentile
+
+
+class AckCollector:
+    def __init__(self):
+        self.pending = {}       # id -> (sent time, future)
+        self.rtt_ms = []
+        self.actuation_us = []
+        self.handled_us = []
+        self.results = {}
+        self.unmatched = 0
+
+    def on_message(self, topic, payload):
+        try:
+            ack = json.loads(payload)
+        except ValueError:
+            return
+        entry = self.pending.pop(ack.get("id"), None)
+        if not entry:
+            self.unmatched += 1
+            return
+        sent, fut = entry
+        if not fut.done():
+            fut.set_result((time.monotonic() - sent, ack))
+
+    def record(self, rtt_s, ack):
+        self.rtt_ms.append(rtt_s * 1000.0)
+        key = ack.get("result", "?") + ("/" + ack["reason"] if ack.get("reason") else "")
+        self.results[key] = self.results.get(key, 0) + 1
+        if "actuation_us" in ack:
+            self.actuation_us.append(ack["actuation_us"])
+        if "handled_us" in ack:
+            self.handled_us.append(ack["handled_us"])
+
+
+async def send(client, collector, topic, cmd, timeout_s, qos):
+    fut = asyncio.get_running_loop().create_future()
+    collector.pending[cmd["id"]] = (time.monotonic(), fut)
+    client.publish(topic, json.dumps(cmd, separators=(",", ":")), qos=qos)
+    try:
+        return await asyncio.wait_for(fut, timeout_s)
+    except asyncio.TimeoutError:
+        collector.pending.pop(cmd["id"], None)
+        return None
+
+
+def summary(name, values, unit):
+    if not values:
+        return "%-22s n=0" % name
+    return "%-22s n=%d p50=%.1f p90=%.1f p99=%.1f max=%.1f %s" % (
+        name, len(values), percentile(values, 50), percentile(values, 90),
+        percentile(values, 99), max(values), unit)
+
+
+async def main_async(args):
+    collector = AckCollector()
+    client = MqttClient("fan-cmdlat-%06x" % random.getrandbits(24), collector.on_message)
+    await client.connect(args.host, args.port, username=args.username, password=args.password)
+    base = "%s/%s" % (TOPIC_PREFIX, args.device)
+    client.subscribe(base + "/command/ack", 1)
+    await asyncio.sleep(0.2)    # 等 SUBACK，避免第一条回执在订阅生效前发出
+
+    run = "%04x" % random.getrandbits(16)
+    got = await send(client, collector, base + "/command", {"id": run + "-m", "mode": "manual"},
+                     args.timeout, args.qos)
+    if got is None:
+        print("no ack from %s (firmware without command acks, wrong device id or offline)" % args.device)
+        await client.disconnect()
+        return 1
+
+    timeouts = 0
+    interval = 1.0 / args.rate if args.rate > 0 else 0.0
+    tasks = []
+    for n in range(args.count):
+        cmd = {"id": "%s-%d" % (run, n), "speed": random.randint(args.min_speed, args.max_speed)}
+        tasks.append(asyncio.ensure_future(send(client, collector, base + "/command", cmd, args.timeout, args.qos)))
+        if interval:
+            await asyncio.sleep(interval)
+        else:
+            await tasks[-1]
+    for got in await asyncio.gather(*tasks):
+        if got is None:
+            timeouts += 1
+        else:
+            collector.record(*got)
+
+    if args.restore_auto:
+        await send(client, collector, base + "/command", {"id": run + "-a", "mode": "auto"}, args.timeout, args.qos)
+    await client.disconnect()
+
+    print("%s: %d commands, %d acked, %d timed out (> %.1f s), %d unmatched acks" % (
+        args.device, args.count, len(collector.rtt_ms), timeouts, args.timeout, collector.unmatched))
+    print("results: " + ", ".join("%s=%d" % kv for kv in sorted(collector.results.items())))
+    print(summary("round trip", collector.rtt_ms, "ms"))
+    print(summary("device actuation", collector.actuation_us, "us"))
+    print(summary("device handled", collector.handled_us, "us"))
+    return 0 if timeouts == 0 else 2
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--username")
+    parser.add_argument("--password")
+    parser.add_argument("--device", required=True, help="device id, e.g. fan-a0b1c2d3e4f5 or fan-027666000000 (virtual_fleet)")
+    parser.add_argument("--count", type=int, default=200)
+    parser.add_argument("--rate", type=float, default=10.0, help="commands per second (0 = one at a time)")
+    parser.add_argument("--timeout", type=float, default=5.0, help="seconds to wait for each ack")
+    parser.add_argument("--qos", type=int, choices=(0, 1), default=1)
+    parser.add_argument("--min-speed", type=int, default=20)
+    parser.add_argument("--max-speed", type=int, default=80)
+    parser.add_argument("--restore-auto", action="store_true", help="switch the device back to auto mode at the end")
+    args = parser.parse_args()
+    raise SystemExit(asyncio.run(main_async(args)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,145 @@
+"""Minimal MQTT 3.1.1 client for the tools in this directory (standard library only).
+
+Used by cmd_latency.py; the load generator is the host build's virtual_fleet
+(test/host/virtual_fleet.c), which runs the firmware's own mqtt_comm.c.
+"""
+import asyncio
+import struct
+
+TOPIC_PREFIX = "esp32/fan_control"
+KEEPALIVE_S = 60
+
+# MQTT 3.1.1 packet types
+CONNECT, CONNACK, PUBLISH, PUBACK, SUBSCRIBE, SUBACK = 1, 2, 3, 4, 8, 9
+PINGREQ, PINGRESP, DISCONNECT = 12, 13, 14
+
+
+def _varint(n):
+    out = bytearray()
+    while True:
+        byte = n % 128
+        n //= 128
+        out.append(byte | (0x80 if n else 0))
+        if not n:
+            return bytes(out)
+
+
+def _str(s):
+    b = s.encode() if isinstance(s, str) else s
+    return struct.pack(">H", len(b)) + b
+
+
+class MqttClient:
+    """Minimal MQTT 3.1.1 client: QoS0/1 publish, subscribe, will, keepalive."""
+
+    def __init__(self, client_id, on_message=None):
+        self.client_id = client_id
+        self.on_message = on_message
+        self.reader = None
+        self.writer = None
+        self.packet_id = 0
+        self.connected = False
+        self._tasks = []
+
+    async def connect(self, host, port, will=None, username=None, password=None):
+        self.reader, self.writer = await asyncio.open_connection(host, port)
+        flags = 0x02  # clean session
+        payload = _str(self.client_id)
+        if will:
+            topic, msg, qos, retain = will
+            flags |= 0x04 | (qos << 3) | (0x20 if retain else 0)
+            payload += _str(topic) + _str(msg)
+        if username:
+            flags |= 0x80
+            payload += _str(username)
+        if password:
+            flags |= 0x40
+            payload += _str(password)
+        var = _str("MQTT") + bytes([4, flags]) + struct.pack(">H", KEEPALIVE_S)
+        self._send(CONNECT << 4, var + payload)
+        first, body = await self._read_packet()
+        if first >> 4 != CONNACK or body[1] != 0:
+            raise ConnectionError("connack rc=%s" % (body[1] if len(body) > 1 else "?"))
+        self.connected = True
+        self._tasks = [asyncio.ensure_future(self._read_loop()), asyncio.ensure_future(self._ping_loop())]
+
+    def _send(self, header, body):
+        self.writer.write(bytes([header]) + _varint(len(body)) + body)
+
+    async def _read_packet(self):
+        first = (await self.reader.readexactly(1))[0]
+        length, mult = 0, 1
+        while True:
+            byte = (await self.reader.readexactly(1))[0]
+            length += (byte & 0x7F) * mult
+            mult *= 128
+            if not byte & 0x80:
+                break
+        body = await self.reader.readexactly(length) if length else b""
+        return first, body
+
+    async def _read_loop(self):
+        try:
+            while True:
+                first, data = await self._read_packet()
+                if first >> 4 == PUBLISH:
+                    qos = (first >> 1) & 3
+                    tlen = struct.unpack_from(">H", data)[0]
+                    topic = data[2:2 + tlen].decode()
+                    off = 2 + tlen
+                    if qos:
+                        pid = data[off:off + 2]
+                        off += 2
+                        self._send(PUBACK << 4, pid)
+                    if self.on_message:
+                        self.on_message(topic, data[off:])
+        except (asyncio.IncompleteReadError, ConnectionError, OSError):
+            pass
+        finally:
+            self.connected = False
+
+    async def _ping_loop(self):
+        while self.connected:
+            await asyncio.sleep(KEEPALIVE_S / 2)
+            if self.connected:
+                self._send(PINGREQ << 4, b"")
+
+    def publish(self, topic, payload, qos=0, retain=False):
+        if not self.connected:
+            return False
+        body = _str(topic)
+        if qos:
+            self.packet_id = self.packet_id % 65535 + 1
+            body += struct.pack(">H", self.packet_id)
+        body += payload if isinstance(payload, bytes) else payload.encode()
+        self._send((PUBLISH << 4) | (qos << 1) | (1 if retain else 0), body)
+        return True
+
+    def subscribe(self, topic, qos=1):
+        self.packet_id = self.packet_id % 65535 + 1
+        self._send((SUBSCRIBE << 4) | 0x02, struct.pack(">H", self.packet_id) + _str(topic) + bytes([qos]))
+
+    async def drain(self):
+        if self.writer:
+            await self.writer.drain()
+
+    def abort(self):
+        """Drop the TCP connection without DISCONNECT (the broker fires the will)."""
+        for t in self._tasks:
+            t.cancel()
+        self.connected = False
+        if self.writer:
+            self.writer.transport.abort()
+
+    async def disconnect(self):
+        if self.connected:
+            self._send(DISCONNECT << 4, b"")
+            await self.drain()
+        self.abort()
+
+
+def percentile(values, p):
+    if not values:
+        return float("nan")
+    values = sorted(values)
+    return values[min(len(values) - 1, int(round(p / 100.0 * (len(values) - 1))))]
@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+"""Convert a fan controller trace dump to Chrome trace JSON (opens in Perfetto / chrome://tracing).
+
+Input is either the raw binary published on <id>/diagnostics/trace or a serial log
+containing the base64 block between the BEGIN/END FAN TRACE markers.
+
+    mosquitto_sub -t 'esp32/fan_control/+/diagnostics/trace' -C 1 > trace.bin
+    python3 tools/trace2perfetto.py trace.bin -o trace.json
+"""
+import argparse
+import base64
+import json
+import struct
+import sys
+
+MAGIC = b"FTRC"
+VERSION = 1
+BEGIN_MARK = "-----BEGIN FAN TRACE-----"
+END_MARK = "-----END FAN TRACE-----"
+TASK_ISR = 0x7F
+TASK_OTHER = 0x7E
+
+
+def load(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data.startswith(MAGIC):
+        return data
+    text = data.decode("utf-8", errors="replace")
+    start = text.find(BEGIN_MARK)
+    end = text.find(END_MARK, start)
+    if start < 0 or end < 0:
+        sys.exit("no trace dump found in %s" % path)
+    block = text[start + len(BEGIN_MARK):end]
+    # 串口日志行可能带前缀，只保留每行最后一个字段
+    lines = [line.split()[-1] for line in block.splitlines() if line.strip()]
+    return base64.b64decode("".join(lines))
+
+
+def parse(data):
+    if data[:4] != MAGIC:
+        sys.exit("bad magic")
+    version, task_count, name_count, event_count, dropped, now_us = struct.unpack_from("<BBHIIQ", data, 4)
+    if version != VERSION:
+        sys.exit("unsupported dump version %d" % version)
+    off = 24
+    names = {}
+    for _ in range(name_count):
+        name_id, length = struct.unpack_from("<HB", data, off)
+        off += 3
+        names[name_id] = data[off:off + length].decode("utf-8", errors="replace")
+        off += length
+    tasks = {TASK_ISR: "ISR", TASK_OTHER: "other"}
+    for _ in range(task_count):
+        slot, length = struct.unpack_from("<BB", data, off)
+        off += 2
+        tasks[slot] = data[off:off + length].decode("utf-8", errors="replace")
+        off += length
+    events = []
+    for _ in range(event_count):
+        events.append(struct.unpack_from("<IIHBB", data, off))
+        off += 12
+    return names, tasks, events, dropped, now_us
+
+
+def convert(names, tasks, events, dropped, now_us):
+    now32 = now_us & 0xFFFFFFFF
+    out = []
+    seen = set()
+    for ts, arg, name_id, ev_type, task in events:
+        # 时间戳只存低 32 位（约 71 分钟回绕），按导出时刻展开为绝对时间
+        ts_abs = now_us - ((now32 - ts) & 0xFFFFFFFF)
+        core = task >> 7
+        slot = task & 0x7F
+        seen.add((core, slot))
+        ev = {
+            "name": names.get(name_id, "#%d" % name_id),
+            "ph": chr(ev_type),
+            "ts": ts_abs,
+            "pid": core,
+            "tid": slot,
+        }
+        if ev["ph"] == "i":
+            ev["s"] = "t"
+            ev["args"] = {"arg": arg}
+        elif ev["ph"] == "C":
+            ev["args"] = {"value": arg}
+        out.append(ev)
+    for core in sorted({c for c, _ in seen}):
+        out.append({"name": "process_name", "ph": "M", "pid": core, "args": {"name": "core %d" % core}})
+    for core, slot in sorted(seen):
+        out.append({"name": "thread_name", "ph": "M", "pid": core, "tid": slot,
+                    "args": {"name": tasks.get(slot, "task %d" % slot)}})
+    return {"traceEvents": out, "displayTimeUnit": "ms",
+            "metadata": {"dropped_events": dropped, "dump_time_us": now_us}}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="binary dump or serial log")
+    parser.add_argument("-o", "--output", default="-", help="output JSON (default stdout)")
+    args = parser.parse_args()
+
+    names, tasks, events, dropped, now_us = parse(load(args.input))
+    trace = convert(names, tasks, events, dropped, now_us)
+    if args.output == "-":
+        json.dump(trace, sys.stdout)
+    else:
+        with open(args.output, "w") as f:
+            json.dump(trace, f)
+    print("%d events, %d dropped" % (len(events), dropped), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()